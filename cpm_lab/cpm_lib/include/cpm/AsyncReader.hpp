@@ -14,6 +14,7 @@
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/get_topic.hpp"
 #include "cpm/Participant.hpp"
+#include "cpm/LoopbackTransport.hpp"
 
 /**
  * \file AsyncReader.hpp
@@ -40,6 +41,10 @@ namespace cpm
         dds::core::cond::StatusCondition read_condition;
         //! Waitset as part of the read condition for async. data receiving
         rti::core::cond::AsyncWaitSet waitset;
+        //! Used instead of the DDS entities above (which are null then) if the LoopbackTransport was enabled when the reader was created
+        std::shared_ptr<LoopbackTopic<MessageType>> loopback_topic;
+        //! Subscription of this reader in loopback_topic, which calls the callback function directly
+        std::shared_ptr<LoopbackSubscription<MessageType>> loopback_subscription;
 
         /**
          * \brief Returns qos for the settings s.t. the constructor becomes more readable
@@ -63,6 +68,20 @@ namespace cpm
             }
         }
 
+        /**
+         * \brief Subscribe to a loopback topic instead of starting the waitset; same QoS as get_qos
+         * \param func The callback function provided by the user
+         * \param key Key of the topic, see LoopbackTransport::topic_key
+         * \param is_reliable QoS reliability
+         * \param is_transient_local QoS durability
+         */
+        void create_loopback_subscription(std::function<void(std::vector<MessageType>&)> func, std::string key, bool is_reliable, bool is_transient_local)
+        {
+            loopback_topic = LoopbackTopic<MessageType>::get(key);
+            loopback_subscription = std::make_shared<LoopbackSubscription<MessageType>>(is_reliable || is_transient_local, is_transient_local, 0, nullptr, func);
+            loopback_topic->add_subscription(loopback_subscription);
+        }
+
         /**
          * \brief Handler that takes unread samples, releases the waitset and calls the callback function provided by the user
          * \param func The callback function provided by the user
@@ -107,6 +126,11 @@ namespace cpm
             bool is_transient_local = false
         );
 
+        /**
+         * \brief Destructor; with the loopback transport, it waits until a running callback returns
+         */
+        ~AsyncReader();
+
         /**
          * \brief Returns # of matched writers
          */
@@ -120,10 +144,19 @@ namespace cpm
         bool is_reliable,
         bool is_transient_local
     )
-    :sub(cpm::ParticipantSingleton::Instance())
-    ,reader(sub, cpm::get_topic<MessageType>(topic_name), get_qos(is_reliable, is_transient_local))
-    ,read_condition(reader)
+    :sub(LoopbackTransport::is_enabled() ? dds::sub::Subscriber(dds::core::null) : dds::sub::Subscriber(cpm::ParticipantSingleton::Instance()))
+    ,reader(LoopbackTransport::is_enabled() ? 
+        dds::sub::DataReader<MessageType>(dds::core::null) : 
+        dds::sub::DataReader<MessageType>(sub, cpm::get_topic<MessageType>(topic_name), get_qos(is_reliable, is_transient_local))
+    )
+    ,read_condition(LoopbackTransport::is_enabled() ? dds::core::cond::StatusCondition(dds::core::null) : dds::core::cond::StatusCondition(reader))
     {
+        if (LoopbackTransport::is_enabled())
+        {
+            create_loopback_subscription(func, LoopbackTransport::topic_key(topic_name), is_reliable, is_transient_local);
+            return;
+        }
+
         //Call the callback function whenever any new data is available
         read_condition.enabled_statuses(dds::core::status::StatusMask::data_available()); 
 
@@ -145,10 +178,19 @@ namespace cpm
         bool is_reliable,
         bool is_transient_local
     )
-    :sub(participant.get_participant())
-    ,reader(sub, cpm::get_topic<MessageType>(participant.get_participant(), topic_name), get_qos(is_reliable, is_transient_local))
-    ,read_condition(reader)
+    :sub(LoopbackTransport::is_enabled() ? dds::sub::Subscriber(dds::core::null) : dds::sub::Subscriber(participant.get_participant()))
+    ,reader(LoopbackTransport::is_enabled() ? 
+        dds::sub::DataReader<MessageType>(dds::core::null) : 
+        dds::sub::DataReader<MessageType>(sub, cpm::get_topic<MessageType>(participant.get_participant(), topic_name), get_qos(is_reliable, is_transient_local))
+    )
+    ,read_condition(LoopbackTransport::is_enabled() ? dds::core::cond::StatusCondition(dds::core::null) : dds::core::cond::StatusCondition(reader))
     {
+        if (LoopbackTransport::is_enabled())
+        {
+            create_loopback_subscription(func, LoopbackTransport::topic_key(participant.get_participant().domain_id(), topic_name), is_reliable, is_transient_local);
+            return;
+        }
+
         //Call the callback function whenever any new data is available
         read_condition.enabled_statuses(dds::core::status::StatusMask::data_available()); 
 
@@ -185,9 +227,23 @@ namespace cpm
         func(samples_vec);
     }
 
+    template<class MessageType> 
+    AsyncReader<MessageType>::~AsyncReader()
+    {
+        if (loopback_subscription)
+        {
+            loopback_subscription->close();
+        }
+    }
+
     template<class MessageType> 
     size_t AsyncReader<MessageType>::matched_publications_size()
     {
+        if (loopback_topic)
+        {
+            return loopback_topic->matched_publications(*loopback_subscription);
+        }
+
         auto matched_pub = dds::sub::matched_publications(reader);
         return matched_pub.size();
     }
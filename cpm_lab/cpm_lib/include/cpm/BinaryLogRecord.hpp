@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cpm
+{
+    /**
+     * \brief Encoding and decoding of binary log records, as written by cpm::Logging::write_binary.
+     *
+     * A record consists of:
+     * - format ID (uint32_t), refers to a format string that was announced once via LogFormat
+     * - log level (uint8_t)
+     * - timestamp (uint64_t, nanoseconds)
+     * - number of arguments (uint8_t)
+     * - for each argument: a type tag (one byte, see ArgTag) followed by the raw value
+     *
+     * All values are stored in host byte order (all participants of the lab run on little endian machines).
+     * This header does not depend on DDS, s.t. it can also be used by offline tools.
+     * \ingroup cpmlib
+     */
+    namespace binary_log
+    {
+        /**
+         * \enum ArgTag
+         * \brief Type tags of encoded arguments
+         */
+        enum ArgTag : uint8_t {
+            Signed = 'i',   //!< int64_t
+            Unsigned = 'u', //!< uint64_t
+            Floating = 'd', //!< double
+            String = 's',   //!< uint16_t length followed by the characters (no terminating zero)
+            Pointer = 'p'   //!< uint64_t
+        };
+
+        //! Strings longer than this are truncated when they are recorded
+        constexpr size_t MAX_STRING_ARG_LENGTH = 1024;
+
+        //! Size of the record header (format ID, level, timestamp, argument count)
+        constexpr size_t RECORD_HEADER_SIZE = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint8_t);
+
+        /**
+         * \brief Append raw bytes to the buffer
+         * \param buffer Buffer to append to
+         * \param data Bytes to append
+         * \param size Number of bytes to append
+         */
+        inline void put(std::vector<uint8_t>& buffer, const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            buffer.insert(buffer.end(), bytes, bytes + size);
+        }
+
+        /**
+         * \brief Append a tag and a trivially copyable value to the buffer
+         */
+        template<typename V> inline void put_tagged(std::vector<uint8_t>& buffer, ArgTag tag, V value)
+        {
+            buffer.push_back(static_cast<uint8_t>(tag));
+            put(buffer, &value, sizeof(V));
+        }
+
+        /**
+         * \brief Append a string argument to the buffer (truncated to MAX_STRING_ARG_LENGTH)
+         */
+        inline void put_string(std::vector<uint8_t>& buffer, const char* str, size_t length)
+        {
+            if (length > MAX_STRING_ARG_LENGTH) length = MAX_STRING_ARG_LENGTH;
+            uint16_t length_16 = static_cast<uint16_t>(length);
+            buffer.push_back(static_cast<uint8_t>(ArgTag::String));
+            put(buffer, &length_16, sizeof(length_16));
+            put(buffer, str, length);
+        }
+
+        //! Encode signed integers (and enums) as int64_t
+        template<typename T>
+        inline typename std::enable_if<(std::is_integral<T>::value && std::is_signed<T>::value) || std::is_enum<T>::value>::type
+        encode_arg(std::vector<uint8_t>& buffer, T value)
+        {
+            put_tagged(buffer, ArgTag::Signed, static_cast<int64_t>(value));
+        }
+
+        //! Encode unsigned integers (and bool) as uint64_t
+        template<typename T>
+        inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+        encode_arg(std::vector<uint8_t>& buffer, T value)
+        {
+            put_tagged(buffer, ArgTag::Unsigned, static_cast<uint64_t>(value));
+        }
+
+        //! Encode floating point values as double
+        template<typename T>
+        inline typename std::enable_if<std::is_floating_point<T>::value>::type
+        encode_arg(std::vector<uint8_t>& buffer, T value)
+        {
+            put_tagged(buffer, ArgTag::Floating, static_cast<double>(value));
+        }
+
+        //! Encode pointers other than C-strings by their address
+        template<typename T>
+        inline typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type, char>::value>::type
+        encode_arg(std::vector<uint8_t>& buffer, T* value)
+        {
+            put_tagged(buffer, ArgTag::Pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        }
+
+        //! Encode C-strings by copying their content (the pointer might be invalid when the record is formatted)
+        inline void encode_arg(std::vector<uint8_t>& buffer, const char* value)
+        {
+            if (value == nullptr) value = "(null)";
+            put_string(buffer, value, strlen(value));
+        }
+
+        //! Encode C-strings by copying their content (the pointer might be invalid when the record is formatted)
+        inline void encode_arg(std::vector<uint8_t>& buffer, char* value)
+        {
+            encode_arg(buffer, static_cast<const char*>(value));
+        }
+
+        //! Encode std::strings by copying their content
+        inline void encode_arg(std::vector<uint8_t>& buffer, const std::string& value)
+        {
+            put_string(buffer, value.data(), value.size());
+        }
+
+        //! End of recursion for encode_args
+        inline void encode_args(std::vector<uint8_t>&) {}
+
+        /**
+         * \brief Encode all given arguments, each with its type tag
+         */
+        template<typename First, typename ...Rest>
+        inline void encode_args(std::vector<uint8_t>& buffer, First&& first, Rest&& ...rest)
+        {
+            encode_arg(buffer, first);
+            encode_args(buffer, std::forward<Rest>(rest)...);
+        }
+
+        /**
+         * \brief Append a whole record to the buffer
+         * \param buffer Buffer to append to, e.g. the thread-local buffer of the Logging instance
+         * \param format_id ID of the format string, as returned by Logging::register_binary_format
+         * \param log_level Log level of the message
+         * \param timestamp Creation time of the message in ns
+         * \param args Arguments for the format string
+         */
+        template<typename ...Args>
+        inline void encode_record(std::vector<uint8_t>& buffer, uint32_t format_id, uint8_t log_level, uint64_t timestamp, Args&& ...args)
+        {
+            static_assert(sizeof...(Args) < 256, "Too many arguments for a binary log record");
+            uint8_t arg_count = static_cast<uint8_t>(sizeof...(Args));
+            put(buffer, &format_id, sizeof(format_id));
+            put(buffer, &log_level, sizeof(log_level));
+            put(buffer, &timestamp, sizeof(timestamp));
+            put(buffer, &arg_count, sizeof(arg_count));
+            encode_args(buffer, std::forward<Args>(args)...);
+        }
+
+        /**
+         * \struct DecodedArg
+         * \brief A decoded argument of a record
+         */
+        struct DecodedArg {
+            //! Type of the argument
+            ArgTag tag;
+            //! Value, if tag is Signed
+            int64_t i = 0;
+            //! Value, if tag is Unsigned or Pointer
+            uint64_t u = 0;
+            //! Value, if tag is Floating
+            double d = 0.0;
+            //! Value, if tag is String
+            std::string s;
+        };
+
+        /**
+         * \struct DecodedRecord
+         * \brief A decoded (but not yet formatted) record
+         */
+        struct DecodedRecord {
+            //! ID of the format string of the call site
+            uint32_t format_id = 0;
+            //! Log level of the message
+            uint8_t log_level = 0;
+            //! Creation time of the message in ns
+            uint64_t timestamp = 0;
+            //! Arguments for the format string
+            std::vector<DecodedArg> args;
+        };
+
+        /**
+         * \brief Decode the next record of an encoded buffer
+         * \param data Encoded records
+         * \param size Size of data in bytes
+         * \param offset Position of the next record in data, is moved behind the decoded record
+         * \param record_out The decoded record
+         * \return False if no (complete) record could be decoded, e.g. because the end of the buffer was reached or the data is corrupted
+         */
+        bool decode_record(const uint8_t* data, size_t size, size_t& offset, DecodedRecord& record_out);
+
+        /**
+         * \brief Create the log string from a printf-style format string and decoded arguments.
+         * Each conversion is formatted with snprintf, using the type that was recorded for the argument.
+         * Widths and precisions given as * take their value from the next argument, like in printf.
+         * Missing arguments are shown as "<?>", superfluous arguments are ignored.
+         * \param format Format string as announced in LogFormat
+         * \param args Decoded arguments of the record
+         */
+        std::string format_record(const std::string& format, const std::vector<DecodedArg>& args);
+    }
+}
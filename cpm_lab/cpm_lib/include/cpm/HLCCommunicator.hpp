@@ -31,6 +31,8 @@
 #include <functional>                       // So we can use std::function
 #include <limits>                           // To get maximum integer value (for stop condition)
 #include <future>                           // So we can use std::async, std::future etc
+#include <map>                              // For the offered commands per vehicle
+#include <mutex>                            // To protect the offered commands and the command writers
 #include <sstream>                          // For std::stringstream
 #include <cstdlib>                          // For getenv("HOME"), so get the default QOS path
 #include <unistd.h>                         // For usleep; Change to sleep_for is possible as soon as the ARM Build supports C++11
@@ -41,12 +43,19 @@
 #include "cpm/ReaderAbstract.hpp"
 #include "cpm/Participant.hpp"
 #include "cpm/Logging.hpp"
+#include "cpm/HLCMailbox.hpp"
+#include "cpm/TimestepDeadline.hpp"
+#include "cpm/get_time_ns.hpp"
 
 // DDS topics
 #include "ReadyStatus.hpp"
 #include "SystemTrigger.hpp"
 #include "VehicleStateList.hpp"
 #include "StopRequest.hpp"
+#include "VehicleCommandTrajectory.hpp"
+#include "VehicleCommandPathTracking.hpp"
+#include "VehicleCommandSpeedCurvature.hpp"
+#include "VehicleCommandDirect.hpp"
 
 class HLCCommunicator{
     /**
@@ -66,6 +75,48 @@ class HLCCommunicator{
     //! Participant to communicate with the middleware
     std::shared_ptr<cpm::Participant> p_local_comms_participant;
 
+    //! DDS domain of the communication with the middleware, used to find its local mailbox
+    int middleware_domain;
+    //! Whether the local mailbox of the middleware should be used if possible (see useLocalMailbox)
+    bool use_local_mailbox = true;
+    //! Shared memory mailbox to the middleware, if it runs on the same machine; else nullptr and DDS is used
+    std::shared_ptr<cpm::HLCMailbox> local_mailbox;
+    //! Time of the last attempt to open the local mailbox, see getLocalMailbox
+    uint64_t local_mailbox_open_time_ns = 0;
+    //! Min. time between two attempts to open the local mailbox while the middleware is not reachable via it
+    static const uint64_t LOCAL_MAILBOX_RETRY_NS = 1000000000ull;
+    //! Protects local_mailbox, as commands are sent from the planning thread and from start()
+    std::mutex local_mailbox_mutex;
+    //! Buffer for messages received via local_mailbox
+    std::vector<char> local_mailbox_buffer;
+
+    //! Writers for commands sent via sendCommand, created when they are first used if the local mailbox cannot be used
+    std::shared_ptr<cpm::Writer<VehicleCommandTrajectory>> writer_trajectory;
+    //! See writer_trajectory
+    std::shared_ptr<cpm::Writer<VehicleCommandPathTracking>> writer_path_tracking;
+    //! See writer_trajectory
+    std::shared_ptr<cpm::Writer<VehicleCommandSpeedCurvature>> writer_speed_curvature;
+    //! See writer_trajectory
+    std::shared_ptr<cpm::Writer<VehicleCommandDirect>> writer_direct;
+    //! Protects the lazy creation of the command writers, as commands are sent from the planning thread and from start()
+    std::mutex command_writer_mutex;
+
+    //! Latest command per vehicle offered via offerCommand in the current timestep, not yet sent
+    std::map<uint8_t, VehicleCommandTrajectory> offered_trajectory;
+    //! See offered_trajectory
+    std::map<uint8_t, VehicleCommandPathTracking> offered_path_tracking;
+    //! See offered_trajectory
+    std::map<uint8_t, VehicleCommandSpeedCurvature> offered_speed_curvature;
+    //! See offered_trajectory
+    std::map<uint8_t, VehicleCommandDirect> offered_direct;
+    //! Protects the offered commands
+    std::mutex offered_commands_mutex;
+
+    //! Deadline of the current timestep, nullptr before the first timestep
+    std::shared_ptr<cpm::TimestepDeadline> current_deadline;
+    //! Time that is reserved before the end of the period to send the commands, see setDeadlineMargin
+    uint64_t deadline_margin_ns = 5000000ull;
+
     //! SystemTrigger value that means "stop" (as defined in SystemTrigger.idl)
     const uint64_t trigger_stop = std::numeric_limits<uint64_t>::max();
 
@@ -91,6 +142,8 @@ class HLCCommunicator{
     std::function<void(VehicleStateList)>   on_first_timestep;
     //! Callback function for when we need to take every timestep (including the first one)
     std::function<void(VehicleStateList)>   on_each_timestep;
+    //! Like on_each_timestep, but with the deadline of the timestep; takes precedence over on_each_timestep
+    std::function<void(VehicleStateList, std::shared_ptr<cpm::TimestepDeadline>)> on_each_timestep_with_deadline;
     //! Callback function for when we need to cancel a planning timestep before it's finished
     std::function<void()>                   on_cancel_timestep;
     //! Callback function for when we have to completely stop planning
@@ -121,6 +174,79 @@ class HLCCommunicator{
      */
     bool stopSignalReceived();
 
+    /**
+     * \brief Receive messages from the local mailbox (if it is used), waits up to timeout_ns for the first one
+     * \param timeout_ns Max. waiting time in ns
+     * \return True if a stop signal was received
+     */
+    bool receiveFromLocalMailbox(uint64_t timeout_ns);
+
+    /**
+     * \brief Get the local mailbox to the middleware, if it is used and the middleware that created it is still running.
+     * If the middleware has stopped (e.g. it crashed or was restarted), the mailbox is (re-)opened, at most every LOCAL_MAILBOX_RETRY_NS,
+     * s.t. the mailbox of a restarted middleware is used again.
+     * \return The mailbox, or nullptr if DDS must be used
+     */
+    std::shared_ptr<cpm::HLCMailbox> getLocalMailbox();
+
+    /**
+     * \brief If the deadline of the current timestep has passed, cancel the timestep and send the offered commands
+     */
+    void checkDeadline();
+
+    /**
+     * \brief Send all commands offered via offerCommand and not sent yet
+     */
+    void sendOfferedCommands();
+
+    /**
+     * \brief Remember a command as the latest offer for its vehicle, replacing older offers
+     * \param offered Offered commands of the command type
+     * \param command The command
+     */
+    template<class T> void offerCommandHelper(std::map<uint8_t, T>& offered, const T& command)
+    {
+        std::lock_guard<std::mutex> lock(offered_commands_mutex);
+        offered[command.vehicle_id()] = command;
+    }
+
+    /**
+     * \brief Send the given offered commands and remove them, see sendOfferedCommands
+     * \param offered Offered commands of the command type
+     */
+    template<class T> void sendOfferedCommandsHelper(std::map<uint8_t, T>& offered)
+    {
+        std::map<uint8_t, T> commands;
+        {
+            std::lock_guard<std::mutex> lock(offered_commands_mutex);
+            commands.swap(offered);
+        }
+        for( auto& entry : commands ) {
+            sendCommand(entry.second);
+        }
+    }
+
+    /**
+     * \brief Send a command via the local mailbox if it is used, else via DDS
+     * \param tag Type of the command for the local mailbox
+     * \param writer DDS writer for the command, created if it does not exist yet
+     * \param topic DDS topic for the command
+     * \param command The command
+     */
+    template<class T> void sendCommandHelper(cpm::HLCMailbox::MessageTag tag, std::shared_ptr<cpm::Writer<T>>& writer, std::string topic, const T& command)
+    {
+        // Commands written to the mailbox of a middleware that is not running anymore would get lost
+        std::shared_ptr<cpm::HLCMailbox> mailbox = getLocalMailbox();
+        if (mailbox && mailbox->write(tag, command)) return;
+
+        std::lock_guard<std::mutex> lock(command_writer_mutex);
+        if (!writer)
+        {
+            writer = std::make_shared<cpm::Writer<T>>(p_local_comms_participant->get_participant(), topic);
+        }
+        writer->write(command);
+    }
+
     /**
      * \brief Writes a short summary of the setup to Logging
      * Includes vehicle_id, and which callbacks are defined or not defined
@@ -182,6 +308,31 @@ public:
      */
     void onEachTimestep(std::function<void(VehicleStateList)> callback) { on_each_timestep = callback; };
 
+    /**
+     * \brief What our HLC should do each timestep, for planners that can make use of the time that is left in the timestep
+     * (e.g. iterative / anytime planners). Replaces the callback set via onEachTimestep.
+     * \param callback Callback function that takes a VehicleStateList and the deadline of the timestep as parameters.
+     * This function will get called once per timestep.
+     *
+     * The deadline is computed from t_now and period_ms of the VehicleStateList, minus the margin set via setDeadlineMargin.
+     * The planner should check it regularly (cpm::TimestepDeadline::is_cancelled, cpm::TimestepDeadline::has_time_for)
+     * and return when it is cancelled. It is cancelled when the deadline has passed or the next timestep starts,
+     * so onCancelTimestep is usually not required with this callback. If the planner has not returned within the margin
+     * after the next timestep started, that timestep is skipped.
+     *
+     * To use the full budget, send a first solution early via sendCommand, and offer refined solutions via offerCommand.
+     * The latest offer per vehicle is sent at the deadline or when the callback returns, whichever comes first.
+     */
+    void onEachTimestepWithDeadline(std::function<void(VehicleStateList, std::shared_ptr<cpm::TimestepDeadline>)> callback) { on_each_timestep_with_deadline = callback; };
+
+    /**
+     * \brief Set the time that is reserved before the end of each period for sending the commands (default: 5ms)
+     * \param margin_ns The margin in ns; at most half of the period is used
+     *
+     * See onEachTimestepWithDeadline.
+     */
+    void setDeadlineMargin(uint64_t margin_ns) { deadline_margin_ns = margin_ns; };
+
     /**
      * \brief What our HLC should do, when it needs to abort planning a timestep early.
      * \param callback Callback function without parameters that will be called, when our HLC is
@@ -205,6 +356,66 @@ public:
      */
     void onStop(std::function<void()> callback) { on_stop = callback; };
 
+    /**
+     * \brief Whether the local mailbox to the middleware should be used (default: true)
+     * \param use If true and the middleware runs on the same machine with the same vehicle IDs, VehicleStateList and SystemTrigger
+     * messages and commands sent with sendCommand are exchanged with the middleware via shared memory instead of DDS (see cpm::HLCMailbox).
+     * Must be called before start.
+     */
+    void useLocalMailbox(bool use) { use_local_mailbox = use; };
+
+    /**
+     * \brief Send a command to the middleware, via the local mailbox if possible, else via DDS.
+     * Commands can also be sent with own writers on getLocalParticipant(), but these always use DDS.
+     * \param command The command
+     */
+    void sendCommand(const VehicleCommandTrajectory& command) { sendCommandHelper(cpm::HLCMailbox::TagVehicleCommandTrajectory, writer_trajectory, "vehicleCommandTrajectory", command); };
+
+    /**
+     * \brief See sendCommand(const VehicleCommandTrajectory&)
+     * \param command The command
+     */
+    void sendCommand(const VehicleCommandPathTracking& command) { sendCommandHelper(cpm::HLCMailbox::TagVehicleCommandPathTracking, writer_path_tracking, "vehicleCommandPathTracking", command); };
+
+    /**
+     * \brief See sendCommand(const VehicleCommandTrajectory&)
+     * \param command The command
+     */
+    void sendCommand(const VehicleCommandSpeedCurvature& command) { sendCommandHelper(cpm::HLCMailbox::TagVehicleCommandSpeedCurvature, writer_speed_curvature, "vehicleCommandSpeedCurvature", command); };
+
+    /**
+     * \brief See sendCommand(const VehicleCommandTrajectory&)
+     * \param command The command
+     */
+    void sendCommand(const VehicleCommandDirect& command) { sendCommandHelper(cpm::HLCMailbox::TagVehicleCommandDirect, writer_direct, "vehicleCommandDirect", command); };
+
+    /**
+     * \brief Offer the best command found so far for its vehicle in the current timestep; it replaces earlier offers for the same vehicle.
+     * The latest offer is sent via sendCommand at the deadline of the timestep or when the timestep callback returns,
+     * whichever comes first. Offers made after the deadline are sent right away by the loop in start() (within about 1ms).
+     * See onEachTimestepWithDeadline.
+     * \param command The command
+     */
+    void offerCommand(const VehicleCommandTrajectory& command) { offerCommandHelper(offered_trajectory, command); };
+
+    /**
+     * \brief See offerCommand(const VehicleCommandTrajectory&)
+     * \param command The command
+     */
+    void offerCommand(const VehicleCommandPathTracking& command) { offerCommandHelper(offered_path_tracking, command); };
+
+    /**
+     * \brief See offerCommand(const VehicleCommandTrajectory&)
+     * \param command The command
+     */
+    void offerCommand(const VehicleCommandSpeedCurvature& command) { offerCommandHelper(offered_speed_curvature, command); };
+
+    /**
+     * \brief See offerCommand(const VehicleCommandTrajectory&)
+     * \param command The command
+     */
+    void offerCommand(const VehicleCommandDirect& command) { offerCommandHelper(offered_direct, command); };
+
     /**
      * \brief Communicate to the middleware that we're ready and can start planning
      *
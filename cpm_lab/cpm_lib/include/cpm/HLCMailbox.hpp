@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <dds/topic/ddstopic.hpp>
+
+#include "cpm/SharedMemoryMailbox.hpp"
+
+namespace cpm
+{
+    /**
+     * \class HLCMailbox
+     * \brief Local fast path between the Middleware and a C++ HLC (using HLCCommunicator) that run on the same machine.
+     * Instead of using DDS for the messages that are exchanged every period (VehicleStateList to the HLC, commands from the HLC),
+     * the messages are exchanged via a pair of shared memory mailboxes (see SharedMemoryMailbox), which skips the DDS transport,
+     * its reliability protocol and the DDS receive threads. The messages are still CDR-serialized, as the IDL types contain sequences.
+     *
+     * The Middleware creates the mailbox pair on startup, named after its HLC domain and its vehicle IDs. An HLC with the same vehicle IDs
+     * opens and attaches to it before it sends its ready message. When the Middleware has received all ready messages, it uses the mailbox
+     * only if an HLC is attached, else (remote HLC, HLC in another language like Matlab, different vehicle IDs) it keeps using DDS.
+     * Each message is tagged with its type.
+     * \ingroup cpmlib
+     */
+    class HLCMailbox
+    {
+    public:
+        /**
+         * \enum MessageTag
+         * \brief Message types that can be sent via the mailbox
+         */
+        enum MessageTag : uint32_t {
+            TagVehicleStateList = 1,
+            TagSystemTrigger,
+            TagVehicleCommandTrajectory,
+            TagVehicleCommandPathTracking,
+            TagVehicleCommandSpeedCurvature,
+            TagVehicleCommandDirect
+        };
+
+    private:
+        //! Mailbox for messages to the HLC
+        std::shared_ptr<SharedMemoryMailbox> to_hlc;
+        //! Mailbox for messages from the HLC
+        std::shared_ptr<SharedMemoryMailbox> from_hlc;
+        //! True for the Middleware side, false for the HLC side
+        bool is_middleware;
+
+        /**
+         * \brief Constructor, use create or open instead
+         * \param _to_hlc Mailbox for messages to the HLC
+         * \param _from_hlc Mailbox for messages from the HLC
+         * \param _is_middleware True for the Middleware side, false for the HLC side
+         */
+        HLCMailbox(std::shared_ptr<SharedMemoryMailbox> _to_hlc, std::shared_ptr<SharedMemoryMailbox> _from_hlc, bool _is_middleware);
+
+        /**
+         * \brief Name of the shared memory segment of one direction
+         * \param domain DDS domain of the communication between Middleware and HLC
+         * \param vehicle_ids Vehicle IDs of the Middleware / HLC
+         * \param direction "to_hlc" or "from_hlc"
+         */
+        static std::string get_name(int domain, const std::vector<uint8_t>& vehicle_ids, std::string direction);
+
+    public:
+        //! Max. number of buffered messages per direction
+        static const size_t SLOT_COUNT = 64;
+        //! Max. size of a serialized message in bytes; larger messages must be sent via DDS
+        static const size_t SLOT_SIZE = 65536;
+
+        /**
+         * \brief Create the mailbox pair (Middleware side)
+         * \param domain DDS domain of the communication between Middleware and HLC
+         * \param vehicle_ids Vehicle IDs of the Middleware
+         * \return The mailbox, or nullptr if it could not be created
+         */
+        static std::shared_ptr<HLCMailbox> create(int domain, const std::vector<uint8_t>& vehicle_ids);
+
+        /**
+         * \brief Open the mailbox pair of a running Middleware and attach to it (HLC side)
+         * \param domain DDS domain of the communication between Middleware and HLC
+         * \param vehicle_ids Vehicle IDs of the HLC
+         * \return The mailbox, or nullptr if no Middleware with the same domain and vehicle IDs runs on this machine
+         */
+        static std::shared_ptr<HLCMailbox> open(int domain, const std::vector<uint8_t>& vehicle_ids);
+
+        /**
+         * \brief Middleware side: Check if an HLC is attached to the mailbox and still running
+         */
+        bool is_hlc_attached();
+
+        /**
+         * \brief HLC side: Check if the Middleware is still running
+         */
+        bool is_middleware_alive();
+
+        /**
+         * \brief Serialize and send a message to the other side
+         * \param tag Type of the message
+         * \param message The message
+         * \return False if the message could not be sent (too large), in which case DDS should be used instead
+         */
+        template<class T> bool write(MessageTag tag, const T& message)
+        {
+            std::vector<char> buffer;
+            dds::topic::topic_type_support<T>::to_cdr_buffer(buffer, message);
+            return (is_middleware ? to_hlc : from_hlc)->write(static_cast<uint32_t>(tag), buffer.data(), buffer.size());
+        }
+
+        /**
+         * \brief Receive the next message from the other side, waits for it if there is none
+         * \param tag Returns the type of the message
+         * \param buffer Returns the serialized message, see deserialize
+         * \param timeout_ns Max. time to wait for a message in ns, 0 to not wait at all
+         * \return True if a message was received, false on timeout
+         */
+        bool read(MessageTag& tag, std::vector<char>& buffer, uint64_t timeout_ns);
+
+        /**
+         * \brief Deserialize a message received with read
+         * \param buffer The serialized message
+         * \param message Returns the message, must have the type given by the tag
+         */
+        template<class T> static void deserialize(const std::vector<char>& buffer, T& message)
+        {
+            dds::topic::topic_type_support<T>::from_cdr_buffer(message, buffer);
+        }
+
+        /**
+         * \brief Number of received messages that were lost because they were not read in time
+         */
+        uint64_t get_lost_messages();
+    };
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cpm
+{
+    /**
+     * \class LogRateLimiter
+     * \brief Token-bucket rate limiting for log messages, used by cpm::Logging.
+     * Each call site (identified by the address of its source location string, a string literal like "file.cpp:42", see CPM_LOG) has its own bucket, 
+     * and all call sites of the node (i.e. of the Logging instance) share another bucket. A message is only sent if both buckets have a token left.
+     * Messages without a call site are only limited by the bucket of the node.
+     * Suppressed messages are counted per call site and reported periodically by a summary message,
+     * s.t. a node that logs in a fast loop can neither saturate the network nor the LCC.
+     * Does not depend on DDS, s.t. it can be tested on its own.
+     * \ingroup cpmlib
+     */
+    class LogRateLimiter
+    {
+    public:
+        /**
+         * \struct Summary
+         * \brief Information about suppressed messages of a single call site, to be logged by the caller
+         */
+        struct Summary {
+            //! Log level of the most recently suppressed message of the call site
+            unsigned short log_level;
+            //! Source location of the call site, e.g. file:line
+            std::string call_site;
+            //! Format string of the most recent message of the call site
+            std::string format;
+            //! Number of suppressed messages since the last summary of this call site
+            uint64_t suppressed_count;
+        };
+
+        /**
+         * \struct Statistics
+         * \brief Counters of the rate limiter, e.g. for monitoring purposes
+         */
+        struct Statistics {
+            //! Messages that passed the rate limiter
+            uint64_t messages_passed = 0;
+            //! Messages that were suppressed by the rate limiter
+            uint64_t messages_suppressed = 0;
+            //! Messages that were suppressed due to the bucket of the whole node (included in messages_suppressed)
+            uint64_t messages_suppressed_by_node_limit = 0;
+            //! Number of call sites with suppressed messages that were not yet summarized
+            size_t suppressing_call_sites = 0;
+            //! Suppressed messages per call site (source location) since the start of the program
+            std::map<std::string, uint64_t> suppressed_per_call_site;
+        };
+
+    private:
+        /**
+         * \struct TokenBucket
+         * \brief Bucket that is refilled with a constant rate up to its size
+         */
+        struct TokenBucket {
+            //! Currently available tokens
+            double tokens = 0.0;
+            //! Time of the last refill in ns
+            uint64_t last_refill_ns = 0;
+
+            /**
+             * \brief Add the tokens that were generated since the last refill
+             * \param now_ns Current time in ns
+             * \param rate Tokens per second
+             * \param burst Max. number of tokens
+             */
+            void refill(uint64_t now_ns, double rate, double burst);
+        };
+
+        /**
+         * \struct CallSite
+         * \brief Rate limiting state of a single call site
+         */
+        struct CallSite {
+            //! Copy of the source location, for the summaries
+            std::string location;
+            //! Copy of the format string, for the summaries; only updated if the call site uses a different (dynamic) format string
+            std::string format;
+            //! Bucket of the call site
+            TokenBucket bucket;
+            //! Suppressed messages since the last summary
+            uint64_t suppressed_since_summary = 0;
+            //! Suppressed messages since the start of the program
+            uint64_t suppressed_total = 0;
+            //! Log level of the most recent suppressed message
+            unsigned short last_log_level = 0;
+            //! Time of the last message (passed or suppressed) in ns, to remove idle call sites
+            uint64_t last_use_ns = 0;
+        };
+
+        //! Max. number of call sites that are tracked; idle call sites are removed first, further call sites only use the node bucket
+        static constexpr size_t MAX_CALL_SITES = 1024;
+
+        //! Messages per second per call site
+        double call_site_rate = 10.0;
+        //! Burst size per call site
+        double call_site_burst = 20.0;
+        //! Messages per second of the whole node
+        double node_rate = 100.0;
+        //! Burst size of the whole node
+        double node_burst = 200.0;
+        //! Period of the suppression summaries in ns
+        uint64_t summary_period_ns = 1000000000ull;
+
+        //! Rate limiting state of all known call sites, by address of the source location string, s.t. a log call does not need to copy or hash the string
+        std::unordered_map<const char*, CallSite> call_sites;
+        //! Bucket shared by all call sites
+        TokenBucket node_bucket;
+        //! Time of the last summary in ns
+        uint64_t last_summary_ns = 0;
+        //! Set in the first call of allow, to initialize the buckets
+        bool initialized = false;
+        //! Counters, see get_statistics
+        Statistics statistics;
+        //! Mutex for all members, as logs are written from multiple threads
+        std::mutex mutex;
+
+        /**
+         * \brief Collect summaries for all call sites with suppressed messages, remove idle call sites. Does not lock the mutex.
+         * \param now_ns Current time in ns
+         * \param summaries_out The summaries are appended here
+         */
+        void collect_summaries(uint64_t now_ns, std::vector<Summary>& summaries_out);
+
+    public:
+        /**
+         * \brief Check if a message of the given call site may be sent now and take a token if so.
+         * If the summary period has passed, the summaries of all call sites with suppressed messages are returned as well;
+         * the caller should log them (without calling allow again).
+         * \param call_site Source location of the call site, a string literal that is compared by address (see CPM_LOG); nullptr if unknown,
+         * then only the bucket of the node applies
+         * \param format Format string of the message, for the summaries
+         * \param log_level Log level of the message
+         * \param now_ns Current time in ns
+         * \param summaries_out Summaries of suppressed messages are appended here (usually empty)
+         * \return True if the message may be sent, false if it must be dropped
+         */
+        bool allow(const char* call_site, const char* format, unsigned short log_level, uint64_t now_ns, std::vector<Summary>& summaries_out);
+
+        /**
+         * \brief Collect the summaries of suppressed messages if the summary period has passed since the last summary.
+         * Must be called regularly, s.t. the summaries of a log storm are also reported if no further messages are logged afterwards.
+         * \param now_ns Current time in ns
+         * \param summaries_out Summaries of suppressed messages are appended here
+         */
+        void collect_due_summaries(uint64_t now_ns, std::vector<Summary>& summaries_out);
+
+        /**
+         * \brief Change the limits. A rate of 0 or less disables the respective limit.
+         * \param call_site_rate Messages per second per call site
+         * \param call_site_burst Messages that a call site may send at once (after being silent for a while)
+         * \param node_rate Messages per second of all call sites together
+         * \param node_burst Messages that all call sites together may send at once
+         */
+        void set_limits(double call_site_rate, double call_site_burst, double node_rate, double node_burst);
+
+        /**
+         * \brief Change the period in which summaries of suppressed messages are created
+         * \param period_ns The period in ns
+         */
+        void set_summary_period(uint64_t period_ns);
+
+        /**
+         * \brief Get the counters of the rate limiter
+         */
+        Statistics get_statistics();
+    };
+}
@@ -9,9 +9,15 @@
 #include <mutex>
 #include <algorithm>
 #include <atomic>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include <vector>
 
 #include "Log.hpp"
 #include "LogLevel.hpp"
+#include "LogFormat.hpp"
+#include "LogRecordBatch.hpp"
 
 #include "cpm/AsyncReader.hpp"
 #include "cpm/ParticipantSingleton.hpp"
@@ -19,6 +25,35 @@
 #include "cpm/get_time_ns.hpp"
 #include "cpm/Parameter.hpp"
 #include "cpm/Writer.hpp"
+#include "cpm/BinaryLogRecord.hpp"
+#include "cpm/LogRateLimiter.hpp"
+
+//! Helper for CPM_LOG and CPM_LOG_BINARY, to turn __LINE__ into a string literal
+#define CPM_LOG_STRINGIFY_IMPL(x) #x
+//! Helper for CPM_LOG and CPM_LOG_BINARY, to turn __LINE__ into a string literal
+#define CPM_LOG_STRINGIFY(x) CPM_LOG_STRINGIFY_IMPL(x)
+
+/**
+ * \brief Version of cpm::Logging::Instance().write(log_level, format, ...) that passes the source location of the call site,
+ * s.t. the call site is rate limited on its own (see LogRateLimiter), even if other call sites use the same format string (e.g. "%s").
+ * \ingroup cpmlib
+ */
+#define CPM_LOG(log_level, format, ...) \
+    cpm::Logging::Instance().write_at(__FILE__ ":" CPM_LOG_STRINGIFY(__LINE__), log_level, format, ##__VA_ARGS__)
+
+/**
+ * \brief Binary (deferred-formatting) version of cpm::Logging::Instance().write(log_level, format, ...).
+ * The format string is registered once per call site; afterwards, each call only records the format ID, 
+ * the timestamp and the raw arguments in a buffer of the calling thread. Formatting happens on the receiver side (LCC).
+ * Use this for verbose logs in periodic / time-critical code. The format must be a string literal.
+ * \ingroup cpmlib
+ */
+#define CPM_LOG_BINARY(log_level, format, ...) \
+    do { \
+        static const uint32_t cpm_binary_log_format_id = \
+            cpm::Logging::Instance().register_binary_format(format, __FILE__ ":" CPM_LOG_STRINGIFY(__LINE__)); \
+        cpm::Logging::Instance().write_binary(cpm_binary_log_format_id, log_level, ##__VA_ARGS__); \
+    } while (0)
 
 namespace cpm {
     /**
@@ -50,11 +85,119 @@ namespace cpm {
             //! Reader to receive the currently set log level in the system
             std::shared_ptr<cpm::AsyncReader<LogLevel>> log_level_reader;
 
+            //! Limits the messages sent by write per call site and for the whole node, s.t. log storms do not flood the network and the LCC
+            LogRateLimiter rate_limiter;
+
+            /**
+             * \brief Write an already formatted message to the log file, the console and via DDS (no log level check, no rate limit)
+             * \param message_log_level Log level of the message
+             * \param str The message
+             * \param time_now Timestamp of the message
+             */
+            void write_formatted(unsigned short message_log_level, const std::string& str, uint64_t time_now);
+
+            /**
+             * \brief Log summaries of messages that were suppressed by the rate limiter
+             * \param summaries Summaries returned by the rate limiter
+             * \param time_now Timestamp for the summary messages
+             */
+            void write_suppression_summaries(const std::vector<LogRateLimiter::Summary>& summaries, uint64_t time_now);
+
+            //Binary logging (see write_binary)
+            /**
+             * \struct BinaryLogBuffer
+             * \brief Per-thread buffer for encoded binary log records
+             */
+            struct BinaryLogBuffer {
+                //! Only contended while the flush thread swaps the records with an empty vector
+                std::mutex mutex;
+                //! Encoded records (see BinaryLogRecord.hpp)
+                std::vector<uint8_t> records;
+                //! Set when the owning thread terminated, s.t. the buffer can be removed after its last flush
+                std::atomic_bool thread_exited{false};
+            };
+
+            //! The flush thread is woken up early if a buffer grows beyond this size (in bytes)
+            static constexpr size_t BINARY_FLUSH_SIZE = 8192;
+            //! Max. size of a batch (bound of LogRecordBatch::records), larger records are dropped
+            static constexpr size_t BINARY_MAX_BATCH_SIZE = 16384;
+            //! Period of the flush thread in milliseconds
+            static constexpr unsigned int BINARY_FLUSH_PERIOD_MS = 100;
+
+            //! Random ID of this Logging instance, used to match LogFormat and LogRecordBatch messages
+            uint64_t session_id;
+            //! Next free format ID for register_binary_format
+            std::atomic_uint next_format_id{0};
+            //! DDS Writer for format strings of binary log call sites (reliable, transient local)
+            cpm::Writer<LogFormat> format_writer;
+            //! DDS Writer for binary log records
+            cpm::Writer<LogRecordBatch> record_writer;
+            //! Buffers of all threads that wrote binary logs so far (removed when their thread exited)
+            std::vector<std::shared_ptr<BinaryLogBuffer>> binary_buffers;
+            //! Mutex for binary_buffers and for starting the flush thread
+            std::mutex binary_buffers_mutex;
+            //! Records that were dropped because the buffer of their thread would have exceeded BINARY_MAX_BATCH_SIZE
+            std::atomic_ullong binary_records_dropped{0};
+            //! Periodically publishes the content of all binary_buffers and the summaries of rate_limiter, started when the first format
+            //! is registered or the first message is suppressed
+            std::thread binary_flush_thread;
+            //! Set once binary_flush_thread was started, to check this without locking binary_buffers_mutex
+            std::atomic_bool binary_flush_thread_started{false};
+            //! Tells binary_flush_thread to stop
+            bool binary_flush_stop = false;
+            //! Set by write_binary if a buffer exceeds BINARY_FLUSH_SIZE, s.t. binary_flush_thread flushes before the period is over
+            std::atomic_bool binary_flush_requested{false};
+            //! To wake up binary_flush_thread early on destruction or if binary_flush_requested was set
+            std::condition_variable binary_flush_cv;
+
+            /**
+             * \brief Creates the pthread key that refers to the binary log buffer of each thread (called once).
+             * A pthread key is used instead of thread_local, as the ARM toolchain does not support the latter.
+             */
+            static void create_binary_buffer_key();
+
+            /**
+             * \brief Destructor of the pthread key, marks the buffer of a terminating thread s.t. the flush thread can remove it
+             * \param buffer The BinaryLogBuffer of the thread
+             */
+            static void mark_binary_buffer_exited(void* buffer);
+
+            /**
+             * \brief Returns the binary log buffer of the calling thread, creates and registers it on first use
+             */
+            BinaryLogBuffer& get_thread_binary_buffer();
+
+            /**
+             * \brief Send the given records via DDS and clear them afterwards. Called by the flush thread with records that were swapped out of a buffer.
+             * \param records Encoded records of one thread
+             */
+            void publish_binary_records(std::vector<uint8_t>& records);
+
+            /**
+             * \brief Start binary_flush_thread if it is not running yet
+             */
+            void start_flush_thread();
+
+            /**
+             * \brief Loop of binary_flush_thread: Publishes all buffers and the due summaries of rate_limiter every BINARY_FLUSH_PERIOD_MS
+             */
+            void binary_flush_loop();
+
+            /**
+             * \brief Publish the content of all buffers once, remove buffers of terminated threads
+             */
+            void flush_binary_buffers();
+
             /**
              * \brief Private Logging constructor to set up the Logging Singleton
              */
             Logging();
 
+            /**
+             * \brief Private Logging destructor, stops the flush thread of the binary logs and publishes remaining records
+             */
+            ~Logging();
+
             /**
              * \brief Private function to get the current time in ns, just uses get_time_ns
              */
@@ -91,54 +234,56 @@ namespace cpm {
             std::string get_filename();
 
             /**
-             * \brief Allows for a C-style use of the logger, like printf, using snprintf
+             * \brief Allows for a C-style use of the logger, like printf, using snprintf.
+             * Messages are rate limited per call site and for the whole program, see set_rate_limits.
+             * Suppressed messages are reported periodically in a summary message.
+             * Usually called via CPM_LOG, which passes the call site.
+             * \param call_site Source location of the call site, a string literal (compared by address); nullptr if unknown, then only the limit of the whole program applies
              * \param message_log_level Determines the relevance of the message (1: critical system failure, 2: typical error message, 3: any other message (verbose) - 0 means 'never log anything')
              * \param f String of a form like in fprintf
              * \param args Optional parameters as given to fprintf after the format string
              */
-            template<class ...Args> void write(unsigned short message_log_level, const char* f, Args&& ...args) {
+            template<class ...Args> void write_at(const char* call_site, unsigned short message_log_level, const char* f, Args&& ...args) {
                 //Only log the message if the log_level of the message is <= the current level - else, it is not relevant enough
                 if (message_log_level <= log_level.load())
                 {
-                    int size = snprintf(nullptr, 0, f, args...); //Determine the size of the resulting string without actually writing it
-                    std::string str(size, ' ');
-                    snprintf(& str[0], size + 1, f, args...);
-
-                    //Before flushing make sure that the Logger was initialized properly / that its ID was set
-                    check_id();
-            
                     //Get the current time, use this timestamp for logging purposes
                     uint64_t time_now = get_time();
 
-                    //For the log file: csv, so escape '"'
-                    std::string log_string = std::string(str);
-                    std::string escaped_quote = std::string("\"\"");
-                    size_t pos = 0;
-                    while ((pos = log_string.find('"', pos)) != std::string::npos) {
-                        log_string.replace(pos, 1, escaped_quote);
-                        pos += escaped_quote.size();
-                    }
-                    //Also put the whole string in quotes
-                    log_string.insert(0, "\"");
-                    log_string += "\"";
-
-                    //Mutex for writing the message (file, writer) - is released when going out of scope
-                    std::lock_guard<std::mutex> lock(log_mutex);
+                    //Rate limit per call site and for the whole node
+                    std::vector<LogRateLimiter::Summary> summaries;
+                    if (rate_limiter.allow(call_site, f, message_log_level, time_now, summaries))
+                    {
+                        int size = snprintf(nullptr, 0, f, args...); //Determine the size of the resulting string without actually writing it
+                        std::string str(size, ' ');
+                        snprintf(& str[0], size + 1, f, args...);
 
-                    //Add the message to the log file - cast for log level is necessary to not create garbage symbols
-                    file.open(filename, std::ios::app);
-                    file << id << "," << static_cast<int>(message_log_level) << "," << time_now << "," << log_string << std::endl;
-                    file.close();
-
-                    //Send the log message via RTI
-                    Log log(id, str, TimeStamp(time_now), message_log_level);
-                    logger.write(log);
+                        write_formatted(message_log_level, str, time_now);
+                    }
+                    else if (!binary_flush_thread_started.load(std::memory_order_relaxed))
+                    {
+                        //The summary must also be written if nothing is logged after the storm
+                        start_flush_thread();
+                    }
 
-                    //Show the log message on the console
-                    std::cerr << "Log at time " << time_now << ", level " << static_cast<int>(message_log_level) << ": " << str << std::endl;
+                    if (summaries.size() > 0)
+                    {
+                        write_suppression_summaries(summaries, time_now);
+                    }
                 }
             }
 
+            /**
+             * \brief Allows for a C-style use of the logger, like printf, using snprintf.
+             * The call site is unknown, so only the rate limit of the whole program applies; use CPM_LOG to also limit the call site on its own.
+             * \param message_log_level Determines the relevance of the message, see write_at
+             * \param f String of a form like in fprintf
+             * \param args Optional parameters as given to fprintf after the format string
+             */
+            template<class ...Args> void write(unsigned short message_log_level, const char* f, Args&& ...args) {
+                write_at(nullptr, message_log_level, f, args...);
+            }
+
             /**
              * \brief Allows for a C-style use of the logger, like printf, using snprintf
              * We do not set any log-level here, the default value then is just one (as can be seen in the if clause)
@@ -150,5 +295,74 @@ namespace cpm {
                 //The default log-level, if none is specified, is 1 (highest priority)
                 write(1, f, args...);
             }
+
+            /**
+             * \brief Change the rate limits of write. A rate of 0 or less disables the respective limit.
+             * Default: 10 messages per second per call site (burst: 20), 100 messages per second for the whole program (burst: 200).
+             * \param call_site_rate Messages per second per call site (see CPM_LOG)
+             * \param call_site_burst Messages that a call site may send at once after being silent for a while
+             * \param node_rate Messages per second of the whole program
+             * \param node_burst Messages that the whole program may send at once
+             */
+            void set_rate_limits(double call_site_rate, double call_site_burst, double node_rate, double node_burst);
+
+            /**
+             * \brief Get the counters of the rate limiter of write, e.g. how many messages were suppressed per call site
+             */
+            LogRateLimiter::Statistics get_rate_limit_statistics();
+
+            /**
+             * \brief Register the format string of a binary log call site, usually called only once per call site by CPM_LOG_BINARY.
+             * The format is sent to all receivers (reliable, transient local), s.t. later records only need to refer to its ID.
+             * \param format printf-style format string, as for write
+             * \param location Source location of the call site, e.g. file:line
+             * \return ID of the format, to be passed to write_binary
+             */
+            uint32_t register_binary_format(const char* format, const char* location);
+
+            /**
+             * \brief Deferred-formatting version of write: Only the format ID, timestamp and raw arguments are recorded 
+             * in a buffer of the calling thread. The buffer is sent periodically (or earlier, if it grows large) as LogRecordBatch by a separate thread,
+             * so that the calling thread never writes to DDS itself. The receiver (e.g. the LCC) formats the message. Unlike write, the message is neither printed on the console 
+             * nor written to the local log file. Usually, this function is used via the CPM_LOG_BINARY macro.
+             * Supported argument types: integers, enums, floating point values, C-strings, std::string and pointers.
+             * \param format_id ID returned by register_binary_format
+             * \param message_log_level Determines the relevance of the message, see write
+             * \param args Parameters for the format string
+             */
+            template<class ...Args> void write_binary(uint32_t format_id, unsigned short message_log_level, Args&& ...args) {
+                //Only log the message if the log_level of the message is <= the current level - else, it is not relevant enough
+                if (message_log_level > log_level.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+
+                BinaryLogBuffer& buffer = get_thread_binary_buffer();
+                uint64_t time_now = get_time();
+
+                //The mutex is only contended while the flush thread swaps the buffer
+                std::lock_guard<std::mutex> lock(buffer.mutex);
+
+                //Publishing is left to the flush thread, only wake it up (once until it flushed)
+                if (buffer.records.size() >= BINARY_FLUSH_SIZE && !binary_flush_requested.exchange(true))
+                {
+                    binary_flush_cv.notify_all();
+                }
+
+                size_t old_size = buffer.records.size();
+                binary_log::encode_record(buffer.records, format_id, static_cast<uint8_t>(message_log_level), time_now, std::forward<Args>(args)...);
+
+                //Records that do not fit into a single batch are dropped (huge string arguments, or the flush thread did not catch up)
+                if (buffer.records.size() > BINARY_MAX_BATCH_SIZE)
+                {
+                    buffer.records.resize(old_size);
+                    binary_records_dropped.fetch_add(1);
+                }
+            }
+
+            /**
+             * \brief Publish all binary log records that are currently buffered, e.g. before the program is shut down
+             */
+            void flush_binary();
     };
 }
\ No newline at end of file
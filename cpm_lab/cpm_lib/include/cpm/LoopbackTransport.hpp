@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace cpm
+{
+    /**
+     * \class LoopbackTransport
+     * \brief In-process replacement for DDS, e.g. for component tests that should neither wait for discovery nor
+     * interfere with other processes on the same machine. If enabled, cpm::Writer, cpm::Reader, cpm::ReaderAbstract, cpm::AsyncReader
+     * and cpm::MultiVehicleReader that are created afterwards do not create DDS entities, but exchange their samples
+     * through shared in-memory queues (see LoopbackTopic). Readers and writers created before keep using DDS.
+     *
+     * The QoS semantics are the same as with DDS: Writers and readers only match if the writer is reliable or the reader is best effort,
+     * and if the writer is transient local or the reader is not. Transient local writers keep their samples (all or the last one per instance),
+     * which late-joining transient local readers receive. Keep-last readers only keep the newest samples per instance.
+     * Instances are distinguished by vehicle_id or name, if the type has one of these members (which are the keys of the cpm IDL types).
+     * Samples are delivered synchronously within write(): Queued for readers, and passed to the callback of an AsyncReader
+     * (but never concurrently for one reader: if its callback is currently running, e.g. because it wrote to its own topic,
+     * the sample is passed to it as soon as the running callback returns). Content filters are only supported for VehicleIDFilteredTopic.
+     *
+     * Topics are separated by DDS domain: Readers and writers of ParticipantSingleton use the domain of the cpm configuration
+     * (see cpm::init), others the domain of their participant.
+     * \ingroup cpmlib
+     */
+    class LoopbackTransport
+    {
+    private:
+        //! If readers and writers created from now on use the loopback transport
+        static std::atomic_bool enabled;
+
+    public:
+        LoopbackTransport() = delete;
+
+        /**
+         * \brief Readers and writers created from now on use the loopback transport
+         */
+        static void enable();
+
+        /**
+         * \brief Readers and writers created from now on use DDS again
+         */
+        static void disable();
+
+        /**
+         * \brief True if readers and writers created now use the loopback transport
+         */
+        static bool is_enabled();
+
+        /**
+         * \brief Key of a loopback topic within the domain of ParticipantSingleton
+         * \param topic_name Name of the topic
+         */
+        static std::string topic_key(const std::string& topic_name);
+
+        /**
+         * \brief Key of a loopback topic
+         * \param domain_id DDS domain of the participant
+         * \param topic_name Name of the topic
+         */
+        static std::string topic_key(int domain_id, const std::string& topic_name);
+
+        /**
+         * \brief Parse the filter expression of a VehicleIDFilteredTopic
+         * \param expression Filter expression
+         * \param vehicle_id_out Returns the vehicle ID of the filter
+         * \return False if the expression has a different format
+         */
+        static bool parse_vehicle_id_filter(const std::string& expression, uint8_t& vehicle_id_out);
+    };
+
+    /**
+     * \brief Helpers to get the instance key of a sample, see LoopbackTransport
+     */
+    namespace loopback_detail
+    {
+        //! Preferred overload
+        struct prefer_vehicle_id {};
+        //! Second overload
+        struct prefer_name : prefer_vehicle_id {};
+
+        //! Instance key of types with a vehicle ID
+        template<typename T>
+        auto instance_key(const T& sample, prefer_name) -> decltype(sample.vehicle_id(), std::string())
+        {
+            return std::to_string(static_cast<int>(sample.vehicle_id()));
+        }
+
+        //! Instance key of types with a name
+        template<typename T>
+        auto instance_key(const T& sample, prefer_vehicle_id) -> decltype(std::string(sample.name()))
+        {
+            return std::string(sample.name());
+        }
+
+        //! Types without a vehicle ID or name only have a single instance
+        template<typename T>
+        std::string instance_key(const T&, ...)
+        {
+            return std::string();
+        }
+
+        /**
+         * \brief Instance key of a sample: vehicle ID, name or none
+         */
+        template<typename T>
+        std::string get_instance_key(const T& sample)
+        {
+            return instance_key(sample, prefer_name());
+        }
+
+        /**
+         * \brief Append a sample to a history that only keeps the newest samples per instance
+         * \param history The history, (instance key, sample)
+         * \param sample The sample
+         * \param depth Max. number of samples per instance, 0 to keep all samples
+         */
+        template<typename T>
+        void keep_last(std::deque<std::pair<std::string, T>>& history, const T& sample, size_t depth)
+        {
+            std::string key = get_instance_key(sample);
+            history.push_back(std::make_pair(key, sample));
+            if (depth == 0) return;
+
+            size_t count = 0;
+            for (auto& entry : history)
+            {
+                if (entry.first == key) ++count;
+            }
+            for (auto it = history.begin(); count > depth && it != history.end();)
+            {
+                if (it->first == key)
+                {
+                    it = history.erase(it);
+                    --count;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    /**
+     * \class LoopbackSubscription
+     * \brief Reader side of a LoopbackTopic: Queues the received samples until they are taken, or passes them to a callback
+     * \ingroup cpmlib
+     */
+    template<typename T>
+    class LoopbackSubscription
+    {
+    private:
+        //! QoS: Reliable or best effort
+        const bool reliable;
+        //! QoS: Transient local or volatile
+        const bool transient_local;
+        //! QoS: Max. number of queued samples per instance, 0 for keep all
+        const size_t history_depth;
+        //! Only samples for which the filter returns true are received, if set
+        std::function<bool(const T&)> filter;
+        //! If set, received samples are passed to the callback instead of being queued until take()
+        std::function<void(std::vector<T>&)> callback;
+
+        //! For all members below
+        std::mutex queue_mutex;
+        //! Notified when a thread stops passing samples to the callback
+        std::condition_variable drain_condition;
+        //! Received samples, (instance key, sample)
+        std::deque<std::pair<std::string, T>> queue;
+        //! If a thread is currently passing samples to the callback
+        bool draining = false;
+        //! The thread that is passing samples to the callback
+        std::thread::id drain_thread;
+        //! If true, no samples are received anymore
+        bool closed = false;
+
+    public:
+        LoopbackSubscription(const LoopbackSubscription&) = delete;
+        LoopbackSubscription& operator=(const LoopbackSubscription&) = delete;
+
+        /**
+         * \brief Constructor
+         * \param _reliable QoS: Reliable or best effort
+         * \param _transient_local QoS: Transient local or volatile
+         * \param _history_depth QoS: Max. number of queued samples per instance, 0 for keep all
+         * \param _filter Optional content filter
+         * \param _callback Optional callback, see AsyncReader
+         */
+        LoopbackSubscription(
+            bool _reliable,
+            bool _transient_local,
+            size_t _history_depth,
+            std::function<bool(const T&)> _filter = nullptr,
+            std::function<void(std::vector<T>&)> _callback = nullptr
+        )
+        :reliable(_reliable)
+        ,transient_local(_transient_local)
+        ,history_depth(_history_depth)
+        ,filter(_filter)
+        ,callback(_callback)
+        {
+        }
+
+        //! QoS: Reliable or best effort
+        bool is_reliable() const { return reliable; }
+        //! QoS: Transient local or volatile
+        bool is_transient_local() const { return transient_local; }
+
+        /**
+         * \brief Receive samples (called by LoopbackTopic)
+         * \param samples The samples, in the order in which they were written
+         */
+        void deliver(const std::vector<T>& samples)
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (closed) return;
+
+            for (auto& sample : samples)
+            {
+                if (!filter || filter(sample))
+                {
+                    loopback_detail::keep_last(queue, sample, history_depth);
+                }
+            }
+
+            if (!callback || draining) return;
+
+            //Pass the samples to the callback until no new samples arrive during the callback
+            draining = true;
+            drain_thread = std::this_thread::get_id();
+            while (!queue.empty() && !closed)
+            {
+                std::vector<T> batch;
+                for (auto& entry : queue)
+                {
+                    batch.push_back(entry.second);
+                }
+                queue.clear();
+
+                lock.unlock();
+                callback(batch);
+                lock.lock();
+            }
+            draining = false;
+            drain_condition.notify_all();
+        }
+
+        /**
+         * \brief Get and remove all queued samples
+         */
+        std::vector<T> take()
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            std::vector<T> samples;
+            for (auto& entry : queue)
+            {
+                samples.push_back(entry.second);
+            }
+            queue.clear();
+            return samples;
+        }
+
+        /**
+         * \brief Stop receiving samples; waits until a running callback returns (unless it is called from within the callback)
+         */
+        void close()
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            closed = true;
+            queue.clear();
+            if (draining && drain_thread != std::this_thread::get_id())
+            {
+                drain_condition.wait(lock, [&](){ return !draining; });
+            }
+        }
+    };
+
+    /**
+     * \class LoopbackTopic
+     * \brief Topic of the LoopbackTransport: Connects the writers and subscriptions with the same topic key and type
+     * \ingroup cpmlib
+     */
+    template<typename T>
+    class LoopbackTopic
+    {
+    private:
+        /**
+         * \brief Writer side of the topic
+         */
+        struct WriterEndpoint
+        {
+            //! QoS: Reliable or best effort
+            bool reliable = false;
+            //! QoS: Keep all or keep the last sample per instance (only relevant for transient local)
+            bool keep_all = false;
+            //! QoS: Transient local or volatile
+            bool transient_local = false;
+            //! Samples kept for late-joining transient local subscriptions, (instance key, sample)
+            std::deque<std::pair<std::string, T>> cache;
+        };
+
+        //! For all members below
+        std::mutex topic_mutex;
+        //! Writers by ID
+        std::map<uint64_t, WriterEndpoint> writers;
+        //! ID of the next writer
+        uint64_t next_writer_id = 1;
+        //! Subscriptions, which are owned by the readers
+        std::vector<std::weak_ptr<LoopbackSubscription<T>>> subscriptions;
+
+        /**
+         * \brief If a writer and a subscription match regarding their QoS (same rules as for DDS)
+         */
+        static bool matches(const WriterEndpoint& writer, const LoopbackSubscription<T>& subscription)
+        {
+            return (writer.reliable || !subscription.is_reliable())
+                && (writer.transient_local || !subscription.is_transient_local());
+        }
+
+        /**
+         * \brief Remove subscriptions of destroyed readers; requires topic_mutex to be locked
+         */
+        void remove_expired_subscriptions()
+        {
+            subscriptions.erase(
+                std::remove_if(subscriptions.begin(), subscriptions.end(), [] (const std::weak_ptr<LoopbackSubscription<T>>& subscription) {
+                    return subscription.expired();
+                }),
+                subscriptions.end()
+            );
+        }
+
+    public:
+        /**
+         * \brief Get (or create) the topic for a key (see LoopbackTransport::topic_key)
+         * \param key Key of the topic
+         */
+        static std::shared_ptr<LoopbackTopic<T>> get(const std::string& key)
+        {
+            static std::mutex registry_mutex;
+            static std::map<std::string, std::shared_ptr<LoopbackTopic<T>>> registry;
+
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            auto& topic = registry[key];
+            if (!topic)
+            {
+                topic = std::make_shared<LoopbackTopic<T>>();
+            }
+            return topic;
+        }
+
+        /**
+         * \brief Add a writer
+         * \param reliable QoS: Reliable or best effort
+         * \param keep_all QoS: Keep all or only the last sample per instance (for late-joining transient local subscriptions)
+         * \param transient_local QoS: Transient local or volatile
+         * \return ID of the writer
+         */
+        uint64_t add_writer(bool reliable, bool keep_all, bool transient_local)
+        {
+            std::lock_guard<std::mutex> lock(topic_mutex);
+            WriterEndpoint writer;
+            writer.reliable = reliable;
+            writer.keep_all = keep_all;
+            writer.transient_local = transient_local;
+            writers[next_writer_id] = writer;
+            return next_writer_id++;
+        }
+
+        /**
+         * \brief Remove a writer, its samples are no longer available for late-joining subscriptions
+         * \param writer_id ID of the writer
+         */
+        void remove_writer(uint64_t writer_id)
+        {
+            std::lock_guard<std::mutex> lock(topic_mutex);
+            writers.erase(writer_id);
+        }
+
+        /**
+         * \brief Write a sample, which is delivered to all matching subscriptions before this function returns
+         * (unless a subscription's callback is currently running in another thread)
+         * \param writer_id ID of the writer
+         * \param sample The sample
+         */
+        void write(uint64_t writer_id, const T& sample)
+        {
+            std::vector<std::shared_ptr<LoopbackSubscription<T>>> receivers;
+            {
+                std::lock_guard<std::mutex> lock(topic_mutex);
+                auto writer = writers.find(writer_id);
+                if (writer == writers.end()) return;
+
+                if (writer->second.transient_local)
+                {
+                    loopback_detail::keep_last(writer->second.cache, sample, writer->second.keep_all ? 0 : 1);
+                }
+
+                remove_expired_subscriptions();
+                for (auto& weak_subscription : subscriptions)
+                {
+                    auto subscription = weak_subscription.lock();
+                    if (subscription && matches(writer->second, *subscription))
+                    {
+                        receivers.push_back(subscription);
+                    }
+                }
+            }
+
+            //Deliver outside of the lock, s.t. callbacks can write to the same topic
+            std::vector<T> samples { sample };
+            for (auto& subscription : receivers)
+            {
+                subscription->deliver(samples);
+            }
+        }
+
+        /**
+         * \brief Add a subscription; transient local subscriptions receive the cached samples of matching writers
+         * \param subscription The subscription, which is only referenced weakly
+         */
+        void add_subscription(std::shared_ptr<LoopbackSubscription<T>> subscription)
+        {
+            std::vector<T> cached_samples;
+            {
+                std::lock_guard<std::mutex> lock(topic_mutex);
+                remove_expired_subscriptions();
+                subscriptions.push_back(subscription);
+
+                if (subscription->is_transient_local())
+                {
+                    for (auto& writer : writers)
+                    {
+                        if (!matches(writer.second, *subscription)) continue;
+                        for (auto& entry : writer.second.cache)
+                        {
+                            cached_samples.push_back(entry.second);
+                        }
+                    }
+                }
+            }
+
+            if (cached_samples.size() > 0)
+            {
+                subscription->deliver(cached_samples);
+            }
+        }
+
+        /**
+         * \brief Number of subscriptions that match a writer
+         * \param writer_id ID of the writer
+         */
+        size_t matched_subscriptions(uint64_t writer_id)
+        {
+            std::lock_guard<std::mutex> lock(topic_mutex);
+            auto writer = writers.find(writer_id);
+            if (writer == writers.end()) return 0;
+
+            size_t count = 0;
+            for (auto& weak_subscription : subscriptions)
+            {
+                auto subscription = weak_subscription.lock();
+                if (subscription && matches(writer->second, *subscription)) ++count;
+            }
+            return count;
+        }
+
+        /**
+         * \brief Number of writers that match a subscription
+         * \param subscription The subscription
+         */
+        size_t matched_publications(const LoopbackSubscription<T>& subscription)
+        {
+            std::lock_guard<std::mutex> lock(topic_mutex);
+            size_t count = 0;
+            for (auto& writer : writers)
+            {
+                if (matches(writer.second, subscription)) ++count;
+            }
+            return count;
+        }
+    };
+}
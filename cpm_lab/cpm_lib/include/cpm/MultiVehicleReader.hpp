@@ -6,9 +6,13 @@
 #include <array>
 #include <vector>
 #include <map>
+#include <memory>
 #include <algorithm>
 
 #include "cpm/ParticipantSingleton.hpp"
+#include "cpm/get_topic.hpp"
+#include "cpm/SampleHistory.hpp"
+#include "cpm/LoopbackTransport.hpp"
 
 #define CPM_READER_RING_BUFFER_SIZE (64)
 
@@ -18,20 +22,69 @@ namespace cpm
      * \brief Class MultiVehicleReader
      * Use this to get a reader for multiple vehicles that works like "Reader", but checks timestamps in the header for all of the vehicles separately
      * This reader always acts in the domain of ParticipantSingleton
+     * 
+     * Received samples are stored as reference-counted immutable handles. get_sample_handles returns these handles, s.t. 
+     * all consumers share one copy of a sample until a newer one arrives, while get_samples returns copies.
      * \ingroup cpmlib
      */
     template<typename T>
     class MultiVehicleReader
     {
     private:
-        //! Internal DDS Reader for reading vehicle data
+        //! Internal DDS Reader for reading vehicle data, null if the loopback transport is used
         dds::sub::DataReader<T> dds_reader;
+        //! Used instead of dds_reader if the LoopbackTransport was enabled when the reader was created
+        std::shared_ptr<LoopbackTopic<T>> loopback_topic;
+        //! Subscription of this reader in loopback_topic (shared by copies of the reader, like dds_reader)
+        std::shared_ptr<LoopbackSubscription<T>> loopback_subscription;
         //! Internal mutex for get_samples and copy constructor
         std::mutex m_mutex;
         //! Used as buffer to store vehicle data for each vehicle seperately, gets filled in flush_dds_reader and (partially) cleared in get_samples
-        std::vector<std::vector<T>> vehicle_buffers;
+        std::vector<std::vector<std::shared_ptr<const T>>> vehicle_buffers;
         //! Vehicle IDs to listen for
         std::vector<uint8_t> vehicle_ids;
+        //! Time-sorted history of the received samples for each vehicle (same order as vehicle_ids) for sample_at and interpolate, disabled by default
+        std::vector<SampleHistory<T>> vehicle_histories;
+        //! Returned for vehicles without a valid sample (create stamp of 0, otherwise empty), shared by all of them
+        std::shared_ptr<const T> empty_sample;
+
+        /**
+         * \brief Create the shared empty sample
+         */
+        static std::shared_ptr<const T> create_empty_sample()
+        {
+            auto sample = std::make_shared<T>();
+            sample->header().create_stamp().nanoseconds(0);
+            return sample;
+        }
+
+        /**
+         * \brief Get the history of a vehicle
+         * \param vehicle_id ID of the vehicle
+         * \return The history, or nullptr if the reader does not listen for the vehicle
+         */
+        SampleHistory<T>* get_history(uint8_t vehicle_id)
+        {
+            auto it = std::find(vehicle_ids.begin(), vehicle_ids.end(), vehicle_id);
+            if (it == vehicle_ids.end()) return nullptr;
+            return &(vehicle_histories.at(std::distance(vehicle_ids.begin(), it)));
+        }
+
+        /**
+         * \brief Store a received sample in the buffer and history of its vehicle, if the reader listens for the vehicle
+         * \param sample The sample
+         */
+        void store_sample(const T& sample)
+        {
+            uint8_t vehicle = sample.vehicle_id();
+            long pos = std::distance(vehicle_ids.begin(), std::find(vehicle_ids.begin(), vehicle_ids.end(), vehicle));
+
+            if (pos < static_cast<long>(vehicle_ids.size()) && pos >= 0) {
+                //This is the only copy of the sample, later on only the handle gets copied
+                vehicle_buffers.at(pos).push_back(std::make_shared<const T>(sample));
+                vehicle_histories.at(pos).insert(sample);
+            }
+        }
 
         /**
          * \brief Function to go through all samples received since the last call of get_samples.
@@ -39,6 +92,15 @@ namespace cpm
          */
         void flush_dds_reader()
         {
+            if (loopback_subscription)
+            {
+                for (auto& sample : loopback_subscription->take())
+                {
+                    store_sample(sample);
+                }
+                return;
+            }
+
             auto num_samples = dds_reader->datareader_cache_status().sample_count();
             auto read_samples = 0;
 
@@ -52,30 +114,45 @@ namespace cpm
                 {
                     if(sample.info().valid()) 
                     {
-                        uint8_t vehicle = sample.data().vehicle_id();
-                        long pos = std::distance(vehicle_ids.begin(), std::find(vehicle_ids.begin(), vehicle_ids.end(), vehicle));
-
-                        if (pos < static_cast<long>(vehicle_ids.size()) && pos >= 0) {
-                            vehicle_buffers.at(pos).push_back(sample.data());
-                        }
+                        store_sample(sample.data());
                     }
                 }
             }
         }
 
+        /**
+         * \brief Subscribe to the loopback topic, if the loopback transport is enabled; same QoS as the DDS reader (best effort, volatile, keep last 2000)
+         * \param key Key of the topic, see LoopbackTransport::topic_key
+         */
+        void create_loopback_subscription(std::string key)
+        {
+            if (!LoopbackTransport::is_enabled()) return;
+
+            loopback_topic = LoopbackTopic<T>::get(key);
+            loopback_subscription = std::make_shared<LoopbackSubscription<T>>(false, false, 2000);
+            loopback_topic->add_subscription(loopback_subscription);
+        }
+
     public:
         /**
          * \brief Constructor
          * \param topic the topic of the communication
          * \param num_of_vehicles The number of vehicles to monitor / read from (from 1 to num_vehicles)
+         * \param history_size Number of samples per vehicle kept for sample_at and interpolate, 0 (default) to disable them
          * \return The MultiVehicleReader, which only keeps the last 2000 msgs for better efficiency (might need to be tweaked)
          */
-        MultiVehicleReader(dds::topic::Topic<T> topic, int num_of_vehicles) : 
-            dds_reader(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic, (dds::sub::qos::DataReaderQos() << dds::core::policy::History(dds::core::policy::HistoryKind::KEEP_LAST, 2000))
-        )
+        MultiVehicleReader(dds::topic::Topic<T> topic, int num_of_vehicles, size_t history_size = 0) : 
+            dds_reader(LoopbackTransport::is_enabled() ?
+                dds::sub::DataReader<T>(dds::core::null) :
+                dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic, (dds::sub::qos::DataReaderQos() << dds::core::policy::History(dds::core::policy::HistoryKind::KEEP_LAST, 2000)))
+            ),
+            empty_sample(create_empty_sample())
         { 
+            create_loopback_subscription(LoopbackTransport::topic_key(topic.participant().domain_id(), topic.name()));
+
             //Set size for buffers
             vehicle_buffers.resize(num_of_vehicles);
+            vehicle_histories.resize(num_of_vehicles, SampleHistory<T>(history_size));
 
             //Also: Create vehicle id list from 1 to num_of_vehicles
             for (long pos = 0; pos < static_cast<long>(num_of_vehicles); ++pos) {
@@ -87,15 +164,74 @@ namespace cpm
          * \brief Constructor
          * \param topic the topic of the communication
          * \param _vehicle_ids List of vehicles to monitor / read from
+         * \param history_size Number of samples per vehicle kept for sample_at and interpolate, 0 (default) to disable them
          * \return The MultiVehicleReader, which only keeps the last 2000 msgs for better efficiency (might need to be tweaked)
          */
-        MultiVehicleReader(dds::topic::Topic<T> topic, std::vector<uint8_t> _vehicle_ids) : 
-            dds_reader(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic, (dds::sub::qos::DataReaderQos() << dds::core::policy::History(dds::core::policy::HistoryKind::KEEP_LAST, 2000))
-        )
+        MultiVehicleReader(dds::topic::Topic<T> topic, std::vector<uint8_t> _vehicle_ids, size_t history_size = 0) : 
+            dds_reader(LoopbackTransport::is_enabled() ?
+                dds::sub::DataReader<T>(dds::core::null) :
+                dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic, (dds::sub::qos::DataReaderQos() << dds::core::policy::History(dds::core::policy::HistoryKind::KEEP_LAST, 2000)))
+            ),
+            empty_sample(create_empty_sample())
+        {             
+            create_loopback_subscription(LoopbackTransport::topic_key(topic.participant().domain_id(), topic.name()));
+
+            //Set size for buffers
+            int num_of_vehicles = _vehicle_ids.size();
+            vehicle_buffers.resize(num_of_vehicles);
+            vehicle_histories.resize(num_of_vehicles, SampleHistory<T>(history_size));
+
+            vehicle_ids = _vehicle_ids;
+        }
+
+        /**
+         * \brief Constructor using a topic name in the domain of ParticipantSingleton.
+         * If the LoopbackTransport is enabled, no DDS entities (and no participant) are created, unlike when the topic is passed.
+         * \param topic_name the name of the topic of the communication
+         * \param num_of_vehicles The number of vehicles to monitor / read from (from 1 to num_vehicles)
+         * \param history_size Number of samples per vehicle kept for sample_at and interpolate, 0 (default) to disable them
+         * \return The MultiVehicleReader, which only keeps the last 2000 msgs for better efficiency (might need to be tweaked)
+         */
+        MultiVehicleReader(std::string topic_name, int num_of_vehicles, size_t history_size = 0) : 
+            dds_reader(LoopbackTransport::is_enabled() ?
+                dds::sub::DataReader<T>(dds::core::null) :
+                dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic_name), (dds::sub::qos::DataReaderQos() << dds::core::policy::History(dds::core::policy::HistoryKind::KEEP_LAST, 2000)))
+            ),
+            empty_sample(create_empty_sample())
+        { 
+            create_loopback_subscription(LoopbackTransport::topic_key(topic_name));
+
+            //Set size for buffers
+            vehicle_buffers.resize(num_of_vehicles);
+            vehicle_histories.resize(num_of_vehicles, SampleHistory<T>(history_size));
+
+            //Also: Create vehicle id list from 1 to num_of_vehicles
+            for (long pos = 0; pos < static_cast<long>(num_of_vehicles); ++pos) {
+                vehicle_ids.push_back(pos + 1);
+            }
+        }
+
+        /**
+         * \brief Constructor using a topic name in the domain of ParticipantSingleton.
+         * If the LoopbackTransport is enabled, no DDS entities (and no participant) are created, unlike when the topic is passed.
+         * \param topic_name the name of the topic of the communication
+         * \param _vehicle_ids List of vehicles to monitor / read from
+         * \param history_size Number of samples per vehicle kept for sample_at and interpolate, 0 (default) to disable them
+         * \return The MultiVehicleReader, which only keeps the last 2000 msgs for better efficiency (might need to be tweaked)
+         */
+        MultiVehicleReader(std::string topic_name, std::vector<uint8_t> _vehicle_ids, size_t history_size = 0) : 
+            dds_reader(LoopbackTransport::is_enabled() ?
+                dds::sub::DataReader<T>(dds::core::null) :
+                dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic_name), (dds::sub::qos::DataReaderQos() << dds::core::policy::History(dds::core::policy::HistoryKind::KEEP_LAST, 2000)))
+            ),
+            empty_sample(create_empty_sample())
         {             
+            create_loopback_subscription(LoopbackTransport::topic_key(topic_name));
+
             //Set size for buffers
             int num_of_vehicles = _vehicle_ids.size();
             vehicle_buffers.resize(num_of_vehicles);
+            vehicle_histories.resize(num_of_vehicles, SampleHistory<T>(history_size));
 
             vehicle_ids = _vehicle_ids;
         }
@@ -109,8 +245,12 @@ namespace cpm
             std::lock_guard<std::mutex> lock(m_mutex);
 
             dds_reader = other.dds_reader;
+            loopback_topic = other.loopback_topic;
+            loopback_subscription = other.loopback_subscription;
             vehicle_buffers = other.vehicle_buffers;
             vehicle_ids = other.vehicle_ids;
+            vehicle_histories = other.vehicle_histories;
+            empty_sample = other.empty_sample;
         }
         
         /**
@@ -126,6 +266,30 @@ namespace cpm
             std::map<uint8_t, T>& sample_out, 
             std::map<uint8_t, uint64_t>& sample_age_out
         )
+        {
+            std::map<uint8_t, std::shared_ptr<const T>> handles;
+            get_sample_handles(t_now, handles, sample_age_out);
+
+            sample_out.clear();
+            for (auto& entry : handles)
+            {
+                sample_out[entry.first] = *(entry.second);
+            }
+        }
+
+        /**
+         * \brief Like get_samples, but returns handles to the samples instead of copies. The handles are never null and the samples
+         * must not be modified (copy them if necessary). A handle stays valid as long as it is held, even if newer samples are received.
+         * If a returned sample has a create stamp of 0, a sample age of t_now and is otherwise empty, no sample could be found for that vehicle
+         * \param t_now Current time in ns since epoch
+         * \param sample_out Map of sample handles, with vehicle_id -> message / content
+         * \param sample_age_out Map of sample ages, with vehicle_id -> age of message
+         */
+        void get_sample_handles(
+            const uint64_t t_now, 
+            std::map<uint8_t, std::shared_ptr<const T>>& sample_out, 
+            std::map<uint8_t, uint64_t>& sample_age_out
+        )
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             flush_dds_reader();
@@ -134,29 +298,29 @@ namespace cpm
             sample_age_out.clear();
 
             for (long i = 0; i < static_cast<long>(vehicle_ids.size()); ++i) {
-                T sample = T();
-                sample.header().create_stamp().nanoseconds(0);
-                sample_out[vehicle_ids.at(i)] = sample;
+                sample_out[vehicle_ids.at(i)] = empty_sample;
                 sample_age_out[vehicle_ids.at(i)] = t_now;
             }
 
             // select samples
             for (long pos = 0; pos < static_cast<long>(vehicle_ids.size()); ++pos) {
+                auto& newest_sample = sample_out[vehicle_ids.at(pos)];
+
                 for (auto& current_sample : vehicle_buffers.at(pos))
                 {
-                    if(current_sample.header().valid_after_stamp().nanoseconds() > t_now) 
+                    if(current_sample->header().valid_after_stamp().nanoseconds() > t_now) 
                     {
                         // Data is "in the future", ignore for now
                         continue;
                     }
 
-                    if(sample_out[vehicle_ids.at(pos)].header().create_stamp().nanoseconds() 
-                                     <= current_sample.header().create_stamp().nanoseconds())
+                    if(newest_sample->header().create_stamp().nanoseconds() 
+                                     <= current_sample->header().create_stamp().nanoseconds())
                     {
                         // Current sample has a higher timestamp, it is newer. Use it.
-                        sample_out[vehicle_ids.at(pos)] = current_sample;
+                        newest_sample = current_sample;
                         sample_age_out[vehicle_ids.at(pos)] = 
-                            t_now - current_sample.header().valid_after_stamp().nanoseconds();
+                            t_now - current_sample->header().valid_after_stamp().nanoseconds();
                     }
                 }
             }
@@ -166,25 +330,54 @@ namespace cpm
             //Delete all messages that are older than the currently newest sample
             //Take a look at the create_stamp only for this
             //We do this because we do not need these messages anymore, and as they take up space
+            //(Handles that were returned before stay valid, the samples are only freed when the last handle is gone)
             for (long pos = 0; pos < static_cast<long>(vehicle_ids.size()); ++pos) {
-                auto it = vehicle_buffers.at(pos).begin();
-                while (it != vehicle_buffers.at(pos).end())
-                {
-                    auto& msg = *it;
-                    //Remove the sample only if the currently newest sample is newer regarding its creation
-                    if (msg.header().create_stamp().nanoseconds() < sample_out[vehicle_ids.at(pos)].header().create_stamp().nanoseconds())
-                    {
-                        //Remove the msg, get a new iterator to the next position to proceed
-                        it = vehicle_buffers.at(pos).erase(it);
-                    }
-                    else
-                    {
-                        //Get the iterator to the next position / proceed to check the age of the next element
-                        ++it;
-                    }
-                }
+                const uint64_t newest_create_stamp = sample_out[vehicle_ids.at(pos)]->header().create_stamp().nanoseconds();
+                auto& buffer = vehicle_buffers.at(pos);
+
+                //Remove the sample only if the currently newest sample is newer regarding its creation
+                buffer.erase(
+                    std::remove_if(buffer.begin(), buffer.end(), [newest_create_stamp] (const std::shared_ptr<const T>& msg) {
+                        return msg->header().create_stamp().nanoseconds() < newest_create_stamp;
+                    }),
+                    buffer.end()
+                );
             }
         }
+
+        /**
+         * \brief Get the sample of a vehicle that was valid at time t, i.e. the newest received sample with a create stamp not after t,
+         * regardless of its valid_after_stamp. Requires a history_size > 0 (see constructor); takes O(log history_size).
+         * \param vehicle_id ID of the vehicle
+         * \param t Time in ns since epoch
+         * \param sample_out Returns the sample, if one exists
+         * \return False if there is no such sample in the history or the reader does not listen for the vehicle
+         */
+        bool sample_at(const uint8_t vehicle_id, const uint64_t t, T& sample_out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            flush_dds_reader();
+
+            auto history = get_history(vehicle_id);
+            return history && history->sample_at(t, sample_out);
+        }
+
+        /**
+         * \brief Get the state of a vehicle at time t, interpolated between the received samples before and after t, for types with a pose
+         * (see SampleInterpolation). Requires a history_size > 0 (see constructor); takes O(log history_size).
+         * \param vehicle_id ID of the vehicle
+         * \param t Time in ns since epoch
+         * \param sample_out Returns the interpolated sample, with t as create stamp
+         * \return False if t is not within the time range of the history (no extrapolation) or the reader does not listen for the vehicle
+         */
+        bool interpolate(const uint8_t vehicle_id, const uint64_t t, T& sample_out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            flush_dds_reader();
+
+            auto history = get_history(vehicle_id);
+            return history && history->interpolate(t, sample_out);
+        }
     };
 
 }
\ No newline at end of file
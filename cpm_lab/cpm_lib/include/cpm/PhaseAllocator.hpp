@@ -0,0 +1,119 @@
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace cpm
+{
+    /**
+     * \class PhaseAllocator
+     * \brief Assigns timer offsets (phases) to the periodic nodes of a machine, s.t. they do not all wake up at the same
+     * instant of each period and compete for the CPU and the network.
+     * Each node announces its period, its expected computation time per period and its stage in the processing pipeline
+     * (vehicle -> middleware -> HLC). The stage restricts the offset to a window of the period, which keeps the pipeline order;
+     * within the window, the offset with the lowest load of the already registered nodes is chosen.
+     *
+     * The registered nodes are stored in a table in POSIX shared memory that is shared by all processes on the machine and protected
+     * by a robust process-shared mutex. Entries of processes that are not running anymore are ignored and reused.
+     * If the table cannot be used, the offset is computed as if no other node was registered.
+     * Does not depend on DDS, s.t. it can be tested on its own.
+     * \ingroup cpmlib
+     */
+    class PhaseAllocator
+    {
+    public:
+        /**
+         * \enum Stage
+         * \brief Stage of a node in the processing pipeline, determines the window of the period its offset is chosen from
+         */
+        enum Stage : uint32_t {
+            //! Vehicles and simulated vehicles, first third of the period
+            StageVehicle = 0,
+            //! Middleware, second third of the period (after the vehicles have sent their state)
+            StageMiddleware = 1,
+            //! Timers of HLCs, last third of the period (after the middleware has sent the states)
+            StageHLC = 2,
+            //! Nodes outside of the pipeline, e.g. tasks of the LCC; whole period
+            StageAny = 3
+        };
+
+        /**
+         * \struct Node
+         * \brief Timing of a registered node, see compute_offset
+         */
+        struct Node {
+            //! Period of the node in ns
+            uint64_t period_ns;
+            //! Expected computation time per period in ns
+            uint64_t compute_ns;
+            //! Offset of the node in ns
+            uint64_t offset_ns;
+        };
+
+        /**
+         * \class Allocation
+         * \brief Offset allocated to a node, the node is registered as long as the allocation exists
+         */
+        class Allocation
+        {
+            //! Allocated offset in ns
+            uint64_t offset_ns;
+            //! Name of the shared memory table, empty if the node is not registered in a table
+            std::string table_name;
+            //! Position of the entry in the table
+            size_t entry_index;
+            //! Identifies the entry, s.t. an entry that was reused by another node is not released
+            uint64_t entry_token;
+
+        public:
+            Allocation(const Allocation&) = delete;
+            Allocation& operator=(const Allocation&) = delete;
+
+            /**
+             * \brief Constructor, use PhaseAllocator::allocate instead
+             * \param _offset_ns Allocated offset in ns
+             * \param _table_name Name of the shared memory table, empty if the node is not registered
+             * \param _entry_index Position of the entry in the table
+             * \param _entry_token Identifies the entry
+             */
+            Allocation(uint64_t _offset_ns, std::string _table_name, size_t _entry_index, uint64_t _entry_token);
+
+            /**
+             * \brief Destructor, removes the node from the table
+             */
+            ~Allocation();
+
+            /**
+             * \brief The allocated offset in ns, to be used as offset of a cpm::Timer
+             */
+            uint64_t get_offset();
+        };
+
+        //! Default name of the shared memory table of the machine
+        static const std::string DEFAULT_TABLE_NAME;
+
+        /**
+         * \brief Compute the offset for a new node, given the nodes that are already registered
+         * \param period_ns Period of the new node in ns
+         * \param compute_ns Expected computation time of the new node per period in ns
+         * \param stage Stage of the new node in the pipeline
+         * \param nodes The registered nodes. The load of nodes with a different period is projected onto the period of the new node
+         * (exact if one period is a multiple of the other).
+         * \return The offset in ns, smaller than the period
+         */
+        static uint64_t compute_offset(uint64_t period_ns, uint64_t compute_ns, Stage stage, const std::vector<Node>& nodes);
+
+        /**
+         * \brief Register a node in the table of the machine and allocate its offset
+         * \param node_id ID of the node, for debugging purposes
+         * \param period_ns Period of the node in ns
+         * \param compute_ns Expected computation time of the node per period in ns
+         * \param stage Stage of the node in the pipeline
+         * \param table_name Name of the shared memory table, should only be changed for tests
+         * \return The allocation, which must be kept as long as the node uses the offset
+         */
+        static std::shared_ptr<Allocation> allocate(std::string node_id, uint64_t period_ns, uint64_t compute_ns, Stage stage, std::string table_name = DEFAULT_TABLE_NAME);
+    };
+}
@@ -7,6 +7,9 @@
 #include <vector>
 
 #include "cpm/ParticipantSingleton.hpp"
+#include "cpm/get_topic.hpp"
+#include "cpm/LoopbackTransport.hpp"
+#include "cpm/SampleHistory.hpp"
 
 namespace cpm
 {
@@ -34,12 +37,18 @@ namespace cpm
     class Reader
     {
     private:
-        //! Internal DDS Reader to receive messages of type T
+        //! Internal DDS Reader to receive messages of type T, null if the loopback transport is used
         dds::sub::DataReader<T> dds_reader;
+        //! Used instead of dds_reader if the LoopbackTransport was enabled when the reader was created
+        std::shared_ptr<LoopbackTopic<T>> loopback_topic;
+        //! Subscription of this reader in loopback_topic
+        std::shared_ptr<LoopbackSubscription<T>> loopback_subscription;
         //! Mutex for access to get_sample and removing old messages
         std::mutex m_mutex;
         //! Internal buffer that stores flushed messages until they are (partially) removed in get_sample
         std::vector<T> messages_buffer;
+        //! Time-sorted history of the received messages for sample_at and interpolate, disabled by default
+        SampleHistory<T> history;
 
         /**
          * \brief Store all received messages since the last call to get_samples in the data structure
@@ -48,6 +57,16 @@ namespace cpm
          */
         void flush_dds_reader()
         {
+            if (loopback_subscription)
+            {
+                for (auto& sample : loopback_subscription->take())
+                {
+                    messages_buffer.push_back(sample);
+                    history.insert(sample);
+                }
+                return;
+            }
+
             auto samples = dds_reader.take();
 
             //Just store all relevant data
@@ -60,6 +79,7 @@ namespace cpm
                 if(sample.info().valid()) 
                 {
                     messages_buffer.push_back(sample.data());
+                    history.insert(sample.data());
                 }
             }
         }
@@ -131,27 +151,88 @@ namespace cpm
         /**
          * \brief Constructor using a topic to create a Reader
          * \param topic the topic of the communication
+         * \param history_size Number of messages kept for sample_at and interpolate, 0 (default) to disable them
          * \return The DDS Reader
          */
-        Reader(dds::topic::Topic<T> topic)
-        :dds_reader(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic,
-            (dds::sub::qos::DataReaderQos() << dds::core::policy::History::KeepAll())
+        Reader(dds::topic::Topic<T> topic, size_t history_size = 0)
+        :dds_reader(LoopbackTransport::is_enabled() ?
+            dds::sub::DataReader<T>(dds::core::null) :
+            dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic,
+                (dds::sub::qos::DataReaderQos() << dds::core::policy::History::KeepAll())
+            )
         )
+        ,history(history_size)
         { 
             static_assert(std::is_same<decltype(std::declval<T>().header().create_stamp().nanoseconds()), rti::core::uint64>::value, "IDL type must have a Header.");
+
+            if (LoopbackTransport::is_enabled())
+            {
+                //Same QoS as the DDS reader: Best effort, volatile, keep all
+                loopback_topic = LoopbackTopic<T>::get(LoopbackTransport::topic_key(topic.participant().domain_id(), topic.name()));
+                loopback_subscription = std::make_shared<LoopbackSubscription<T>>(false, false, 0);
+                loopback_topic->add_subscription(loopback_subscription);
+            }
+        }
+        
+        /**
+         * \brief Constructor using a topic name to create a Reader in the domain of ParticipantSingleton.
+         * If the LoopbackTransport is enabled, no DDS entities (and no participant) are created, unlike when the topic is passed.
+         * \param topic_name the name of the topic of the communication
+         * \param history_size Number of messages kept for sample_at and interpolate, 0 (default) to disable them
+         * \return The DDS Reader
+         */
+        Reader(std::string topic_name, size_t history_size = 0)
+        :dds_reader(LoopbackTransport::is_enabled() ?
+            dds::sub::DataReader<T>(dds::core::null) :
+            dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic_name),
+                (dds::sub::qos::DataReaderQos() << dds::core::policy::History::KeepAll())
+            )
+        )
+        ,history(history_size)
+        { 
+            static_assert(std::is_same<decltype(std::declval<T>().header().create_stamp().nanoseconds()), rti::core::uint64>::value, "IDL type must have a Header.");
+
+            if (LoopbackTransport::is_enabled())
+            {
+                //Same QoS as the DDS reader: Best effort, volatile, keep all
+                loopback_topic = LoopbackTopic<T>::get(LoopbackTransport::topic_key(topic_name));
+                loopback_subscription = std::make_shared<LoopbackSubscription<T>>(false, false, 0);
+                loopback_topic->add_subscription(loopback_subscription);
+            }
         }
         
         /**
          * \brief Constructor using a filtered topic to create a Reader
          * \param topic the topic of the communication, filtered (e.g. by the vehicle ID)
+         * \param history_size Number of messages kept for sample_at and interpolate, 0 (default) to disable them
          * \return The DDS Reader
          */
-        Reader(dds::topic::ContentFilteredTopic<T> topic)
-        :dds_reader(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic,
-            (dds::sub::qos::DataReaderQos() << dds::core::policy::History::KeepAll())
+        Reader(dds::topic::ContentFilteredTopic<T> topic, size_t history_size = 0)
+        :dds_reader(LoopbackTransport::is_enabled() ?
+            dds::sub::DataReader<T>(dds::core::null) :
+            dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), topic,
+                (dds::sub::qos::DataReaderQos() << dds::core::policy::History::KeepAll())
+            )
         )
+        ,history(history_size)
         { 
             static_assert(std::is_same<decltype(std::declval<T>().header().create_stamp().nanoseconds()), rti::core::uint64>::value, "IDL type must have a Header.");
+
+            if (LoopbackTransport::is_enabled())
+            {
+                //Only the filter of VehicleIDFilteredTopic is supported, other filters are ignored
+                std::function<bool(const T&)> filter;
+                uint8_t vehicle_id = 0;
+                if (LoopbackTransport::parse_vehicle_id_filter(topic.filter_expression(), vehicle_id))
+                {
+                    filter = [vehicle_id] (const T& sample) { return sample.vehicle_id() == vehicle_id; };
+                }
+
+                auto related_topic = topic.topic();
+                loopback_topic = LoopbackTopic<T>::get(LoopbackTransport::topic_key(related_topic.participant().domain_id(), related_topic.name()));
+                loopback_subscription = std::make_shared<LoopbackSubscription<T>>(false, false, 0, filter);
+                loopback_topic->add_subscription(loopback_subscription);
+            }
         }
         
         /**
@@ -177,11 +258,44 @@ namespace cpm
             remove_old_msgs(sample_out);
         }
 
+        /**
+         * \brief Get the message that was valid at time t, i.e. the newest received message with a create stamp not after t,
+         * regardless of its valid_after_stamp. Requires a history_size > 0 (see constructor); takes O(log history_size).
+         * \param t Time in nanoseconds
+         * \param sample_out Returns the message, if one exists
+         * \return False if there is no such message in the history
+         */
+        bool sample_at(const uint64_t t, T& sample_out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            flush_dds_reader();
+            return history.sample_at(t, sample_out);
+        }
+
+        /**
+         * \brief Get the state at time t, interpolated between the received messages before and after t, for types with a pose
+         * (see SampleInterpolation). Requires a history_size > 0 (see constructor); takes O(log history_size).
+         * \param t Time in nanoseconds
+         * \param sample_out Returns the interpolated message, with t as create stamp
+         * \return False if t is not within the time range of the history (no extrapolation)
+         */
+        bool interpolate(const uint64_t t, T& sample_out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            flush_dds_reader();
+            return history.interpolate(t, sample_out);
+        }
+
         /**
          * \brief Returns # of matched writers, needs template parameter for topic type
          */
         size_t matched_publications_size()
         {
+            if (loopback_topic)
+            {
+                return loopback_topic->matched_publications(*loopback_subscription);
+            }
+
             auto matched_pub = dds::sub::matched_publications(dds_reader);
             return matched_pub.size();
         }
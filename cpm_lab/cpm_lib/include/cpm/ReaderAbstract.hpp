@@ -3,6 +3,7 @@
 #include <dds/sub/ddssub.hpp>
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/get_topic.hpp"
+#include "cpm/LoopbackTransport.hpp"
 
 namespace cpm
 {
@@ -18,8 +19,12 @@ namespace cpm
     {
     private:
 
-        //! Internal DDS reader that is abstracted by this class
+        //! Internal DDS reader that is abstracted by this class, null if the loopback transport is used
         dds::sub::DataReader<T> dds_reader;
+        //! Used instead of dds_reader if the LoopbackTransport was enabled when the reader was created
+        std::shared_ptr<LoopbackTopic<T>> loopback_topic;
+        //! Subscription of this reader in loopback_topic
+        std::shared_ptr<LoopbackSubscription<T>> loopback_subscription;
 
         /**
          * \brief Returns qos for the settings s.t. the constructor becomes more readable
@@ -54,6 +59,22 @@ namespace cpm
             return qos;
         }
 
+        /**
+         * \brief Subscribe to a loopback topic, if the loopback transport is enabled
+         * \param key Key of the topic, see LoopbackTransport::topic_key
+         * \param is_reliable QoS reliability
+         * \param history_keep_all QoS history (keep all or the last sample per instance)
+         * \param is_transient_local QoS durability
+         */
+        void create_loopback_subscription(std::string key, bool is_reliable, bool history_keep_all, bool is_transient_local)
+        {
+            if (!LoopbackTransport::is_enabled()) return;
+
+            loopback_topic = LoopbackTopic<T>::get(key);
+            loopback_subscription = std::make_shared<LoopbackSubscription<T>>(is_reliable, is_transient_local, history_keep_all ? 0 : 1);
+            loopback_topic->add_subscription(loopback_subscription);
+        }
+
     public:
         ReaderAbstract(const ReaderAbstract&) = delete;
         ReaderAbstract& operator=(const ReaderAbstract&) = delete;
@@ -69,9 +90,12 @@ namespace cpm
          * \param transient_local Receive messages sent before joining (true) or not (false, default)
          */
         ReaderAbstract(std::string topic, bool reliable = false, bool history_keep_all = false, bool transient_local = false)
-        :dds_reader(dds::sub::Subscriber(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic), get_qos(reliable, history_keep_all, transient_local))
+        :dds_reader(LoopbackTransport::is_enabled() ?
+            dds::sub::DataReader<T>(dds::core::null) :
+            dds::sub::DataReader<T>(dds::sub::Subscriber(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic), get_qos(reliable, history_keep_all, transient_local))
+        )
         { 
-            
+            create_loopback_subscription(LoopbackTransport::topic_key(topic), reliable, history_keep_all, transient_local);
         }
 
         /**
@@ -90,9 +114,12 @@ namespace cpm
             bool history_keep_all = false, 
             bool transient_local = false
         )
-        :dds_reader(dds::sub::Subscriber(_participant), cpm::get_topic<T>(_participant, topic), get_qos(reliable, history_keep_all, transient_local))
+        :dds_reader(LoopbackTransport::is_enabled() ?
+            dds::sub::DataReader<T>(dds::core::null) :
+            dds::sub::DataReader<T>(dds::sub::Subscriber(_participant), cpm::get_topic<T>(_participant, topic), get_qos(reliable, history_keep_all, transient_local))
+        )
         { 
-            
+            create_loopback_subscription(LoopbackTransport::topic_key(_participant.domain_id(), topic), reliable, history_keep_all, transient_local);
         }
         
         /**
@@ -100,6 +127,11 @@ namespace cpm
          */
         std::vector<T> take()
         {
+            if (loopback_subscription)
+            {
+                return loopback_subscription->take();
+            }
+
             //Only take() could be a cause for not being thread-safe, but the DDS APIs should be implemented thread-safe (is the case for RTI DDS)
             auto samples = dds_reader.take();
             std::vector<T> samples_vec;
@@ -120,6 +152,11 @@ namespace cpm
          */
         size_t matched_publications_size()
         {
+            if (loopback_topic)
+            {
+                return loopback_topic->matched_publications(*loopback_subscription);
+            }
+
             auto matched_pub = dds::sub::matched_publications(dds_reader);
             return matched_pub.size();
         }
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cmath>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace cpm
+{
+    /**
+     * \struct SampleInterpolation
+     * \brief Interpolation between two samples of type T, used by SampleHistory::interpolate.
+     * By default, the pose (Pose2D, e.g. of VehicleState or VehicleObservation) is interpolated linearly
+     * (the yaw along the shorter direction), all other fields are taken from the sample that is closer in time.
+     * Specialize it for types without a pose or to interpolate further fields.
+     * \ingroup cpmlib
+     */
+    template<typename T>
+    struct SampleInterpolation
+    {
+        /**
+         * \brief Interpolate between two samples
+         * \param before The older sample
+         * \param after The newer sample
+         * \param alpha Position of the requested time between the samples, in [0, 1]
+         * \param sample_out Returns the interpolated sample (its create stamp is set by the caller)
+         */
+        static void interpolate(const T& before, const T& after, double alpha, T& sample_out)
+        {
+            sample_out = (alpha < 0.5) ? before : after;
+
+            double yaw_difference = std::remainder(after.pose().yaw() - before.pose().yaw(), 2.0 * M_PI);
+            sample_out.pose().x(before.pose().x() + alpha * (after.pose().x() - before.pose().x()));
+            sample_out.pose().y(before.pose().y() + alpha * (after.pose().y() - before.pose().y()));
+            sample_out.pose().yaw(std::remainder(before.pose().yaw() + alpha * yaw_difference, 2.0 * M_PI));
+        }
+    };
+
+    /**
+     * \class SampleHistory
+     * \brief Bounded history of samples sorted by their create stamp, to get the sample (or the interpolated state) at a given time,
+     * e.g. for sensor fusion or delay compensation. Used by Reader and MultiVehicleReader.
+     * The samples are stored in a ring buffer that is allocated once, so inserting a sample does not allocate memory
+     * (as long as T itself does not, i.e. has no sequences). Samples usually arrive in order and are appended in O(1);
+     * a sample that arrived late is sorted in. When the history is full, the oldest sample is dropped.
+     * Queries use a binary search, i.e. take O(log n). Not thread-safe.
+     * \ingroup cpmlib
+     */
+    template<typename T>
+    class SampleHistory
+    {
+        //! Ring buffer, its size is the capacity of the history
+        std::vector<T> samples;
+        //! Position of the oldest sample in samples
+        size_t first = 0;
+        //! Number of stored samples
+        size_t count = 0;
+
+        /**
+         * \brief Time of a sample, its create stamp
+         * \param sample The sample
+         */
+        static uint64_t get_stamp(const T& sample)
+        {
+            return sample.header().create_stamp().nanoseconds();
+        }
+
+        /**
+         * \brief Access the sample with the given index, 0 is the oldest sample
+         * \param index Index of the sample
+         */
+        T& at(size_t index)
+        {
+            return samples[(first + index) % samples.size()];
+        }
+
+        /**
+         * \brief Index of the first sample that is newer than t (count if there is none), binary search
+         * \param t Time in ns
+         */
+        size_t upper_bound(uint64_t t)
+        {
+            size_t low = 0;
+            size_t high = count;
+            while (low < high)
+            {
+                size_t middle = low + (high - low) / 2;
+                if (get_stamp(at(middle)) <= t)
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+            return low;
+        }
+
+    public:
+        /**
+         * \brief Constructor
+         * \param capacity Max. number of stored samples, 0 to disable the history
+         */
+        explicit SampleHistory(size_t capacity = 0)
+        :samples(capacity)
+        {
+        }
+
+        /**
+         * \brief Max. number of stored samples
+         */
+        size_t capacity()
+        {
+            return samples.size();
+        }
+
+        /**
+         * \brief Number of stored samples
+         */
+        size_t size()
+        {
+            return count;
+        }
+
+        /**
+         * \brief Remove all samples (the memory is kept)
+         */
+        void clear()
+        {
+            first = 0;
+            count = 0;
+        }
+
+        /**
+         * \brief Insert a sample at its position regarding its create stamp. If the history is full, the oldest sample is dropped,
+         * or the new sample if it is older than all stored samples.
+         * \param sample The sample
+         */
+        void insert(const T& sample)
+        {
+            if (samples.size() == 0) return;
+
+            uint64_t stamp = get_stamp(sample);
+            if (count == samples.size())
+            {
+                if (stamp < get_stamp(at(0))) return;
+
+                first = (first + 1) % samples.size();
+                --count;
+            }
+
+            //Append, then move the sample to its position (only if it arrived late), behind samples with the same stamp
+            size_t position = upper_bound(stamp);
+            at(count) = sample;
+            ++count;
+            for (size_t i = count - 1; i > position; --i)
+            {
+                std::swap(at(i), at(i - 1));
+            }
+        }
+
+        /**
+         * \brief Get the sample that was valid at time t, i.e. the newest sample with a create stamp not after t
+         * \param t Time in ns
+         * \param sample_out Returns the sample, if one exists
+         * \return False if there is no such sample (e.g. t is older than the history)
+         */
+        bool sample_at(uint64_t t, T& sample_out)
+        {
+            size_t position = upper_bound(t);
+            if (position == 0) return false;
+
+            sample_out = at(position - 1);
+            return true;
+        }
+
+        /**
+         * \brief Get the state at time t, interpolated between the samples before and after t (see SampleInterpolation).
+         * The create stamp of the returned sample is set to t. There is no extrapolation.
+         * \param t Time in ns
+         * \param sample_out Returns the interpolated sample, if t lies within the history
+         * \return False if t is not within the time range of the stored samples
+         */
+        bool interpolate(uint64_t t, T& sample_out)
+        {
+            size_t position = upper_bound(t);
+            if (position == 0) return false;
+
+            T& before = at(position - 1);
+            uint64_t before_stamp = get_stamp(before);
+            if (before_stamp == t)
+            {
+                sample_out = before;
+                return true;
+            }
+            if (position == count) return false;
+
+            T& after = at(position);
+            double alpha = static_cast<double>(t - before_stamp) / static_cast<double>(get_stamp(after) - before_stamp);
+            SampleInterpolation<T>::interpolate(before, after, alpha, sample_out);
+            sample_out.header().create_stamp().nanoseconds(t);
+            return true;
+        }
+    };
+}
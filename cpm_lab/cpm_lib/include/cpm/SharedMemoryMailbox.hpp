@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace cpm
+{
+    /**
+     * \class SharedMemoryMailbox
+     * \brief Lock-free ring of messages in POSIX shared memory, for the communication of two processes on the same machine
+     * (e.g. Middleware and HLC) without the DDS transport. One process creates the mailbox (and owns it), the other one opens it.
+     * Messages flow in one direction only, so a mailbox pair is required for a bidirectional communication.
+     *
+     * Each message consists of a tag (e.g. the message type) and bytes. Messages get consecutive sequence numbers, which are
+     * used to detect messages that were overwritten while they were read. The writer never blocks: If the reader falls behind
+     * by more than the number of slots, the oldest messages are skipped and counted as lost. The reader is woken up via a futex
+     * on new messages, so it does not need to poll.
+     *
+     * Writing is thread-safe within the writing process; there must only be one writing and one reading process.
+     * Does not depend on DDS, s.t. it can be tested on its own.
+     * \ingroup cpmlib
+     */
+    class SharedMemoryMailbox
+    {
+        /**
+         * \struct Header
+         * \brief Shared data at the beginning of the shared memory segment, followed by the slots
+         */
+        struct Header;
+
+        /**
+         * \struct Slot
+         * \brief Header of a single message slot, followed by slot_size bytes of message data
+         */
+        struct Slot;
+
+        //! Name of the shared memory segment
+        std::string name;
+        //! Whether this process created the segment (and unlinks it on destruction)
+        bool is_owner;
+        //! Mapped shared memory segment
+        void* memory = nullptr;
+        //! Size of the mapped segment in bytes
+        size_t memory_size = 0;
+        //! Header within memory
+        Header* header = nullptr;
+
+        //! Sequence number of the next message to read (reading process only)
+        uint64_t next_read_sequence = 0;
+        //! Number of messages that were overwritten before they could be read (reading process only)
+        uint64_t lost_messages = 0;
+        //! Serializes writes of multiple threads of the writing process
+        std::mutex write_mutex;
+
+        /**
+         * \brief Constructor, use create or open instead
+         * \param _name Name of the shared memory segment
+         * \param _is_owner Whether this process created the segment
+         * \param _memory The mapped segment
+         * \param _memory_size Size of the mapped segment in bytes
+         */
+        SharedMemoryMailbox(std::string _name, bool _is_owner, void* _memory, size_t _memory_size);
+
+        /**
+         * \brief Get the slot for the given sequence number
+         * \param sequence Sequence number of the message
+         */
+        Slot* get_slot(uint64_t sequence);
+
+    public:
+        SharedMemoryMailbox(const SharedMemoryMailbox&) = delete;
+        SharedMemoryMailbox& operator=(const SharedMemoryMailbox&) = delete;
+
+        /**
+         * \brief Create a new mailbox (replaces an existing segment with the same name, e.g. of a crashed process)
+         * \param name Name of the shared memory segment, must start with '/' (see shm_open)
+         * \param slot_count Max. number of messages that can be buffered
+         * \param slot_size Max. size of a single message in bytes
+         * \return The mailbox, or nullptr if the segment could not be created
+         */
+        static std::shared_ptr<SharedMemoryMailbox> create(std::string name, size_t slot_count, size_t slot_size);
+
+        /**
+         * \brief Open a mailbox that was created by another process
+         * \param name Name of the shared memory segment
+         * \return The mailbox, or nullptr if it does not exist, is not fully initialized yet, has an incompatible layout or its owner is not running anymore
+         */
+        static std::shared_ptr<SharedMemoryMailbox> open(std::string name);
+
+        /**
+         * \brief Destructor, unmaps the segment, which is also unlinked by its owner
+         */
+        ~SharedMemoryMailbox();
+
+        /**
+         * \brief Write a message and wake up the reader
+         * \param tag Tag of the message, e.g. its type
+         * \param data Message data
+         * \param size Size of the message data in bytes
+         * \return False if the message is larger than the slot size (it is not written then)
+         */
+        bool write(uint32_t tag, const char* data, size_t size);
+
+        /**
+         * \brief Read the next message, waits for it if there is none
+         * \param tag Returns the tag of the message
+         * \param data Returns the message data
+         * \param timeout_ns Max. time to wait for a message in ns, 0 to not wait at all
+         * \return True if a message was read, false on timeout
+         */
+        bool read(uint32_t& tag, std::vector<char>& data, uint64_t timeout_ns);
+
+        /**
+         * \brief Sequence number of the next message that will be written, i.e. the number of messages written so far
+         */
+        uint64_t get_write_sequence();
+
+        /**
+         * \brief Number of messages that were overwritten before the reader could read them
+         */
+        uint64_t get_lost_messages();
+
+        /**
+         * \brief Register the calling process as the peer of the owner, e.g. to tell the owner that the mailbox is being used
+         */
+        void attach();
+
+        /**
+         * \brief Check if a peer is attached (see attach) and still running
+         */
+        bool is_peer_attached();
+
+        /**
+         * \brief Check if the owner of the mailbox is still running
+         */
+        bool is_owner_alive();
+    };
+}
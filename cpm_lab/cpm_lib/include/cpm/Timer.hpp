@@ -4,6 +4,8 @@
 #include <functional>
 #include <memory>
 
+#include "cpm/PhaseAllocator.hpp"
+
 namespace cpm
 {
     /**
@@ -25,6 +27,9 @@ namespace cpm
     protected:
         Timer(){}
 
+        //! Registration of the offset of the timer, if it was created with create_staggered; released with the timer
+        std::shared_ptr<PhaseAllocator::Allocation> phase_allocation;
+
     public:
         /**
          * \brief Create a timer that can be used for function callback
@@ -43,6 +48,29 @@ namespace cpm
             bool simulated_time_allowed,
             bool simulated_time
         );
+
+        /**
+         * \brief Create a timer like create, but with an offset that is allocated automatically (see PhaseAllocator), s.t. the
+         * periodic nodes of a machine do not all wake up at the same time. The offset is chosen within the part of the period that
+         * belongs to the stage of the node in the pipeline (vehicle -> middleware -> HLC), where the load of the other nodes is lowest.
+         * With simulated time, the offset is 0, as the nodes do not run concurrently then anyway.
+         * \param node_id ID of the timer in the network
+         * \param period_nanoseconds The timer is called periodically with a period of period_nanoseconds
+         * \param compute_nanoseconds Expected computation time of the callback per period
+         * \param stage Stage of the node in the pipeline
+         * \param wait_for_start For the real-time timer: Set whether the timer is started only if a start signal is sent via DDS
+         * \param simulated_time_allowed Decide whether the timer can run with simulated time
+         * \param simulated_time Set to true if simulated time should be used for the user, else false
+         */
+        static std::shared_ptr<Timer> create_staggered(
+            std::string node_id,
+            uint64_t period_nanoseconds,
+            uint64_t compute_nanoseconds,
+            PhaseAllocator::Stage stage,
+            bool wait_for_start,
+            bool simulated_time_allowed,
+            bool simulated_time
+        );
         /**
          * Start the periodic callback of the callback function in the 
          * calling thread. The thread is blocked until stop() is 
@@ -85,6 +113,20 @@ namespace cpm
          */
         virtual void stop() = 0;
         
+        //Ignore warning that period_nanoseconds is unused in the default implementation
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wunused-parameter"
+
+        /**
+         * \brief Change the period of a running timer, e.g. for an adaptive period. The change takes effect after the current
+         * callback; the following timesteps are aligned to the new period (plus offset) again. Only supported by the real-time timer.
+         * \param period_nanoseconds The new period in nanoseconds
+         * \return False if the timer does not support changing its period (simulated time)
+         */
+        virtual bool set_period(uint64_t period_nanoseconds) { return false; }
+
+        #pragma GCC diagnostic pop
+
         /**
          * \brief Can be used to obtain the current system time in nanoseconds.
          * \return the current system time in nanoseconds
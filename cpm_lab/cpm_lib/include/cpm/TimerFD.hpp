@@ -71,10 +71,14 @@ namespace cpm {
         //! Optional function for when a stop signal is received
         std::function<void()> m_stop_callback;
 
+        //! If the timer runs in the virtual time of cpm::VirtualClock (decided when the timer is started) instead of using timer_fd
+        bool virtual_time = false;
+
         /**
-         * \brief Wait for the next period start of timerfd
+         * \brief Wait for the next period start of timerfd, or for the virtual clock to reach the deadline
+         * \param deadline Next deadline, only used with the virtual clock
          */
-        void wait();
+        void wait(uint64_t deadline);
 
         /**
          * \brief Wait for a start signal; 
@@ -100,6 +104,15 @@ namespace cpm {
          */
         void createTimer ();
 
+        /**
+         * \brief Set the expiration time and period of the internal timerfd
+         * \param first_expiration Absolute time of the first expiration in ns, must not be 0
+         */
+        void armTimer (uint64_t first_expiration);
+
+        //! Period requested via set_period, applied after the current callback; 0 if there is no request
+        std::atomic<uint64_t> requested_period_nanoseconds{0};
+
         //! For custom stop signals, should be changed only if you know what you are doing (usually you do not want to define a stop signal for you own participant, but use the default one!)
         uint64_t stop_signal = TRIGGER_STOP_SYMBOL;
 
@@ -161,6 +174,8 @@ namespace cpm {
          */
         void stop() override;
 
+        bool set_period(uint64_t period_nanoseconds) override;
+
         /**
          * \brief Can be used to obtain the current system time in nanoseconds.
          * \return the current system time in nanoseconds
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+namespace cpm
+{
+    /**
+     * \class TimestepDeadline
+     * \brief Deadline and cancellation token of a single planning timestep of an HLC, see HLCCommunicator::onEachTimestepWithDeadline.
+     * Iterative (anytime) planners can use it to decide if another iteration fits into the remaining time,
+     * and to notice that the timestep was cancelled (because the deadline has passed or the next timestep has started).
+     * All times are given in ns of the system clock (see get_time_ns). The token is shared between the
+     * HLCCommunicator and the planning thread, and all functions are thread-safe.
+     * Does not depend on DDS, s.t. it can be tested on its own.
+     * \ingroup cpmlib
+     */
+    class TimestepDeadline
+    {
+        //! Start of the timestep in ns
+        uint64_t start_ns;
+        //! Time in ns at which the commands of the timestep should have been sent
+        uint64_t deadline_ns;
+        //! Set by cancel
+        std::atomic_bool cancelled;
+
+    public:
+        /**
+         * \brief Constructor
+         * \param _start_ns Start of the timestep in ns
+         * \param _deadline_ns Time in ns at which the commands of the timestep should have been sent
+         */
+        TimestepDeadline(uint64_t _start_ns, uint64_t _deadline_ns);
+
+        /**
+         * \brief Create the deadline of a timestep that was started by the Middleware at t_now (see VehicleStateList)
+         * \param t_now Start of the timestep given by the Middleware in ns
+         * \param period_ns Period of the Middleware in ns
+         * \param margin_ns Time in ns that is reserved for sending the commands before the period ends, at most half of the period is used for it
+         * \param now_ns Current time in ns; if it is not within the period that starts at t_now (e.g. because the Middleware uses simulated time
+         * or the clocks differ), the timestep is regarded as started now
+         */
+        static std::shared_ptr<TimestepDeadline> from_period(uint64_t t_now, uint64_t period_ns, uint64_t margin_ns, uint64_t now_ns);
+
+        /**
+         * \brief Start of the timestep in ns
+         */
+        uint64_t get_start();
+
+        /**
+         * \brief Time in ns at which the commands of the timestep should have been sent
+         */
+        uint64_t get_deadline();
+
+        /**
+         * \brief Total time in ns that is available for the timestep
+         */
+        uint64_t get_budget();
+
+        /**
+         * \brief Remaining time until the deadline in ns, 0 if it has passed or the timestep was cancelled
+         * \param now_ns Current time in ns
+         */
+        uint64_t get_remaining(uint64_t now_ns);
+
+        /**
+         * \brief Remaining time until the deadline in ns, see get_remaining(uint64_t), using the current system time
+         */
+        uint64_t get_remaining();
+
+        /**
+         * \brief Check if the remaining time suffices for a computation of the given duration, e.g. the next iteration of a planner
+         * \param duration_ns Expected duration of the computation in ns
+         */
+        bool has_time_for(uint64_t duration_ns);
+
+        /**
+         * \brief Cancel the timestep, the planner should return as soon as possible
+         */
+        void cancel();
+
+        /**
+         * \brief Check if the planner should stop, i.e. if the timestep was cancelled or the deadline has passed
+         */
+        bool is_cancelled();
+    };
+}
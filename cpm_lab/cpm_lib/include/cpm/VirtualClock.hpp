@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <stdint.h>
+
+namespace cpm {
+    /**
+     * \class VirtualClock
+     * \brief Virtual clock and deterministic scheduler for tests. While enabled, cpm::get_time_ns returns the virtual time,
+     * TimerFD (and thus SimpleTimer and real-time timers created with cpm::Timer::create) sleeps in virtual time instead of using a timerfd,
+     * and the polling waits of ParameterReceiver and RTTTool (see sleep_for_ns) wait for the virtual time to pass.
+     *
+     * Virtual time only passes when advance / advance_to is called, or automatically (see enable) when all participants sleep.
+     * Participants are threads that are driven by the clock, e.g. the threads of running TimerFD instances. Before the clock
+     * advances to the next wake-up time, it waits until all participants sleep again, and sleepers are woken one at a time,
+     * ordered by their wake-up time and then by the order in which they started to sleep. Thus, e.g. timer callbacks are called
+     * in the same order and with the same timestamps in each test run, without waiting in real time.
+     *
+     * Note: A participant that blocks on something else than the clock (e.g. a timer that waits for its DDS start signal)
+     * also blocks advance until it continues. Disable the clock only after all timers that were started with it have been stopped.
+     * \ingroup cpmlib
+     */
+    class VirtualClock {
+        private:
+            VirtualClock();
+            VirtualClock(const VirtualClock&) = delete;
+            VirtualClock& operator=(const VirtualClock&) = delete;
+            VirtualClock(VirtualClock&&) = delete;
+            VirtualClock& operator=(VirtualClock&&) = delete;
+
+            //! If the virtual time is used, atomic s.t. get_time_ns does not need to lock the mutex
+            std::atomic_bool enabled;
+            //! Current virtual time in ns, only changed while clock_mutex is locked
+            std::atomic<uint64_t> now_ns;
+            //! If the clock advances on its own when all participants sleep, see enable
+            bool auto_advance = false;
+
+            //! For all members below
+            std::mutex clock_mutex;
+            //! Notified whenever a sleeper was woken, a participant started to sleep or the clock was disabled / interrupted
+            std::condition_variable clock_condition;
+
+            //! Sleeping threads, key: (wake-up time, sleeper ID in the order of the sleep calls), value: true if the thread is a participant
+            std::map<std::pair<uint64_t, uint64_t>, bool> sleepers;
+            //! ID for the next sleeper
+            uint64_t next_sleeper_id = 0;
+            //! Registered participants
+            std::set<std::thread::id> participants;
+            //! Participants (including announced ones) that are currently not sleeping
+            size_t running_participants = 0;
+            //! Participants that were announced, but did not register yet
+            size_t announced_participants = 0;
+
+            /**
+             * \brief Wake the sleeper with the earliest wake-up time, if it is not after limit_ns; requires clock_mutex to be locked
+             * \param limit_ns Latest wake-up time to consider
+             * \return True if a sleeper was woken
+             */
+            bool wake_next_sleeper(uint64_t limit_ns);
+
+            /**
+             * \brief If auto_advance is set and all participants sleep: Wake sleepers until a participant was woken; requires clock_mutex to be locked
+             */
+            void advance_if_idle();
+
+        public:
+            /**
+             * \brief Get the clock, which is shared by all threads of the process
+             */
+            static VirtualClock& Instance();
+
+            /**
+             * \brief Switch cpm::get_time_ns, the timers and the polling waits to the virtual time
+             * \param start_time_ns Initial virtual time
+             * \param _auto_advance If true, the clock advances to the next wake-up time on its own whenever all participants sleep
+             * (only if there is at least one participant), s.t. e.g. a test can simply start a timer and let it run in virtual time
+             */
+            void enable(uint64_t start_time_ns, bool _auto_advance = false);
+
+            /**
+             * \brief Switch back to the real time; all sleepers return (with false)
+             */
+            void disable();
+
+            /**
+             * \brief True if the virtual time is used
+             */
+            bool is_enabled() const;
+
+            /**
+             * \brief Current virtual time in ns
+             */
+            uint64_t now() const;
+
+            /**
+             * \brief Let the virtual time pass, see advance_to
+             * \param duration_ns Time to pass in ns
+             */
+            void advance(uint64_t duration_ns);
+
+            /**
+             * \brief Let the virtual time pass up to time_ns: All sleepers with a wake-up time up to time_ns are woken
+             * one after another (the time is set to their wake-up time), and after each wake-up, the call waits until all participants
+             * sleep again. Thus, when this function returns, all callbacks scheduled up to time_ns have been executed.
+             * \param time_ns Virtual time to advance to, nothing happens if it is not after the current virtual time
+             */
+            void advance_to(uint64_t time_ns);
+
+            /**
+             * \brief Block the calling thread until the virtual time reaches time_ns
+             * \param time_ns Wake-up time in virtual time
+             * \return False if the clock is (or was) disabled before the wake-up time was reached
+             */
+            bool sleep_until(uint64_t time_ns);
+
+            /**
+             * \brief Block the calling thread until the virtual time reaches time_ns or keep_sleeping becomes false;
+             * call interrupt after setting keep_sleeping to false
+             * \param time_ns Wake-up time in virtual time
+             * \param keep_sleeping Checked when the clock is notified, e.g. the active flag of a timer
+             * \return False if the clock is disabled or the sleep was interrupted before the wake-up time was reached
+             */
+            bool sleep_until(uint64_t time_ns, const std::atomic_bool& keep_sleeping);
+
+            /**
+             * \brief Notify all sleepers, s.t. they check their keep_sleeping flag (see sleep_until)
+             */
+            void interrupt();
+
+            /**
+             * \brief Announce a participant that is about to be started in a new thread, s.t. advance_to waits for it
+             * even before it called register_participant. The new thread must call register_participant.
+             */
+            void announce_participant();
+
+            /**
+             * \brief Register the calling thread as participant (see class description); does nothing if it is already registered
+             */
+            void register_participant();
+
+            /**
+             * \brief Unregister the calling thread as participant, e.g. when the timer it runs has been stopped
+             */
+            void unregister_participant();
+
+            /**
+             * \brief Number of currently sleeping threads, e.g. for a test to wait until a thread started to sleep
+             */
+            size_t get_sleeper_count();
+
+            /**
+             * \brief Sleep for a duration in the virtual time if the clock is enabled, else in real time
+             * \param duration_ns Duration in ns
+             */
+            static void sleep_for_ns(uint64_t duration_ns);
+    };
+}
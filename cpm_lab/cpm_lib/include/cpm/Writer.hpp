@@ -3,6 +3,7 @@
 #include <dds/pub/ddspub.hpp>
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/get_topic.hpp"
+#include "cpm/LoopbackTransport.hpp"
 
 #include <dds/core/QosProvider.hpp>
 #include <dds/dds.hpp>
@@ -24,8 +25,12 @@ namespace cpm
     {
     private:
     
-        //! Internal DDS Writer to be abstracted
+        //! Internal DDS Writer to be abstracted, null if the loopback transport is used
         dds::pub::DataWriter<T> dds_writer;
+        //! Used instead of dds_writer if the LoopbackTransport was enabled when the writer was created
+        std::shared_ptr<LoopbackTopic<T>> loopback_topic;
+        //! ID of this writer in loopback_topic
+        uint64_t loopback_writer_id = 0;
 
         /**
          * \brief Returns qos for the settings s.t. the constructor becomes more readable
@@ -57,6 +62,21 @@ namespace cpm
             return qos;
         }
 
+        /**
+         * \brief Register the writer at a loopback topic, if the loopback transport is enabled
+         * \param key Key of the topic, see LoopbackTransport::topic_key
+         * \param is_reliable QoS reliability
+         * \param history_keep_all QoS history
+         * \param is_transient_local QoS durability
+         */
+        void create_loopback_writer(std::string key, bool is_reliable, bool history_keep_all, bool is_transient_local)
+        {
+            if (!LoopbackTransport::is_enabled()) return;
+
+            loopback_topic = LoopbackTopic<T>::get(key);
+            loopback_writer_id = loopback_topic->add_writer(is_reliable, history_keep_all, is_transient_local);
+        }
+
     public:
         Writer(const Writer&) = delete;
         Writer& operator=(const Writer&) = delete;
@@ -72,9 +92,12 @@ namespace cpm
          * \param transient_local Resent messages sent before a new participant joined to that participant (true) or not (false, default)
          */
         Writer(std::string topic, bool reliable = false, bool history_keep_all = false, bool transient_local = false)
-        :dds_writer(dds::pub::Publisher(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic), get_qos(reliable, history_keep_all, transient_local))
+        :dds_writer(LoopbackTransport::is_enabled() ? 
+            dds::pub::DataWriter<T>(dds::core::null) :
+            dds::pub::DataWriter<T>(dds::pub::Publisher(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic), get_qos(reliable, history_keep_all, transient_local))
+        )
         { 
-            
+            create_loopback_writer(LoopbackTransport::topic_key(topic), reliable, history_keep_all, transient_local);
         }
 
         /**
@@ -85,9 +108,22 @@ namespace cpm
          * \param library The loaded library to use
          */
         Writer(std::string topic, std::string qos_xml_path, std::string library)
-        :dds_writer(dds::pub::Publisher(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic), dds::core::QosProvider(qos_xml_path, library).datawriter_qos())
+        :dds_writer(LoopbackTransport::is_enabled() ? 
+            dds::pub::DataWriter<T>(dds::core::null) :
+            dds::pub::DataWriter<T>(dds::pub::Publisher(ParticipantSingleton::Instance()), cpm::get_topic<T>(topic), dds::core::QosProvider(qos_xml_path, library).datawriter_qos())
+        )
         { 
-        
+            if (LoopbackTransport::is_enabled())
+            {
+                //Use the QoS of the XML file for the loopback transport as well
+                dds::pub::qos::DataWriterQos qos = dds::core::QosProvider(qos_xml_path, library).datawriter_qos();
+                create_loopback_writer(
+                    LoopbackTransport::topic_key(topic),
+                    qos.policy<dds::core::policy::Reliability>().kind() == dds::core::policy::ReliabilityKind::RELIABLE,
+                    qos.policy<dds::core::policy::History>().kind() == dds::core::policy::HistoryKind::KEEP_ALL,
+                    qos.policy<dds::core::policy::Durability>().kind() == dds::core::policy::DurabilityKind::TRANSIENT_LOCAL
+                );
+            }
         }
 
         /**
@@ -106,9 +142,23 @@ namespace cpm
             bool history_keep_all = false, 
             bool transient_local = false
         )
-        :dds_writer(dds::pub::Publisher(_participant), cpm::get_topic<T>(_participant, topic), get_qos(reliable, history_keep_all, transient_local))
+        :dds_writer(LoopbackTransport::is_enabled() ? 
+            dds::pub::DataWriter<T>(dds::core::null) :
+            dds::pub::DataWriter<T>(dds::pub::Publisher(_participant), cpm::get_topic<T>(_participant, topic), get_qos(reliable, history_keep_all, transient_local))
+        )
         { 
-            
+            create_loopback_writer(LoopbackTransport::topic_key(_participant.domain_id(), topic), reliable, history_keep_all, transient_local);
+        }
+
+        /**
+         * \brief Destructor, removes the writer from the loopback topic (if used)
+         */
+        ~Writer()
+        {
+            if (loopback_topic)
+            {
+                loopback_topic->remove_writer(loopback_writer_id);
+            }
         }
         
         /**
@@ -117,6 +167,12 @@ namespace cpm
          */
         void write(T msg)
         {
+            if (loopback_topic)
+            {
+                loopback_topic->write(loopback_writer_id, msg);
+                return;
+            }
+
             //DDS operations are assumed to be thread safe, so don't use a mutex here
             dds_writer.write(msg);
         }
@@ -126,6 +182,11 @@ namespace cpm
          */
         size_t matched_subscriptions_size()
         {
+            if (loopback_topic)
+            {
+                return loopback_topic->matched_subscriptions(loopback_writer_id);
+            }
+
             auto matched_sub = dds::pub::matched_subscriptions(dds_writer);
             return matched_sub.size();
         }
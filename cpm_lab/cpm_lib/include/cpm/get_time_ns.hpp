@@ -4,13 +4,14 @@
 
 namespace cpm {
     /**
-     * \brief Global function to access the current system time in nanoseconds, saves redundant code
+     * \brief Global function to access the current system time in nanoseconds, saves redundant code.
+     * Returns the virtual time instead if cpm::VirtualClock is enabled.
      * \ingroup cpmlib
      */
     uint64_t get_time_ns();
 
     /**
-     * \brief Same as get_time_ns but allows specifying the clock type
+     * \brief Same as get_time_ns but allows specifying the clock type (also replaced by the virtual time if cpm::VirtualClock is enabled)
      */
     uint64_t get_time_ns(clockid_t clockid);
 }
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "cpm/BinaryLogRecord.hpp"
+
+#include <cstdio>
+
+/**
+ * \file BinaryLogRecord.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm
+{
+    namespace binary_log
+    {
+        /**
+         * \brief Read a trivially copyable value from the buffer
+         * \return False if the buffer does not contain enough bytes
+         */
+        template<typename V> static bool get(const uint8_t* data, size_t size, size_t& offset, V& value_out)
+        {
+            if (offset + sizeof(V) > size) return false;
+            memcpy(&value_out, data + offset, sizeof(V));
+            offset += sizeof(V);
+            return true;
+        }
+
+        bool decode_record(const uint8_t* data, size_t size, size_t& offset, DecodedRecord& record_out)
+        {
+            size_t pos = offset;
+            uint8_t arg_count = 0;
+
+            if (!get(data, size, pos, record_out.format_id)) return false;
+            if (!get(data, size, pos, record_out.log_level)) return false;
+            if (!get(data, size, pos, record_out.timestamp)) return false;
+            if (!get(data, size, pos, arg_count)) return false;
+
+            record_out.args.clear();
+            record_out.args.reserve(arg_count);
+            for (uint8_t i = 0; i < arg_count; ++i)
+            {
+                uint8_t tag;
+                if (!get(data, size, pos, tag)) return false;
+
+                DecodedArg arg;
+                arg.tag = static_cast<ArgTag>(tag);
+                switch (arg.tag)
+                {
+                    case ArgTag::Signed:
+                        if (!get(data, size, pos, arg.i)) return false;
+                        break;
+                    case ArgTag::Unsigned:
+                    case ArgTag::Pointer:
+                        if (!get(data, size, pos, arg.u)) return false;
+                        break;
+                    case ArgTag::Floating:
+                        if (!get(data, size, pos, arg.d)) return false;
+                        break;
+                    case ArgTag::String:
+                    {
+                        uint16_t length;
+                        if (!get(data, size, pos, length)) return false;
+                        if (pos + length > size) return false;
+                        arg.s.assign(reinterpret_cast<const char*>(data + pos), length);
+                        pos += length;
+                        break;
+                    }
+                    default:
+                        //Unknown tag, the rest of the buffer cannot be interpreted
+                        return false;
+                }
+
+                record_out.args.push_back(std::move(arg));
+            }
+
+            offset = pos;
+            return true;
+        }
+
+        /**
+         * \brief Format a single conversion specification with a decoded argument
+         * \param spec Conversion specification without length modifier, e.g. "%5.2" (conversion character not included)
+         * \param conversion Conversion character, e.g. 'f'
+         * \param arg The argument to format
+         */
+        static std::string format_single(std::string spec, char conversion, const DecodedArg& arg)
+        {
+            //Convert the argument to the type that the conversion expects,
+            //s.t. snprintf is never called with mismatching types
+            int size = 0;
+            std::string result;
+
+            switch (conversion)
+            {
+                case 'd': case 'i':
+                {
+                    long long value = (arg.tag == ArgTag::Signed) ? arg.i
+                        : (arg.tag == ArgTag::Floating) ? static_cast<long long>(arg.d)
+                        : static_cast<long long>(arg.u);
+                    spec += "ll";
+                    spec += conversion;
+                    size = snprintf(nullptr, 0, spec.c_str(), value);
+                    result.assign(size, ' ');
+                    snprintf(&result[0], size + 1, spec.c_str(), value);
+                    break;
+                }
+                case 'u': case 'x': case 'X': case 'o':
+                {
+                    unsigned long long value = (arg.tag == ArgTag::Signed) ? static_cast<unsigned long long>(arg.i)
+                        : (arg.tag == ArgTag::Floating) ? static_cast<unsigned long long>(arg.d)
+                        : arg.u;
+                    spec += "ll";
+                    spec += conversion;
+                    size = snprintf(nullptr, 0, spec.c_str(), value);
+                    result.assign(size, ' ');
+                    snprintf(&result[0], size + 1, spec.c_str(), value);
+                    break;
+                }
+                case 'c':
+                {
+                    int value = (arg.tag == ArgTag::Signed) ? static_cast<int>(arg.i) : static_cast<int>(arg.u);
+                    spec += conversion;
+                    size = snprintf(nullptr, 0, spec.c_str(), value);
+                    result.assign(size, ' ');
+                    snprintf(&result[0], size + 1, spec.c_str(), value);
+                    break;
+                }
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                {
+                    double value = (arg.tag == ArgTag::Floating) ? arg.d
+                        : (arg.tag == ArgTag::Signed) ? static_cast<double>(arg.i)
+                        : static_cast<double>(arg.u);
+                    spec += conversion;
+                    size = snprintf(nullptr, 0, spec.c_str(), value);
+                    result.assign(size, ' ');
+                    snprintf(&result[0], size + 1, spec.c_str(), value);
+                    break;
+                }
+                case 's':
+                {
+                    std::string value = arg.s;
+                    if (arg.tag == ArgTag::Signed) value = std::to_string(arg.i);
+                    else if (arg.tag == ArgTag::Unsigned || arg.tag == ArgTag::Pointer) value = std::to_string(arg.u);
+                    else if (arg.tag == ArgTag::Floating) value = std::to_string(arg.d);
+                    spec += conversion;
+                    size = snprintf(nullptr, 0, spec.c_str(), value.c_str());
+                    result.assign(size, ' ');
+                    snprintf(&result[0], size + 1, spec.c_str(), value.c_str());
+                    break;
+                }
+                case 'p':
+                {
+                    void* value = reinterpret_cast<void*>(static_cast<uintptr_t>(arg.u));
+                    spec += conversion;
+                    size = snprintf(nullptr, 0, spec.c_str(), value);
+                    result.assign(size, ' ');
+                    snprintf(&result[0], size + 1, spec.c_str(), value);
+                    break;
+                }
+                default:
+                    //Unsupported conversion (e.g. %n), print it as it is
+                    result = spec + conversion;
+                    break;
+            }
+
+            return result;
+        }
+
+        std::string format_record(const std::string& format, const std::vector<DecodedArg>& args)
+        {
+            std::string result;
+            result.reserve(format.size() + 16 * args.size());
+            size_t next_arg = 0;
+
+            for (size_t pos = 0; pos < format.size(); ++pos)
+            {
+                if (format[pos] != '%')
+                {
+                    result += format[pos];
+                    continue;
+                }
+
+                if (pos + 1 < format.size() && format[pos + 1] == '%')
+                {
+                    result += '%';
+                    ++pos;
+                    continue;
+                }
+
+                //Collect flags, width and precision; drop length modifiers (the recorded type is used instead)
+                std::string spec = "%";
+                size_t spec_end = pos + 1;
+                while (spec_end < format.size())
+                {
+                    char c = format[spec_end];
+                    if (strchr("-+ #0123456789.", c) != nullptr)
+                    {
+                        spec += c;
+                    }
+                    else if (c == '*')
+                    {
+                        //Width or precision is passed as an int argument before the value, insert it into the specification
+                        long long value = 0;
+                        if (next_arg < args.size())
+                        {
+                            const DecodedArg& arg = args.at(next_arg);
+                            value = (arg.tag == ArgTag::Signed) ? arg.i : static_cast<long long>(arg.u);
+                            ++next_arg;
+                        }
+
+                        bool is_precision = (spec.back() == '.');
+                        if (value >= 0)
+                        {
+                            spec += std::to_string(value);
+                        }
+                        else if (is_precision)
+                        {
+                            //A negative precision is taken as if it was omitted
+                            spec.pop_back();
+                        }
+                        else
+                        {
+                            //A negative width is taken as the flag - followed by a positive width
+                            spec += "-" + std::to_string(-value);
+                        }
+                    }
+                    else if (strchr("hlLqjzt", c) == nullptr)
+                    {
+                        break;
+                    }
+                    ++spec_end;
+                }
+
+                if (spec_end >= format.size())
+                {
+                    //Incomplete conversion at the end of the string
+                    result += format.substr(pos);
+                    break;
+                }
+
+                if (next_arg < args.size())
+                {
+                    result += format_single(spec, format[spec_end], args.at(next_arg));
+                    ++next_arg;
+                }
+                else
+                {
+                    result += "<?>";
+                }
+
+                pos = spec_end;
+            }
+
+            return result;
+        }
+    }
+}
@@ -34,6 +34,7 @@ HLCCommunicator::HLCCommunicator(std::vector<uint8_t> _vehicle_ids, int middlewa
                 qos_profile
             )
     ),
+    middleware_domain(middleware_domain),
     writer_readyStatus(
             p_local_comms_participant->get_participant(),
             "readyStatus",
@@ -56,12 +57,19 @@ HLCCommunicator::HLCCommunicator(std::vector<uint8_t> _vehicle_ids, int middlewa
     }
 
 void HLCCommunicator::start(){
+    // Attach to the local mailbox of the middleware before sending the ready message,
+    // as the middleware decides on the ready message if it uses the mailbox
+    getLocalMailbox();
+
     writeInfoMessage();
     sendReadyMessage(); 
  
     // Run this until we get a SystemTrigger to stop
     bool stop = false;
     while(!stop) {
+        // Messages from the local mailbox (if any), with a wakeup on new messages
+        stop = receiveFromLocalMailbox(1000000ull);
+
         auto state_samples = reader_vehicleStateList.take();
         for(auto sample : state_samples) {
             // We received a StateList, which is our timing signal
@@ -75,10 +83,15 @@ void HLCCommunicator::start(){
             new_vehicleStateList = false;
         }
          
-        stop = stopSignalReceived();
+        stop = stopSignalReceived() || stop;
+
+        // Send the offered commands in time, even if the planner is still running
+        checkDeadline();
 
-        // Slow down the loop a bit
-        usleep(10);
+        // Slow down the loop a bit (the local mailbox already waits)
+        if( !getLocalMailbox() ){
+            usleep(10);
+        }
     }
  
     // If on_stop is defined, call it now before we finish
@@ -95,14 +108,31 @@ void HLCCommunicator::runTimestep(){
     }
 
     if( planning_future.valid() ){
+        // A planner that uses the deadline stops on its own when it is cancelled
+        if( current_deadline ){
+            current_deadline->cancel();
+        }
+
         std::future_status future_status = planning_future.wait_for(std::chrono::milliseconds(1));
         if( future_status != std::future_status::ready ) {
             if( on_cancel_timestep.target_type() != typeid(void) ) {
                 on_cancel_timestep();
+            } else if( on_each_timestep_with_deadline.target_type() != typeid(void) ) {
+                // The planner has been cancelled, we give it the margin to notice that.
+                // A planner that ignores the cancellation must not block this loop (and thus the stop signal),
+                // so we skip this timestep and check again with the next one
+                future_status = planning_future.wait_for(std::chrono::nanoseconds(deadline_margin_ns));
+                if( future_status != std::future_status::ready ) {
+                    CPM_LOG(1,
+                            "%s",
+                            "HLC planner does not stop when it is cancelled, skipping this timestep"
+                            );
+                    return;
+                }
             } else {
                 // If we're here that means we did not manage to calculate a plan in time,
                 // and we don't have a callback to stop planning early
-                cpm::Logging::Instance().write(1,
+                CPM_LOG(1,
                         "%s",
                         "HLC is taking too long to plan and we have no way to stop it"
                         );
@@ -113,15 +143,53 @@ void HLCCommunicator::runTimestep(){
         planning_future.get();
     }
 
+    // Offers of the previous timestep that were made after its deadline
+    sendOfferedCommands();
+
+    current_deadline = cpm::TimestepDeadline::from_period(
+            vehicle_state_list.t_now(),
+            vehicle_state_list.period_ms() * 1000000ull,
+            deadline_margin_ns,
+            cpm::get_time_ns()
+        );
+
     // on_each_timestep should pretty much always be defined, but we check anyway
-    if( on_each_timestep.target_type() != typeid(void) ) {
+    if( on_each_timestep_with_deadline.target_type() != typeid(void) ) {
+        std::shared_ptr<cpm::TimestepDeadline> deadline = current_deadline;
+        VehicleStateList state_list = vehicle_state_list;
         planning_future = std::async(
-                on_each_timestep,
-                vehicle_state_list
+                std::launch::async,
+                [this, deadline, state_list](){
+                    on_each_timestep_with_deadline(state_list, deadline);
+                    sendOfferedCommands();
+                }
+            );
+    } else if( on_each_timestep.target_type() != typeid(void) ) {
+        VehicleStateList state_list = vehicle_state_list;
+        planning_future = std::async(
+                std::launch::async,
+                [this, state_list](){
+                    on_each_timestep(state_list);
+                    sendOfferedCommands();
+                }
             );
     }
 }
 
+void HLCCommunicator::checkDeadline(){
+    if( current_deadline && current_deadline->get_remaining() == 0 ){
+        current_deadline->cancel();
+        sendOfferedCommands();
+    }
+}
+
+void HLCCommunicator::sendOfferedCommands(){
+    sendOfferedCommandsHelper(offered_trajectory);
+    sendOfferedCommandsHelper(offered_path_tracking);
+    sendOfferedCommandsHelper(offered_speed_curvature);
+    sendOfferedCommandsHelper(offered_direct);
+}
+
 void HLCCommunicator::sendReadyMessage(){
     TimeStamp timestamp(11111);
     // The middleware expects a message like "hlc_${vehicle_id}", e.g. hlc_1
@@ -143,6 +211,59 @@ bool HLCCommunicator::stopSignalReceived(){
     return false;
 }
 
+std::shared_ptr<cpm::HLCMailbox> HLCCommunicator::getLocalMailbox(){
+    if( !use_local_mailbox ){
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(local_mailbox_mutex);
+    if( local_mailbox && local_mailbox->is_middleware_alive() ){
+        return local_mailbox;
+    }
+
+    // The middleware is gone: Try its successor right away, then only from time to time, as DDS is used in between
+    uint64_t t_now = cpm::get_time_ns();
+    if( local_mailbox || local_mailbox_open_time_ns == 0 || t_now >= local_mailbox_open_time_ns + LOCAL_MAILBOX_RETRY_NS ){
+        if( local_mailbox ){
+            CPM_LOG(2,
+                    "%s",
+                    "HLC: Middleware of the local mailbox is not running anymore, reopening it or using DDS instead"
+                    );
+        }
+        local_mailbox = cpm::HLCMailbox::open(middleware_domain, vehicle_ids);
+        local_mailbox_open_time_ns = t_now;
+    }
+    return local_mailbox;
+}
+
+bool HLCCommunicator::receiveFromLocalMailbox(uint64_t timeout_ns){
+    std::shared_ptr<cpm::HLCMailbox> mailbox = getLocalMailbox();
+    if( !mailbox ){
+        return false;
+    }
+
+    bool stop = false;
+    cpm::HLCMailbox::MessageTag tag;
+    while( mailbox->read(tag, local_mailbox_buffer, timeout_ns) ) {
+        // Only wait for the first message, take the others that are already there
+        timeout_ns = 0;
+
+        if( tag == cpm::HLCMailbox::TagVehicleStateList ) {
+            cpm::HLCMailbox::deserialize(local_mailbox_buffer, vehicle_state_list);
+            new_vehicleStateList = true;
+        }
+        else if( tag == cpm::HLCMailbox::TagSystemTrigger ) {
+            SystemTrigger trigger;
+            cpm::HLCMailbox::deserialize(local_mailbox_buffer, trigger);
+            if( trigger.next_start().nanoseconds() == trigger_stop ) {
+                stop = true;
+            }
+        }
+    }
+
+    return stop;
+}
+
 void HLCCommunicator::stop(int vehicle_id){
     StopRequest request(vehicle_id);
     writer_stopRequest.write(request);
@@ -165,6 +286,12 @@ void HLCCommunicator::writeInfoMessage(){
         set_callbacks << "on_each_timestep ";
     }
 
+    if( on_each_timestep_with_deadline.target_type() == typeid(void)) { 
+        unset_callbacks << "on_each_timestep_with_deadline ";
+    } else {
+        set_callbacks << "on_each_timestep_with_deadline ";
+    }
+
     if( on_cancel_timestep.target_type() == typeid(void)) { 
         unset_callbacks << "on_cancel_timestep ";
     } else {
@@ -187,7 +314,13 @@ void HLCCommunicator::writeInfoMessage(){
 
     ss << "The following callback methods were not set: "  << unset_callbacks.rdbuf() << std::endl;
 
+    if( getLocalMailbox() ){
+        ss << "Communicating with the middleware via the local mailbox (shared memory)" << std::endl;
+    } else {
+        ss << "Communicating with the middleware via DDS" << std::endl;
+    }
+
     // Write to Log as an info message and to stdout, so it appears in the text logs
-    cpm::Logging::Instance().write(3, "%s", ss.str().c_str());
+    CPM_LOG(3, "%s", ss.str().c_str());
     std::cout << ss.str() << std::endl;
 }
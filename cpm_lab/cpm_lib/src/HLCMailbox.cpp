@@ -0,0 +1,78 @@
+#include "cpm/HLCMailbox.hpp"
+
+#include <sstream>
+
+/**
+ * \file HLCMailbox.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm {
+
+    const size_t HLCMailbox::SLOT_COUNT;
+    const size_t HLCMailbox::SLOT_SIZE;
+
+    HLCMailbox::HLCMailbox(std::shared_ptr<SharedMemoryMailbox> _to_hlc, std::shared_ptr<SharedMemoryMailbox> _from_hlc, bool _is_middleware)
+    :to_hlc(_to_hlc)
+    ,from_hlc(_from_hlc)
+    ,is_middleware(_is_middleware)
+    {
+    }
+
+    std::string HLCMailbox::get_name(int domain, const std::vector<uint8_t>& vehicle_ids, std::string direction)
+    {
+        std::stringstream name;
+        name << "/cpm_hlc_mailbox_" << domain;
+        for (auto vehicle_id : vehicle_ids)
+        {
+            name << "_" << static_cast<int>(vehicle_id);
+        }
+        name << "_" << direction;
+        return name.str();
+    }
+
+    std::shared_ptr<HLCMailbox> HLCMailbox::create(int domain, const std::vector<uint8_t>& vehicle_ids)
+    {
+        auto to_hlc = SharedMemoryMailbox::create(get_name(domain, vehicle_ids, "to_hlc"), SLOT_COUNT, SLOT_SIZE);
+        auto from_hlc = SharedMemoryMailbox::create(get_name(domain, vehicle_ids, "from_hlc"), SLOT_COUNT, SLOT_SIZE);
+        if (!to_hlc || !from_hlc) return nullptr;
+
+        return std::shared_ptr<HLCMailbox>(new HLCMailbox(to_hlc, from_hlc, true));
+    }
+
+    std::shared_ptr<HLCMailbox> HLCMailbox::open(int domain, const std::vector<uint8_t>& vehicle_ids)
+    {
+        auto to_hlc = SharedMemoryMailbox::open(get_name(domain, vehicle_ids, "to_hlc"));
+        auto from_hlc = SharedMemoryMailbox::open(get_name(domain, vehicle_ids, "from_hlc"));
+        if (!to_hlc || !from_hlc) return nullptr;
+
+        //The Middleware checks this when it decides which path to use
+        to_hlc->attach();
+        from_hlc->attach();
+
+        return std::shared_ptr<HLCMailbox>(new HLCMailbox(to_hlc, from_hlc, false));
+    }
+
+    bool HLCMailbox::is_hlc_attached()
+    {
+        return to_hlc->is_peer_attached() && from_hlc->is_peer_attached();
+    }
+
+    bool HLCMailbox::is_middleware_alive()
+    {
+        return to_hlc->is_owner_alive();
+    }
+
+    bool HLCMailbox::read(MessageTag& tag, std::vector<char>& buffer, uint64_t timeout_ns)
+    {
+        uint32_t raw_tag = 0;
+        bool received = (is_middleware ? from_hlc : to_hlc)->read(raw_tag, buffer, timeout_ns);
+        tag = static_cast<MessageTag>(raw_tag);
+        return received;
+    }
+
+    uint64_t HLCMailbox::get_lost_messages()
+    {
+        return (is_middleware ? from_hlc : to_hlc)->get_lost_messages();
+    }
+}
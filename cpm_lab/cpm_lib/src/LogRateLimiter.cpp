@@ -0,0 +1,190 @@
+#include "cpm/LogRateLimiter.hpp"
+
+#include <algorithm>
+
+/**
+ * \file LogRateLimiter.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm
+{
+    constexpr size_t LogRateLimiter::MAX_CALL_SITES;
+
+    void LogRateLimiter::TokenBucket::refill(uint64_t now_ns, double rate, double burst)
+    {
+        if (now_ns > last_refill_ns)
+        {
+            tokens += static_cast<double>(now_ns - last_refill_ns) * 1e-9 * rate;
+            tokens = std::min(tokens, burst);
+        }
+        last_refill_ns = now_ns;
+    }
+
+    bool LogRateLimiter::allow(const char* call_site, const char* format, unsigned short log_level, uint64_t now_ns, std::vector<Summary>& summaries_out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!initialized)
+        {
+            node_bucket.tokens = node_burst;
+            node_bucket.last_refill_ns = now_ns;
+            last_summary_ns = now_ns;
+            initialized = true;
+        }
+
+        //Find the call site or create it (full bucket); only new call sites copy their strings. Messages without a call site only use the node bucket.
+        auto entry = (call_site != nullptr) ? call_sites.find(call_site) : call_sites.end();
+        if (call_site != nullptr && entry == call_sites.end() && call_sites.size() >= MAX_CALL_SITES)
+        {
+            //Make room by removing idle call sites, which are summarized early if necessary
+            collect_summaries(now_ns, summaries_out);
+        }
+        if (call_site != nullptr && entry == call_sites.end() && call_sites.size() < MAX_CALL_SITES)
+        {
+            CallSite new_site;
+            new_site.location = call_site;
+            new_site.format = format;
+            new_site.bucket.tokens = call_site_burst;
+            new_site.bucket.last_refill_ns = now_ns;
+            entry = call_sites.emplace(call_site, new_site).first;
+        }
+        else if (entry != call_sites.end() && entry->second.format != format)
+        {
+            //The call site uses a different (dynamic) format string, it keeps its bucket but the summary should show the current format
+            entry->second.format = format;
+        }
+
+        //Check both buckets before taking a token from either of them
+        bool call_site_ok = true;
+        if (entry != call_sites.end() && call_site_rate > 0)
+        {
+            entry->second.bucket.refill(now_ns, call_site_rate, call_site_burst);
+            call_site_ok = entry->second.bucket.tokens >= 1.0;
+        }
+
+        bool node_ok = true;
+        if (node_rate > 0)
+        {
+            node_bucket.refill(now_ns, node_rate, node_burst);
+            node_ok = node_bucket.tokens >= 1.0;
+        }
+
+        bool allowed = call_site_ok && node_ok;
+        if (allowed)
+        {
+            if (entry != call_sites.end() && call_site_rate > 0) entry->second.bucket.tokens -= 1.0;
+            if (node_rate > 0) node_bucket.tokens -= 1.0;
+            ++statistics.messages_passed;
+        }
+        else
+        {
+            ++statistics.messages_suppressed;
+            if (call_site_ok)
+            {
+                ++statistics.messages_suppressed_by_node_limit;
+            }
+
+            if (entry != call_sites.end())
+            {
+                ++entry->second.suppressed_since_summary;
+                ++entry->second.suppressed_total;
+                entry->second.last_log_level = log_level;
+            }
+        }
+
+        if (entry != call_sites.end())
+        {
+            entry->second.last_use_ns = now_ns;
+        }
+
+        if (now_ns >= last_summary_ns + summary_period_ns)
+        {
+            collect_summaries(now_ns, summaries_out);
+        }
+
+        return allowed;
+    }
+
+    void LogRateLimiter::collect_summaries(uint64_t now_ns, std::vector<Summary>& summaries_out)
+    {
+        last_summary_ns = now_ns;
+
+        for (auto it = call_sites.begin(); it != call_sites.end();)
+        {
+            CallSite& site = it->second;
+
+            if (site.suppressed_since_summary > 0)
+            {
+                Summary summary;
+                summary.log_level = site.last_log_level;
+                summary.call_site = site.location;
+                summary.format = site.format;
+                summary.suppressed_count = site.suppressed_since_summary;
+                summaries_out.push_back(summary);
+
+                //Bounded, like call_sites
+                if (statistics.suppressed_per_call_site.size() < MAX_CALL_SITES || statistics.suppressed_per_call_site.count(site.location) > 0)
+                {
+                    statistics.suppressed_per_call_site[site.location] = site.suppressed_total;
+                }
+                site.suppressed_since_summary = 0;
+            }
+
+            //Idle call sites with a full bucket behave like new ones, so they can be removed
+            site.bucket.refill(now_ns, call_site_rate, call_site_burst);
+            if (now_ns >= site.last_use_ns + summary_period_ns && (call_site_rate <= 0 || site.bucket.tokens >= call_site_burst))
+            {
+                it = call_sites.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void LogRateLimiter::collect_due_summaries(uint64_t now_ns, std::vector<Summary>& summaries_out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (initialized && now_ns >= last_summary_ns + summary_period_ns)
+        {
+            collect_summaries(now_ns, summaries_out);
+        }
+    }
+
+    void LogRateLimiter::set_limits(double _call_site_rate, double _call_site_burst, double _node_rate, double _node_burst)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        call_site_rate = _call_site_rate;
+        call_site_burst = std::max(_call_site_burst, 1.0);
+        node_rate = _node_rate;
+        node_burst = std::max(_node_burst, 1.0);
+    }
+
+    void LogRateLimiter::set_summary_period(uint64_t period_ns)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        summary_period_ns = period_ns;
+    }
+
+    LogRateLimiter::Statistics LogRateLimiter::get_statistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Statistics result = statistics;
+        result.suppressing_call_sites = 0;
+        for (auto& site : call_sites)
+        {
+            if (site.second.suppressed_since_summary > 0)
+            {
+                ++result.suppressing_call_sites;
+                result.suppressed_per_call_site[site.second.location] = site.second.suppressed_total;
+            }
+        }
+        return result;
+    }
+}
@@ -1,5 +1,9 @@
 #include "cpm/Logging.hpp"
 
+#include <pthread.h>
+#include <random>
+#include <chrono>
+
 /**
  * \file Logging.cpp
  * \ingroup cpmlib
@@ -7,9 +11,24 @@
 
 namespace cpm {
 
+    constexpr size_t Logging::BINARY_FLUSH_SIZE;
+    constexpr size_t Logging::BINARY_MAX_BATCH_SIZE;
+    constexpr unsigned int Logging::BINARY_FLUSH_PERIOD_MS;
+
+    //! Thread-specific key for the binary log buffer of each thread, see get_thread_binary_buffer
+    static pthread_key_t binary_buffer_key;
+    //! Makes sure that binary_buffer_key is only created once
+    static pthread_once_t binary_buffer_key_once = PTHREAD_ONCE_INIT;
+
     Logging::Logging() :
-        logger("log", true)
+        logger("log", true),
+        format_writer("logFormat", true, true, true),
+        record_writer("logRecords", true)
     {
+        //Random session ID, s.t. format IDs of different programs or restarts cannot be confused by the receiver
+        std::random_device random_device;
+        session_id = (static_cast<uint64_t>(random_device()) << 32) ^ cpm::get_time_ns();
+
         //Get log level / logging verbosity
         log_level_reader = std::make_shared<cpm::AsyncReader<LogLevel>>(
             [this](std::vector<LogLevel>& samples){
@@ -46,6 +65,23 @@ namespace cpm {
         file.close();
     }
 
+    Logging::~Logging()
+    {
+        {
+            std::lock_guard<std::mutex> lock(binary_buffers_mutex);
+            binary_flush_stop = true;
+        }
+        binary_flush_cv.notify_all();
+
+        if (binary_flush_thread.joinable())
+        {
+            binary_flush_thread.join();
+        }
+
+        //Publish records that were written since the last flush
+        flush_binary_buffers();
+    }
+
     Logging& Logging::Instance() {
         static Logging instance;
         return instance;
@@ -77,4 +113,217 @@ namespace cpm {
         }
     }
 
+
+    void Logging::write_formatted(unsigned short message_log_level, const std::string& str, uint64_t time_now)
+    {
+        //Before flushing make sure that the Logger was initialized properly / that its ID was set
+        check_id();
+
+        //For the log file: csv, so escape '"'
+        std::string log_string = std::string(str);
+        std::string escaped_quote = std::string("\"\"");
+        size_t pos = 0;
+        while ((pos = log_string.find('"', pos)) != std::string::npos) {
+            log_string.replace(pos, 1, escaped_quote);
+            pos += escaped_quote.size();
+        }
+        //Also put the whole string in quotes
+        log_string.insert(0, "\"");
+        log_string += "\"";
+
+        //Mutex for writing the message (file, writer) - is released when going out of scope
+        std::lock_guard<std::mutex> lock(log_mutex);
+
+        //Add the message to the log file - cast for log level is necessary to not create garbage symbols
+        file.open(filename, std::ios::app);
+        file << id << "," << static_cast<int>(message_log_level) << "," << time_now << "," << log_string << std::endl;
+        file.close();
+
+        //Send the log message via RTI
+        Log log(id, str, TimeStamp(time_now), message_log_level);
+        logger.write(log);
+
+        //Show the log message on the console
+        std::cerr << "Log at time " << time_now << ", level " << static_cast<int>(message_log_level) << ": " << str << std::endl;
+    }
+
+    void Logging::write_suppression_summaries(const std::vector<LogRateLimiter::Summary>& summaries, uint64_t time_now)
+    {
+        for (auto& summary : summaries)
+        {
+            std::stringstream stream;
+            stream << "Logging: " << summary.suppressed_count 
+                << " messages suppressed by the rate limit, call site: " << summary.call_site << ", format: " << summary.format;
+            write_formatted(summary.log_level, stream.str(), time_now);
+        }
+    }
+
+    void Logging::set_rate_limits(double call_site_rate, double call_site_burst, double node_rate, double node_burst)
+    {
+        rate_limiter.set_limits(call_site_rate, call_site_burst, node_rate, node_burst);
+    }
+
+    LogRateLimiter::Statistics Logging::get_rate_limit_statistics()
+    {
+        return rate_limiter.get_statistics();
+    }
+
+    uint32_t Logging::register_binary_format(const char* format, const char* location)
+    {
+        //Same behaviour as write: Make sure that the Logger was initialized properly / that its ID was set
+        check_id();
+
+        uint32_t format_id = next_format_id.fetch_add(1);
+
+        std::string current_id;
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            current_id = id;
+        }
+
+        LogFormat log_format;
+        log_format.session_id(session_id);
+        log_format.format_id(format_id);
+        log_format.id(current_id);
+        log_format.format(format);
+        log_format.location(location);
+        format_writer.write(log_format);
+
+        //Start the flush thread when the first binary log call site is used
+        start_flush_thread();
+
+        return format_id;
+    }
+
+    void Logging::start_flush_thread()
+    {
+        std::lock_guard<std::mutex> lock(binary_buffers_mutex);
+        if (!binary_flush_thread.joinable() && !binary_flush_stop)
+        {
+            binary_flush_thread = std::thread(&Logging::binary_flush_loop, this);
+            binary_flush_thread_started.store(true);
+        }
+    }
+
+    void Logging::mark_binary_buffer_exited(void* buffer)
+    {
+        static_cast<BinaryLogBuffer*>(buffer)->thread_exited.store(true);
+    }
+
+    void Logging::create_binary_buffer_key()
+    {
+        pthread_key_create(&binary_buffer_key, &Logging::mark_binary_buffer_exited);
+    }
+
+    Logging::BinaryLogBuffer& Logging::get_thread_binary_buffer()
+    {
+        pthread_once(&binary_buffer_key_once, &Logging::create_binary_buffer_key);
+
+        //The buffer is owned by binary_buffers, the thread-specific value is just a shortcut to it
+        void* thread_value = pthread_getspecific(binary_buffer_key);
+        if (thread_value != nullptr)
+        {
+            return *static_cast<BinaryLogBuffer*>(thread_value);
+        }
+
+        auto buffer = std::make_shared<BinaryLogBuffer>();
+        buffer->records.reserve(BINARY_FLUSH_SIZE + 1024);
+        {
+            std::lock_guard<std::mutex> lock(binary_buffers_mutex);
+            binary_buffers.push_back(buffer);
+        }
+        pthread_setspecific(binary_buffer_key, buffer.get());
+
+        return *buffer;
+    }
+
+    void Logging::publish_binary_records(std::vector<uint8_t>& records)
+    {
+        if (records.empty()) return;
+
+        std::string current_id;
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            current_id = id;
+        }
+
+        LogRecordBatch batch;
+        batch.session_id(session_id);
+        batch.id(current_id);
+        batch.records().resize(records.size());
+        std::copy(records.begin(), records.end(), batch.records().begin());
+        record_writer.write(batch);
+
+        records.clear();
+    }
+
+    void Logging::flush_binary_buffers()
+    {
+        //Copy the list of buffers, s.t. new threads are not blocked while the buffers are published
+        std::vector<std::shared_ptr<BinaryLogBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(binary_buffers_mutex);
+            buffers = binary_buffers;
+        }
+
+        for (auto& buffer : buffers)
+        {
+            //Only swap under the lock, s.t. the writing thread is not blocked by the DDS write
+            std::vector<uint8_t> records;
+            records.reserve(BINARY_FLUSH_SIZE);
+            {
+                std::lock_guard<std::mutex> lock(buffer->mutex);
+                if (buffer->records.empty()) continue;
+                std::swap(records, buffer->records);
+            }
+            publish_binary_records(records);
+        }
+
+        //Remove buffers of terminated threads (they were flushed above and cannot receive new records)
+        {
+            std::lock_guard<std::mutex> lock(binary_buffers_mutex);
+            binary_buffers.erase(
+                std::remove_if(binary_buffers.begin(), binary_buffers.end(), 
+                    [](const std::shared_ptr<BinaryLogBuffer>& buffer) { 
+                        std::lock_guard<std::mutex> lock(buffer->mutex);
+                        return buffer->thread_exited.load() && buffer->records.empty(); 
+                    }),
+                binary_buffers.end()
+            );
+        }
+
+        //Report dropped records via the regular log
+        uint64_t dropped = binary_records_dropped.exchange(0);
+        if (dropped > 0)
+        {
+            CPM_LOG(2, "Logging: Dropped %llu binary log records that did not fit into a batch", static_cast<unsigned long long>(dropped));
+        }
+    }
+
+    void Logging::binary_flush_loop()
+    {
+        std::unique_lock<std::mutex> lock(binary_buffers_mutex);
+        while (!binary_flush_stop)
+        {
+            binary_flush_cv.wait_for(lock, std::chrono::milliseconds(BINARY_FLUSH_PERIOD_MS), [&] () {
+                return binary_flush_stop || binary_flush_requested.load();
+            });
+            binary_flush_requested.store(false);
+
+            lock.unlock();
+            flush_binary_buffers();
+
+            //Summaries of suppressed messages are otherwise only created by the next call of write
+            std::vector<LogRateLimiter::Summary> summaries;
+            uint64_t time_now = get_time();
+            rate_limiter.collect_due_summaries(time_now, summaries);
+            write_suppression_summaries(summaries, time_now);
+            lock.lock();
+        }
+    }
+
+    void Logging::flush_binary()
+    {
+        flush_binary_buffers();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "cpm/LoopbackTransport.hpp"
+#include "InternalConfiguration.hpp"
+
+#include <sstream>
+
+/**
+ * \file LoopbackTransport.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm
+{
+    std::atomic_bool LoopbackTransport::enabled(false);
+
+    void LoopbackTransport::enable()
+    {
+        enabled.store(true);
+    }
+
+    void LoopbackTransport::disable()
+    {
+        enabled.store(false);
+    }
+
+    bool LoopbackTransport::is_enabled()
+    {
+        return enabled.load();
+    }
+
+    std::string LoopbackTransport::topic_key(const std::string& topic_name)
+    {
+        return topic_key(InternalConfiguration::Instance().get_dds_domain(), topic_name);
+    }
+
+    std::string LoopbackTransport::topic_key(int domain_id, const std::string& topic_name)
+    {
+        return std::to_string(domain_id) + "/" + topic_name;
+    }
+
+    bool LoopbackTransport::parse_vehicle_id_filter(const std::string& expression, uint8_t& vehicle_id_out)
+    {
+        //Format of VehicleIDFilteredTopic: "vehicle_id = <id>"
+        std::stringstream stream(expression);
+        std::string field;
+        std::string op;
+        int vehicle_id = -1;
+        std::string rest;
+        if (!(stream >> field >> op >> vehicle_id) || (stream >> rest)) return false;
+        if (field != "vehicle_id" || op != "=" || vehicle_id < 0 || vehicle_id > 255) return false;
+
+        vehicle_id_out = static_cast<uint8_t>(vehicle_id);
+        return true;
+    }
+}
@@ -2,6 +2,7 @@
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/Parameter.hpp"
 #include "cpm/get_topic.hpp"
+#include "cpm/VirtualClock.hpp"
 #include <chrono>
 #include <thread>
 
@@ -61,12 +62,12 @@ namespace cpm
         while (param_bool.find(parameter_name) == param_bool.end()) {
             s_lock.unlock();
             requestParam(parameter_name);
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Waiting for parameter %s ...", 
                 parameter_name.c_str()
             );
-            usleep(1000);
+            VirtualClock::sleep_for_ns(1000000ull);
             s_lock.lock();
         }
 
@@ -81,12 +82,12 @@ namespace cpm
         while (param_uint64_t.find(parameter_name) == param_uint64_t.end()) {
             s_lock.unlock();
             requestParam(parameter_name);
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Waiting for parameter %s ...", 
                 parameter_name.c_str()
             );
-            rti::util::sleep(dds::core::Duration::from_millisecs(static_cast<uint64_t>(1000)));
+            VirtualClock::sleep_for_ns(1000000000ull);
             s_lock.lock();
         }
 
@@ -101,12 +102,12 @@ namespace cpm
         while (param_int.find(parameter_name) == param_int.end()) {
             s_lock.unlock();
             requestParam(parameter_name);
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Waiting for parameter %s ...", 
                 parameter_name.c_str()
             );
-            usleep(1000);
+            VirtualClock::sleep_for_ns(1000000ull);
             s_lock.lock();
         }
 
@@ -121,12 +122,12 @@ namespace cpm
         while (param_double.find(parameter_name) == param_double.end()) {
             s_lock.unlock();
             requestParam(parameter_name);
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Waiting for parameter %s ...", 
                 parameter_name.c_str()
             );
-            usleep(1000);
+            VirtualClock::sleep_for_ns(1000000ull);
             s_lock.lock();
         }
 
@@ -141,12 +142,12 @@ namespace cpm
         while (param_string.find(parameter_name) == param_string.end()) {
             s_lock.unlock();
             requestParam(parameter_name);
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Waiting for parameter %s ...", 
                 parameter_name.c_str()
             );
-            usleep(1000);
+            VirtualClock::sleep_for_ns(1000000ull);
             s_lock.lock();
         }
 
@@ -161,12 +162,12 @@ namespace cpm
         while (param_ints.find(parameter_name) == param_ints.end()) {
             s_lock.unlock();
             requestParam(parameter_name);
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Waiting for parameter %s ...", 
                 parameter_name.c_str()
             );
-            usleep(1000);
+            VirtualClock::sleep_for_ns(1000000ull);
             s_lock.lock();
         }
 
@@ -181,12 +182,12 @@ namespace cpm
         while (param_doubles.find(parameter_name) == param_doubles.end()) {
             s_lock.unlock();
             requestParam(parameter_name);
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Waiting for parameter %s ...", 
                 parameter_name.c_str()
             );
-            usleep(1000);
+            VirtualClock::sleep_for_ns(1000000ull);
             s_lock.lock();
         }
 
@@ -0,0 +1,365 @@
+#include "cpm/PhaseAllocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * \file PhaseAllocator.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm
+{
+    const std::string PhaseAllocator::DEFAULT_TABLE_NAME = "/cpm_phase_allocation";
+
+    //! Max. number of nodes in the table of a machine, further nodes get an offset but are not registered
+    static const size_t PHASE_TABLE_SIZE = 128;
+    //! Identifies an initialized table
+    static const uint32_t PHASE_TABLE_MAGIC = 0x63706d50;
+    //! Layout version of the table, must be increased if PhaseTable or PhaseTableEntry change
+    static const uint32_t PHASE_TABLE_VERSION = 1;
+    //! Number of candidate offsets per period
+    static const uint64_t PHASE_BINS = 200;
+
+    /**
+     * \struct PhaseTableEntry
+     * \brief A registered node in the shared memory table
+     * \ingroup cpmlib
+     */
+    struct PhaseTableEntry {
+        //! PID of the process of the node, 0 if the entry is free
+        int32_t pid;
+        //! Stage of the node, see PhaseAllocator::Stage
+        uint32_t stage;
+        //! Identifies the registration, see PhaseAllocator::Allocation
+        uint64_t token;
+        //! Period in ns
+        uint64_t period_ns;
+        //! Expected computation time per period in ns
+        uint64_t compute_ns;
+        //! Allocated offset in ns
+        uint64_t offset_ns;
+        //! ID of the node (truncated), for debugging purposes
+        char node_id[64];
+    };
+
+    /**
+     * \struct PhaseTable
+     * \brief Shared memory table of all registered nodes of the machine
+     * \ingroup cpmlib
+     */
+    struct PhaseTable {
+        //! Set to PHASE_TABLE_MAGIC (release) after the table was initialized
+        std::atomic<uint32_t> magic;
+        //! Layout version, see PHASE_TABLE_VERSION
+        uint32_t version;
+        //! Robust process-shared mutex for all following members
+        pthread_mutex_t mutex;
+        //! Last token that was given to an entry
+        uint64_t last_token;
+        //! The registered nodes
+        PhaseTableEntry entries[PHASE_TABLE_SIZE];
+    };
+
+    /**
+     * \brief Check if the process with the given PID is running
+     * \param pid The PID
+     * \ingroup cpmlib
+     */
+    static bool is_process_alive(int32_t pid)
+    {
+        return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+    }
+
+    /**
+     * \brief Map the table with the given name, create it if it does not exist yet. Tables are only mapped once per process.
+     * \param name Name of the shared memory segment
+     * \return The table, or nullptr if it could not be created or opened
+     * \ingroup cpmlib
+     */
+    static PhaseTable* get_phase_table(const std::string& name)
+    {
+        static std::mutex tables_mutex;
+        static std::map<std::string, PhaseTable*> tables;
+
+        std::lock_guard<std::mutex> lock(tables_mutex);
+        auto entry = tables.find(name);
+        if (entry != tables.end()) return entry->second;
+
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+        bool is_creator = (fd >= 0);
+        if (is_creator)
+        {
+            //Nodes of all users share the table, independent of the umask
+            fchmod(fd, 0666);
+            if (ftruncate(fd, sizeof(PhaseTable)) != 0)
+            {
+                close(fd);
+                shm_unlink(name.c_str());
+                return nullptr;
+            }
+        }
+        else
+        {
+            fd = shm_open(name.c_str(), O_RDWR, 0666);
+            if (fd < 0) return nullptr;
+
+            //The creator might not have set the size yet
+            struct stat table_stat;
+            for (int i = 0; i < 100; ++i)
+            {
+                if (fstat(fd, &table_stat) == 0 && static_cast<size_t>(table_stat.st_size) >= sizeof(PhaseTable)) break;
+                usleep(10000);
+            }
+            if (fstat(fd, &table_stat) != 0 || static_cast<size_t>(table_stat.st_size) != sizeof(PhaseTable))
+            {
+                close(fd);
+                return nullptr;
+            }
+        }
+
+        void* memory = mmap(nullptr, sizeof(PhaseTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) return nullptr;
+        PhaseTable* table = static_cast<PhaseTable*>(memory);
+
+        if (is_creator)
+        {
+            //The segment is zero-initialized, i.e. all entries are free
+            pthread_mutexattr_t attributes;
+            pthread_mutexattr_init(&attributes);
+            pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+            pthread_mutex_init(&table->mutex, &attributes);
+            pthread_mutexattr_destroy(&attributes);
+
+            table->version = PHASE_TABLE_VERSION;
+            table->last_token = 0;
+            table->magic.store(PHASE_TABLE_MAGIC, std::memory_order_release);
+        }
+        else
+        {
+            for (int i = 0; i < 100 && table->magic.load(std::memory_order_acquire) != PHASE_TABLE_MAGIC; ++i)
+            {
+                usleep(10000);
+            }
+            if (table->magic.load(std::memory_order_acquire) != PHASE_TABLE_MAGIC || table->version != PHASE_TABLE_VERSION)
+            {
+                munmap(memory, sizeof(PhaseTable));
+                return nullptr;
+            }
+        }
+
+        tables[name] = table;
+        return table;
+    }
+
+    /**
+     * \brief Lock the mutex of the table, recovers it if its previous owner died while holding it
+     * \param table The table
+     * \return False if the mutex could not be locked
+     * \ingroup cpmlib
+     */
+    static bool lock_phase_table(PhaseTable* table)
+    {
+        int status = pthread_mutex_lock(&table->mutex);
+        if (status == EOWNERDEAD)
+        {
+            //The entries are only changed field by field, so they are still usable
+            pthread_mutex_consistent(&table->mutex);
+            return true;
+        }
+        return status == 0;
+    }
+
+    /**
+     * \brief Add the computation time of a node to the load of the bins, repeated with the period of the node
+     * \param load Load per bin, covering one period of the new node
+     * \param period_ns Period of the new node in ns
+     * \param node The registered node
+     * \ingroup cpmlib
+     */
+    static void add_node_load(std::vector<double>& load, uint64_t period_ns, const PhaseAllocator::Node& node)
+    {
+        if (node.period_ns == 0) return;
+
+        const uint64_t bins = load.size();
+        const double bin_ns = static_cast<double>(period_ns) / static_cast<double>(bins);
+        const uint64_t compute_ns = std::min(std::max<uint64_t>(node.compute_ns, 1), node.period_ns);
+
+        //A node with a longer period only runs in some of the periods of the new node
+        double weight = 1.0;
+        uint64_t occurrences = 1;
+        if (node.period_ns < period_ns)
+        {
+            occurrences = std::min<uint64_t>((period_ns + node.period_ns - 1) / node.period_ns, 1000);
+        }
+        else
+        {
+            weight = static_cast<double>(period_ns) / static_cast<double>(node.period_ns);
+        }
+
+        for (uint64_t k = 0; k < occurrences; ++k)
+        {
+            double start = static_cast<double>((node.offset_ns + k * node.period_ns) % period_ns);
+            double end = start + static_cast<double>(std::min(compute_ns, period_ns));
+
+            //Distribute the interval [start, end) onto the bins, wrapping around at the end of the period
+            for (uint64_t bin = static_cast<uint64_t>(start / bin_ns); static_cast<double>(bin) * bin_ns < end; ++bin)
+            {
+                double bin_start = static_cast<double>(bin) * bin_ns;
+                double overlap = std::min(end, bin_start + bin_ns) - std::max(start, bin_start);
+                if (overlap > 0.0)
+                {
+                    load.at(bin % bins) += weight * overlap / bin_ns;
+                }
+            }
+        }
+    }
+
+    uint64_t PhaseAllocator::compute_offset(uint64_t period_ns, uint64_t compute_ns, Stage stage, const std::vector<Node>& nodes)
+    {
+        if (period_ns == 0) return 0;
+
+        const uint64_t bins = std::min(PHASE_BINS, period_ns);
+        std::vector<double> load(bins, 0.0);
+        for (auto& node : nodes)
+        {
+            add_node_load(load, period_ns, node);
+        }
+
+        //Window of the stage in bins
+        uint64_t window_begin = 0;
+        uint64_t window_end = bins;
+        if (stage != StageAny)
+        {
+            window_begin = bins * static_cast<uint64_t>(stage) / 3;
+            window_end = bins * (static_cast<uint64_t>(stage) + 1) / 3;
+        }
+
+        //Number of bins covered by the computation of the new node
+        const uint64_t covered_bins = std::max<uint64_t>(1, std::min(bins, (compute_ns * bins + period_ns - 1) / period_ns));
+
+        //Choose the start bin with the lowest peak load (then lowest total load) during the computation, the earliest one on ties
+        uint64_t best_bin = window_begin;
+        double best_peak = std::numeric_limits<double>::max();
+        double best_total = std::numeric_limits<double>::max();
+        for (uint64_t bin = window_begin; bin < window_end; ++bin)
+        {
+            double peak = 0.0;
+            double total = 0.0;
+            for (uint64_t i = 0; i < covered_bins; ++i)
+            {
+                double bin_load = load.at((bin + i) % bins);
+                peak = std::max(peak, bin_load);
+                total += bin_load;
+            }
+
+            if (peak < best_peak - 1e-9 || (peak < best_peak + 1e-9 && total < best_total - 1e-9))
+            {
+                best_bin = bin;
+                best_peak = peak;
+                best_total = total;
+            }
+        }
+
+        return best_bin * period_ns / bins;
+    }
+
+    std::shared_ptr<PhaseAllocator::Allocation> PhaseAllocator::allocate(std::string node_id, uint64_t period_ns, uint64_t compute_ns, Stage stage, std::string table_name)
+    {
+        PhaseTable* table = get_phase_table(table_name);
+        if (!table || !lock_phase_table(table))
+        {
+            return std::make_shared<Allocation>(compute_offset(period_ns, compute_ns, stage, std::vector<Node>()), "", 0, 0);
+        }
+
+        //Collect the registered nodes, free the entries of processes that are not running anymore
+        std::vector<Node> nodes;
+        long free_index = -1;
+        for (size_t i = 0; i < PHASE_TABLE_SIZE; ++i)
+        {
+            PhaseTableEntry& entry = table->entries[i];
+            if (entry.pid != 0 && !is_process_alive(entry.pid))
+            {
+                entry.pid = 0;
+                entry.token = 0;
+            }
+
+            if (entry.pid == 0)
+            {
+                if (free_index < 0) free_index = static_cast<long>(i);
+                continue;
+            }
+
+            Node node;
+            node.period_ns = entry.period_ns;
+            node.compute_ns = entry.compute_ns;
+            node.offset_ns = entry.offset_ns;
+            nodes.push_back(node);
+        }
+
+        uint64_t offset_ns = compute_offset(period_ns, compute_ns, stage, nodes);
+
+        if (free_index < 0)
+        {
+            pthread_mutex_unlock(&table->mutex);
+            return std::make_shared<Allocation>(offset_ns, "", 0, 0);
+        }
+
+        PhaseTableEntry& entry = table->entries[free_index];
+        entry.token = ++(table->last_token);
+        entry.stage = static_cast<uint32_t>(stage);
+        entry.period_ns = period_ns;
+        entry.compute_ns = compute_ns;
+        entry.offset_ns = offset_ns;
+        strncpy(entry.node_id, node_id.c_str(), sizeof(entry.node_id) - 1);
+        entry.node_id[sizeof(entry.node_id) - 1] = '\0';
+        entry.pid = static_cast<int32_t>(getpid());
+        uint64_t token = entry.token;
+
+        pthread_mutex_unlock(&table->mutex);
+        return std::make_shared<Allocation>(offset_ns, table_name, static_cast<size_t>(free_index), token);
+    }
+
+    PhaseAllocator::Allocation::Allocation(uint64_t _offset_ns, std::string _table_name, size_t _entry_index, uint64_t _entry_token)
+    :offset_ns(_offset_ns)
+    ,table_name(_table_name)
+    ,entry_index(_entry_index)
+    ,entry_token(_entry_token)
+    {
+    }
+
+    PhaseAllocator::Allocation::~Allocation()
+    {
+        if (table_name.empty()) return;
+
+        PhaseTable* table = get_phase_table(table_name);
+        if (!table || !lock_phase_table(table)) return;
+
+        PhaseTableEntry& entry = table->entries[entry_index];
+        if (entry.token == entry_token && entry.pid == static_cast<int32_t>(getpid()))
+        {
+            entry.pid = 0;
+            entry.token = 0;
+        }
+
+        pthread_mutex_unlock(&table->mutex);
+    }
+
+    uint64_t PhaseAllocator::Allocation::get_offset()
+    {
+        return offset_ns;
+    }
+}
@@ -1,4 +1,5 @@
 #include "cpm/RTTTool.hpp"
+#include "cpm/VirtualClock.hpp"
 
 /**
  * \file RTTTool.cpp
@@ -111,7 +112,7 @@ std::map<std::string, std::pair<uint64_t, uint64_t>> cpm::RTTTool::measure_rtt()
         }
         ++ wait_count;
 
-        usleep(200000);
+        cpm::VirtualClock::sleep_for_ns(200000000ull);
 
         lock.lock();
     }
@@ -121,7 +122,7 @@ std::map<std::string, std::pair<uint64_t, uint64_t>> cpm::RTTTool::measure_rtt()
     if (wait_count < 10)
     {
         //Also wait another 500ms to get a worse RTT time
-        usleep(500000);
+        cpm::VirtualClock::sleep_for_ns(500000000ull);
 
         if (!lock.owns_lock())
         {
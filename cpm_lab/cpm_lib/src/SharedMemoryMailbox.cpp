@@ -0,0 +1,320 @@
+#include "cpm/SharedMemoryMailbox.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * \file SharedMemoryMailbox.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm {
+
+    //The atomics are shared between processes, which requires them to be lock-free (and thus address-free)
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "SharedMemoryMailbox requires lock-free atomics");
+
+    //! Identifies an initialized mailbox segment
+    static const uint32_t MAILBOX_MAGIC = 0x63706d4d;
+    //! Layout version of the segment, must be increased if Header or Slot change
+    static const uint32_t MAILBOX_VERSION = 1;
+
+    struct SharedMemoryMailbox::Header {
+        //! Set to MAILBOX_MAGIC (release) after the segment was initialized
+        std::atomic<uint32_t> magic;
+        //! Layout version, see MAILBOX_VERSION
+        uint32_t version;
+        //! Number of slots
+        uint64_t slot_count;
+        //! Max. message size of a slot in bytes
+        uint64_t slot_size;
+        //! Distance between two slots in bytes
+        uint64_t slot_stride;
+        //! PID of the creating process
+        std::atomic<int32_t> owner_pid;
+        //! PID of the attached process, or 0
+        std::atomic<int32_t> peer_pid;
+        //! Number of messages written so far = sequence number of the next message
+        std::atomic<uint64_t> write_sequence;
+        //! Changed on each write, used as futex by the waiting reader
+        std::atomic<uint32_t> futex_word;
+        //! Set by the reader while it waits, s.t. the writer can skip the wake-up system call otherwise
+        std::atomic<uint32_t> reader_waiting;
+    };
+
+    struct SharedMemoryMailbox::Slot {
+        //! 2 * sequence + 1 while the message with the given sequence number is written, 2 * sequence + 2 afterwards
+        std::atomic<uint64_t> state;
+        //! Tag of the message
+        uint32_t tag;
+        //! Size of the message in bytes
+        uint32_t size;
+    };
+
+    /**
+     * \brief Round up to a multiple of 64 bytes (cache line size)
+     * \param size Size in bytes
+     * \ingroup cpmlib
+     */
+    static size_t align_to_cache_line(size_t size)
+    {
+        return (size + 63) / 64 * 64;
+    }
+
+    /**
+     * \brief Check if the process with the given PID is running
+     * \param pid The PID
+     * \ingroup cpmlib
+     */
+    static bool is_process_alive(int32_t pid)
+    {
+        return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+    }
+
+    SharedMemoryMailbox::SharedMemoryMailbox(std::string _name, bool _is_owner, void* _memory, size_t _memory_size)
+    :name(_name)
+    ,is_owner(_is_owner)
+    ,memory(_memory)
+    ,memory_size(_memory_size)
+    ,header(static_cast<Header*>(_memory))
+    {
+        if (!is_owner)
+        {
+            //Only messages that are written from now on are relevant for the reader
+            next_read_sequence = header->write_sequence.load(std::memory_order_acquire);
+        }
+    }
+
+    std::shared_ptr<SharedMemoryMailbox> SharedMemoryMailbox::create(std::string name, size_t slot_count, size_t slot_size)
+    {
+        if (slot_count == 0 || slot_size == 0 || slot_size > UINT32_MAX) return nullptr;
+
+        size_t header_size = align_to_cache_line(sizeof(Header));
+        size_t slot_stride = align_to_cache_line(sizeof(Slot) + slot_size);
+        size_t memory_size = header_size + slot_count * slot_stride;
+
+        //Remove segments of processes that did not shut down properly
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return nullptr;
+
+        if (ftruncate(fd, static_cast<off_t>(memory_size)) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+
+        void* memory = mmap(nullptr, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+
+        //The segment is zero-initialized, which is a valid state for all slots (no message written yet)
+        Header* header = new (memory) Header();
+        header->version = MAILBOX_VERSION;
+        header->slot_count = slot_count;
+        header->slot_size = slot_size;
+        header->slot_stride = slot_stride;
+        header->owner_pid.store(static_cast<int32_t>(getpid()));
+        header->peer_pid.store(0);
+        header->write_sequence.store(0);
+        header->futex_word.store(0);
+        header->reader_waiting.store(0);
+        for (size_t i = 0; i < slot_count; ++i)
+        {
+            new (static_cast<char*>(memory) + header_size + i * slot_stride) Slot();
+        }
+        header->magic.store(MAILBOX_MAGIC, std::memory_order_release);
+
+        return std::shared_ptr<SharedMemoryMailbox>(new SharedMemoryMailbox(name, true, memory, memory_size));
+    }
+
+    std::shared_ptr<SharedMemoryMailbox> SharedMemoryMailbox::open(std::string name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0) return nullptr;
+
+        struct stat segment_stat;
+        if (fstat(fd, &segment_stat) != 0 || static_cast<size_t>(segment_stat.st_size) < sizeof(Header))
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        size_t memory_size = static_cast<size_t>(segment_stat.st_size);
+        void* memory = mmap(nullptr, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) return nullptr;
+
+        //Check that the segment is initialized, compatible and still in use
+        Header* header = static_cast<Header*>(memory);
+        bool valid = header->magic.load(std::memory_order_acquire) == MAILBOX_MAGIC
+            && header->version == MAILBOX_VERSION
+            && align_to_cache_line(sizeof(Header)) + header->slot_count * header->slot_stride == memory_size
+            && is_process_alive(header->owner_pid.load());
+        if (!valid)
+        {
+            munmap(memory, memory_size);
+            return nullptr;
+        }
+
+        return std::shared_ptr<SharedMemoryMailbox>(new SharedMemoryMailbox(name, false, memory, memory_size));
+    }
+
+    SharedMemoryMailbox::~SharedMemoryMailbox()
+    {
+        if (!is_owner && header->peer_pid.load() == static_cast<int32_t>(getpid()))
+        {
+            header->peer_pid.store(0);
+        }
+
+        munmap(memory, memory_size);
+
+        if (is_owner)
+        {
+            shm_unlink(name.c_str());
+        }
+    }
+
+    SharedMemoryMailbox::Slot* SharedMemoryMailbox::get_slot(uint64_t sequence)
+    {
+        char* slots = static_cast<char*>(memory) + align_to_cache_line(sizeof(Header));
+        return reinterpret_cast<Slot*>(slots + (sequence % header->slot_count) * header->slot_stride);
+    }
+
+    bool SharedMemoryMailbox::write(uint32_t tag, const char* data, size_t size)
+    {
+        if (size > header->slot_size) return false;
+
+        std::lock_guard<std::mutex> lock(write_mutex);
+
+        uint64_t sequence = header->write_sequence.load(std::memory_order_relaxed);
+        Slot* slot = get_slot(sequence);
+
+        //Seqlock: Mark the slot as being written, s.t. a reader of an older message in this slot notices the overwrite
+        slot->state.store(2 * sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->tag = tag;
+        slot->size = static_cast<uint32_t>(size);
+        memcpy(reinterpret_cast<char*>(slot) + sizeof(Slot), data, size);
+        slot->state.store(2 * sequence + 2, std::memory_order_release);
+
+        header->write_sequence.store(sequence + 1, std::memory_order_seq_cst);
+
+        //Wake up the reader (only if it waits, to save the system call)
+        header->futex_word.fetch_add(1, std::memory_order_seq_cst);
+        if (header->reader_waiting.load(std::memory_order_seq_cst) != 0)
+        {
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header->futex_word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+        }
+
+        return true;
+    }
+
+    bool SharedMemoryMailbox::read(uint32_t& tag, std::vector<char>& data, uint64_t timeout_ns)
+    {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t start_ns = static_cast<uint64_t>(start.tv_sec) * 1000000000ull + static_cast<uint64_t>(start.tv_nsec);
+
+        while (true)
+        {
+            uint64_t write_sequence = header->write_sequence.load(std::memory_order_seq_cst);
+
+            if (write_sequence > next_read_sequence)
+            {
+                //Skip messages that were already overwritten
+                if (write_sequence - next_read_sequence > header->slot_count)
+                {
+                    lost_messages += write_sequence - header->slot_count - next_read_sequence;
+                    next_read_sequence = write_sequence - header->slot_count;
+                }
+
+                Slot* slot = get_slot(next_read_sequence);
+                uint64_t state = slot->state.load(std::memory_order_acquire);
+                if (state != 2 * next_read_sequence + 2)
+                {
+                    //Overwritten by a newer message in the meantime, try again with the current write sequence
+                    continue;
+                }
+
+                uint32_t size = slot->size;
+                if (size > header->slot_size)
+                {
+                    continue;
+                }
+                tag = slot->tag;
+                data.resize(size);
+                memcpy(data.data(), reinterpret_cast<char*>(slot) + sizeof(Slot), size);
+
+                //The slot must not have changed while it was copied
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot->state.load(std::memory_order_relaxed) != state)
+                {
+                    continue;
+                }
+
+                ++next_read_sequence;
+                return true;
+            }
+
+            //No new message - wait until one is written or the timeout is reached
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            uint64_t now_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+            if (now_ns - start_ns >= timeout_ns)
+            {
+                return false;
+            }
+            uint64_t remaining_ns = timeout_ns - (now_ns - start_ns);
+            struct timespec remaining;
+            remaining.tv_sec = static_cast<time_t>(remaining_ns / 1000000000ull);
+            remaining.tv_nsec = static_cast<long>(remaining_ns % 1000000000ull);
+
+            uint32_t futex_value = header->futex_word.load(std::memory_order_seq_cst);
+            header->reader_waiting.store(1, std::memory_order_seq_cst);
+            if (header->write_sequence.load(std::memory_order_seq_cst) == write_sequence)
+            {
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header->futex_word), FUTEX_WAIT, futex_value, &remaining, nullptr, 0);
+            }
+            header->reader_waiting.store(0, std::memory_order_seq_cst);
+        }
+    }
+
+    uint64_t SharedMemoryMailbox::get_write_sequence()
+    {
+        return header->write_sequence.load(std::memory_order_acquire);
+    }
+
+    uint64_t SharedMemoryMailbox::get_lost_messages()
+    {
+        return lost_messages;
+    }
+
+    void SharedMemoryMailbox::attach()
+    {
+        header->peer_pid.store(static_cast<int32_t>(getpid()));
+    }
+
+    bool SharedMemoryMailbox::is_peer_attached()
+    {
+        return is_process_alive(header->peer_pid.load());
+    }
+
+    bool SharedMemoryMailbox::is_owner_alive()
+    {
+        return is_process_alive(header->owner_pid.load());
+    }
+}
@@ -44,7 +44,7 @@ namespace cpm {
             }
             else
             {
-                cpm::Logging::Instance().write(
+                CPM_LOG(
                     2, 
                     "%s", 
                     "Callback function for simple timer is undefined!"
@@ -34,7 +34,7 @@ namespace cpm {
         std::map<std::string, MeasurementData>::iterator it = measurements.find(name);
         if (it == measurements.end()){
             // Element not existing. Log warning and return 0.
-            cpm::Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "Warning: Tried to stop a non-existing time measurement by name %s",
                 name.c_str()
@@ -26,7 +26,7 @@ std::shared_ptr<Timer> Timer::create(
         return std::make_shared<TimerSimulated>(node_id, period_nanoseconds, offset_nanoseconds);
     }
     else if (simulated_time && !simulated_time_allowed) {
-        Logging::Instance().write(
+        CPM_LOG(
             1,
             "%s", 
             "Timer Error: simulated time requested but not allowed."
@@ -41,5 +41,34 @@ std::shared_ptr<Timer> Timer::create(
     }
 }
 
+std::shared_ptr<Timer> Timer::create_staggered(
+    std::string node_id,
+    uint64_t period_nanoseconds,
+    uint64_t compute_nanoseconds,
+    PhaseAllocator::Stage stage,
+    bool wait_for_start,
+    bool simulated_time_allowed,
+    bool simulated_time
+)
+{
+    if (simulated_time) {
+        return create(node_id, period_nanoseconds, 0, wait_for_start, simulated_time_allowed, simulated_time);
+    }
+
+    auto allocation = PhaseAllocator::allocate(node_id, period_nanoseconds, compute_nanoseconds, stage);
+    auto timer = create(node_id, period_nanoseconds, allocation->get_offset(), wait_for_start, simulated_time_allowed, simulated_time);
+    timer->phase_allocation = allocation;
 
-}
\ No newline at end of file
+    CPM_LOG(
+        3,
+        "Timer %s: Allocated offset %llu ns (period %llu ns)", 
+        node_id.c_str(),
+        static_cast<unsigned long long>(allocation->get_offset()),
+        static_cast<unsigned long long>(period_nanoseconds)
+    );
+
+    return timer;
+}
+
+
+}
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include "cpm/get_topic.hpp"
 #include "cpm/TimeMeasurement.hpp"
+#include "cpm/VirtualClock.hpp"
 
 /**
  * \file TimerFD.cpp
@@ -36,7 +37,7 @@ namespace cpm {
     {
         //Offset must be smaller than period
         if (offset_nanoseconds >= period_nanoseconds) {
-            Logging::Instance().write(
+            CPM_LOG(
                 1,
                 "%s", 
                 "TimerFD: Offset set higher than period."
@@ -57,7 +58,7 @@ namespace cpm {
         // Timer setup
         timer_fd = timerfd_create(CLOCK_REALTIME, 0);
         if (timer_fd == -1) {
-            Logging::Instance().write(
+            CPM_LOG(
                 1,
                 "%s", 
                 "TimerFD: Call to timerfd_create failed."
@@ -74,14 +75,18 @@ namespace cpm {
             offset_nanoseconds_fd = 1;
         }
 
+        armTimer(offset_nanoseconds_fd);
+    }
+
+    void TimerFD::armTimer(uint64_t first_expiration) {
         struct itimerspec its;
-        its.it_value.tv_sec     = offset_nanoseconds_fd / 1000000000ull;
-        its.it_value.tv_nsec    = offset_nanoseconds_fd % 1000000000ull;
+        its.it_value.tv_sec     = first_expiration / 1000000000ull;
+        its.it_value.tv_nsec    = first_expiration % 1000000000ull;
         its.it_interval.tv_sec  = period_nanoseconds / 1000000000ull;
         its.it_interval.tv_nsec = period_nanoseconds % 1000000000ull;
         int status = timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
         if (status != 0) {
-            Logging::Instance().write(
+            CPM_LOG(
                 1,
                 "TimerFD: Call to timer_settime returned error status (%d).", 
                 status
@@ -92,12 +97,27 @@ namespace cpm {
         }
     }
 
-    void TimerFD::wait()
+    void TimerFD::wait(uint64_t deadline)
     {
+        if (virtual_time)
+        {
+            VirtualClock& virtual_clock = VirtualClock::Instance();
+            if (!virtual_clock.sleep_until(deadline, active) && !virtual_clock.is_enabled())
+            {
+                CPM_LOG(
+                    1,
+                    "%s", 
+                    "TimerFD: The virtual clock was disabled while the timer was running, the timer is stopped."
+                );
+                active.store(false);
+            }
+            return;
+        }
+
         unsigned long long missed;
         int status = read(timer_fd, &missed, sizeof(missed));
         if(status != sizeof(missed)) {
-            Logging::Instance().write(
+            CPM_LOG(
                 1,
                 "TimerFD: Error: read(timerfd), status %d.", 
                 status
@@ -132,10 +152,37 @@ namespace cpm {
         return stop_signal;
     }
 
+    /**
+     * \brief Registers the thread of a timer as participant of the virtual clock while the timer runs
+     * \ingroup cpmlib
+     */
+    struct VirtualClockParticipation
+    {
+        //! If the thread was registered
+        const bool registered;
+
+        /**
+         * \brief Register the calling thread if the timer runs in virtual time
+         * \param virtual_time If the timer runs in virtual time
+         */
+        explicit VirtualClockParticipation(bool virtual_time) : registered(virtual_time)
+        {
+            if (registered) VirtualClock::Instance().register_participant();
+        }
+
+        ~VirtualClockParticipation()
+        {
+            if (registered) VirtualClock::Instance().unregister_participant();
+        }
+    };
+
     void TimerFD::start(std::function<void(uint64_t t_now)> update_callback)
     {
+        virtual_time = VirtualClock::Instance().is_enabled();
+        VirtualClockParticipation participation(virtual_time);
+
         if(active.load()) {
-            Logging::Instance().write(
+            CPM_LOG(
             2,
             "%s", 
             "TimerFD: The cpm::Timer can not be started twice."
@@ -153,7 +200,10 @@ namespace cpm {
         m_update_callback = update_callback;
 
         //Create the timer (so that they operate in sync)
-        createTimer();
+        if (!virtual_time)
+        {
+            createTimer();
+        }
 
         //Send ready signal, wait for start signal
         uint64_t deadline;
@@ -179,25 +229,42 @@ namespace cpm {
         start_point_initialized = true;
 
         while(active.load()) {
-            this->wait();
+            this->wait(deadline);
             if(this->get_time() >= deadline) {
                 if(m_update_callback) m_update_callback(deadline);
 
-                deadline += period_nanoseconds;
-
-                uint64_t current_time = this->get_time();
+                uint64_t requested_period = requested_period_nanoseconds.exchange(0);
+                if (requested_period != 0 && requested_period != period_nanoseconds)
+                {
+                    //Period change: Continue with the next timestep that is aligned to the new period
+                    period_nanoseconds = requested_period;
+                    offset_nanoseconds = offset_nanoseconds % period_nanoseconds;
 
-                //Error if deadline was missed, correction to next deadline
-                if (current_time >= deadline)
+                    uint64_t current_time = this->get_time();
+                    deadline = (((current_time - offset_nanoseconds) / period_nanoseconds) + 1) * period_nanoseconds + offset_nanoseconds;
+                    if (!virtual_time)
+                    {
+                        armTimer(deadline);
+                    }
+                }
+                else
                 {
-                    Logging::Instance().write(
-                        1,
-                        "TimerFD: Periods missed: %d", 
-                        static_cast<int>(((current_time - deadline) / period_nanoseconds) + 1)
-                    );
-                    Logging::Instance().write(1,"%s", TimeMeasurement::Instance().get_str().c_str());
-
-                    deadline += (((current_time - deadline)/period_nanoseconds) + 1)*period_nanoseconds;
+                    deadline += period_nanoseconds;
+
+                    uint64_t current_time = this->get_time();
+
+                    //Error if deadline was missed, correction to next deadline
+                    if (current_time >= deadline)
+                    {
+                        CPM_LOG(
+                            1,
+                            "TimerFD: Periods missed: %d", 
+                            static_cast<int>(((current_time - deadline) / period_nanoseconds) + 1)
+                        );
+                        CPM_LOG(1,"%s", TimeMeasurement::Instance().get_str().c_str());
+
+                        deadline += (((current_time - deadline)/period_nanoseconds) + 1)*period_nanoseconds;
+                    }
                 }
 
                 if (received_stop_signal()) {
@@ -214,7 +281,10 @@ namespace cpm {
             }
         }
 
-        close(timer_fd);
+        if (!virtual_time)
+        {
+            close(timer_fd);
+        }
     }
 
     void TimerFD::start(std::function<void(uint64_t t_now)> update_callback, std::function<void()> stop_callback)
@@ -228,13 +298,20 @@ namespace cpm {
         if(!runner_thread.joinable())
         {
             m_update_callback = update_callback;
+
+            //The virtual clock must wait for the new thread before it advances
+            if (VirtualClock::Instance().is_enabled())
+            {
+                VirtualClock::Instance().announce_participant();
+            }
+
             runner_thread = std::thread([this](){
                 this->start(m_update_callback);
             });
         }
         else
         {
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "%s", 
                 "TimerFD: The cpm::Timer can not be started twice."
@@ -255,6 +332,12 @@ namespace cpm {
 
         cancelled.store(true);
         active.store(false);
+
+        //Wake the timer thread if it sleeps in virtual time
+        if (VirtualClock::Instance().is_enabled())
+        {
+            VirtualClock::Instance().interrupt();
+        }
         
         if(runner_thread.joinable())
         {
@@ -270,6 +353,12 @@ namespace cpm {
 
         cancelled.store(true);
         active.store(false);
+
+        //Wake the timer thread if it sleeps in virtual time
+        if (VirtualClock::Instance().is_enabled())
+        {
+            VirtualClock::Instance().interrupt();
+        }
         
         if(runner_thread.joinable())
         {
@@ -282,6 +371,14 @@ namespace cpm {
     }
 
 
+    bool TimerFD::set_period(uint64_t _period_nanoseconds)
+    {
+        if (_period_nanoseconds == 0) return false;
+
+        requested_period_nanoseconds.store(_period_nanoseconds);
+        return true;
+    }
+
     uint64_t TimerFD::get_time()
     {
         return cpm::get_time_ns();
@@ -89,7 +89,7 @@ namespace cpm {
     void TimerSimulated::start(std::function<void(uint64_t t_now)> update_callback)
     {
         if(active.load()) {
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "%s", 
                 "TimerSimulated: The cpm::Timer can not be started twice."
@@ -150,7 +150,7 @@ namespace cpm {
         }
         else
         {
-            Logging::Instance().write(
+            CPM_LOG(
                 2,
                 "%s", 
                 "TimerSimulated: The cpm::Timer can not be started twice."
@@ -0,0 +1,77 @@
+#include "cpm/TimestepDeadline.hpp"
+#include "cpm/get_time_ns.hpp"
+
+#include <algorithm>
+
+/**
+ * \file TimestepDeadline.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm
+{
+    TimestepDeadline::TimestepDeadline(uint64_t _start_ns, uint64_t _deadline_ns)
+    :start_ns(_start_ns)
+    ,deadline_ns(std::max(_start_ns, _deadline_ns))
+    ,cancelled(false)
+    {
+    }
+
+    std::shared_ptr<TimestepDeadline> TimestepDeadline::from_period(uint64_t t_now, uint64_t period_ns, uint64_t margin_ns, uint64_t now_ns)
+    {
+        //The time that has already passed since the start of the period counts against the budget, if it can be determined
+        uint64_t start = now_ns;
+        if (now_ns >= t_now && now_ns - t_now < period_ns)
+        {
+            start = t_now;
+        }
+
+        uint64_t margin = std::min(margin_ns, period_ns / 2);
+        return std::make_shared<TimestepDeadline>(start, start + period_ns - margin);
+    }
+
+    uint64_t TimestepDeadline::get_start()
+    {
+        return start_ns;
+    }
+
+    uint64_t TimestepDeadline::get_deadline()
+    {
+        return deadline_ns;
+    }
+
+    uint64_t TimestepDeadline::get_budget()
+    {
+        return deadline_ns - start_ns;
+    }
+
+    uint64_t TimestepDeadline::get_remaining(uint64_t now_ns)
+    {
+        if (cancelled.load() || now_ns >= deadline_ns)
+        {
+            return 0;
+        }
+        return deadline_ns - now_ns;
+    }
+
+    uint64_t TimestepDeadline::get_remaining()
+    {
+        return get_remaining(cpm::get_time_ns());
+    }
+
+    bool TimestepDeadline::has_time_for(uint64_t duration_ns)
+    {
+        uint64_t remaining = get_remaining();
+        return remaining > 0 && remaining >= duration_ns;
+    }
+
+    void TimestepDeadline::cancel()
+    {
+        cancelled.store(true);
+    }
+
+    bool TimestepDeadline::is_cancelled()
+    {
+        return get_remaining() == 0;
+    }
+}
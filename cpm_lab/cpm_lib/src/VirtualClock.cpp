@@ -0,0 +1,218 @@
+#include "cpm/VirtualClock.hpp"
+
+#include <chrono>
+#include <limits>
+
+/**
+ * \file VirtualClock.cpp
+ * \ingroup cpmlib
+ */
+
+namespace cpm {
+
+    VirtualClock::VirtualClock()
+    {
+        enabled.store(false);
+        now_ns.store(0);
+    }
+
+    VirtualClock& VirtualClock::Instance()
+    {
+        // Thread-safe in C++11
+        static VirtualClock myInstance;
+        return myInstance;
+    }
+
+    void VirtualClock::enable(uint64_t start_time_ns, bool _auto_advance)
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex);
+        now_ns.store(start_time_ns);
+        auto_advance = _auto_advance;
+        enabled.store(true);
+    }
+
+    void VirtualClock::disable()
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex);
+        enabled.store(false);
+        auto_advance = false;
+        clock_condition.notify_all();
+    }
+
+    bool VirtualClock::is_enabled() const
+    {
+        return enabled.load();
+    }
+
+    uint64_t VirtualClock::now() const
+    {
+        return now_ns.load();
+    }
+
+    bool VirtualClock::wake_next_sleeper(uint64_t limit_ns)
+    {
+        if (sleepers.empty()) return false;
+
+        auto next = sleepers.begin();
+        uint64_t wake_up_time = next->first.first;
+        if (wake_up_time > limit_ns) return false;
+
+        if (wake_up_time > now_ns.load())
+        {
+            now_ns.store(wake_up_time);
+        }
+
+        //The woken participant runs until it sleeps again
+        if (next->second)
+        {
+            ++running_participants;
+        }
+        sleepers.erase(next);
+
+        clock_condition.notify_all();
+        return true;
+    }
+
+    void VirtualClock::advance_if_idle()
+    {
+        if (!auto_advance || participants.empty()) return;
+
+        //Non-participants are woken on the way, but the clock does not wait for them
+        while (running_participants == 0 && !sleepers.empty())
+        {
+            bool is_participant = sleepers.begin()->second;
+            wake_next_sleeper(std::numeric_limits<uint64_t>::max());
+            if (is_participant) break;
+        }
+    }
+
+    void VirtualClock::advance(uint64_t duration_ns)
+    {
+        advance_to(now_ns.load() + duration_ns);
+    }
+
+    void VirtualClock::advance_to(uint64_t time_ns)
+    {
+        std::unique_lock<std::mutex> lock(clock_mutex);
+
+        //A participant may advance the clock as well, but then it does not sleep itself
+        size_t own_count = participants.count(std::this_thread::get_id());
+
+        while (true)
+        {
+            clock_condition.wait(lock, [&](){
+                return !enabled.load() || running_participants <= own_count;
+            });
+
+            if (!enabled.load()) return;
+
+            if (!wake_next_sleeper(time_ns)) break;
+        }
+
+        if (time_ns > now_ns.load())
+        {
+            now_ns.store(time_ns);
+        }
+    }
+
+    bool VirtualClock::sleep_until(uint64_t time_ns)
+    {
+        std::atomic_bool keep_sleeping;
+        keep_sleeping.store(true);
+        return sleep_until(time_ns, keep_sleeping);
+    }
+
+    bool VirtualClock::sleep_until(uint64_t time_ns, const std::atomic_bool& keep_sleeping)
+    {
+        std::unique_lock<std::mutex> lock(clock_mutex);
+        if (!enabled.load()) return false;
+        if (time_ns <= now_ns.load()) return true;
+
+        bool is_participant = (participants.count(std::this_thread::get_id()) > 0);
+        auto key = std::make_pair(time_ns, next_sleeper_id++);
+        sleepers[key] = is_participant;
+
+        if (is_participant)
+        {
+            --running_participants;
+            clock_condition.notify_all();
+            advance_if_idle();
+        }
+
+        clock_condition.wait(lock, [&](){
+            return !enabled.load() || !keep_sleeping.load() || sleepers.count(key) == 0;
+        });
+
+        //If the sleeper was not woken by the clock, it must remove itself
+        bool woken = (sleepers.count(key) == 0);
+        if (!woken)
+        {
+            sleepers.erase(key);
+            if (is_participant)
+            {
+                ++running_participants;
+            }
+        }
+
+        return woken;
+    }
+
+    void VirtualClock::interrupt()
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex);
+        clock_condition.notify_all();
+    }
+
+    void VirtualClock::announce_participant()
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex);
+        ++announced_participants;
+        ++running_participants;
+    }
+
+    void VirtualClock::register_participant()
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex);
+        if (!participants.insert(std::this_thread::get_id()).second) return;
+
+        //An announced participant is already counted as running
+        if (announced_participants > 0)
+        {
+            --announced_participants;
+        }
+        else
+        {
+            ++running_participants;
+        }
+    }
+
+    void VirtualClock::unregister_participant()
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex);
+        if (participants.erase(std::this_thread::get_id()) == 0) return;
+
+        --running_participants;
+        clock_condition.notify_all();
+        advance_if_idle();
+    }
+
+    size_t VirtualClock::get_sleeper_count()
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex);
+        return sleepers.size();
+    }
+
+    void VirtualClock::sleep_for_ns(uint64_t duration_ns)
+    {
+        VirtualClock& clock = VirtualClock::Instance();
+        if (clock.is_enabled())
+        {
+            clock.sleep_until(clock.now() + duration_ns);
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(duration_ns));
+        }
+    }
+
+}
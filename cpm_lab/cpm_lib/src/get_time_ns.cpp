@@ -1,4 +1,5 @@
 #include "cpm/get_time_ns.hpp"
+#include "cpm/VirtualClock.hpp"
 
 /**
  * \file get_time_ns.cpp
@@ -6,6 +7,12 @@
  */
 
 uint64_t cpm::get_time_ns(clockid_t clockid) {
+    //In tests, all clocks may be replaced by the virtual clock
+    VirtualClock& virtual_clock = VirtualClock::Instance();
+    if (virtual_clock.is_enabled()) {
+        return virtual_clock.now();
+    }
+
     struct timespec t;
     clock_gettime(clockid, &t);
     return uint64_t(t.tv_sec) * 1000000000ull + uint64_t(t.tv_nsec);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "cpm/VirtualClock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/**
+ * \class VirtualClockDriver
+ * \brief For tests of code that polls in virtual time (see cpm::VirtualClock::sleep_for_ns) without being a participant of the clock,
+ * e.g. RTTTool and ParameterReceiver, which wait for DDS answers: Enables the clock and, whenever a thread sleeps in it,
+ * lets the virtual time pass after a short pause in real time, s.t. DDS messages can still arrive in between.
+ * The clock is disabled again when the driver is destroyed, also if a REQUIRE failed.
+ * \ingroup cpmlib
+ */
+class VirtualClockDriver
+{
+    //! Stop condition for driver_thread
+    std::atomic_bool running;
+    //! Thread that advances the virtual time
+    std::thread driver_thread;
+
+public:
+    /**
+     * \brief Enable the virtual clock and start advancing it
+     * \param start_time_ns Initial virtual time
+     * \param step_ns Virtual time that passes with each step, should be at least the longest poll interval of the tested code
+     * \param pause_ms Real time between two steps
+     */
+    VirtualClockDriver(uint64_t start_time_ns, uint64_t step_ns = 1000000000ull, uint64_t pause_ms = 1)
+    {
+        running.store(true);
+        cpm::VirtualClock::Instance().enable(start_time_ns);
+
+        driver_thread = std::thread([this, step_ns, pause_ms](){
+            cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+            while (running.load())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(pause_ms));
+                if (clock.get_sleeper_count() > 0) clock.advance(step_ns);
+            }
+        });
+    }
+
+    VirtualClockDriver(const VirtualClockDriver&) = delete;
+    VirtualClockDriver& operator=(const VirtualClockDriver&) = delete;
+
+    /**
+     * \brief Stop advancing and disable the virtual clock, which also wakes all remaining sleepers
+     */
+    ~VirtualClockDriver()
+    {
+        running.store(false);
+        if (driver_thread.joinable()) driver_thread.join();
+        cpm::VirtualClock::Instance().disable();
+    }
+};
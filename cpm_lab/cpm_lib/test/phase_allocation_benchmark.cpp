@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "cpm/CommandLineReader.hpp"
+#include "cpm/PhaseAllocator.hpp"
+#include "cpm/get_time_ns.hpp"
+
+/**
+ * \file phase_allocation_benchmark.cpp
+ * \brief Shows the effect of the phase allocation (cpm::PhaseAllocator) on the response times of periodic nodes that share a CPU:
+ * Several nodes with the same period (each a thread with an absolute timerfd, like cpm::TimerFD) busy-wait for their computation time
+ * in each period, once all with offset 0 and once with allocated offsets. The response time is the time from the scheduled
+ * wake-up until the computation of the period is finished.
+ * Usage: ./phase_allocation_benchmark --nodes=8 --period_ms=50 --compute_us=3000 --periods=100 --cpus=1
+ * \ingroup cpmlib
+ */
+
+/**
+ * \brief Run a periodic node: Wake up at offset + k * period, then compute (busy wait) and measure the response time
+ * \param period_ns Period in ns
+ * \param offset_ns Offset in ns
+ * \param compute_ns Computation time per period in ns
+ * \param periods Number of periods
+ * \param response_times_out The response times in ns are appended here
+ * \ingroup cpmlib
+ */
+static void run_node(uint64_t period_ns, uint64_t offset_ns, uint64_t compute_ns, int periods, std::vector<uint64_t>& response_times_out)
+{
+    int timer_fd = timerfd_create(CLOCK_REALTIME, 0);
+
+    //First deadline: Next multiple of the period (plus offset), at least one period from now
+    uint64_t deadline = ((cpm::get_time_ns() / period_ns) + 2) * period_ns + offset_ns;
+    struct itimerspec its;
+    its.it_value.tv_sec = deadline / 1000000000ull;
+    its.it_value.tv_nsec = deadline % 1000000000ull;
+    its.it_interval.tv_sec = period_ns / 1000000000ull;
+    its.it_interval.tv_nsec = period_ns % 1000000000ull;
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+
+    for (int i = 0; i < periods; ++i)
+    {
+        uint64_t missed = 0;
+        if (read(timer_fd, &missed, sizeof(missed)) != sizeof(missed)) break;
+
+        //Measure from the latest expiration if periods were missed
+        deadline += (missed - 1) * period_ns;
+
+        //Computation of the period (CPU time, s.t. the nodes compete for the CPU)
+        uint64_t cpu_start = cpm::get_time_ns(CLOCK_THREAD_CPUTIME_ID);
+        while (cpm::get_time_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start < compute_ns) {}
+
+        response_times_out.push_back(cpm::get_time_ns() - deadline);
+        deadline += period_ns;
+    }
+
+    close(timer_fd);
+}
+
+/**
+ * \brief Run all nodes concurrently and print statistics of their response times
+ * \param name Name of the configuration
+ * \param period_ns Period in ns
+ * \param offsets Offset of each node in ns
+ * \param compute_ns Computation time per period in ns
+ * \param periods Number of periods
+ * \ingroup cpmlib
+ */
+static void run_configuration(std::string name, uint64_t period_ns, const std::vector<uint64_t>& offsets, uint64_t compute_ns, int periods)
+{
+    std::vector<std::vector<uint64_t>> response_times(offsets.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < offsets.size(); ++i)
+    {
+        threads.push_back(std::thread(run_node, period_ns, offsets.at(i), compute_ns, periods, std::ref(response_times.at(i))));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<uint64_t> all_times;
+    for (auto& times : response_times)
+    {
+        all_times.insert(all_times.end(), times.begin(), times.end());
+    }
+    if (all_times.empty()) return;
+    std::sort(all_times.begin(), all_times.end());
+
+    std::cout << name << " response times (us, " << all_times.size() << " samples):"
+        << " median " << all_times.at(all_times.size() / 2) / 1000.0
+        << ", p99 " << all_times.at(all_times.size() * 99 / 100) / 1000.0
+        << ", max " << all_times.back() / 1000.0
+        << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int nodes = cpm::cmd_parameter_int("nodes", 8, argc, argv);
+    uint64_t period_ns = cpm::cmd_parameter_uint64_t("period_ms", 50, argc, argv) * 1000000ull;
+    uint64_t compute_ns = cpm::cmd_parameter_uint64_t("compute_us", 3000, argc, argv) * 1000ull;
+    int periods = cpm::cmd_parameter_int("periods", 100, argc, argv);
+    int cpus = cpm::cmd_parameter_int("cpus", 1, argc, argv);
+
+    //Restrict the process to few CPUs, like a busy NUC / LCC machine
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu = 0; cpu < cpus; ++cpu)
+    {
+        CPU_SET(cpu, &cpu_set);
+    }
+    sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+
+    std::cout << nodes << " nodes, period " << period_ns / 1000000 << " ms, computation " << compute_ns / 1000 << " us, "
+        << cpus << " CPU(s), " << periods << " periods" << std::endl;
+
+    run_configuration("Offset 0", period_ns, std::vector<uint64_t>(nodes, 0), compute_ns, periods);
+
+    //Allocated offsets (own table, s.t. the nodes of the machine are not affected)
+    std::string table_name = "/cpm_phase_allocation_benchmark_" + std::to_string(getpid());
+    std::vector<std::shared_ptr<cpm::PhaseAllocator::Allocation>> allocations;
+    std::vector<uint64_t> offsets;
+    for (int i = 0; i < nodes; ++i)
+    {
+        allocations.push_back(cpm::PhaseAllocator::allocate("node_" + std::to_string(i), period_ns, compute_ns, cpm::PhaseAllocator::StageAny, table_name));
+        offsets.push_back(allocations.back()->get_offset());
+    }
+    run_configuration("Allocated offsets", period_ns, offsets, compute_ns, periods);
+
+    allocations.clear();
+    shm_unlink(table_name.c_str());
+
+    return 0;
+}
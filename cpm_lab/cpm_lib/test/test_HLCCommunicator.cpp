@@ -100,7 +100,7 @@ TEST_CASE( "HLCCommunicator" ) {
             abort_timestep.store(false);
             hlc_timestep++;
 
-            cpm::Logging::Instance().write(1,
+            CPM_LOG(1,
                     "HLC planning timestep %i",
                     hlc_timestep);
 
@@ -111,13 +111,13 @@ TEST_CASE( "HLCCommunicator" ) {
             REQUIRE( period_ms == vehicle_state_list.period_ms() );
 
             if( hlc_timestep == timestep_to_test_cancel ) {
-                cpm::Logging::Instance().write(1,
+                CPM_LOG(1,
                         "%s",
                         "Testing onCancelTimestep");
                 while(!abort_timestep.load()){
                     std::this_thread::sleep_for(std::chrono::milliseconds(5));
                 }
-                cpm::Logging::Instance().write(1,
+                CPM_LOG(1,
                         "%s",
                         "Finished testing onCancelTimestep");
             }
@@ -130,14 +130,14 @@ TEST_CASE( "HLCCommunicator" ) {
             // Check that the timer timestep is one past the hlc_timestep, so we had reason to cancel
             REQUIRE( timestep_to_test_cancel + 1 == (timer_timestep.load() + 1 - first_timer_timestep.load()));
 
-            cpm::Logging::Instance().write(1,
+            CPM_LOG(1,
                     "HLC cancelling timestep %i",
                     hlc_timestep);
             });
 
     hlc_communicator.onStop([&]{
             REQUIRE( hlc_timestep == timestep_to_test_stop );
-            cpm::Logging::Instance().write(1,
+            CPM_LOG(1,
                     "%s",
                     "HLC stopping");
             });
@@ -161,12 +161,12 @@ TEST_CASE( "HLCCommunicator" ) {
 
             timer_timestep++;
 
-            cpm::Logging::Instance().write(1,
+            CPM_LOG(1,
                     "Timer at timestep %i",
                     timer_timestep.load());
 
             for( auto sample : reader_readyStatus.take()){
-                cpm::Logging::Instance().write(1,
+                CPM_LOG(1,
                         "Mock middleware received ready message from %s",
                         sample.source_id().c_str());
                 if( sample.source_id() == std::string("hlc_")+std::to_string(vehicle_id) ) {
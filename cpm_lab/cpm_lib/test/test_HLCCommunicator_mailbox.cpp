@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "cpm/HLCCommunicator.hpp"
+#include "cpm/HLCMailbox.hpp"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * \test Tests that HLCCommunicator notices a restart of the middleware on the same machine:
+ * The first middleware is a child process that is killed, which leaves its local mailbox behind. Commands must then be sent
+ * via DDS and, once the middleware was restarted (here: by this process), via the mailbox of the new middleware.
+ * \ingroup cpmlib
+ */
+TEST_CASE( "HLCCommunicator_mailbox_middleware_restart" ) {
+    const int middleware_domain = 7; //Arbitrary
+    const uint8_t vehicle_id = 23; //Arbitrary
+    const std::vector<uint8_t> vehicle_ids = { vehicle_id };
+
+    //First middleware, in a child process s.t. it can be killed
+    int ready_pipe[2];
+    REQUIRE( pipe(ready_pipe) == 0 );
+    pid_t first_middleware = fork();
+    REQUIRE( first_middleware >= 0 );
+    if (first_middleware == 0)
+    {
+        auto mailbox = cpm::HLCMailbox::create(middleware_domain, vehicle_ids);
+        char created = mailbox ? 1 : 0;
+        if (write(ready_pipe[1], &created, 1) != 1) _exit(1);
+        while (true) pause();
+    }
+    char created = 0;
+    REQUIRE( read(ready_pipe[0], &created, 1) == 1 );
+    close(ready_pipe[0]);
+    close(ready_pipe[1]);
+    REQUIRE( created == 1 );
+
+    HLCCommunicator hlc_communicator(vehicle_id, middleware_domain, "../test/QOS_TEST.xml", "TESTLibrary::TEST"); //The path depends on from where the program is called
+
+    //Attaches to the mailbox of the first middleware
+    hlc_communicator.sendCommand(VehicleCommandTrajectory(vehicle_id, Header(TimeStamp(1), TimeStamp(1)), {}));
+
+    //The first middleware crashes and does not remove its mailbox
+    kill(first_middleware, SIGKILL);
+    waitpid(first_middleware, nullptr, 0);
+
+    //No middleware runs on this machine, so DDS must be used
+    REQUIRE_NOTHROW( hlc_communicator.sendCommand(VehicleCommandTrajectory(vehicle_id, Header(TimeStamp(2), TimeStamp(2)), {})) );
+
+    //The restarted middleware creates a new mailbox; the HLC retries to open it about once per second
+    auto restarted_middleware = cpm::HLCMailbox::create(middleware_domain, vehicle_ids);
+    REQUIRE( restarted_middleware );
+
+    cpm::HLCMailbox::MessageTag tag;
+    std::vector<char> buffer;
+    bool received = false;
+    for (int i = 0; i < 30 && !received; ++i)
+    {
+        hlc_communicator.sendCommand(VehicleCommandTrajectory(vehicle_id, Header(TimeStamp(3), TimeStamp(3)), {}));
+        received = restarted_middleware->read(tag, buffer, 100000000ull);
+    }
+    REQUIRE( received );
+    CHECK( restarted_middleware->is_hlc_attached() );
+    CHECK( tag == cpm::HLCMailbox::TagVehicleCommandTrajectory );
+
+    //Only commands sent after the restart arrive at the new middleware
+    VehicleCommandTrajectory command;
+    cpm::HLCMailbox::deserialize(buffer, command);
+    CHECK( command.vehicle_id() == vehicle_id );
+    CHECK( command.header().create_stamp().nanoseconds() == 3 );
+}
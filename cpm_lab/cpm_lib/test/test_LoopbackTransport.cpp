@@ -0,0 +1,144 @@
+#include "catch.hpp"
+#include "cpm/dds/VehicleState.hpp"
+#include "cpm/dds/Parameter.hpp"
+#include "cpm/LoopbackTransport.hpp"
+#include "cpm/Writer.hpp"
+#include "cpm/Reader.hpp"
+#include "cpm/ReaderAbstract.hpp"
+#include "cpm/AsyncReader.hpp"
+#include "cpm/MultiVehicleReader.hpp"
+#include "cpm/VehicleIDFilteredTopic.hpp"
+#include "cpm/stamp_message.hpp"
+#include "cpm/get_topic.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * \test Tests LoopbackTransport
+ *
+ * - If samples are delivered synchronously, without waiting for discovery
+ * - If the QoS rules of DDS apply: Reliable readers only match reliable writers, transient local readers only match transient local writers
+ *   and receive their previous samples, keep-last readers only keep the newest sample per instance
+ * - If Reader, MultiVehicleReader and VehicleIDFilteredTopic work with the loopback transport
+ * - If an AsyncReader callback can write to its own topic
+ * \ingroup cpmlib
+ */
+TEST_CASE( "LoopbackTransport" ) {
+    cpm::LoopbackTransport::enable();
+
+    SECTION( "QoS" ) {
+        cpm::Writer<Parameter> best_effort_writer("loopback_qos");
+        cpm::Writer<Parameter> transient_local_writer("loopback_qos", true, false, true);
+
+        //Written before the readers exist: Only the last sample of each instance is kept by the transient local writer
+        Parameter parameter;
+        parameter.name("a");
+        parameter.value_string("old");
+        transient_local_writer.write(parameter);
+        parameter.value_string("new");
+        transient_local_writer.write(parameter);
+        parameter.name("b");
+        transient_local_writer.write(parameter);
+        best_effort_writer.write(parameter);
+
+        cpm::ReaderAbstract<Parameter> best_effort_reader("loopback_qos", false, true, false);
+        cpm::ReaderAbstract<Parameter> reliable_reader("loopback_qos", true, true, false);
+        cpm::ReaderAbstract<Parameter> keep_last_reader("loopback_qos", true, false, false);
+        std::vector<Parameter> transient_local_samples;
+        cpm::AsyncReader<Parameter> transient_local_reader([&](std::vector<Parameter>& samples){
+            transient_local_samples.insert(transient_local_samples.end(), samples.begin(), samples.end());
+        }, "loopback_qos", true, true);
+
+        //Late-joining transient local reader got the kept samples within its constructor
+        REQUIRE( transient_local_samples.size() == 2 );
+        CHECK( transient_local_samples.at(0).name() == "a" );
+        CHECK( transient_local_samples.at(0).value_string() == "new" );
+        CHECK( transient_local_samples.at(1).name() == "b" );
+
+        CHECK( best_effort_writer.matched_subscriptions_size() == 1 );
+        CHECK( transient_local_writer.matched_subscriptions_size() == 4 );
+        CHECK( reliable_reader.matched_publications_size() == 1 );
+        CHECK( best_effort_reader.matched_publications_size() == 2 );
+
+        //Delivered before write returns
+        parameter.name("c");
+        best_effort_writer.write(parameter);
+        parameter.name("d");
+        transient_local_writer.write(parameter);
+        parameter.value_string("newer");
+        transient_local_writer.write(parameter);
+
+        CHECK( best_effort_reader.take().size() == 3 );
+        CHECK( reliable_reader.take().size() == 2 );
+        auto keep_last_samples = keep_last_reader.take();
+        REQUIRE( keep_last_samples.size() == 1 );
+        CHECK( keep_last_samples.at(0).value_string() == "newer" );
+        CHECK( transient_local_samples.size() == 4 );
+    }
+
+    SECTION( "Reader, MultiVehicleReader and VehicleIDFilteredTopic" ) {
+        //The topic name constructors do not need a DDS topic, the filtered reader does
+        cpm::Writer<VehicleState> writer("loopback_vehicle_state");
+        cpm::Reader<VehicleState> reader("loopback_vehicle_state");
+        cpm::Reader<VehicleState> filtered_reader(cpm::VehicleIDFilteredTopic<VehicleState>(cpm::get_topic<VehicleState>("loopback_vehicle_state"), 3));
+        cpm::MultiVehicleReader<VehicleState> multi_vehicle_reader("loopback_vehicle_state", std::vector<uint8_t>{1, 3});
+
+        const uint64_t t0 = 1500000000000000000ull;
+        for (uint8_t vehicle_id = 1; vehicle_id <= 3; ++vehicle_id)
+        {
+            VehicleState state;
+            state.vehicle_id(vehicle_id);
+            state.odometer_distance(vehicle_id);
+            cpm::stamp_message(state, t0 + vehicle_id, 0);
+            writer.write(state);
+        }
+
+        VehicleState sample;
+        uint64_t sample_age;
+        reader.get_sample(t0 + 10, sample, sample_age);
+        CHECK( sample.vehicle_id() == 3 );
+        filtered_reader.get_sample(t0 + 10, sample, sample_age);
+        CHECK( sample.vehicle_id() == 3 );
+        filtered_reader.get_sample(t0 + 10, sample, sample_age);
+        CHECK( sample.odometer_distance() == 3 );
+
+        std::map<uint8_t, VehicleState> samples;
+        std::map<uint8_t, uint64_t> sample_ages;
+        multi_vehicle_reader.get_samples(t0 + 10, samples, sample_ages);
+        REQUIRE( samples.size() == 2 );
+        CHECK( samples.at(1).odometer_distance() == 1 );
+        CHECK( samples.at(3).odometer_distance() == 3 );
+    }
+
+    SECTION( "AsyncReader writes to its own topic" ) {
+        //Like the RTTTool, which answers requests on the topic it reads
+        cpm::Writer<Parameter> answer_writer("loopback_echo", true);
+        std::vector<std::string> received;
+        cpm::AsyncReader<Parameter> echo_reader([&](std::vector<Parameter>& samples){
+            for (auto& sample : samples)
+            {
+                received.push_back(sample.name());
+                if (sample.name() == "request")
+                {
+                    Parameter answer;
+                    answer.name("answer");
+                    answer_writer.write(answer);
+                }
+            }
+        }, "loopback_echo", true);
+
+        cpm::Writer<Parameter> request_writer("loopback_echo", true);
+        Parameter request;
+        request.name("request");
+        request_writer.write(request);
+
+        //The answer is delivered after the callback returned, but before write returned
+        REQUIRE( received.size() == 2 );
+        CHECK( received.at(0) == "request" );
+        CHECK( received.at(1) == "answer" );
+    }
+
+    cpm::LoopbackTransport::disable();
+}
@@ -137,4 +137,26 @@ TEST_CASE( "MultiVehicleReader" ) {
     }
 
     REQUIRE(!hasVehicleTwo);
+
+    //Handles refer to the same samples, without copying them for each call
+    std::map<uint8_t, std::shared_ptr<const VehicleState>> handles;
+    std::map<uint8_t, std::shared_ptr<const VehicleState>> handles_again;
+    std::map<uint8_t, uint64_t> handles_age;
+    const uint64_t t_now = t0 + 5 * second + 300 * millisecond;
+    reader.get_sample_handles(t_now, handles, handles_age);
+    reader.get_sample_handles(t_now, handles_again, handles_age);
+
+    for (auto vehicle_id : vehicle_ids)
+    {
+        REQUIRE( handles.at(vehicle_id) );
+        REQUIRE( handles.at(vehicle_id) == handles_again.at(vehicle_id) );
+        REQUIRE( handles.at(vehicle_id)->odometer_distance() == samples[vehicle_id].odometer_distance() );
+        REQUIRE( handles_age.at(vehicle_id) == 900 * millisecond );
+    }
+
+    //A handle that is held stays valid when newer samples are selected
+    auto held_handle = handles.at(vehicle_ids.at(0));
+    reader.get_sample_handles(t0 + 10 * second + 500 * millisecond, handles, handles_age);
+    REQUIRE( handles.at(vehicle_ids.at(0))->odometer_distance() == 10 );
+    REQUIRE( held_handle->odometer_distance() == 4 );
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "catch.hpp"
+#include "cpm/PhaseAllocator.hpp"
+
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * \test Tests the phase allocation: Offsets within the window of the stage, spreading of the load and the shared table
+ * \ingroup cpmlib
+ */
+TEST_CASE( "PhaseAllocator" ) {
+    const uint64_t ms = 1000000ull;
+    const uint64_t period = 100 * ms;
+
+    SECTION( "Stage windows" ) {
+        std::vector<cpm::PhaseAllocator::Node> nodes;
+        CHECK( cpm::PhaseAllocator::compute_offset(period, 5 * ms, cpm::PhaseAllocator::StageVehicle, nodes) == 0 );
+        CHECK( cpm::PhaseAllocator::compute_offset(period, 5 * ms, cpm::PhaseAllocator::StageMiddleware, nodes) == 33 * ms );
+        CHECK( cpm::PhaseAllocator::compute_offset(period, 5 * ms, cpm::PhaseAllocator::StageHLC, nodes) == 66 * ms + 500000ull );
+        CHECK( cpm::PhaseAllocator::compute_offset(period, 5 * ms, cpm::PhaseAllocator::StageAny, nodes) == 0 );
+        CHECK( cpm::PhaseAllocator::compute_offset(0, 5 * ms, cpm::PhaseAllocator::StageAny, nodes) == 0 );
+    }
+
+    SECTION( "Load is spread" ) {
+        std::vector<cpm::PhaseAllocator::Node> nodes;
+        for (int i = 0; i < 4; ++i)
+        {
+            uint64_t offset = cpm::PhaseAllocator::compute_offset(period, 20 * ms, cpm::PhaseAllocator::StageAny, nodes);
+            for (auto& node : nodes)
+            {
+                //No overlap with the computation of previous nodes
+                CHECK( (offset >= node.offset_ns + node.compute_ns || offset + 20 * ms <= node.offset_ns) );
+            }
+            nodes.push_back({period, 20 * ms, offset});
+        }
+
+        //Node with a shorter period: Computes from 0 to 10ms and from 50 to 60ms, so the earliest start without overlap is 10ms (33ms within the middleware window)
+        std::vector<cpm::PhaseAllocator::Node> fast_node = { {50 * ms, 10 * ms, 0} };
+        CHECK( cpm::PhaseAllocator::compute_offset(period, 10 * ms, cpm::PhaseAllocator::StageAny, fast_node) == 10 * ms );
+        CHECK( cpm::PhaseAllocator::compute_offset(period, 10 * ms, cpm::PhaseAllocator::StageMiddleware, fast_node) == 33 * ms );
+    }
+
+    SECTION( "Shared table" ) {
+        std::string table_name = "/cpm_test_phase_allocation_" + std::to_string(getpid());
+
+        auto first = cpm::PhaseAllocator::allocate("first", period, 30 * ms, cpm::PhaseAllocator::StageAny, table_name);
+        auto second = cpm::PhaseAllocator::allocate("second", period, 30 * ms, cpm::PhaseAllocator::StageAny, table_name);
+        CHECK( first->get_offset() == 0 );
+        CHECK( second->get_offset() == 30 * ms );
+
+        //Released entries do not count anymore
+        first.reset();
+        auto third = cpm::PhaseAllocator::allocate("third", period, 30 * ms, cpm::PhaseAllocator::StageAny, table_name);
+        CHECK( third->get_offset() == 0 );
+
+        shm_unlink(table_name.c_str());
+    }
+}
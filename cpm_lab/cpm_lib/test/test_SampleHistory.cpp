@@ -0,0 +1,140 @@
+#include "catch.hpp"
+#include "cpm/SampleHistory.hpp"
+
+#include <cmath>
+#include <stdint.h>
+
+/**
+ * \brief Minimal message type with the accessors of the IDL types (header, pose), s.t. the test does not depend on DDS
+ * \ingroup cpmlib
+ */
+struct HistoryTestSample {
+    //! Stamp with the accessors of TimeStamp
+    struct Stamp {
+        uint64_t value = 0;
+        uint64_t nanoseconds() const { return value; }
+        void nanoseconds(uint64_t v) { value = v; }
+    };
+    //! Header with the accessors of Header
+    struct Header {
+        Stamp stamp;
+        const Stamp& create_stamp() const { return stamp; }
+        Stamp& create_stamp() { return stamp; }
+    };
+    //! Pose with the accessors of Pose2D
+    struct Pose {
+        double x_ = 0, y_ = 0, yaw_ = 0;
+        double x() const { return x_; }
+        double y() const { return y_; }
+        double yaw() const { return yaw_; }
+        void x(double v) { x_ = v; }
+        void y(double v) { y_ = v; }
+        void yaw(double v) { yaw_ = v; }
+    };
+
+    Header header_;
+    Pose pose_;
+    int id = 0;
+
+    const Header& header() const { return header_; }
+    Header& header() { return header_; }
+    const Pose& pose() const { return pose_; }
+    Pose& pose() { return pose_; }
+
+    /**
+     * \brief Create a sample
+     * \param stamp Create stamp
+     * \param x x and y of the pose
+     * \param yaw Yaw of the pose
+     * \param id To identify the sample
+     */
+    static HistoryTestSample create(uint64_t stamp, double x, double yaw, int id)
+    {
+        HistoryTestSample sample;
+        sample.header().create_stamp().nanoseconds(stamp);
+        sample.pose().x(x);
+        sample.pose().y(x);
+        sample.pose().yaw(yaw);
+        sample.id = id;
+        return sample;
+    }
+};
+
+/**
+ * \test Tests the time-sorted sample history: Insertion (also out of order and when full), sample_at and interpolate
+ * \ingroup cpmlib
+ */
+TEST_CASE( "SampleHistory" ) {
+    cpm::SampleHistory<HistoryTestSample> history(4);
+    HistoryTestSample sample;
+
+    SECTION( "Disabled history" ) {
+        cpm::SampleHistory<HistoryTestSample> disabled;
+        disabled.insert(HistoryTestSample::create(10, 0, 0, 1));
+        CHECK( disabled.size() == 0 );
+        CHECK_FALSE( disabled.sample_at(10, sample) );
+    }
+
+    SECTION( "Samples at a given time" ) {
+        //Out of order: 30 arrives before 20
+        history.insert(HistoryTestSample::create(10, 0, 0, 1));
+        history.insert(HistoryTestSample::create(30, 0, 0, 3));
+        history.insert(HistoryTestSample::create(20, 0, 0, 2));
+        CHECK( history.size() == 3 );
+
+        CHECK_FALSE( history.sample_at(9, sample) );
+        REQUIRE( history.sample_at(10, sample) );
+        CHECK( sample.id == 1 );
+        REQUIRE( history.sample_at(25, sample) );
+        CHECK( sample.id == 2 );
+        REQUIRE( history.sample_at(1000, sample) );
+        CHECK( sample.id == 3 );
+
+        //Full: The oldest sample is dropped, samples older than the history are ignored
+        history.insert(HistoryTestSample::create(40, 0, 0, 4));
+        history.insert(HistoryTestSample::create(35, 0, 0, 5));
+        CHECK( history.size() == 4 );
+        CHECK_FALSE( history.sample_at(15, sample) );
+        history.insert(HistoryTestSample::create(5, 0, 0, 6));
+        CHECK_FALSE( history.sample_at(5, sample) );
+
+        REQUIRE( history.sample_at(37, sample) );
+        CHECK( sample.id == 5 );
+        REQUIRE( history.sample_at(40, sample) );
+        CHECK( sample.id == 4 );
+
+        //Wraps around the ring buffer multiple times
+        for (int i = 0; i < 10; ++i)
+        {
+            history.insert(HistoryTestSample::create(100 + 10 * i, 0, 0, 100 + i));
+        }
+        REQUIRE( history.sample_at(165, sample) );
+        CHECK( sample.id == 106 );
+        CHECK_FALSE( history.sample_at(155, sample) );
+
+        history.clear();
+        CHECK( history.size() == 0 );
+    }
+
+    SECTION( "Interpolation" ) {
+        history.insert(HistoryTestSample::create(100, 0.0, 3.0, 1));
+        history.insert(HistoryTestSample::create(200, 2.0, -3.0, 2));
+
+        CHECK_FALSE( history.interpolate(50, sample) );
+        CHECK_FALSE( history.interpolate(250, sample) );
+
+        REQUIRE( history.interpolate(200, sample) );
+        CHECK( sample.id == 2 );
+
+        REQUIRE( history.interpolate(125, sample) );
+        CHECK( sample.header().create_stamp().nanoseconds() == 125 );
+        CHECK( sample.id == 1 );
+        CHECK( sample.pose().x() == Approx(0.5) );
+        CHECK( sample.pose().y() == Approx(0.5) );
+
+        //The yaw is interpolated along the shorter direction (across pi)
+        REQUIRE( history.interpolate(150, sample) );
+        CHECK( sample.id == 2 );
+        CHECK( std::fabs(sample.pose().yaw()) == Approx(M_PI) );
+    }
+}
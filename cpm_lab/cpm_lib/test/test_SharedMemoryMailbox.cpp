@@ -0,0 +1,97 @@
+#include "catch.hpp"
+#include "cpm/SharedMemoryMailbox.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * \test Tests the shared memory mailbox: Sequence of messages, lost messages, waiting and the owner / peer handling
+ * \ingroup cpmlib
+ */
+TEST_CASE( "SharedMemoryMailbox" ) {
+    std::string name = "/cpm_test_mailbox_" + std::to_string(getpid());
+
+    //Only the created mailbox can be opened
+    REQUIRE( cpm::SharedMemoryMailbox::open(name) == nullptr );
+    auto writer = cpm::SharedMemoryMailbox::create(name, 4, 64);
+    REQUIRE( writer );
+    auto reader = cpm::SharedMemoryMailbox::open(name);
+    REQUIRE( reader );
+
+    uint32_t tag = 0;
+    std::vector<char> data;
+
+    SECTION( "Messages are read in order" ) {
+        std::string first = "first";
+        std::string second = "second";
+        REQUIRE( writer->write(1, first.data(), first.size()) );
+        REQUIRE( writer->write(2, second.data(), second.size()) );
+        REQUIRE_FALSE( writer->write(3, std::string(65, 'x').data(), 65) );
+        CHECK( writer->get_write_sequence() == 2 );
+
+        REQUIRE( reader->read(tag, data, 0) );
+        CHECK( tag == 1 );
+        CHECK( std::string(data.begin(), data.end()) == first );
+        REQUIRE( reader->read(tag, data, 0) );
+        CHECK( tag == 2 );
+        CHECK( std::string(data.begin(), data.end()) == second );
+
+        //No further message: Returns after the timeout
+        auto start = std::chrono::steady_clock::now();
+        CHECK_FALSE( reader->read(tag, data, 20000000ull) );
+        CHECK( std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(15) );
+    }
+
+    SECTION( "Overwritten messages are skipped" ) {
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            REQUIRE( writer->write(i, reinterpret_cast<const char*>(&i), sizeof(i)) );
+        }
+
+        //Only the last 4 messages (slot count) can be read
+        for (uint32_t i = 6; i < 10; ++i)
+        {
+            REQUIRE( reader->read(tag, data, 0) );
+            CHECK( tag == i );
+        }
+        CHECK_FALSE( reader->read(tag, data, 0) );
+        CHECK( reader->get_lost_messages() == 6 );
+    }
+
+    SECTION( "Reader is woken up by the writer" ) {
+        std::thread writer_thread([&] () {
+            for (uint32_t i = 0; i < 100; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                writer->write(i, reinterpret_cast<const char*>(&i), sizeof(i));
+            }
+        });
+
+        uint32_t received = 0;
+        while (received < 100 && reader->read(tag, data, 1000000000ull))
+        {
+            CHECK( tag == received );
+            ++received;
+        }
+        writer_thread.join();
+
+        CHECK( received == 100 );
+        CHECK( reader->get_lost_messages() == 0 );
+    }
+
+    SECTION( "Peer and owner" ) {
+        CHECK( reader->is_owner_alive() );
+        CHECK_FALSE( writer->is_peer_attached() );
+        reader->attach();
+        CHECK( writer->is_peer_attached() );
+        reader.reset();
+        CHECK_FALSE( writer->is_peer_attached() );
+
+        //The segment is removed with its owner
+        writer.reset();
+        CHECK( cpm::SharedMemoryMailbox::open(name) == nullptr );
+    }
+}
@@ -0,0 +1,55 @@
+#include "catch.hpp"
+#include "cpm/TimestepDeadline.hpp"
+#include "cpm/get_time_ns.hpp"
+
+/**
+ * \test Tests the deadline of a planning timestep: Budget computed from the period, remaining time and cancellation
+ * \ingroup cpmlib
+ */
+TEST_CASE( "TimestepDeadline" ) {
+    const uint64_t ms = 1000000ull;
+    const uint64_t t_now = 1000 * ms;
+    const uint64_t period = 100 * ms;
+
+    SECTION( "Budget from the period" ) {
+        //Received 20ms after the start of the period: The elapsed time counts against the budget
+        auto deadline = cpm::TimestepDeadline::from_period(t_now, period, 5 * ms, t_now + 20 * ms);
+        CHECK( deadline->get_start() == t_now );
+        CHECK( deadline->get_deadline() == t_now + 95 * ms );
+        CHECK( deadline->get_budget() == 95 * ms );
+        CHECK( deadline->get_remaining(t_now + 20 * ms) == 75 * ms );
+        CHECK( deadline->get_remaining(t_now + 95 * ms) == 0 );
+        CHECK( deadline->get_remaining(t_now + 200 * ms) == 0 );
+
+        //At most half of the period is reserved as margin
+        auto short_deadline = cpm::TimestepDeadline::from_period(t_now, 4 * ms, 5 * ms, t_now);
+        CHECK( short_deadline->get_budget() == 2 * ms );
+    }
+
+    SECTION( "Start of the period cannot be used" ) {
+        //t_now is not within the last period (simulated time or different clocks): Starts on reception
+        auto simulated = cpm::TimestepDeadline::from_period(5 * ms, period, 5 * ms, t_now);
+        CHECK( simulated->get_start() == t_now );
+        CHECK( simulated->get_budget() == 95 * ms );
+
+        auto future = cpm::TimestepDeadline::from_period(t_now + 10 * ms, period, 5 * ms, t_now);
+        CHECK( future->get_start() == t_now );
+    }
+
+    SECTION( "Cancellation" ) {
+        uint64_t now = cpm::get_time_ns();
+        auto deadline = cpm::TimestepDeadline::from_period(now, 10000 * ms, 0, now);
+        CHECK_FALSE( deadline->is_cancelled() );
+        CHECK( deadline->has_time_for(100 * ms) );
+        CHECK_FALSE( deadline->has_time_for(20000 * ms) );
+
+        deadline->cancel();
+        CHECK( deadline->is_cancelled() );
+        CHECK( deadline->get_remaining() == 0 );
+        CHECK_FALSE( deadline->has_time_for(0) );
+
+        //Deadline in the past
+        auto expired = std::make_shared<cpm::TimestepDeadline>(now - 20 * ms, now - 10 * ms);
+        CHECK( expired->is_cancelled() );
+    }
+}
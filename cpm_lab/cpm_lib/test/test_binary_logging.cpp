@@ -0,0 +1,77 @@
+#include "catch.hpp"
+#include "cpm/BinaryLogRecord.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * \test Tests encoding and lazy formatting of binary log records
+ * \ingroup cpmlib
+ */
+TEST_CASE( "BinaryLogRecord" ) {
+    std::vector<uint8_t> buffer;
+    std::string str_arg = "fünf";
+    const char* c_str_arg = "Test \"quoted\"";
+    uint64_t big_value = 18446744073709551615ull;
+
+    //Encode two records in the same buffer, like in a thread buffer of the Logging
+    cpm::binary_log::encode_record(buffer, 3, 2, 123456789ull, 5, str_arg, 0.5, c_str_arg, big_value);
+    cpm::binary_log::encode_record(buffer, 4, 3, 123456790ull);
+
+    size_t offset = 0;
+    cpm::binary_log::DecodedRecord record;
+
+    SECTION( "Decoding" ) {
+        REQUIRE(cpm::binary_log::decode_record(buffer.data(), buffer.size(), offset, record));
+        CHECK(record.format_id == 3);
+        CHECK(record.log_level == 2);
+        CHECK(record.timestamp == 123456789ull);
+        REQUIRE(record.args.size() == 5);
+        CHECK(record.args.at(0).tag == cpm::binary_log::ArgTag::Signed);
+        CHECK(record.args.at(1).s == str_arg);
+        CHECK(record.args.at(2).d == 0.5);
+        CHECK(record.args.at(4).u == big_value);
+
+        REQUIRE(cpm::binary_log::decode_record(buffer.data(), buffer.size(), offset, record));
+        CHECK(record.format_id == 4);
+        CHECK(record.args.size() == 0);
+
+        //End of buffer reached
+        CHECK(offset == buffer.size());
+        CHECK_FALSE(cpm::binary_log::decode_record(buffer.data(), buffer.size(), offset, record));
+    }
+
+    SECTION( "Truncated data" ) {
+        CHECK_FALSE(cpm::binary_log::decode_record(buffer.data(), 10, offset, record));
+        CHECK(offset == 0);
+    }
+
+    SECTION( "Formatting" ) {
+        REQUIRE(cpm::binary_log::decode_record(buffer.data(), buffer.size(), offset, record));
+
+        //Result must match the one of snprintf / Logging::write, length modifiers are replaced by the recorded type
+        std::string result = cpm::binary_log::format_record("Die Zahl %i nennt sich auch %s, %.2f%% - %s %llu", record.args);
+        CHECK(result == "Die Zahl 5 nennt sich auch fünf, 0.50% - Test \"quoted\" 18446744073709551615");
+
+        //Width, flags and missing arguments
+        std::vector<cpm::binary_log::DecodedArg> args(record.args.begin(), record.args.begin() + 1);
+        CHECK(cpm::binary_log::format_record("[%03d]", args) == "[005]");
+        CHECK(cpm::binary_log::format_record("[%-3d] %d", args) == "[5  ] <?>");
+    }
+
+    SECTION( "Width and precision as arguments" ) {
+        //Round trip: The result must match snprintf, and the arguments after * must stay in step
+        std::vector<uint8_t> star_buffer;
+        cpm::binary_log::encode_record(star_buffer, 5, 2, 1ull, 6, 42, 3, 3.14159, -4, 7, -1, 2.5, str_arg);
+        size_t star_offset = 0;
+        cpm::binary_log::DecodedRecord star_record;
+        REQUIRE(cpm::binary_log::decode_record(star_buffer.data(), star_buffer.size(), star_offset, star_record));
+
+        const char* format = "[%*d] [%.*f] [%*d] [%.*f] %s";
+        char expected[128];
+        snprintf(expected, sizeof(expected), format, 6, 42, 3, 3.14159, -4, 7, -1, 2.5, str_arg.c_str());
+        CHECK(cpm::binary_log::format_record(format, star_record.args) == expected);
+        CHECK(cpm::binary_log::format_record(format, star_record.args) == "[    42] [3.142] [7   ] [2.500000] fünf");
+    }
+}
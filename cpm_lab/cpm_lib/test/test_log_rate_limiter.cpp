@@ -0,0 +1,138 @@
+#include "catch.hpp"
+#include "cpm/LogRateLimiter.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * \test Tests the token-bucket rate limiting of log messages per call site and per node
+ * \ingroup cpmlib
+ */
+TEST_CASE( "LogRateLimiter" ) {
+    cpm::LogRateLimiter limiter;
+    std::vector<cpm::LogRateLimiter::Summary> summaries;
+    const uint64_t ms = 1000000ull;
+    uint64_t t = 1000 * ms;
+
+    //Source locations, as passed by CPM_LOG
+    const char* storm_site = "Timer.cpp:42";
+    const char* other_site = "Timer.cpp:57";
+    const char* format = "%s";
+
+    SECTION( "Per call site" ) {
+        limiter.set_limits(10.0, 5.0, 1000.0, 1000.0);
+
+        //Log storm within 1ms: Only the burst passes
+        int passed = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            if (limiter.allow(storm_site, format, 1, t + i * 10, summaries)) ++passed;
+        }
+        CHECK(passed == 5);
+        CHECK(summaries.size() == 0);
+
+        //Other call sites are not affected
+        CHECK(limiter.allow(other_site, format, 1, t + 1000, summaries));
+
+        //100ms later, one more token is available
+        CHECK(limiter.allow(storm_site, format, 1, t + 100 * ms, summaries));
+        CHECK_FALSE(limiter.allow(storm_site, format, 1, t + 101 * ms, summaries));
+
+        auto statistics = limiter.get_statistics();
+        CHECK(statistics.messages_passed == 7);
+        CHECK(statistics.messages_suppressed == 96);
+        CHECK(statistics.messages_suppressed_by_node_limit == 0);
+        CHECK(statistics.suppressing_call_sites == 1);
+        CHECK(statistics.suppressed_per_call_site[storm_site] == 96);
+
+        //After the summary period, the suppressed messages are reported once
+        limiter.allow(other_site, format, 1, t + 1001 * ms, summaries);
+        REQUIRE(summaries.size() == 1);
+        CHECK(summaries.at(0).call_site == storm_site);
+        CHECK(summaries.at(0).format == format);
+        CHECK(summaries.at(0).suppressed_count == 96);
+        CHECK(summaries.at(0).log_level == 1);
+
+        summaries.clear();
+        limiter.allow(other_site, format, 1, t + 2002 * ms, summaries);
+        CHECK(summaries.size() == 0);
+        CHECK(limiter.get_statistics().suppressing_call_sites == 0);
+    }
+
+    SECTION( "Per node" ) {
+        limiter.set_limits(1000.0, 1000.0, 10.0, 3.0);
+
+        //Many different (dynamic) messages without a known call site: Only the node bucket limits them
+        int passed = 0;
+        for (int i = 0; i < 20; ++i)
+        {
+            std::string message = "Message " + std::to_string(i);
+            if (limiter.allow(nullptr, message.c_str(), 2, t + i, summaries)) ++passed;
+        }
+        CHECK(passed == 3);
+        CHECK(limiter.get_statistics().suppressing_call_sites == 0);
+
+        auto statistics = limiter.get_statistics();
+        CHECK(statistics.messages_suppressed == 17);
+        CHECK(statistics.messages_suppressed_by_node_limit == 17);
+    }
+
+    SECTION( "Summary without further messages" ) {
+        limiter.set_limits(10.0, 5.0, 1000.0, 1000.0);
+
+        for (int i = 0; i < 50; ++i)
+        {
+            limiter.allow(storm_site, format, 1, t + i, summaries);
+        }
+
+        //The storm ended, but the logger collects the summaries regularly
+        limiter.collect_due_summaries(t + 500 * ms, summaries);
+        CHECK(summaries.size() == 0);
+
+        limiter.collect_due_summaries(t + 1000 * ms, summaries);
+        REQUIRE(summaries.size() == 1);
+        CHECK(summaries.at(0).call_site == storm_site);
+        CHECK(summaries.at(0).suppressed_count == 45);
+
+        summaries.clear();
+        limiter.collect_due_summaries(t + 2000 * ms, summaries);
+        CHECK(summaries.size() == 0);
+    }
+
+    SECTION( "Call sites by source location" ) {
+        limiter.set_limits(10.0, 2.0, 1000.0, 1000.0);
+
+        //Two call sites with the same format string (e.g. write(level, "%s", msg)) are limited independently
+        int storm_passed = 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            if (limiter.allow(storm_site, format, 1, t + i, summaries)) ++storm_passed;
+        }
+        CHECK(storm_passed == 2);
+        CHECK(limiter.allow(other_site, format, 1, t + 10, summaries));
+        CHECK(limiter.allow(other_site, format, 1, t + 11, summaries));
+        CHECK_FALSE(limiter.allow(other_site, format, 1, t + 12, summaries));
+
+        //A dynamic format string at a known call site shares its bucket and is reported with its current text
+        std::string dynamic_format = "Value " + std::to_string(7);
+        CHECK_FALSE(limiter.allow(storm_site, dynamic_format.c_str(), 2, t + 20, summaries));
+        limiter.collect_due_summaries(t + 1000 * ms, summaries);
+        REQUIRE(summaries.size() == 2);
+        bool storm_site_reported = false;
+        for (const auto& summary : summaries)
+        {
+            if (summary.call_site == storm_site && summary.format == "Value 7" && summary.suppressed_count == 9 && summary.log_level == 2) storm_site_reported = true;
+        }
+        CHECK(storm_site_reported);
+    }
+
+    SECTION( "Disabled" ) {
+        limiter.set_limits(0.0, 0.0, 0.0, 0.0);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            CHECK(limiter.allow(storm_site, format, 1, t + i, summaries));
+        }
+        CHECK(limiter.get_statistics().messages_suppressed == 0);
+    }
+}
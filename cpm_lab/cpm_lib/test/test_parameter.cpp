@@ -8,6 +8,7 @@
 #include <chrono>
 #include <functional>
 #include "cpm/get_topic.hpp"
+#include "VirtualClockDriver.hpp"
 
 #include "cpm/Writer.hpp"
 
@@ -55,6 +56,7 @@ class ParameterServerDummy {
  * - If parameter requests are processed correctly by the lib
  * - If the ParameterServerDummy answers correctly
  * - If different types are supported
+ * - The lib waits for the answer in virtual time (see VirtualClockDriver)
  * \ingroup cpmlib
  */
 TEST_CASE( "parameter_double" ) {
@@ -66,6 +68,9 @@ TEST_CASE( "parameter_double" ) {
     double param_value = 42.1;
     bool received_wrong_param_name = false;
 
+    //The lib polls for the parameter in virtual time, see VirtualClockDriver
+    VirtualClockDriver clock_driver(1000000000000ull);
+
     //Thread that uses the cpm lib to request a parameter - this is supposed to be tested
     double received_parameter_value = 0;
     std::thread client_thread([&](){
@@ -101,6 +106,47 @@ TEST_CASE( "parameter_double" ) {
     CHECK( ! received_wrong_param_name );
 }
 
+/**
+ * \test Tests Parameters with uint64_t values
+ * 
+ * - If parameter requests are processed correctly by the lib
+ * - If the lib requests the parameter again until it is answered; it polls once per second in virtual time, so this does not take seconds
+ * \ingroup cpmlib
+ */
+TEST_CASE( "parameter_uint64_t" ) {
+    //Set the Logger ID
+    cpm::Logging::Instance().set_id("test_parameter_uint64_t");
+
+    std::string param_name = "my_param_uint64_t";
+    uint64_t param_value = 12345678901234ull;
+
+    //The lib polls for the parameter in virtual time, see VirtualClockDriver
+    VirtualClockDriver clock_driver(1000000000000ull);
+
+    //Thread that uses the cpm lib to request a parameter - this is supposed to be tested
+    uint64_t received_parameter_value = 0;
+    std::thread client_thread([&](){
+        received_parameter_value = cpm::parameter_uint64_t(param_name);
+    });
+
+    //Create a callback function that acts similar to the parameter server - only send data if the expected request was received
+    ParameterServerDummy server([&](std::vector<ParameterRequest>& samples){
+        for (auto data : samples) {
+            if (data.name() == param_name) {
+                Parameter param = Parameter();
+                param.name(param_name);
+                param.type(ParameterType::UInt64);
+                param.value_uint64_t(param_value);
+                server.get_writer().write(param);
+            }
+        }
+    });
+
+    client_thread.join();
+
+    REQUIRE( received_parameter_value == param_value );
+}
+
 
 /**
  * \test Tests Parameters with string values
@@ -108,6 +154,7 @@ TEST_CASE( "parameter_double" ) {
  * - If parameter requests are processed correctly by the lib
  * - If the ParameterServerDummy answers correctly
  * - If different types are supported
+ * - The lib waits for the answer in virtual time (see VirtualClockDriver)
  * \ingroup cpmlib
  */
 TEST_CASE( "parameter_strings" ) {
@@ -120,6 +167,9 @@ TEST_CASE( "parameter_strings" ) {
     std::string param_name_2 = "param_name_2";
     const char* string_param_2 = "Take one down and pass it around, 98 bottles of beer on the wall.";
 
+    //The lib polls for the parameter in virtual time, see VirtualClockDriver
+    VirtualClockDriver clock_driver(1000000000000ull);
+
     //Thread to request parameters via the cpm lib
     std::string received_parameter_value;
     std::string received_parameter_value_2;
@@ -162,6 +212,7 @@ TEST_CASE( "parameter_strings" ) {
  * - If parameter requests are processed correctly by the lib
  * - If the ParameterServerDummy answers correctly
  * - If different types are supported
+ * - The lib waits for the answer in virtual time (see VirtualClockDriver)
  * \ingroup cpmlib
  */
 TEST_CASE( "parameter_bool" ) {
@@ -176,6 +227,9 @@ TEST_CASE( "parameter_bool" ) {
     bool received_parameter_value_false = true;
     bool desired_paramater_value_false = false;
 
+    //The lib polls for the parameter in virtual time, see VirtualClockDriver
+    VirtualClockDriver clock_driver(1000000000000ull);
+
     //Thread to request parameters via the cpm lib
     std::thread client_thread([&](){
         received_parameter_value_true = cpm::parameter_bool(param_name_1);
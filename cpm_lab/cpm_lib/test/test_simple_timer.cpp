@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "cpm/SimpleTimer.hpp"
+#include "cpm/VirtualClock.hpp"
 #include <unistd.h>
 
 #include <thread>
@@ -22,6 +23,8 @@
  * - Is the callback function called shortly after t_now
  * - Is the timer actually stopped when it should be stopped
  * - If the callback function takes longer than period to finish, is this handled correctly
+ *
+ * The timer runs in virtual time (see cpm::VirtualClock), only the start signal is exchanged via DDS in real time.
  * \ingroup cpmlib
  */
 TEST_CASE( "SimpleTimer functionality" ) {
@@ -33,6 +36,9 @@ TEST_CASE( "SimpleTimer functionality" ) {
     const std::string time_name = "asdfg";
 
 
+    cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+    clock.enable(1000000000000ull, true);
+
     cpm::SimpleTimer timer(time_name, period, true);
 
     //Starting time to check for:
@@ -100,8 +106,8 @@ TEST_CASE( "SimpleTimer functionality" ) {
         CHECK( now >= starting_time + period_ns * timer_loop_count); 
 
         if (timer_loop_count == 0) {
-            // actual start time is within 2 ms of initial start time
-            CHECK( t_start <= starting_time + period_ns + 2000000); 
+            // the first timestep is at most one period after the start time
+            CHECK( t_start <= starting_time + period_ns ); 
         }
 
         timer_loop_count++;
@@ -112,13 +118,15 @@ TEST_CASE( "SimpleTimer functionality" ) {
         t_start_prev = t_start;
 
         // simluate variable runtime that can be greater than period
-        usleep( ((timer_loop_count%3)*period_ns + period_ns/3) / 1000 ); 
+        cpm::VirtualClock::sleep_for_ns((timer_loop_count%3)*period_ns + period_ns/3);
     });
 
     if (signal_thread.joinable()) {
         signal_thread.join();
     }
 
+    clock.disable();
+
     // Check that the ready signal matches the expected ready signal
     CHECK(source_id == time_name);
 }
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "cpm/SimpleTimer.hpp"
+#include "cpm/VirtualClock.hpp"
 #include <unistd.h>
 
 #include <thread>
@@ -20,6 +21,8 @@
  * 
  * - Sends a custom stop signal and checks whether it works
  * - Therefore: Makes sure that the timer callback function is never actually called
+ *
+ * The timer runs in virtual time with auto advance (see cpm::VirtualClock), so it would call its callback right away if it started.
  * \ingroup cpmlib
  */
 TEST_CASE( "SimpleTimer_custom_stop_signal" ) {
@@ -31,6 +34,9 @@ TEST_CASE( "SimpleTimer_custom_stop_signal" ) {
     bool react_to_stop = true;
     uint64_t custom_stop_signal = 1234;
     std::string timer_id = "0";
+    cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+    clock.enable(1000000000000ull, true);
+
     cpm::SimpleTimer timer(timer_id, period_ms, wait_for_start, react_to_stop, custom_stop_signal);
 
     //Writer to send system triggers to the timer 
@@ -95,4 +101,6 @@ TEST_CASE( "SimpleTimer_custom_stop_signal" ) {
         signal_thread.join();
     }
 
+    clock.disable();
+
 }
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "cpm/TimerFD.hpp"
+#include "cpm/VirtualClock.hpp"
 #include <unistd.h>
 
 #include <thread>
@@ -22,6 +23,9 @@
  * - Is the callback function called shortly after t_now
  * - Is the timer actually stopped when it should be stopped
  * - If the callback function takes longer than period to finish, is this handled correctly
+ *
+ * The timer runs in virtual time (see cpm::VirtualClock), so the start delay and the periods do not take real time;
+ * only the start signal is exchanged via DDS in real time.
  * \ingroup cpmlib
  */
 TEST_CASE( "TimerFD_accuracy" ) {
@@ -34,6 +38,9 @@ TEST_CASE( "TimerFD_accuracy" ) {
     const std::string time_name = "asdfg";
 
 
+    cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+    clock.enable(1000000000000ull, true);
+
     cpm::TimerFD timer(time_name, period, offset, true);
 
     //Starting time to check for:
@@ -99,11 +106,11 @@ TEST_CASE( "TimerFD_accuracy" ) {
         CHECK( now >= starting_time + period * timer_loop_count); 
 
         if (timer_loop_count == 0) {
-            // actual start time is within 3 ms of initial start time
-            CHECK( t_start <= starting_time + period + 3000000); 
+            // the first timestep is the first one at or after the start time
+            CHECK( t_start >= starting_time );
+            CHECK( t_start < starting_time + period ); 
         }
-        CHECK( t_start <= now ); //Callback should not be called before t_start
-        CHECK( now <= t_start + 3000000 ); // actual start time is within 3 ms of declared start time
+        CHECK( t_start == now ); //In virtual time, the callback is called exactly at t_start
         CHECK( t_start % period == offset ); // start time corresponds to timer definition
 
         if(timer_loop_count > 0)
@@ -120,13 +127,15 @@ TEST_CASE( "TimerFD_accuracy" ) {
         t_start_prev = t_start;
 
         // simluate variable runtime that can be greater than period
-        usleep( ((timer_loop_count%3)*period + period/3) / 1000 ); 
+        cpm::VirtualClock::sleep_for_ns((timer_loop_count%3)*period + period/3);
     });
 
     if (signal_thread.joinable()) {
         signal_thread.join();
     }
 
+    clock.disable();
+
     // Check that the ready signal matches the expected ready signal
     CHECK(source_id == time_name);
 }
@@ -1,8 +1,11 @@
 #include "catch.hpp"
 #include "cpm/TimerFD.hpp"
+#include "cpm/VirtualClock.hpp"
 #include "cpm/exceptions.hpp"
 #include <unistd.h>
 
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <string>
 #include <vector>
@@ -15,6 +18,8 @@
  * \test Tests TimerFD cannot be started twice
  * 
  * - Calls start(_async) after the timer has been started -> exceptions should be thrown
+ *
+ * The timer runs in virtual time (see cpm::VirtualClock), so the test only waits until the first callback.
  * \ingroup cpmlib
  */
 TEST_CASE( "TimerFD_start_again" ) {
@@ -25,21 +30,29 @@ TEST_CASE( "TimerFD_start_again" ) {
     const uint64_t offset =  0;
 
     std::string timer_id = "2";
+    cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+    clock.enable(1000000000000ull, true);
     cpm::TimerFD timer(timer_id, period, offset, false);
 
+    std::atomic_bool called;
+    called.store(false);
+
     //Ignore warning that t_start is unused
     #pragma GCC diagnostic push
     #pragma GCC diagnostic ignored "-Wunused-parameter"
 
     //Check if start_async works as expected as well and store timestamps
     timer.start_async([&](uint64_t t_start){
-        usleep(100);
+        called.store(true);
     });
 
     #pragma GCC diagnostic pop
 
     //Check that the timer cannot be used while it is running
-    usleep(1000000);
+    while (!called.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
 
     //Ignore warning that t_start is unused
     #pragma GCC diagnostic push
@@ -52,5 +65,5 @@ TEST_CASE( "TimerFD_start_again" ) {
 
 
     timer.stop();
-
+    clock.disable();
 }
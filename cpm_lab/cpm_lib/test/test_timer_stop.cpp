@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "cpm/TimerFD.hpp"
+#include "cpm/VirtualClock.hpp"
 #include <unistd.h>
 
 #include <thread>
@@ -19,6 +20,8 @@
  * 
  * - Sends a stop signal but not a start signal
  * - Therefore: Makes sure that the timer callback function is never actually called
+ *
+ * The timer runs in virtual time with auto advance (see cpm::VirtualClock), so it would call its callback right away if it started.
  * \ingroup cpmlib
  */
 TEST_CASE( "TimerFD_stop_signal" ) {
@@ -28,6 +31,9 @@ TEST_CASE( "TimerFD_stop_signal" ) {
     const uint64_t period = 21000000;
     const uint64_t offset =  5000000;
     std::string timer_id = "0";
+    cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+    clock.enable(1000000000000ull, true);
+
     cpm::TimerFD timer(timer_id, period, offset, true);
 
     //Writer to send system triggers to the timer 
@@ -92,4 +98,6 @@ TEST_CASE( "TimerFD_stop_signal" ) {
         signal_thread.join();
     }
 
+    clock.disable();
+
 }
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "cpm/TimerFD.hpp"
+#include "cpm/VirtualClock.hpp"
 #include <unistd.h>
 
 #include <thread>
@@ -20,6 +21,9 @@
  * \test Tests TimerFD stop signal while running
  * 
  * - Tests if the timer can be stopped by sending a stop signal
+ *
+ * The timer runs in virtual time (see cpm::VirtualClock), so it does not wait for the start time in real time.
+ * The runtime of the callback is still simulated in real time, as the stop signal is sent via DDS in real time.
  * \ingroup cpmlib
  */
 TEST_CASE( "TimerFD_stop_signal_when_running" ) {
@@ -28,6 +32,9 @@ TEST_CASE( "TimerFD_stop_signal_when_running" ) {
 
     const uint64_t period = 21000000;
     const uint64_t offset =  5000000;
+    cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+    clock.enable(1000000000000ull, true);
+
     cpm::TimerFD timer("xcvbn", period, offset, true);
 
     //Starting time to check for:
@@ -103,4 +110,6 @@ TEST_CASE( "TimerFD_stop_signal_when_running" ) {
     if (signal_thread.joinable()) {
         signal_thread.join();
     }
+
+    clock.disable();
 }
@@ -0,0 +1,104 @@
+#include "catch.hpp"
+#include "cpm/VirtualClock.hpp"
+#include "cpm/TimerFD.hpp"
+#include "cpm/get_time_ns.hpp"
+#include "cpm/Logging.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/**
+ * \test Tests VirtualClock
+ *
+ * - If get_time_ns returns the virtual time while the clock is enabled
+ * - If sleepers are only woken when the virtual time reaches their wake-up time
+ * - If a timer started with start_async is called exactly at each period when the time is advanced, without waiting in real time
+ * - If a timer started with start runs on its own in virtual time with auto advance
+ * \ingroup cpmlib
+ */
+TEST_CASE( "VirtualClock" ) {
+    //Set the Logger ID
+    cpm::Logging::Instance().set_id("test_virtual_clock");
+
+    cpm::VirtualClock& clock = cpm::VirtualClock::Instance();
+    const uint64_t start_time = 1000000000000ull; //Aligned to the timer periods
+    const uint64_t period = 10000000ull; //10ms
+    auto real_start = std::chrono::steady_clock::now();
+
+    SECTION( "get_time_ns and sleepers" ) {
+        clock.enable(start_time);
+        CHECK( cpm::get_time_ns() == start_time );
+        clock.advance(5000);
+        CHECK( cpm::get_time_ns() == start_time + 5000 );
+
+        std::atomic_bool woken;
+        woken.store(false);
+        std::thread sleeper([&](){
+            clock.sleep_until(start_time + 2 * period);
+            woken.store(true);
+        });
+
+        //Wait (in real time) until the thread sleeps
+        while (clock.get_sleeper_count() == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        clock.advance_to(start_time + period);
+        CHECK( !woken.load() );
+        clock.advance_to(start_time + 2 * period);
+        sleeper.join();
+        CHECK( woken.load() );
+        CHECK( cpm::get_time_ns() == start_time + 2 * period );
+
+        clock.disable();
+        CHECK( cpm::get_time_ns() > start_time + 2 * period );
+    }
+
+    SECTION( "Timer with advance" ) {
+        clock.enable(start_time);
+
+        cpm::TimerFD timer("test_virtual_clock", period, 0, false);
+        std::vector<uint64_t> timesteps;
+        timer.start_async([&](uint64_t t_now){
+            CHECK( cpm::get_time_ns() == t_now );
+            timesteps.push_back(t_now);
+        });
+
+        //Ten seconds of virtual time: When advance returns, all callbacks up to then must have been called
+        clock.advance(10000000000ull);
+        REQUIRE( timesteps.size() == 1001 );
+        for (size_t i = 0; i < timesteps.size(); ++i)
+        {
+            CHECK( timesteps.at(i) == start_time + i * period );
+        }
+        clock.advance(period);
+        CHECK( timesteps.size() == 1002 );
+
+        timer.stop();
+        clock.disable();
+    }
+
+    SECTION( "Timer with auto advance" ) {
+        clock.enable(start_time, true);
+
+        cpm::TimerFD timer("test_virtual_clock", period, 0, false);
+        uint64_t last_timestep = 0;
+        int count = 0;
+        timer.start([&](uint64_t t_now){
+            last_timestep = t_now;
+            ++count;
+            if (count == 500) timer.stop();
+        });
+
+        CHECK( last_timestep == start_time + 499 * period );
+        CHECK( cpm::get_time_ns() == last_timestep );
+        clock.disable();
+    }
+
+    //Five seconds of timer periods must not take five seconds in real time
+    auto real_duration = std::chrono::steady_clock::now() - real_start;
+    CHECK( real_duration < std::chrono::seconds(5) );
+}
@@ -60,6 +60,8 @@ public:
 	bool SaveSettingsToCamera(bool BootWithNewSettings = false);
 	double GetFrameRate();
 	GstElement* GetSource();	
+	// Each frame carries its capture time (cpm::get_time_ns clock) as GstReferenceTimestampMeta with these caps, through the whole pipeline
+	static GstCaps* GetCaptureTimeCaps();
 	
 private:
 	int m_width;
@@ -1,7 +1,10 @@
 #pragma once
+#include <map>
+#include <mutex>
 #include <string>
 #include <thread>
 #include "CInstantCameraAppSrc.h"
+#include "LabCamIndex.hpp"
 #include <gst/gst.h>
 
 
@@ -41,6 +44,27 @@ class LabCam {
 		std::string file_name_;
 		//! Folder in which the resulting video will be saved
 		std::string path_;
+		//! Length of each video segment in seconds
+		unsigned int segment_length_s_ = 600;
+
+		/**
+		 * \brief Frame that left the encoder, but was not yet written to the file
+		 */
+		struct PendingFrame {
+			//! Capture time (cpm::get_time_ns clock)
+			uint64_t capture_time_ns;
+			//! True if the encoder created a keyframe
+			bool keyframe;
+		};
+
+		//! Frames that left the encoder, by presentation timestamp
+		std::map<uint64_t, PendingFrame> encoded_frames_;
+		//! Mutex for encoded_frames_ and the index, which are accessed by different streaming threads
+		std::mutex frames_mutex_;
+		//! Bytes written to the current segment file so far, i.e. the offset of the next chunk
+		uint64_t segment_bytes_ = 0;
+		//! Sidecar index of the recording
+		LabCamIndex index_;
 
         //! A pipeline needs a source element. The InstantCameraForAppSrc will create, configure, and provide an AppSrc which fits the camera.
         GstElement *source = nullptr;
@@ -62,6 +86,21 @@ class LabCam {
 		 */
 		bool startRecordingImpl();
 
+		/**
+		 * \brief Pad probe on the encoder output: Remembers the capture time (see CInstantCameraAppSrc::GetCaptureTimeCaps) of each encoded frame
+		 */
+		static GstPadProbeReturn encoder_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+
+		/**
+		 * \brief Pad probe on the file sink input: Adds written frames with their byte offset to the index
+		 */
+		static GstPadProbeReturn sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+
+		/**
+		 * \brief Called by splitmuxsink when a new segment is started, returns its file name and starts its index
+		 */
+		static gchar* format_location(GstElement *splitmux, guint fragment_id, gpointer data);
+
 	public:
 		LabCam() = default;
 		~LabCam() = default;
@@ -70,8 +109,9 @@ class LabCam {
 		 * \brief Wrapper to specify the output folder/file and to start the recording of the LabCam.
 		 * \param path Folder in which the resulting video will be saved
 		 * \param file_name Filename of the recording
+		 * \param segment_length_s Length of each video segment in seconds
 		 */
-		void startRecording(std::string path, std::string file_name);
+		void startRecording(std::string path, std::string file_name, unsigned int segment_length_s = 600);
 
 		/**
 		 * \brief Stops current recording
@@ -23,9 +23,10 @@ class LabCamIface {
 		/**
 		 * \brief Starts recording of LabCam.
 		 * \param path Folder in which the resulting video will be saved.
-		 * \param file_name Filename of the recording.
+		 * \param file_name Filename of the recording (segments are saved as <file_name>_<segment>.avi).
+		 * \param segment_length_s Length of each video segment in seconds.
 		 */
-		void startRecording(std::string path, std::string file_name);
+		void startRecording(std::string path, std::string file_name, unsigned int segment_length_s = 600);
 
 		/**
 		 * \brief Stops current recording.
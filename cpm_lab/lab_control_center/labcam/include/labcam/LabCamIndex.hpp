@@ -0,0 +1,132 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * \brief Sidecar index of a segmented LabCam recording.
+ *
+ * For a recording <file_name>, the following files are created in the recording folder:
+ * - <file_name>_<segment>.avi: Video segments of (approximately, they start at a keyframe) fixed length
+ * - <file_name>_<segment>.idx: One line per frame of the segment: frame number within the segment, capture time
+ *   (cpm::get_time_ns), presentation timestamp within the stream, keyframe flag and byte offset of the frame's chunk
+ *   within the AVI file (only meaningful for keyframes, which can be decoded without previous frames)
+ * - <file_name>_segments.idx: One line per segment: segment number and capture time of its first frame
+ *
+ * All lines of a file have the same length (fields are zero-padded, the first line is a header padded with spaces),
+ * s.t. the n-th entry can be read directly. As the frame rate and the segment length are (almost) constant,
+ * the entry for a timestamp is found with a constant number of reads (see find_frame).
+ * \ingroup lcc_labcam
+ */
+class LabCamIndex {
+	public:
+		/**
+		 * \brief An entry of a segment index
+		 */
+		struct FrameEntry {
+			//! Frame number within the segment, starting at 0
+			uint64_t frame = 0;
+			//! Capture time of the frame (cpm::get_time_ns clock)
+			uint64_t capture_time_ns = 0;
+			//! Presentation timestamp of the frame within the stream
+			uint64_t pts_ns = 0;
+			//! True if the frame is a keyframe
+			bool keyframe = false;
+			//! Byte offset of the frame's chunk in the AVI file
+			uint64_t byte_offset = 0;
+		};
+
+		//! Length of each line of a segment index, including the newline
+		static constexpr size_t FRAME_LINE_LENGTH = 76;
+		//! Length of each line of the segment list, including the newline
+		static constexpr size_t SEGMENT_LINE_LENGTH = 32;
+
+	private:
+		//! Index file of the current segment
+		FILE* frame_file = nullptr;
+		//! List of all segments of the recording
+		FILE* segment_file = nullptr;
+		//! Number of the current segment
+		uint32_t segment = 0;
+		//! Next frame number within the current segment
+		uint64_t next_frame = 0;
+
+		/**
+		 * \brief Write a header line, padded with spaces to the given line length
+		 */
+		static void write_header(FILE* file, const char* header, size_t line_length);
+
+		/**
+		 * \brief Read the n-th entry (not counting the header) of a segment index
+		 * \return False if the entry does not exist
+		 */
+		static bool read_frame(FILE* file, uint64_t n, FrameEntry& entry_out);
+
+		/**
+		 * \brief Read the n-th entry (not counting the header) of a segment list
+		 * \return False if the entry does not exist
+		 */
+		static bool read_segment(FILE* file, uint64_t n, uint32_t& segment_out, uint64_t& start_time_out);
+
+	public:
+		LabCamIndex() = default;
+		~LabCamIndex();
+
+		/**
+		 * \brief Get the file name of a video segment
+		 * \param path Folder of the recording
+		 * \param file_name File name of the recording (without extension)
+		 * \param segment Number of the segment
+		 */
+		static std::string segment_video_file(const std::string& path, const std::string& file_name, uint32_t segment);
+
+		/**
+		 * \brief Get the file name of the index of a video segment
+		 * \param path Folder of the recording
+		 * \param file_name File name of the recording (without extension)
+		 * \param segment Number of the segment
+		 */
+		static std::string segment_index_file(const std::string& path, const std::string& file_name, uint32_t segment);
+
+		/**
+		 * \brief Get the file name of the list of segments of a recording
+		 * \param path Folder of the recording
+		 * \param file_name File name of the recording (without extension)
+		 */
+		static std::string segment_list_file(const std::string& path, const std::string& file_name);
+
+		/**
+		 * \brief Finish the index of the previous segment (if any) and start the index of the next one
+		 * \param path Folder of the recording
+		 * \param file_name File name of the recording (without extension)
+		 * \param segment Number of the new segment
+		 */
+		void open_segment(const std::string& path, const std::string& file_name, uint32_t segment);
+
+		/**
+		 * \brief Add the next frame of the current segment to the index
+		 * \param capture_time_ns Capture time of the frame (cpm::get_time_ns clock)
+		 * \param pts_ns Presentation timestamp of the frame within the stream
+		 * \param keyframe True if the frame is a keyframe
+		 * \param byte_offset Byte offset of the frame's chunk in the AVI file
+		 */
+		void add_frame(uint64_t capture_time_ns, uint64_t pts_ns, bool keyframe, uint64_t byte_offset);
+
+		/**
+		 * \brief Finish the index files
+		 */
+		void close();
+
+		/**
+		 * \brief Find the last frame that was captured at or before the given time
+		 * \param path Folder of the recording
+		 * \param file_name File name of the recording (without extension)
+		 * \param time_ns Time to look for (cpm::get_time_ns clock)
+		 * \param segment_out Segment that contains the frame
+		 * \param frame_out The frame
+		 * \param keyframe_out Last keyframe at or before the frame, to start decoding from
+		 * \return False if the recording does not contain a frame at or before the given time
+		 */
+		static bool find_frame(const std::string& path, const std::string& file_name, uint64_t time_ns,
+			uint32_t& segment_out, FrameEntry& frame_out, FrameEntry& keyframe_out);
+};
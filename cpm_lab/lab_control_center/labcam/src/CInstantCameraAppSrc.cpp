@@ -514,6 +514,9 @@ bool CInstantCameraAppSrc::retrieve_image()
             NULL
         );
 
+		// Attach the capture time to the frame itself, the meta is kept by the converter and the encoder (e.g. for the index of the recording)
+		gst_buffer_add_reference_timestamp_meta(m_gstBuffer, GetCaptureTimeCaps(), t_image, GST_CLOCK_TIME_NONE);
+
 		// Push the gst buffer wrapping the image buffer to the source pads of the AppSrc element, where it's picked up by the rest of the pipeline
 		GstFlowReturn ret;
 		g_signal_emit_by_name(m_appsrc, "push-buffer", m_gstBuffer, &ret);
@@ -698,6 +701,13 @@ bool CInstantCameraAppSrc::SaveSettingsToCamera(bool BootWithNewSettings)
 	}
 }
 
+// identifies the reference timestamp meta that holds the capture time of a frame
+GstCaps* CInstantCameraAppSrc::GetCaptureTimeCaps()
+{
+	static GstCaps* caps = gst_caps_new_empty_simple("timestamp/x-cpm-time");
+	return caps;
+}
+
 // we will provide the application a configured gst source element to match the camera.
 GstElement* CInstantCameraAppSrc::GetSource()
 {
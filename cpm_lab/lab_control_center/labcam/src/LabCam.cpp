@@ -57,15 +57,89 @@ gboolean bus_call(GstBus *bus, GstMessage *msg, gpointer data)
 	}
 }
 
+GstPadProbeReturn LabCam::encoder_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data){
+	(void)pad;
+	LabCam* cam = (LabCam*)data;
+	GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+	if (buffer == nullptr || !GST_BUFFER_PTS_IS_VALID(buffer)) return GST_PAD_PROBE_OK;
+
+	// The capture time travels with the frame, so dropped or duplicated frames cannot shift it to other frames
+	GstReferenceTimestampMeta* capture_time = gst_buffer_get_reference_timestamp_meta(buffer, CInstantCameraAppSrc::GetCaptureTimeCaps());
+	if (capture_time == nullptr) return GST_PAD_PROBE_OK;
+
+	std::lock_guard<std::mutex> lock(cam->frames_mutex_);
+
+	PendingFrame frame;
+	frame.capture_time_ns = capture_time->timestamp;
+	frame.keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+	cam->encoded_frames_[GST_BUFFER_PTS(buffer)] = frame;
+
+	return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn LabCam::sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data){
+	(void)pad;
+	LabCam* cam = (LabCam*)data;
+
+	if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+	{
+		GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+		// avimux keeps the timestamp of a frame on its chunk; only the first buffer of a chunk is indexed
+		if (GST_BUFFER_PTS_IS_VALID(buffer))
+		{
+			std::lock_guard<std::mutex> lock(cam->frames_mutex_);
+			auto frame = cam->encoded_frames_.find(GST_BUFFER_PTS(buffer));
+			if (frame != cam->encoded_frames_.end())
+			{
+				cam->index_.add_frame(frame->second.capture_time_ns, GST_BUFFER_PTS(buffer), frame->second.keyframe, cam->segment_bytes_);
+				// Older entries can no longer be written (e.g. dropped at a segment boundary)
+				cam->encoded_frames_.erase(cam->encoded_frames_.begin(), ++frame);
+			}
+		}
+
+		cam->segment_bytes_ += gst_buffer_get_size(buffer);
+	}
+	else if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM)
+	{
+		// The muxer seeks back to rewrite its headers, the following buffers are written at the new position
+		GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+		if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT)
+		{
+			const GstSegment* segment;
+			gst_event_parse_segment(event, &segment);
+			if (segment->format == GST_FORMAT_BYTES)
+			{
+				cam->segment_bytes_ = segment->start;
+			}
+		}
+	}
+
+	return GST_PAD_PROBE_OK;
+}
+
+gchar* LabCam::format_location(GstElement *splitmux, guint fragment_id, gpointer data){
+	(void)splitmux;
+	LabCam* cam = (LabCam*)data;
+
+	// A new segment file is started: Start its index as well
+	std::lock_guard<std::mutex> lock(cam->frames_mutex_);
+	cam->segment_bytes_ = 0;
+	cam->index_.open_segment(cam->path_, cam->file_name_, fragment_id);
+
+	return g_strdup(LabCamIndex::segment_video_file(cam->path_, cam->file_name_, fragment_id).c_str());
+}
+
 void LabCam::jumppad(void* arg){
 	LabCam* cam = (LabCam*)arg;
 	cam->startRecordingImpl();
 
 }
 
-void LabCam::startRecording(std::string path, std::string file_name){
+void LabCam::startRecording(std::string path, std::string file_name, unsigned int segment_length_s){
 	file_name_ = file_name;
 	path_ = path;
+	segment_length_s_ = segment_length_s;
 	cam_thread_ = std::thread(LabCam::jumppad, this);
 	cam_thread_.detach();
 }
@@ -120,24 +194,42 @@ bool LabCam::startRecordingImpl(){
 	    GstElement *sink;
 	    GstElement *x264enc;
 	    GstElement *avimux;
+	    GstElement *splitmux;
 
 	    convert = gst_element_factory_make("videoconvert", "converter");
 	    x264enc = gst_element_factory_make("x264enc", "h264encoder");
 	    avimux = gst_element_factory_make("avimux", "muxer");
 	    sink = gst_element_factory_make("filesink", "videosink"); // depending on your platform, you may have to use some alternative here, like ("autovideosink", "sink")
-
-	    std::stringstream filename_stream;
-	    filename_stream << path_ << "/" << file_name_ << ".avi";
-
-	    g_object_set(G_OBJECT(sink), "location", filename_stream.str().c_str(), NULL);
+	    splitmux = gst_element_factory_make("splitmuxsink", "splitmuxer");
 
 	    if (!convert){ cout << "Could not make convert" << endl; return false; }
 	    if (!sink){ cout << "Could not make sink" << endl; return false; }
+	    if (!splitmux){ cout << "Could not make splitmuxsink" << endl; return false; }
+
+	    // One keyframe per second s.t. segments can be split and the recording can be seeked quickly,
+	    // no B-frames s.t. frames are written in capture order (the index must be sorted by capture time)
+	    g_object_set(G_OBJECT(x264enc), "key-int-max", frameRate, "bframes", 0, NULL);
+
+	    // The recording is split into segments of fixed length (starting at a keyframe), each with its own index
+	    g_object_set(G_OBJECT(splitmux),
+	        "muxer", avimux,
+	        "sink", sink,
+	        "max-size-time", static_cast<guint64>(segment_length_s_) * GST_SECOND,
+	        NULL);
+	    g_signal_connect(splitmux, "format-location", G_CALLBACK(LabCam::format_location), this);
+
+	    GstPad* encoder_pad = gst_element_get_static_pad(x264enc, "src");
+	    gst_pad_add_probe(encoder_pad, GST_PAD_PROBE_TYPE_BUFFER, LabCam::encoder_probe, this, NULL);
+	    gst_object_unref(encoder_pad);
+
+	    GstPad* sink_pad = gst_element_get_static_pad(sink, "sink");
+	    gst_pad_add_probe(sink_pad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM), LabCam::sink_probe, this, NULL);
+	    gst_object_unref(sink_pad);
 	    
 	    // add and link the pipeline elements
-	    gst_bin_add_many(GST_BIN(pipeline), source, convert, x264enc, avimux, sink, NULL);
-	    if(!gst_element_link_many(source, convert, x264enc, avimux, sink, NULL)){
-	        std::cout << "FAILED: gst_element_link_many(source, convert, x264enc, sink, NULL)" << std::endl;
+	    gst_bin_add_many(GST_BIN(pipeline), source, convert, x264enc, splitmux, NULL);
+	    if(!gst_element_link_many(source, convert, x264enc, splitmux, NULL)){
+	        std::cout << "FAILED: gst_element_link_many(source, convert, x264enc, splitmux, NULL)" << std::endl;
 	        return false;
 	    } 
 
@@ -157,6 +249,7 @@ bool LabCam::startRecordingImpl(){
 
 		camera_.StopCamera();
 		camera_.CloseCamera();
+		index_.close();
 
 		return true;
 
@@ -10,8 +10,8 @@ LabCamIface::LabCamIface(){
 	impl_ = new LabCam();
 }
 
-void LabCamIface::startRecording(std::string path, std::string file_name){
-	impl_->startRecording(path, file_name);
+void LabCamIface::startRecording(std::string path, std::string file_name, unsigned int segment_length_s){
+	impl_->startRecording(path, file_name, segment_length_s);
 }
 
 void LabCamIface::stopRecording(){
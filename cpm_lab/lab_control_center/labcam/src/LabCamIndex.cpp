@@ -0,0 +1,210 @@
+#include "labcam/LabCamIndex.hpp"
+
+#include <cinttypes>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+/**
+ * \file LabCamIndex.cpp
+ * \ingroup lcc_labcam
+ */
+
+constexpr size_t LabCamIndex::FRAME_LINE_LENGTH;
+constexpr size_t LabCamIndex::SEGMENT_LINE_LENGTH;
+
+LabCamIndex::~LabCamIndex(){
+	close();
+}
+
+std::string LabCamIndex::segment_video_file(const std::string& path, const std::string& file_name, uint32_t segment){
+	std::stringstream stream;
+	stream << path << "/" << file_name << "_" << std::setw(5) << std::setfill('0') << segment << ".avi";
+	return stream.str();
+}
+
+std::string LabCamIndex::segment_index_file(const std::string& path, const std::string& file_name, uint32_t segment){
+	std::stringstream stream;
+	stream << path << "/" << file_name << "_" << std::setw(5) << std::setfill('0') << segment << ".idx";
+	return stream.str();
+}
+
+std::string LabCamIndex::segment_list_file(const std::string& path, const std::string& file_name){
+	return path + "/" + file_name + "_segments.idx";
+}
+
+void LabCamIndex::write_header(FILE* file, const char* header, size_t line_length){
+	fprintf(file, "%-*s\n", static_cast<int>(line_length - 1), header);
+}
+
+void LabCamIndex::open_segment(const std::string& path, const std::string& file_name, uint32_t _segment){
+	if (segment_file == nullptr)
+	{
+		segment_file = fopen(segment_list_file(path, file_name).c_str(), "w");
+		if (segment_file != nullptr) write_header(segment_file, "segment,start_time_ns", SEGMENT_LINE_LENGTH);
+	}
+
+	if (frame_file != nullptr)
+	{
+		fclose(frame_file);
+	}
+
+	segment = _segment;
+	next_frame = 0;
+	frame_file = fopen(segment_index_file(path, file_name, segment).c_str(), "w");
+	if (frame_file != nullptr) write_header(frame_file, "frame,capture_time_ns,pts_ns,keyframe,byte_offset", FRAME_LINE_LENGTH);
+}
+
+void LabCamIndex::add_frame(uint64_t capture_time_ns, uint64_t pts_ns, bool keyframe, uint64_t byte_offset){
+	if (frame_file == nullptr) return;
+
+	//The segment list refers to the first frame of each segment
+	if (next_frame == 0 && segment_file != nullptr)
+	{
+		fprintf(segment_file, "%010" PRIu32 ",%020" PRIu64 "\n", segment, capture_time_ns);
+		fflush(segment_file);
+	}
+
+	fprintf(frame_file, "%010" PRIu64 ",%020" PRIu64 ",%020" PRIu64 ",%d,%020" PRIu64 "\n",
+		next_frame, capture_time_ns, pts_ns, keyframe ? 1 : 0, byte_offset);
+	++next_frame;
+}
+
+void LabCamIndex::close(){
+	if (frame_file != nullptr)
+	{
+		fclose(frame_file);
+		frame_file = nullptr;
+	}
+	if (segment_file != nullptr)
+	{
+		fclose(segment_file);
+		segment_file = nullptr;
+	}
+}
+
+bool LabCamIndex::read_frame(FILE* file, uint64_t n, FrameEntry& entry_out){
+	char line[FRAME_LINE_LENGTH + 1];
+	if (fseek(file, static_cast<long>((n + 1) * FRAME_LINE_LENGTH), SEEK_SET) != 0) return false;
+	if (fread(line, 1, FRAME_LINE_LENGTH, file) != FRAME_LINE_LENGTH) return false;
+	line[FRAME_LINE_LENGTH] = '\0';
+
+	int keyframe = 0;
+	if (sscanf(line, "%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%d,%" SCNu64,
+		&entry_out.frame, &entry_out.capture_time_ns, &entry_out.pts_ns, &keyframe, &entry_out.byte_offset) != 5)
+	{
+		return false;
+	}
+	entry_out.keyframe = (keyframe != 0);
+	return true;
+}
+
+bool LabCamIndex::read_segment(FILE* file, uint64_t n, uint32_t& segment_out, uint64_t& start_time_out){
+	char line[SEGMENT_LINE_LENGTH + 1];
+	if (fseek(file, static_cast<long>((n + 1) * SEGMENT_LINE_LENGTH), SEEK_SET) != 0) return false;
+	if (fread(line, 1, SEGMENT_LINE_LENGTH, file) != SEGMENT_LINE_LENGTH) return false;
+	line[SEGMENT_LINE_LENGTH] = '\0';
+
+	return sscanf(line, "%" SCNu32 ",%" SCNu64, &segment_out, &start_time_out) == 2;
+}
+
+/**
+ * \brief Number of complete entries (without the header) of an index file
+ * \ingroup lcc_labcam
+ */
+static uint64_t count_entries(FILE* file, size_t line_length){
+	if (fseek(file, 0, SEEK_END) != 0) return 0;
+	long size = ftell(file);
+	if (size < static_cast<long>(line_length)) return 0;
+	return static_cast<uint64_t>(size) / line_length - 1;
+}
+
+/**
+ * \brief Estimate the entry for a timestamp, assuming that entries are equally spaced in time
+ * \ingroup lcc_labcam
+ */
+static uint64_t estimate_entry(uint64_t time_ns, uint64_t first_time_ns, uint64_t last_time_ns, uint64_t count){
+	if (count <= 1 || last_time_ns <= first_time_ns || time_ns <= first_time_ns) return 0;
+	double estimate = static_cast<double>(time_ns - first_time_ns) / static_cast<double>(last_time_ns - first_time_ns) * static_cast<double>(count - 1);
+	uint64_t entry = static_cast<uint64_t>(estimate);
+	return (entry < count) ? entry : count - 1;
+}
+
+bool LabCamIndex::find_frame(const std::string& path, const std::string& file_name, uint64_t time_ns,
+	uint32_t& segment_out, FrameEntry& frame_out, FrameEntry& keyframe_out)
+{
+	//Find the segment
+	FILE* segments = fopen(segment_list_file(path, file_name).c_str(), "r");
+	if (segments == nullptr) return false;
+
+	uint64_t segment_count = count_entries(segments, SEGMENT_LINE_LENGTH);
+	uint32_t first_segment, last_segment, segment;
+	uint64_t first_start, last_start, start;
+	if (segment_count == 0
+		|| !read_segment(segments, 0, first_segment, first_start)
+		|| !read_segment(segments, segment_count - 1, last_segment, last_start)
+		|| time_ns < first_start)
+	{
+		fclose(segments);
+		return false;
+	}
+
+	//Segments have a fixed length, so the estimate is at most one segment off
+	uint64_t n = estimate_entry(time_ns, first_start, last_start, segment_count);
+	read_segment(segments, n, segment, start);
+	while (n > 0 && start > time_ns)
+	{
+		--n;
+		read_segment(segments, n, segment, start);
+	}
+	uint32_t next_segment;
+	uint64_t next_start;
+	while (n + 1 < segment_count && read_segment(segments, n + 1, next_segment, next_start) && next_start <= time_ns)
+	{
+		++n;
+		segment = next_segment;
+		start = next_start;
+	}
+	fclose(segments);
+
+	//Find the frame within the segment
+	FILE* frames = fopen(segment_index_file(path, file_name, segment).c_str(), "r");
+	if (frames == nullptr) return false;
+
+	uint64_t frame_count = count_entries(frames, FRAME_LINE_LENGTH);
+	FrameEntry first_frame, last_frame, frame;
+	if (frame_count == 0
+		|| !read_frame(frames, 0, first_frame)
+		|| !read_frame(frames, frame_count - 1, last_frame))
+	{
+		fclose(frames);
+		return false;
+	}
+
+	//The frame rate is (almost) constant, so only few steps are necessary to correct the estimate
+	uint64_t m = estimate_entry(time_ns, first_frame.capture_time_ns, last_frame.capture_time_ns, frame_count);
+	read_frame(frames, m, frame);
+	while (m > 0 && frame.capture_time_ns > time_ns)
+	{
+		--m;
+		read_frame(frames, m, frame);
+	}
+	FrameEntry next_frame;
+	while (m + 1 < frame_count && read_frame(frames, m + 1, next_frame) && next_frame.capture_time_ns <= time_ns)
+	{
+		++m;
+		frame = next_frame;
+	}
+
+	//Decoding has to start at the previous keyframe (at most one keyframe interval away)
+	keyframe_out = frame;
+	while (!keyframe_out.keyframe && keyframe_out.frame > 0)
+	{
+		if (!read_frame(frames, keyframe_out.frame - 1, keyframe_out)) break;
+	}
+	fclose(frames);
+
+	segment_out = segment;
+	frame_out = frame;
+	return true;
+}
@@ -2,12 +2,14 @@
  * \file main.cpp
  * 
  * \brief Starts labcam recording. The command line parameters path and file_name can be used to
- *        specify the folder and filename of the resulting recording. As soon as a SIGTERM or
+ *        specify the folder and filename of the resulting recording, segment_length_s the length
+ *        of each video segment (see LabCamIndex for the sidecar index files). As soon as a SIGTERM or
  *        SIGHUP signal is recognized, the recording is stopped.
  * 
  * \ingroup lcc_labcam
  */
 
+#include <algorithm>
 #include <chrono>
 #include <csignal>
 #include <iostream>
@@ -48,9 +50,10 @@ int main(int argc, char *argv[])
     // If no path is given, the default location is software/lab_control_center/build/labcam (due to "." and creation of tmux session)
     std::string path = cpm::cmd_parameter_string("path", ".", argc, argv);
     std::string file_name = cpm::cmd_parameter_string("file_name", "awesome_recording", argc, argv);
+    int segment_length_s = cpm::cmd_parameter_int("segment_length_s", 600, argc, argv);
 
     // Start recording by using the given input parameters
-    labcam.startRecording(path, file_name);
+    labcam.startRecording(path, file_name, static_cast<unsigned int>(std::max(segment_length_s, 1)));
 
     std::chrono::milliseconds dt_sleep(500);
     while(~is_stopped) std::this_thread::sleep_for(dt_sleep);
@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "labcam/LabCamIndex.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file LabCamIndexTest.cpp
+ * \brief Test for LabCamIndex: Writes the index of a recording with two segments (and a dropped frame) and checks
+ * that find_frame returns the right segment, frame and keyframe for exact timestamps, timestamps between frames,
+ * and timestamps before the first and after the last frame.
+ * Example: ./LabCamIndexTest
+ * \ingroup lcc_labcam
+ */
+
+//! Time between two frames in ns (30 fps)
+static const uint64_t frame_period_ns = 33333333ull;
+//! Capture time of the first frame
+static const uint64_t first_time_ns = 1000000000000ull;
+
+/**
+ * \brief Capture time of the n-th frame of the recording
+ * \ingroup lcc_labcam
+ */
+static uint64_t frame_time(uint64_t n)
+{
+    return first_time_ns + n * frame_period_ns;
+}
+
+/**
+ * \brief Look up a time and compare the result
+ * \return True if a frame was found in the expected segment, with the expected frame number and keyframe
+ * \ingroup lcc_labcam
+ */
+static bool find(const std::string& path, uint64_t time_ns, uint32_t segment, uint64_t frame, uint64_t keyframe)
+{
+    uint32_t segment_out = 0;
+    LabCamIndex::FrameEntry frame_out, keyframe_out;
+    if (!LabCamIndex::find_frame(path, "recording", time_ns, segment_out, frame_out, keyframe_out)) return false;
+
+    return segment_out == segment && frame_out.frame == frame && keyframe_out.frame == keyframe && keyframe_out.keyframe;
+}
+
+int main()
+{
+    int failures = 0;
+
+    char path_template[] = "/tmp/LabCamIndexTestXXXXXX";
+    char* path_ptr = mkdtemp(path_template);
+    if (path_ptr == nullptr)
+    {
+        check(false, "Create a temporary folder", failures);
+        return check_summary(failures);
+    }
+    const std::string path(path_ptr);
+
+    //Two segments of 30 frames each, one keyframe every 10 frames; frame 45 was dropped, so later frames of the segment are numbered one lower
+    {
+        LabCamIndex index;
+        for (uint64_t n = 0; n < 60; ++n)
+        {
+            if (n % 30 == 0) index.open_segment(path, "recording", static_cast<uint32_t>(n / 30));
+            if (n == 45) continue;
+
+            uint64_t frame_in_segment = n % 30;
+            index.add_frame(frame_time(n), frame_in_segment * frame_period_ns, frame_in_segment % 10 == 0, 1000 * frame_in_segment);
+        }
+        index.close();
+    }
+
+    check(find(path, frame_time(12), 0, 12, 10), "Exact capture time finds the frame", failures);
+    check(find(path, frame_time(12) + frame_period_ns / 2, 0, 12, 10), "Time between two frames finds the earlier frame", failures);
+    check(find(path, frame_time(0), 0, 0, 0), "Capture time of the first frame finds the first frame", failures);
+    check(find(path, frame_time(29) + frame_period_ns / 2, 0, 29, 20), "Time between two segments finds the last frame of the first segment", failures);
+    check(find(path, frame_time(30), 1, 0, 0), "Start of the second segment finds its first frame", failures);
+    check(find(path, frame_time(45), 1, 14, 10), "Time of a dropped frame finds the frame before it", failures);
+    check(find(path, frame_time(46), 1, 15, 10), "Frames after a dropped frame are found by their capture time", failures);
+    check(find(path, frame_time(59) + 10 * frame_period_ns, 1, 28, 19), "Time after the last frame finds the last frame", failures);
+
+    uint32_t segment_out = 0;
+    LabCamIndex::FrameEntry frame_out, keyframe_out;
+    check(!LabCamIndex::find_frame(path, "recording", frame_time(0) - 1, segment_out, frame_out, keyframe_out),
+        "Time before the first frame finds no frame", failures);
+    check(!LabCamIndex::find_frame(path, "missing", frame_time(12), segment_out, frame_out, keyframe_out),
+        "Unknown recording finds no frame", failures);
+
+    //Clean up
+    for (uint32_t segment = 0; segment < 2; ++segment)
+    {
+        std::remove(LabCamIndex::segment_index_file(path, "recording", segment).c_str());
+    }
+    std::remove(LabCamIndex::segment_list_file(path, "recording").c_str());
+    rmdir(path.c_str());
+
+    return check_summary(failures);
+}
@@ -35,16 +35,79 @@ HLCReadyAggregator::HLCReadyAggregator() :
                 }
                 catch (const std::runtime_error& err)
                 {
-                    cpm::Logging::Instance().write(2, "Error on converting HLC ID %s: %s", id_string.c_str(), err.what());
+                    CPM_LOG(2, "Error on converting HLC ID %s: %s", id_string.c_str(), err.what());
                 }
                 catch (...) {
-                    cpm::Logging::Instance().write(2, "Error: Could not convert HLC ID %s to int in HLCReadyAggregator", id_string.c_str());
+                    CPM_LOG(2, "Error: Could not convert HLC ID %s to int in HLCReadyAggregator", id_string.c_str());
                 }
             }
         },
         "hlc_hello",
         true)
 {
+    //At most 256 HLC IDs can be stored, so this budget should only be reached if many different IDs were used
+    memory_budget_id = MemoryBudget::Instance().register_component(
+        "hlc_ready",
+        16 * 1024,
+        [this](){ return get_memory_footprint(); },
+        [this](size_t max_bytes){ evict_oldest(max_bytes); }
+    );
+}
+
+HLCReadyAggregator::~HLCReadyAggregator()
+{
+    MemoryBudget::Instance().unregister_component(memory_budget_id);
+}
+
+size_t HLCReadyAggregator::get_memory_footprint_locked()
+{
+    return hlc_map.size() * (sizeof(uint8_t) + sizeof(uint64_t) + MemoryBudget::MAP_NODE_OVERHEAD)
+        + (hlc_script_running.size() + hlc_middleware_running.size()) * (sizeof(uint8_t) + sizeof(bool) + MemoryBudget::MAP_NODE_OVERHEAD);
+}
+
+size_t HLCReadyAggregator::get_memory_footprint()
+{
+    std::lock_guard<std::mutex> lock(hlc_list_mutex);
+    return get_memory_footprint_locked();
+}
+
+void HLCReadyAggregator::evict_oldest(size_t max_bytes)
+{
+    //Log after the lock was released, s.t. the logger does not block other users of the HLC list
+    std::vector<uint8_t> removed_ids;
+    {
+        std::lock_guard<std::mutex> lock(hlc_list_mutex);
+
+        //Entries of the program state maps for IDs that are not in hlc_map anymore are not needed
+        for (auto iterator = hlc_script_running.begin(); iterator != hlc_script_running.end();)
+        {
+            if (hlc_map.find(iterator->first) == hlc_map.end()) iterator = hlc_script_running.erase(iterator);
+            else ++iterator;
+        }
+        for (auto iterator = hlc_middleware_running.begin(); iterator != hlc_middleware_running.end();)
+        {
+            if (hlc_map.find(iterator->first) == hlc_map.end()) iterator = hlc_middleware_running.erase(iterator);
+            else ++iterator;
+        }
+
+        //Then remove the HLCs that were updated least recently
+        while (get_memory_footprint_locked() > max_bytes && !hlc_map.empty())
+        {
+            auto oldest = std::min_element(hlc_map.begin(), hlc_map.end(),
+                [](const std::pair<const uint8_t, uint64_t>& a, const std::pair<const uint8_t, uint64_t>& b) { return a.second < b.second; });
+
+            removed_ids.push_back(oldest->first);
+
+            hlc_script_running.erase(oldest->first);
+            hlc_middleware_running.erase(oldest->first);
+            hlc_map.erase(oldest);
+        }
+    }
+
+    for (uint8_t id : removed_ids)
+    {
+        CPM_LOG(2, "HLC %s removed due to the memory budget of the LCC", std::to_string(static_cast<int>(id)).c_str());
+    }
 }
 
 std::vector<std::string> HLCReadyAggregator::get_hlc_ids_string()
@@ -79,7 +142,7 @@ std::vector<uint8_t> HLCReadyAggregator::get_hlc_ids_uint8_t()
         }
         else
         {
-            cpm::Logging::Instance().write(1, "HLC / NUC crashed / now offline / missed online message: %s", std::to_string(static_cast<int>(iterator->first)).c_str());
+            CPM_LOG(1, "HLC / NUC crashed / now offline / missed online message: %s", std::to_string(static_cast<int>(iterator->first)).c_str());
             iterator = hlc_map.erase(iterator);
         }
         
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <mutex>
 #include <sstream>
@@ -14,6 +15,8 @@
 #include "cpm/get_time_ns.hpp"
 #include "cpm/AsyncReader.hpp"
 
+#include "MemoryBudget.hpp"
+
 /**
  * \brief This class collects all the HLCHello messages sent by the HLCs (NUCs) to present the GUI user the NUCs (/IDs) that are currently online
  * This class can also be used to just retrieve the currently available IDs for distribution of scripts on several NUCs
@@ -39,9 +42,37 @@ private:
     //! The HLCs send a signal every second, so they are probably offline if no signal was received within 3 seconds
     const uint64_t time_to_live_ns = 3000000000;
 
+    //! ID of this aggregator in MemoryBudget
+    uint64_t memory_budget_id;
+
+    /**
+     * \brief Estimated memory footprint of the stored HLC entries, hlc_list_mutex must be locked
+     */
+    size_t get_memory_footprint_locked();
+
+    /**
+     * \brief Get the estimated memory footprint of the stored HLC entries, for MemoryBudget
+     */
+    size_t get_memory_footprint();
+
+    /**
+     * \brief Remove program states of HLCs that are no longer stored, then the HLCs that were updated least recently, 
+     * until the footprint is at most max_bytes, for MemoryBudget
+     * \param max_bytes Desired maximum footprint in bytes
+     */
+    void evict_oldest(size_t max_bytes);
+
 public:
+    /**
+     * \brief Constructor, sets up the reader for HLCHello messages and registers the aggregator in MemoryBudget
+     */
     HLCReadyAggregator();
 
+    /**
+     * \brief Destructor, unregisters the aggregator from MemoryBudget
+     */
+    ~HLCReadyAggregator();
+
     /**
      * \brief Gets currently online NUCs and checks if a NUC has crashed based on currently stored HLC entries and time to live
      * \return NUC IDs as strings
@@ -5,12 +5,58 @@
  * \ingroup lcc
  */
 
+LCCErrorLogger::LCCErrorLogger()
+{
+    //Error messages are only stored once, so this budget is only reached if messages contain e.g. changing values
+    memory_budget_id = MemoryBudget::Instance().register_component(
+        "lcc_errors",
+        1024 * 1024,
+        [this](){ return get_memory_footprint(); },
+        [this](size_t max_bytes){ evict_oldest(max_bytes); }
+    );
+}
+
+LCCErrorLogger::~LCCErrorLogger()
+{
+    MemoryBudget::Instance().unregister_component(memory_budget_id);
+}
+
 LCCErrorLogger& LCCErrorLogger::Instance()
 {
     static LCCErrorLogger instance;
     return instance;
 }
 
+size_t LCCErrorLogger::get_entry_footprint(const std::string& error, const std::string& timestamp)
+{
+    //Stored in error_storage, error_order and error_sequence (messages in new_error_storage are usually taken soon by the UI and are not counted)
+    return 3 * error.size() + timestamp.size() + sizeof(uint64_t) * 2 + 3 * (sizeof(std::string) + MemoryBudget::MAP_NODE_OVERHEAD);
+}
+
+size_t LCCErrorLogger::get_memory_footprint()
+{
+    std::lock_guard<std::mutex> lock(error_storage_mutex);
+    return error_storage_bytes;
+}
+
+void LCCErrorLogger::evict_oldest(size_t max_bytes)
+{
+    std::lock_guard<std::mutex> lock(error_storage_mutex);
+    std::lock_guard<std::mutex> lock2(new_error_storage_mutex);
+
+    while (error_storage_bytes > max_bytes && !error_order.empty())
+    {
+        auto oldest = error_order.begin();
+        auto entry = error_storage.find(oldest->second);
+
+        error_storage_bytes -= get_entry_footprint(entry->first, entry->second);
+        new_error_storage.erase(oldest->second);
+        error_sequence.erase(oldest->second);
+        error_storage.erase(entry);
+        error_order.erase(oldest);
+    }
+}
+
 std::string LCCErrorLogger::get_timestamp_string()
 {
     auto c_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
@@ -28,11 +74,23 @@ void LCCErrorLogger::log_error(std::string error)
     std::string timestamp = get_timestamp_string();
 
     //String is only new if it has not been added before
-    if (error_storage.find(error) == error_storage.end())
+    auto entry = error_storage.find(error);
+    if (entry == error_storage.end())
     {
         new_error_storage[error] = timestamp;
     }
+    else
+    {
+        error_storage_bytes -= get_entry_footprint(entry->first, entry->second);
+        error_order.erase(error_sequence.at(error));
+    }
     error_storage[error] = timestamp;
+    error_storage_bytes += get_entry_footprint(error, timestamp);
+
+    //Remember that the message was emitted most recently
+    error_order[next_error_sequence] = error;
+    error_sequence[error] = next_error_sequence;
+    ++next_error_sequence;
 }
 
 std::unordered_map<std::string, std::string> LCCErrorLogger::get_all_errors()
@@ -59,4 +117,7 @@ void LCCErrorLogger::reset()
 
     error_storage.clear();
     new_error_storage.clear();
+    error_order.clear();
+    error_sequence.clear();
+    error_storage_bytes = 0;
 }
\ No newline at end of file
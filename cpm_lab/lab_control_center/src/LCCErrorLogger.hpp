@@ -16,6 +16,8 @@
 
 #include <glib.h>
 
+#include "MemoryBudget.hpp"
+
 /**
  * \brief LCCErrorLogger is a Singleton class that is used throughout the LCC to log error messages that would else be shown in the console, which might not be directly related to the simulation
  * (For this reason, cpm::Logging is not used)
@@ -38,10 +40,45 @@ private:
     //! Mutex for new_error_storage
     std::mutex new_error_storage_mutex;
 
+    //! Order in which the messages in error_storage were last emitted (sequence number -> error message), to evict the oldest messages first
+    std::map<uint64_t, std::string> error_order;
+    //! Sequence number of each message in error_storage (error message -> sequence number), to find its entry in error_order
+    std::unordered_map<std::string, uint64_t> error_sequence;
+    //! Sequence number for the next emitted message
+    uint64_t next_error_sequence = 0;
+    //! Estimated memory footprint of all stored messages, uses error_storage_mutex
+    size_t error_storage_bytes = 0;
+    //! ID of the logger in MemoryBudget
+    uint64_t memory_budget_id;
+
+    /**
+     * \brief Constructor, made private s.t. singleton property is fulfilled. Registers the logger in MemoryBudget.
+     */
+    LCCErrorLogger();
+
+    /**
+     * \brief Destructor, unregisters the logger from MemoryBudget
+     */
+    ~LCCErrorLogger();
+
+    /**
+     * \brief Estimated memory footprint of a stored error message (in all maps)
+     * \param error The error message
+     * \param timestamp Its timestamp string
+     */
+    static size_t get_entry_footprint(const std::string& error, const std::string& timestamp);
+
+    /**
+     * \brief Get the estimated memory footprint of all stored error messages, for MemoryBudget
+     */
+    size_t get_memory_footprint();
+
     /**
-     * \brief Constructor, made private s.t. singleton property is fulfilled
+     * \brief Evict the error messages that were emitted least recently until the footprint is at most max_bytes, for MemoryBudget.
+     * Messages that are evicted are shown as new again if they are emitted again.
+     * \param max_bytes Desired maximum footprint in bytes
      */
-    LCCErrorLogger() {};
+    void evict_oldest(size_t max_bytes);
 
     /**
      * \brief A simple function relying on std::chrono to get the current time in Hours:Minutes:Seconds
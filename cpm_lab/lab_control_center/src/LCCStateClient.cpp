@@ -0,0 +1,243 @@
+#include "LCCStateClient.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * \file LCCStateClient.cpp
+ * \ingroup lcc
+ */
+
+LCCStateClient::LCCStateClient(std::string _socket_path)
+:socket_path(_socket_path)
+{
+    running.store(true);
+    client_thread = std::thread(&LCCStateClient::run, this);
+}
+
+LCCStateClient::~LCCStateClient()
+{
+    running.store(false);
+    if (client_thread.joinable())
+    {
+        client_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(fd_mutex);
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool LCCStateClient::connect_to_service()
+{
+    sockaddr_un address;
+    if (socket_path.size() >= sizeof(address.sun_path)) return false;
+
+    int new_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (new_fd < 0) return false;
+
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    //Do not send commands to (or show the data of) a service of a different user that took over the socket path
+    if (connect(new_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || !lcc_state_peer_is_same_user(new_fd))
+    {
+        close(new_fd);
+        return false;
+    }
+
+    //The indices of the time series are only valid for a single connection
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        vehicle_data.clear();
+        series_by_index.clear();
+        hlc_ids.clear();
+        logs.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(fd_mutex);
+    fd = new_fd;
+    connected.store(true);
+    return true;
+}
+
+void LCCStateClient::handle_frame(uint8_t type, LCCStateFrameReader& reader)
+{
+    std::lock_guard<std::mutex> lock(data_mutex);
+
+    switch (type)
+    {
+        case FrameSeriesInfo:
+        {
+            uint16_t index;
+            uint8_t vehicle_id;
+            std::string key, name, format, unit;
+            if (!(reader.get(index) && reader.get(vehicle_id) && reader.get_string(key) && reader.get_string(name)
+                && reader.get_string(format) && reader.get_string(unit))) return;
+
+            auto series = std::make_shared<TimeSeries>(name, format, unit);
+            series_by_index[index] = series;
+            vehicle_data[vehicle_id][key] = series;
+            break;
+        }
+        case FrameSamples:
+        {
+            uint32_t count;
+            if (!reader.get(count)) return;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint16_t index;
+                uint64_t time;
+                double value;
+                if (!(reader.get(index) && reader.get(time) && reader.get(value))) return;
+
+                auto series = series_by_index.find(index);
+                if (series != series_by_index.end())
+                {
+                    series->second->push_sample(time, value);
+                }
+            }
+            break;
+        }
+        case FrameTimer:
+        {
+            uint8_t simulated_time;
+            uint64_t current_time;
+            if (!(reader.get(simulated_time) && reader.get(current_time))) return;
+            timer_state.simulated_time = (simulated_time != 0);
+            timer_state.current_time = current_time;
+            break;
+        }
+        case FrameHLCIds:
+        {
+            uint32_t count;
+            if (!reader.get(count)) return;
+            std::vector<uint8_t> ids;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint8_t id;
+                if (!reader.get(id)) return;
+                ids.push_back(id);
+            }
+            hlc_ids = ids;
+            break;
+        }
+        case FrameLogs:
+        {
+            uint32_t count;
+            if (!reader.get(count)) return;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                LCCStateLogEntry log;
+                if (!(reader.get_string(log.id) && reader.get_string(log.content) && reader.get(log.stamp) && reader.get(log.level))) return;
+                logs.push_back(log);
+            }
+            while (logs.size() > max_logs)
+            {
+                logs.pop_front();
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void LCCStateClient::run()
+{
+    std::vector<char> receive_buffer;
+    char buffer[4096];
+
+    while (running.load())
+    {
+        if (!connected.load())
+        {
+            if (!connect_to_service())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                continue;
+            }
+            receive_buffer.clear();
+        }
+
+        //Wait for data, but check the stop condition regularly
+        pollfd poll_fd;
+        poll_fd.fd = fd;
+        poll_fd.events = POLLIN;
+        if (poll(&poll_fd, 1, 100) <= 0) continue;
+
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0)
+        {
+            //Service stopped / restarted
+            std::lock_guard<std::mutex> lock(fd_mutex);
+            close(fd);
+            fd = -1;
+            connected.store(false);
+            continue;
+        }
+
+        receive_buffer.insert(receive_buffer.end(), buffer, buffer + received);
+
+        uint8_t type;
+        size_t payload_offset;
+        size_t payload_size;
+        while (LCCStateFrameReader::next_frame(receive_buffer, type, payload_offset, payload_size))
+        {
+            LCCStateFrameReader reader(receive_buffer.data() + payload_offset, payload_size);
+            handle_frame(type, reader);
+            receive_buffer.erase(receive_buffer.begin(), receive_buffer.begin() + payload_offset + payload_size);
+        }
+    }
+}
+
+bool LCCStateClient::is_connected()
+{
+    return connected.load();
+}
+
+bool LCCStateClient::send_command(LCCStateCommand command)
+{
+    LCCStateFrameWriter writer;
+    writer.begin_frame(FrameCommand);
+    writer.put(static_cast<uint8_t>(command));
+    writer.end_frame();
+
+    std::lock_guard<std::mutex> lock(fd_mutex);
+    if (fd < 0) return false;
+
+    const auto& buffer = writer.get_buffer();
+    return send(fd, buffer.data(), buffer.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(buffer.size());
+}
+
+VehicleData LCCStateClient::get_vehicle_data()
+{
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return vehicle_data;
+}
+
+std::vector<uint8_t> LCCStateClient::get_hlc_ids()
+{
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return hlc_ids;
+}
+
+LCCStateTimer LCCStateClient::get_timer_state()
+{
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return timer_state;
+}
+
+std::vector<LCCStateLogEntry> LCCStateClient::get_logs()
+{
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return std::vector<LCCStateLogEntry>(logs.begin(), logs.end());
+}
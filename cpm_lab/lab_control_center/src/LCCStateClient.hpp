@@ -0,0 +1,116 @@
+#pragma once
+
+#include "defaults.hpp"
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LCCStateProtocol.hpp"
+#include "LCCStateService.hpp"
+#include "TimeSeries.hpp"
+
+/**
+ * \class LCCStateClient
+ * \brief Used by a detached UI to mirror the state of a headless LCC (see LCCStateService), and to send commands to it.
+ * The received samples are stored in TimeSeries objects, s.t. the mirrored data can be used like the data of the TimeSeriesAggregator
+ * (e.g. by the MapViewUi). If the connection is lost (e.g. the service was restarted), the client reconnects automatically.
+ * \ingroup lcc
+ */
+class LCCStateClient {
+private:
+    //! Path of the Unix domain socket of the service
+    std::string socket_path;
+    //! Socket of the connection, -1 if not connected
+    int fd = -1;
+    //! Mutex for fd (sending commands happens in the UI thread)
+    std::mutex fd_mutex;
+    //! If the client is connected to the service
+    std::atomic_bool connected{false};
+
+    //! Mutex for the mirrored data
+    std::mutex data_mutex;
+    //! Mirrored time series of all vehicles
+    VehicleData vehicle_data;
+    //! Mirrored time series by the index used in the protocol
+    std::map<uint16_t, std::shared_ptr<TimeSeries>> series_by_index;
+    //! Mirrored HLC IDs
+    std::vector<uint8_t> hlc_ids;
+    //! Mirrored timer state
+    LCCStateTimer timer_state;
+    //! Received logs (the newest max_logs)
+    std::deque<LCCStateLogEntry> logs;
+    //! Maximum size of logs
+    static constexpr size_t max_logs = 1000;
+
+    //! Connects to the service and receives its updates
+    std::thread client_thread;
+    //! Stop condition for client_thread
+    std::atomic_bool running{false};
+
+    /**
+     * \brief Try to connect to the service
+     * \return True if the connection was established
+     */
+    bool connect_to_service();
+
+    /**
+     * \brief Apply a received frame to the mirrored data
+     * \param type Type of the frame
+     * \param reader Reader for the payload of the frame
+     */
+    void handle_frame(uint8_t type, LCCStateFrameReader& reader);
+
+    /**
+     * \brief Loop of client_thread: Connect, receive, reconnect
+     */
+    void run();
+
+public:
+    /**
+     * \brief Constructor, starts connecting to the service
+     * \param _socket_path Path of the Unix domain socket of the service, see LCCStateService::default_socket_path
+     */
+    LCCStateClient(std::string _socket_path);
+
+    /**
+     * \brief Destructor, closes the connection
+     */
+    ~LCCStateClient();
+
+    /**
+     * \brief If the client is currently connected to the service
+     */
+    bool is_connected();
+
+    /**
+     * \brief Send a command to the service
+     * \param command The command
+     * \return False if the client is not connected or the command could not be sent
+     */
+    bool send_command(LCCStateCommand command);
+
+    /**
+     * \brief Mirrored time series of all vehicles, see TimeSeriesAggregator::get_vehicle_data
+     */
+    VehicleData get_vehicle_data();
+
+    /**
+     * \brief Mirrored IDs of the connected HLCs
+     */
+    std::vector<uint8_t> get_hlc_ids();
+
+    /**
+     * \brief Mirrored timer state
+     */
+    LCCStateTimer get_timer_state();
+
+    /**
+     * \brief Received logs (up to the 1000 newest)
+     */
+    std::vector<LCCStateLogEntry> get_logs();
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <sys/socket.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * \file LCCStateProtocol.hpp
+ * \brief Binary protocol between the headless LCC service (LCCStateService) and a detached UI (LCCStateClient),
+ * via a local (Unix domain) stream socket. Each frame consists of the payload length (uint32_t), the frame type (uint8_t) and the payload.
+ * The service only sends deltas: Time series are announced once (FrameSeriesInfo) and then referenced by a short index,
+ * only new samples are sent (FrameSamples), the timer state and HLC IDs only when they change.
+ * Both sides run on the same machine, so values are sent in host byte order.
+ * Both sides only talk to processes of the same user (see lcc_state_peer_is_same_user), as the commands control the lab.
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Check the credentials of the process on the other side of a connected Unix domain socket
+ * \param fd The socket
+ * \return True if the other process runs as the same (effective) user as this process
+ * \ingroup lcc
+ */
+inline bool lcc_state_peer_is_same_user(int fd)
+{
+    ucred credentials;
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0 || length != sizeof(credentials)) return false;
+    return credentials.uid == geteuid();
+}
+
+/**
+ * \brief Types of frames
+ * \ingroup lcc
+ */
+enum LCCStateFrameType : uint8_t {
+    FrameSeriesInfo = 1,    //!< Service -> UI: index (uint16_t), vehicle ID (uint8_t), key, name, format, unit (strings)
+    FrameSamples = 2,       //!< Service -> UI: count (uint32_t), then per sample index (uint16_t), time (uint64_t), value (double)
+    FrameTimer = 3,         //!< Service -> UI: simulated time (uint8_t), current time (uint64_t)
+    FrameHLCIds = 4,        //!< Service -> UI: count (uint32_t), then the IDs (uint8_t)
+    FrameLogs = 5,          //!< Service -> UI: count (uint32_t), then per log entry ID, content (strings), stamp (uint64_t), level (uint8_t)
+    FrameCommand = 6        //!< UI -> Service: command (uint8_t, see LCCStateCommand)
+};
+
+/**
+ * \brief Commands that a detached UI can send to the service
+ * \ingroup lcc
+ */
+enum LCCStateCommand : uint8_t {
+    CommandStartTimer = 1,  //!< Send the start signal (TimerTrigger)
+    CommandStopTimer = 2,   //!< Send the stop signal (TimerTrigger)
+    CommandShutdown = 3     //!< Stop the headless service
+};
+
+/**
+ * \struct LCCStateLogEntry
+ * \brief Log message in a form that does not depend on DDS
+ * \ingroup lcc
+ */
+struct LCCStateLogEntry {
+    //! ID of the sender
+    std::string id;
+    //! Log content
+    std::string content;
+    //! Creation time in ns
+    uint64_t stamp = 0;
+    //! Log level
+    uint8_t level = 0;
+};
+
+/**
+ * \struct LCCStateTimer
+ * \brief Timer state of the LCC
+ * \ingroup lcc
+ */
+struct LCCStateTimer {
+    //! If simulated time is used
+    bool simulated_time = false;
+    //! Current (simulated) time in ns
+    uint64_t current_time = 0;
+
+    //! Compare two timer states
+    bool operator==(const LCCStateTimer& other) const
+    {
+        return simulated_time == other.simulated_time && current_time == other.current_time;
+    }
+};
+
+/**
+ * \class LCCStateFrameWriter
+ * \brief Appends frames to a buffer
+ * \ingroup lcc
+ */
+class LCCStateFrameWriter {
+private:
+    //! Serialized frames
+    std::vector<char> buffer;
+    //! Position of the length field of the current frame
+    size_t frame_start = 0;
+
+public:
+    /**
+     * \brief Start a new frame, must be finished with end_frame
+     * \param type Type of the frame
+     */
+    void begin_frame(LCCStateFrameType type)
+    {
+        frame_start = buffer.size();
+        put(static_cast<uint32_t>(0));
+        put(static_cast<uint8_t>(type));
+    }
+
+    /**
+     * \brief Finish the current frame (sets its length)
+     */
+    void end_frame()
+    {
+        uint32_t length = static_cast<uint32_t>(buffer.size() - frame_start - sizeof(uint32_t) - sizeof(uint8_t));
+        std::memcpy(buffer.data() + frame_start, &length, sizeof(length));
+    }
+
+    /**
+     * \brief Append an arithmetic value to the current frame
+     * \param value The value
+     */
+    template<typename T> void put(T value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be written directly");
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * \brief Append a string (uint16_t length, then the characters, longer strings are cut) to the current frame
+     * \param value The string
+     */
+    void put_string(const std::string& value)
+    {
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+        put(length);
+        buffer.insert(buffer.end(), value.data(), value.data() + length);
+    }
+
+    /**
+     * \brief Serialized frames
+     */
+    const std::vector<char>& get_buffer() const
+    {
+        return buffer;
+    }
+
+    /**
+     * \brief Remove all frames
+     */
+    void clear()
+    {
+        buffer.clear();
+        frame_start = 0;
+    }
+};
+
+/**
+ * \class LCCStateFrameReader
+ * \brief Reads the payload of a single frame
+ * \ingroup lcc
+ */
+class LCCStateFrameReader {
+private:
+    //! Payload of the frame
+    const char* data;
+    //! Size of the payload
+    size_t size;
+    //! Read position
+    size_t position = 0;
+
+public:
+    /**
+     * \brief Constructor
+     * \param _data Payload of the frame, must stay valid while reading
+     * \param _size Size of the payload
+     */
+    LCCStateFrameReader(const char* _data, size_t _size)
+    :data(_data)
+    ,size(_size)
+    {
+    }
+
+    /**
+     * \brief Read an arithmetic value
+     * \param value Is set to the value
+     * \return False if the payload is too short
+     */
+    template<typename T> bool get(T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be read directly");
+        if (position + sizeof(T) > size) return false;
+        std::memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    /**
+     * \brief Read a string
+     * \param value Is set to the string
+     * \return False if the payload is too short
+     */
+    bool get_string(std::string& value)
+    {
+        uint16_t length = 0;
+        if (!get(length) || position + length > size) return false;
+        value.assign(data + position, length);
+        position += length;
+        return true;
+    }
+
+    /**
+     * \brief Find the next complete frame in a receive buffer
+     * \param buffer Received bytes, starting with a frame
+     * \param type Is set to the type of the frame
+     * \param payload_offset Is set to the position of the payload in buffer
+     * \param payload_size Is set to the size of the payload
+     * \return False if the buffer does not (yet) contain a complete frame
+     */
+    static bool next_frame(const std::vector<char>& buffer, uint8_t& type, size_t& payload_offset, size_t& payload_size)
+    {
+        const size_t header_size = sizeof(uint32_t) + sizeof(uint8_t);
+        if (buffer.size() < header_size) return false;
+
+        uint32_t length = 0;
+        std::memcpy(&length, buffer.data(), sizeof(length));
+        if (buffer.size() < header_size + length) return false;
+
+        std::memcpy(&type, buffer.data() + sizeof(uint32_t), sizeof(type));
+        payload_offset = header_size;
+        payload_size = length;
+        return true;
+    }
+};
@@ -0,0 +1,358 @@
+#include "LCCStateService.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cpm/Logging.hpp"
+
+/**
+ * \file LCCStateService.cpp
+ * \ingroup lcc
+ */
+
+LCCStateService::LCCStateService(
+    std::string _socket_path,
+    unsigned int _update_period_ms,
+    std::function<VehicleData()> _get_vehicle_data,
+    std::function<std::vector<uint8_t>()> _get_hlc_ids,
+    std::function<std::vector<LCCStateLogEntry>()> _get_new_logs,
+    std::function<LCCStateTimer()> _get_timer_state,
+    std::function<void(LCCStateCommand)> _on_command
+)
+:socket_path(_socket_path)
+,update_period_ms(std::max(_update_period_ms, 1u))
+,get_vehicle_data(_get_vehicle_data)
+,get_hlc_ids(_get_hlc_ids)
+,get_new_logs(_get_new_logs)
+,get_timer_state(_get_timer_state)
+,on_command(_on_command)
+{
+    sockaddr_un address;
+    if (socket_path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("LCCStateService: Socket path is too long: " + socket_path);
+    }
+
+    server_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server_fd < 0)
+    {
+        throw std::runtime_error("LCCStateService: Could not create socket");
+    }
+
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    //Create the directory of the socket if necessary (e.g. the per-user directory of default_socket_path), only accessible by this user
+    size_t directory_end = socket_path.find_last_of('/');
+    if (directory_end != std::string::npos && directory_end > 0)
+    {
+        mkdir(socket_path.substr(0, directory_end).c_str(), S_IRWXU);
+    }
+
+    //Remove the socket of a previous service that was not shut down properly
+    unlink(socket_path.c_str());
+    if (bind(server_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || chmod(socket_path.c_str(), S_IRUSR | S_IWUSR) != 0
+        || listen(server_fd, 4) != 0)
+    {
+        close(server_fd);
+        throw std::runtime_error("LCCStateService: Could not listen on " + socket_path);
+    }
+
+    running.store(true);
+    service_thread = std::thread(&LCCStateService::run, this);
+}
+
+LCCStateService::~LCCStateService()
+{
+    running.store(false);
+    if (service_thread.joinable())
+    {
+        service_thread.join();
+    }
+
+    for (auto& client : clients)
+    {
+        close(client.fd);
+    }
+    close(server_fd);
+    unlink(socket_path.c_str());
+}
+
+std::string LCCStateService::default_socket_path(int dds_domain)
+{
+    //The runtime directory of the user is only accessible by the user, else use a directory of the user in /tmp
+    const char* runtime_directory = std::getenv("XDG_RUNTIME_DIR");
+    std::string directory = (runtime_directory != nullptr && runtime_directory[0] != '\0') ? 
+        std::string(runtime_directory) : 
+        "/tmp/cpm_lcc_" + std::to_string(geteuid());
+
+    return directory + "/cpm_lcc_state_" + std::to_string(dds_domain) + ".sock";
+}
+
+void LCCStateService::accept_clients()
+{
+    while (true)
+    {
+        int fd = accept4(server_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        //The socket file is only accessible by this user, but its path may be in a shared directory (--state_socket)
+        if (!lcc_state_peer_is_same_user(fd))
+        {
+            close(fd);
+            CPM_LOG(2, "%s", "LCC state service: Rejected a UI of a different user");
+            continue;
+        }
+
+        Client client;
+        client.fd = fd;
+        clients.push_back(client);
+        CPM_LOG(2, "%s", "LCC state service: UI attached");
+
+        //Recent logs for the new UI, further logs are sent with the updates
+        if (recent_logs.size() > 0)
+        {
+            LCCStateFrameWriter writer;
+            writer.begin_frame(FrameLogs);
+            writer.put(static_cast<uint32_t>(recent_logs.size()));
+            for (auto& log : recent_logs)
+            {
+                writer.put_string(log.id);
+                writer.put_string(log.content);
+                writer.put(log.stamp);
+                writer.put(log.level);
+            }
+            writer.end_frame();
+            if (!send_all(fd, writer.get_buffer()))
+            {
+                close(fd);
+                clients.pop_back();
+            }
+        }
+    }
+}
+
+bool LCCStateService::receive_commands(Client& client)
+{
+    char buffer[256];
+    while (true)
+    {
+        ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (received == 0) return false;
+        if (received < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+
+        client.receive_buffer.insert(client.receive_buffer.end(), buffer, buffer + received);
+
+        uint8_t type;
+        size_t payload_offset;
+        size_t payload_size;
+        while (LCCStateFrameReader::next_frame(client.receive_buffer, type, payload_offset, payload_size))
+        {
+            LCCStateFrameReader reader(client.receive_buffer.data() + payload_offset, payload_size);
+            uint8_t command = 0;
+            if (type == FrameCommand && reader.get(command) && on_command)
+            {
+                on_command(static_cast<LCCStateCommand>(command));
+            }
+            client.receive_buffer.erase(client.receive_buffer.begin(), client.receive_buffer.begin() + payload_offset + payload_size);
+        }
+    }
+}
+
+bool LCCStateService::send_update(Client& client, const VehicleData& vehicle_data, const std::vector<uint8_t>& hlc_ids, const LCCStateTimer& timer, const std::vector<LCCStateLogEntry>& new_logs)
+{
+    LCCStateFrameWriter writer;
+
+    //Time series: Announce new ones, then send the newest sample of each series that changed
+    std::vector<std::pair<uint16_t, std::shared_ptr<TimeSeries>>> changed_series;
+    for (auto& vehicle_entry : vehicle_data)
+    {
+        for (auto& series_entry : vehicle_entry.second)
+        {
+            auto& series = series_entry.second;
+            if (!series || !series->has_data()) continue;
+
+            auto key = std::make_pair(vehicle_entry.first, series_entry.first);
+            auto index_entry = series_indices.find(key);
+            if (index_entry == series_indices.end())
+            {
+                if (series_indices.size() > UINT16_MAX) continue;
+                index_entry = series_indices.emplace(key, static_cast<uint16_t>(series_indices.size())).first;
+            }
+            uint16_t index = index_entry->second;
+
+            auto sent_entry = client.sent_sample_times.find(index);
+            if (sent_entry == client.sent_sample_times.end())
+            {
+                writer.begin_frame(FrameSeriesInfo);
+                writer.put(index);
+                writer.put(vehicle_entry.first);
+                writer.put_string(series_entry.first);
+                writer.put_string(series->get_name());
+                writer.put_string(series->get_format());
+                writer.put_string(series->get_unit());
+                writer.end_frame();
+                sent_entry = client.sent_sample_times.emplace(index, 0).first;
+            }
+
+            if (series->get_latest_time() > sent_entry->second)
+            {
+                changed_series.push_back(std::make_pair(index, series));
+                sent_entry->second = series->get_latest_time();
+            }
+        }
+    }
+
+    if (changed_series.size() > 0)
+    {
+        writer.begin_frame(FrameSamples);
+        writer.put(static_cast<uint32_t>(changed_series.size()));
+        for (auto& entry : changed_series)
+        {
+            writer.put(entry.first);
+            writer.put(entry.second->get_latest_time());
+            writer.put(entry.second->get_latest_value());
+        }
+        writer.end_frame();
+    }
+
+    if (!client.timer_sent || !(client.sent_timer == timer))
+    {
+        writer.begin_frame(FrameTimer);
+        writer.put(static_cast<uint8_t>(timer.simulated_time));
+        writer.put(timer.current_time);
+        writer.end_frame();
+        client.sent_timer = timer;
+        client.timer_sent = true;
+    }
+
+    if (!client.hlc_ids_sent || client.sent_hlc_ids != hlc_ids)
+    {
+        writer.begin_frame(FrameHLCIds);
+        writer.put(static_cast<uint32_t>(hlc_ids.size()));
+        for (auto id : hlc_ids)
+        {
+            writer.put(id);
+        }
+        writer.end_frame();
+        client.sent_hlc_ids = hlc_ids;
+        client.hlc_ids_sent = true;
+    }
+
+    if (new_logs.size() > 0)
+    {
+        writer.begin_frame(FrameLogs);
+        writer.put(static_cast<uint32_t>(new_logs.size()));
+        for (auto& log : new_logs)
+        {
+            writer.put_string(log.id);
+            writer.put_string(log.content);
+            writer.put(log.stamp);
+            writer.put(log.level);
+        }
+        writer.end_frame();
+    }
+
+    if (writer.get_buffer().empty()) return true;
+    return send_all(client.fd, writer.get_buffer());
+}
+
+bool LCCStateService::send_all(int fd, const std::vector<char>& buffer)
+{
+    size_t sent = 0;
+    int blocked_waits = 0;
+    while (sent < buffer.size())
+    {
+        ssize_t result = send(fd, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+        if (result > 0)
+        {
+            sent += static_cast<size_t>(result);
+            continue;
+        }
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            //The UI does not read fast enough - wait a bit, but a frozen UI must not block the service
+            if (++blocked_waits > 3) return false;
+
+            pollfd poll_fd;
+            poll_fd.fd = fd;
+            poll_fd.events = POLLOUT;
+            poll(&poll_fd, 1, static_cast<int>(update_period_ms));
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+void LCCStateService::run()
+{
+    auto next_update = std::chrono::steady_clock::now();
+    while (running.load())
+    {
+        next_update += std::chrono::milliseconds(update_period_ms);
+
+        accept_clients();
+
+        //Commands of the UIs
+        for (auto client = clients.begin(); client != clients.end();)
+        {
+            if (receive_commands(*client))
+            {
+                ++client;
+            }
+            else
+            {
+                close(client->fd);
+                client = clients.erase(client);
+                CPM_LOG(2, "%s", "LCC state service: UI detached");
+            }
+        }
+
+        //Obtain the data once for all UIs
+        std::vector<LCCStateLogEntry> new_logs;
+        if (get_new_logs) new_logs = get_new_logs();
+        recent_logs.insert(recent_logs.end(), new_logs.begin(), new_logs.end());
+        if (recent_logs.size() > max_recent_logs)
+        {
+            recent_logs.erase(recent_logs.begin(), recent_logs.end() - max_recent_logs);
+        }
+
+        if (clients.size() > 0)
+        {
+            VehicleData vehicle_data;
+            if (get_vehicle_data) vehicle_data = get_vehicle_data();
+            std::vector<uint8_t> hlc_ids;
+            if (get_hlc_ids) hlc_ids = get_hlc_ids();
+            LCCStateTimer timer;
+            if (get_timer_state) timer = get_timer_state();
+
+            for (auto client = clients.begin(); client != clients.end();)
+            {
+                if (send_update(*client, vehicle_data, hlc_ids, timer, new_logs))
+                {
+                    ++client;
+                }
+                else
+                {
+                    close(client->fd);
+                    client = clients.erase(client);
+                    CPM_LOG(2, "%s", "LCC state service: Disconnected a UI that did not receive its updates");
+                }
+            }
+        }
+
+        std::this_thread::sleep_until(next_update);
+    }
+}
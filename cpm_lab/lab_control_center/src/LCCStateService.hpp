@@ -0,0 +1,156 @@
+#pragma once
+
+#include "defaults.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LCCStateProtocol.hpp"
+#include "TimeSeries.hpp"
+
+/**
+ * \brief Definition for VehicleData, see TimeSeriesAggregator
+ * \ingroup lcc
+ */
+using VehicleData = map<uint8_t, map<string, shared_ptr<TimeSeries> > >;
+
+/**
+ * \class LCCStateService
+ * \brief Makes the state of a (headless) LCC available to detached UIs of the same user on the same machine, see LCCStateProtocol.hpp.
+ * Only the state needed by the map view and the timer controls is mirrored (see AttachedWindowUi); the other tabs of the LCC UI
+ * (setup, parameters, logs, monitoring, commonroad) are not available to detached UIs.
+ * UIs connect to a Unix domain socket. Regularly, each connected UI receives the changes since its last update
+ * (new time series, newest samples, timer state, HLC IDs, new logs), and commands of the UIs are passed to a callback.
+ * A UI can be closed and attached again at any time without affecting the service; slow or frozen UIs are disconnected
+ * instead of blocking the service.
+ * The data is obtained with callbacks, s.t. this class does not depend on the aggregators or DDS.
+ * \ingroup lcc
+ */
+class LCCStateService {
+private:
+    /**
+     * \brief State of a connected UI
+     */
+    struct Client {
+        //! Socket of the connection
+        int fd = -1;
+        //! Time series indices that were already announced to the UI -> time of the last sample sent
+        std::map<uint16_t, uint64_t> sent_sample_times;
+        //! Last timer state sent to the UI
+        LCCStateTimer sent_timer;
+        //! If the timer state was sent yet
+        bool timer_sent = false;
+        //! Last HLC IDs sent to the UI
+        std::vector<uint8_t> sent_hlc_ids;
+        //! If the HLC IDs were sent yet
+        bool hlc_ids_sent = false;
+        //! Received bytes that do not form a complete frame yet
+        std::vector<char> receive_buffer;
+    };
+
+    //! Path of the Unix domain socket
+    std::string socket_path;
+    //! Listening socket
+    int server_fd = -1;
+    //! Time between two updates of the UIs in ms
+    unsigned int update_period_ms;
+
+    //! Returns the time series of all vehicles
+    std::function<VehicleData()> get_vehicle_data;
+    //! Returns the IDs of the connected HLCs
+    std::function<std::vector<uint8_t>()> get_hlc_ids;
+    //! Returns the logs that were received since the last call
+    std::function<std::vector<LCCStateLogEntry>()> get_new_logs;
+    //! Returns the current timer state
+    std::function<LCCStateTimer()> get_timer_state;
+    //! Called for each command received from a UI
+    std::function<void(LCCStateCommand)> on_command;
+
+    //! Connected UIs, only accessed by service_thread
+    std::vector<Client> clients;
+    //! Index of each time series (vehicle ID, key), s.t. samples can reference it with few bytes
+    std::map<std::pair<uint8_t, std::string>, uint16_t> series_indices;
+    //! Recent logs, sent to UIs when they attach
+    std::vector<LCCStateLogEntry> recent_logs;
+    //! Maximum size of recent_logs
+    static constexpr size_t max_recent_logs = 100;
+
+    //! Accepts UIs and sends the updates
+    std::thread service_thread;
+    //! Stop condition for service_thread
+    std::atomic_bool running{false};
+
+    /**
+     * \brief Accept all pending connections of UIs
+     */
+    void accept_clients();
+
+    /**
+     * \brief Read and handle the commands of a UI
+     * \param client The UI
+     * \return False if the connection was closed
+     */
+    bool receive_commands(Client& client);
+
+    /**
+     * \brief Create the update for a UI (all changes since its last update) and send it
+     * \param client The UI
+     * \param vehicle_data Current time series
+     * \param hlc_ids Current HLC IDs
+     * \param timer Current timer state
+     * \param new_logs Logs since the last update
+     * \return False if the update could not be sent
+     */
+    bool send_update(Client& client, const VehicleData& vehicle_data, const std::vector<uint8_t>& hlc_ids, const LCCStateTimer& timer, const std::vector<LCCStateLogEntry>& new_logs);
+
+    /**
+     * \brief Write all bytes to a socket, without blocking for longer than a few update periods
+     * \param fd The socket
+     * \param buffer The bytes
+     * \return False if the bytes could not be sent
+     */
+    bool send_all(int fd, const std::vector<char>& buffer);
+
+    /**
+     * \brief Update loop of service_thread
+     */
+    void run();
+
+public:
+    /**
+     * \brief Constructor, starts the service
+     * \param _socket_path Path of the Unix domain socket (an old socket file at this path is removed, a missing directory is created);
+     * only UIs of the same user are accepted
+     * \param _update_period_ms Time between two updates of the UIs in ms
+     * \param _get_vehicle_data Returns the time series of all vehicles
+     * \param _get_hlc_ids Returns the IDs of the connected HLCs
+     * \param _get_new_logs Returns the logs that were received since the last call
+     * \param _get_timer_state Returns the current timer state
+     * \param _on_command Called for each command received from a UI (from the service thread)
+     */
+    LCCStateService(
+        std::string _socket_path,
+        unsigned int _update_period_ms,
+        std::function<VehicleData()> _get_vehicle_data,
+        std::function<std::vector<uint8_t>()> _get_hlc_ids,
+        std::function<std::vector<LCCStateLogEntry>()> _get_new_logs,
+        std::function<LCCStateTimer()> _get_timer_state,
+        std::function<void(LCCStateCommand)> _on_command
+    );
+
+    /**
+     * \brief Destructor, disconnects all UIs and removes the socket file
+     */
+    ~LCCStateService();
+
+    /**
+     * \brief Default path of the socket for a DDS domain, in $XDG_RUNTIME_DIR or else in /tmp/cpm_lcc_<uid>,
+     * s.t. only the user that runs the LCC can attach a UI
+     * \param dds_domain The DDS domain of the LCC
+     */
+    static std::string default_socket_path(int dds_domain);
+};
@@ -30,5 +30,5 @@ void LogLevelSetter::set_log_level(unsigned short log_level)
     //Priority 1 to always show this message in the logs - 
     //it is not a critical error per se, but a level change 
     //can be crucial for debugging and should thus always be indicated
-    cpm::Logging::Instance().write(1, "Log level was changed to %i", static_cast<int>(log_level));
+    CPM_LOG(1, "Log level was changed to %i", static_cast<int>(log_level));
 }
\ No newline at end of file
@@ -8,7 +8,9 @@
 using namespace std::placeholders;
 LogStorage::LogStorage() :
     /*Set up communication*/
-    log_reader(std::bind(&LogStorage::log_callback, this, _1), "log", true)
+    log_reader(std::bind(&LogStorage::log_callback, this, _1), "log", true),
+    log_format_reader(std::bind(&LogStorage::log_format_callback, this, _1), "logFormat", true, true),
+    log_record_reader(std::bind(&LogStorage::log_record_callback, this, _1), "logRecords", true)
 {    
     file.open(filename, std::ofstream::out | std::ofstream::trunc);
     file << "ID,Timestamp,Content" << std::endl;
@@ -21,6 +23,90 @@ LogStorage::~LogStorage()
 }
 
 void LogStorage::log_callback(std::vector<Log>& samples) { 
+    store_logs(samples);
+}
+
+void LogStorage::log_format_callback(std::vector<LogFormat>& samples) {
+    std::vector<Log> decoded_logs;
+
+    {
+        std::lock_guard<std::mutex> lock(log_formats_mutex);
+        for (auto& format : samples)
+        {
+            log_formats[std::make_pair(format.session_id(), format.format_id())] = format.format();
+        }
+
+        //Retry batches that could not be decoded before
+        for (auto it = pending_record_batches.begin(); it != pending_record_batches.end();)
+        {
+            if (decode_record_batch(*it, decoded_logs))
+            {
+                it = pending_record_batches.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    if (decoded_logs.size() > 0)
+    {
+        store_logs(decoded_logs);
+    }
+}
+
+void LogStorage::log_record_callback(std::vector<LogRecordBatch>& samples) {
+    std::vector<Log> decoded_logs;
+
+    {
+        std::lock_guard<std::mutex> lock(log_formats_mutex);
+        for (auto& batch : samples)
+        {
+            if (!decode_record_batch(batch, decoded_logs))
+            {
+                pending_record_batches.push_back(batch);
+                if (pending_record_batches.size() > max_pending_record_batches)
+                {
+                    pending_record_batches.pop_front();
+                }
+            }
+        }
+    }
+
+    if (decoded_logs.size() > 0)
+    {
+        store_logs(decoded_logs);
+    }
+}
+
+bool LogStorage::decode_record_batch(const LogRecordBatch& batch, std::vector<Log>& logs_out) {
+    const auto& records = batch.records();
+    std::vector<Log> decoded_logs;
+    cpm::binary_log::DecodedRecord record;
+    size_t offset = 0;
+
+    while (offset < records.size() && cpm::binary_log::decode_record(records.data(), records.size(), offset, record))
+    {
+        auto format = log_formats.find(std::make_pair(batch.session_id(), record.format_id));
+        if (format == log_formats.end())
+        {
+            return false;
+        }
+
+        decoded_logs.push_back(Log(
+            batch.id(), 
+            cpm::binary_log::format_record(format->second, record.args), 
+            TimeStamp(record.timestamp), 
+            record.log_level
+        ));
+    }
+
+    logs_out.insert(logs_out.end(), decoded_logs.begin(), decoded_logs.end());
+    return true;
+}
+
+void LogStorage::store_logs(std::vector<Log>& samples) {
     std::lock_guard<std::mutex> lock_1(log_storage_mutex);
     std::lock_guard<std::mutex> lock_2(log_buffer_mutex); 
 
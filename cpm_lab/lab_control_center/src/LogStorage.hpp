@@ -3,6 +3,7 @@
 #include "defaults.hpp"
 #include <atomic>
 #include <cassert>
+#include <deque>
 #include <ctime>
 #include <fstream>
 #include <iostream>
@@ -21,7 +22,11 @@
 #include "cpm/Timer.hpp"
 #include "cpm/ParticipantSingleton.hpp"
 
+#include "cpm/BinaryLogRecord.hpp"
+
 #include "Log.hpp"
+#include "LogFormat.hpp"
+#include "LogRecordBatch.hpp"
 
 /**
  * \brief Used to receive and store Log messages (cpm::Logging) from all participants in the current domain
@@ -44,6 +49,43 @@ private:
     void log_callback(std::vector<Log>& samples);
     //! Async. reader to receive log messages sent within the network
     cpm::AsyncReader<Log> log_reader;
+
+    /**
+     * \brief Callback function for format strings of binary log call sites (see cpm::Logging::write_binary)
+     * \param samples The received format strings
+     */
+    void log_format_callback(std::vector<LogFormat>& samples);
+    /**
+     * \brief Callback function for batches of binary log records, which are formatted here and then stored like regular logs
+     * \param samples The received batches
+     */
+    void log_record_callback(std::vector<LogRecordBatch>& samples);
+    //! Async. reader to receive the format strings of binary log call sites, transient local s.t. late joiners get all formats
+    cpm::AsyncReader<LogFormat> log_format_reader;
+    //! Async. reader to receive batches of binary log records
+    cpm::AsyncReader<LogRecordBatch> log_record_reader;
+    //! Format strings of binary log call sites, by (session ID, format ID)
+    std::map<std::pair<uint64_t, uint32_t>, std::string> log_formats;
+    //! Batches that contain records with yet unknown formats (DDS does not guarantee the order between topics), retried when new formats arrive
+    std::deque<LogRecordBatch> pending_record_batches;
+    //! Max. number of pending batches, older ones are dropped
+    static constexpr size_t max_pending_record_batches = 100;
+    //! Mutex for accessing log_formats and pending_record_batches
+    std::mutex log_formats_mutex;
+
+    /**
+     * \brief Decode and format all records of a batch. Does not lock log_formats_mutex.
+     * \param batch The batch to decode
+     * \param logs_out The formatted log messages are appended here
+     * \return False if a record refers to a format that is not yet known; in that case, logs_out is not changed
+     */
+    bool decode_record_batch(const LogRecordBatch& batch, std::vector<Log>& logs_out);
+
+    /**
+     * \brief Store received or decoded logs in storage, buffer and log file
+     * \param logs The logs to store
+     */
+    void store_logs(std::vector<Log>& logs);
     //! Only keeps the newest logs, used when not in search-mode
     std::vector<Log> log_buffer;
     //! Keeps all logs (might delete oldest ones if some limit is reached)
@@ -0,0 +1,171 @@
+#include "MemoryBudget.hpp"
+
+#include "cpm/CommandLineReader.hpp"
+
+/**
+ * \file MemoryBudget.cpp
+ * \ingroup lcc
+ */
+
+constexpr size_t MemoryBudget::MAP_NODE_OVERHEAD;
+
+MemoryBudget& MemoryBudget::Instance()
+{
+    static MemoryBudget instance;
+    return instance;
+}
+
+MemoryBudget::~MemoryBudget()
+{
+    stop();
+}
+
+uint64_t MemoryBudget::register_component(
+    std::string name,
+    size_t default_budget_bytes,
+    std::function<size_t()> get_footprint,
+    std::function<void(size_t)> shrink_to)
+{
+    std::lock_guard<std::mutex> lock(components_mutex);
+
+    Component component;
+    component.usage.name = name;
+    component.usage.budget_bytes = default_budget_bytes;
+    component.get_footprint = get_footprint;
+    component.shrink_to = shrink_to;
+
+    auto configured_budget = configured_budgets.find(name);
+    if (configured_budget != configured_budgets.end())
+    {
+        component.usage.budget_bytes = configured_budget->second;
+    }
+
+    uint64_t id = next_component_id++;
+    components[id] = component;
+    return id;
+}
+
+void MemoryBudget::unregister_component(uint64_t id)
+{
+    //The callbacks of the component must not be running anymore when it is destroyed
+    std::lock_guard<std::mutex> callback_lock(callback_mutex);
+    std::lock_guard<std::mutex> lock(components_mutex);
+    components.erase(id);
+}
+
+void MemoryBudget::set_budget(std::string name, size_t budget_bytes)
+{
+    std::lock_guard<std::mutex> lock(components_mutex);
+
+    configured_budgets[name] = budget_bytes;
+    for (auto& entry : components)
+    {
+        if (entry.second.usage.name == name)
+        {
+            entry.second.usage.budget_bytes = budget_bytes;
+        }
+    }
+}
+
+void MemoryBudget::configure(int argc, char *argv[])
+{
+    //Copy the names and current budgets first, as set_budget locks the mutex as well
+    std::map<std::string, size_t> budgets;
+    {
+        std::lock_guard<std::mutex> lock(components_mutex);
+        for (auto& entry : components)
+        {
+            budgets[entry.second.usage.name] = entry.second.usage.budget_bytes;
+        }
+    }
+
+    for (auto& entry : budgets)
+    {
+        int budget_kb = cpm::cmd_parameter_int("memory_budget_" + entry.first + "_kb", static_cast<int>(entry.second / 1024), argc, argv);
+        if (budget_kb >= 0 && static_cast<size_t>(budget_kb) * 1024 != entry.second)
+        {
+            set_budget(entry.first, static_cast<size_t>(budget_kb) * 1024);
+        }
+    }
+}
+
+void MemoryBudget::enforce()
+{
+    std::lock_guard<std::mutex> callback_lock(callback_mutex);
+
+    //Copy the components, s.t. components_mutex is not held while they shrink (and e.g. log what they removed)
+    std::map<uint64_t, Component> current_components;
+    {
+        std::lock_guard<std::mutex> lock(components_mutex);
+        current_components = components;
+    }
+
+    for (auto& entry : current_components)
+    {
+        Component& component = entry.second;
+
+        size_t footprint = component.get_footprint();
+        bool shrunk = false;
+        if (footprint > component.usage.budget_bytes)
+        {
+            //Shrink to less than the budget, s.t. the component does not need to shrink again with the next few samples
+            component.shrink_to(component.usage.budget_bytes - component.usage.budget_bytes / 4);
+            shrunk = true;
+            footprint = component.get_footprint();
+        }
+
+        std::lock_guard<std::mutex> lock(components_mutex);
+        auto registered = components.find(entry.first);
+        if (registered != components.end())
+        {
+            if (shrunk) ++registered->second.usage.shrink_count;
+            registered->second.usage.footprint_bytes = footprint;
+        }
+    }
+}
+
+void MemoryBudget::start(uint64_t period_ms)
+{
+    stop();
+
+    std::lock_guard<std::mutex> lock(enforcement_mutex);
+    enforcement_running = true;
+    enforcement_thread = std::thread([this, period_ms] () {
+        std::unique_lock<std::mutex> thread_lock(enforcement_mutex);
+        while (enforcement_running)
+        {
+            //Do not hold the lock while enforcing, or stop() would have to wait for it
+            thread_lock.unlock();
+            enforce();
+            thread_lock.lock();
+
+            enforcement_cv.wait_for(thread_lock, std::chrono::milliseconds(period_ms), [this] { return !enforcement_running; });
+        }
+    });
+}
+
+void MemoryBudget::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(enforcement_mutex);
+        enforcement_running = false;
+    }
+    enforcement_cv.notify_all();
+
+    if (enforcement_thread.joinable())
+    {
+        enforcement_thread.join();
+    }
+}
+
+std::vector<MemoryBudget::ComponentUsage> MemoryBudget::get_usage()
+{
+    std::lock_guard<std::mutex> lock(components_mutex);
+
+    std::vector<ComponentUsage> usage;
+    for (auto& entry : components)
+    {
+        usage.push_back(entry.second.usage);
+    }
+    return usage;
+}
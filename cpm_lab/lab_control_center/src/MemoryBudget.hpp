@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief MemoryBudget is a Singleton class that keeps track of the memory used by the data that is accumulated within the LCC
+ * (received samples, error messages, visualizations, participant data...).
+ *
+ * Each component that accumulates data registers itself with a function that reports its (estimated) footprint and a function
+ * that reduces its footprint to a given number of bytes, by evicting or downsampling its oldest data. Each component has a budget,
+ * which is set on registration and can be overwritten using the command line (see configure).
+ * The budgets are enforced regularly by a thread (see start), the current usage is shown in the UI (see MonitoringUi).
+ *
+ * Important: The registered functions are called while the internal mutex is held, so they must not call any function of this class.
+ * \ingroup lcc
+ */
+class MemoryBudget {
+    MemoryBudget(MemoryBudget const&) = delete;
+    MemoryBudget(MemoryBudget&&) = delete;
+    MemoryBudget& operator=(MemoryBudget const&) = delete;
+    MemoryBudget& operator=(MemoryBudget &&) = delete;
+
+public:
+    /**
+     * \brief Approximate overhead of a single entry of a std::map / std::unordered_map (node pointers, color / hash, allocator),
+     * used by the components to estimate their footprint
+     */
+    static constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+    /**
+     * \brief Current usage of a component, as shown in the UI
+     */
+    struct ComponentUsage {
+        //! Name of the component
+        std::string name;
+        //! Estimated footprint in bytes, at the time of the last check
+        size_t footprint_bytes = 0;
+        //! Budget of the component in bytes
+        size_t budget_bytes = 0;
+        //! How often the component had to reduce its footprint because it exceeded its budget
+        uint64_t shrink_count = 0;
+    };
+
+private:
+    /**
+     * \brief A registered component
+     */
+    struct Component {
+        //! Usage data of the component
+        ComponentUsage usage;
+        //! Returns the current footprint of the component in bytes
+        std::function<size_t()> get_footprint;
+        //! Reduces the footprint of the component to at most the given number of bytes
+        std::function<void(size_t)> shrink_to;
+    };
+
+    //! Registered components, by their registration ID
+    std::map<uint64_t, Component> components;
+    //! Budgets that were set for component names (e.g. via the command line), overwrite the defaults given on registration
+    std::map<std::string, size_t> configured_budgets;
+    //! ID for the next registered component
+    uint64_t next_component_id = 1;
+    //! Mutex for the data above
+    std::mutex components_mutex;
+    //! Held while enforce() calls the callbacks of the components (without components_mutex), s.t. unregister_component waits for them to return
+    std::mutex callback_mutex;
+
+    //! Thread that enforces the budgets regularly
+    std::thread enforcement_thread;
+    //! Stop condition for enforcement_thread
+    bool enforcement_running = false;
+    //! Mutex for enforcement_running
+    std::mutex enforcement_mutex;
+    //! To wake up enforcement_thread when it is stopped
+    std::condition_variable enforcement_cv;
+
+    /**
+     * \brief Constructor, made private s.t. singleton property is fulfilled
+     */
+    MemoryBudget() {};
+
+    /**
+     * \brief Destructor, stops the enforcement thread
+     */
+    ~MemoryBudget();
+
+public:
+    /**
+     * \brief Retrieve the memory budget singleton with this function
+     */
+    static MemoryBudget& Instance();
+
+    /**
+     * \brief Register a component that accumulates data. Must be unregistered before it is destroyed.
+     * \param name Name of the component, which is shown in the UI and used for the command line parameter memory_budget_<name>_kb
+     * \param default_budget_bytes Budget of the component, if no other budget was configured for its name
+     * \param get_footprint Returns the current (estimated) footprint of the component in bytes
+     * \param shrink_to Called if the component exceeds its budget, must reduce the footprint to at most the given number of bytes by evicting / downsampling its oldest data
+     * \return ID of the component, required for unregister_component
+     */
+    uint64_t register_component(
+        std::string name,
+        size_t default_budget_bytes,
+        std::function<size_t()> get_footprint,
+        std::function<void(size_t)> shrink_to
+    );
+
+    /**
+     * \brief Unregister a component, e.g. in its destructor. Blocks if its budget is currently being enforced.
+     * \param id ID returned by register_component
+     */
+    void unregister_component(uint64_t id);
+
+    /**
+     * \brief Set the budget for all components with the given name (also for components that are registered later on)
+     * \param name Name of the component(s)
+     * \param budget_bytes The budget in bytes
+     */
+    void set_budget(std::string name, size_t budget_bytes);
+
+    /**
+     * \brief Read the budgets of all currently registered components from the command line, parameter: --memory_budget_<name>_kb=...
+     * \param argc Command line argument count
+     * \param argv Command line arguments
+     */
+    void configure(int argc, char *argv[]);
+
+    /**
+     * \brief Check the footprint of all components and let each component that exceeds its budget shrink its data
+     */
+    void enforce();
+
+    /**
+     * \brief Start a thread that calls enforce regularly
+     * \param period_ms Time between two checks in milliseconds
+     */
+    void start(uint64_t period_ms);
+
+    /**
+     * \brief Stop the thread that calls enforce
+     */
+    void stop();
+
+    /**
+     * \brief Get the usage of all components, as determined by the last check (enforce)
+     */
+    std::vector<ComponentUsage> get_usage();
+};
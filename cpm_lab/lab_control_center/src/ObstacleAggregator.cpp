@@ -11,6 +11,12 @@ ObstacleAggregator::ObstacleAggregator(std::shared_ptr<CommonRoadScenario> scena
     commonroad_obstacle_reader(
         std::bind(&ObstacleAggregator::commonroad_obstacle_receive_callback, this, _1), 
         "commonroadObstacle"
+    ),
+    commonroad_static_obstacle_reader(
+        std::bind(&ObstacleAggregator::commonroad_static_obstacle_receive_callback, this, _1), 
+        "commonroadStaticObstacle",
+        true,
+        true
     )
 {
     scenario->register_obstacle_aggregator(
@@ -33,7 +39,7 @@ void ObstacleAggregator::commonroad_obstacle_receive_callback(std::vector<Common
             //@Max: Ist das okay so?
             if (obstacle.header().create_stamp().nanoseconds() < reset_time)
             {
-                cpm::Logging::Instance().write(2, "%s", "Received outdated obstacle data (likely event in case of reset)");
+                CPM_LOG(2, "%s", "Received outdated obstacle data (likely event in case of reset)");
                 continue;
             }
 
@@ -55,6 +61,27 @@ void ObstacleAggregator::commonroad_obstacle_receive_callback(std::vector<Common
     }
 }
 
+void ObstacleAggregator::commonroad_static_obstacle_receive_callback(std::vector<CommonroadObstacleList>& samples)
+{
+    std::lock_guard<std::mutex> lock(commonroad_obstacle_mutex);
+
+    for (auto& data : samples) {
+        //Ignore if data is older than last reset; an empty list (sent on a reset) is always accepted
+        auto& obstacles = data.commonroad_obstacle_list();
+        if (obstacles.size() > 0 && obstacles.at(0).header().create_stamp().nanoseconds() < reset_time)
+        {
+            continue;
+        }
+
+        //Each list contains all static obstacles that should currently be shown
+        commonroad_static_obstacle_data.clear();
+        for (auto& obstacle : obstacles)
+        {
+            commonroad_static_obstacle_data[obstacle.vehicle_id()] = obstacle;
+        }
+    }
+}
+
 std::vector<CommonroadObstacle> ObstacleAggregator::get_obstacle_data()
 {
     std::lock_guard<std::mutex> lock(commonroad_obstacle_mutex);
@@ -73,6 +100,12 @@ std::vector<CommonroadObstacle> ObstacleAggregator::get_obstacle_data()
         return_vec.push_back(entry.second);
     }
 
+    //Static obstacles are only sent once, so they do not time out
+    for (auto& entry : commonroad_static_obstacle_data)
+    {
+        return_vec.push_back(entry.second);
+    }
+
     return return_vec;
 }
 
@@ -80,6 +113,7 @@ void ObstacleAggregator::reset_all_data()
 {
     std::lock_guard<std::mutex> lock(commonroad_obstacle_mutex);
     commonroad_obstacle_data.clear();
+    commonroad_static_obstacle_data.clear();
 
     reset_time = cpm::get_time_ns();
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 /**
  * \class ObstacleAggregator
  * \brief Keeps received data from commonroad obstacles in map that regards multiple messages + timestamps; analogous to TimeSeriesAggregator but for commonroad obstacles; ignores more than 2 seconds old data
+ * Dynamic obstacles are only sent when their state changed (but at least every second), static obstacles are only sent once in a separate (transient local) list, which is kept until it is replaced
  * \ingroup lcc
 */
 class ObstacleAggregator
@@ -30,7 +31,17 @@ class ObstacleAggregator
     void commonroad_obstacle_receive_callback(std::vector<CommonroadObstacleList>& samples);
     //! Map that stores obstacle data by ID
     std::map<uint8_t, CommonroadObstacle> commonroad_obstacle_data;
-    //! Mutex for accessing commonroad_obstacle_data
+
+    //! Async. reader to receive sent static obstacle data (reliable, transient local)
+    cpm::AsyncReader<CommonroadObstacleList> commonroad_static_obstacle_reader;
+    /**
+     * \brief Callback function for the async reader, to process received static obstacle messages - each message replaces all previously received static obstacles
+     * \param samples Received static obstacle messages
+     */
+    void commonroad_static_obstacle_receive_callback(std::vector<CommonroadObstacleList>& samples);
+    //! Map that stores static obstacle data by ID, which does not time out
+    std::map<uint8_t, CommonroadObstacle> commonroad_static_obstacle_data;
+    //! Mutex for accessing commonroad_obstacle_data and commonroad_static_obstacle_data
     std::mutex commonroad_obstacle_mutex;
 
     //! Timestamp of last reset. After a reset, ignore all previous data (->Header). Necessary because the loaded scenario / obstacles may change
@@ -432,6 +432,234 @@ VehicleCommandTrajectory ObstacleSimulation::get_trajectory(uint64_t start_time,
     return construct_trajectory(trajectory_points, t_now);
 }
 
+bool ObstacleSimulation::is_static()
+{
+    return trajectory.obstacle_class != ObstacleClass::Dynamic || trajectory.trajectory.size() <= 1;
+}
+
+void ObstacleSimulation::set_update_period(uint64_t time_step_size, uint64_t timer_period, uint64_t max_period)
+{
+    double period = static_cast<double>(max_period);
+
+    for (size_t index = 1; index < trajectory.trajectory.size(); ++index)
+    {
+        auto& previous_point = trajectory.trajectory.at(index - 1);
+        auto& point = trajectory.trajectory.at(index);
+        assert(previous_point.time.has_value() && point.time.has_value());
+
+        //Time between the two trajectory points in ns - each point should be reached by an update
+        double dt = (point.time.value().get_mean() - previous_point.time.value().get_mean()) * time_step_size;
+        if (dt <= 0) continue;
+        period = std::min(period, dt);
+
+        //Speed between the two points, or the given speed if it is higher
+        auto previous_position = get_position(previous_point);
+        auto position = get_position(point);
+        double speed = sqrt(pow(position.first - previous_position.first, 2) + pow(position.second - previous_position.second, 2)) / (dt / 1e9);
+        if (previous_point.velocity.has_value())
+        {
+            speed = std::max(speed, std::abs(previous_point.velocity.value().get_mean()));
+        }
+
+        if (speed > 0)
+        {
+            period = std::min(period, max_position_change / speed * 1e9);
+        }
+    }
+
+    //Must be a multiple of the timer period, else the updates would not be equidistant
+    uint64_t timer_steps = static_cast<uint64_t>(period / static_cast<double>(timer_period));
+    update_period = std::max(timer_steps, static_cast<uint64_t>(1)) * timer_period;
+}
+
+bool ObstacleSimulation::get_reactive_agent_data(uint64_t time_step_size, double& x, double& y, double& yaw, double& initial_speed, double& desired_speed, double& length)
+{
+    auto& first_point = trajectory.trajectory.at(0);
+    if (is_static() || !first_point.position.has_value()) return false;
+
+    x = first_point.position.value().first;
+    y = first_point.position.value().second;
+    yaw = first_point.orientation.value_or(0.0);
+    initial_speed = first_point.velocity.has_value() ? first_point.velocity.value().get_mean() : 0.0;
+
+    //Desired speed: Max. speed of the trajectory, either given directly or derived from the positions
+    desired_speed = 0.0;
+    for (size_t i = 0; i < trajectory.trajectory.size(); ++i)
+    {
+        auto& point = trajectory.trajectory.at(i);
+        if (point.velocity.has_value())
+        {
+            desired_speed = std::max(desired_speed, point.velocity.value().get_mean());
+        }
+        else if (i > 0 && point.position.has_value() && trajectory.trajectory.at(i - 1).position.has_value())
+        {
+            auto& previous_point = trajectory.trajectory.at(i - 1);
+            double dt = (point.time.value().get_mean() - previous_point.time.value().get_mean()) * time_step_size / 1e9;
+            if (dt > 0)
+            {
+                double distance = std::hypot(
+                    point.position.value().first - previous_point.position.value().first, 
+                    point.position.value().second - previous_point.position.value().second
+                );
+                desired_speed = std::max(desired_speed, distance / dt);
+            }
+        }
+    }
+
+    //Length: Rectangles are oriented along the obstacle, circles are used as an approximation otherwise
+    length = 0.22;
+    if (first_point.shape.rectangles().size() > 0)
+    {
+        length = first_point.shape.rectangles().at(0).length();
+    }
+    else if (first_point.shape.circles().size() > 0)
+    {
+        length = 2.0 * first_point.shape.circles().at(0).radius();
+    }
+
+    return desired_speed > 0;
+}
+
+CommonroadObstacle ObstacleSimulation::get_reactive_state(double x, double y, double yaw, double speed, uint64_t t_now)
+{
+    auto obstacle = construct_obstacle(trajectory.trajectory.at(0), x, y, yaw, t_now);
+    obstacle.speed(speed);
+    obstacle.pose_is_exact(true);
+    return obstacle;
+}
+
+uint64_t ObstacleSimulation::get_update_period()
+{
+    return update_period;
+}
+
+std::optional<CommonroadObstacle> ObstacleSimulation::get_state_update(uint64_t start_time, uint64_t t_now, uint64_t time_step_size, uint64_t max_unchanged_period)
+{
+    if (t_now < next_update_time)
+    {
+        return std::nullopt;
+    }
+    next_update_time = t_now + update_period;
+
+    auto state = get_state(start_time, t_now, time_step_size);
+
+    //Only send the state if it changed, or if the last sent state would become outdated otherwise
+    bool changed = true;
+    if (last_sent_state.has_value())
+    {
+        auto& last_pose = last_sent_state.value().second;
+        changed = last_sent_state.value().first != current_trajectory
+            || std::abs(last_pose.x() - state.pose().x()) > 1e-4
+            || std::abs(last_pose.y() - state.pose().y()) > 1e-4
+            || std::abs(last_pose.yaw() - state.pose().yaw()) > 1e-4;
+    }
+
+    if (!changed && t_now < last_sent_time + max_unchanged_period)
+    {
+        return std::nullopt;
+    }
+
+    last_sent_state = std::make_pair(current_trajectory, state.pose());
+    last_sent_time = t_now;
+    return state;
+}
+
+void ObstacleSimulation::precompute_prediction(uint64_t time_step_size)
+{
+    prediction_times.clear();
+    prediction_points.clear();
+    prediction_shapes.clear();
+
+    for (auto& segment : trajectory.trajectory)
+    {
+        assert(segment.time.has_value());
+
+        //Same pose as in get_state for this trajectory point
+        Pose2D pose;
+        pose.x(0);
+        pose.y(0);
+        if (segment.position.has_value())
+        {
+            pose.x(segment.position.value().first);
+            pose.y(segment.position.value().second);
+        }
+        pose.yaw(segment.orientation.value_or(0.0));
+
+        if (prediction_shapes.size() == 0 || !(prediction_shapes.back() == segment.shape))
+        {
+            prediction_shapes.push_back(segment.shape);
+        }
+
+        CommonroadObstaclePredictionPoint point;
+        point.time_is_exact(segment.time.value().is_exact());
+        point.pose(pose);
+        point.pose_is_exact(segment.is_exact);
+        point.shape_index(static_cast<uint16_t>(prediction_shapes.size() - 1));
+        if (segment.velocity.has_value())
+        {
+            point.speed(segment.velocity.value().get_mean());
+        }
+
+        double relative_time = std::max(segment.time.value().get_mean(), 0.0) * time_step_size;
+        prediction_times.push_back(static_cast<uint64_t>(relative_time));
+        prediction_points.push_back(point);
+    }
+}
+
+std::optional<CommonroadObstaclePrediction> ObstacleSimulation::get_prediction_update(uint64_t start_time, uint64_t t_now, uint64_t horizon, uint64_t max_unchanged_period)
+{
+    if (prediction_points.size() == 0 || t_now < start_time)
+    {
+        return std::nullopt;
+    }
+
+    //Select the latest state before t_now up to the first state after t_now + horizon, or only the final state
+    uint64_t relative_time = t_now - start_time;
+    size_t first = prediction_points.size() - 1;
+    size_t last = prediction_points.size() - 1;
+    if (relative_time < prediction_times.back())
+    {
+        auto after_now = std::upper_bound(prediction_times.begin(), prediction_times.end(), relative_time);
+        first = (after_now == prediction_times.begin()) ? 0 : static_cast<size_t>(after_now - prediction_times.begin()) - 1;
+
+        auto after_horizon = std::lower_bound(after_now, prediction_times.end(), relative_time + horizon);
+        last = (after_horizon == prediction_times.end()) ? prediction_points.size() - 1 : static_cast<size_t>(after_horizon - prediction_times.begin());
+    }
+
+    //Only send the prediction if the selected states changed, or if the last sent prediction would become outdated otherwise
+    auto slice = std::make_pair(first, last);
+    if (last_sent_prediction.has_value() && last_sent_prediction.value() == slice && t_now < last_sent_prediction_time + max_unchanged_period)
+    {
+        return std::nullopt;
+    }
+    last_sent_prediction = slice;
+    last_sent_prediction_time = t_now;
+
+    //Only send the shapes referenced by the selected states
+    uint16_t first_shape = prediction_points.at(first).shape_index();
+    uint16_t last_shape = prediction_points.at(last).shape_index();
+    std::vector<CommonroadDDSShape> shapes(prediction_shapes.begin() + first_shape, prediction_shapes.begin() + last_shape + 1);
+
+    std::vector<CommonroadObstaclePredictionPoint> predicted_states(prediction_points.begin() + first, prediction_points.begin() + last + 1);
+    for (size_t index = 0; index < predicted_states.size(); ++index)
+    {
+        predicted_states.at(index).t(TimeStamp(start_time + prediction_times.at(first + index)));
+        predicted_states.at(index).shape_index(static_cast<uint16_t>(predicted_states.at(index).shape_index() - first_shape));
+    }
+
+    CommonroadObstaclePrediction prediction;
+    prediction.vehicle_id(obstacle_id);
+    Header header;
+    header.create_stamp(TimeStamp(t_now));
+    header.valid_after_stamp(TimeStamp(t_now));
+    prediction.header(header);
+    prediction.type(trajectory.obstacle_type);
+    prediction.shapes(shapes);
+    prediction.predicted_states(predicted_states);
+
+    return prediction;
+}
+
 uint8_t ObstacleSimulation::get_id()
 {
     return obstacle_id;
@@ -440,4 +668,11 @@ uint8_t ObstacleSimulation::get_id()
 void ObstacleSimulation::reset()
 {
     current_trajectory = 0;
+
+    next_update_time = 0;
+    last_sent_time = 0;
+    last_sent_state = std::nullopt;
+
+    last_sent_prediction = std::nullopt;
+    last_sent_prediction_time = 0;
 }
\ No newline at end of file
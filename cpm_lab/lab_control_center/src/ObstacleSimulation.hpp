@@ -3,7 +3,10 @@
 #include "commonroad_classes/CommonRoadScenario.hpp"
 #include "commonroad_classes/ObstacleSimulationData.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <optional>
 
 #include "cpm/Logging.hpp"
 #include "cpm/CommandLineReader.hpp"
@@ -11,6 +14,7 @@
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/SimpleTimer.hpp"
 #include "CommonroadObstacle.hpp"
+#include "CommonroadObstaclePrediction.hpp"
 #include "VehicleCommandTrajectory.hpp"
 #include "commonroad_classes/DynamicObstacle.hpp"
 
@@ -35,6 +39,30 @@ private:
     //! As we cannot just send single points, but need to send a trajectory to vehicles: Send up to 10 trajectory points from future time steps
     const size_t future_time_steps = 10;
 
+    //Update scheduling
+    //! Max. distance in m the obstacle may move between two state updates, used to derive the update period from the obstacle's speed
+    const double max_position_change = 0.02;
+    //! Time between two state updates in ns, see set_update_period
+    uint64_t update_period = 0;
+    //! Time of the next state update in ns, see get_state_update
+    uint64_t next_update_time = 0;
+    //! Time the last state update was sent in ns
+    uint64_t last_sent_time = 0;
+    //! Trajectory point and pose of the last sent state, to find out if the state changed (the shape may change with the trajectory point)
+    std::optional<std::pair<size_t, Pose2D>> last_sent_state = std::nullopt;
+
+    //Prediction (computed once in precompute_prediction, sliced in get_prediction_update)
+    //! Times of the predicted states relative to the simulation start in ns, ascending
+    std::vector<uint64_t> prediction_times;
+    //! Predicted states at prediction_times; their timestamps are set when a slice is sent
+    std::vector<CommonroadObstaclePredictionPoint> prediction_points;
+    //! Distinct shapes of the obstacle, referenced by prediction_points (consecutive points with the same shape share it, so the indices are ascending)
+    std::vector<CommonroadDDSShape> prediction_shapes;
+    //! First and last index of the last sent slice of prediction_points, to find out if the prediction changed
+    std::optional<std::pair<size_t, size_t>> last_sent_prediction = std::nullopt;
+    //! Time the last prediction was sent in ns
+    uint64_t last_sent_prediction_time = 0;
+
     /**
      * \brief Interpolation function that delivers state values in between set trajectory points
      * \param p1 First trajectory point to interpolate from
@@ -130,13 +158,83 @@ public:
      */
     VehicleCommandTrajectory get_trajectory(uint64_t start_time, uint64_t t_now, uint64_t time_step_size);
 
+    /**
+     * \brief Static obstacles (all non-dynamic obstacles and dynamic obstacles without a trajectory) never change their state,
+     * so their initial state only needs to be sent once
+     */
+    bool is_static();
+
+    /**
+     * \brief Derive the period of the state updates from the trajectory: The obstacle should not move more than max_position_change
+     * between two updates, and each trajectory point should be reached by an update. Slow obstacles (like pedestrians) and obstacles
+     * with sparse trajectories are thus updated less often than fast ones.
+     * \param time_step_size Commonroad time step size in ns, to translate the trajectory's times to ns
+     * \param timer_period Period of the calling timer in ns, which is the min. update period; the update period is a multiple of it
+     * \param max_period Max. update period in ns
+     */
+    void set_update_period(uint64_t time_step_size, uint64_t timer_period, uint64_t max_period);
+
+    /**
+     * \brief Get the update period that was set with set_update_period
+     */
+    uint64_t get_update_period();
+
+    /**
+     * \brief Like get_state, but only returns a state if an update is due (see set_update_period) and the state changed since
+     * the last returned state, or if the last returned state is older than max_unchanged_period (s.t. receivers do not regard it as outdated)
+     * \param start_time Time when the simulation was started
+     * \param t_now Current time
+     * \param time_step_size Must be known to find out which current point is active
+     * \param max_unchanged_period Max. time in ns between two returned states, even if the state did not change
+     */
+    std::optional<CommonroadObstacle> get_state_update(uint64_t start_time, uint64_t t_now, uint64_t time_step_size, uint64_t max_unchanged_period);
+
+    /**
+     * \brief Compute all predicted states of the obstacle from its trajectory, s.t. get_prediction_update only needs to select a slice of them
+     * \param time_step_size Commonroad time step size in ns, to translate the trajectory's times to ns
+     */
+    void precompute_prediction(uint64_t time_step_size);
+
+    /**
+     * \brief Get the predicted states of the obstacle within [t_now, t_now + horizon] (plus the surrounding states, see CommonroadObstaclePrediction),
+     * but only if the selected states changed since the last returned prediction or if that one is older than max_unchanged_period
+     * \param start_time Time when the simulation was started
+     * \param t_now Current time
+     * \param horizon Length of the prediction horizon in ns
+     * \param max_unchanged_period Max. time in ns between two returned predictions, even if the prediction did not change
+     */
+    std::optional<CommonroadObstaclePrediction> get_prediction_update(uint64_t start_time, uint64_t t_now, uint64_t horizon, uint64_t max_unchanged_period);
+
+    /**
+     * \brief Get the values to replace the trajectory of this obstacle by a reactive traffic agent (see ReactiveTrafficSimulation)
+     * \param time_step_size Commonroad time step size in ns, to derive the desired speed from the trajectory if it does not define velocities
+     * \param x Return value: Initial x position
+     * \param y Return value: Initial y position
+     * \param yaw Return value: Initial orientation
+     * \param initial_speed Return value: Initial speed
+     * \param desired_speed Return value: Max. speed of the trajectory
+     * \param length Return value: Length of the obstacle's shape
+     * \return False if the obstacle does not move or its position is not given directly, in which case it should keep following its trajectory
+     */
+    bool get_reactive_agent_data(uint64_t time_step_size, double& x, double& y, double& yaw, double& initial_speed, double& desired_speed, double& length);
+
+    /**
+     * \brief Get the state of the obstacle at a pose computed by a reactive traffic agent (the shape etc. are taken from the initial trajectory point)
+     * \param x x position
+     * \param y y position
+     * \param yaw Orientation
+     * \param speed Speed
+     * \param t_now Current time, used for timestamp of msg
+     */
+    CommonroadObstacle get_reactive_state(double x, double y, double yaw, double speed, uint64_t t_now);
+
     /**
      * \brief Get the ID of the obstacle
      */
     uint8_t get_id();
 
     /**
-     * \brief Reset internal counter variable which was implemented to make the lookup a bit faster
+     * \brief Reset internal counter variable which was implemented to make the lookup a bit faster, and the update schedule
      */
     void reset();
 };
\ No newline at end of file
@@ -5,12 +5,16 @@
  * \ingroup lcc
  */
 
-ObstacleSimulationManager::ObstacleSimulationManager(std::shared_ptr<CommonRoadScenario> _scenario, bool _use_simulated_time) 
+ObstacleSimulationManager::ObstacleSimulationManager(std::shared_ptr<CommonRoadScenario> _scenario, bool _use_simulated_time, uint64_t prediction_horizon_ms, bool reactive_agents) 
 :
 scenario(_scenario),
 use_simulated_time(_use_simulated_time),
+prediction_horizon(prediction_horizon_ms * 1000000ull),
 writer_commonroad_obstacle("commonroadObstacle"),
-writer_vehicle_trajectory("vehicleCommandTrajectory")
+writer_commonroad_static_obstacle("commonroadStaticObstacle", true, false, true),
+writer_obstacle_prediction("commonroadObstaclePrediction"),
+writer_vehicle_trajectory("vehicleCommandTrajectory"),
+use_reactive_agents(reactive_agents)
 {
     //Set up cpm values (cpm init has already been done before)
     node_id = "obstacle_simulation"; //Will probably not be used, as main already set LabControlCenter
@@ -85,13 +89,16 @@ void ObstacleSimulationManager::send_init_states()
     standby_timer->start_async([&] (uint64_t t_now) {
         std::lock_guard<std::mutex> lock(map_mutex);
 
-        //Get and send initial states
+        //Get and send initial states (static obstacles are sent separately, see send_static_obstacles)
         std::vector<CommonroadObstacle> initial_obstacle_states;
         for (auto& obstacle : simulated_obstacles)
         {
             //if (get_obstacle_simulation_state(obstacle.second.get_id()) == ObstacleToggle::ToggleState::Simulated)
             //{
+            if (!obstacle.second.is_static())
+            {
                 initial_obstacle_states.push_back(obstacle.second.get_init_state(t_now));
+            }
             //}
         }
 
@@ -110,6 +117,28 @@ void ObstacleSimulationManager::send_init_states()
     });
 }
 
+void ObstacleSimulationManager::send_static_obstacles()
+{
+    //Use the real time for the header, as the obstacle aggregator ignores data that is older than its last reset
+    auto t_now = cpm::get_time_ns();
+
+    std::vector<CommonroadObstacle> static_obstacle_states;
+    for (auto& obstacle : simulated_obstacles)
+    {
+        if (obstacle.second.is_static())
+        {
+            if (!simulation_running || get_obstacle_simulation_state(obstacle.second.get_id()) == ObstacleToggle::ToggleState::Simulated)
+            {
+                static_obstacle_states.push_back(obstacle.second.get_init_state(t_now));
+            }
+        }
+    }
+
+    CommonroadObstacleList obstacle_list;
+    obstacle_list.commonroad_obstacle_list(static_obstacle_states);
+    writer_commonroad_static_obstacle.write(obstacle_list);
+}
+
 std::vector<CommonroadObstacle> ObstacleSimulationManager::compute_all_next_states(uint64_t t_now, uint64_t start_time)
 {
     //TODO: Thread pool?
@@ -118,10 +147,17 @@ std::vector<CommonroadObstacle> ObstacleSimulationManager::compute_all_next_stat
 
     for (auto& obstacle : simulated_obstacles)
     {
-        //Only simulate obstacles that are supposed to be simulated
-        if (get_obstacle_simulation_state(obstacle.second.get_id()) == ObstacleToggle::ToggleState::Simulated)
+        //Reactive agents are computed separately, see compute_reactive_states
+        if (reactive_obstacle_ids.count(obstacle.first) > 0) continue;
+
+        //Only simulate obstacles that are supposed to be simulated; static obstacles were already sent at the start
+        if (!obstacle.second.is_static() && get_obstacle_simulation_state(obstacle.second.get_id()) == ObstacleToggle::ToggleState::Simulated)
         {
-            next_obstacle_states.push_back(obstacle.second.get_state(start_time, t_now, time_step_size));
+            auto state = obstacle.second.get_state_update(start_time, t_now, time_step_size, max_unchanged_period);
+            if (state.has_value())
+            {
+                next_obstacle_states.push_back(state.value());
+            }
         }
         
     }
@@ -129,6 +165,153 @@ std::vector<CommonroadObstacle> ObstacleSimulationManager::compute_all_next_stat
     return next_obstacle_states;
 }
 
+std::vector<CommonroadObstaclePrediction> ObstacleSimulationManager::compute_all_predictions(uint64_t t_now, uint64_t start_time)
+{
+    std::vector<CommonroadObstaclePrediction> predictions;
+    std::lock_guard<std::mutex> lock(map_mutex);
+
+    for (auto& obstacle : simulated_obstacles)
+    {
+        //The trajectories of reactive agents are not known in advance, so the precomputed predictions would be wrong
+        if (reactive_obstacle_ids.count(obstacle.first) > 0) continue;
+
+        //Static obstacles do not move, so there is nothing to predict
+        if (!obstacle.second.is_static() && get_obstacle_simulation_state(obstacle.second.get_id()) == ObstacleToggle::ToggleState::Simulated)
+        {
+            auto prediction = obstacle.second.get_prediction_update(start_time, t_now, prediction_horizon, max_unchanged_period);
+            if (prediction.has_value())
+            {
+                predictions.push_back(prediction.value());
+            }
+        }
+    }
+
+    return predictions;
+}
+
+std::vector<ReactiveTrafficVehicle> ObstacleSimulationManager::get_reactive_traffic_vehicles(uint64_t t_now)
+{
+    std::vector<ReactiveTrafficVehicle> vehicles;
+    if (!get_vehicle_data) return vehicles;
+
+    for (auto& vehicle_entry : get_vehicle_data())
+    {
+        auto& vehicle = vehicle_entry.second;
+        if (!(vehicle.count("pose_x") && vehicle.count("pose_y") && vehicle.count("pose_yaw") && vehicle.count("speed"))) continue;
+        if (!vehicle.at("pose_x")->has_data()) continue;
+
+        //Vehicles that did not send their state for a while are no longer regarded
+        if (vehicle.at("pose_x")->get_latest_time() + max_unchanged_period < t_now) continue;
+
+        ReactiveTrafficVehicle reactive_vehicle;
+        reactive_vehicle.x = vehicle.at("pose_x")->get_latest_value();
+        reactive_vehicle.y = vehicle.at("pose_y")->get_latest_value();
+        reactive_vehicle.yaw = vehicle.at("pose_yaw")->get_latest_value();
+        reactive_vehicle.speed = vehicle.at("speed")->get_latest_value();
+        vehicles.push_back(reactive_vehicle);
+    }
+
+    return vehicles;
+}
+
+std::vector<CommonroadObstacle> ObstacleSimulationManager::compute_reactive_states(uint64_t t_now)
+{
+    std::vector<CommonroadObstacle> reactive_states;
+
+    //The vehicle data is obtained before locking, as the callback locks the aggregator
+    auto vehicles = get_reactive_traffic_vehicles(cpm::get_time_ns());
+
+    std::lock_guard<std::mutex> lock(map_mutex);
+    if (!reactive_traffic) return reactive_states;
+
+    //The first step after the start only sends the initial states; dt is limited s.t. a delayed timer does not cause jumps
+    if (last_reactive_step_time > 0 && t_now > last_reactive_step_time)
+    {
+        double dt = std::min(static_cast<double>(t_now - last_reactive_step_time) / 1e9, 0.1);
+        reactive_traffic->set_external_vehicles(vehicles);
+        reactive_traffic->step(dt);
+    }
+    last_reactive_step_time = t_now;
+
+    for (size_t agent = 0; agent < reactive_traffic->size(); ++agent)
+    {
+        int id = reactive_traffic->get_id(agent);
+        if (get_obstacle_simulation_state(id) != ObstacleToggle::ToggleState::Simulated) continue;
+
+        auto obstacle = simulated_obstacles.find(id);
+        if (obstacle != simulated_obstacles.end())
+        {
+            reactive_states.push_back(obstacle->second.get_reactive_state(
+                reactive_traffic->get_x(agent),
+                reactive_traffic->get_y(agent),
+                reactive_traffic->get_yaw(agent),
+                reactive_traffic->get_speed(agent),
+                t_now
+            ));
+        }
+    }
+
+    return reactive_states;
+}
+
+void ObstacleSimulationManager::setup_reactive_traffic()
+{
+    if (!use_reactive_agents) return;
+
+    //Lanes from the lanelets, referencing each other by index
+    auto lanelet_ids = scenario->get_lanelet_ids();
+    std::map<int, int> lane_indices;
+    for (auto lanelet_id : lanelet_ids)
+    {
+        lane_indices[lanelet_id] = static_cast<int>(lane_indices.size());
+    }
+
+    std::vector<ReactiveTrafficLane> lanes(lanelet_ids.size());
+    for (auto lanelet_id : lanelet_ids)
+    {
+        auto lanelet = scenario->get_lanelet(lanelet_id);
+        if (!lanelet.has_value()) continue;
+
+        auto& lane = lanes.at(lane_indices.at(lanelet_id));
+        lane = ReactiveTrafficLane::from_points(lanelet->get_center_line());
+
+        for (auto successor : lanelet->get_successors())
+        {
+            if (lane_indices.count(successor)) lane.successors.push_back(lane_indices.at(successor));
+        }
+
+        //Lane changes are only possible to lanes with the same driving direction
+        auto left = lanelet->get_adjacent_left();
+        if (left.has_value() && left->direction == DrivingDirection::Same && lane_indices.count(left->ref_id))
+        {
+            lane.left = lane_indices.at(left->ref_id);
+        }
+        auto right = lanelet->get_adjacent_right();
+        if (right.has_value() && right->direction == DrivingDirection::Same && lane_indices.count(right->ref_id))
+        {
+            lane.right = lane_indices.at(right->ref_id);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(map_mutex);
+    reactive_traffic = std::make_unique<ReactiveTrafficSimulation>(lanes, ReactiveTrafficSimulation::Parameters());
+    reactive_obstacle_ids.clear();
+
+    //Obstacles that cannot be placed on a lanelet keep following their trajectory
+    for (auto& obstacle : simulated_obstacles)
+    {
+        double x, y, yaw, initial_speed, desired_speed, length;
+        if (!obstacle.second.get_reactive_agent_data(time_step_size, x, y, yaw, initial_speed, desired_speed, length)) continue;
+
+        if (reactive_traffic->add_agent(obstacle.first, x, y, yaw, initial_speed, desired_speed, length))
+        {
+            reactive_obstacle_ids.insert(obstacle.first);
+        }
+    }
+
+    CPM_LOG(3, "Obstacle simulation: %zu of %zu obstacles are simulated as reactive traffic agents", reactive_obstacle_ids.size(), simulated_obstacles.size());
+}
+
 void ObstacleSimulationManager::setup()
 {
     //Translate time distance to nanoseconds
@@ -184,6 +367,12 @@ void ObstacleSimulationManager::setup()
         create_obstacle_simulation(obstacle_id, obstacle_data);
     }
 
+    setup_reactive_traffic();
+
+    {
+        std::lock_guard<std::mutex> lock(map_mutex);
+        send_static_obstacles();
+    }
     send_init_states();
 
     //TODO: Part for real participant: Send trajectory
@@ -222,8 +411,12 @@ void ObstacleSimulationManager::create_obstacle_simulation(int id, ObstacleSimul
         }
     }
 
+    ObstacleSimulation obstacle(data, id);
+    obstacle.set_update_period(time_step_size, dt_nanos, max_unchanged_period);
+    obstacle.precompute_prediction(time_step_size);
+
     std::lock_guard<std::mutex> lock(map_mutex);
-    simulated_obstacles.emplace(id, ObstacleSimulation(data, id));
+    simulated_obstacles.emplace(id, obstacle);
 }
 
 //Suppress warning for unused parameter
@@ -244,15 +437,50 @@ void ObstacleSimulationManager::start_helper(bool wait_for_start_signal, bool si
 
     std::cout << std::endl << std::endl << "--------- Set time step size to: " << time_step_size << std::endl << std::endl;
 
+    {
+        //Start all update schedules from scratch, only show simulated static obstacles from now on
+        std::lock_guard<std::mutex> lock(map_mutex);
+        for (auto& simulated_obstacle : simulated_obstacles)
+        {
+            simulated_obstacle.second.reset();
+        }
+        if (reactive_traffic)
+        {
+            reactive_traffic->reset();
+        }
+        last_reactive_step_time = 0;
+
+        simulation_running = true;
+        send_static_obstacles();
+    }
+
     simulation_timer->start_async([&] (uint64_t t_now) {
         //Cannot be obtained before the timer was started
         auto start_time = simulation_timer->get_start_time();
         
+        //Only contains obstacles whose state changed, the ObstacleAggregator keeps the others
         auto next_obstacle_states = compute_all_next_states(t_now, start_time);
 
-        CommonroadObstacleList obstacle_list;
-        obstacle_list.commonroad_obstacle_list(next_obstacle_states);
-        writer_commonroad_obstacle.write(obstacle_list);
+        //Reactive agents move depending on the other vehicles, so their states are sent in each period
+        auto reactive_states = compute_reactive_states(t_now);
+        next_obstacle_states.insert(next_obstacle_states.end(), reactive_states.begin(), reactive_states.end());
+
+        if (next_obstacle_states.size() > 0)
+        {
+            CommonroadObstacleList obstacle_list;
+            obstacle_list.commonroad_obstacle_list(next_obstacle_states);
+            writer_commonroad_obstacle.write(obstacle_list);
+        }
+
+        //Predictions are sliced from the precomputed ones and only sent if they changed
+        auto predictions = compute_all_predictions(t_now, start_time);
+
+        if (predictions.size() > 0)
+        {
+            CommonroadObstaclePredictionList prediction_list;
+            prediction_list.commonroad_obstacle_prediction_list(predictions);
+            writer_obstacle_prediction.write(prediction_list);
+        }
 
         //Send test trajectory messages
         std::lock_guard<std::mutex> lock(map_mutex);
@@ -286,6 +514,8 @@ void ObstacleSimulationManager::stop()
         simulated_obstacle.second.reset();
     }
 
+    simulation_running = false;
+    send_static_obstacles();
     send_init_states();
 }
 
@@ -296,6 +526,17 @@ void ObstacleSimulationManager::reset()
     std::lock_guard<std::mutex> lock(map_mutex);
     simulated_obstacles.clear();
     simulated_obstacle_states.clear();
+    reactive_traffic.reset();
+    reactive_obstacle_ids.clear();
+
+    //Remove the static obstacles of the old scenario, also for participants that join later on
+    send_static_obstacles();
+}
+
+void ObstacleSimulationManager::set_vehicle_data_callback(std::function<map<uint8_t, map<string, shared_ptr<TimeSeries>>>()> _get_vehicle_data)
+{
+    std::lock_guard<std::mutex> lock(map_mutex);
+    get_vehicle_data = _get_vehicle_data;
 }
 
 void ObstacleSimulationManager::set_obstacle_simulation_state(int id, ObstacleToggle::ToggleState state)
@@ -303,6 +544,13 @@ void ObstacleSimulationManager::set_obstacle_simulation_state(int id, ObstacleTo
     std::lock_guard<std::mutex> lock(map_mutex);
     simulated_obstacle_states[id] = state;
 
+    //Static obstacles are only sent on changes, so they need to be sent again if they are shown / hidden during the simulation
+    auto obstacle = simulated_obstacles.find(id);
+    if (simulation_running && obstacle != simulated_obstacles.end() && obstacle->second.is_static())
+    {
+        send_static_obstacles();
+    }
+
     //TODO: Maybe use mutex
 }
 
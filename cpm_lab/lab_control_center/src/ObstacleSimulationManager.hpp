@@ -4,23 +4,31 @@
 #include "commonroad_classes/ObstacleSimulationData.hpp"
 
 #include "ObstacleSimulation.hpp"
+#include "ReactiveTrafficSimulation.hpp"
+#include "TimeSeries.hpp"
 
 #include "cpm/Timer.hpp"
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/get_topic.hpp"
 #include "cpm/Writer.hpp"
 #include "CommonroadObstacleList.hpp"
+#include "CommonroadObstaclePredictionList.hpp"
 #include "VehicleCommandTrajectory.hpp"
 
 #include "ui/commonroad/ObstacleToggle.hpp" //For callback from vehicle toggle: Need enum defined here
 
+#include <functional>
 #include <map>
+#include <memory>
+#include <set>
 
 /**
  * \brief This class simulates a traffic participant / obstacle logic based on the obstacle type(s) defined in a commonroad scenario.
  * It sends trajectories/... defined in the scenario (which may define position, time, velocity...).
  * These are received by either a real vehicle or a special simulated participant, that also gets a starting position etc.
  * Obstacles or trajectories are also drawn on the MapView. During simulation, obstacle poses are updated, else only the initial positions are drawn.
+ * Optionally, moving obstacles do not play back their trajectories but become reactive traffic agents (see ReactiveTrafficSimulation),
+ * which follow the scenario's lanelets and react to each other and to the vehicles in the lab.
  * \ingroup lcc
  */
 class ObstacleSimulationManager
@@ -35,14 +43,20 @@ private:
     std::map<int, ObstacleToggle::ToggleState> simulated_obstacle_states;
     //! Mutex for access to the maps
     std::mutex map_mutex;
+    //! If the simulation (or its preview) is running, in which case only simulated obstacles are sent; protected by map_mutex
+    bool simulation_running = false;
 
     //Timing
     //! Whether simulated time should be used for the timer that is responsible for sending obstacle trajectories or states for the MapView of the LCC
     bool use_simulated_time;
     //! Timer identifier
     std::string node_id;
-    //! Timer periodicity, depends on the obstacle's periodicity
+    //! Timer periodicity, depends on the obstacle's periodicity; this is the min. update period of each obstacle, slower obstacles are updated less often (see ObstacleSimulation::set_update_period)
     uint64_t dt_nanos;
+    //! Max. time between two states sent for a dynamic obstacle, even if its state did not change - must be smaller than the timeout of the ObstacleAggregator
+    const uint64_t max_unchanged_period = 1000000000ull;
+    //! Length of the prediction horizon in ns, see writer_obstacle_prediction
+    uint64_t prediction_horizon;
     //! Min. periodicity defined by Commonroad scenario, as size for each time step, here translated from seconds to nanoseconds - Commonroad time uses integers, so the smallest possible step value is 1*time_step_size
     uint64_t time_step_size;
     //! Timer for the simulation, where we need higher accuracy
@@ -50,11 +64,27 @@ private:
     //! Timer for standby, that sends obstacle's initial states s.t. they are drawn on the MapView - is not called often & thus would take long to be quit if a normal Timer instead of SimpleTimer would be used
     std::shared_ptr<cpm::SimpleTimer> standby_timer;
 
-    //! DDS writer to send obstacle information to the MapView (and potentially other participants in the network)
+    //! DDS writer to send obstacle information to the MapView (and potentially other participants in the network); only contains dynamic obstacles whose state changed
     cpm::Writer<CommonroadObstacleList> writer_commonroad_obstacle;
+    //! DDS writer (reliable, transient local) for static obstacles, which are only sent when the scenario or the simulation state changes; each message contains all static obstacles that should currently be shown
+    cpm::Writer<CommonroadObstacleList> writer_commonroad_static_obstacle;
+    //! DDS writer to send the predicted states of moving obstacles within the prediction horizon to HLCs, s.t. they do not need to extrapolate the obstacles' states; only contains obstacles whose prediction changed
+    cpm::Writer<CommonroadObstaclePredictionList> writer_obstacle_prediction;
     //! DDS writer to send obstacle trajectories e.g. to a vehicle, s.t. it can follow this trajectory to represent the object in the real world
     cpm::Writer<VehicleCommandTrajectory> writer_vehicle_trajectory;
 
+    //Reactive traffic agents
+    //! If moving obstacles should be simulated as reactive traffic agents instead of following their trajectories
+    bool use_reactive_agents;
+    //! Agents of the current scenario, only set if use_reactive_agents is true; protected by map_mutex
+    std::unique_ptr<ReactiveTrafficSimulation> reactive_traffic;
+    //! IDs of the obstacles that are simulated by reactive_traffic; protected by map_mutex
+    std::set<int> reactive_obstacle_ids;
+    //! Time of the last step of reactive_traffic, 0 before the first step after the start
+    uint64_t last_reactive_step_time = 0;
+    //! Returns the data of the real and simulated vehicles, which the agents react to
+    std::function<map<uint8_t, map<string, shared_ptr<TimeSeries>>>()> get_vehicle_data;
+
     /**
      * \brief Function that sets up the obstacle simulation based on the currently set scenario (callback for scenario)
      */
@@ -78,17 +108,47 @@ private:
     void create_obstacle_simulation(int id, ObstacleSimulationData& data);
 
     /**
-     * \brief Send initial state of all simulation objects (when sim. is not running, to show initial position in MapView)
+     * \brief Create the reactive traffic agents from the scenario's lanelets and the simulated moving obstacles, if use_reactive_agents is set
+     */
+    void setup_reactive_traffic();
+
+    /**
+     * \brief Get the current poses of the vehicles from get_vehicle_data, for the reactive traffic agents
+     * \param t_now Current time, outdated poses are ignored
+     */
+    std::vector<ReactiveTrafficVehicle> get_reactive_traffic_vehicles(uint64_t t_now);
+
+    /**
+     * \brief Simulate the reactive traffic agents up to t_now and return the states of the agents that are supposed to be simulated
+     * \param t_now Current time
+     */
+    std::vector<CommonroadObstacle> compute_reactive_states(uint64_t t_now);
+
+    /**
+     * \brief Send initial state of all dynamic simulation objects (when sim. is not running, to show initial position in MapView)
      */
     void send_init_states();
 
     /**
-     * \brief Compute next states of commonroad obstacles based on the current time and return them; only consider obstacles that are supposed to be simulated by the LCC
+     * \brief Send the states of all static obstacles once (all of them if the simulation is not running, else only the simulated ones); does not lock, so lock before calling!
+     */
+    void send_static_obstacles();
+
+    /**
+     * \brief Compute next states of dynamic commonroad obstacles based on the current time and return them; only consider obstacles that are supposed to be simulated by the LCC
+     * and only return states of obstacles whose update is due and whose state changed (see ObstacleSimulation::get_state_update)
      * \param t_now Current time
      * \param start_time Time the simulation was started, to compute diff to t_now
      */
     std::vector<CommonroadObstacle> compute_all_next_states(uint64_t t_now, uint64_t start_time);
 
+    /**
+     * \brief Get the predictions of all simulated moving obstacles whose prediction changed (see ObstacleSimulation::get_prediction_update)
+     * \param t_now Current time
+     * \param start_time Time the simulation was started, to compute diff to t_now
+     */
+    std::vector<CommonroadObstaclePrediction> compute_all_predictions(uint64_t t_now, uint64_t start_time);
+
     /**
      * \brief Either returns the content of the map or the default value (simulated); does not lock, so lock before calling!
      * \param id The obstacle's ID
@@ -108,8 +168,10 @@ public:
      * \brief Constructor to set up the simulation object
      * \param _scenario Data object to get the obstacle's data
      * \param use_simulated_time If simulated time should be used
+     * \param prediction_horizon_ms Length of the horizon of the sent obstacle predictions in ms
+     * \param reactive_agents If moving obstacles should be simulated as reactive traffic agents instead of following their trajectories
      */
-    ObstacleSimulationManager(std::shared_ptr<CommonRoadScenario> _scenario, bool use_simulated_time);
+    ObstacleSimulationManager(std::shared_ptr<CommonRoadScenario> _scenario, bool use_simulated_time, uint64_t prediction_horizon_ms = 3000, bool reactive_agents = false);
 
     /**
      * \brief Destructor for threads & timer
@@ -137,6 +199,12 @@ public:
      */
     void stop();
 
+    /**
+     * \brief Set the callback for the data of the real and simulated vehicles, which reactive traffic agents react to (see TimeSeriesAggregator::get_vehicle_data)
+     * \param _get_vehicle_data The callback
+     */
+    void set_vehicle_data_callback(std::function<map<uint8_t, map<string, shared_ptr<TimeSeries>>>()> _get_vehicle_data);
+
     /**
      * \brief Set the simulation state (off, visualized/simulated, trajectory) for an obstacle (default is simulated)
      * \param id ID of the obstacle in commonroad
@@ -154,7 +154,7 @@ bool RTTAggregator::get_rtt(std::string participant_id, uint64_t &_current_best_
     if (measure_count[participant_id] <= 0)
     {
         _missed_answers = 0;
-        cpm::Logging::Instance().write(1, "%s", "Warning: An overflow occured in RTT aggregator, missed answers data is certainly wrong");
+        CPM_LOG(1, "%s", "Warning: An overflow occured in RTT aggregator, missed answers data is certainly wrong");
     }
     else
     {
@@ -0,0 +1,525 @@
+#include "ReactiveTrafficSimulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * \file ReactiveTrafficSimulation.cpp
+ * \ingroup lcc
+ */
+
+ReactiveTrafficLane ReactiveTrafficLane::from_points(const std::vector<std::pair<double, double>>& points)
+{
+    ReactiveTrafficLane lane;
+    double arc_length = 0;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        //Skip duplicate points, they would create segments without a direction
+        if (i > 0)
+        {
+            double segment_length = std::hypot(points[i].first - lane.x.back(), points[i].second - lane.y.back());
+            if (segment_length < 1e-6) continue;
+            arc_length += segment_length;
+        }
+
+        lane.x.push_back(points[i].first);
+        lane.y.push_back(points[i].second);
+        lane.s.push_back(arc_length);
+    }
+    return lane;
+}
+
+double ReactiveTrafficLane::length() const
+{
+    return (s.size() > 0) ? s.back() : 0.0;
+}
+
+ReactiveTrafficSimulation::ReactiveTrafficSimulation(std::vector<ReactiveTrafficLane> _lanes, Parameters _parameters)
+:parameters(_parameters)
+,lanes(_lanes)
+{
+    //Lanes without a segment cannot be followed, so no lane may lead to them
+    for (auto& lane_entry : lanes)
+    {
+        lane_entry.successors.erase(
+            std::remove_if(lane_entry.successors.begin(), lane_entry.successors.end(), [&](int successor){
+                return successor < 0 || static_cast<size_t>(successor) >= lanes.size() || lanes[successor].s.size() < 2;
+            }),
+            lane_entry.successors.end()
+        );
+        if (lane_entry.left >= static_cast<int>(lanes.size()) || (lane_entry.left >= 0 && lanes[lane_entry.left].s.size() < 2)) lane_entry.left = -1;
+        if (lane_entry.right >= static_cast<int>(lanes.size()) || (lane_entry.right >= 0 && lanes[lane_entry.right].s.size() < 2)) lane_entry.right = -1;
+    }
+
+    parameters.max_lookahead = std::max(parameters.max_lookahead, 0.01);
+}
+
+double ReactiveTrafficSimulation::project_onto_lane(int lane_index, double px, double py, double& s_out, size_t& segment_out, double& lateral_out) const
+{
+    const auto& lane_entry = lanes.at(lane_index);
+    double min_distance = std::numeric_limits<double>::max();
+
+    for (size_t i = 0; i + 1 < lane_entry.x.size(); ++i)
+    {
+        double dx = lane_entry.x[i + 1] - lane_entry.x[i];
+        double dy = lane_entry.y[i + 1] - lane_entry.y[i];
+        double segment_length = lane_entry.s[i + 1] - lane_entry.s[i];
+        double t = ((px - lane_entry.x[i]) * dx + (py - lane_entry.y[i]) * dy) / (segment_length * segment_length);
+        t = std::min(std::max(t, 0.0), 1.0);
+
+        double projected_x = lane_entry.x[i] + t * dx;
+        double projected_y = lane_entry.y[i] + t * dy;
+        double distance = std::hypot(px - projected_x, py - projected_y);
+        if (distance < min_distance)
+        {
+            min_distance = distance;
+            s_out = lane_entry.s[i] + t * segment_length;
+            segment_out = i;
+            //Cross product: Positive if the position is left of the center line
+            lateral_out = (dx * (py - projected_y) - dy * (px - projected_x)) / segment_length;
+        }
+    }
+
+    return min_distance;
+}
+
+double ReactiveTrafficSimulation::lane_curvature(int lane_index, size_t lane_segment) const
+{
+    const auto& lane_entry = lanes[lane_index];
+    if (lane_entry.s.size() < 3) return 0.0;
+
+    size_t first = std::min(lane_segment, lane_entry.s.size() - 3);
+    double yaw_1 = std::atan2(lane_entry.y[first + 1] - lane_entry.y[first], lane_entry.x[first + 1] - lane_entry.x[first]);
+    double yaw_2 = std::atan2(lane_entry.y[first + 2] - lane_entry.y[first + 1], lane_entry.x[first + 2] - lane_entry.x[first + 1]);
+    double yaw_change = std::remainder(yaw_2 - yaw_1, 2.0 * M_PI);
+    return yaw_change / (0.5 * (lane_entry.s[first + 2] - lane_entry.s[first]));
+}
+
+void ReactiveTrafficSimulation::update_pose(size_t agent)
+{
+    const auto& lane_entry = lanes[lane[agent]];
+    s[agent] = std::min(std::max(s[agent], 0.0), lane_entry.length());
+
+    //Agents move forward, so the segment is usually found after a few comparisons
+    size_t& seg = segment[agent];
+    if (seg + 1 >= lane_entry.s.size()) seg = 0;
+    while (seg > 0 && s[agent] < lane_entry.s[seg]) --seg;
+    while (seg + 2 < lane_entry.s.size() && s[agent] > lane_entry.s[seg + 1]) ++seg;
+
+    double dx = lane_entry.x[seg + 1] - lane_entry.x[seg];
+    double dy = lane_entry.y[seg + 1] - lane_entry.y[seg];
+    double segment_length = lane_entry.s[seg + 1] - lane_entry.s[seg];
+    double t = (s[agent] - lane_entry.s[seg]) / segment_length;
+
+    yaw[agent] = std::atan2(dy, dx);
+    curvature[agent] = lane_curvature(lane[agent], seg);
+    x[agent] = lane_entry.x[seg] + t * dx - std::sin(yaw[agent]) * lateral_offset[agent];
+    y[agent] = lane_entry.y[seg] + t * dy + std::cos(yaw[agent]) * lateral_offset[agent];
+}
+
+uint32_t ReactiveTrafficSimulation::hash_bucket(int64_t cell_x, int64_t cell_y) const
+{
+    uint64_t hash = static_cast<uint64_t>(cell_x) * 73856093ull ^ static_cast<uint64_t>(cell_y) * 19349663ull;
+    return static_cast<uint32_t>(hash ^ (hash >> 32)) & hash_mask;
+}
+
+void ReactiveTrafficSimulation::build_spatial_hash()
+{
+    size_t entity_count = agent_id.size() + external_vehicles.size();
+
+    //At least twice as many buckets as entities, s.t. different cells rarely share a bucket
+    uint32_t bucket_count = 16;
+    while (bucket_count < 2 * entity_count) bucket_count <<= 1;
+    hash_mask = bucket_count - 1;
+
+    hash_entity_bucket.resize(entity_count);
+    hash_bucket_start.assign(bucket_count + 1, 0);
+    hash_entries.resize(entity_count);
+
+    //Counting sort by bucket: Count, prefix sum, then place
+    for (size_t entity = 0; entity < entity_count; ++entity)
+    {
+        double ex, ey, eyaw, espeed, elength;
+        get_entity(entity, ex, ey, eyaw, espeed, elength);
+        uint32_t bucket = hash_bucket(
+            static_cast<int64_t>(std::floor(ex / parameters.max_lookahead)),
+            static_cast<int64_t>(std::floor(ey / parameters.max_lookahead))
+        );
+        hash_entity_bucket[entity] = bucket;
+        ++hash_bucket_start[bucket + 1];
+    }
+
+    for (uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+        hash_bucket_start[bucket + 1] += hash_bucket_start[bucket];
+    }
+
+    std::vector<uint32_t> insert_position(hash_bucket_start.begin(), hash_bucket_start.end() - 1);
+    hash_entry_x.resize(entity_count);
+    hash_entry_y.resize(entity_count);
+    for (size_t entity = 0; entity < entity_count; ++entity)
+    {
+        uint32_t position = insert_position[hash_entity_bucket[entity]]++;
+        hash_entries[position] = static_cast<uint32_t>(entity);
+
+        double ex, ey, eyaw, espeed, elength;
+        get_entity(entity, ex, ey, eyaw, espeed, elength);
+        hash_entry_x[position] = ex;
+        hash_entry_y[position] = ey;
+    }
+}
+
+void ReactiveTrafficSimulation::get_entity(size_t entity, double& ex, double& ey, double& eyaw, double& espeed, double& elength) const
+{
+    if (entity < agent_id.size())
+    {
+        ex = x[entity];
+        ey = y[entity];
+        eyaw = yaw[entity];
+        espeed = speed[entity];
+        elength = length[entity];
+    }
+    else
+    {
+        const auto& vehicle = external_vehicles[entity - agent_id.size()];
+        ex = vehicle.x;
+        ey = vehicle.y;
+        eyaw = vehicle.yaw;
+        espeed = vehicle.speed;
+        elength = vehicle.length;
+    }
+}
+
+ReactiveTrafficSimulation::Neighbour ReactiveTrafficSimulation::find_neighbour(double px, double py, double pyaw, double pcurvature, double own_length, size_t ignore_entity, bool ahead) const
+{
+    Neighbour neighbour;
+    double min_distance = parameters.max_lookahead;
+    double cos_yaw = std::cos(pyaw);
+    double sin_yaw = std::sin(pyaw);
+
+    //On curved lanes, distances are measured along the arc through the position (center at center_x, center_y)
+    bool use_arc = std::abs(pcurvature) > 1e-3;
+    double radius = use_arc ? 1.0 / pcurvature : 0.0;
+    double center_x = px - sin_yaw * radius;
+    double center_y = py + cos_yaw * radius;
+
+    //The cell size equals the lookahead, so the 3x3 cells around the position contain all candidates
+    int64_t cell_x = static_cast<int64_t>(std::floor(px / parameters.max_lookahead));
+    int64_t cell_y = static_cast<int64_t>(std::floor(py / parameters.max_lookahead));
+    uint32_t visited_buckets[9];
+    size_t visited_count = 0;
+
+    for (int64_t offset_x = -1; offset_x <= 1; ++offset_x)
+    {
+        for (int64_t offset_y = -1; offset_y <= 1; ++offset_y)
+        {
+            //Different cells may share a bucket, which must only be searched once
+            uint32_t bucket = hash_bucket(cell_x + offset_x, cell_y + offset_y);
+            if (std::find(visited_buckets, visited_buckets + visited_count, bucket) != visited_buckets + visited_count) continue;
+            visited_buckets[visited_count++] = bucket;
+
+            for (uint32_t i = hash_bucket_start[bucket]; i < hash_bucket_start[bucket + 1]; ++i)
+            {
+                //The distance along the lane is at least the straight distance, so most candidates are rejected here
+                double dx = hash_entry_x[i] - px;
+                double dy = hash_entry_y[i] - py;
+                if (dx * dx + dy * dy >= min_distance * min_distance) continue;
+
+                size_t entity = hash_entries[i];
+                if (entity == ignore_entity) continue;
+
+                double ex, ey, eyaw, espeed, elength;
+                get_entity(entity, ex, ey, eyaw, espeed, elength);
+
+                double longitudinal, lateral, expected_yaw;
+                if (use_arc)
+                {
+                    double from_center_x = ex - center_x;
+                    double from_center_y = ey - center_y;
+                    //Angle between the position and the entity as seen from the center, positive in driving direction
+                    double angle = std::atan2(
+                        (px - center_x) * from_center_y - (py - center_y) * from_center_x,
+                        (px - center_x) * from_center_x + (py - center_y) * from_center_y
+                    );
+                    longitudinal = angle * radius;
+                    lateral = std::copysign(std::abs(radius) - std::hypot(from_center_x, from_center_y), pcurvature);
+                    expected_yaw = pyaw + angle;
+                }
+                else
+                {
+                    longitudinal = dx * cos_yaw + dy * sin_yaw;
+                    lateral = -dx * sin_yaw + dy * cos_yaw;
+                    expected_yaw = pyaw;
+                }
+
+                if (!ahead) longitudinal = -longitudinal;
+                if (longitudinal <= 0 || longitudinal >= min_distance || std::abs(lateral) >= parameters.lane_half_width) continue;
+
+                //Oncoming vehicles are not regarded as leaders / followers
+                double heading_alignment = std::cos(eyaw - expected_yaw);
+                if (heading_alignment <= 0) continue;
+
+                min_distance = longitudinal;
+                neighbour.found = true;
+                neighbour.entity = entity;
+                neighbour.gap = longitudinal - 0.5 * (own_length + elength);
+                neighbour.speed = espeed * heading_alignment;
+            }
+        }
+    }
+
+    return neighbour;
+}
+
+double ReactiveTrafficSimulation::idm_acceleration(double v, double v0, const Neighbour& neighbour) const
+{
+    const double a = parameters.max_acceleration;
+    const double b = parameters.comfortable_deceleration;
+
+    double acceleration = a * (1.0 - std::pow(v / std::max(v0, 0.01), parameters.acceleration_exponent));
+    if (neighbour.found)
+    {
+        double desired_gap = parameters.min_gap + std::max(0.0, v * parameters.time_gap + v * (v - neighbour.speed) / (2.0 * std::sqrt(a * b)));
+        double gap = std::max(neighbour.gap, 0.01);
+        acceleration -= a * (desired_gap / gap) * (desired_gap / gap);
+    }
+
+    //Limit the (physically impossible) deceleration for very small gaps
+    return std::max(acceleration, -10.0 * b);
+}
+
+void ReactiveTrafficSimulation::decide_lane_change(size_t agent)
+{
+    target_lane[agent] = -1;
+    if (lane_change_wait[agent] > 0 || std::abs(lateral_offset[agent]) > 0.01) return;
+
+    const auto& lane_entry = lanes[lane[agent]];
+    if (lane_entry.left < 0 && lane_entry.right < 0) return;
+
+    //The agent cannot accelerate more than on a free road, so agents that are (almost) unhindered do not need to evaluate a lane change
+    Neighbour no_leader;
+    if (idm_acceleration(speed[agent], desired_speed[agent], no_leader) - acceleration[agent] <= parameters.lane_change_threshold) return;
+    double best_incentive = parameters.lane_change_threshold;
+
+    for (int candidate : {lane_entry.left, lane_entry.right})
+    {
+        if (candidate < 0) continue;
+
+        double target_s, target_lateral;
+        size_t target_segment;
+        if (project_onto_lane(candidate, x[agent], y[agent], target_s, target_segment, target_lateral) > parameters.max_lane_distance) continue;
+
+        const auto& target_entry = lanes[candidate];
+        double target_yaw = std::atan2(target_entry.y[target_segment + 1] - target_entry.y[target_segment], target_entry.x[target_segment + 1] - target_entry.x[target_segment]);
+        double target_x = x[agent] + std::sin(target_yaw) * target_lateral;
+        double target_y = y[agent] - std::cos(target_yaw) * target_lateral;
+
+        //Own gain
+        double target_curvature = lane_curvature(candidate, target_segment);
+        auto new_leader = find_neighbour(target_x, target_y, target_yaw, target_curvature, length[agent], agent, true);
+        double new_acceleration = idm_acceleration(speed[agent], desired_speed[agent], new_leader);
+
+        //Effect on the new follower, which must not need to brake too hard
+        double follower_gain = 0;
+        auto new_follower = find_neighbour(target_x, target_y, target_yaw, target_curvature, length[agent], agent, false);
+        if (new_follower.found)
+        {
+            //The follower's new leader would be this agent; external vehicles are assumed to keep their speed
+            Neighbour agent_as_leader;
+            agent_as_leader.found = true;
+            agent_as_leader.gap = new_follower.gap;
+            agent_as_leader.speed = speed[agent];
+
+            bool follower_is_agent = new_follower.entity < agent_id.size();
+            double follower_desired_speed = follower_is_agent ? desired_speed[new_follower.entity] : new_follower.speed;
+            double follower_acceleration = follower_is_agent ? acceleration[new_follower.entity] : 0.0;
+            double follower_new_acceleration = idm_acceleration(new_follower.speed, follower_desired_speed, agent_as_leader);
+
+            if (follower_new_acceleration < -parameters.safe_deceleration) continue;
+            follower_gain = follower_new_acceleration - follower_acceleration;
+        }
+
+        double incentive = new_acceleration - acceleration[agent] + parameters.politeness * follower_gain;
+        if (incentive > best_incentive)
+        {
+            best_incentive = incentive;
+            target_lane[agent] = candidate;
+        }
+    }
+}
+
+bool ReactiveTrafficSimulation::add_agent(int id, double px, double py, double pyaw, double initial_speed, double _desired_speed, double _length)
+{
+    int best_lane = -1;
+    double best_distance = parameters.max_lane_distance;
+    double best_s = 0;
+
+    for (size_t lane_index = 0; lane_index < lanes.size(); ++lane_index)
+    {
+        if (lanes[lane_index].s.size() < 2) continue;
+
+        double lane_s, lateral;
+        size_t lane_segment;
+        double distance = project_onto_lane(static_cast<int>(lane_index), px, py, lane_s, lane_segment, lateral);
+
+        //The lane must point in the direction of the agent
+        const auto& lane_entry = lanes[lane_index];
+        double lane_yaw = std::atan2(lane_entry.y[lane_segment + 1] - lane_entry.y[lane_segment], lane_entry.x[lane_segment + 1] - lane_entry.x[lane_segment]);
+        if (std::cos(lane_yaw - pyaw) <= 0) continue;
+
+        if (distance <= best_distance)
+        {
+            best_distance = distance;
+            best_lane = static_cast<int>(lane_index);
+            best_s = lane_s;
+        }
+    }
+
+    if (best_lane < 0) return false;
+
+    agent_id.push_back(id);
+    lane.push_back(best_lane);
+    segment.push_back(0);
+    s.push_back(best_s);
+    speed.push_back(std::max(initial_speed, 0.0));
+    desired_speed.push_back(std::max(_desired_speed, 0.01));
+    length.push_back(std::max(_length, 0.0));
+    lateral_offset.push_back(0);
+    lane_change_wait.push_back(0);
+    x.push_back(px);
+    y.push_back(py);
+    yaw.push_back(pyaw);
+    curvature.push_back(0);
+    acceleration.push_back(0);
+    target_lane.push_back(-1);
+    initial_state.push_back(std::make_pair(best_lane, std::make_pair(best_s, std::max(initial_speed, 0.0))));
+
+    update_pose(agent_id.size() - 1);
+    return true;
+}
+
+void ReactiveTrafficSimulation::set_external_vehicles(std::vector<ReactiveTrafficVehicle> vehicles)
+{
+    external_vehicles = vehicles;
+}
+
+void ReactiveTrafficSimulation::step(double dt)
+{
+    if (dt <= 0) return;
+    size_t agent_count = agent_id.size();
+
+    //All decisions are based on the state at the start of the step, so the order of the agents does not matter
+    build_spatial_hash();
+
+    for (size_t agent = 0; agent < agent_count; ++agent)
+    {
+        auto leader = find_neighbour(x[agent], y[agent], yaw[agent], curvature[agent], length[agent], agent, true);
+
+        //A lane without successor ends like a standing vehicle
+        const auto& lane_entry = lanes[lane[agent]];
+        double distance_to_end = lane_entry.length() - s[agent] - 0.5 * length[agent];
+        if (lane_entry.successors.empty() && distance_to_end < parameters.max_lookahead && (!leader.found || distance_to_end < leader.gap))
+        {
+            leader.found = true;
+            leader.gap = distance_to_end + parameters.min_gap;
+            leader.speed = 0;
+        }
+
+        acceleration[agent] = idm_acceleration(speed[agent], desired_speed[agent], leader);
+    }
+
+    for (size_t agent = 0; agent < agent_count; ++agent)
+    {
+        lane_change_wait[agent] = std::max(lane_change_wait[agent] - dt, 0.0);
+        decide_lane_change(agent);
+    }
+
+    for (size_t agent = 0; agent < agent_count; ++agent)
+    {
+        if (target_lane[agent] >= 0)
+        {
+            //Keep the current position, the lateral offset is then reduced smoothly
+            double lateral;
+            project_onto_lane(target_lane[agent], x[agent], y[agent], s[agent], segment[agent], lateral);
+            lane[agent] = target_lane[agent];
+            lateral_offset[agent] = lateral;
+            lane_change_wait[agent] = parameters.lane_change_cooldown;
+        }
+
+        speed[agent] = std::max(speed[agent] + acceleration[agent] * dt, 0.0);
+        s[agent] += speed[agent] * dt;
+
+        while (s[agent] > lanes[lane[agent]].length())
+        {
+            const auto& successors = lanes[lane[agent]].successors;
+            if (successors.empty())
+            {
+                s[agent] = lanes[lane[agent]].length();
+                speed[agent] = 0;
+                break;
+            }
+
+            //Deterministic route choice at forks
+            s[agent] -= lanes[lane[agent]].length();
+            lane[agent] = successors[static_cast<size_t>(std::abs(agent_id[agent])) % successors.size()];
+            segment[agent] = 0;
+        }
+
+        double offset_change = parameters.lateral_speed * dt;
+        lateral_offset[agent] = (std::abs(lateral_offset[agent]) <= offset_change) ? 0.0 : lateral_offset[agent] - std::copysign(offset_change, lateral_offset[agent]);
+
+        update_pose(agent);
+    }
+}
+
+void ReactiveTrafficSimulation::reset()
+{
+    for (size_t agent = 0; agent < agent_id.size(); ++agent)
+    {
+        lane[agent] = initial_state[agent].first;
+        s[agent] = initial_state[agent].second.first;
+        speed[agent] = initial_state[agent].second.second;
+        segment[agent] = 0;
+        lateral_offset[agent] = 0;
+        lane_change_wait[agent] = 0;
+        acceleration[agent] = 0;
+        target_lane[agent] = -1;
+        update_pose(agent);
+    }
+}
+
+size_t ReactiveTrafficSimulation::size() const
+{
+    return agent_id.size();
+}
+
+int ReactiveTrafficSimulation::get_id(size_t agent) const
+{
+    return agent_id.at(agent);
+}
+
+double ReactiveTrafficSimulation::get_x(size_t agent) const
+{
+    return x.at(agent);
+}
+
+double ReactiveTrafficSimulation::get_y(size_t agent) const
+{
+    return y.at(agent);
+}
+
+double ReactiveTrafficSimulation::get_yaw(size_t agent) const
+{
+    return yaw.at(agent);
+}
+
+double ReactiveTrafficSimulation::get_speed(size_t agent) const
+{
+    return speed.at(agent);
+}
+
+int ReactiveTrafficSimulation::get_lane(size_t agent) const
+{
+    return lane.at(agent);
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * \struct ReactiveTrafficLane
+ * \brief Lane that reactive traffic agents can follow, usually created from the center line of a commonroad lanelet
+ * \ingroup lcc
+ */
+struct ReactiveTrafficLane
+{
+    //! x coordinates of the center line points
+    std::vector<double> x;
+    //! y coordinates of the center line points
+    std::vector<double> y;
+    //! Arc length of the center line at each point, starting at 0
+    std::vector<double> s;
+    //! Indices of the lanes that follow this lane
+    std::vector<int> successors;
+    //! Index of the adjacent lane on the left with the same driving direction, -1 if none exists
+    int left = -1;
+    //! Index of the adjacent lane on the right with the same driving direction, -1 if none exists
+    int right = -1;
+
+    /**
+     * \brief Create a lane from its center line (s is computed from the points)
+     * \param points Center line, at least two points
+     */
+    static ReactiveTrafficLane from_points(const std::vector<std::pair<double, double>>& points);
+
+    /**
+     * \brief Length of the lane in m
+     */
+    double length() const;
+};
+
+/**
+ * \struct ReactiveTrafficVehicle
+ * \brief A (real or simulated) vehicle that reactive traffic agents react to, but which they do not control
+ * \ingroup lcc
+ */
+struct ReactiveTrafficVehicle
+{
+    //! x position in m
+    double x = 0;
+    //! y position in m
+    double y = 0;
+    //! Orientation in rad
+    double yaw = 0;
+    //! Speed in m/s
+    double speed = 0;
+    //! Length in m
+    double length = 0.22;
+};
+
+/**
+ * \class ReactiveTrafficSimulation
+ * \brief Simulates traffic agents that follow lanes and react to each other and to the vehicles in the lab:
+ * The longitudinal behaviour is given by the Intelligent Driver Model (IDM), lane changes by a simplified MOBIL model
+ * (the gain of the agent and of its new follower is weighed against a threshold, the new follower must not need to brake harder than a safe deceleration).
+ * To simulate several hundred agents in each timer period, the agent state is stored as a struct of arrays and
+ * neighbours are found with a spatial hash (a grid with cell size max_lookahead, stored as a counting-sorted index array that is rebuilt in each step).
+ * Leaders and followers are found geometrically (within the lane's half width along an arc with the lane's local curvature), s.t. agents also react to vehicles which are not on a known lane.
+ * This class does not depend on DDS or the commonroad classes, see ObstacleSimulationManager for its use.
+ * \ingroup lcc
+ */
+class ReactiveTrafficSimulation
+{
+public:
+    /**
+     * \struct Parameters
+     * \brief Model parameters, defaults are chosen for the 1:18 vehicles of the lab
+     */
+    struct Parameters
+    {
+        //! Max. acceleration in m/s^2 (IDM a)
+        double max_acceleration = 1.0;
+        //! Comfortable deceleration in m/s^2 (IDM b)
+        double comfortable_deceleration = 1.5;
+        //! Desired time gap to the leader in s (IDM T)
+        double time_gap = 0.8;
+        //! Min. distance to the leader when standing in m (IDM s0)
+        double min_gap = 0.1;
+        //! Acceleration exponent (IDM delta)
+        double acceleration_exponent = 4.0;
+        //! Leaders and followers are only searched within this distance in m; also the cell size of the spatial hash
+        double max_lookahead = 2.0;
+        //! Half width of a lane in m, vehicles with a larger lateral distance are not regarded as leader / follower
+        double lane_half_width = 0.15;
+        //! Politeness factor of the lane change model (MOBIL p)
+        double politeness = 0.2;
+        //! Min. acceleration gain in m/s^2 for a lane change (MOBIL a_thr)
+        double lane_change_threshold = 0.2;
+        //! Max. deceleration in m/s^2 that a lane change may force upon the new follower (MOBIL b_safe)
+        double safe_deceleration = 2.0;
+        //! Min. time in s between two lane changes of an agent
+        double lane_change_cooldown = 3.0;
+        //! Speed in m/s with which the lateral offset after a lane change is reduced
+        double lateral_speed = 0.3;
+        //! Agents are only placed on a lane if they are at most this far away from its center line, in m
+        double max_lane_distance = 0.5;
+    };
+
+private:
+    //! Model parameters
+    Parameters parameters;
+    //! Lanes the agents follow
+    std::vector<ReactiveTrafficLane> lanes;
+
+    //Agent state, struct of arrays (index = agent)
+    //! ID of the agent (e.g. the commonroad obstacle ID)
+    std::vector<int> agent_id;
+    //! Current lane
+    std::vector<int> lane;
+    //! Current segment of the lane's center line (index of its first point)
+    std::vector<size_t> segment;
+    //! Position along the lane's center line in m
+    std::vector<double> s;
+    //! Speed in m/s
+    std::vector<double> speed;
+    //! Desired speed in m/s (IDM v0)
+    std::vector<double> desired_speed;
+    //! Length in m
+    std::vector<double> length;
+    //! Lateral offset to the lane's center line in m (left is positive), reduced to zero after a lane change
+    std::vector<double> lateral_offset;
+    //! Time until the next lane change is allowed in s
+    std::vector<double> lane_change_wait;
+    //! Pose of the agent, derived from lane, s and lateral_offset
+    std::vector<double> x;
+    //! Pose of the agent, derived from lane, s and lateral_offset
+    std::vector<double> y;
+    //! Pose of the agent, derived from lane, s and lateral_offset
+    std::vector<double> yaw;
+    //! Curvature of the lane at the agent's position
+    std::vector<double> curvature;
+    //! Acceleration computed in the last step
+    std::vector<double> acceleration;
+    //! Target lane of a lane change decided in the current step, -1 if none
+    std::vector<int> target_lane;
+
+    //! Initial lane, s and speed of each agent, for reset()
+    std::vector<std::pair<int, std::pair<double, double>>> initial_state;
+
+    //! Vehicles the agents react to
+    std::vector<ReactiveTrafficVehicle> external_vehicles;
+
+    //Spatial hash of agents and external vehicles (index < agent count: agent, else external vehicle)
+    //! Start of each bucket in hash_entries (size: bucket count + 1)
+    std::vector<uint32_t> hash_bucket_start;
+    //! Entity indices, sorted by bucket
+    std::vector<uint32_t> hash_entries;
+    //! Positions of the entities in the order of hash_entries, s.t. a bucket can be scanned without accessing the agent arrays
+    std::vector<double> hash_entry_x;
+    //! Positions of the entities in the order of hash_entries, s.t. a bucket can be scanned without accessing the agent arrays
+    std::vector<double> hash_entry_y;
+    //! Bucket of each entity in the current step
+    std::vector<uint32_t> hash_entity_bucket;
+    //! Bucket count - 1 (bucket count is a power of two)
+    uint32_t hash_mask = 0;
+
+    /**
+     * \brief Closest vehicle ahead of / behind a position (leader or follower)
+     */
+    struct Neighbour
+    {
+        //! Bumper-to-bumper distance in m, only valid if found
+        double gap = 0;
+        //! Speed of the neighbour along the queried heading in m/s
+        double speed = 0;
+        //! Entity index of the neighbour (see hash_entries), only valid if found
+        size_t entity = 0;
+        //! If a neighbour was found
+        bool found = false;
+    };
+
+    /**
+     * \brief Project a position onto a lane
+     * \param lane_index The lane
+     * \param px x position
+     * \param py y position
+     * \param s_out Return value: Arc length of the projection
+     * \param segment_out Return value: Segment of the projection
+     * \param lateral_out Return value: Signed lateral distance to the center line (left is positive)
+     * \return Distance of the position to the center line
+     */
+    double project_onto_lane(int lane_index, double px, double py, double& s_out, size_t& segment_out, double& lateral_out) const;
+
+    /**
+     * \brief Curvature of a lane, estimated from the heading change at the end of a segment
+     * \param lane_index The lane
+     * \param lane_segment The segment
+     */
+    double lane_curvature(int lane_index, size_t lane_segment) const;
+
+    /**
+     * \brief Update the pose (and the segment) of an agent from its lane, s and lateral offset
+     * \param agent The agent
+     */
+    void update_pose(size_t agent);
+
+    /**
+     * \brief Bucket of a grid cell in the spatial hash
+     */
+    uint32_t hash_bucket(int64_t cell_x, int64_t cell_y) const;
+
+    /**
+     * \brief Rebuild the spatial hash from the current agent poses and the external vehicles
+     */
+    void build_spatial_hash();
+
+    /**
+     * \brief Get position, heading, speed and length of an entity of the spatial hash
+     */
+    void get_entity(size_t entity, double& ex, double& ey, double& eyaw, double& espeed, double& elength) const;
+
+    /**
+     * \brief Find the closest vehicle ahead of (or behind) a position, within the lane's half width along an arc with the given heading and curvature
+     * \param px x position
+     * \param py y position
+     * \param pyaw Heading
+     * \param pcurvature Curvature of the lane at the position
+     * \param own_length Length of the vehicle at the position
+     * \param ignore_entity Entity to ignore (usually the agent itself)
+     * \param ahead True to find the leader, false to find the follower
+     */
+    Neighbour find_neighbour(double px, double py, double pyaw, double pcurvature, double own_length, size_t ignore_entity, bool ahead) const;
+
+    /**
+     * \brief IDM acceleration
+     * \param v Own speed
+     * \param v0 Desired speed
+     * \param neighbour Leader, if any
+     */
+    double idm_acceleration(double v, double v0, const Neighbour& neighbour) const;
+
+    /**
+     * \brief Decide if an agent should change to an adjacent lane (simplified MOBIL), sets target_lane
+     * \param agent The agent
+     */
+    void decide_lane_change(size_t agent);
+
+public:
+    /**
+     * \brief Constructor
+     * \param _lanes Lanes the agents follow, referencing each other by their index
+     * \param _parameters Model parameters
+     */
+    ReactiveTrafficSimulation(std::vector<ReactiveTrafficLane> _lanes, Parameters _parameters);
+
+    /**
+     * \brief Add an agent at the closest lane that points in the agent's direction
+     * \param id ID of the agent
+     * \param px x position
+     * \param py y position
+     * \param pyaw Orientation, used to find a lane with the same direction
+     * \param initial_speed Initial speed in m/s
+     * \param _desired_speed Desired speed in m/s
+     * \param _length Length of the agent in m
+     * \return False if no lane is close enough (the agent is not added then)
+     */
+    bool add_agent(int id, double px, double py, double pyaw, double initial_speed, double _desired_speed, double _length);
+
+    /**
+     * \brief Set the vehicles the agents react to in the next steps
+     * \param vehicles The vehicles
+     */
+    void set_external_vehicles(std::vector<ReactiveTrafficVehicle> vehicles);
+
+    /**
+     * \brief Simulate all agents for dt seconds
+     * \param dt Step size in s
+     */
+    void step(double dt);
+
+    /**
+     * \brief Reset all agents to the state they were added with
+     */
+    void reset();
+
+    /**
+     * \brief Number of agents
+     */
+    size_t size() const;
+
+    //! ID of an agent
+    int get_id(size_t agent) const;
+    //! x position of an agent in m
+    double get_x(size_t agent) const;
+    //! y position of an agent in m
+    double get_y(size_t agent) const;
+    //! Orientation of an agent in rad
+    double get_yaw(size_t agent) const;
+    //! Speed of an agent in m/s
+    double get_speed(size_t agent) const;
+    //! Lane (index) of an agent
+    int get_lane(size_t agent) const;
+};
@@ -5,6 +5,9 @@
  * \ingroup lcc
  */
 
+template<typename T>
+constexpr size_t _TimeSeries<T>::newest_samples_kept;
+
 template<typename T>
 _TimeSeries<T>::_TimeSeries(string _name, string _format, string _unit)
 :name(_name)
@@ -74,10 +77,58 @@ uint64_t _TimeSeries<T>::get_latest_time() const
 template<typename T>
 vector<T> _TimeSeries<T>::get_last_n_values(size_t n) const 
 {
+    //Lock required, as the samples may be downsampled from another thread
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     if(values.size() <= n) return values;
 
     return vector<T>(values.end()-n, values.end());
 }
 
+template<typename T>
+size_t _TimeSeries<T>::get_memory_footprint_locked() const
+{
+    return sizeof(*this) + times.capacity() * sizeof(uint64_t) + values.capacity() * sizeof(T);
+}
+
+template<typename T>
+size_t _TimeSeries<T>::get_memory_footprint() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return get_memory_footprint_locked();
+}
+
+template<typename T>
+void _TimeSeries<T>::downsample_oldest(size_t max_bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (get_memory_footprint_locked() <= max_bytes) return;
+
+    //Capacity only shrinks after the loop, so the loop checks the footprint the samples will have then
+    auto footprint_after_shrink = [this] () {
+        return sizeof(*this) + times.size() * sizeof(uint64_t) + values.size() * sizeof(T);
+    };
+
+    while (footprint_after_shrink() > max_bytes && times.size() > newest_samples_kept + 1)
+    {
+        //Keep every second of the older samples (including the first one, which is the initial sample from the constructor)
+        size_t old_samples = times.size() - newest_samples_kept;
+        size_t kept = 0;
+        for (size_t i = 0; i < old_samples; i += 2)
+        {
+            times[kept] = times[i];
+            values[kept] = values[i];
+            ++kept;
+        }
+        times.erase(times.begin() + kept, times.begin() + old_samples);
+        values.erase(values.begin() + kept, values.begin() + old_samples);
+    }
+
+    //Erasing does not free memory by itself; reallocate once, not with every pass
+    times.shrink_to_fit();
+    values.shrink_to_fit();
+}
+
 template class _TimeSeries<double>;
 template class _TimeSeries<TrajectoryPoint>;
\ No newline at end of file
@@ -28,6 +28,14 @@ class _TimeSeries
     //! TODO
     mutable std::mutex m_mutex;
 
+    //! Number of newest samples that are never removed by downsample_oldest (they are used for plots and checks in the UI)
+    static constexpr size_t newest_samples_kept = 1000;
+
+    /**
+     * \brief Footprint of the stored samples, m_mutex must be locked
+     */
+    size_t get_memory_footprint_locked() const;
+
 public:
     /**
      * \brief TODO Constructor
@@ -76,6 +84,11 @@ public:
      */
     string get_name() const {return name;}
 
+    /**
+     * \brief Get the printf format of the values
+     */
+    string get_format() const {return format;}
+
     /**
      * \brief TODO
      */
@@ -87,6 +100,19 @@ public:
      */
     vector<T> get_last_n_values(size_t n) const;
 
+    /**
+     * \brief Get the (estimated) memory footprint of the time series in bytes
+     */
+    size_t get_memory_footprint() const;
+
+    /**
+     * \brief Reduce the memory footprint to at most max_bytes by repeatedly dropping every second of the older samples.
+     * Thus, the older part of the time series gets coarser, while the newest samples are kept as they are.
+     * The footprint might remain larger than max_bytes if only the newest samples are left.
+     * \param max_bytes Desired maximum footprint in bytes
+     */
+    void downsample_oldest(size_t max_bytes);
+
 };
 
 /**
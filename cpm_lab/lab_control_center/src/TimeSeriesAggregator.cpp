@@ -9,6 +9,10 @@
 
 TimeSeriesAggregator::TimeSeriesAggregator(uint8_t max_vehicle_id)
 {
+    //Created before the reader, which updates it
+    presence_tracker = make_shared<VehiclePresenceTracker>();
+    presence_tracker->start(100);
+
     vehicle_state_reader = make_shared<cpm::AsyncReader<VehicleState>>(
         [this](std::vector<VehicleState>& samples){
             handle_new_vehicleState_samples(samples);
@@ -37,6 +41,56 @@ TimeSeriesAggregator::TimeSeriesAggregator(uint8_t max_vehicle_id)
         cpm::get_topic<VehicleCommandPathTracking>("vehicleCommandPathTracking"),
         vehicle_ids
     );
+
+    //At 50 Hz, the time series of a single vehicle grow by more than 10 kB per second
+    memory_budget_id = MemoryBudget::Instance().register_component(
+        "time_series",
+        64 * 1024 * 1024,
+        [this](){ return get_memory_footprint(); },
+        [this](size_t max_bytes){ downsample_oldest(max_bytes); }
+    );
+}
+
+TimeSeriesAggregator::~TimeSeriesAggregator()
+{
+    MemoryBudget::Instance().unregister_component(memory_budget_id);
+}
+
+size_t TimeSeriesAggregator::get_memory_footprint()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t footprint = 0;
+    for (auto& vehicle_entry : timeseries_vehicles)
+    {
+        for (auto& timeseries_entry : vehicle_entry.second)
+        {
+            footprint += timeseries_entry.second->get_memory_footprint() + timeseries_entry.first.size() + MemoryBudget::MAP_NODE_OVERHEAD;
+        }
+    }
+    return footprint;
+}
+
+void TimeSeriesAggregator::downsample_oldest(size_t max_bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t timeseries_count = 0;
+    for (auto& vehicle_entry : timeseries_vehicles)
+    {
+        timeseries_count += vehicle_entry.second.size();
+    }
+    if (timeseries_count == 0) return;
+
+    //Time series that receive their samples together (e.g. pose_x and pose_y) get the same share, so they stay aligned after downsampling
+    size_t max_bytes_per_timeseries = max_bytes / timeseries_count;
+    for (auto& vehicle_entry : timeseries_vehicles)
+    {
+        for (auto& timeseries_entry : vehicle_entry.second)
+        {
+            timeseries_entry.second->downsample_oldest(max_bytes_per_timeseries);
+        }
+    }
 }
 
 
@@ -134,7 +188,7 @@ static inline double voltage_to_percent(const double& v)
 
 void TimeSeriesAggregator::handle_new_vehicleState_samples(std::vector<VehicleState>& samples)
 {
-    std::lock_guard<std::mutex> lock(_mutex); 
+    std::unique_lock<std::mutex> lock(_mutex); 
     const uint64_t now = cpm::get_time_ns();
     for(auto& state : samples)
     {
@@ -171,6 +225,13 @@ void TimeSeriesAggregator::handle_new_vehicleState_samples(std::vector<VehicleSt
         last_vehicle_state_time[state.vehicle_id()] = now;
         last_vehicle_state_time_dev[state.vehicle_id()] = now;
     }
+    lock.unlock();
+
+    //Not under the lock, s.t. subscribers of the tracker can get the vehicle data
+    for(auto& state : samples)
+    {
+        presence_tracker->update(state.vehicle_id(), state.is_real(), now);
+    }
 }
 
 void TimeSeriesAggregator::check_for_deviation(uint64_t t_now, std::unordered_map<uint8_t, uint64_t>::iterator entry, uint64_t allowed_diff)
@@ -179,13 +240,13 @@ void TimeSeriesAggregator::check_for_deviation(uint64_t t_now, std::unordered_ma
     {
         if (t_now - entry->second > allowed_diff)
         {
-            cpm::Logging::Instance().write(2, "Vehicle %i deviated from expected vehicle state frequency on LCC side or is offline", static_cast<int>(entry->first));
+            CPM_LOG(2, "Vehicle %i deviated from expected vehicle state frequency on LCC side or is offline", static_cast<int>(entry->first));
             entry->second = 0;
         }
         else if (t_now < entry->second)
         {
             //This should never occur, due to the way timestamps are stored, unless the clock values are obtained in a way that negative clock changes of the system change the timestamps
-            cpm::Logging::Instance().write(1, "Critical error in TimeSeriesAggregator check, this should never happen; (vehicle id %i)", static_cast<int>(entry->second));
+            CPM_LOG(1, "Critical error in TimeSeriesAggregator check, this should never happen; (vehicle id %i)", static_cast<int>(entry->second));
         }
     }
 }
@@ -256,10 +317,14 @@ VehicleData TimeSeriesAggregator::get_vehicle_data() {
     return timeseries_vehicles; 
 }
 
+shared_ptr<VehiclePresenceTracker> TimeSeriesAggregator::get_presence_tracker() {
+    return presence_tracker;
+}
+
 VehicleTrajectories TimeSeriesAggregator::get_vehicle_trajectory_commands() {
     VehicleTrajectories trajectory_sample;
     std::map<uint8_t, uint64_t> trajectory_sample_age;
-    vehicle_commandTrajectory_reader->get_samples(cpm::get_time_ns(), trajectory_sample, trajectory_sample_age);
+    vehicle_commandTrajectory_reader->get_sample_handles(cpm::get_time_ns(), trajectory_sample, trajectory_sample_age);
 
     //Only return data that is not fully outdated
     for(auto it = trajectory_sample.begin(); it != trajectory_sample.end(); /*No ++ because this depends on whether a deletion took place*/)
@@ -280,7 +345,7 @@ VehicleTrajectories TimeSeriesAggregator::get_vehicle_trajectory_commands() {
 VehiclePathTracking TimeSeriesAggregator::get_vehicle_path_tracking_commands() {
     VehiclePathTracking path_tracking_sample;
     std::map<uint8_t, uint64_t> path_tracking_sample_age;
-    vehicle_commandPathTracking_reader->get_samples(cpm::get_time_ns(), path_tracking_sample, path_tracking_sample_age);
+    vehicle_commandPathTracking_reader->get_sample_handles(cpm::get_time_ns(), path_tracking_sample, path_tracking_sample_age);
 
     //Only return data that is not fully outdated
     for(auto it = path_tracking_sample.begin(); it != path_tracking_sample.end(); /*No ++ because this depends on whether a deletion took place*/)
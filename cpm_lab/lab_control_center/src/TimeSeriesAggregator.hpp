@@ -13,6 +13,9 @@
 #include "cpm/MultiVehicleReader.hpp"
 #include "cpm/get_time_ns.hpp"
 
+#include "MemoryBudget.hpp"
+#include "VehiclePresenceTracker.hpp"
+
 #include <mutex>
 #include <unordered_map>
 
@@ -29,18 +32,18 @@ using VehicleData = map<uint8_t, map<string, shared_ptr<TimeSeries> > >;
 /**
  * \brief Definition for VehicleTrajectories.
  * 
- * Vehicle ID (uint8_t) -> VehicleCommandTrajectory data for that vehicle
+ * Vehicle ID (uint8_t) -> VehicleCommandTrajectory data for that vehicle (shared with the reader and other consumers, must not be modified)
  * \ingroup lcc
  */
-using VehicleTrajectories = map<uint8_t, VehicleCommandTrajectory >;
+using VehicleTrajectories = map<uint8_t, shared_ptr<const VehicleCommandTrajectory> >;
 
 /**
  * \brief Definition for VehiclePathTracking.
  * 
- * Vehicle ID (uint8_t) -> VehicleCommandPathTracking data for that vehicle
+ * Vehicle ID (uint8_t) -> VehicleCommandPathTracking data for that vehicle (shared with the reader and other consumers, must not be modified)
  * \ingroup lcc
  */
-using VehiclePathTracking = map<uint8_t, VehicleCommandPathTracking >;
+using VehiclePathTracking = map<uint8_t, shared_ptr<const VehicleCommandPathTracking> >;
 
 /**
  * \class TimeSeriesAggregator
@@ -75,6 +78,8 @@ class TimeSeriesAggregator
      */
     void handle_new_vehicleObservation_samples(std::vector<VehicleObservation>& samples);
 
+    //! Keeps track of which vehicles are online / real, updated with each received VehicleState (declared before the readers, s.t. it is destroyed after them)
+    shared_ptr<VehiclePresenceTracker> presence_tracker;
     //! Async. reader to receive vehicle state data from the vehicles and store them for later access in the LCC
     shared_ptr<cpm::AsyncReader<VehicleState>> vehicle_state_reader;
     //! Async. reader to receive vehicle observation data from the IPS and store them for later access in the LCC
@@ -112,6 +117,20 @@ class TimeSeriesAggregator
     //! Max. allowed data age before data is totally ignored or reset if possible - currently at 3 seconds
     const uint64_t max_allowed_age = 3e9;
 
+    //! ID of this aggregator in MemoryBudget, where the time series of all vehicles are registered as one component
+    uint64_t memory_budget_id;
+
+    /**
+     * \brief Memory footprint of all time series, for MemoryBudget
+     */
+    size_t get_memory_footprint();
+
+    /**
+     * \brief Downsample the older samples of all time series, s.t. their total footprint is at most max_bytes, for MemoryBudget
+     * \param max_bytes Desired maximum total footprint in bytes
+     */
+    void downsample_oldest(size_t max_bytes);
+
 public:
     /**
      * \brief Constructor
@@ -119,11 +138,21 @@ public:
      */
     TimeSeriesAggregator(uint8_t max_vehicle_id);
 
+    /**
+     * \brief Destructor, unregisters the aggregator from MemoryBudget
+     */
+    ~TimeSeriesAggregator();
+
     /**
      * \brief Get current received vehicle data
      */
     VehicleData get_vehicle_data();
 
+    /**
+     * \brief Get the tracker of currently online and real vehicles, to subscribe to changes instead of scanning the vehicle data
+     */
+    shared_ptr<VehiclePresenceTracker> get_presence_tracker();
+
     /**
      * \brief Get newest received vehicle trajectories that are already valid (using MultiVehicleReader)
      */
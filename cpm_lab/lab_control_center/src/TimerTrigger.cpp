@@ -18,6 +18,14 @@ TimerTrigger::TimerTrigger(bool simulated_time) :
 
     timer_running.store(true);
 
+    //Participants are only stored once, but e.g. restarted programs with changing IDs accumulate over time
+    memory_budget_id = MemoryBudget::Instance().register_component(
+        "timer_trigger",
+        1024 * 1024,
+        [this](){ return get_memory_footprint(); },
+        [this](size_t max_bytes){ evict_oldest(max_bytes); }
+    );
+
     //Create timer thread that handles receiving + sending timing messages in a more ordered fashion
     next_signal_thread = std::thread([&] () {
         //Get initial messages so that the UI displays all participants that have sent an initial ready message
@@ -60,7 +68,7 @@ TimerTrigger::TimerTrigger(bool simulated_time) :
                         }
                     }
 
-                    cpm::Logging::Instance().write(2, "Simulated time - Participants that need to answer or are out of sync: %s", id_stream.str().c_str());
+                    CPM_LOG(2, "Simulated time - Participants that need to answer or are out of sync: %s", id_stream.str().c_str());
                 }
             }   
         }  
@@ -68,15 +76,66 @@ TimerTrigger::TimerTrigger(bool simulated_time) :
 }
 
 TimerTrigger::~TimerTrigger() {
+    MemoryBudget::Instance().unregister_component(memory_budget_id);
+
     timer_running.store(false);
     if(next_signal_thread.joinable()) {
         next_signal_thread.join();
     }
 }
 
+/**
+ * \brief Estimated memory footprint of an entry of ready_status_storage
+ * \param id ID of the participant
+ * \ingroup lcc
+ */
+static size_t get_entry_footprint(const std::string& id)
+{
+    return sizeof(std::string) + id.size() + sizeof(TimerData) + MemoryBudget::MAP_NODE_OVERHEAD;
+}
+
+size_t TimerTrigger::get_memory_footprint() {
+    std::lock_guard<std::mutex> lock(ready_status_storage_mutex);
+
+    size_t footprint = 0;
+    for (auto& entry : ready_status_storage)
+    {
+        footprint += get_entry_footprint(entry.first);
+    }
+    return footprint;
+}
+
+void TimerTrigger::evict_oldest(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(ready_status_storage_mutex);
+
+    //Order by the time of the last message
+    std::vector<std::pair<uint64_t, std::string>> receive_stamp_and_id;
+    size_t footprint = 0;
+    for (auto& entry : ready_status_storage)
+    {
+        footprint += get_entry_footprint(entry.first);
+
+        bool simulation_participant = use_simulated_time 
+            && (entry.second.participant_status == WORKING || entry.second.participant_status == WAITING);
+        if (!simulation_participant)
+        {
+            receive_stamp_and_id.push_back(std::make_pair(entry.second.last_message_receive_stamp, entry.first));
+        }
+    }
+    std::sort(receive_stamp_and_id.begin(), receive_stamp_and_id.end());
+
+    for (auto& entry : receive_stamp_and_id)
+    {
+        if (footprint <= max_bytes) break;
+
+        footprint -= get_entry_footprint(entry.second);
+        ready_status_storage.erase(entry.second);
+    }
+}
+
 void TimerTrigger::stop_request_callback(std::vector<StopRequest>& samples){
     for(auto sample:samples) {
-        cpm::Logging::Instance().write(1,
+        CPM_LOG(1,
                 "Vehicle %d sent StopRequest",
                 sample.vehicle_id()
             );
@@ -116,7 +175,7 @@ bool TimerTrigger::obtain_new_ready_signals() {
                 } //If an old message is received and the entry in the storage is old as well, the participant is out of sync
                 else if (next_start_request < current_simulated_time && use_simulated_time) {
                     current_participant_status = OUT_OF_SYNC;
-                    cpm::Logging::Instance().write(1, "Participant with id '%s' is out of sync", id.c_str());
+                    CPM_LOG(1, "Participant with id '%s' is out of sync", id.c_str());
                 }
                 else if (next_start_request > current_simulated_time && use_simulated_time) {
                     current_participant_status = WAITING;
@@ -133,7 +192,7 @@ bool TimerTrigger::obtain_new_ready_signals() {
                 ready_status_storage[id] = data;
             }
             else {
-                cpm::Logging::Instance().write(
+                CPM_LOG(
                     1,
                     "LCC Timer: Received old timestamp from participant with ID %s", 
                     id.c_str()
@@ -181,14 +240,14 @@ bool TimerTrigger::check_signals_and_send_next_signal() {
         std::lock_guard<std::mutex> lock(simulated_time_mutex);
         //React according to current data
         if (!has_data) {
-            cpm::Logging::Instance().write(
+            CPM_LOG(
                 1,
                 "%s", 
                 "LCC Timer: No data or only invalid data received!"
             );
         }
         else if (next_simulated_time < current_simulated_time) {
-            cpm::Logging::Instance().write(
+            CPM_LOG(
                 1,
                 "%s", 
                 "LCC Timer: At least one participant is out of sync (or its answer was not received)!"
@@ -224,7 +283,7 @@ void TimerTrigger::send_stop_signal() {
     trigger.next_start(TimeStamp(cpm::TRIGGER_STOP_SYMBOL));
     system_trigger_writer.write(trigger);
 
-    cpm::Logging::Instance().write(
+    CPM_LOG(
         1,
         "%s", 
         "LCC: Sent stop signal"
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defaults.hpp"
+#include <algorithm>
 #include <cassert>
 #include <ctime>
 #include <map>
@@ -24,6 +25,8 @@
 #include "SystemTrigger.hpp"
 #include "StopRequest.hpp"
 
+#include "MemoryBudget.hpp"
+
 /**
  * \enum ParticipantStatus
  * \brief Possible status of a participant
@@ -78,13 +81,14 @@ private:
     bool obtain_new_stop_request_signals();
 
     /**
-     * \brief TODO
-     * \param samples
+     * \brief Stops the timers in the network when an HLC sends a StopRequest. The vehicle itself is stopped by VehicleAutomatedControl,
+     * which receives the StopRequest as well.
+     * \param samples Received StopRequests
      */
     void stop_request_callback(std::vector<StopRequest>& samples);
     //! DDS Reader to obtain ReadyStatus messages sent within the network
     dds::sub::DataReader<ReadyStatus> ready_status_reader;
-    //! TODO
+    //! DDS Reader to receive StopRequests of the HLCs
     cpm::AsyncReader<StopRequest> stop_request_reader;
     //! DDS Writer to send SystemTrigger messages, with which timers in the network can be started / controlled (simulated time) / stopped
     cpm::Writer<SystemTrigger> system_trigger_writer;
@@ -108,6 +112,21 @@ private:
      */
     bool check_signals_and_send_next_signal();
 
+    //! ID of the timer trigger in MemoryBudget
+    uint64_t memory_budget_id;
+
+    /**
+     * \brief Get the estimated memory footprint of ready_status_storage, for MemoryBudget
+     */
+    size_t get_memory_footprint();
+
+    /**
+     * \brief Remove the participants that sent their last message least recently until the footprint is at most max_bytes, for MemoryBudget.
+     * With simulated time, participants that are working or waiting for a later time step are never removed, as the timer must wait for them.
+     * \param max_bytes Desired maximum footprint in bytes
+     */
+    void evict_oldest(size_t max_bytes);
+
 public:
     /**
      * \brief Constructor for the timer trigger, which also determines if it should be used as a real-time or simulated trigger
@@ -115,7 +134,7 @@ public:
      */
     TimerTrigger(bool simulated_time);
     /**
-     * \brief Deconstructor, destroys the timing thread
+     * \brief Deconstructor, destroys the timing thread and unregisters the timer trigger from MemoryBudget
      */
     ~TimerTrigger();
 
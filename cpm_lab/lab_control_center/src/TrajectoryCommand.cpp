@@ -15,7 +15,8 @@ TrajectoryCommand::TrajectoryCommand()
 : 
     writer_vehicleCommandTrajectory("vehicleCommandTrajectory")
 {
-    timer = std::make_shared<cpm::TimerFD>("LabControlCenter_TrajectoryCommand", dt_nanos, 0, false);
+    //The offset is allocated s.t. the LCC tasks do not all wake up at the same time
+    timer = cpm::Timer::create_staggered("LabControlCenter_TrajectoryCommand", dt_nanos, 1000000ull, cpm::PhaseAllocator::StageAny, false, false, false);
 
     timer->start_async([this](uint64_t t_now){
         send_trajectory(t_now);
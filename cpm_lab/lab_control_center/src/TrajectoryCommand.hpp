@@ -3,7 +3,7 @@
 #include "defaults.hpp"
 #include "Pose2D.hpp"
 #include "VehicleCommandTrajectory.hpp"
-#include "cpm/TimerFD.hpp"
+#include "cpm/Timer.hpp"
 #include "cpm/get_topic.hpp"
 #include "cpm/Writer.hpp"
 
@@ -25,7 +25,7 @@ class TrajectoryCommand
      * Does not respond to stop signals as it can be used independt of running simulations 
      * (as vehicle paths can always be drawn, also to align vehicles before a simulation).
      */
-    std::shared_ptr<cpm::TimerFD> timer;
+    std::shared_ptr<cpm::Timer> timer;
 
     //! Writer to send trajectories to the vehicles
     cpm::Writer<VehicleCommandTrajectory> writer_vehicleCommandTrajectory;
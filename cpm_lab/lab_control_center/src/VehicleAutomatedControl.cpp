@@ -8,6 +8,7 @@
 VehicleAutomatedControl::VehicleAutomatedControl() 
 :participant(cpm::ParticipantSingleton::Instance())
 ,topic_vehicleCommandSpeedCurvature(cpm::get_topic<VehicleCommandSpeedCurvature>("vehicleCommandSpeedCurvature"))
+,stop_tracker(0.05, 10000000000ull) //Standing still at up to 5cm/s, give up retransmitting after 10s
 {
     //Initialization of the data writer
     auto QoS = dds::pub::qos::DataWriterQos();
@@ -18,46 +19,86 @@ VehicleAutomatedControl::VehicleAutomatedControl()
     publisher.default_datawriter_qos(QoS);
 
     writer_vehicleCommandSpeedCurvature = make_shared<dds::pub::DataWriter<VehicleCommandSpeedCurvature>>(publisher, topic_vehicleCommandSpeedCurvature);
+
+    //The vehicles confirm their stop with their state
+    vehicle_state_reader = make_shared<cpm::AsyncReader<VehicleState>>(
+        [this](std::vector<VehicleState>& samples){
+            handle_vehicle_states(samples);
+        },
+        "vehicleState"
+    );
+
+    //HLCs can request a stop of their vehicle as well
+    stop_request_reader = make_shared<cpm::AsyncReader<StopRequest>>(
+        [this](std::vector<StopRequest>& samples){
+            for (auto& sample : samples)
+            {
+                stop_vehicle(sample.vehicle_id());
+            }
+        },
+        "stopRequest"
+    );
     
-    //Initialize the timer (task loop) - here, different tasks like stopping the vehicle are performed
-    task_loop = std::make_shared<cpm::TimerFD>("LCCAutomatedControl", 200000000ull, 0, false);
-    
-    //Suppress warning for unused parameter in timer (because we only want to show relevant warnings)
-    #pragma GCC diagnostic push
-    #pragma GCC diagnostic ignored "-Wunused-parameter"
+    //Initialize the timer (task loop) - here, the stop signals are retransmitted until the vehicles confirm the stop
+    //The offset is allocated s.t. the LCC tasks do not all wake up at the same time
+    task_loop = cpm::Timer::create_staggered("LCCAutomatedControl", 20000000ull, 1000000ull, cpm::PhaseAllocator::StageAny, false, false, false);
 
     task_loop->start_async([&](uint64_t t_now)
     {
-        std::lock_guard<std::mutex> lock(stop_list_mutex);
-        for (auto iter = vehicle_stop_list.begin(); iter != vehicle_stop_list.end();)
+        std::vector<uint8_t> timed_out;
+        for (auto id : stop_tracker.get_retransmissions(t_now, timed_out))
         {
-            //Create and send stop signal for the vehicle - TODO, here test value with speed > 0
-            VehicleCommandSpeedCurvature stop_command;
-            stop_command.vehicle_id(iter->first);
-            stop_command.speed(0);
-            stop_command.curvature(0);
-
-            cpm::stamp_message(stop_command, cpm::get_time_ns(), 100000000ull);
-
-            writer_vehicleCommandSpeedCurvature->write(stop_command);
+            send_stop_command(id, t_now);
+        }
 
-            //Delete the vehicle from the map if its message count is zero - then, enough messages should have been sent
-            if (iter->second == 0)
-            {
-                iter = vehicle_stop_list.erase(iter);
-            }
-            else 
-            {
-                iter->second = iter->second - 1;
-                ++iter;
-            }
+        for (auto id : timed_out)
+        {
+            CPM_LOG(1,
+                "Vehicle %d did not confirm its stop, the stop signal is no longer sent",
+                static_cast<int>(id)
+            );
         }
     },
     [](){
         //Empty lambda callback for stop signals -> Do nothing when a stop signal is received
     });
+}
 
-    #pragma GCC diagnostic pop
+VehicleAutomatedControl::~VehicleAutomatedControl()
+{
+    task_loop->stop();
+}
+
+void VehicleAutomatedControl::send_stop_command(uint8_t id, uint64_t t_now)
+{
+    VehicleCommandSpeedCurvature stop_command;
+    stop_command.vehicle_id(id);
+    stop_command.speed(0);
+    stop_command.curvature(0);
+
+    //Valid immediately, a stop should not be delayed
+    cpm::stamp_message(stop_command, t_now, 0);
+
+    writer_vehicleCommandSpeedCurvature->write(stop_command);
+}
+
+void VehicleAutomatedControl::handle_vehicle_states(std::vector<VehicleState>& samples)
+{
+    if (!stop_tracker.has_pending_stops()) return;
+
+    uint64_t t_now = cpm::get_time_ns();
+    for (auto& state : samples)
+    {
+        uint64_t latency = 0;
+        if (stop_tracker.handle_vehicle_state(state.vehicle_id(), state.speed(), state.header().create_stamp().nanoseconds(), t_now, latency))
+        {
+            CPM_LOG(3,
+                "Vehicle %d confirmed its stop after %llu ms",
+                static_cast<int>(state.vehicle_id()),
+                static_cast<unsigned long long>(latency / 1000000ull)
+            );
+        }
+    }
 }
 
 void VehicleAutomatedControl::stop_vehicles(std::vector<uint8_t> id_list)
@@ -72,6 +113,18 @@ void VehicleAutomatedControl::stop_vehicles(std::vector<uint8_t> id_list)
 
 void VehicleAutomatedControl::stop_vehicle(uint8_t id)
 {
-    std::lock_guard<std::mutex> lock(stop_list_mutex);
-    vehicle_stop_list[id] = 5; //How often the command should be sent
-}
\ No newline at end of file
+    //Send the first command right away instead of waiting for the next timer tick, the timer only retransmits it
+    uint64_t t_now = cpm::get_time_ns();
+    stop_tracker.request_stop(id, t_now);
+    send_stop_command(id, t_now);
+}
+
+std::map<uint8_t, VehicleStopTracker::PendingStop> VehicleAutomatedControl::get_pending_stops()
+{
+    return stop_tracker.get_pending_stops();
+}
+
+std::map<uint8_t, uint64_t> VehicleAutomatedControl::get_stop_latencies()
+{
+    return stop_tracker.get_stop_latencies();
+}
@@ -3,18 +3,24 @@
 #include "defaults.hpp"
 #include <dds/pub/ddspub.hpp>
 #include "VehicleCommandSpeedCurvature.hpp"
+#include "VehicleState.hpp"
+#include "StopRequest.hpp"
+#include "VehicleStopTracker.hpp"
+#include "cpm/AsyncReader.hpp"
+#include "cpm/Logging.hpp"
 #include "cpm/get_time_ns.hpp"
 #include "cpm/stamp_message.hpp"
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/get_topic.hpp"
-#include "cpm/TimerFD.hpp"
+#include "cpm/Timer.hpp"
 
 /**
  * \brief This class is used to send automated control structures to the vehicles. A prominent example would be a stop signal that is sent to 
  * all vehicles after a simulation was stopped, so that they try to freeze at their current position and do not 'drive on while slowing down'
  * 
- * 
- * TODO: UNUSED CLASS - this class can probably be deleted, as proper vehicle stopping is now part of the stop signal??
+ * A stop command (speed = 0) is sent immediately from the thread that requested the stop, and then retransmitted every 20ms
+ * until the VehicleState of the vehicle confirms that it stands still (or until a timeout), so that lost commands do not go unnoticed.
+ * The latency of each stop is measured and logged. StopRequest messages of the HLCs are handled the same way.
  * \ingroup lcc
  */
 class VehicleAutomatedControl
@@ -28,20 +34,39 @@ private:
     //! DDS Writer to send the stop signal (speed = 0) to the vehicles
     shared_ptr<dds::pub::DataWriter<VehicleCommandSpeedCurvature>> writer_vehicleCommandSpeedCurvature = nullptr;
 
-    //Vehicle commands need to be sent regularly to be interpreted correctly, so e.g. a stop signal should not be sent only once (TODO: Check that)
-    //! Loop to send the speed = 0 stop signal multiple times, s.t. it is definitely received and obeyed for some time period
-    std::shared_ptr<cpm::TimerFD> task_loop = nullptr;
-    //! Mutex to access currently stopped vehicles
-    std::mutex stop_list_mutex;
-    //! Currently stopped vehicles & how often the stop signal should still be sent; deleted if the counter in the second part reaches 0
-    std::map<uint32_t, uint32_t> vehicle_stop_list; //TODO: Unordered set / different approach
+    //! Vehicles that were told to stop and did not confirm it yet, and the measured stop latencies
+    VehicleStopTracker stop_tracker;
+    //! Loop to retransmit the stop signal to all vehicles that did not confirm their stop yet
+    std::shared_ptr<cpm::Timer> task_loop = nullptr;
+    //! Reader for the VehicleStates, which confirm the stops
+    std::shared_ptr<cpm::AsyncReader<VehicleState>> vehicle_state_reader;
+    //! Reader for StopRequests sent by the HLCs, which are handled like stop requests from the LCC
+    std::shared_ptr<cpm::AsyncReader<StopRequest>> stop_request_reader;
+
+    /**
+     * \brief Send a single stop command (speed = 0, valid immediately) to a vehicle
+     * \param id Vehicle id
+     * \param t_now Current time in ns
+     */
+    void send_stop_command(uint8_t id, uint64_t t_now);
+
+    /**
+     * \brief Confirm the stops of vehicles whose states report standstill, and log the stop latency
+     * \param samples The newly received VehicleState samples
+     */
+    void handle_vehicle_states(std::vector<VehicleState>& samples);
 
 public:
     /**
-     * \brief Constructor, also initializes the task_loop for sending stop signals to the vehicles
+     * \brief Constructor, also initializes the task_loop for retransmitting stop signals to the vehicles
      */
     VehicleAutomatedControl();
 
+    /**
+     * \brief Destructor, stops the task_loop before the data it uses is destroyed
+     */
+    ~VehicleAutomatedControl();
+
     /**
      * \brief This function is used to send an immediate stop signal to all vehicles
      * \param id_list List of vehicle ids of the vehicles that should be stopped
@@ -49,8 +74,18 @@ public:
     void stop_vehicles(std::vector<uint8_t> id_list);
 
     /**
-     * \brief This function is used to send an immediate stop signal to a single vehicle
+     * \brief This function is used to send an immediate stop signal to a single vehicle, which is retransmitted until the vehicle confirms the stop
      * \param id Vehicle id
      */
     void stop_vehicle(uint8_t id);
+
+    /**
+     * \brief Get the vehicles that were told to stop, but did not confirm the stop yet
+     */
+    std::map<uint8_t, VehicleStopTracker::PendingStop> get_pending_stops();
+
+    /**
+     * \brief Get the latency (in ns) of the last confirmed stop of each vehicle, from the stop request to the first VehicleState that reported standstill
+     */
+    std::map<uint8_t, uint64_t> get_stop_latencies();
 };
\ No newline at end of file
@@ -60,7 +60,8 @@ void VehicleManualControl::start(uint8_t vehicleId, string joystick_device_file)
     vehicle_id = vehicleId;
     joystick = make_shared<Joystick>(joystick_device_file);
 
-    update_loop = std::make_shared<cpm::TimerFD>("lab_control_center", 20000000ull, 0, false);
+    //The offset is allocated s.t. the LCC tasks do not all wake up at the same time
+    update_loop = cpm::Timer::create_staggered("lab_control_center", 20000000ull, 1000000ull, cpm::PhaseAllocator::StageAny, false, false, false);
 
     update_loop->start_async([&](uint64_t t_now){
 
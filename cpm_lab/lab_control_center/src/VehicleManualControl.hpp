@@ -1,7 +1,7 @@
 #pragma once
 #include "defaults.hpp"
 #include <dds/pub/ddspub.hpp>
-#include "cpm/TimerFD.hpp"
+#include "cpm/Timer.hpp"
 #include "Joystick.hpp"
 #include "VehicleCommandDirect.hpp"
 #include "VehicleCommandSpeedCurvature.hpp"
@@ -19,7 +19,7 @@ class VehicleManualControl
     //! TODO
     shared_ptr<Joystick> joystick = nullptr;
     //! TODO
-    std::shared_ptr<cpm::TimerFD> update_loop = nullptr;
+    std::shared_ptr<cpm::Timer> update_loop = nullptr;
     //! TODO
     uint8_t vehicle_id = 0;
     
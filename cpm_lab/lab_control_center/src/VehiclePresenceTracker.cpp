@@ -0,0 +1,197 @@
+#include "VehiclePresenceTracker.hpp"
+#include "cpm/get_time_ns.hpp"
+
+#include <chrono>
+
+/**
+ * \file VehiclePresenceTracker.cpp
+ * \ingroup lcc
+ */
+
+VehiclePresenceTracker::VehiclePresenceTracker(uint64_t _offline_timeout_ns, uint64_t _real_timeout_ns)
+:offline_timeout_ns(_offline_timeout_ns)
+,real_timeout_ns(_real_timeout_ns)
+{
+
+}
+
+VehiclePresenceTracker::~VehiclePresenceTracker()
+{
+    stop();
+}
+
+void VehiclePresenceTracker::update(uint8_t vehicle_id, bool is_real, uint64_t t_now)
+{
+    std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+    std::vector<std::pair<VehiclePresence, PresenceChange>> changes;
+
+    {
+        std::lock_guard<std::mutex> lock(presence_mutex);
+        auto& vehicle = presence[vehicle_id];
+        vehicle.vehicle_id = vehicle_id;
+
+        //Message rate: Exponential moving average of the time between two messages, restarted when the vehicle comes back online
+        if (vehicle.online && t_now > vehicle.last_seen)
+        {
+            double interval = static_cast<double>(t_now - vehicle.last_seen);
+            auto smoothed = smoothed_interval_ns.find(vehicle_id);
+            if (smoothed == smoothed_interval_ns.end())
+            {
+                smoothed = smoothed_interval_ns.emplace(vehicle_id, interval).first;
+            }
+            else
+            {
+                smoothed->second = 0.9 * smoothed->second + 0.1 * interval;
+            }
+            vehicle.message_rate_hz = 1e9 / smoothed->second;
+        }
+        vehicle.last_seen = t_now;
+
+        if (!vehicle.online)
+        {
+            vehicle.online = true;
+            changes.push_back(std::make_pair(vehicle, PresenceChange::ONLINE));
+        }
+
+        if (is_real)
+        {
+            vehicle.last_seen_real = t_now;
+            if (!vehicle.is_real)
+            {
+                vehicle.is_real = true;
+                changes.push_back(std::make_pair(vehicle, PresenceChange::REAL));
+            }
+        }
+    }
+
+    if (!changes.empty()) dispatch(changes);
+}
+
+void VehiclePresenceTracker::check_timeouts(uint64_t t_now)
+{
+    std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+    std::vector<std::pair<VehiclePresence, PresenceChange>> changes;
+
+    {
+        std::lock_guard<std::mutex> lock(presence_mutex);
+        for (auto& entry : presence)
+        {
+            auto& vehicle = entry.second;
+
+            if (vehicle.is_real && t_now > vehicle.last_seen_real + real_timeout_ns)
+            {
+                vehicle.is_real = false;
+                changes.push_back(std::make_pair(vehicle, PresenceChange::SIMULATED));
+            }
+
+            if (vehicle.online && t_now > vehicle.last_seen + offline_timeout_ns)
+            {
+                vehicle.online = false;
+                vehicle.message_rate_hz = 0;
+                smoothed_interval_ns.erase(entry.first);
+                changes.push_back(std::make_pair(vehicle, PresenceChange::OFFLINE));
+            }
+        }
+    }
+
+    if (!changes.empty()) dispatch(changes);
+}
+
+void VehiclePresenceTracker::dispatch(const std::vector<std::pair<VehiclePresence, PresenceChange>>& changes)
+{
+    //Copy the subscribers, s.t. callbacks may subscribe further callbacks
+    std::vector<std::function<void(const VehiclePresence&, PresenceChange)>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(subscribers_mutex);
+        for (auto& subscriber : subscribers)
+        {
+            callbacks.push_back(subscriber.second);
+        }
+    }
+
+    for (auto& change : changes)
+    {
+        for (auto& callback : callbacks)
+        {
+            callback(change.first, change.second);
+        }
+    }
+}
+
+void VehiclePresenceTracker::start(uint64_t period_ms)
+{
+    stop();
+
+    std::lock_guard<std::mutex> lock(timeout_thread_mutex);
+    timeout_thread_running = true;
+    timeout_thread = std::thread([this, period_ms] () {
+        std::unique_lock<std::mutex> thread_lock(timeout_thread_mutex);
+        while (timeout_thread_running)
+        {
+            //Do not hold the lock while checking, or stop() would have to wait for it
+            thread_lock.unlock();
+            check_timeouts(cpm::get_time_ns());
+            thread_lock.lock();
+
+            timeout_thread_cv.wait_for(thread_lock, std::chrono::milliseconds(period_ms), [this] { return !timeout_thread_running; });
+        }
+    });
+}
+
+void VehiclePresenceTracker::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(timeout_thread_mutex);
+        timeout_thread_running = false;
+    }
+    timeout_thread_cv.notify_all();
+
+    if (timeout_thread.joinable())
+    {
+        timeout_thread.join();
+    }
+}
+
+uint64_t VehiclePresenceTracker::subscribe(std::function<void(const VehiclePresence&, PresenceChange)> callback)
+{
+    std::lock_guard<std::mutex> lock(subscribers_mutex);
+    uint64_t id = next_subscription_id++;
+    subscribers[id] = callback;
+    return id;
+}
+
+void VehiclePresenceTracker::unsubscribe(uint64_t id)
+{
+    //Wait for changes that are currently being sent, which might still use the callback
+    std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+    std::lock_guard<std::mutex> lock(subscribers_mutex);
+    subscribers.erase(id);
+}
+
+std::map<uint8_t, VehiclePresenceTracker::VehiclePresence> VehiclePresenceTracker::get_presence()
+{
+    std::lock_guard<std::mutex> lock(presence_mutex);
+    return presence;
+}
+
+std::vector<uint8_t> VehiclePresenceTracker::get_online_vehicle_ids()
+{
+    std::lock_guard<std::mutex> lock(presence_mutex);
+    std::vector<uint8_t> ids;
+    for (auto& entry : presence)
+    {
+        if (entry.second.online) ids.push_back(entry.first);
+    }
+    return ids;
+}
+
+std::vector<uint8_t> VehiclePresenceTracker::get_real_vehicle_ids()
+{
+    std::lock_guard<std::mutex> lock(presence_mutex);
+    std::vector<uint8_t> ids;
+    for (auto& entry : presence)
+    {
+        if (entry.second.online && entry.second.is_real) ids.push_back(entry.first);
+    }
+    return ids;
+}
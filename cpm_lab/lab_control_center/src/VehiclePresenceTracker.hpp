@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Keeps track of which vehicles are currently online and whether they are real or simulated.
+ * It is updated whenever a VehicleState is received (see TimeSeriesAggregator) and stores, per vehicle, when it was last seen,
+ * when a message of the real vehicle was last seen and an estimate of its message rate.
+ *
+ * Components that need to know which vehicles are present subscribe to presence changes (vehicle came online / went offline,
+ * became real / simulated) instead of regularly copying and scanning all vehicle data. Vehicles go offline / lose their real
+ * status if no (real) message was received within a timeout, which is checked regularly by a thread (see start).
+ *
+ * Important: The callbacks are called from the thread that received the data or from the timeout thread, one after another.
+ * They must return quickly and must not call update, check_timeouts or unsubscribe.
+ * \ingroup lcc
+ */
+class VehiclePresenceTracker {
+public:
+    /**
+     * \brief Presence of a single vehicle
+     */
+    struct VehiclePresence {
+        //! Vehicle ID
+        uint8_t vehicle_id = 0;
+        //! True if a message was received within the offline timeout
+        bool online = false;
+        //! True if a message of the real vehicle was received within the real timeout, else the vehicle is simulated
+        bool is_real = false;
+        //! Time of the last received message (in ns)
+        uint64_t last_seen = 0;
+        //! Time of the last received message of the real vehicle (in ns), 0 if none was received
+        uint64_t last_seen_real = 0;
+        //! Estimated message rate in Hz, 0 if not enough messages were received
+        double message_rate_hz = 0;
+    };
+
+    /**
+     * \brief Changes of a vehicle's presence, sent to the subscribers
+     */
+    enum class PresenceChange {
+        //! The vehicle sends messages (again)
+        ONLINE,
+        //! The vehicle did not send any message within the offline timeout
+        OFFLINE,
+        //! Messages of the real vehicle are received (again)
+        REAL,
+        //! No message of the real vehicle was received within the real timeout, but the vehicle may still be online (as simulated vehicle)
+        SIMULATED
+    };
+
+private:
+    //! A message of the vehicle must have been received within this time (in ns) for it to be online
+    const uint64_t offline_timeout_ns;
+    //! A message of the real vehicle must have been received within this time (in ns) for it to be real
+    const uint64_t real_timeout_ns;
+
+    //! Presence of all vehicles that were seen so far, by ID; Offline vehicles are kept s.t. their last_seen can still be queried
+    std::map<uint8_t, VehiclePresence> presence;
+    //! Smoothed time between two messages (in ns) per vehicle, for message_rate_hz
+    std::map<uint8_t, double> smoothed_interval_ns;
+    //! Mutex for the data above
+    std::mutex presence_mutex;
+
+    //! Subscribers, by their subscription ID
+    std::map<uint64_t, std::function<void(const VehiclePresence&, PresenceChange)>> subscribers;
+    //! ID for the next subscription
+    uint64_t next_subscription_id = 1;
+    //! Mutex for the subscribers
+    std::mutex subscribers_mutex;
+    //! Held while changes are determined and sent, s.t. the subscribers get the changes in the right order
+    std::mutex dispatch_mutex;
+
+    //! Thread that calls check_timeouts regularly
+    std::thread timeout_thread;
+    //! Stop condition for timeout_thread
+    bool timeout_thread_running = false;
+    //! Mutex for timeout_thread_running
+    std::mutex timeout_thread_mutex;
+    //! To wake up timeout_thread when it is stopped
+    std::condition_variable timeout_thread_cv;
+
+    /**
+     * \brief Send the changes to all subscribers, dispatch_mutex must be held
+     * \param changes The changes, with the presence of the vehicle after the change
+     */
+    void dispatch(const std::vector<std::pair<VehiclePresence, PresenceChange>>& changes);
+
+public:
+    /**
+     * \brief Constructor
+     * \param _offline_timeout_ns A message of the vehicle must have been received within this time (in ns) for it to be online
+     * \param _real_timeout_ns A message of the real vehicle must have been received within this time (in ns) for it to be real
+     */
+    VehiclePresenceTracker(uint64_t _offline_timeout_ns = 1000000000ull, uint64_t _real_timeout_ns = 500000000ull);
+
+    /**
+     * \brief Destructor, stops the timeout thread
+     */
+    ~VehiclePresenceTracker();
+
+    /**
+     * \brief Register a received message of a vehicle, sends ONLINE / REAL if the presence of the vehicle changed
+     * \param vehicle_id ID of the vehicle
+     * \param is_real If the message was sent by the real vehicle
+     * \param t_now Time of reception in ns
+     */
+    void update(uint8_t vehicle_id, bool is_real, uint64_t t_now);
+
+    /**
+     * \brief Check for vehicles that did not send (real) messages within the timeouts, sends OFFLINE / SIMULATED for them
+     * \param t_now Current time in ns
+     */
+    void check_timeouts(uint64_t t_now);
+
+    /**
+     * \brief Start a thread that calls check_timeouts regularly
+     * \param period_ms Time between two checks in milliseconds
+     */
+    void start(uint64_t period_ms);
+
+    /**
+     * \brief Stop the thread that calls check_timeouts
+     */
+    void stop();
+
+    /**
+     * \brief Subscribe to presence changes. The callback is not called for the current presence, use get_presence for that.
+     * \param callback Called with the new presence of the vehicle and the change
+     * \return ID of the subscription, required for unsubscribe
+     */
+    uint64_t subscribe(std::function<void(const VehiclePresence&, PresenceChange)> callback);
+
+    /**
+     * \brief Unsubscribe from presence changes. Blocks if changes are currently being sent, s.t. the callback is not called after this function returned.
+     * \param id ID returned by subscribe
+     */
+    void unsubscribe(uint64_t id);
+
+    /**
+     * \brief Get the presence of all vehicles that were seen so far, including offline vehicles
+     */
+    std::map<uint8_t, VehiclePresence> get_presence();
+
+    /**
+     * \brief Get the IDs of all vehicles that are currently online (real or simulated)
+     */
+    std::vector<uint8_t> get_online_vehicle_ids();
+
+    /**
+     * \brief Get the IDs of all real vehicles that are currently online
+     */
+    std::vector<uint8_t> get_real_vehicle_ids();
+};
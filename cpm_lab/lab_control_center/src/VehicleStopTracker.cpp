@@ -0,0 +1,81 @@
+#include "VehicleStopTracker.hpp"
+
+#include <cmath>
+
+/**
+ * \file VehicleStopTracker.cpp
+ * \ingroup lcc
+ */
+
+VehicleStopTracker::VehicleStopTracker(double _standstill_speed, uint64_t _timeout_ns)
+:standstill_speed(_standstill_speed)
+,timeout_ns(_timeout_ns)
+{
+
+}
+
+void VehicleStopTracker::request_stop(uint8_t id, uint64_t t_now)
+{
+    std::lock_guard<std::mutex> lock(tracker_mutex);
+    auto inserted = pending_stops.emplace(id, PendingStop());
+    if (inserted.second)
+    {
+        inserted.first->second.request_stamp = t_now;
+    }
+    inserted.first->second.send_count += 1;
+}
+
+std::vector<uint8_t> VehicleStopTracker::get_retransmissions(uint64_t t_now, std::vector<uint8_t>& timed_out)
+{
+    std::lock_guard<std::mutex> lock(tracker_mutex);
+    std::vector<uint8_t> retransmissions;
+    for (auto iter = pending_stops.begin(); iter != pending_stops.end();)
+    {
+        if (t_now >= iter->second.request_stamp + timeout_ns)
+        {
+            timed_out.push_back(iter->first);
+            iter = pending_stops.erase(iter);
+        }
+        else
+        {
+            retransmissions.push_back(iter->first);
+            iter->second.send_count += 1;
+            ++iter;
+        }
+    }
+    return retransmissions;
+}
+
+bool VehicleStopTracker::handle_vehicle_state(uint8_t id, double speed, uint64_t create_stamp, uint64_t t_now, uint64_t& latency_out)
+{
+    std::lock_guard<std::mutex> lock(tracker_mutex);
+    auto pending = pending_stops.find(id);
+    if (pending == pending_stops.end()) return false;
+
+    //States that were created before the request may still have been on their way, they do not show the reaction to the stop
+    if (create_stamp < pending->second.request_stamp) return false;
+    if (std::fabs(speed) > standstill_speed) return false;
+
+    latency_out = (t_now > pending->second.request_stamp) ? (t_now - pending->second.request_stamp) : 0;
+    stop_latencies[id] = latency_out;
+    pending_stops.erase(pending);
+    return true;
+}
+
+bool VehicleStopTracker::has_pending_stops()
+{
+    std::lock_guard<std::mutex> lock(tracker_mutex);
+    return !pending_stops.empty();
+}
+
+std::map<uint8_t, VehicleStopTracker::PendingStop> VehicleStopTracker::get_pending_stops()
+{
+    std::lock_guard<std::mutex> lock(tracker_mutex);
+    return pending_stops;
+}
+
+std::map<uint8_t, uint64_t> VehicleStopTracker::get_stop_latencies()
+{
+    std::lock_guard<std::mutex> lock(tracker_mutex);
+    return stop_latencies;
+}
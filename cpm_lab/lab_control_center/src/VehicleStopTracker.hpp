@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * \brief Keeps track of the vehicles that were told to stop, until their own VehicleState confirms that they are standing still.
+ * Used by VehicleAutomatedControl to decide which stop commands must still be retransmitted, and to measure the stop latency
+ * (time from the stop request to the first VehicleState that was created afterwards and reports a speed close to zero).
+ *
+ * This class does not communicate by itself, so it does not depend on DDS. All functions are thread-safe.
+ * \ingroup lcc
+ */
+class VehicleStopTracker
+{
+public:
+    /**
+     * \brief Stop status of a vehicle that has not yet confirmed its stop
+     */
+    struct PendingStop {
+        //! When the stop was requested first (the latency is measured from here)
+        uint64_t request_stamp = 0;
+        //! How often the stop command was sent to the vehicle so far
+        uint32_t send_count = 0;
+    };
+
+private:
+    //! Vehicles with a speed up to this value (in m/s) count as standing still
+    const double standstill_speed;
+    //! After this duration (in ns) without confirmation, the stop command is no longer retransmitted
+    const uint64_t timeout_ns;
+
+    //! Mutex for all data below
+    std::mutex tracker_mutex;
+    //! Vehicles that were told to stop, but did not confirm the stop yet
+    std::map<uint8_t, PendingStop> pending_stops;
+    //! Latency (in ns) of the last confirmed stop of each vehicle
+    std::map<uint8_t, uint64_t> stop_latencies;
+
+public:
+    /**
+     * \brief Constructor
+     * \param _standstill_speed Vehicles with a speed up to this value (in m/s) count as standing still
+     * \param _timeout_ns After this duration (in ns) without confirmation, the stop command is no longer retransmitted
+     */
+    VehicleStopTracker(double _standstill_speed, uint64_t _timeout_ns);
+
+    /**
+     * \brief Register that a stop command was sent to a vehicle on request. If the vehicle has not confirmed a previous stop yet,
+     * the time of the previous request is kept, so that the latency is measured from the first request.
+     * \param id Vehicle id
+     * \param t_now Current time in ns
+     */
+    void request_stop(uint8_t id, uint64_t t_now);
+
+    /**
+     * \brief Get the vehicles to which the stop command must be retransmitted, which is also registered as sent.
+     * Vehicles that did not confirm their stop within the timeout are removed instead.
+     * \param t_now Current time in ns
+     * \param timed_out Vehicles that were removed due to the timeout are appended here
+     * \return Vehicles to which the stop command must be sent now
+     */
+    std::vector<uint8_t> get_retransmissions(uint64_t t_now, std::vector<uint8_t>& timed_out);
+
+    /**
+     * \brief Check a new VehicleState. If the vehicle was told to stop before the state was created and reports standstill,
+     * its stop is confirmed: It is no longer retransmitted, and its latency is stored.
+     * \param id Vehicle id
+     * \param speed Speed of the vehicle in m/s
+     * \param create_stamp When the vehicle created the state, in ns
+     * \param t_now Current time in ns, i.e. when the state was received
+     * \param latency_out Set to the latency of the stop (in ns) if it was confirmed
+     * \return True if the stop was confirmed by this state, else false
+     */
+    bool handle_vehicle_state(uint8_t id, double speed, uint64_t create_stamp, uint64_t t_now, uint64_t& latency_out);
+
+    /**
+     * \brief Check if any vehicle has not confirmed its stop yet, to quickly skip new VehicleStates if nothing is being stopped
+     */
+    bool has_pending_stops();
+
+    /**
+     * \brief Get the vehicles that were told to stop, but did not confirm the stop yet
+     */
+    std::map<uint8_t, PendingStop> get_pending_stops();
+
+    /**
+     * \brief Get the latency (in ns) of the last confirmed stop of each vehicle
+     */
+    std::map<uint8_t, uint64_t> get_stop_latencies();
+};
@@ -13,6 +13,66 @@ VisualizationCommandsAggregator::VisualizationCommandsAggregator()
         }
         ,"visualization"
     );
+
+    //Messages with a long time to live and many points could otherwise accumulate, as messages only expire when the map view is drawn
+    memory_budget_id = MemoryBudget::Instance().register_component(
+        "visualization_commands",
+        16 * 1024 * 1024,
+        [this](){ return get_memory_footprint(); },
+        [this](size_t max_bytes){ evict_oldest(max_bytes); }
+    );
+}
+
+VisualizationCommandsAggregator::~VisualizationCommandsAggregator()
+{
+    MemoryBudget::Instance().unregister_component(memory_budget_id);
+}
+
+size_t VisualizationCommandsAggregator::get_entry_footprint(const Visualization& viz)
+{
+    return sizeof(Visualization) + MemoryBudget::MAP_NODE_OVERHEAD
+        + viz.points().size() * sizeof(Point2D)
+        + viz.string_message().size();
+}
+
+size_t VisualizationCommandsAggregator::get_memory_footprint()
+{
+    std::lock_guard<std::mutex> lock(received_viz_map_mutex);
+
+    size_t footprint = 0;
+    for (auto& entry : received_viz_map)
+    {
+        footprint += get_entry_footprint(entry.second);
+    }
+    return footprint;
+}
+
+void VisualizationCommandsAggregator::evict_oldest(size_t max_bytes)
+{
+    std::lock_guard<std::mutex> lock(received_viz_map_mutex);
+
+    //Order by the point in time when the messages become invalid (expired messages come first)
+    std::vector<std::pair<uint64_t, uint64_t>> expiry_and_id;
+    size_t footprint = 0;
+    for (auto& entry : received_viz_map)
+    {
+        expiry_and_id.push_back(std::make_pair(entry.second.time_to_live(), entry.first));
+        footprint += get_entry_footprint(entry.second);
+    }
+    std::sort(expiry_and_id.begin(), expiry_and_id.end());
+
+    uint64_t time_now = cpm::get_time_ns();
+    for (auto& entry : expiry_and_id)
+    {
+        if (footprint <= max_bytes && entry.first >= time_now)
+        {
+            break;
+        }
+
+        auto viz_entry = received_viz_map.find(entry.second);
+        footprint -= get_entry_footprint(viz_entry->second);
+        received_viz_map.erase(viz_entry);
+    }
 }
 
 void VisualizationCommandsAggregator::handle_new_viz_msgs(std::vector<Visualization>& samples) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defaults.hpp"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <map>
@@ -15,6 +16,8 @@
 #include "cpm/get_time_ns.hpp"
 #include "Visualization.hpp"
 
+#include "MemoryBudget.hpp"
+
 /**
  * \brief This class is used as storage to aggregate all visualization commands received by the LCC (which are drawn in MapViewUi)
  * \ingroup lcc
@@ -35,12 +38,39 @@ private:
     std::map<uint64_t, Visualization> received_viz_map;
     //! Mutex to thread-safely store and access visualization messages in received_viz_map
     std::mutex received_viz_map_mutex;
+
+    //! ID of this aggregator in MemoryBudget
+    uint64_t memory_budget_id;
+
+    /**
+     * \brief Estimated memory footprint of a stored visualization message
+     * \param viz The visualization message
+     */
+    static size_t get_entry_footprint(const Visualization& viz);
+
+    /**
+     * \brief Get the estimated memory footprint of all stored visualization messages, for MemoryBudget
+     */
+    size_t get_memory_footprint();
+
+    /**
+     * \brief Remove expired visualization messages, then the ones that expire first (usually the oldest), 
+     * until the footprint is at most max_bytes, for MemoryBudget
+     * \param max_bytes Desired maximum footprint in bytes
+     */
+    void evict_oldest(size_t max_bytes);
+
 public:
     /**
-     * \brief Constructor, sets up the async visualization message reader viz_reader
+     * \brief Constructor, sets up the async visualization message reader viz_reader and registers the aggregator in MemoryBudget
      */
     VisualizationCommandsAggregator();
 
+    /**
+     * \brief Destructor, unregisters the aggregator from MemoryBudget
+     */
+    ~VisualizationCommandsAggregator();
+
     /**
      * \brief Returns all viz messages that have been received
      */
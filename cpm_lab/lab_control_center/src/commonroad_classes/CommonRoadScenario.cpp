@@ -70,6 +70,7 @@ void CommonRoadScenario::clear_data()
     dynamic_obstacles.clear();
     environment_obstacles.clear();
     planning_problems.clear();
+    geometry_version += 1;
 
     if (reset_obstacle_sim_manager)
     {
@@ -605,6 +606,8 @@ void CommonRoadScenario::transform_coordinate_system_helper(double translate_x,
 {
     if (scale > 0 || angle > 0 || translate_x != 0.0 || translate_y != 0.0)
     {
+        geometry_version += 1;
+
         for (auto &lanelet_entry : lanelets)
         {
             lanelet_entry.second.transform_coordinate_system(scale, angle, translate_x, translate_y);
@@ -651,7 +654,7 @@ double CommonRoadScenario::get_scale(double min_lane_width)
 {
     if (min_lane_width < 0.0)
     {
-        cpm::Logging::Instance().write(1, "The lane width value %f of is not allowed (smaller than zero)", min_lane_width);
+        CPM_LOG(1, "The lane width value %f of is not allowed (smaller than zero)", min_lane_width);
         min_lane_width = 0.0;
     }
     
@@ -1199,6 +1202,56 @@ std::optional<Lanelet> CommonRoadScenario::get_lanelet(int id)
     return std::nullopt;
 }
 
+uint64_t CommonRoadScenario::get_geometry_version()
+{
+    return geometry_version.load();
+}
+
+bool CommonRoadScenario::get_pick_geometry(std::map<int, std::vector<std::vector<std::pair<double, double>>>>& lanelet_segments, std::map<int, std::vector<std::pair<double, double>>>& planning_problem_positions)
+{
+    //Called by the UI thread, so do not block (as in draw)
+    std::shared_lock<std::shared_mutex> load_lock(load_file_mutex, std::try_to_lock);
+    std::shared_lock<std::shared_mutex> read_lock(write_changes_mutex, std::try_to_lock);
+
+    if (!(load_lock.owns_lock() && read_lock.owns_lock()))
+    {
+        return false;
+    }
+
+    lanelet_segments.clear();
+    for (auto& lanelet_entry : lanelets)
+    {
+        lanelet_segments[lanelet_entry.first] = lanelet_entry.second.get_shape_segments();
+    }
+
+    planning_problem_positions.clear();
+    for (const auto& pb : planning_problems)
+    {
+        auto& positions = planning_problem_positions[pb.first];
+
+        std::optional<StateExact> initial_state = pb.second.get_initial_state();
+        if (initial_state.has_value())
+        {
+            std::optional<Position> initial_position = initial_state->get_position();
+            if (initial_position.has_value())
+            {
+                positions.push_back(initial_position->get_center());
+            }
+        }
+
+        for (const auto& goal_state : pb.second.get_goal_states())
+        {
+            std::optional<Position> goal_position = goal_state.get_position();
+            if (goal_position.has_value())
+            {
+                positions.push_back(goal_position->get_center());
+            }
+        }
+    }
+
+    return true;
+}
+
 std::pair<double, double> CommonRoadScenario::get_lanelet_center(int id)
 {
     //Mutex locking not necessary / possible here (called within draw from other objects)
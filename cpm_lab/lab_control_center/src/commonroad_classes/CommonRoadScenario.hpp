@@ -2,6 +2,7 @@
 
 #include <libxml++-2.6/libxml++/libxml++.h>
 
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <mutex>
@@ -200,6 +201,9 @@ private:
     //! Mutex to lock when writing changes, so that reading and writing are not performed simultaneously. Write changes are exclusive.
     std::shared_mutex write_changes_mutex;    
 
+    //! Incremented whenever the scenario geometry changes (load, transformation), s.t. e.g. the map view knows when to update derived data
+    std::atomic<uint64_t> geometry_version{0};
+
     //! Storage to load / store translation in YAML
     CommonRoadTransformation yaml_transformation_storage;
 
@@ -450,6 +454,20 @@ public:
      */
     std::optional<Lanelet> get_lanelet(int id);
 
+    /**
+     * \brief Get the current geometry version, which changes whenever a file is loaded or the scenario is transformed
+     */
+    uint64_t get_geometry_version();
+
+    /**
+     * \brief Get the shapes of all lanelets and the positions of all planning problems, e.g. for picking in the map view
+     * Uses try_lock like draw, so that the UI is not blocked while a file is being loaded
+     * \param lanelet_segments Lanelet ID -> Quads between consecutive bound points (see Lanelet::get_shape_segments)
+     * \param planning_problem_positions Planning problem ID -> Centers of the initial state position and all goal state positions
+     * \return False if the scenario is currently being changed, in which case the output parameters are not touched
+     */
+    bool get_pick_geometry(std::map<int, std::vector<std::vector<std::pair<double, double>>>>& lanelet_segments, std::map<int, std::vector<std::pair<double, double>>>& planning_problem_positions);
+
     ///////////////////////////////////////////////////////////////////////////////////////////
     ///////////////////                 DDS Functions               ///////////////////////////
     ///////////////////////////////////////////////////////////////////////////////////////////
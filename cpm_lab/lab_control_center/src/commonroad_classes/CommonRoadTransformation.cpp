@@ -89,7 +89,7 @@ void CommonRoadTransformation::load_transformation_from_profile(double& time_sca
         //Make sure that values exist
         if (! (profile[time_scale_key] && profile[scale_key] && profile[translate_x_key] && profile[translate_y_key] && profile[rotation_key]))
         {
-            cpm::Logging::Instance().write(1, "Commonroad profile not properly defined for %s in %s, setting default values...", current_file_name.c_str(), transformation_file_location.c_str());
+            CPM_LOG(1, "Commonroad profile not properly defined for %s in %s, setting default values...", current_file_name.c_str(), transformation_file_location.c_str());
             set_defaults_for_undefined(profile);
         }
     
@@ -152,7 +152,7 @@ void CommonRoadTransformation::add_change_to_transform_profile(double time_scale
             //Make sure that values exist
             if (! (profile[time_scale_key] && profile[scale_key] && profile[translate_x_key] && profile[translate_y_key] && profile[rotation_key]))
             {
-                cpm::Logging::Instance().write(1, "Commonroad profile not properly defined for %s in %s, setting default values...", current_file_name.c_str(), transformation_file_location.c_str());
+                CPM_LOG(1, "Commonroad profile not properly defined for %s in %s, setting default values...", current_file_name.c_str(), transformation_file_location.c_str());
                 set_defaults_for_undefined(profile);
             }
 
@@ -995,6 +995,55 @@ std::vector<Point> Lanelet::get_shape()
     return shape;
 }
 
+std::vector<std::pair<double, double>> Lanelet::get_center_line()
+{
+    std::vector<std::pair<double, double>> center_line;
+    size_t point_count = std::min(left_bound.points.size(), right_bound.points.size());
+
+    for (size_t i = 0; i < point_count; ++i)
+    {
+        center_line.push_back(std::pair<double, double>(
+            left_bound.points.at(i).get_x() * 0.5 + right_bound.points.at(i).get_x() * 0.5,
+            left_bound.points.at(i).get_y() * 0.5 + right_bound.points.at(i).get_y() * 0.5
+        ));
+    }
+
+    return center_line;
+}
+
+std::vector<std::vector<std::pair<double, double>>> Lanelet::get_shape_segments()
+{
+    std::vector<std::vector<std::pair<double, double>>> segments;
+    size_t point_count = std::min(left_bound.points.size(), right_bound.points.size());
+
+    for (size_t i = 0; i + 1 < point_count; ++i)
+    {
+        segments.push_back({
+            {left_bound.points.at(i).get_x(), left_bound.points.at(i).get_y()},
+            {left_bound.points.at(i + 1).get_x(), left_bound.points.at(i + 1).get_y()},
+            {right_bound.points.at(i + 1).get_x(), right_bound.points.at(i + 1).get_y()},
+            {right_bound.points.at(i).get_x(), right_bound.points.at(i).get_y()}
+        });
+    }
+
+    return segments;
+}
+
+std::vector<int> Lanelet::get_successors()
+{
+    return successors;
+}
+
+std::optional<Adjacent> Lanelet::get_adjacent_left()
+{
+    return adjacent_left;
+}
+
+std::optional<Adjacent> Lanelet::get_adjacent_right()
+{
+    return adjacent_right;
+}
+
 std::string Lanelet::get_speed_limit()
 {
     std::stringstream speed_limit_stream;
@@ -322,6 +322,33 @@ public:
      */
     std::vector<Point> get_shape();
 
+    /**
+     * \brief Get the center line of the lanelet (middle of each pair of bound points)
+     * \return Center line points, in driving direction
+     */
+    std::vector<std::pair<double, double>> get_center_line();
+
+    /**
+     * \brief Get the lanelet shape split into quads between consecutive pairs of bound points, e.g. for picking in the map view
+     * \return Quads (left i, left i+1, right i+1, right i), in driving direction
+     */
+    std::vector<std::vector<std::pair<double, double>>> get_shape_segments();
+
+    /**
+     * \brief Get the IDs of the successors of the lanelet
+     */
+    std::vector<int> get_successors();
+
+    /**
+     * \brief Get the adjacent lanelet on the left, if one exists
+     */
+    std::optional<Adjacent> get_adjacent_left();
+
+    /**
+     * \brief Get the adjacent lanelet on the right, if one exists
+     */
+    std::optional<Adjacent> get_adjacent_right();
+
     //For table entries
     /**
      * \brief Get the lanelet speed limit or an empty string
@@ -28,6 +28,11 @@
 #include "cpm/Logging.hpp"
 #include "cpm/CommandLineReader.hpp"
 #include "TimerTrigger.hpp"
+#include "LCCErrorLogger.hpp"
+#include "MemoryBudget.hpp"
+#include "LCCStateService.hpp"
+#include "LCCStateClient.hpp"
+#include "ui/attached/AttachedWindowUi.hpp"
 #include "cpm/init.hpp"
 
 #include "commonroad_classes/CommonRoadScenario.hpp"
@@ -39,7 +44,9 @@
 
 #include <gtkmm/builder.h>
 #include <gtkmm.h>
+#include <algorithm>
 #include <functional>
+#include <future>
 #include <sstream>
 
 //For exit handlers
@@ -104,6 +111,57 @@ void interrupt_handler(int s) {
 
 #pragma GCC diagnostic pop
 
+/**
+ * \brief Run only a UI that attaches to a headless LCC on the same machine (--attach), see LCCStateClient.
+ * This UI is limited to the map view, the timer controls, the connected HLCs and the newest log (see AttachedWindowUi);
+ * the other tabs of the LCC (e.g. setup and deployment, parameters, monitoring) need the LCC with its built-in UI.
+ * No programs are deployed or killed, s.t. the UI can be closed and restarted without affecting the headless LCC.
+ * \param argc Command line argument count
+ * \param argv Command line arguments
+ * \return Return code of the Gtk::Application
+ * \ingroup lcc
+ */
+int run_attached_ui(int argc, char *argv[])
+{
+    cpm::init(argc, argv);
+    cpm::Logging::Instance().set_id("lab_control_center_ui");
+
+    unsigned int cmd_domain_id = cpm::cmd_parameter_int("dds_domain", 0, argc, argv);
+    std::string socket_path = cpm::cmd_parameter_string("state_socket", LCCStateService::default_socket_path(cmd_domain_id), argc, argv);
+
+    auto commonroad_scenario = std::make_shared<CommonRoadScenario>();
+    try
+    {
+        commonroad_scenario->load_file("./ui/map_view/LabMapCommonRoad.xml");
+    }
+    catch(const std::exception& e)
+    {
+        CPM_LOG(1, "Could not load initial commonroad scenario, error is: %s", e.what());
+    }
+
+    Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+    Glib::RefPtr<Gtk::CssProvider> cssProvider = Gtk::CssProvider::create();
+    cssProvider->load_from_path("ui/style.css");
+    Gtk::StyleContext::create()->add_provider_for_screen (Gdk::Display::get_default()->get_default_screen(),cssProvider,500);
+
+    auto client = std::make_shared<LCCStateClient>(socket_path);
+    auto trajectoryCommand = std::make_shared<TrajectoryCommand>();
+    auto mapViewUi = std::make_shared<MapViewUi>(
+        trajectoryCommand,
+        commonroad_scenario,
+        [&](){return client->get_vehicle_data();},
+        [](){return VehicleTrajectories();},
+        [](){return VehiclePathTracking();},
+        [](){return std::vector<CommonroadObstacle>();},
+        [](){return std::vector<Visualization>();}
+    );
+    bool map_profiler = cpm::cmd_parameter_bool("map_profiler", false, argc, argv);
+    mapViewUi->set_profiler(map_profiler, cpm::cmd_parameter_string("map_profile_file", "map_view_profile.csv", argc, argv), map_profiler);
+    auto attachedWindowUi = std::make_shared<AttachedWindowUi>(client, mapViewUi);
+
+    return app->run(attachedWindowUi->get_window());
+}
+
 
 /**
  * \brief Main function of the LCC.
@@ -115,6 +173,14 @@ void interrupt_handler(int s) {
  * --simulated_time
  * --number_of_vehicles (default 20, set how many vehicles can max. be selected in the UI)
  * --config_file (default parameters.yaml)
+ * --reactive_obstacles (default false, moving obstacles follow the lanelets and react to other vehicles instead of following their trajectories)
+ * --obstacle_prediction_horizon_ms (default 3000, in ms, how far ahead the predicted states of simulated moving obstacles are published to the HLCs)
+ * --headless (default false, run the LCC without UI, a map view with timer controls can attach to it with --attach, see LCCStateService)
+ * --attach (default false, only run the map view with timer controls of a headless LCC; setup, parameters, logs and monitoring are not available)
+ * --state_socket (default $XDG_RUNTIME_DIR/cpm_lcc_state_<dds_domain>.sock or /tmp/cpm_lcc_<uid>/cpm_lcc_state_<dds_domain>.sock, socket used by --headless and --attach)
+ * --state_update_period_ms (default 100, period of the updates sent to attached UIs)
+ * --map_profiler (default false, show the profiler overlay in the map view (toggle with F2) and write its statistics to --map_profile_file on exit)
+ * --map_profile_file (default map_view_profile.csv, file that the map view profiler statistics are written to, also with F3)
  * \ingroup lcc
  */
 int main(int argc, char *argv[])
@@ -125,6 +191,13 @@ int main(int argc, char *argv[])
     auto return_code = 0;
 
     try {
+        //An attached UI must neither set up program execution nor kill the tmux sessions of the headless LCC
+        if (cpm::cmd_parameter_bool("attach", false, argc, argv))
+        {
+            return run_attached_ui(argc, argv);
+        }
+        bool headless = cpm::cmd_parameter_bool("headless", false, argc, argv);
+
         //Do this even before creating the process-spawning child
         //We need to get the path to the executable, and argv[0] is not
         //reliable enough for that (and sometimes also only returns a relative path)
@@ -210,25 +283,22 @@ int main(int argc, char *argv[])
         }
         catch(const std::exception& e)
         {
-            cpm::Logging::Instance().write(1, "Could not load initial commonroad scenario, error is: %s", e.what());
+            CPM_LOG(1, "Could not load initial commonroad scenario, error is: %s", e.what());
         }
 
         auto storage = make_shared<ParameterStorage>(config_file, 32);
         ParameterServer server(storage);
         storage->register_on_param_changed_callback(std::bind(&ParameterServer::resend_param_callback, &server, _1));
 
-        Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
-        Glib::RefPtr<Gtk::CssProvider> cssProvider = Gtk::CssProvider::create();
-        cssProvider->load_from_path("ui/style.css");
-        Gtk::StyleContext::create()->add_provider_for_screen (Gdk::Display::get_default()->get_default_screen(),cssProvider,500);
-
         bool use_simulated_time = cpm::cmd_parameter_bool("simulated_time", false, argc, argv);
 
-        auto obstacle_simulation_manager = std::make_shared<ObstacleSimulationManager>(commonroad_scenario, use_simulated_time);
+        int obstacle_prediction_horizon_ms = std::max(cpm::cmd_parameter_int("obstacle_prediction_horizon_ms", 3000, argc, argv), 0);
+
+        bool reactive_obstacles = cpm::cmd_parameter_bool("reactive_obstacles", false, argc, argv);
+
+        auto obstacle_simulation_manager = std::make_shared<ObstacleSimulationManager>(commonroad_scenario, use_simulated_time, static_cast<uint64_t>(obstacle_prediction_horizon_ms), reactive_obstacles);
 
         auto timerTrigger = make_shared<TimerTrigger>(use_simulated_time);
-        auto timerViewUi = make_shared<TimerViewUI>(timerTrigger);
-        auto loggerViewUi = make_shared<LoggerViewUI>(logStorage);
         auto vehicleManualControl = make_shared<VehicleManualControl>();
         auto vehicleAutomatedControl = make_shared<VehicleAutomatedControl>();
         auto trajectoryCommand = make_shared<TrajectoryCommand>();
@@ -236,9 +306,83 @@ int main(int argc, char *argv[])
         auto obstacleAggregator = make_shared<ObstacleAggregator>(commonroad_scenario); //Use scenario to register reset callback if scenario is reloaded
         auto hlcReadyAggregator = make_shared<HLCReadyAggregator>();
         auto visualizationCommandsAggregator = make_shared<VisualizationCommandsAggregator>();
+
+        //Reactive obstacles react to the real and simulated vehicles
+        obstacle_simulation_manager->set_vehicle_data_callback([=](){return timeSeriesAggregator->get_vehicle_data();});
+
+        //Limit the memory used by the data accumulated in the aggregators above (and in the error logger, which registers itself on first use),
+        //budgets can be set with --memory_budget_<name>_kb
+        LCCErrorLogger::Instance();
+        MemoryBudget::Instance().configure(argc, argv);
+        MemoryBudget::Instance().start(1000);
+
         unsigned int cmd_domain_id = cpm::cmd_parameter_int("dds_domain", 0, argc, argv);
         std::string cmd_dds_initial_peer = cpm::cmd_parameter_string("dds_initial_peer", "", argc, argv);
 
+        //Headless LCC: Run the services above without any UI (and thus without a display), until an attached UI requests the shutdown
+        if (headless)
+        {
+            std::string socket_path = cpm::cmd_parameter_string("state_socket", LCCStateService::default_socket_path(cmd_domain_id), argc, argv);
+            int state_update_period_ms = std::max(cpm::cmd_parameter_int("state_update_period_ms", 100, argc, argv), 1);
+
+            std::promise<void> shutdown_requested;
+            std::atomic_bool shutdown_flag{false};
+            auto stateService = make_shared<LCCStateService>(
+                socket_path,
+                static_cast<unsigned int>(state_update_period_ms),
+                [&](){return timeSeriesAggregator->get_vehicle_data();},
+                [&](){return hlcReadyAggregator->get_hlc_ids_uint8_t();},
+                [&](){
+                    //Without a LoggerViewUI, the service is the only consumer of the new logs
+                    std::vector<LCCStateLogEntry> entries;
+                    for (auto& log : logStorage->get_new_logs(3))
+                    {
+                        entries.push_back({log.id(), log.content(), log.stamp().nanoseconds(), static_cast<uint8_t>(log.log_level())});
+                    }
+                    return entries;
+                },
+                [&](){
+                    LCCStateTimer timer;
+                    timerTrigger->get_current_simulated_time(timer.simulated_time, timer.current_time);
+                    return timer;
+                },
+                [&](LCCStateCommand command){
+                    switch (command)
+                    {
+                        case CommandStartTimer:
+                            obstacle_simulation_manager->stop();
+                            obstacle_simulation_manager->start();
+                            timerTrigger->send_start_signal();
+                            break;
+                        case CommandStopTimer:
+                            timerTrigger->send_stop_signal();
+                            obstacle_simulation_manager->stop();
+                            trajectoryCommand->stop_all();
+                            break;
+                        case CommandShutdown:
+                            if (!shutdown_flag.exchange(true)) shutdown_requested.set_value();
+                            break;
+                    }
+                }
+            );
+
+            std::cout << "Headless LCC is running, attach a map view with timer controls with --attach (socket: " << socket_path << ")" << std::endl;
+            shutdown_requested.get_future().wait();
+            stateService.reset();
+
+            MemoryBudget::Instance().stop();
+            kill_cloud_discovery();
+            return return_code;
+        }
+
+        Glib::RefPtr<Gtk::Application> app = Gtk::Application::create();
+        Glib::RefPtr<Gtk::CssProvider> cssProvider = Gtk::CssProvider::create();
+        cssProvider->load_from_path("ui/style.css");
+        Gtk::StyleContext::create()->add_provider_for_screen (Gdk::Display::get_default()->get_default_screen(),cssProvider,500);
+
+        auto timerViewUi = make_shared<TimerViewUI>(timerTrigger);
+        auto loggerViewUi = make_shared<LoggerViewUI>(logStorage);
+
         auto goToPlanner = make_shared<GoToPlanner>(
             std::bind(&CommonRoadScenario::get_start_poses, commonroad_scenario),
             [=](){return timeSeriesAggregator->get_vehicle_data();},
@@ -263,8 +407,11 @@ int main(int argc, char *argv[])
             [&](){return timeSeriesAggregator->get_vehicle_trajectory_commands();},
             [&](){return timeSeriesAggregator->get_vehicle_path_tracking_commands();},
             [&](){return obstacleAggregator->get_obstacle_data();}, 
-            [&](){return visualizationCommandsAggregator->get_all_visualization_messages();}
+            [&](){return visualizationCommandsAggregator->get_all_visualization_messages();},
+            timeSeriesAggregator->get_presence_tracker()
         );
+        bool map_profiler = cpm::cmd_parameter_bool("map_profiler", false, argc, argv);
+        mapViewUi->set_profiler(map_profiler, cpm::cmd_parameter_string("map_profile_file", "map_view_profile.csv", argc, argv), map_profiler);
         auto rtt_aggregator = make_shared<RTTAggregator>();
         auto monitoringUi = make_shared<MonitoringUi>(
             deploy_functions, 
@@ -294,7 +441,7 @@ int main(int argc, char *argv[])
             vehicleAutomatedControl, 
             hlcReadyAggregator, 
             goToPlanner,
-            [&](){return timeSeriesAggregator->get_vehicle_data();},
+            timeSeriesAggregator->get_presence_tracker(),
             [&](bool simulated_time, bool reset_timer){return timerViewUi->reset(simulated_time, reset_timer);}, 
             [&](){return monitoringUi->reset_vehicle_view();},
             [&](){
@@ -383,6 +530,8 @@ int main(int argc, char *argv[])
 
         return_code = app->run(mainWindow->get_window());
 
+        MemoryBudget::Instance().stop();
+
         // Clean up on exit
         kill_cloud_discovery();
         //Kill remaining programs opened by setup view ui
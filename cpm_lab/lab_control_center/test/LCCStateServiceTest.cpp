@@ -0,0 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include "cpm/init.hpp"
+#include "LCCStateClient.hpp"
+#include "LCCStateService.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file LCCStateServiceTest.cpp
+ * \brief Test for the headless LCC service and a detached UI: A LCCStateService with synthetic data and a LCCStateClient
+ * run in this process. The test checks that the client mirrors the time series, timer state, HLC IDs and logs,
+ * that only changes are sent, that commands reach the service, and that the client reattaches after the service was restarted.
+ * It also checks that the socket (and a directory created for it) is only accessible by the user and the default socket path.
+ * Example: ./LCCStateServiceTest
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Wait until a condition is true
+ * \param condition The condition
+ * \param timeout_ms Maximum waiting time
+ * \return False if the condition did not become true in time
+ * \ingroup lcc
+ */
+static bool wait_for(std::function<bool()> condition, int timeout_ms = 3000)
+{
+    for (int waited = 0; waited < timeout_ms; waited += 10)
+    {
+        if (condition()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+int main(int argc, char *argv[]) {
+    cpm::init(argc, argv);
+
+    int failures = 0;
+    //The service creates the directory of the socket
+    std::string socket_directory = "/tmp/cpm_lcc_state_test_" + std::to_string(getpid());
+    std::string socket_path = socket_directory + "/state.sock";
+
+    //Synthetic data of a single vehicle
+    VehicleData vehicle_data;
+    vehicle_data[3]["pose_x"] = std::make_shared<TimeSeries>("Position X", "%6.2f", "m");
+    vehicle_data[3]["pose_x"]->push_sample(1000, 1.5);
+    std::vector<LCCStateLogEntry> pending_logs;
+    pending_logs.push_back({"test", "hello", 42, 1});
+    std::mutex logs_mutex;
+    std::atomic<int> start_commands{0};
+
+    auto create_service = [&] () {
+        return std::make_shared<LCCStateService>(
+            socket_path,
+            20,
+            [&](){ return vehicle_data; },
+            [](){ return std::vector<uint8_t>{3, 4}; },
+            [&](){
+                std::lock_guard<std::mutex> lock(logs_mutex);
+                auto logs = pending_logs;
+                pending_logs.clear();
+                return logs;
+            },
+            [](){ LCCStateTimer timer; timer.simulated_time = true; timer.current_time = 7; return timer; },
+            [&](LCCStateCommand command){ if (command == CommandStartTimer) ++start_commands; }
+        );
+    };
+
+    auto service = create_service();
+    LCCStateClient client(socket_path);
+
+    struct stat socket_stat;
+    check(stat(socket_path.c_str(), &socket_stat) == 0 && (socket_stat.st_mode & 0777) == 0600, "Socket only accessible by the user", failures);
+    check(stat(socket_directory.c_str(), &socket_stat) == 0 && (socket_stat.st_mode & 0777) == 0700, "Created socket directory only accessible by the user", failures);
+
+    check(wait_for([&](){ return client.is_connected(); }), "Client attaches", failures);
+    check(wait_for([&](){
+        auto data = client.get_vehicle_data();
+        return data.count(3) && data[3].count("pose_x") && data[3]["pose_x"]->has_data() && data[3]["pose_x"]->get_latest_value() == 1.5;
+    }), "Time series mirrored", failures);
+    check(client.get_vehicle_data()[3]["pose_x"]->get_unit() == "m", "Time series metadata mirrored", failures);
+    check(wait_for([&](){ return client.get_hlc_ids() == std::vector<uint8_t>{3, 4}; }), "HLC IDs mirrored", failures);
+    check(wait_for([&](){ return client.get_timer_state().simulated_time && client.get_timer_state().current_time == 7; }), "Timer state mirrored", failures);
+    check(wait_for([&](){ return client.get_logs().size() == 1 && client.get_logs().at(0).content == "hello"; }), "Logs mirrored", failures);
+
+    //Delta: Only the new sample is sent
+    vehicle_data[3]["pose_x"]->push_sample(2000, 2.5);
+    check(wait_for([&](){ return client.get_vehicle_data()[3]["pose_x"]->get_latest_value() == 2.5; }), "New sample mirrored", failures);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    check(client.get_vehicle_data()[3]["pose_x"]->get_last_n_values(10) == vehicle_data[3]["pose_x"]->get_last_n_values(10), "Unchanged samples are not sent again", failures);
+
+    check(client.send_command(CommandStartTimer), "Command sent", failures);
+    check(wait_for([&](){ return start_commands.load() == 1; }), "Command received by the service", failures);
+
+    //Restart of the service: The client reattaches and receives the state again
+    service.reset();
+    check(wait_for([&](){ return !client.is_connected(); }), "Client detects stopped service", failures);
+    service = create_service();
+    check(wait_for([&](){ return client.is_connected(); }), "Client reattaches", failures);
+    check(wait_for([&](){
+        auto data = client.get_vehicle_data();
+        return data.count(3) && data[3].count("pose_x") && data[3]["pose_x"]->has_data() && data[3]["pose_x"]->get_latest_value() == 2.5;
+    }), "State mirrored after reattaching", failures);
+
+    service.reset();
+    rmdir(socket_directory.c_str());
+
+    //Default path: In the runtime directory of the user, else in a directory of the user in /tmp
+    setenv("XDG_RUNTIME_DIR", "/run/user/1234", 1);
+    check(LCCStateService::default_socket_path(5) == "/run/user/1234/cpm_lcc_state_5.sock", "Default socket in XDG_RUNTIME_DIR", failures);
+    unsetenv("XDG_RUNTIME_DIR");
+    check(LCCStateService::default_socket_path(5) == "/tmp/cpm_lcc_" + std::to_string(geteuid()) + "/cpm_lcc_state_5.sock", "Default socket in a directory of the user", failures);
+
+    return check_summary(failures);
+}
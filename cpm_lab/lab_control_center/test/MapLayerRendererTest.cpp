@@ -0,0 +1,130 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "cpm/init.hpp"
+#include "cpm/Logging.hpp"
+#include "ui/map_view/MapLayerRenderer.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file MapLayerRendererTest.cpp
+ * \brief Test for MapLayerRenderer: Checks that layers are drawn in the background and painted with the requested view,
+ * that the last finished version of a layer is reused (and moved with the view) while a new version is drawn,
+ * that a slow layer does not block painting and that requests which were not drawn in time are counted as dropped.
+ * Example: ./MapLayerRendererTest
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Wait until a layer has finished the given number of versions
+ * \return False if this did not happen within 2 seconds
+ * \ingroup lcc
+ */
+static bool wait_for_frames(MapLayerRenderer& renderer, size_t layer, uint64_t frames)
+{
+    for (int i = 0; i < 200; ++i)
+    {
+        if (renderer.get_finished_frames(layer) >= frames) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+/**
+ * \brief Alpha value of a pixel of an ARGB32 surface
+ * \ingroup lcc
+ */
+static int alpha_at(const Cairo::RefPtr<Cairo::ImageSurface>& surface, int x, int y)
+{
+    surface->flush();
+    const unsigned char* row = surface->get_data() + y * surface->get_stride();
+    return static_cast<int>(reinterpret_cast<const uint32_t*>(row)[x] >> 24);
+}
+
+/**
+ * \brief Paint a layer on a new, transparent 100x100 surface
+ * \ingroup lcc
+ */
+static Cairo::RefPtr<Cairo::ImageSurface> paint_layer(MapLayerRenderer& renderer, size_t layer, const Cairo::Matrix& view, bool& painted)
+{
+    auto target = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, 100, 100);
+    auto ctx = Cairo::Context::create(target);
+    painted = renderer.paint(ctx, layer, view);
+    return target;
+}
+
+int main(int argc, char *argv[])
+{
+    //Errors in draw functions are logged
+    cpm::init(argc, argv);
+    cpm::Logging::Instance().set_id("map_layer_renderer_test");
+
+    int failures = 0;
+    bool painted = false;
+
+    MapLayerRenderer renderer(2);
+
+    //1 m in the world = 10 pixels
+    Cairo::Matrix view = Cairo::identity_matrix();
+    view.scale(10, 10);
+
+    paint_layer(renderer, 0, view, painted);
+    check(!painted, "Nothing is painted before a layer was finished", failures);
+
+    //Layer 0: Unit square at the origin
+    auto draw_square = [] (const Cairo::RefPtr<Cairo::Context>& ctx) {
+        ctx->set_source_rgb(1, 0, 0);
+        ctx->rectangle(0, 0, 1, 1);
+        ctx->fill();
+    };
+    renderer.request(0, view, 100, 100, draw_square);
+    check(wait_for_frames(renderer, 0, 1), "Requested layer is drawn in the background", failures);
+
+    auto target = paint_layer(renderer, 0, view, painted);
+    check(painted && alpha_at(target, 5, 5) == 255 && alpha_at(target, 15, 15) == 0, "Layer is painted with the requested view", failures);
+
+    //The view was moved by 2 m in x direction, but the layer was not drawn again yet
+    Cairo::Matrix moved_view = Cairo::identity_matrix();
+    moved_view.translate(20, 0);
+    moved_view.scale(10, 10);
+    target = paint_layer(renderer, 0, moved_view, painted);
+    check(painted && alpha_at(target, 25, 5) == 255 && alpha_at(target, 5, 5) == 0, "Last finished version is moved with the current view", failures);
+
+    //Layer 1 is slow, the other layer can still be painted and new requests replace the waiting one
+    auto draw_slow = [] (const Cairo::RefPtr<Cairo::Context>& ctx) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        ctx->set_source_rgb(0, 0, 1);
+        ctx->rectangle(5, 5, 1, 1);
+        ctx->fill();
+    };
+    renderer.request(1, view, 100, 100, draw_slow);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    renderer.request(1, view, 100, 100, draw_slow);
+    renderer.request(1, view, 100, 100, draw_slow);
+    renderer.request(1, view, 100, 100, draw_slow);
+
+    auto paint_start = std::chrono::steady_clock::now();
+    paint_layer(renderer, 0, view, painted);
+    auto paint_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - paint_start).count();
+    check(painted && paint_ms < 50, "Painting is not blocked by a slow layer", failures);
+    check(renderer.get_dropped_frames(1) == 2, "Replaced requests are counted as dropped", failures);
+    check(wait_for_frames(renderer, 1, 2) && renderer.get_finished_frames(1) == 2, "Only the newest request is drawn after a slow frame", failures);
+
+    //Errors while drawing do not stop the layer
+    renderer.request(0, view, 100, 100, [] (const Cairo::RefPtr<Cairo::Context>&) {
+        throw std::runtime_error("Test error");
+    });
+    check(wait_for_frames(renderer, 0, 2), "Layer is finished even if its draw function throws", failures);
+    renderer.request(0, view, 100, 100, draw_square);
+    check(wait_for_frames(renderer, 0, 3), "Layer is drawn again after an error", failures);
+
+    renderer.stop();
+    renderer.request(0, view, 100, 100, draw_square);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    check(renderer.get_finished_frames(0) == 3, "No requests are drawn after stop", failures);
+
+    return check_summary(failures);
+}
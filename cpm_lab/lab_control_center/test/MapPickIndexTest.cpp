@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ui/map_view/MapPickIndex.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file MapPickIndexTest.cpp
+ * \brief Test for MapPickIndex: Checks picking of circles, polygons and polylines, the order of the hits, incremental updates
+ * (set / remove / sync) and that a single pick stays below 1 ms for a map with many lanelet segments and vehicles.
+ * Example: ./MapPickIndexTest
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Create a circle shape
+ * \ingroup lcc
+ */
+static MapPickShape circle(double x, double y, double radius)
+{
+    MapPickShape shape;
+    shape.type = MapPickShape::Circle;
+    shape.points = {{x, y}};
+    shape.radius = radius;
+    return shape;
+}
+
+/**
+ * \brief Check if a key is among the hits
+ * \ingroup lcc
+ */
+static bool contains(const std::vector<MapPickHit>& hits, MapPickKind kind, int64_t id)
+{
+    return std::any_of(hits.begin(), hits.end(), [&](const MapPickHit& hit){ return hit.key == MapPickKey{kind, id}; });
+}
+
+int main()
+{
+    int failures = 0;
+
+    //Picking of the different shapes
+    {
+        MapPickIndex index;
+        index.set({MapPickKind::Vehicle, 1}, {circle(1.0, 1.0, 0.2)});
+
+        MapPickShape square;
+        square.type = MapPickShape::Polygon;
+        square.points = {{2.0, 0.0}, {3.0, 0.0}, {3.0, 1.0}, {2.0, 1.0}};
+        index.set({MapPickKind::Obstacle, 7}, {square});
+
+        MapPickShape line;
+        line.type = MapPickShape::Polyline;
+        line.radius = 0.05;
+        for (int i = 0; i <= 40; ++i)
+        {
+            line.points.push_back({0.1 * i, 3.0});
+        }
+        index.set({MapPickKind::Visualization, 3}, {line});
+
+        check(contains(index.pick(1.1, 1.0, 0.0), MapPickKind::Vehicle, 1), "Point within a circle is hit", failures);
+        check(index.pick(1.3, 1.0, 0.0).empty(), "Point outside of a circle is not hit", failures);
+        check(contains(index.pick(1.3, 1.0, 0.15), MapPickKind::Vehicle, 1), "Point near a circle is hit within the tolerance", failures);
+
+        auto square_hits = index.pick(2.5, 0.5, 0.0);
+        check(square_hits.size() == 1 && square_hits[0].key == MapPickKey{MapPickKind::Obstacle, 7} && std::fabs(square_hits[0].distance + 0.5) < 1e-9,
+            "Point within a polygon is hit with a negative distance", failures);
+        check(index.pick(3.2, 0.5, 0.1).empty(), "Point outside of a polygon is not hit", failures);
+
+        check(contains(index.pick(2.35, 3.04, 0.0), MapPickKind::Visualization, 3), "Point on a long polyline is hit", failures);
+        check(contains(index.pick(3.95, 3.0, 0.0), MapPickKind::Visualization, 3), "Point on the last piece of a long polyline is hit", failures);
+        check(index.pick(2.35, 3.2, 0.0).empty(), "Point next to a polyline is not hit", failures);
+        check(index.pick(4.2, 3.0, 0.0).empty(), "Point after the end of a polyline is not hit", failures);
+
+        auto line_hits = index.pick(2.0, 3.0, 0.0);
+        check(line_hits.size() == 1, "Pieces of a polyline are reported as a single object", failures);
+
+        //Order: By kind, then by distance
+        index.set({MapPickKind::Lanelet, 100}, {circle(1.0, 1.0, 1.0)});
+        index.set({MapPickKind::Vehicle, 2}, {circle(1.1, 1.0, 0.2)});
+        auto hits = index.pick(1.12, 1.0, 0.0);
+        check(hits.size() == 3
+            && hits[0].key == MapPickKey{MapPickKind::Vehicle, 2}
+            && hits[1].key == MapPickKey{MapPickKind::Vehicle, 1}
+            && hits[2].key == MapPickKey{MapPickKind::Lanelet, 100},
+            "Hits are ordered by kind and distance", failures);
+    }
+
+    //Incremental updates
+    {
+        MapPickIndex index;
+        index.set({MapPickKind::Vehicle, 1}, {circle(0.0, 0.0, 0.2)});
+        index.set({MapPickKind::Vehicle, 1}, {circle(5.0, 5.0, 0.2)});
+        check(index.pick(0.0, 0.0, 0.0).empty() && contains(index.pick(5.0, 5.0, 0.0), MapPickKind::Vehicle, 1), "Moved object is only hit at its new position", failures);
+
+        index.set({MapPickKind::Vehicle, 2}, {circle(6.0, 6.0, 0.2)});
+        index.set({MapPickKind::Obstacle, 1}, {circle(7.0, 7.0, 0.2)});
+        index.begin_sync(MapPickKind::Vehicle);
+        index.set({MapPickKind::Vehicle, 2}, {circle(6.0, 6.0, 0.2)});
+        index.end_sync(MapPickKind::Vehicle);
+        check(index.pick(5.0, 5.0, 0.0).empty(), "Object that was not set during a sync is removed", failures);
+        check(contains(index.pick(6.0, 6.0, 0.0), MapPickKind::Vehicle, 2), "Object that was set during a sync is kept", failures);
+        check(contains(index.pick(7.0, 7.0, 0.0), MapPickKind::Obstacle, 1), "Objects of other kinds are not affected by a sync", failures);
+
+        index.remove({MapPickKind::Obstacle, 1});
+        check(index.pick(7.0, 7.0, 0.0).empty() && index.size() == 1, "Removed object is not hit", failures);
+
+        //Shapes that cover many cells are tested with every pick
+        MapPickIndex small_grid(0.25, 8, 16);
+        small_grid.set({MapPickKind::Obstacle, 2}, {circle(0.0, 0.0, 10.0)});
+        check(contains(small_grid.pick(5.0, 5.0, 0.0), MapPickKind::Obstacle, 2), "Large shape is hit", failures);
+        small_grid.clear(MapPickKind::Obstacle);
+        check(small_grid.pick(5.0, 5.0, 0.0).empty() && small_grid.size() == 0, "Large shape is removed", failures);
+    }
+
+    //Pick time for a large map: 2000 lanelets with 10 segments each, 50 vehicles and 200 obstacles
+    {
+        MapPickIndex index;
+        for (int lanelet = 0; lanelet < 2000; ++lanelet)
+        {
+            std::vector<MapPickShape> segments;
+            double base_x = (lanelet % 50) * 2.0;
+            double base_y = (lanelet / 50) * 1.0;
+            for (int segment = 0; segment < 10; ++segment)
+            {
+                MapPickShape quad;
+                quad.type = MapPickShape::Polygon;
+                double x = base_x + segment * 0.2;
+                quad.points = {{x, base_y}, {x + 0.2, base_y}, {x + 0.2, base_y + 0.5}, {x, base_y + 0.5}};
+                segments.push_back(quad);
+            }
+            index.set({MapPickKind::Lanelet, lanelet}, segments);
+        }
+        for (int vehicle = 0; vehicle < 50; ++vehicle)
+        {
+            index.set({MapPickKind::Vehicle, vehicle}, {circle(vehicle * 2.0 + 0.3, 10.2, 0.2)});
+        }
+        for (int obstacle = 0; obstacle < 200; ++obstacle)
+        {
+            index.set({MapPickKind::Obstacle, obstacle}, {circle((obstacle % 50) * 2.0 + 1.0, (obstacle / 50) * 10.0 + 0.25, 0.3)});
+        }
+
+        double max_pick_ms = 0;
+        size_t total_hits = 0;
+        for (int i = 0; i < 10000; ++i)
+        {
+            double x = (i * 37 % 1000) * 0.1;
+            double y = (i * 53 % 400) * 0.1;
+
+            //Best of three, s.t. the thread being preempted by the OS does not count as a slow pick
+            double pick_ms = 1e9;
+            for (int repetition = 0; repetition < 3; ++repetition)
+            {
+                auto start = std::chrono::steady_clock::now();
+                size_t hits = index.pick(x, y, 0.05).size();
+                auto end = std::chrono::steady_clock::now();
+                pick_ms = std::min(pick_ms, std::chrono::duration<double, std::milli>(end - start).count());
+                if (repetition == 0) total_hits += hits;
+            }
+            max_pick_ms = std::max(max_pick_ms, pick_ms);
+        }
+        std::cout << "Max. pick time: " << max_pick_ms << " ms" << std::endl;
+        check(total_hits > 0, "Objects of the large map are hit", failures);
+        check(max_pick_ms < 1.0, "Each pick in the large map takes less than 1 ms", failures);
+    }
+
+    return check_summary(failures);
+}
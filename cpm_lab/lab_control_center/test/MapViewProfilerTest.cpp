@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ui/map_view/MapViewProfiler.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file MapViewProfilerTest.cpp
+ * \brief Test for MapViewProfiler: Checks the percentiles of the phases, that only the newest durations are used once the window is full,
+ * the frame rate and dropped frame counting, measurements from several threads and the written report.
+ * Example: ./MapViewProfilerTest
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Compare two values in ms
+ * \ingroup lcc
+ */
+static bool near(double a, double b)
+{
+    return std::fabs(a - b) < 1e-9;
+}
+
+int main()
+{
+    int failures = 0;
+    const uint64_t ms = 1000000ull;
+
+    //Percentiles of 1..100 ms
+    {
+        MapViewProfiler profiler({"fetch", "draw"}, 100);
+        for (uint64_t i = 100; i >= 1; --i)
+        {
+            profiler.record(0, i * ms);
+        }
+
+        auto statistics = profiler.get_phase_statistics();
+        check(statistics.size() == 2, "There are statistics for each phase", failures);
+        check(statistics.at(0).name == "fetch" && statistics.at(1).name == "draw", "Phases keep their names and order", failures);
+        check(statistics.at(0).count == 100, "All measurements are counted", failures);
+        check(near(statistics.at(0).p50_ms, 50) && near(statistics.at(0).p90_ms, 90) && near(statistics.at(0).p99_ms, 99) && near(statistics.at(0).max_ms, 100),
+            "Percentiles of 1..100 ms are 50, 90, 99 and 100 ms", failures);
+        check(statistics.at(1).count == 0 && near(statistics.at(1).max_ms, 0), "A phase without measurements has empty statistics", failures);
+
+        profiler.record(5, ms);
+        check(profiler.get_phase_statistics().size() == 2, "Measurements of unknown phases are ignored", failures);
+    }
+
+    //Only the newest durations are used once the window is full
+    {
+        MapViewProfiler profiler({"phase"}, 10);
+        for (int i = 0; i < 10; ++i) profiler.record(0, 100 * ms);
+        for (int i = 0; i < 10; ++i) profiler.record(0, 1 * ms);
+
+        auto statistics = profiler.get_phase_statistics().at(0);
+        check(statistics.count == 20, "The count includes measurements outside of the window", failures);
+        check(near(statistics.max_ms, 1), "Old measurements are dropped from the window", failures);
+    }
+
+    //Frame rate and dropped frames, with a frame period of 20 ms
+    {
+        MapViewProfiler profiler({"phase"}, 100, 20 * ms);
+        uint64_t t = 1000 * ms;
+        for (int i = 0; i < 10; ++i)
+        {
+            profiler.frame(t);
+            t += 20 * ms;
+        }
+        auto frames = profiler.get_frame_statistics();
+        check(frames.frames == 10, "All frames are counted", failures);
+        check(std::fabs(frames.frame_rate_hz - 50) < 1e-6, "Frame rate is 50 Hz for a frame every 20 ms", failures);
+        check(frames.dropped_frames == 0, "No frames are dropped for a frame every 20 ms", failures);
+
+        //Small jitter is no dropped frame
+        t += 8 * ms;
+        profiler.frame(t);
+        check(profiler.get_frame_statistics().dropped_frames == 0, "A frame 28 ms after the last one does not count as dropped", failures);
+
+        //80 ms: 3 frames were expected in between
+        t += 80 * ms;
+        profiler.frame(t);
+        frames = profiler.get_frame_statistics();
+        check(frames.dropped_frames == 3, "A gap of 80 ms counts as 3 dropped frames", failures);
+        check(near(frames.max_interval_ms, 80), "The max. interval between frames is 80 ms", failures);
+    }
+
+    //Scoped measurements from several threads
+    {
+        MapViewProfiler profiler({"sleep", "other"});
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.push_back(std::thread([&profiler] () {
+                for (int j = 0; j < 5; ++j)
+                {
+                    auto measurement = profiler.measure(0);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            }));
+        }
+        for (auto& thread : threads) thread.join();
+
+        auto statistics = profiler.get_phase_statistics().at(0);
+        check(statistics.count == 20, "Measurements of all threads are recorded", failures);
+        check(statistics.p50_ms >= 2.0, "Scoped measurements include the measured time", failures);
+    }
+
+    //Report
+    {
+        MapViewProfiler profiler({"fetch_vehicle_data", "composite"}, 100, 20 * ms);
+        profiler.record(0, 2 * ms);
+        profiler.record(1, 4 * ms);
+        profiler.frame(20 * ms);
+        profiler.frame(40 * ms);
+        profiler.set_counter("dropped_frames_map", 7);
+
+        std::stringstream report;
+        profiler.write_report(report);
+        std::string text = report.str();
+        check(text.find("phase,count,p50_ms,p90_ms,p99_ms,max_ms") != std::string::npos, "Report contains the phase header", failures);
+        check(text.find("fetch_vehicle_data,1,2.000,2.000,2.000,2.000") != std::string::npos, "Report contains the phase statistics", failures);
+        check(text.find("2,50.000,0,20.000") != std::string::npos, "Report contains the frame statistics", failures);
+        check(text.find("dropped_frames_map,7") != std::string::npos, "Report contains the counters", failures);
+
+        const std::string filename = "MapViewProfilerTest_report.csv";
+        check(profiler.write_report(filename), "Report can be written to a file", failures);
+        std::ifstream file(filename);
+        std::stringstream file_content;
+        file_content << file.rdbuf();
+        check(file_content.str() == text, "The file contains the report", failures);
+        std::remove(filename.c_str());
+
+        check(!profiler.write_report(std::string("/nonexistent_directory/report.csv")), "Writing to an invalid path fails", failures);
+    }
+
+    return check_summary(failures);
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "cpm/init.hpp"
+#include "cpm/CommandLineReader.hpp"
+#include "cpm/Logging.hpp"
+#include "cpm/Writer.hpp"
+#include "cpm/get_time_ns.hpp"
+#include "HLCHello.hpp"
+#include "VehicleState.hpp"
+#include "Visualization.hpp"
+#include "HLCReadyAggregator.hpp"
+#include "LCCErrorLogger.hpp"
+#include "MemoryBudget.hpp"
+#include "TimeSeriesAggregator.hpp"
+#include "VisualizationCommandsAggregator.hpp"
+
+/**
+ * \file MemoryBudgetSoakTest.cpp
+ * \brief Soak test for MemoryBudget: Creates the LCC aggregators in this process and feeds them with synthetic traffic
+ * (vehicle states, visualizations with a long time to live, HLC hellos with changing IDs, error messages that are all different),
+ * while the budgets are enforced as in the LCC.
+ *
+ * Every --report_period_s seconds, the footprint of each component and the resident set size (RSS) of the process are printed.
+ * The test fails if a component exceeds its budget after enforcement or if the RSS grows by more than --max_rss_growth_percent
+ * in the second half of the test (the first half is regarded as warm-up, where the aggregators fill up to their budgets).
+ * Budgets can be set like in the LCC with --memory_budget_<name>_kb; small budgets make the test reach a steady state faster.
+ *
+ * ctest runs a short version of this test with small budgets (see CMakeLists.txt), soak runs of several hours are started manually.
+ * Example: ./MemoryBudgetSoakTest --duration_s=7200 --vehicles=20 --rate_hz=50 --memory_budget_time_series_kb=8192
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Resident set size of this process in bytes
+ * \ingroup lcc
+ */
+static size_t get_rss_bytes()
+{
+    size_t pages_total = 0;
+    size_t pages_resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr) return 0;
+    if (fscanf(statm, "%zu %zu", &pages_total, &pages_resident) != 2) pages_resident = 0;
+    fclose(statm);
+    return pages_resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+int main(int argc, char *argv[]) {
+    cpm::init(argc, argv);
+    cpm::Logging::Instance().set_id("memory_budget_soak_test");
+
+    const double duration_s = cpm::cmd_parameter_double("duration_s", 600.0, argc, argv);
+    const double report_period_s = cpm::cmd_parameter_double("report_period_s", 10.0, argc, argv);
+    const int vehicles = std::max(1, std::min(cpm::cmd_parameter_int("vehicles", 20, argc, argv), 254));
+    const double rate_hz = std::max(1.0, cpm::cmd_parameter_double("rate_hz", 50.0, argc, argv));
+    const double max_rss_growth_percent = cpm::cmd_parameter_double("max_rss_growth_percent", 10.0, argc, argv);
+
+    //The aggregators of the LCC, which register themselves in MemoryBudget
+    auto timeSeriesAggregator = std::make_shared<TimeSeriesAggregator>(255);
+    auto hlcReadyAggregator = std::make_shared<HLCReadyAggregator>();
+    auto visualizationCommandsAggregator = std::make_shared<VisualizationCommandsAggregator>();
+    LCCErrorLogger::Instance();
+    MemoryBudget::Instance().configure(argc, argv);
+    MemoryBudget::Instance().start(1000);
+
+    cpm::Writer<VehicleState> vehicle_state_writer("vehicleState");
+    cpm::Writer<Visualization> visualization_writer("visualization", true);
+    cpm::Writer<HLCHello> hlc_hello_writer("hlc_hello", true);
+
+    std::atomic_bool running(true);
+    uint64_t message_count = 0;
+
+    //Synthetic traffic, sent at rate_hz
+    std::thread traffic_thread([&] () {
+        auto period = std::chrono::nanoseconds(static_cast<uint64_t>(1e9 / rate_hz));
+        auto next = std::chrono::steady_clock::now();
+        uint64_t step = 0;
+
+        while (running.load())
+        {
+            for (int vehicle_id = 1; vehicle_id <= vehicles; ++vehicle_id)
+            {
+                VehicleState state;
+                state.vehicle_id(static_cast<uint8_t>(vehicle_id));
+                state.header().create_stamp(TimeStamp(cpm::get_time_ns()));
+                state.pose().x(static_cast<double>(step % 1000) * 0.001);
+                state.pose().y(static_cast<double>(vehicle_id) * 0.1);
+                state.speed(1.0);
+                state.battery_voltage(8.0);
+                vehicle_state_writer.write(state);
+            }
+
+            //Visualizations that stay valid for an hour and get new IDs, s.t. they are never replaced
+            Visualization viz;
+            viz.id(step);
+            viz.type(VisualizationType::LineStrips);
+            viz.time_to_live(3600000000000ull);
+            std::vector<Point2D> points(50, Point2D(1.0, 1.0));
+            viz.points(rti::core::vector<Point2D>(points));
+            visualization_writer.write(viz);
+
+            //HLCs with changing IDs, e.g. from restarted programs
+            HLCHello hello;
+            hello.source_id(std::to_string(step % 256));
+            hello.script_running(true);
+            hello.middleware_running(false);
+            hlc_hello_writer.write(hello);
+
+            //Error messages that are all different, e.g. because they contain measured values
+            LCCErrorLogger::Instance().log_error("Synthetic error message number " + std::to_string(step));
+
+            message_count += static_cast<uint64_t>(vehicles) + 2;
+            ++step;
+
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    //The UI regularly takes new errors and visualizations, which is done here as well
+    bool success = true;
+    size_t warm_up_rss = 0;
+    size_t max_rss_after_warm_up = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto next_report = start;
+    while (true)
+    {
+        next_report += std::chrono::milliseconds(static_cast<uint64_t>(report_period_s * 1000));
+        while (std::chrono::steady_clock::now() < next_report)
+        {
+            timeSeriesAggregator->get_vehicle_data();
+            hlcReadyAggregator->get_hlc_ids_uint8_t();
+            visualizationCommandsAggregator->get_all_visualization_messages();
+            LCCErrorLogger::Instance().get_new_errors();
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+
+        double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t rss = get_rss_bytes();
+
+        std::cout << "t = " << static_cast<uint64_t>(elapsed_s) << " s, messages: " << message_count << ", RSS: " << rss / 1000000.0 << " MB" << std::endl;
+        for (auto& usage : MemoryBudget::Instance().get_usage())
+        {
+            std::cout << "\t" << usage.name << ": " << usage.footprint_bytes / 1000000.0 << " / " << usage.budget_bytes / 1000000.0
+                << " MB (reduced " << usage.shrink_count << "x)" << std::endl;
+
+            if (usage.footprint_bytes > usage.budget_bytes)
+            {
+                std::cout << "\t\tBudget of " << usage.name << " exceeded" << std::endl;
+                success = false;
+            }
+        }
+
+        if (elapsed_s < duration_s / 2)
+        {
+            warm_up_rss = rss;
+        }
+        else
+        {
+            max_rss_after_warm_up = std::max(max_rss_after_warm_up, rss);
+        }
+
+        if (elapsed_s >= duration_s) break;
+    }
+
+    running.store(false);
+    traffic_thread.join();
+    MemoryBudget::Instance().stop();
+
+    double rss_growth_percent = (warm_up_rss > 0)
+        ? (static_cast<double>(max_rss_after_warm_up) / static_cast<double>(warm_up_rss) - 1.0) * 100.0
+        : 0.0;
+    std::cout << "RSS growth after warm-up: " << rss_growth_percent << " %" << std::endl;
+    if (rss_growth_percent > max_rss_growth_percent)
+    {
+        success = false;
+    }
+
+    std::cout << (success ? "Test passed" : "Test failed") << std::endl;
+    return success ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ReactiveTrafficSimulation.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file ReactiveTrafficTest.cpp
+ * \brief Test for the reactive traffic agents (see ReactiveTrafficSimulation): Checks car-following, stopping behind a standing vehicle,
+ * lane changes to overtake a slow vehicle, and that 500 agents on two-lane ring roads can be simulated at 50 Hz
+ * without collisions in a fraction of the period.
+ * Example: ./ReactiveTrafficTest
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Create a straight lane along the x axis
+ * \param y y coordinate of the lane
+ * \param length Length of the lane
+ * \ingroup lcc
+ */
+static ReactiveTrafficLane straight_lane(double y, double length)
+{
+    std::vector<std::pair<double, double>> points;
+    for (double x = 0; x <= length + 1e-9; x += 0.5)
+    {
+        points.push_back(std::make_pair(x, y));
+    }
+    return ReactiveTrafficLane::from_points(points);
+}
+
+/**
+ * \brief Add a two-lane ring road (counter-clockwise, the inner lane is the left lane), each lane consisting of four lanes that succeed each other
+ * \param lanes The lanes are appended here
+ * \param center_x Center of the ring
+ * \param center_y Center of the ring
+ * \param radius Radius of the outer lane, the inner lane has a radius smaller by 0.3
+ * \ingroup lcc
+ */
+static void add_ring_road(std::vector<ReactiveTrafficLane>& lanes, double center_x, double center_y, double radius)
+{
+    size_t first = lanes.size();
+    for (int ring = 0; ring < 2; ++ring)
+    {
+        double ring_radius = radius - 0.3 * ring;
+        for (int quarter = 0; quarter < 4; ++quarter)
+        {
+            std::vector<std::pair<double, double>> points;
+            for (int i = 0; i <= 20; ++i)
+            {
+                double angle = (quarter + i / 20.0) * M_PI / 2.0;
+                points.push_back(std::make_pair(center_x + ring_radius * std::cos(angle), center_y + ring_radius * std::sin(angle)));
+            }
+            lanes.push_back(ReactiveTrafficLane::from_points(points));
+        }
+    }
+
+    for (int quarter = 0; quarter < 4; ++quarter)
+    {
+        auto& outer = lanes[first + quarter];
+        auto& inner = lanes[first + 4 + quarter];
+        outer.successors.push_back(static_cast<int>(first + (quarter + 1) % 4));
+        inner.successors.push_back(static_cast<int>(first + 4 + (quarter + 1) % 4));
+        outer.left = static_cast<int>(first + 4 + quarter);
+        inner.right = static_cast<int>(first + quarter);
+    }
+}
+
+int main()
+{
+    int failures = 0;
+    ReactiveTrafficSimulation::Parameters parameters;
+    const double dt = 0.02;
+
+    //Free road: The agent approaches its desired speed
+    {
+        ReactiveTrafficSimulation simulation({straight_lane(0, 50)}, parameters);
+        simulation.add_agent(1, 0.5, 0.02, 0, 0, 1.0, 0.22);
+        for (int i = 0; i < 500; ++i) simulation.step(dt);
+        check(std::abs(simulation.get_speed(0) - 1.0) < 0.05, "Free road: Desired speed is reached", failures);
+        check(std::abs(simulation.get_y(0)) < 1e-6, "Free road: Agent follows the lane's center line", failures);
+    }
+
+    //Standing vehicle: The agent stops behind it
+    {
+        ReactiveTrafficSimulation simulation({straight_lane(0, 20)}, parameters);
+        simulation.add_agent(1, 0.5, 0, 0, 1.0, 1.0, 0.22);
+        ReactiveTrafficVehicle vehicle;
+        vehicle.x = 5.0;
+        simulation.set_external_vehicles({vehicle});
+        for (int i = 0; i < 1000; ++i) simulation.step(dt);
+        double gap = vehicle.x - simulation.get_x(0) - 0.22;
+        check(simulation.get_speed(0) < 0.01, "Standing vehicle: Agent stops", failures);
+        check(gap > 0.05 && gap < 0.3, "Standing vehicle: Agent keeps the min. gap (" + std::to_string(gap) + " m)", failures);
+    }
+
+    //Slow vehicle on a two-lane road: The agent overtakes it on the left lane
+    {
+        auto right_lane = straight_lane(0, 50);
+        auto left_lane = straight_lane(0.3, 50);
+        right_lane.left = 1;
+        left_lane.right = 0;
+        ReactiveTrafficSimulation simulation({right_lane, left_lane}, parameters);
+        simulation.add_agent(1, 0.5, 0, 0, 1.0, 1.0, 0.22);
+
+        ReactiveTrafficVehicle vehicle;
+        vehicle.x = 2.0;
+        vehicle.speed = 0.3;
+        bool changed_lane = false;
+        for (int i = 0; i < 500; ++i)
+        {
+            simulation.set_external_vehicles({vehicle});
+            simulation.step(dt);
+            vehicle.x += vehicle.speed * dt;
+            changed_lane |= (simulation.get_lane(0) == 1);
+        }
+        check(changed_lane, "Slow vehicle: Agent changes to the left lane", failures);
+        check(simulation.get_x(0) > vehicle.x && simulation.get_speed(0) > 0.9, "Slow vehicle: Agent overtakes it", failures);
+    }
+
+    //Dense traffic: 10 ring roads with 25 agents per lane
+    {
+        std::vector<ReactiveTrafficLane> lanes;
+        const double radius = 4.0;
+        for (int ring = 0; ring < 10; ++ring)
+        {
+            add_ring_road(lanes, (ring % 5) * 10.0, (ring / 5) * 10.0, radius);
+        }
+        ReactiveTrafficSimulation simulation(lanes, parameters);
+
+        int id = 0;
+        for (int ring = 0; ring < 10; ++ring)
+        {
+            for (int lane = 0; lane < 2; ++lane)
+            {
+                double lane_radius = radius - 0.3 * lane;
+                for (int i = 0; i < 25; ++i)
+                {
+                    //Different desired speeds provoke lane changes
+                    double angle = (i + 0.5 * lane) * 2.0 * M_PI / 25.0;
+                    simulation.add_agent(
+                        id,
+                        (ring % 5) * 10.0 + lane_radius * std::cos(angle),
+                        (ring / 5) * 10.0 + lane_radius * std::sin(angle),
+                        angle + M_PI / 2.0,
+                        0.5,
+                        0.6 + 0.1 * (id % 7),
+                        0.22
+                    );
+                    ++id;
+                }
+            }
+        }
+        check(simulation.size() == 500, "Dense traffic: All " + std::to_string(simulation.size()) + " agents were placed on a lane", failures);
+
+        //Check for collisions: No two agents may be closer than their length
+        double min_distance = 1e9;
+        uint64_t max_step_ns = 0;
+        uint64_t total_step_ns = 0;
+        const int steps = 50 * 30;
+        for (int step = 0; step < steps; ++step)
+        {
+            auto start = std::chrono::steady_clock::now();
+            simulation.step(dt);
+            uint64_t step_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            max_step_ns = std::max(max_step_ns, step_ns);
+            total_step_ns += step_ns;
+
+            if (step % 50 == 0)
+            {
+                for (size_t a = 0; a < simulation.size(); ++a)
+                {
+                    for (size_t b = a + 1; b < simulation.size(); ++b)
+                    {
+                        if (simulation.get_id(a) / 50 != simulation.get_id(b) / 50) continue;
+                        min_distance = std::min(min_distance, std::hypot(simulation.get_x(a) - simulation.get_x(b), simulation.get_y(a) - simulation.get_y(b)));
+                    }
+                }
+            }
+        }
+
+        double mean_step_ms = total_step_ns / 1e6 / steps;
+        std::cout << "Dense traffic: Mean step time " << mean_step_ms << " ms, max. step time " << max_step_ns / 1e6 << " ms for " << simulation.size() << " agents" << std::endl;
+        check(min_distance > 0.22, "Dense traffic: No collisions (min. distance " + std::to_string(min_distance) + " m)", failures);
+        check(mean_step_ms < 5.0, "Dense traffic: Mean step time is below a quarter of the 20 ms period", failures);
+    }
+
+    return check_summary(failures);
+}
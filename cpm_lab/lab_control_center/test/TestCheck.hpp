@@ -0,0 +1,36 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+/**
+ * \file TestCheck.hpp
+ * \brief Helpers shared by the self-checking test executables of the LCC, which are run by ctest (see add_test in CMakeLists.txt).
+ * Each check prints a line, main returns check_summary(failures) s.t. ctest sees failed checks.
+ * \ingroup lcc
+ */
+
+/**
+ * \brief Print the result of a check
+ * \param ok Result of the check
+ * \param description What was checked
+ * \param failures Is incremented if the check failed
+ * \ingroup lcc
+ */
+inline void check(bool ok, const std::string& description, int& failures)
+{
+    std::cout << (ok ? "[OK]     " : "[FAILED] ") << description << std::endl;
+    if (!ok) ++failures;
+}
+
+/**
+ * \brief Print whether all checks passed
+ * \param failures Number of failed checks
+ * \return Exit code for main: 0 if all checks passed, 1 otherwise
+ * \ingroup lcc
+ */
+inline int check_summary(int failures)
+{
+    std::cout << (failures == 0 ? "All checks passed" : "Some checks failed") << std::endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -1,16 +1,205 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
 #include <thread>
+#include <vector>
 #include "cpm/Timer.hpp"
 #include "cpm/CommandLineReader.hpp"
 #include "cpm/Logging.hpp"
+#include "TimerTrigger.hpp"
 
 /**
  * \file TimerTestSimulated.cpp
- * \brief Test scenario: Creates a simulated-time timer that should be visible and stoppable from the LCC' timer tab
+ * \brief Test scenario: Creates simulated-time timers that should be visible and stoppable from the LCC' timer tab.
+ *
+ * Can also be used as scalability test harness for TimerSimulated / TimerTrigger:
+ * Spawns --participants timers in this process, with periods, offsets and artificial compute loads
+ * taken (cyclically) from --periods_ms, --offsets_ms and --loads_ms. With --internal_trigger=true,
+ * a TimerTrigger is run in this process as well (the LCC is not required) and the test is stopped
+ * after --duration_s simulated seconds; else, the LCC must be used to start and stop the simulation.
+ * After the stop signal, a report is printed: simulated seconds per wall-clock second,
+ * the distribution of the time that the participants spent waiting until the next time step was started (barrier wait),
+ * the idle time of each participant between two of its callbacks (which also contains the steps in which it was not triggered due to its period)
+ * and the slack of each participant (how much longer it could have computed without delaying the time step).
+ *
+ * Example: ./TimerTestSimulated --participants=20 --periods_ms=10,20,50 --loads_ms=1,2,5 --internal_trigger=true --duration_s=5
  * \ingroup lcc
  */
 
+/**
+ * \struct ParticipantStatistics
+ * \brief Wall-clock measurements of a single simulated participant, only written by its timer thread
+ * \ingroup lcc
+ */
+struct ParticipantStatistics {
+    //! ID of the participant's timer
+    std::string id;
+    //! Period of the timer in ns
+    uint64_t period_ns = 0;
+    //! Artificial compute load of each callback in ms
+    double load_ms = 0.0;
+    //! Simulated time of each callback
+    std::vector<uint64_t> simulated_times;
+    //! Wall clock time when each callback started
+    std::vector<uint64_t> callback_starts;
+    //! Wall clock time when each callback ended (afterwards, the ready signal is sent)
+    std::vector<uint64_t> callback_ends;
+};
+
+/**
+ * \brief Simulate a computation of the given duration
+ * \param load_ms Duration in ms
+ * \param busy If true, the CPU is kept busy, else the thread sleeps
+ */
+static void compute_load(double load_ms, bool busy)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<int64_t>(load_ms * 1000.0));
+    if (busy)
+    {
+        while (std::chrono::steady_clock::now() < end) {}
+    }
+    else
+    {
+        std::this_thread::sleep_until(end);
+    }
+}
+
+/**
+ * \brief Get the p-percentile (p in [0, 1]) of a sorted vector
+ */
+static double percentile(const std::vector<double>& sorted_values, double p)
+{
+    if (sorted_values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted_values.size() - 1) + 0.5);
+    return sorted_values.at(std::min(index, sorted_values.size() - 1));
+}
+
+/**
+ * \brief Print min, median, p90, p99 and max of the values
+ * \param name Name of the distribution
+ * \param values Values in ms (are sorted by this function)
+ */
+static void print_distribution(const std::string& name, std::vector<double>& values)
+{
+    std::sort(values.begin(), values.end());
+    printf("%-28s n=%-7zu min=%9.3f  p50=%9.3f  p90=%9.3f  p99=%9.3f  max=%9.3f (ms)\n",
+        name.c_str(),
+        values.size(),
+        percentile(values, 0.0),
+        percentile(values, 0.5),
+        percentile(values, 0.9),
+        percentile(values, 0.99),
+        percentile(values, 1.0)
+    );
+}
+
+/**
+ * \brief Print the results of the test run
+ * \param participants Measurements of all participants (their timers must not run anymore)
+ */
+static void print_report(const std::vector<std::shared_ptr<ParticipantStatistics>>& participants)
+{
+    //Latest callback end of all participants for each simulated time step, to determine the slack
+    std::map<uint64_t, uint64_t> step_ends;
+    //Earliest callback start for each simulated time step, i.e. when the barrier of the previous step was released
+    std::map<uint64_t, uint64_t> step_starts;
+    uint64_t first_wall = std::numeric_limits<uint64_t>::max();
+    uint64_t last_wall = 0;
+    uint64_t first_simulated = std::numeric_limits<uint64_t>::max();
+    uint64_t last_simulated = 0;
+
+    for (auto& participant : participants)
+    {
+        for (size_t i = 0; i < participant->callback_ends.size(); ++i)
+        {
+            uint64_t& step_end = step_ends[participant->simulated_times.at(i)];
+            step_end = std::max(step_end, participant->callback_ends.at(i));
+            auto step_start = step_starts.emplace(participant->simulated_times.at(i), participant->callback_starts.at(i)).first;
+            step_start->second = std::min(step_start->second, participant->callback_starts.at(i));
+
+            first_wall = std::min(first_wall, participant->callback_starts.at(i));
+            last_wall = std::max(last_wall, participant->callback_ends.at(i));
+            first_simulated = std::min(first_simulated, participant->simulated_times.at(i));
+            last_simulated = std::max(last_simulated, participant->simulated_times.at(i));
+        }
+    }
+
+    if (step_ends.empty())
+    {
+        std::cout << "No time steps were performed" << std::endl;
+        return;
+    }
+
+    double wall_s = static_cast<double>(last_wall - first_wall) * 1e-9;
+    double simulated_s = static_cast<double>(last_simulated - first_simulated) * 1e-9;
+
+    printf("\n===== Simulated time report =====\n");
+    printf("Participants: %zu, time steps: %zu\n", participants.size(), step_ends.size());
+    printf("Simulated: %.3f s, wall clock: %.3f s, simulated s per wall s: %.3f\n",
+        simulated_s, wall_s, (wall_s > 0) ? simulated_s / wall_s : 0.0);
+
+    std::vector<double> all_waits;
+    std::vector<double> all_idles;
+    std::vector<double> all_step_durations;
+    uint64_t previous_step_end = 0;
+    for (auto& step : step_ends)
+    {
+        if (previous_step_end > 0 && step.second > previous_step_end)
+        {
+            all_step_durations.push_back(static_cast<double>(step.second - previous_step_end) * 1e-6);
+        }
+        previous_step_end = step.second;
+    }
+    print_distribution("Time step duration", all_step_durations);
+
+    printf("\nPer participant (barrier wait: callback end until the first callback of the next time step starts; "
+        "idle: callback end until own next callback start; slack: last callback end of the step minus own callback end)\n");
+    for (auto& participant : participants)
+    {
+        std::vector<double> waits;
+        std::vector<double> idles;
+        std::vector<double> slacks;
+        std::vector<double> computes;
+
+        for (size_t i = 0; i < participant->callback_ends.size(); ++i)
+        {
+            uint64_t simulated_time = participant->simulated_times.at(i);
+            computes.push_back(static_cast<double>(participant->callback_ends.at(i) - participant->callback_starts.at(i)) * 1e-6);
+            slacks.push_back(static_cast<double>(step_ends.at(simulated_time) - participant->callback_ends.at(i)) * 1e-6);
+
+            auto next_step = step_starts.upper_bound(simulated_time);
+            if (next_step != step_starts.end() && next_step->second >= participant->callback_ends.at(i))
+            {
+                waits.push_back(static_cast<double>(next_step->second - participant->callback_ends.at(i)) * 1e-6);
+            }
+
+            if (i + 1 < participant->callback_starts.size())
+            {
+                idles.push_back(static_cast<double>(participant->callback_starts.at(i + 1) - participant->callback_ends.at(i)) * 1e-6);
+            }
+        }
+        all_waits.insert(all_waits.end(), waits.begin(), waits.end());
+        all_idles.insert(all_idles.end(), idles.begin(), idles.end());
+
+        printf("--- %s (period %.3f ms, load %.3f ms)\n", participant->id.c_str(), static_cast<double>(participant->period_ns) * 1e-6, participant->load_ms);
+        print_distribution("  Compute", computes);
+        print_distribution("  Barrier wait", waits);
+        print_distribution("  Idle between callbacks", idles);
+        print_distribution("  Slack", slacks);
+    }
+
+    printf("\n");
+    print_distribution("Barrier wait (all)", all_waits);
+    print_distribution("Idle between callbacks (all)", all_idles);
+}
+
 int main(int argc, char *argv[]) {
     cpm::Logging::Instance().set_id("Logger_test");
 
@@ -20,13 +209,109 @@ int main(int argc, char *argv[]) {
     uint64_t period = cpm::cmd_parameter_uint64_t("period", 1000000ull, argc, argv);
     uint64_t offset = cpm::cmd_parameter_uint64_t("offset", 0ull, argc, argv);
 
-    auto timer1 = cpm::Timer::create(id, period, offset, true, true, true);
-    timer1->start([&](uint64_t t_now) {
-        std::cout << "Time now: " << t_now << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    });
+    //Scalability test settings, the defaults correspond to a single timer with 100ms of load per step
+    int participant_count = std::max(cpm::cmd_parameter_int("participants", 1, argc, argv), 1);
+    std::vector<double> periods_ms = cpm::cmd_parameter_doubles("periods_ms", {static_cast<double>(period) * 1e-6}, argc, argv);
+    std::vector<double> offsets_ms = cpm::cmd_parameter_doubles("offsets_ms", {static_cast<double>(offset) * 1e-6}, argc, argv);
+    std::vector<double> loads_ms = cpm::cmd_parameter_doubles("loads_ms", {100.0}, argc, argv);
+    double load_jitter = cpm::cmd_parameter_double("load_jitter", 0.0, argc, argv);
+    bool busy_load = cpm::cmd_parameter_bool("busy_load", false, argc, argv);
+    bool verbose = cpm::cmd_parameter_bool("verbose", participant_count == 1, argc, argv);
+    bool internal_trigger = cpm::cmd_parameter_bool("internal_trigger", false, argc, argv);
+    double duration_s = cpm::cmd_parameter_double("duration_s", 10.0, argc, argv);
+
+    if (periods_ms.empty() || offsets_ms.empty() || loads_ms.empty())
+    {
+        std::cerr << "periods_ms, offsets_ms and loads_ms must not be empty" << std::endl;
+        return 1;
+    }
+
+    //Optional in-process trigger, replaces the LCC
+    std::shared_ptr<TimerTrigger> timer_trigger;
+    if (internal_trigger)
+    {
+        timer_trigger = std::make_shared<TimerTrigger>(true);
+    }
+
+    std::vector<std::shared_ptr<ParticipantStatistics>> statistics;
+    std::vector<std::shared_ptr<cpm::Timer>> timers;
+    std::vector<std::function<void(uint64_t)>> callbacks;
+    for (int i = 0; i < participant_count; ++i)
+    {
+        auto participant = std::make_shared<ParticipantStatistics>();
+        participant->id = (participant_count == 1) ? id : id + "_" + std::to_string(i);
+        participant->period_ns = static_cast<uint64_t>(periods_ms.at(i % periods_ms.size()) * 1e6);
+        participant->load_ms = loads_ms.at(i % loads_ms.size());
+        uint64_t offset_ns = static_cast<uint64_t>(offsets_ms.at(i % offsets_ms.size()) * 1e6);
+        statistics.push_back(participant);
+
+        timers.push_back(cpm::Timer::create(participant->id, participant->period_ns, offset_ns, true, true, true));
+
+        auto random_engine = std::make_shared<std::mt19937>(i);
+        callbacks.push_back([=](uint64_t t_now) {
+            participant->callback_starts.push_back(cpm::get_time_ns());
+            participant->simulated_times.push_back(t_now);
+
+            if (verbose)
+            {
+                std::cout << participant->id << " - Time now: " << t_now << std::endl;
+            }
+
+            double load = participant->load_ms;
+            if (load_jitter > 0)
+            {
+                std::uniform_real_distribution<double> jitter(-load_jitter, load_jitter);
+                load = std::max(0.0, load * (1.0 + jitter(*random_engine)));
+            }
+            compute_load(load, busy_load);
+
+            participant->callback_ends.push_back(cpm::get_time_ns());
+        });
+    }
+
+    //Start the trigger and stop it after the given duration (in simulated time)
+    std::thread trigger_thread;
+    if (internal_trigger)
+    {
+        trigger_thread = std::thread([&] () {
+            //Wait until all participants registered
+            while (timer_trigger->get_participant_message_data().size() < static_cast<size_t>(participant_count))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            timer_trigger->send_start_signal();
+
+            bool use_simulated_time;
+            uint64_t current_time = 0;
+            uint64_t duration_ns = static_cast<uint64_t>(duration_s * 1e9);
+            while (current_time < duration_ns)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                timer_trigger->get_current_simulated_time(use_simulated_time, current_time);
+            }
+            timer_trigger->send_stop_signal();
+        });
+    }
+
+    //The first timer blocks until the stop signal was received, the others run in their own threads
+    for (size_t i = 1; i < timers.size(); ++i)
+    {
+        timers.at(i)->start_async(callbacks.at(i));
+    }
+    timers.at(0)->start(callbacks.at(0));
 
     std::cout << "Shutting down..." << std::endl;
 
+    if (trigger_thread.joinable())
+    {
+        trigger_thread.join();
+    }
+    for (auto& timer : timers)
+    {
+        timer->stop();
+    }
+
+    print_report(statistics);
+
     return 0;
-}
\ No newline at end of file
+}
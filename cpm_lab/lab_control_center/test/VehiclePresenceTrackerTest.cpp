@@ -0,0 +1,76 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "VehiclePresenceTracker.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file VehiclePresenceTrackerTest.cpp
+ * \brief Test for VehiclePresenceTracker: Checks that vehicles come online / go offline and become real / simulated depending on
+ * the received messages and the timeouts, that subscribers get these changes exactly once and in order, and that the message rate is estimated.
+ * Example: ./VehiclePresenceTrackerTest
+ * \ingroup lcc
+ */
+
+int main()
+{
+    int failures = 0;
+    const uint64_t ms = 1000000ull;
+    const uint64_t t0 = 1000000000000ull;
+
+    using PresenceChange = VehiclePresenceTracker::PresenceChange;
+    VehiclePresenceTracker tracker(1000 * ms, 500 * ms);
+    std::vector<std::pair<uint8_t, PresenceChange>> changes;
+    uint64_t subscription = tracker.subscribe([&](const VehiclePresenceTracker::VehiclePresence& presence, PresenceChange change){
+        changes.push_back(std::make_pair(presence.vehicle_id, change));
+    });
+
+    //A simulated and a real vehicle send messages at 50 Hz
+    for (uint64_t i = 0; i < 50; ++i)
+    {
+        tracker.update(1, false, t0 + i * 20 * ms);
+        tracker.update(2, true, t0 + i * 20 * ms);
+        tracker.check_timeouts(t0 + i * 20 * ms);
+    }
+    check(changes == std::vector<std::pair<uint8_t, PresenceChange>>({
+            {1, PresenceChange::ONLINE}, {2, PresenceChange::ONLINE}, {2, PresenceChange::REAL}
+        }), "Online: Each change is sent once", failures);
+    check(tracker.get_online_vehicle_ids() == std::vector<uint8_t>({1, 2}), "Online: Both vehicles are online", failures);
+    check(tracker.get_real_vehicle_ids() == std::vector<uint8_t>({2}), "Online: Only vehicle 2 is real", failures);
+    check(std::fabs(tracker.get_presence().at(1).message_rate_hz - 50.0) < 0.01, "Online: Message rate is estimated", failures);
+
+    //Vehicle 2 is replaced by a simulated vehicle: It stays online, but is no longer real after the real timeout
+    changes.clear();
+    const uint64_t t1 = t0 + 980 * ms;
+    tracker.update(2, false, t1 + 200 * ms);
+    tracker.check_timeouts(t1 + 400 * ms);
+    check(changes.empty(), "Simulated: Still real within the real timeout", failures);
+    tracker.update(2, false, t1 + 600 * ms);
+    tracker.check_timeouts(t1 + 600 * ms);
+    check(changes == std::vector<std::pair<uint8_t, PresenceChange>>({{2, PresenceChange::SIMULATED}}), "Simulated: Real status is lost after the real timeout", failures);
+    check(tracker.get_real_vehicle_ids().empty(), "Simulated: No real vehicles", failures);
+
+    //Vehicle 1 stops sending
+    changes.clear();
+    tracker.check_timeouts(t1 + 1000 * ms);
+    check(changes.empty(), "Offline: Still online within the offline timeout", failures);
+    tracker.check_timeouts(t1 + 1001 * ms);
+    check(changes == std::vector<std::pair<uint8_t, PresenceChange>>({{1, PresenceChange::OFFLINE}}), "Offline: Vehicle goes offline after the offline timeout", failures);
+    check(tracker.get_online_vehicle_ids() == std::vector<uint8_t>({2}), "Offline: Only vehicle 2 is online", failures);
+    check(tracker.get_presence().at(1).last_seen == t0 + 49 * 20 * ms, "Offline: Last seen time is kept", failures);
+
+    //Vehicle 1 comes back as real vehicle
+    changes.clear();
+    tracker.update(1, true, t1 + 2000 * ms);
+    check(changes == std::vector<std::pair<uint8_t, PresenceChange>>({{1, PresenceChange::ONLINE}, {1, PresenceChange::REAL}}), "Back online: Online and real again", failures);
+    check(tracker.get_presence().at(1).message_rate_hz == 0, "Back online: Message rate is restarted", failures);
+
+    //No changes after unsubscribing
+    changes.clear();
+    tracker.unsubscribe(subscription);
+    tracker.check_timeouts(t1 + 10000 * ms);
+    check(changes.empty() && tracker.get_online_vehicle_ids().empty(), "Unsubscribe: No changes are sent, but the presence is still updated", failures);
+
+    return check_summary(failures);
+}
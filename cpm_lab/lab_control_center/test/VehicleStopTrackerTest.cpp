@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "VehicleStopTracker.hpp"
+#include "TestCheck.hpp"
+
+/**
+ * \file VehicleStopTrackerTest.cpp
+ * \brief Test for VehicleStopTracker: Checks that stops are retransmitted until a VehicleState that was created after the request
+ * reports standstill, that the stop latency is measured from the first request, and that unconfirmed stops time out.
+ * Example: ./VehicleStopTrackerTest
+ * \ingroup lcc
+ */
+
+int main()
+{
+    int failures = 0;
+    const uint64_t ms = 1000000ull;
+    const uint64_t t0 = 1000000000000ull;
+
+    //Confirmation: Only a new state with a speed close to zero confirms the stop
+    {
+        VehicleStopTracker tracker(0.05, 10000 * ms);
+        tracker.request_stop(1, t0);
+        tracker.request_stop(2, t0);
+        check(tracker.has_pending_stops(), "Confirmation: Requested stops are pending", failures);
+
+        std::vector<uint8_t> timed_out;
+        auto retransmissions = tracker.get_retransmissions(t0 + 20 * ms, timed_out);
+        check(retransmissions == std::vector<uint8_t>({1, 2}) && timed_out.empty(), "Confirmation: Unconfirmed stops are retransmitted", failures);
+
+        uint64_t latency = 0;
+        check(!tracker.handle_vehicle_state(1, 0.0, t0 - 1 * ms, t0 + 25 * ms, latency), "Confirmation: A state created before the request does not confirm the stop", failures);
+        check(!tracker.handle_vehicle_state(1, 0.5, t0 + 10 * ms, t0 + 25 * ms, latency), "Confirmation: A moving vehicle does not confirm the stop", failures);
+        check(!tracker.handle_vehicle_state(3, 0.0, t0 + 10 * ms, t0 + 25 * ms, latency), "Confirmation: A vehicle that was not stopped is ignored", failures);
+        check(tracker.handle_vehicle_state(1, -0.01, t0 + 30 * ms, t0 + 32 * ms, latency), "Confirmation: Standstill confirms the stop", failures);
+        check(latency == 32 * ms, "Confirmation: Latency is measured from the request to the reception of the state", failures);
+
+        retransmissions = tracker.get_retransmissions(t0 + 40 * ms, timed_out);
+        check(retransmissions == std::vector<uint8_t>({2}), "Confirmation: Confirmed stops are no longer retransmitted", failures);
+        check(tracker.get_pending_stops().at(2).send_count == 3, "Confirmation: Sent commands are counted", failures);
+        check(tracker.get_stop_latencies().size() == 1 && tracker.get_stop_latencies().at(1) == 32 * ms, "Confirmation: Latency is stored", failures);
+    }
+
+    //Repeated request: The latency is measured from the first request
+    {
+        VehicleStopTracker tracker(0.05, 10000 * ms);
+        tracker.request_stop(4, t0);
+        tracker.request_stop(4, t0 + 50 * ms);
+        uint64_t latency = 0;
+        check(tracker.handle_vehicle_state(4, 0.0, t0 + 10 * ms, t0 + 100 * ms, latency) && latency == 100 * ms, "Repeated request: Latency is measured from the first request", failures);
+        check(!tracker.has_pending_stops(), "Repeated request: No stops are pending after the confirmation", failures);
+    }
+
+    //Timeout: Unconfirmed stops are given up
+    {
+        VehicleStopTracker tracker(0.05, 1000 * ms);
+        tracker.request_stop(5, t0);
+        std::vector<uint8_t> timed_out;
+        tracker.get_retransmissions(t0 + 999 * ms, timed_out);
+        check(timed_out.empty(), "Timeout: Not given up before the timeout", failures);
+        auto retransmissions = tracker.get_retransmissions(t0 + 1000 * ms, timed_out);
+        check(retransmissions.empty() && timed_out == std::vector<uint8_t>({5}), "Timeout: Given up after the timeout", failures);
+        check(!tracker.has_pending_stops(), "Timeout: No stops are pending afterwards", failures);
+    }
+
+    return check_summary(failures);
+}
@@ -0,0 +1,90 @@
+#include "AttachedWindowUi.hpp"
+
+#include <sstream>
+
+/**
+ * \file AttachedWindowUi.cpp
+ * \ingroup lcc_ui
+ */
+
+AttachedWindowUi::AttachedWindowUi(std::shared_ptr<LCCStateClient> _client, std::shared_ptr<MapViewUi> _map_view_ui)
+:client(_client)
+,map_view_ui(_map_view_ui)
+{
+    window.set_title("CPM Lab Control Center (attached)");
+    window.add_events(Gdk::SCROLL_MASK);
+
+    label_status.set_xalign(0);
+    label_log.set_xalign(0);
+    label_log.set_ellipsize(Pango::ELLIPSIZE_END);
+
+    box_controls.set_border_width(5);
+    box_controls.pack_start(button_start, false, false);
+    box_controls.pack_start(button_stop, false, false);
+    box_controls.pack_start(label_status, true, true);
+    box_controls.pack_end(button_shutdown, false, false);
+
+    box_main.pack_start(box_controls, false, false);
+    box_main.pack_start(*(map_view_ui->get_parent()), true, true);
+    box_main.pack_end(label_log, false, false);
+    window.add(box_main);
+
+    button_start.signal_clicked().connect([this](){ client->send_command(CommandStartTimer); });
+    button_stop.signal_clicked().connect([this](){ client->send_command(CommandStopTimer); });
+    button_shutdown.signal_clicked().connect([this](){ client->send_command(CommandShutdown); });
+
+    Glib::signal_timeout().connect(sigc::mem_fun(*this, &AttachedWindowUi::update_status), 200);
+
+    int screen_width = window.get_screen()->get_width();
+    int screen_height = window.get_screen()->get_height();
+    window.set_default_size((3 * screen_width)/4, (3 * screen_height)/4);
+    window.show_all();
+}
+
+bool AttachedWindowUi::update_status()
+{
+    std::stringstream status;
+    bool connected = client->is_connected();
+    if (!connected)
+    {
+        status << "Not connected to a headless LCC, retrying...";
+    }
+    else
+    {
+        auto timer = client->get_timer_state();
+        status << "Connected";
+        if (timer.simulated_time)
+        {
+            status << " | Simulated time: " << timer.current_time / 1000000ull << " ms";
+        }
+        else
+        {
+            status << " | Real time";
+        }
+
+        auto hlc_ids = client->get_hlc_ids();
+        status << " | HLCs:";
+        if (hlc_ids.empty()) status << " none";
+        for (auto id : hlc_ids)
+        {
+            status << " " << static_cast<int>(id);
+        }
+
+        auto logs = client->get_logs();
+        if (logs.size() > 0)
+        {
+            label_log.set_text(logs.back().id + ": " + logs.back().content);
+        }
+    }
+
+    label_status.set_text(status.str());
+    button_start.set_sensitive(connected);
+    button_stop.set_sensitive(connected);
+    button_shutdown.set_sensitive(connected);
+    return true;
+}
+
+Gtk::Window& AttachedWindowUi::get_window()
+{
+    return window;
+}
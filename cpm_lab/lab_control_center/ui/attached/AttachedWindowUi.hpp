@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defaults.hpp"
+#include <memory>
+#include <gtkmm.h>
+#include "LCCStateClient.hpp"
+#include "ui/map_view/MapViewUi.hpp"
+
+/**
+ * \class AttachedWindowUi
+ * \brief Minimal LCC window for a UI that is attached to a headless LCC (--attach, see LCCStateClient).
+ * It shows the map with the mirrored vehicle data, the connection / timer state and the connected HLCs,
+ * and allows to start and stop the timer of the headless LCC. Closing this window does not affect the headless LCC.
+ * This is not a full LCC UI: Setup and deployment, parameters, logs and monitoring are only available in the LCC with its built-in UI.
+ * \ingroup lcc_ui
+ */
+class AttachedWindowUi
+{
+private:
+    //! Client that mirrors the state of the headless LCC
+    std::shared_ptr<LCCStateClient> client;
+    //! Map view, drawn with the mirrored vehicle data
+    std::shared_ptr<MapViewUi> map_view_ui;
+
+    //! The window
+    Gtk::Window window;
+    //! Contains the control bar and the map
+    Gtk::Box box_main{Gtk::ORIENTATION_VERTICAL};
+    //! Contains the buttons and the status label
+    Gtk::Box box_controls{Gtk::ORIENTATION_HORIZONTAL, 10};
+    //! Sends CommandStartTimer to the headless LCC
+    Gtk::Button button_start{"Start"};
+    //! Sends CommandStopTimer to the headless LCC
+    Gtk::Button button_stop{"Stop"};
+    //! Sends CommandShutdown to the headless LCC
+    Gtk::Button button_shutdown{"Shut down LCC"};
+    //! Shows the connection state, the timer state and the connected HLCs
+    Gtk::Label label_status;
+    //! Shows the newest log message
+    Gtk::Label label_log;
+
+    /**
+     * \brief Regularly called in the UI thread to update the status labels
+     * \return True, s.t. the timeout keeps running
+     */
+    bool update_status();
+
+public:
+    /**
+     * \brief Constructor
+     * \param _client Client that is connected to the headless LCC
+     * \param _map_view_ui Map view that draws the data of _client
+     */
+    AttachedWindowUi(std::shared_ptr<LCCStateClient> _client, std::shared_ptr<MapViewUi> _map_view_ui);
+
+    /**
+     * \brief Get the window, e.g. to run it with Gtk::Application
+     */
+    Gtk::Window& get_window();
+};
@@ -424,7 +424,7 @@ void CommonroadViewUI::vehicle_selection_changed(unsigned int id, ObstacleToggle
     }
     else
     {
-        cpm::Logging::Instance().write(1, "%s", "Error in CommonroadViewUI::vehicle_selection_changed - no sim. manager");
+        CPM_LOG(1, "%s", "Error in CommonroadViewUI::vehicle_selection_changed - no sim. manager");
     }
 }
 
@@ -850,7 +850,7 @@ void CommonroadViewUI::preview_clicked()
 
     if (! obstacle_sim_manager)
     {
-        cpm::Logging::Instance().write(1, "%s", "Error in CommonroadViewUI::preview_clicked - no sim. manager");
+        CPM_LOG(1, "%s", "Error in CommonroadViewUI::preview_clicked - no sim. manager");
     }
 
     preview_enabled = !preview_enabled;
@@ -140,7 +140,7 @@ void LoggerViewUI::on_log_level_changed()
     }
     else
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1, 
             "%s", 
             "ERROR: Log level set that does not exist!"
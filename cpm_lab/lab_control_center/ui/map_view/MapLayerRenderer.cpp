@@ -0,0 +1,171 @@
+#include "MapLayerRenderer.hpp"
+#include "cpm/Logging.hpp"
+
+#include <exception>
+
+/**
+ * \file MapLayerRenderer.cpp
+ * \ingroup lcc_ui
+ */
+
+MapLayerRenderer::MapLayerRenderer(size_t layer_count)
+{
+    for (size_t i = 0; i < layer_count; ++i)
+    {
+        layers.push_back(std::unique_ptr<Layer>(new Layer()));
+    }
+
+    //Start the workers after all layers exist, the vector must not change anymore
+    for (auto& layer : layers)
+    {
+        Layer* layer_ptr = layer.get();
+        layer->worker = std::thread([this, layer_ptr] () {
+            run_layer(*layer_ptr);
+        });
+    }
+}
+
+MapLayerRenderer::~MapLayerRenderer()
+{
+    stop();
+}
+
+void MapLayerRenderer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(renderer_mutex);
+        renderer_running = false;
+    }
+    renderer_cv.notify_all();
+
+    for (auto& layer : layers)
+    {
+        if (layer->worker.joinable())
+        {
+            layer->worker.join();
+        }
+    }
+
+    //Release the draw functions, which may hold data of the caller
+    std::lock_guard<std::mutex> lock(renderer_mutex);
+    for (auto& layer : layers)
+    {
+        layer->request_draw = nullptr;
+        layer->has_request = false;
+    }
+}
+
+void MapLayerRenderer::run_layer(Layer& layer)
+{
+    std::unique_lock<std::mutex> lock(renderer_mutex);
+    while (true)
+    {
+        renderer_cv.wait(lock, [&] { return !renderer_running || layer.has_request; });
+        if (!renderer_running) break;
+
+        DrawFunction draw = std::move(layer.request_draw);
+        layer.request_draw = nullptr;
+        layer.has_request = false;
+        Cairo::Matrix view = layer.request_view;
+        int width = layer.request_width;
+        int height = layer.request_height;
+        Cairo::RefPtr<Cairo::ImageSurface> surface = layer.back_surface;
+
+        //Draw without holding the lock, s.t. the UI thread can paint other layers / request new versions in the meantime
+        lock.unlock();
+        {
+            if (!surface || surface->get_width() != width || surface->get_height() != height)
+            {
+                surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+            }
+
+            auto ctx = Cairo::Context::create(surface);
+
+            //The reused surface still contains an older version of the layer
+            ctx->save();
+            ctx->set_operator(Cairo::OPERATOR_CLEAR);
+            ctx->paint();
+            ctx->restore();
+
+            ctx->transform(view);
+            try
+            {
+                draw(ctx);
+            }
+            catch (const std::exception& e)
+            {
+                CPM_LOG(1, "Error while drawing a map view layer: %s", e.what());
+            }
+        }
+        surface->flush();
+        //The draw function may hold a data snapshot, which should not be destroyed while the lock is held
+        draw = nullptr;
+        lock.lock();
+
+        layer.back_surface = layer.front_surface;
+        layer.front_surface = surface;
+        layer.front_view = view;
+        layer.finished_frames += 1;
+    }
+}
+
+void MapLayerRenderer::request(size_t layer, const Cairo::Matrix& view, int width, int height, DrawFunction draw)
+{
+    if (width <= 0 || height <= 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(renderer_mutex);
+        if (!renderer_running) return;
+
+        Layer& requested_layer = *(layers.at(layer));
+        if (requested_layer.has_request)
+        {
+            requested_layer.dropped_frames += 1;
+        }
+
+        //Swap, s.t. a replaced draw function is destroyed after the lock was released
+        std::swap(requested_layer.request_draw, draw);
+        requested_layer.request_view = view;
+        requested_layer.request_width = width;
+        requested_layer.request_height = height;
+        requested_layer.has_request = true;
+    }
+    renderer_cv.notify_all();
+}
+
+bool MapLayerRenderer::paint(const Cairo::RefPtr<Cairo::Context>& ctx, size_t layer, const Cairo::Matrix& view)
+{
+    std::lock_guard<std::mutex> lock(renderer_mutex);
+    Layer& painted_layer = *(layers.at(layer));
+    if (!painted_layer.front_surface) return false;
+
+    //Canvas coordinates of the finished surface -> World coordinates -> Current canvas coordinates
+    Cairo::Matrix canvas_to_world = painted_layer.front_view;
+    canvas_to_world.invert();
+    Cairo::Matrix current_view = view;
+    Cairo::Matrix correction = Cairo::identity_matrix();
+    correction.multiply(canvas_to_world, current_view);
+
+    ctx->save();
+    ctx->transform(correction);
+    ctx->set_source(painted_layer.front_surface, 0, 0);
+    ctx->paint();
+    //The worker draws on the surface again later: Restore drops the context's reference to it, flush detaches
+    //copies that the target backend may have cached for it (which must not be touched by the worker's thread)
+    ctx->restore();
+    painted_layer.front_surface->flush();
+
+    return true;
+}
+
+uint64_t MapLayerRenderer::get_finished_frames(size_t layer)
+{
+    std::lock_guard<std::mutex> lock(renderer_mutex);
+    return layers.at(layer)->finished_frames;
+}
+
+uint64_t MapLayerRenderer::get_dropped_frames(size_t layer)
+{
+    std::lock_guard<std::mutex> lock(renderer_mutex);
+    return layers.at(layer)->dropped_frames;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cairomm/cairomm.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \class MapLayerRenderer
+ * \brief Draws the layers of the map view (map, trajectories, obstacles, vehicles...) into off-screen image surfaces, each layer in its own thread.
+ *
+ * The UI thread requests a new version of a layer regularly (see request) and only puts the finished surfaces together when drawing (see paint).
+ * If a layer is not finished in time, the last finished version is shown instead, moved / scaled / rotated according to the current view.
+ * Thus, the UI stays responsive even if a layer takes long to draw. Requests that were not picked up by the layer's thread before the next
+ * request arrived are dropped (only the newest request is drawn), and are counted (see get_dropped_frames).
+ *
+ * Important: The draw functions are called in the layer's thread, so they must only use data that is not changed by other threads
+ * (e.g. a snapshot taken in the UI thread) or that is thread-safe.
+ * \ingroup lcc_ui
+ */
+class MapLayerRenderer
+{
+public:
+    //! Draws a layer in world coordinates, the context is already transformed by the view matrix
+    using DrawFunction = std::function<void(const Cairo::RefPtr<Cairo::Context>&)>;
+
+private:
+    /**
+     * \brief State of a single layer; the surfaces are only accessed with renderer_mutex locked, except for the one that is currently drawn
+     */
+    struct Layer {
+        //! Thread that draws the layer
+        std::thread worker;
+
+        //! True if there is a request that was not picked up by worker yet
+        bool has_request = false;
+        //! Draw function of the newest request
+        DrawFunction request_draw;
+        //! View (world to canvas coordinates) of the newest request
+        Cairo::Matrix request_view = Cairo::identity_matrix();
+        //! Canvas width of the newest request
+        int request_width = 0;
+        //! Canvas height of the newest request
+        int request_height = 0;
+
+        //! Newest finished surface, shown by paint
+        Cairo::RefPtr<Cairo::ImageSurface> front_surface;
+        //! View that front_surface was drawn with
+        Cairo::Matrix front_view = Cairo::identity_matrix();
+        //! Surface that is reused for the next request, to avoid allocating a new surface for each frame
+        Cairo::RefPtr<Cairo::ImageSurface> back_surface;
+
+        //! Number of finished requests
+        uint64_t finished_frames = 0;
+        //! Number of requests that were replaced by a newer one before they were drawn
+        uint64_t dropped_frames = 0;
+    };
+
+    //! All layers, in the order given by the layer index
+    std::vector<std::unique_ptr<Layer>> layers;
+    //! Stop condition for the workers
+    bool renderer_running = true;
+    //! Mutex for the requests, the finished surfaces and renderer_running
+    std::mutex renderer_mutex;
+    //! To wake up the workers on new requests / when they are stopped
+    std::condition_variable renderer_cv;
+
+    /**
+     * \brief Worker loop of a layer: Wait for requests and draw them
+     * \param layer The layer
+     */
+    void run_layer(Layer& layer);
+
+public:
+    /**
+     * \brief Constructor, starts one thread per layer
+     * \param layer_count Number of layers, a layer is identified by its index
+     */
+    MapLayerRenderer(size_t layer_count);
+
+    /**
+     * \brief Destructor, stops all threads (see stop)
+     */
+    ~MapLayerRenderer();
+
+    /**
+     * \brief Stop all threads, waits for the layers that are currently being drawn. Must be called before data used by the draw functions is destroyed.
+     */
+    void stop();
+
+    /**
+     * \brief Request a new version of a layer. Replaces a request for the layer that was not picked up yet.
+     * \param layer Index of the layer
+     * \param view Transformation from world to canvas coordinates
+     * \param width Width of the canvas in pixels
+     * \param height Height of the canvas in pixels
+     * \param draw Draws the layer, called in the layer's thread
+     */
+    void request(size_t layer, const Cairo::Matrix& view, int width, int height, DrawFunction draw);
+
+    /**
+     * \brief Paint the newest finished version of a layer. If it was drawn with another view, it is transformed to the current view.
+     * \param ctx Context to paint on, in canvas coordinates
+     * \param layer Index of the layer
+     * \param view Current transformation from world to canvas coordinates
+     * \return False if no version of the layer was finished yet (nothing is painted then)
+     */
+    bool paint(const Cairo::RefPtr<Cairo::Context>& ctx, size_t layer, const Cairo::Matrix& view);
+
+    /**
+     * \brief Get the number of finished versions of a layer
+     * \param layer Index of the layer
+     */
+    uint64_t get_finished_frames(size_t layer);
+
+    /**
+     * \brief Get the number of requests for a layer that were dropped because a newer request arrived before they were drawn
+     * \param layer Index of the layer
+     */
+    uint64_t get_dropped_frames(size_t layer);
+};
@@ -0,0 +1,312 @@
+#include "MapPickIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * \file MapPickIndex.cpp
+ * \ingroup lcc_ui
+ */
+
+MapPickIndex::MapPickIndex(double _cell_size, size_t _max_piece_points, size_t _max_piece_cells)
+:cell_size(_cell_size)
+,max_piece_points(std::max<size_t>(_max_piece_points, 2))
+,max_piece_cells(_max_piece_cells)
+{
+
+}
+
+int32_t MapPickIndex::cell_index(double value) const
+{
+    double index = std::floor(value / cell_size);
+
+    //Also catches NaN, which would otherwise lead to undefined behaviour in the cast
+    if (!(index > static_cast<double>(std::numeric_limits<int32_t>::min()))) return std::numeric_limits<int32_t>::min();
+    if (index >= static_cast<double>(std::numeric_limits<int32_t>::max())) return std::numeric_limits<int32_t>::max();
+    return static_cast<int32_t>(index);
+}
+
+uint64_t MapPickIndex::cell_key(int32_t x, int32_t y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+void MapPickIndex::insert_piece(const MapPickKey& key, MapPickShape::Type type, std::vector<std::pair<double, double>> points, double radius, std::vector<size_t>& piece_ids)
+{
+    if (points.empty()) return;
+
+    size_t piece_id;
+    if (free_pieces.empty())
+    {
+        piece_id = pieces.size();
+        pieces.emplace_back();
+    }
+    else
+    {
+        piece_id = free_pieces.back();
+        free_pieces.pop_back();
+    }
+    piece_ids.push_back(piece_id);
+
+    Piece& piece = pieces[piece_id];
+    piece.key = key;
+    piece.type = type;
+    piece.points = std::move(points);
+    piece.radius = (type == MapPickShape::Polygon) ? 0.0 : std::max(radius, 0.0);
+    piece.cells.clear();
+    piece.last_pick = 0;
+
+    //Bounding box, extended by the radius
+    double min_x = piece.points.front().first;
+    double max_x = min_x;
+    double min_y = piece.points.front().second;
+    double max_y = min_y;
+    for (const auto& point : piece.points)
+    {
+        min_x = std::min(min_x, point.first);
+        max_x = std::max(max_x, point.first);
+        min_y = std::min(min_y, point.second);
+        max_y = std::max(max_y, point.second);
+    }
+
+    int64_t cell_x_min = cell_index(min_x - piece.radius);
+    int64_t cell_x_max = cell_index(max_x + piece.radius);
+    int64_t cell_y_min = cell_index(min_y - piece.radius);
+    int64_t cell_y_max = cell_index(max_y + piece.radius);
+
+    if ((cell_x_max - cell_x_min + 1) * (cell_y_max - cell_y_min + 1) > static_cast<int64_t>(max_piece_cells))
+    {
+        large_pieces.push_back(piece_id);
+        return;
+    }
+
+    for (int64_t cell_x = cell_x_min; cell_x <= cell_x_max; ++cell_x)
+    {
+        for (int64_t cell_y = cell_y_min; cell_y <= cell_y_max; ++cell_y)
+        {
+            uint64_t cell = cell_key(static_cast<int32_t>(cell_x), static_cast<int32_t>(cell_y));
+            grid[cell].push_back(piece_id);
+            piece.cells.push_back(cell);
+        }
+    }
+}
+
+void MapPickIndex::remove_pieces(Entry& entry)
+{
+    for (size_t piece_id : entry.piece_ids)
+    {
+        Piece& piece = pieces[piece_id];
+        if (piece.cells.empty())
+        {
+            large_pieces.erase(std::remove(large_pieces.begin(), large_pieces.end(), piece_id), large_pieces.end());
+        }
+
+        for (uint64_t cell : piece.cells)
+        {
+            auto grid_cell = grid.find(cell);
+            if (grid_cell == grid.end()) continue;
+
+            //Order within a cell does not matter
+            auto& cell_pieces = grid_cell->second;
+            auto position = std::find(cell_pieces.begin(), cell_pieces.end(), piece_id);
+            if (position != cell_pieces.end())
+            {
+                *position = cell_pieces.back();
+                cell_pieces.pop_back();
+            }
+            if (cell_pieces.empty())
+            {
+                grid.erase(grid_cell);
+            }
+        }
+
+        piece.cells.clear();
+        piece.points.clear();
+        free_pieces.push_back(piece_id);
+    }
+    entry.piece_ids.clear();
+}
+
+void MapPickIndex::set(const MapPickKey& key, const std::vector<MapPickShape>& shapes)
+{
+    Entry& entry = entries[key];
+    entry.sync_round = sync_rounds[key.kind];
+
+    if (entry.shapes == shapes) return;
+
+    remove_pieces(entry);
+    entry.shapes = shapes;
+
+    for (const auto& shape : shapes)
+    {
+        if (shape.type == MapPickShape::Polyline && shape.points.size() > max_piece_points)
+        {
+            //Consecutive pieces share their end / start point, s.t. no segment is lost
+            for (size_t start = 0; start + 1 < shape.points.size(); start += max_piece_points - 1)
+            {
+                size_t end = std::min(start + max_piece_points, shape.points.size());
+                insert_piece(key, shape.type, std::vector<std::pair<double, double>>(shape.points.begin() + start, shape.points.begin() + end), shape.radius, entry.piece_ids);
+            }
+        }
+        else
+        {
+            insert_piece(key, shape.type, shape.points, shape.radius, entry.piece_ids);
+        }
+    }
+}
+
+void MapPickIndex::remove(const MapPickKey& key)
+{
+    auto entry = entries.find(key);
+    if (entry == entries.end()) return;
+
+    remove_pieces(entry->second);
+    entries.erase(entry);
+}
+
+void MapPickIndex::begin_sync(MapPickKind kind)
+{
+    sync_rounds[kind] += 1;
+}
+
+void MapPickIndex::end_sync(MapPickKind kind)
+{
+    uint64_t round = sync_rounds[kind];
+
+    //Entries are ordered by kind first, so only the entries of this kind are visited
+    auto entry = entries.lower_bound(MapPickKey{kind, std::numeric_limits<int64_t>::min()});
+    while (entry != entries.end() && entry->first.kind == kind)
+    {
+        if (entry->second.sync_round != round)
+        {
+            remove_pieces(entry->second);
+            entry = entries.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
+
+void MapPickIndex::clear(MapPickKind kind)
+{
+    begin_sync(kind);
+    end_sync(kind);
+}
+
+/**
+ * \brief Distance of a point to a line segment
+ * \ingroup lcc_ui
+ */
+static double distance_to_segment(double x, double y, const std::pair<double, double>& a, const std::pair<double, double>& b)
+{
+    double dx = b.first - a.first;
+    double dy = b.second - a.second;
+    double length_sq = dx * dx + dy * dy;
+
+    double t = 0;
+    if (length_sq > 0)
+    {
+        t = ((x - a.first) * dx + (y - a.second) * dy) / length_sq;
+        t = std::max(0.0, std::min(1.0, t));
+    }
+
+    return std::hypot(x - (a.first + t * dx), y - (a.second + t * dy));
+}
+
+double MapPickIndex::distance_to_piece(const Piece& piece, double x, double y)
+{
+    const auto& points = piece.points;
+
+    if (piece.type == MapPickShape::Circle || points.size() == 1)
+    {
+        return std::hypot(x - points.front().first, y - points.front().second) - piece.radius;
+    }
+
+    bool closed = (piece.type == MapPickShape::Polygon);
+    double distance = std::numeric_limits<double>::infinity();
+    bool inside = false;
+    size_t segment_count = closed ? points.size() : points.size() - 1;
+    for (size_t i = 0; i < segment_count; ++i)
+    {
+        const auto& a = points[i];
+        const auto& b = points[(i + 1) % points.size()];
+        distance = std::min(distance, distance_to_segment(x, y, a, b));
+
+        //Ray casting for points within the polygon
+        if (closed && ((a.second > y) != (b.second > y)))
+        {
+            double crossing_x = a.first + (y - a.second) / (b.second - a.second) * (b.first - a.first);
+            if (x < crossing_x) inside = !inside;
+        }
+    }
+
+    if (closed)
+    {
+        return inside ? -distance : distance;
+    }
+    return distance - piece.radius;
+}
+
+std::vector<MapPickHit> MapPickIndex::pick(double x, double y, double tolerance)
+{
+    ++pick_count;
+    std::map<MapPickKey, double> distances;
+
+    auto test_piece = [&] (size_t piece_id) {
+        Piece& piece = pieces[piece_id];
+        if (piece.last_pick == pick_count) return;
+        piece.last_pick = pick_count;
+
+        double distance = distance_to_piece(piece, x, y);
+        if (distance > tolerance) return;
+
+        auto known = distances.find(piece.key);
+        if (known == distances.end())
+        {
+            distances.emplace(piece.key, distance);
+        }
+        else
+        {
+            known->second = std::min(known->second, distance);
+        }
+    };
+
+    int64_t cell_x_max = cell_index(x + tolerance);
+    int64_t cell_y_max = cell_index(y + tolerance);
+    for (int64_t cell_x = cell_index(x - tolerance); cell_x <= cell_x_max; ++cell_x)
+    {
+        for (int64_t cell_y = cell_index(y - tolerance); cell_y <= cell_y_max; ++cell_y)
+        {
+            auto grid_cell = grid.find(cell_key(static_cast<int32_t>(cell_x), static_cast<int32_t>(cell_y)));
+            if (grid_cell == grid.end()) continue;
+
+            for (size_t piece_id : grid_cell->second)
+            {
+                test_piece(piece_id);
+            }
+        }
+    }
+
+    for (size_t piece_id : large_pieces)
+    {
+        test_piece(piece_id);
+    }
+
+    std::vector<MapPickHit> hits;
+    for (const auto& entry : distances)
+    {
+        hits.push_back(MapPickHit{entry.first, entry.second});
+    }
+    std::stable_sort(hits.begin(), hits.end(), [] (const MapPickHit& a, const MapPickHit& b) {
+        return (a.key.kind != b.key.kind) ? (a.key.kind < b.key.kind) : (a.distance < b.distance);
+    });
+    return hits;
+}
+
+size_t MapPickIndex::size() const
+{
+    return entries.size();
+}
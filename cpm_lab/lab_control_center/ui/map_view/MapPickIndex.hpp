@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * \enum MapPickKind
+ * \brief Kinds of objects that can be picked in the map view. If several objects are hit, they are ordered by their kind (first one first).
+ * \ingroup lcc_ui
+ */
+enum class MapPickKind {
+    Vehicle, Obstacle, Visualization, PlanningProblem, Lanelet
+};
+
+/**
+ * \struct MapPickKey
+ * \brief Identifies an object in the map view, e.g. vehicle 3 or lanelet 120
+ * \ingroup lcc_ui
+ */
+struct MapPickKey {
+    //! Kind of the object
+    MapPickKind kind;
+    //! ID of the object, unique for its kind
+    int64_t id;
+
+    //! Order by kind, then by ID
+    bool operator<(const MapPickKey& other) const
+    {
+        return (kind != other.kind) ? (kind < other.kind) : (id < other.id);
+    }
+
+    //! Equality of kind and ID
+    bool operator==(const MapPickKey& other) const
+    {
+        return kind == other.kind && id == other.id;
+    }
+};
+
+/**
+ * \struct MapPickHit
+ * \brief An object that was hit when picking
+ * \ingroup lcc_ui
+ */
+struct MapPickHit {
+    //! The object that was hit
+    MapPickKey key;
+    //! Signed distance of the picked point to the object's shape, negative if the point lies within a circle / line / polygon
+    double distance;
+};
+
+/**
+ * \struct MapPickShape
+ * \brief Shape of (a part of) an object for picking, in map coordinates
+ * \ingroup lcc_ui
+ */
+struct MapPickShape {
+    //! Types of shapes
+    enum Type {
+        //! Circle around points[0] with the given radius (a point for radius 0)
+        Circle,
+        //! Polygon, closed automatically; points within it are hit as well
+        Polygon,
+        //! Line through all points with the given radius (half its width)
+        Polyline
+    };
+
+    //! Type of the shape
+    Type type = Circle;
+    //! Points of the shape, see Type
+    std::vector<std::pair<double, double>> points;
+    //! Radius of a circle / half the width of a polyline, ignored for polygons
+    double radius = 0;
+
+    //! Same type, points and radius
+    bool operator==(const MapPickShape& other) const
+    {
+        return type == other.type && radius == other.radius && points == other.points;
+    }
+};
+
+/**
+ * \class MapPickIndex
+ * \brief Spatial index for picking objects (vehicles, obstacles, lanelets...) in the map view, e.g. for hover tooltips.
+ *
+ * The shapes of the objects are stored in a uniform grid, so that a pick only tests the few shapes in the grid cells around the picked point.
+ * To keep the effort per tested shape small, polylines are split into pieces with a limited number of points, and large objects like
+ * lanelets should be given as several small polygons. Shapes that would cover too many cells are tested with every pick instead.
+ *
+ * The index is updated incrementally: Setting an object with unchanged shapes costs a comparison only, objects that were not set again
+ * between begin_sync and end_sync are removed. The class is not thread-safe, it is meant to be used by the UI thread only.
+ * \ingroup lcc_ui
+ */
+class MapPickIndex
+{
+    /**
+     * \brief Part of a shape that is stored in the grid
+     */
+    struct Piece {
+        //! Object the piece belongs to
+        MapPickKey key;
+        //! Type of the piece
+        MapPickShape::Type type;
+        //! Points of the piece
+        std::vector<std::pair<double, double>> points;
+        //! Radius of the piece
+        double radius;
+        //! Grid cells the piece is stored in; empty if it is in large_pieces
+        std::vector<uint64_t> cells;
+        //! Used to test each piece only once per pick
+        uint64_t last_pick = 0;
+    };
+
+    /**
+     * \brief An object in the index
+     */
+    struct Entry {
+        //! Shapes of the object, to detect changes
+        std::vector<MapPickShape> shapes;
+        //! Pieces of the object (indices into pieces)
+        std::vector<size_t> piece_ids;
+        //! Sync round in which the object was set last
+        uint64_t sync_round = 0;
+    };
+
+    //! Side length of a grid cell in m
+    const double cell_size;
+    //! Polylines are split into pieces with at most this many points
+    const size_t max_piece_points;
+    //! Pieces that would be stored in more cells than this are stored in large_pieces instead
+    const size_t max_piece_cells;
+
+    //! All objects in the index
+    std::map<MapPickKey, Entry> entries;
+    //! All pieces, unused slots are listed in free_pieces
+    std::vector<Piece> pieces;
+    //! Unused slots in pieces
+    std::vector<size_t> free_pieces;
+    //! Grid cell -> Pieces within the cell
+    std::unordered_map<uint64_t, std::vector<size_t>> grid;
+    //! Pieces that are too large for the grid, tested with every pick
+    std::vector<size_t> large_pieces;
+
+    //! Current sync round per kind, see begin_sync
+    std::map<MapPickKind, uint64_t> sync_rounds;
+    //! Number of the current pick, see Piece::last_pick
+    uint64_t pick_count = 0;
+
+    /**
+     * \brief Get the grid cell for a coordinate (cell index along one axis)
+     */
+    int32_t cell_index(double value) const;
+
+    /**
+     * \brief Combine the cell indices of both axes to the key used in grid
+     */
+    static uint64_t cell_key(int32_t x, int32_t y);
+
+    /**
+     * \brief Store a piece in the grid (or in large_pieces)
+     */
+    void insert_piece(const MapPickKey& key, MapPickShape::Type type, std::vector<std::pair<double, double>> points, double radius, std::vector<size_t>& piece_ids);
+
+    /**
+     * \brief Remove all pieces of an entry from the grid
+     */
+    void remove_pieces(Entry& entry);
+
+    /**
+     * \brief Signed distance of a point to a piece
+     */
+    static double distance_to_piece(const Piece& piece, double x, double y);
+
+public:
+    /**
+     * \brief Constructor
+     * \param _cell_size Side length of a grid cell in m, should be about the size of the smallest objects (vehicles)
+     * \param _max_piece_points Polylines are split into pieces with at most this many points
+     * \param _max_piece_cells Pieces that would be stored in more cells than this are tested with every pick instead
+     */
+    MapPickIndex(double _cell_size = 0.25, size_t _max_piece_points = 8, size_t _max_piece_cells = 4096);
+
+    /**
+     * \brief Add an object or replace its shapes. Nothing is changed if the shapes are the same as before.
+     * \param key The object
+     * \param shapes Shapes of the object in map coordinates
+     */
+    void set(const MapPickKey& key, const std::vector<MapPickShape>& shapes);
+
+    /**
+     * \brief Remove an object
+     * \param key The object
+     */
+    void remove(const MapPickKey& key);
+
+    /**
+     * \brief Start a new round of setting all objects of a kind, see end_sync
+     * \param kind Kind of the objects
+     */
+    void begin_sync(MapPickKind kind);
+
+    /**
+     * \brief Remove all objects of the kind that were not set since the last call of begin_sync
+     * \param kind Kind of the objects
+     */
+    void end_sync(MapPickKind kind);
+
+    /**
+     * \brief Remove all objects of a kind
+     * \param kind Kind of the objects
+     */
+    void clear(MapPickKind kind);
+
+    /**
+     * \brief Get all objects whose shapes are at most tolerance away from the given point
+     * \param x x coordinate in the map
+     * \param y y coordinate in the map
+     * \param tolerance Max. distance in m
+     * \return Objects that were hit, ordered by their kind and then by their distance
+     */
+    std::vector<MapPickHit> pick(double x, double y, double tolerance);
+
+    /**
+     * \brief Number of objects in the index
+     */
+    size_t size() const;
+};
@@ -0,0 +1,189 @@
+#include "MapViewProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+/**
+ * \file MapViewProfiler.cpp
+ * \ingroup lcc_ui
+ */
+
+MapViewProfiler::ScopedMeasurement::ScopedMeasurement(MapViewProfiler& _profiler, size_t _phase)
+:profiler(_profiler)
+,phase(_phase)
+,start(std::chrono::steady_clock::now())
+{
+
+}
+
+MapViewProfiler::ScopedMeasurement::~ScopedMeasurement()
+{
+    auto duration = std::chrono::steady_clock::now() - start;
+    profiler.record(phase, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+}
+
+MapViewProfiler::MapViewProfiler(std::vector<std::string> _phase_names, size_t _window_size, uint64_t _frame_period_ns)
+:window_size(std::max<size_t>(_window_size, 1))
+,frame_period_ns(_frame_period_ns)
+,phase_names(_phase_names)
+,phase_windows(_phase_names.size())
+{
+
+}
+
+void MapViewProfiler::add_to_window(Window& window, uint64_t value_ns)
+{
+    if (window.values_ns.size() < window_size)
+    {
+        window.values_ns.push_back(value_ns);
+    }
+    else
+    {
+        window.values_ns[window.next] = value_ns;
+        window.next = (window.next + 1) % window_size;
+    }
+    window.count += 1;
+}
+
+uint64_t MapViewProfiler::percentile(const std::vector<uint64_t>& sorted_values, double percent)
+{
+    if (sorted_values.empty()) return 0;
+
+    size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(sorted_values.size())));
+    rank = std::min(std::max<size_t>(rank, 1), sorted_values.size());
+    return sorted_values[rank - 1];
+}
+
+MapViewProfiler::ScopedMeasurement MapViewProfiler::measure(size_t phase)
+{
+    return ScopedMeasurement(*this, phase);
+}
+
+void MapViewProfiler::record(size_t phase, uint64_t duration_ns)
+{
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    if (phase >= phase_windows.size()) return;
+
+    add_to_window(phase_windows[phase], duration_ns);
+}
+
+void MapViewProfiler::frame(uint64_t t_now_ns)
+{
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+
+    if (last_frame_ns > 0 && t_now_ns > last_frame_ns)
+    {
+        uint64_t interval = t_now_ns - last_frame_ns;
+        add_to_window(frame_intervals, interval);
+
+        //E.g. 3 periods between two frames: The 2 frames in between were dropped; allow for some jitter
+        if (frame_period_ns > 0 && interval > frame_period_ns + frame_period_ns / 2)
+        {
+            dropped_frames += (interval + frame_period_ns / 2) / frame_period_ns - 1;
+        }
+    }
+    last_frame_ns = t_now_ns;
+}
+
+void MapViewProfiler::set_counter(const std::string& name, uint64_t value)
+{
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    counters[name] = value;
+}
+
+std::vector<MapViewProfiler::PhaseStatistics> MapViewProfiler::get_phase_statistics()
+{
+    //Copy the windows, s.t. the lock is not held while sorting
+    std::vector<Window> windows;
+    {
+        std::lock_guard<std::mutex> lock(profiler_mutex);
+        windows = phase_windows;
+    }
+
+    std::vector<PhaseStatistics> statistics;
+    for (size_t i = 0; i < windows.size(); ++i)
+    {
+        auto& values = windows[i].values_ns;
+        std::sort(values.begin(), values.end());
+
+        PhaseStatistics phase;
+        phase.name = phase_names[i];
+        phase.count = windows[i].count;
+        phase.p50_ms = percentile(values, 50) / 1e6;
+        phase.p90_ms = percentile(values, 90) / 1e6;
+        phase.p99_ms = percentile(values, 99) / 1e6;
+        phase.max_ms = percentile(values, 100) / 1e6;
+        statistics.push_back(phase);
+    }
+    return statistics;
+}
+
+MapViewProfiler::FrameStatistics MapViewProfiler::get_frame_statistics()
+{
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+
+    FrameStatistics statistics;
+    //The first frame has no interval
+    statistics.frames = (last_frame_ns > 0) ? frame_intervals.count + 1 : 0;
+    statistics.dropped_frames = dropped_frames;
+
+    uint64_t sum_ns = 0;
+    uint64_t max_ns = 0;
+    for (uint64_t interval : frame_intervals.values_ns)
+    {
+        sum_ns += interval;
+        max_ns = std::max(max_ns, interval);
+    }
+    if (sum_ns > 0)
+    {
+        statistics.frame_rate_hz = 1e9 * static_cast<double>(frame_intervals.values_ns.size()) / static_cast<double>(sum_ns);
+    }
+    statistics.max_interval_ms = max_ns / 1e6;
+
+    return statistics;
+}
+
+std::map<std::string, uint64_t> MapViewProfiler::get_counters()
+{
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    return counters;
+}
+
+void MapViewProfiler::write_report(std::ostream& stream)
+{
+    auto frames = get_frame_statistics();
+    auto phases = get_phase_statistics();
+    auto current_counters = get_counters();
+
+    stream << std::fixed << std::setprecision(3);
+    stream << "frames,frame_rate_hz,dropped_frames,max_interval_ms" << std::endl;
+    stream << frames.frames << "," << frames.frame_rate_hz << "," << frames.dropped_frames << "," << frames.max_interval_ms << std::endl;
+    stream << std::endl;
+
+    stream << "phase,count,p50_ms,p90_ms,p99_ms,max_ms" << std::endl;
+    for (const auto& phase : phases)
+    {
+        stream << phase.name << "," << phase.count << "," << phase.p50_ms << "," << phase.p90_ms << "," << phase.p99_ms << "," << phase.max_ms << std::endl;
+    }
+
+    if (!current_counters.empty())
+    {
+        stream << std::endl;
+        stream << "counter,value" << std::endl;
+        for (const auto& counter : current_counters)
+        {
+            stream << counter.first << "," << counter.second << std::endl;
+        }
+    }
+}
+
+bool MapViewProfiler::write_report(const std::string& filename)
+{
+    std::ofstream file(filename);
+    if (!file.good()) return false;
+
+    write_report(file);
+    return file.good();
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * \class MapViewProfiler
+ * \brief Measures the durations of the phases of the map view (data fetching, drawing of the layers, compositing...) and the frame rate,
+ * to find out which part makes the map view slow.
+ *
+ * Only the last window_size durations of each phase are kept, in a ring buffer, so that recording a duration is cheap and the
+ * percentiles follow the current situation. Percentiles are only computed when they are requested (see get_phase_statistics), e.g. for
+ * the overlay in the map view or for a report file, which allows to compare different builds (see write_report).
+ * All functions are thread-safe, as the layers of the map view are drawn in different threads.
+ * \ingroup lcc_ui
+ */
+class MapViewProfiler
+{
+public:
+    /**
+     * \brief Percentiles of the durations of a phase, in ms
+     */
+    struct PhaseStatistics {
+        //! Name of the phase
+        std::string name;
+        //! Total number of measurements (not only the ones in the window)
+        uint64_t count = 0;
+        //! Median
+        double p50_ms = 0;
+        //! 90th percentile
+        double p90_ms = 0;
+        //! 99th percentile
+        double p99_ms = 0;
+        //! Max. within the window
+        double max_ms = 0;
+    };
+
+    /**
+     * \brief Frame rate and dropped frames
+     */
+    struct FrameStatistics {
+        //! Total number of frames
+        uint64_t frames = 0;
+        //! Frame rate within the window in Hz
+        double frame_rate_hz = 0;
+        //! Total number of frames that were expected, but not drawn, because the time between two frames was too long
+        uint64_t dropped_frames = 0;
+        //! Max. time between two frames within the window, in ms
+        double max_interval_ms = 0;
+    };
+
+    /**
+     * \brief Measures the time from its creation until it is destroyed and records it for a phase
+     */
+    class ScopedMeasurement {
+        //! Profiler to record the duration with
+        MapViewProfiler& profiler;
+        //! Measured phase
+        size_t phase;
+        //! Time of creation
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        /**
+         * \brief Start the measurement
+         * \param _profiler Profiler to record the duration with
+         * \param _phase Index of the measured phase
+         */
+        ScopedMeasurement(MapViewProfiler& _profiler, size_t _phase);
+        ScopedMeasurement(const ScopedMeasurement&) = delete;
+        ScopedMeasurement& operator=(const ScopedMeasurement&) = delete;
+
+        /**
+         * \brief Stop the measurement and record the duration
+         */
+        ~ScopedMeasurement();
+    };
+
+private:
+    /**
+     * \brief Ring buffer of durations / intervals in ns
+     */
+    struct Window {
+        //! The values, at most window_size
+        std::vector<uint64_t> values_ns;
+        //! Position of the next value, if the window is full
+        size_t next = 0;
+        //! Total number of values that were added
+        uint64_t count = 0;
+    };
+
+    //! Number of values per phase that are used for the statistics
+    const size_t window_size;
+    //! Expected time between two frames in ns
+    const uint64_t frame_period_ns;
+
+    //! Names of the phases, by index
+    std::vector<std::string> phase_names;
+    //! Recent durations of the phases, by index
+    std::vector<Window> phase_windows;
+    //! Recent times between two frames
+    Window frame_intervals;
+    //! Time of the last frame in ns, 0 before the first frame
+    uint64_t last_frame_ns = 0;
+    //! Total number of dropped frames
+    uint64_t dropped_frames = 0;
+    //! Further values to show, e.g. counters of other components
+    std::map<std::string, uint64_t> counters;
+    //! Mutex for all data above
+    std::mutex profiler_mutex;
+
+    /**
+     * \brief Add a value to a window, profiler_mutex must be held
+     */
+    void add_to_window(Window& window, uint64_t value_ns);
+
+    /**
+     * \brief Get the value at a percentile of sorted values (nearest rank)
+     */
+    static uint64_t percentile(const std::vector<uint64_t>& sorted_values, double percent);
+
+public:
+    /**
+     * \brief Constructor
+     * \param _phase_names Names of the phases to measure; a phase is identified by its index in this list
+     * \param _window_size Number of recent values per phase that are used for the statistics
+     * \param _frame_period_ns Expected time between two frames in ns, frames are counted as dropped if the time between two frames is longer
+     */
+    MapViewProfiler(std::vector<std::string> _phase_names, size_t _window_size = 500, uint64_t _frame_period_ns = 20000000ull);
+
+    /**
+     * \brief Measure a phase until the returned object is destroyed
+     * \param phase Index of the phase
+     */
+    ScopedMeasurement measure(size_t phase);
+
+    /**
+     * \brief Record the duration of a phase
+     * \param phase Index of the phase
+     * \param duration_ns The duration in ns
+     */
+    void record(size_t phase, uint64_t duration_ns);
+
+    /**
+     * \brief Register a drawn frame, for the frame rate and the dropped frames
+     * \param t_now_ns Time of the frame in ns, frames with a time that is not newer than the last one are ignored for the interval
+     */
+    void frame(uint64_t t_now_ns);
+
+    /**
+     * \brief Set a counter of another component, which is shown with the statistics (e.g. frames dropped by the layer threads)
+     * \param name Name of the counter
+     * \param value Current value
+     */
+    void set_counter(const std::string& name, uint64_t value);
+
+    /**
+     * \brief Get the statistics of all phases, in the order of their indices
+     */
+    std::vector<PhaseStatistics> get_phase_statistics();
+
+    /**
+     * \brief Get the frame rate and dropped frames
+     */
+    FrameStatistics get_frame_statistics();
+
+    /**
+     * \brief Get all counters set with set_counter
+     */
+    std::map<std::string, uint64_t> get_counters();
+
+    /**
+     * \brief Write all statistics as CSV, s.t. the results of different builds can be compared
+     * \param stream Stream to write to
+     */
+    void write_report(std::ostream& stream);
+
+    /**
+     * \brief Write all statistics as CSV to a file, see write_report(std::ostream&)
+     * \param filename Path of the file, which is overwritten
+     * \return False if the file could not be written
+     */
+    bool write_report(const std::string& filename);
+};
@@ -2,6 +2,7 @@
 #include <cassert>
 #include <glibmm/main.h>
 #include <libxml++-2.6/libxml++/libxml++.h>
+#include <iomanip>
 #include <math.h>
 
 #include "TrajectoryInterpolation.hpp"
@@ -26,7 +27,8 @@ MapViewUi::MapViewUi(
     std::function<VehicleTrajectories()> _get_vehicle_trajectory_command_callback,
     std::function<VehiclePathTracking()> _get_vehicle_path_tracking_command_callback,
     std::function<std::vector<CommonroadObstacle>()> _get_obstacle_data,
-    std::function<std::vector<Visualization>()> _get_visualization_msgs_callback
+    std::function<std::vector<Visualization>()> _get_visualization_msgs_callback,
+    shared_ptr<VehiclePresenceTracker> _presence_tracker
 )
 :trajectoryCommand(_trajectoryCommand)
 ,commonroad_scenario(_commonroad_scenario)
@@ -35,6 +37,7 @@ MapViewUi::MapViewUi(
 ,get_vehicle_path_tracking_command_callback(_get_vehicle_path_tracking_command_callback)
 ,get_visualization_msgs_callback(_get_visualization_msgs_callback)
 ,get_obstacle_data(_get_obstacle_data)
+,presence_tracker(_presence_tracker)
 {
     //Create a drawing area to draw on (for showing vehicles, trajectories, obstacles etc.)
     drawingArea = Gtk::manage(new Gtk::DrawingArea());
@@ -47,6 +50,8 @@ MapViewUi::MapViewUi(
     image_map = Cairo::ImageSurface::create_from_png("ui/map_view/map.png");
     //image_arrow = Cairo::ImageSurface::create_from_png("ui/map_view/arrow.png");
     image_labcam = Cairo::ImageSurface::create_from_png("ui/map_view/labcam.png");
+
+    layer_renderer = std::unique_ptr<MapLayerRenderer>(new MapLayerRenderer(map_layer_count));
     
     update_dispatcher.connect([&](){ 
         //Pan depending on key press
@@ -55,10 +60,62 @@ MapViewUi::MapViewUi(
         if (key_left) pan_x += key_move;
         if (key_right) pan_x -= key_move;
 
-        vehicle_data = this->get_vehicle_data();
+        {
+            auto measurement = measure(ProfiledPhase::FetchVehicleData);
+            vehicle_data = this->get_vehicle_data();
+        }
+
+        //Only ask for the online vehicles if they changed
+        if (presence_changed.exchange(false))
+        {
+            auto online_ids = presence_tracker->get_online_vehicle_ids();
+            online_vehicle_ids = std::set<uint8_t>(online_ids.begin(), online_ids.end());
+        }
+
+        if (get_obstacle_data)
+        {
+            auto measurement = measure(ProfiledPhase::FetchObstacles);
+            obstacle_data = get_obstacle_data();
+        }
+        {
+            auto measurement = measure(ProfiledPhase::FetchVisualizations);
+            visualization_data = get_visualization_msgs_callback();
+        }
+        {
+            auto measurement = measure(ProfiledPhase::FetchTrajectories);
+            vehicle_trajectories = get_vehicle_trajectory_command_callback();
+        }
+        {
+            auto measurement = measure(ProfiledPhase::FetchPathTracking);
+            vehicle_path_tracking = get_vehicle_path_tracking_command_callback();
+        }
+        {
+            auto measurement = measure(ProfiledPhase::UpdatePickIndex);
+            update_pick_index();
+        }
+
+        //Keep the values in a shown tooltip up to date (every 200ms)
+        if (++tooltip_tick % 10 == 0)
+        {
+            drawingArea->trigger_tooltip_query();
+        }
+
+        {
+            auto measurement = measure(ProfiledPhase::RequestLayers);
+            request_layers();
+        }
         drawingArea->queue_draw(); 
     });
 
+    presence_changed.store(false);
+    if (presence_tracker)
+    {
+        presence_changed.store(true);
+        presence_subscription_id = presence_tracker->subscribe([&](const VehiclePresenceTracker::VehiclePresence&, VehiclePresenceTracker::PresenceChange){
+            presence_changed.store(true);
+        });
+    }
+
     run_draw_thread.store(true);
     draw_loop_thread = std::thread([&](){
         while(run_draw_thread.load()) {
@@ -76,6 +133,20 @@ MapViewUi::MapViewUi(
 
     drawingArea->set_can_focus(true);
 
+    //Show the objects under the mouse and their current values in a tooltip
+    drawingArea->set_has_tooltip(true);
+    drawingArea->signal_query_tooltip().connect([&](int x, int y, bool keyboard_tooltip, const Glib::RefPtr<Gtk::Tooltip>& tooltip) {
+        //Do not distract the user while painting a path or dragging the view
+        if (keyboard_tooltip || mouse_left_button || mouse_right_button) return false;
+
+        auto position = canvas_to_world(x, y);
+        std::string text = get_tooltip_text(position.first, position.second);
+        if (text.empty()) return false;
+
+        tooltip->set_text(text);
+        return true;
+    });
+
     //Store initial zoom factor in the draw config. of commonroad
     if (commonroad_scenario)
     {
@@ -129,6 +200,18 @@ MapViewUi::MapViewUi(
             if (event->keyval == GDK_KEY_Left) key_left = true;
             if (event->keyval == GDK_KEY_Right) key_right = true;
 
+            //Profiler: F2 shows / hides the overlay, F3 writes the statistics to a file
+            if (event->keyval == GDK_KEY_F2)
+            {
+                show_profiler_overlay = !show_profiler_overlay;
+                return true;
+            }
+            if (event->keyval == GDK_KEY_F3)
+            {
+                write_profile_report();
+                return true;
+            }
+
             if (key_up || key_down || key_left || key_right) return true; //Signal was handled
         }
         return false; //Propagate signal
@@ -201,14 +284,9 @@ MapViewUi::MapViewUi(
     });
 
     drawingArea->signal_motion_notify_event().connect([&](GdkEventMotion* event) {
-        // Transform mouse-event from canvas coordinates into world coordinates by reversing all steps done while drawing (compare (*))
-        // Rotation around z-axis corresponds to the following matrix multiplication [x'] = [cos(a) -sin(a)] * [x]
-        //                                                                           [y']   [sin(a)  cos(a)]   [y]
-        double event_x =  ((event->x - pan_x) / zoom) - rotation_fixpoint_x;
-        double event_y = -((event->y - pan_y) / zoom) - rotation_fixpoint_y;
-        mouse_x =  (cos(-rotation)*event_x - sin(-rotation)*event_y) + rotation_fixpoint_x;
-        mouse_y =  (sin(-rotation)*event_x + cos(-rotation)*event_y) + rotation_fixpoint_y;
-
+        auto mouse_position = canvas_to_world(event->x, event->y);
+        mouse_x = mouse_position.first;
+        mouse_y = mouse_position.second;
 
         vehicle_id_in_focus = find_vehicle_id_in_focus();
 
@@ -326,99 +404,529 @@ MapViewUi::MapViewUi(
     //This is done in signal_draw(), because in the constructor the width and height value of the drawing area are not yet set to their final value
 }
 
+bool MapViewUi::is_vehicle_online(uint8_t vehicle_id, const map<string, shared_ptr<TimeSeries>>& vehicle_timeseries)
+{
+    if (presence_tracker)
+    {
+        return online_vehicle_ids.count(vehicle_id) > 0;
+    }
+
+    return vehicle_timeseries.at("pose_x")->has_new_data(1.0);
+}
+
+std::pair<double, double> MapViewUi::canvas_to_world(double canvas_x, double canvas_y)
+{
+    // Transform from canvas coordinates into world coordinates by reversing all steps done while drawing (compare (*))
+    // Rotation around z-axis corresponds to the following matrix multiplication [x'] = [cos(a) -sin(a)] * [x]
+    //                                                                           [y']   [sin(a)  cos(a)]   [y]
+    double event_x =  ((canvas_x - pan_x) / zoom) - rotation_fixpoint_x;
+    double event_y = -((canvas_y - pan_y) / zoom) - rotation_fixpoint_y;
+    return std::make_pair(
+        (inverse_rotation_cos*event_x - inverse_rotation_sin*event_y) + rotation_fixpoint_x,
+        (inverse_rotation_sin*event_x + inverse_rotation_cos*event_y) + rotation_fixpoint_y
+    );
+}
+
 int MapViewUi::find_vehicle_id_in_focus()
 {
-    int id = -1;
-    double dist_sq_min = 1e300;
+    //Vehicles are the first kind of hits, the closest one comes first
+    auto hits = pick_index.pick(mouse_x, mouse_y, 0.0);
+    if (hits.size() > 0 && hits.front().key.kind == MapPickKind::Vehicle && vehicle_data.count(static_cast<uint8_t>(hits.front().key.id)) > 0)
+    {
+        return static_cast<int>(hits.front().key.id);
+    }
+    return -1;
+}
+
+void MapViewUi::update_pick_index()
+{
+    //Vehicles: Same radius as the focus disk
+    pick_index.begin_sync(MapPickKind::Vehicle);
+    for (const auto& entry : vehicle_data)
+    {
+        if (!is_vehicle_online(entry.first, entry.second)) continue;
+
+        MapPickShape shape;
+        shape.points.push_back(std::make_pair(entry.second.at("pose_x")->get_latest_value(), entry.second.at("pose_y")->get_latest_value()));
+        shape.radius = 0.2;
+        pick_index.set(MapPickKey{MapPickKind::Vehicle, entry.first}, {shape});
+    }
+    pick_index.end_sync(MapPickKind::Vehicle);
+
+    //Obstacles: Shapes are given relative to the obstacle's pose, as in draw_commonroad_obstacles
+    pick_index.begin_sync(MapPickKind::Obstacle);
+    for (auto& entry : obstacle_data)
+    {
+        const double pose_x = entry.pose().x();
+        const double pose_y = entry.pose().y();
+        const double pose_cos = std::cos(entry.pose().yaw());
+        const double pose_sin = std::sin(entry.pose().yaw());
+        auto to_world = [&] (double x, double y) {
+            return std::make_pair(pose_x + pose_cos * x - pose_sin * y, pose_y + pose_sin * x + pose_cos * y);
+        };
+
+        std::vector<MapPickShape> shapes;
+        for (auto& circle : entry.shape().circles())
+        {
+            MapPickShape shape;
+            shape.points.push_back(to_world(circle.center().x(), circle.center().y()));
+            shape.radius = circle.radius();
+            shapes.push_back(shape);
+        }
+        for (auto& polygon : entry.shape().polygons())
+        {
+            if (polygon.points().size() < 3) continue;
+
+            MapPickShape shape;
+            shape.type = MapPickShape::Polygon;
+            for (auto& point : polygon.points())
+            {
+                shape.points.push_back(to_world(point.x(), point.y()));
+            }
+            shapes.push_back(shape);
+        }
+        for (auto& rectangle : entry.shape().rectangles())
+        {
+            const double rectangle_cos = std::cos(rectangle.orientation());
+            const double rectangle_sin = std::sin(rectangle.orientation());
+            const double half_length = rectangle.length() / 2;
+            const double half_width = rectangle.width() / 2;
+
+            MapPickShape shape;
+            shape.type = MapPickShape::Polygon;
+            for (auto corner : {std::make_pair(-1.0, -1.0), std::make_pair(-1.0, 1.0), std::make_pair(1.0, 1.0), std::make_pair(1.0, -1.0)})
+            {
+                double x = corner.first * half_length;
+                double y = corner.second * half_width;
+                shape.points.push_back(to_world(
+                    rectangle.center().x() + rectangle_cos * x - rectangle_sin * y,
+                    rectangle.center().y() + rectangle_sin * x + rectangle_cos * y
+                ));
+            }
+            shapes.push_back(shape);
+        }
 
-    for(const auto& entry : vehicle_data) {
-        const auto vehicle_id = entry.first;
-        const auto& vehicle_timeseries = entry.second;
+        pick_index.set(MapPickKey{MapPickKind::Obstacle, entry.vehicle_id()}, shapes);
+    }
+    pick_index.end_sync(MapPickKind::Obstacle);
 
-        if(!vehicle_timeseries.at("pose_x")->has_new_data(1.0)) continue;
+    //Visualizations: As drawn in draw_received_visualization_commands
+    pick_index.begin_sync(MapPickKind::Visualization);
+    for (const auto& entry : visualization_data)
+    {
+        if (entry.points().size() == 0) continue;
 
-        double dx = mouse_x - vehicle_timeseries.at("pose_x")->get_latest_value();
-        double dy = mouse_y - vehicle_timeseries.at("pose_y")->get_latest_value();
+        MapPickShape shape;
+        for (const auto& point : entry.points())
+        {
+            shape.points.push_back(std::make_pair(point.x(), point.y()));
+        }
 
-        double dist_sq = dx*dx + dy*dy;
-        if(dist_sq < 0.04 && dist_sq < dist_sq_min)
+        if (entry.type() == VisualizationType::FilledCircle)
+        {
+            shape.points.resize(1);
+            shape.radius = entry.size();
+        }
+        else if (entry.type() == VisualizationType::StringMessage)
+        {
+            //The text extents are only known while drawing, so only its anchor point can be picked
+            shape.points.resize(1);
+            shape.radius = 0.05;
+        }
+        else if (entry.points().size() < 2)
         {
-            id = vehicle_id;
-            dist_sq_min = dist_sq;
+            continue;
         }
+        else
+        {
+            shape.type = (entry.type() == VisualizationType::Polygon) ? MapPickShape::Polygon : MapPickShape::Polyline;
+            shape.radius = entry.size() / 2;
+        }
+
+        //IDs are unsigned, but far below the int64 range in practice
+        pick_index.set(MapPickKey{MapPickKind::Visualization, static_cast<int64_t>(entry.id())}, {shape});
     }
-    return id;
+    pick_index.end_sync(MapPickKind::Visualization);
+
+    //Lanelets and planning problems only change with the scenario, which is expensive to copy, so only update them if it changed
+    if (!commonroad_scenario) return;
+    uint64_t geometry_version = commonroad_scenario->get_geometry_version();
+    if (pick_geometry_valid && geometry_version == pick_geometry_version) return;
+
+    std::map<int, std::vector<std::vector<std::pair<double, double>>>> lanelet_segments;
+    std::map<int, std::vector<std::pair<double, double>>> planning_problem_positions;
+    if (!commonroad_scenario->get_pick_geometry(lanelet_segments, planning_problem_positions))
+    {
+        //The scenario is currently being changed, try again in the next tick
+        return;
+    }
+
+    pick_index.begin_sync(MapPickKind::Lanelet);
+    for (const auto& lanelet : lanelet_segments)
+    {
+        std::vector<MapPickShape> shapes;
+        for (const auto& segment : lanelet.second)
+        {
+            MapPickShape shape;
+            shape.type = MapPickShape::Polygon;
+            shape.points = segment;
+            shapes.push_back(shape);
+        }
+        pick_index.set(MapPickKey{MapPickKind::Lanelet, lanelet.first}, shapes);
+    }
+    pick_index.end_sync(MapPickKind::Lanelet);
+
+    pick_index.begin_sync(MapPickKind::PlanningProblem);
+    for (const auto& planning_problem : planning_problem_positions)
+    {
+        std::vector<MapPickShape> shapes;
+        for (const auto& position : planning_problem.second)
+        {
+            MapPickShape shape;
+            shape.points.push_back(position);
+            shape.radius = 0.1;
+            shapes.push_back(shape);
+        }
+        pick_index.set(MapPickKey{MapPickKind::PlanningProblem, planning_problem.first}, shapes);
+    }
+    pick_index.end_sync(MapPickKind::PlanningProblem);
+
+    //The version might have changed again while the geometry was copied, which is then caught in the next tick
+    pick_geometry_version = geometry_version;
+    pick_geometry_valid = true;
 }
 
-void MapViewUi::draw(const DrawingContext& ctx)
+std::string MapViewUi::get_tooltip_text(double x, double y)
 {
-    ctx->save();
-    {   
-        // transforming (*)
-        ctx->translate(pan_x, pan_y);
-        ctx->scale(zoom, -zoom);
-        
-        // rotate mapview without changing the center of the map
-        ctx->translate(rotation_fixpoint_x,rotation_fixpoint_y);
-        ctx->rotate(rotation);
-        ctx->translate(-rotation_fixpoint_x,-rotation_fixpoint_y);       
+    //Tolerance of a few pixels, s.t. thin lines can be hovered as well
+    auto hits = pick_index.pick(x, y, 4.0 / zoom);
 
-        //draw_grid(ctx);
-        //Draw map
-        if (commonroad_scenario)
+    std::map<uint8_t, VehiclePresenceTracker::VehiclePresence> presence;
+    if (presence_tracker)
+    {
+        presence = presence_tracker->get_presence();
+    }
+
+    //Only list the first (most relevant) hits, e.g. not all lanelets below a vehicle
+    const size_t max_hits = 5;
+    std::stringstream text;
+    text << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < hits.size() && i < max_hits; ++i)
+    {
+        const auto& key = hits.at(i).key;
+        if (i > 0) text << "\n";
+
+        switch (key.kind)
         {
-            commonroad_scenario->draw(ctx);
+            case MapPickKind::Vehicle:
+            {
+                uint8_t vehicle_id = static_cast<uint8_t>(key.id);
+                text << "Vehicle " << static_cast<int>(vehicle_id);
+
+                auto vehicle_presence = presence.find(vehicle_id);
+                if (vehicle_presence != presence.end())
+                {
+                    text << (vehicle_presence->second.is_real ? " (real, " : " (simulated, ");
+                    text << std::setprecision(0) << vehicle_presence->second.message_rate_hz << " Hz)" << std::setprecision(2);
+                }
+
+                auto vehicle = vehicle_data.find(vehicle_id);
+                if (vehicle != vehicle_data.end())
+                {
+                    auto speed = vehicle->second.find("speed");
+                    if (speed != vehicle->second.end() && speed->second->has_new_data(1.0))
+                    {
+                        text << ", " << speed->second->get_latest_value() << " m/s";
+                    }
+                    auto battery_level = vehicle->second.find("battery_level");
+                    if (battery_level != vehicle->second.end() && battery_level->second->has_new_data(1.0))
+                    {
+                        text << ", battery " << std::setprecision(0) << battery_level->second->get_latest_value() << " %" << std::setprecision(2);
+                    }
+                }
+                break;
+            }
+            case MapPickKind::Obstacle:
+            {
+                text << "Obstacle " << key.id;
+                for (auto& obstacle : obstacle_data)
+                {
+                    if (obstacle.vehicle_id() != key.id) continue;
+
+                    text << (obstacle.is_moving() ? " (moving, " : " (static, ") << obstacle.speed() << " m/s)";
+                    break;
+                }
+                break;
+            }
+            case MapPickKind::Visualization:
+            {
+                text << "Visualization " << key.id;
+                for (const auto& visualization : visualization_data)
+                {
+                    if (static_cast<int64_t>(visualization.id()) != key.id) continue;
+
+                    if (visualization.type() == VisualizationType::StringMessage)
+                    {
+                        text << ": " << visualization.string_message();
+                    }
+                    break;
+                }
+                break;
+            }
+            case MapPickKind::PlanningProblem:
+                text << "Planning problem " << key.id;
+                break;
+            case MapPickKind::Lanelet:
+                text << "Lanelet " << key.id;
+                break;
         }
+    }
+
+    if (hits.size() > max_hits)
+    {
+        text << "\n(" << (hits.size() - max_hits) << " more)";
+    }
+
+    return text.str();
+}
+
+Cairo::Matrix MapViewUi::get_view_matrix()
+{
+    // transforming (*)
+    Cairo::Matrix view = Cairo::identity_matrix();
+    view.translate(pan_x, pan_y);
+    view.scale(zoom, -zoom);
+
+    // rotate mapview without changing the center of the map
+    view.translate(rotation_fixpoint_x,rotation_fixpoint_y);
+    view.rotate(rotation);
+    view.translate(-rotation_fixpoint_x,-rotation_fixpoint_y);
 
-        // Draw vehicle focus disk
-        if(vehicle_id_in_focus >= 0 && path_painting_in_progress_vehicle_id < 0)
+    return view;
+}
+
+void MapViewUi::request_layers()
+{
+    const int width = drawingArea->get_allocated_width();
+    const int height = drawingArea->get_allocated_height();
+    const Cairo::Matrix view = get_view_matrix();
+
+    //Only the snapshot may be used by the layer threads, the members are changed by the UI thread in the meantime
+    auto frame = std::make_shared<MapViewFrame>();
+    frame->vehicle_data = vehicle_data;
+    for (const auto& entry : vehicle_data)
+    {
+        if (is_vehicle_online(entry.first, entry.second))
         {
-            ctx->set_source_rgba(0,0,1,0.4);
-            ctx->arc(
-                vehicle_data.at(vehicle_id_in_focus).at("pose_x")->get_latest_value(),
-                vehicle_data.at(vehicle_id_in_focus).at("pose_y")->get_latest_value(),
-                0.2, 0.0, 2 * M_PI
-            );
-            ctx->fill();
+            frame->online_vehicle_ids.push_back(entry.first);
+        }
+    }
+    frame->vehicle_trajectories = vehicle_trajectories;
+    frame->vehicle_path_tracking = vehicle_path_tracking;
+    frame->obstacle_data = obstacle_data;
+    frame->visualization_data = visualization_data;
+    frame->zoom = zoom;
+    frame->rotation = rotation;
+    frame->t_now = cpm::get_time_ns();
+    std::shared_ptr<const MapViewFrame> const_frame = frame;
+
+    layer_renderer->request(static_cast<size_t>(MapLayer::Map), view, width, height, [this] (const DrawingContext& ctx) {
+        auto measurement = measure(ProfiledPhase::DrawMap);
+
+        //draw_grid(ctx);
+        //The scenario uses its own (try-)locks, so it can be drawn in another thread
+        if (commonroad_scenario)
+        {
+            commonroad_scenario->draw(ctx);
         }
 
         draw_lab_boundaries(ctx);
 
         draw_labcam(ctx);
+    });
 
-        draw_received_trajectory_commands(ctx);
+    layer_renderer->request(static_cast<size_t>(MapLayer::Trajectories), view, width, height, [this, const_frame] (const DrawingContext& ctx) {
+        auto measurement = measure(ProfiledPhase::DrawTrajectories);
 
-        draw_received_path_tracking_commands(ctx);
+        draw_received_trajectory_commands(ctx, *const_frame);
 
-        for(const auto& entry : vehicle_data) {
-            //const auto vehicle_id = entry.first;
-            const auto& vehicle_timeseries = entry.second;
+        draw_received_path_tracking_commands(ctx, *const_frame);
 
-            if(vehicle_timeseries.at("pose_x")->has_new_data(1.0))
-            {
-                draw_vehicle_past_trajectory(ctx, vehicle_timeseries);
-            }
+        for (const auto vehicle_id : const_frame->online_vehicle_ids)
+        {
+            draw_vehicle_past_trajectory(ctx, const_frame->vehicle_data.at(vehicle_id));
         }
+    });
 
-        draw_received_visualization_commands(ctx);
+    layer_renderer->request(static_cast<size_t>(MapLayer::Visualizations), view, width, height, [this, const_frame] (const DrawingContext& ctx) {
+        auto measurement = measure(ProfiledPhase::DrawVisualizations);
+        draw_received_visualization_commands(ctx, *const_frame);
+    });
 
-        draw_commonroad_obstacles(ctx);
+    layer_renderer->request(static_cast<size_t>(MapLayer::Obstacles), view, width, height, [this, const_frame] (const DrawingContext& ctx) {
+        auto measurement = measure(ProfiledPhase::DrawObstacles);
+        draw_commonroad_obstacles(ctx, *const_frame);
+    });
 
-        draw_path_painting(ctx);
+    layer_renderer->request(static_cast<size_t>(MapLayer::Vehicles), view, width, height, [this, const_frame] (const DrawingContext& ctx) {
+        auto measurement = measure(ProfiledPhase::DrawVehicles);
 
-        for(const auto& entry : vehicle_data) {
-            const auto vehicle_id = entry.first;
-            const auto& vehicle_timeseries = entry.second;
+        for (const auto vehicle_id : const_frame->online_vehicle_ids)
+        {
+            draw_vehicle_body(ctx, *const_frame, const_frame->vehicle_data.at(vehicle_id), vehicle_id);
+        }
+    });
+}
 
-            if(vehicle_timeseries.at("pose_x")->has_new_data(1.0))
-            {
-                draw_vehicle_body(ctx, vehicle_timeseries, vehicle_id);
-            }
+void MapViewUi::draw(const DrawingContext& ctx)
+{
+    const uint64_t t_draw_start = cpm::get_time_ns();
+    profiler.frame(t_draw_start);
+
+    const Cairo::Matrix view = get_view_matrix();
+
+    layer_renderer->paint(ctx, static_cast<size_t>(MapLayer::Map), view);
+
+    // Draw vehicle focus disk
+    if(vehicle_id_in_focus >= 0 && path_painting_in_progress_vehicle_id < 0)
+    {
+        ctx->save();
+        ctx->transform(view);
+        ctx->set_source_rgba(0,0,1,0.4);
+        ctx->arc(
+            vehicle_data.at(vehicle_id_in_focus).at("pose_x")->get_latest_value(),
+            vehicle_data.at(vehicle_id_in_focus).at("pose_y")->get_latest_value(),
+            0.2, 0.0, 2 * M_PI
+        );
+        ctx->fill();
+        ctx->restore();
+    }
+
+    layer_renderer->paint(ctx, static_cast<size_t>(MapLayer::Trajectories), view);
+
+    layer_renderer->paint(ctx, static_cast<size_t>(MapLayer::Visualizations), view);
+
+    layer_renderer->paint(ctx, static_cast<size_t>(MapLayer::Obstacles), view);
+
+    ctx->save();
+    ctx->transform(view);
+    draw_path_painting(ctx);
+    ctx->restore();
+
+    layer_renderer->paint(ctx, static_cast<size_t>(MapLayer::Vehicles), view);
+
+    //The overlay itself is not measured, s.t. showing it does not change the results
+    profiler.record(static_cast<size_t>(ProfiledPhase::Composite), cpm::get_time_ns() - t_draw_start);
+    if (show_profiler_overlay)
+    {
+        draw_profiler_overlay(ctx);
+    }
+}
+
+MapViewProfiler::ScopedMeasurement MapViewUi::measure(ProfiledPhase phase)
+{
+    return profiler.measure(static_cast<size_t>(phase));
+}
+
+void MapViewUi::update_profiler_counters()
+{
+    const std::vector<std::string> layer_names = {"map", "trajectories", "visualizations", "obstacles", "vehicles"};
+    for (size_t layer = 0; layer < map_layer_count; ++layer)
+    {
+        profiler.set_counter("dropped_frames_" + layer_names.at(layer), layer_renderer->get_dropped_frames(layer));
+    }
+}
+
+void MapViewUi::draw_profiler_overlay(const DrawingContext& ctx)
+{
+    //Update the text only every 500ms, s.t. it can be read
+    const uint64_t t_now = cpm::get_time_ns();
+    if (profiler_overlay_lines.empty() || t_now >= profiler_overlay_update_time + 500000000ull)
+    {
+        profiler_overlay_update_time = t_now;
+        update_profiler_counters();
+
+        auto frames = profiler.get_frame_statistics();
+        std::stringstream frame_stream;
+        frame_stream << std::fixed << std::setprecision(1)
+            << frames.frame_rate_hz << " fps, " << frames.dropped_frames << " dropped, max. interval " << frames.max_interval_ms << " ms";
+
+        //Counters are named dropped_frames_<layer>, see update_profiler_counters
+        const std::string counter_prefix = "dropped_frames_";
+        std::stringstream layer_stream;
+        layer_stream << "Dropped by layers:";
+        for (const auto& counter : profiler.get_counters())
+        {
+            layer_stream << " " << counter.first.substr(counter_prefix.size()) << " " << counter.second;
         }
+
+        profiler_overlay_lines.clear();
+        profiler_overlay_lines.push_back(frame_stream.str());
+        profiler_overlay_lines.push_back(layer_stream.str());
+        profiler_overlay_lines.push_back("phase [ms]               p50     p90     p99     max");
+        for (const auto& phase : profiler.get_phase_statistics())
+        {
+            std::stringstream phase_stream;
+            phase_stream << std::left << std::setw(22) << phase.name << std::right << std::fixed << std::setprecision(2)
+                << std::setw(8) << phase.p50_ms
+                << std::setw(8) << phase.p90_ms
+                << std::setw(8) << phase.p99_ms
+                << std::setw(8) << phase.max_ms;
+            profiler_overlay_lines.push_back(phase_stream.str());
+        }
+    }
+
+    //Drawn in canvas coordinates, s.t. the overlay does not move with the view
+    const double font_size = 12;
+    const double line_height = 15;
+    const double margin = 10;
+    const double padding = 5;
+
+    ctx->save();
+    ctx->select_font_face("monospace", Cairo::FONT_SLANT_NORMAL, Cairo::FONT_WEIGHT_NORMAL);
+    ctx->set_font_size(font_size);
+
+    double width = 0;
+    for (const auto& line : profiler_overlay_lines)
+    {
+        Cairo::TextExtents extents;
+        ctx->get_text_extents(line, extents);
+        width = std::max(width, extents.x_advance);
+    }
+
+    ctx->set_source_rgba(1, 1, 1, 0.8);
+    ctx->rectangle(margin, margin, width + 2 * padding, line_height * profiler_overlay_lines.size() + 2 * padding);
+    ctx->fill();
+
+    ctx->set_source_rgb(0, 0, 0);
+    for (size_t i = 0; i < profiler_overlay_lines.size(); ++i)
+    {
+        ctx->move_to(margin + padding, margin + padding + line_height * (i + 1) - (line_height - font_size));
+        ctx->show_text(profiler_overlay_lines.at(i));
     }
     ctx->restore();
 }
 
+void MapViewUi::set_profiler(bool show_overlay, std::string report_file, bool write_on_exit)
+{
+    show_profiler_overlay = show_overlay;
+    profile_report_file = report_file;
+    write_profile_on_exit = write_on_exit;
+}
+
+bool MapViewUi::write_profile_report()
+{
+    update_profiler_counters();
+    if (!profiler.write_report(profile_report_file))
+    {
+        CPM_LOG(2, "Could not write the map view profile to %s", profile_report_file.c_str());
+        return false;
+    }
+
+    CPM_LOG(3, "Wrote the map view profile to %s", profile_report_file.c_str());
+    return true;
+}
+
 void MapViewUi::draw_lab_boundaries(const DrawingContext& ctx)
 {
     ctx->save();
@@ -455,21 +963,19 @@ void MapViewUi::draw_lab_boundaries(const DrawingContext& ctx)
     ctx->restore();
 }
 
-void MapViewUi::draw_received_trajectory_commands(const DrawingContext& ctx)
+void MapViewUi::draw_received_trajectory_commands(const DrawingContext& ctx, const MapViewFrame& frame)
 {
-    VehicleTrajectories vehicleTrajectories = get_vehicle_trajectory_command_callback();
-
     ctx->save();
-    for(const auto& entry : vehicleTrajectories) 
+    for(const auto& entry : frame.vehicle_trajectories) 
     {
         //const auto vehicle_id = entry.first;
-        const auto& trajectory = entry.second;
+        const auto& trajectory = *(entry.second);
 
-        rti::core::vector<TrajectoryPoint> trajectory_segment = trajectory.trajectory_points();
+        const rti::core::vector<TrajectoryPoint>& trajectory_segment = trajectory.trajectory_points();
         
         if(trajectory_segment.size() < 2 ) continue;
         
-        uint64_t t_now = cpm::get_time_ns();
+        uint64_t t_now = frame.t_now;
 
         ctx->set_line_width(0.01);
 
@@ -545,16 +1051,14 @@ void MapViewUi::draw_received_trajectory_commands(const DrawingContext& ctx)
     ctx->restore();
 }
 
-void MapViewUi::draw_received_path_tracking_commands(const DrawingContext& ctx)
+void MapViewUi::draw_received_path_tracking_commands(const DrawingContext& ctx, const MapViewFrame& frame)
 {
-    VehiclePathTracking vehiclePathTracking = get_vehicle_path_tracking_command_callback();
-
     ctx->save();
-    for(const auto& entry : vehiclePathTracking) 
+    for(const auto& entry : frame.vehicle_path_tracking) 
     {
-        const auto& command = entry.second;
+        const auto& command = *(entry.second);
 
-        rti::core::vector<PathPoint> path = command.path();
+        const rti::core::vector<PathPoint>& path = command.path();
         
         if(path.size() < 2 ) continue;
 
@@ -687,11 +1191,8 @@ void get_text_offset(Cairo::TextExtents ext, StringMessageAnchor anchor, double&
 
 
 //Draw all received viz commands on the screen
-void MapViewUi::draw_received_visualization_commands(const DrawingContext& ctx) {
-    //Get commands
-    std::vector<Visualization> visualization_commands = get_visualization_msgs_callback();
-
-    for(const auto& entry : visualization_commands) 
+void MapViewUi::draw_received_visualization_commands(const DrawingContext& ctx, const MapViewFrame& frame) {
+    for(const auto& entry : frame.visualization_data) 
     {
         if ((entry.type() == VisualizationType::LineStrips || 
              entry.type() == VisualizationType::Polygon    ||
@@ -712,7 +1213,7 @@ void MapViewUi::draw_received_visualization_commands(const DrawingContext& ctx)
             }
             else if(entry.points().size() < 2) // type definitely is LineStrips or Polygon
             {
-                cpm::Logging::Instance().write(1, "%s", "WARNING: Visualisation of Polygon or LineStrips with < 2 points");
+                CPM_LOG(1, "%s", "WARNING: Visualisation of Polygon or LineStrips with < 2 points");
             }
             else
             {
@@ -746,13 +1247,13 @@ void MapViewUi::draw_received_visualization_commands(const DrawingContext& ctx)
             // Secondly, apply rotation matrix to text_offset so that offset is correclty applied dependent on the map view rotation.
             double text_offset_left, text_offset_right;
             get_text_offset(ext, entry.string_message_anchor(), text_offset_left, text_offset_right);
-            double text_offset_x = (cos(-rotation)*text_offset_left - sin(-rotation)*text_offset_right);
-            double text_offset_y = (sin(-rotation)*text_offset_left + cos(-rotation)*text_offset_right);
+            double text_offset_x = (cos(-frame.rotation)*text_offset_left - sin(-frame.rotation)*text_offset_right);
+            double text_offset_y = (sin(-frame.rotation)*text_offset_left + cos(-frame.rotation)*text_offset_right);
 
             // Move to the correct position and rotate so that text is shown horizontally
             ctx->translate(entry.points().at(0).x() + text_offset_x, 
                          entry.points().at(0).y() + text_offset_y );
-            ctx->rotate(-rotation);
+            ctx->rotate(-frame.rotation);
 
             //Flip font
             Cairo::Matrix font_matrix(entry.size(), 0.0, 0.0, -1.0 * entry.size(), 0.0, 0.0);
@@ -890,7 +1391,7 @@ void MapViewUi::draw_grid(const DrawingContext& ctx)
 
         if(!parser) 
         {
-            cpm::Logging::Instance().write(
+            CPM_LOG(
                 1,
                 "%s", 
                 "ERROR: can not parse file"
@@ -978,7 +1479,7 @@ void MapViewUi::draw_vehicle_past_trajectory(const DrawingContext& ctx, const ma
     ctx->stroke();
 }
 
-void MapViewUi::draw_vehicle_body(const DrawingContext& ctx, const map<string, shared_ptr<TimeSeries>>& vehicle_timeseries, uint8_t vehicle_id)
+void MapViewUi::draw_vehicle_body(const DrawingContext& ctx, const MapViewFrame& frame, const map<string, shared_ptr<TimeSeries>>& vehicle_timeseries, uint8_t vehicle_id)
 {
     ctx->save();
     {                        
@@ -1010,7 +1511,7 @@ void MapViewUi::draw_vehicle_body(const DrawingContext& ctx, const map<string, s
         {
             ctx->translate(-0.03, 0);
             const double scale = 0.01;
-            ctx->rotate(-yaw - rotation);
+            ctx->rotate(-yaw - frame.rotation);
             ctx->scale(scale, -scale);
             ctx->move_to(0,0);
             Cairo::TextExtents extents;
@@ -1181,13 +1682,12 @@ std::pair<double, double> MapViewUi::get_shape_center(CommonroadDDSShape& shape)
     return std::pair<double, double>(x, y);
 }
 
-void MapViewUi::draw_commonroad_obstacles(const DrawingContext& ctx)
+void MapViewUi::draw_commonroad_obstacles(const DrawingContext& ctx, const MapViewFrame& frame)
 {
     //Behavior is currently similar to drawing a vehicle - TODO: Improve this later on    
     ctx->set_source_rgb(1,.5,.1);
 
-    assert(get_obstacle_data);
-    for (auto entry : get_obstacle_data())
+    for (auto entry : frame.obstacle_data)
     {
         ctx->save();
 
@@ -1295,8 +1795,8 @@ void MapViewUi::draw_commonroad_obstacles(const DrawingContext& ctx)
             description_stream << static_cast<int>(entry.vehicle_id()); //CO for CommonroadObstacle
 
             ctx->translate(-0.03, 0);
-            const double scale = 1.8 / zoom;
-            ctx->rotate(-yaw - rotation);
+            const double scale = 1.8 / frame.zoom;
+            ctx->rotate(-yaw - frame.rotation);
             ctx->scale(scale, -scale);
             ctx->move_to(0,0);
             Cairo::TextExtents extents;
@@ -1326,4 +1826,6 @@ Gtk::DrawingArea* MapViewUi::get_parent()
 
 void MapViewUi::rotate_by(double rotation) {
     this->rotation = std::fmod(this->rotation + (rotation * M_PI / 180), 2*M_PI);
+    inverse_rotation_cos = cos(-this->rotation);
+    inverse_rotation_sin = sin(-this->rotation);
 }
@@ -18,6 +18,12 @@
 
 #include "commonroad_classes/CommonRoadScenario.hpp"
 #include "LCCErrorLogger.hpp"
+#include "VehiclePresenceTracker.hpp"
+#include "ui/map_view/MapLayerRenderer.hpp"
+#include "ui/map_view/MapPickIndex.hpp"
+#include "ui/map_view/MapViewProfiler.hpp"
+
+#include <set>
 
 /**
  * \brief Used in a lot of classes, provides a reference to the drawing context of the map view, 
@@ -34,12 +40,12 @@ using VehicleData = map<uint8_t, map<string, shared_ptr<TimeSeries> > >;
  * \brief Maps vehicle ID to current vehicle trajectory
  * \ingroup lcc_ui
  */
-using VehicleTrajectories = map<uint8_t, VehicleCommandTrajectory >;
+using VehicleTrajectories = map<uint8_t, shared_ptr<const VehicleCommandTrajectory> >;
 /**
  * \brief Maps vehicle ID to current vehicle path tracking
  * \ingroup lcc_ui
  */
-using VehiclePathTracking = map<uint8_t, VehicleCommandPathTracking >;
+using VehiclePathTracking = map<uint8_t, shared_ptr<const VehicleCommandPathTracking> >;
 
 /**
  * \class MapViewUi
@@ -78,8 +84,187 @@ class MapViewUi
     //! Storage containing current vehicle data obtained with get_vehicle_data
     VehicleData vehicle_data;
 
+    //! Tells which vehicles are online, if available (not available in an attached UI, then the age of the vehicle data is checked instead)
+    shared_ptr<VehiclePresenceTracker> presence_tracker;
+    //! ID of the subscription to presence_tracker
+    uint64_t presence_subscription_id = 0;
+    //! Set by the presence_tracker subscription, s.t. online_vehicle_ids is updated in the UI thread
+    std::atomic_bool presence_changed;
+    //! Vehicles that are currently online according to presence_tracker, only used in the UI thread
+    std::set<uint8_t> online_vehicle_ids;
+
+    /**
+     * \brief Check if a vehicle is currently online and should thus be drawn / be selectable
+     * \param vehicle_id ID of the vehicle
+     * \param vehicle_timeseries Data of the vehicle, used if no presence_tracker is available
+     */
+    bool is_vehicle_online(uint8_t vehicle_id, const map<string, shared_ptr<TimeSeries>>& vehicle_timeseries);
+
     //! For visualization of / drawing commonroad data, get obstacle information from data storage object via callback
     std::function<std::vector<CommonroadObstacle>()> get_obstacle_data;
+    //! Storage containing current obstacles obtained with get_obstacle_data
+    std::vector<CommonroadObstacle> obstacle_data;
+    //! Storage containing current visualizations obtained with get_visualization_msgs_callback
+    std::vector<Visualization> visualization_data;
+    //! Storage containing current trajectories obtained with get_vehicle_trajectory_command_callback
+    VehicleTrajectories vehicle_trajectories;
+    //! Storage containing current path tracking commands obtained with get_vehicle_path_tracking_command_callback
+    VehiclePathTracking vehicle_path_tracking;
+
+    /**
+     * \brief Snapshot of all data required to draw the layers, taken in the UI thread, s.t. the layers can be drawn in other threads
+     * while the UI thread already receives new data
+     */
+    struct MapViewFrame {
+        //! Vehicle data (the time series themselves are thread-safe)
+        VehicleData vehicle_data;
+        //! Vehicles that are online and thus drawn
+        std::vector<uint8_t> online_vehicle_ids;
+        //! Trajectory commands
+        VehicleTrajectories vehicle_trajectories;
+        //! Path tracking commands
+        VehiclePathTracking vehicle_path_tracking;
+        //! Commonroad obstacles
+        std::vector<CommonroadObstacle> obstacle_data;
+        //! Visualization messages
+        std::vector<Visualization> visualization_data;
+        //! View zoom, to keep the size of labels independent of the zoom
+        double zoom = 1;
+        //! View rotation, to draw labels horizontally
+        double rotation = 0;
+        //! Time of the snapshot, to tell past from future trajectory points
+        uint64_t t_now = 0;
+    };
+
+    /**
+     * \brief Layers of the map view, each drawn by its own thread (see layer_renderer), in drawing order
+     */
+    enum class MapLayer {
+        //! Commonroad scenario, lab boundaries and labcam
+        Map,
+        //! Trajectory and path tracking commands, past vehicle trajectories
+        Trajectories,
+        //! Visualization messages
+        Visualizations,
+        //! Commonroad obstacles
+        Obstacles,
+        //! Vehicle bodies
+        Vehicles
+    };
+    //! Number of values of MapLayer
+    static constexpr size_t map_layer_count = 5;
+
+    //! Draws the layers in other threads; only the finished layers are put together in draw(), s.t. slow layers do not block the UI
+    std::unique_ptr<MapLayerRenderer> layer_renderer;
+
+    /**
+     * \brief Get the transformation from world to canvas coordinates for the current view (pan, zoom, rotation)
+     */
+    Cairo::Matrix get_view_matrix();
+
+    /**
+     * \brief Take a snapshot of the current data and request new versions of all layers from layer_renderer, called regularly by update_dispatcher
+     */
+    void request_layers();
+
+    /**
+     * \brief Phases of fetching and drawing the map view data that are measured by profiler, in the order of their names in profiler
+     */
+    enum class ProfiledPhase {
+        //! get_vehicle_data
+        FetchVehicleData,
+        //! get_vehicle_trajectory_command_callback
+        FetchTrajectories,
+        //! get_vehicle_path_tracking_command_callback
+        FetchPathTracking,
+        //! get_obstacle_data
+        FetchObstacles,
+        //! get_visualization_msgs_callback
+        FetchVisualizations,
+        //! update_pick_index
+        UpdatePickIndex,
+        //! request_layers, mostly taking the data snapshot
+        RequestLayers,
+        //! Drawing MapLayer::Map (commonroad scenario), in its layer thread
+        DrawMap,
+        //! Drawing MapLayer::Trajectories (incl. trajectory interpolation), in its layer thread
+        DrawTrajectories,
+        //! Drawing MapLayer::Visualizations, in its layer thread
+        DrawVisualizations,
+        //! Drawing MapLayer::Obstacles, in its layer thread
+        DrawObstacles,
+        //! Drawing MapLayer::Vehicles, in its layer thread
+        DrawVehicles,
+        //! draw(), putting the layers together in the UI thread
+        Composite
+    };
+
+    //! Measures the phases of fetching and drawing the data, always active as a measurement only costs two clock reads
+    MapViewProfiler profiler{{
+        "fetch_vehicle_data",
+        "fetch_trajectories",
+        "fetch_path_tracking",
+        "fetch_obstacles",
+        "fetch_visualizations",
+        "update_pick_index",
+        "request_layers",
+        "draw_map",
+        "draw_trajectories",
+        "draw_visualizations",
+        "draw_obstacles",
+        "draw_vehicles",
+        "composite"
+    }};
+    //! If true, the statistics of profiler are shown on top of the map (toggled with F2)
+    bool show_profiler_overlay = false;
+    //! File that the statistics of profiler are written to (with F3, or when the map view is closed if write_profile_on_exit is set)
+    std::string profile_report_file = "map_view_profile.csv";
+    //! If true, the statistics of profiler are written to profile_report_file when the map view is destroyed
+    bool write_profile_on_exit = false;
+    //! Text of the profiler overlay, only updated every 500ms s.t. it is readable and computing the percentiles does not slow down drawing
+    std::vector<std::string> profiler_overlay_lines;
+    //! Time of the last update of profiler_overlay_lines
+    uint64_t profiler_overlay_update_time = 0;
+
+    /**
+     * \brief Measure a phase until the returned object is destroyed, see profiler
+     * \param phase The phase
+     */
+    MapViewProfiler::ScopedMeasurement measure(ProfiledPhase phase);
+
+    /**
+     * \brief Pass the dropped frames of layer_renderer to profiler, s.t. they are shown and written as well
+     */
+    void update_profiler_counters();
+
+    /**
+     * \brief Draw the statistics of profiler in the top left corner of the map view
+     * \param ctx The drawing context, in canvas coordinates
+     */
+    void draw_profiler_overlay(const DrawingContext& ctx);
+
+    //! Spatial index of vehicles, obstacles, visualizations, planning problems and lanelets, for finding the objects under the mouse; only used in the UI thread
+    MapPickIndex pick_index;
+    //! Geometry version of commonroad_scenario that the lanelets and planning problems in pick_index belong to, see CommonRoadScenario::get_geometry_version
+    uint64_t pick_geometry_version = 0;
+    //! False until the lanelets and planning problems were put into pick_index for the first time
+    bool pick_geometry_valid = false;
+    //! Counts calls of update_dispatcher, to update the shown tooltip regularly
+    uint64_t tooltip_tick = 0;
+
+    /**
+     * \brief Update pick_index with the current vehicle data, obstacles and visualizations; lanelets and planning problems are only
+     * updated if the scenario geometry changed
+     */
+    void update_pick_index();
+
+    /**
+     * \brief Get the tooltip text for a position in the map, which lists the objects at that position and their current values
+     * \param x x coordinate in the map
+     * \param y y coordinate in the map
+     * \return The text, empty if there is no object at that position
+     */
+    std::string get_tooltip_text(double x, double y);
 
     //! hold the path and related values temporarily, while the user draws with the mouse
     std::vector<Pose2D> path_painting_in_progress;
@@ -105,6 +290,10 @@ class MapViewUi
     double pan_y = 0; 
     //! For rotating the view; rotation is done around the origin (rotation_fixpoint_x and rotation_fixpoint_y) (not to be confused with commonroad map transformations)
     double rotation = 0; //[rad]
+    //! cos(-rotation), cached for canvas_to_world
+    double inverse_rotation_cos = 1;
+    //! sin(-rotation), cached for canvas_to_world
+    double inverse_rotation_sin = 0;
 
     //! It takes some time for the map scale to settle in, so monitor this a bit before initializing pan_x, pan_y and zoom
     double map_width = 0;
@@ -145,7 +334,8 @@ class MapViewUi
 
 
     /**
-     * \brief "Master" draw function, invoked regularly on the map view / drawingArea, calls all other draw functions
+     * \brief "Master" draw function, invoked regularly on the map view / drawingArea. Puts together the layers drawn by layer_renderer
+     * and draws the interactive parts (vehicle in focus, path painting) directly.
      * \param ctx The drawing context, to draw on the map view
      */
     void draw(const DrawingContext& ctx);
@@ -180,11 +370,13 @@ class MapViewUi
     /**
      * \brief Draws car image with vehicle ID on top, to show the current position of the vehicle
      * \param ctx The drawing context, to draw on the map view
+     * \param frame Snapshot of the data to draw, for the view rotation
      * \param vehicle_timeseries Gives current vehicle position and orientation
      * \param vehicle_id ID to draw on top of the car image, to visually identify the drawn vehicle
      */
     void draw_vehicle_body(
         const DrawingContext& ctx, 
+        const MapViewFrame& frame,
         const map<string, shared_ptr<TimeSeries>>& vehicle_timeseries, 
         uint8_t vehicle_id
     );
@@ -213,26 +405,30 @@ class MapViewUi
     /**
      * \brief Draw the vehicle's future trajectory, with one color for past and another for future parts of the trajectory
      * \param ctx The drawing context, to draw on the map view
+     * \param frame Snapshot of the data to draw
      */
-    void draw_received_trajectory_commands(const DrawingContext& ctx);
+    void draw_received_trajectory_commands(const DrawingContext& ctx, const MapViewFrame& frame);
 
     /**
      * \brief Draw received path tracking
      * \param ctx The drawing context, to draw on the map view
+     * \param frame Snapshot of the data to draw
      */
-    void draw_received_path_tracking_commands(const DrawingContext& ctx);
+    void draw_received_path_tracking_commands(const DrawingContext& ctx, const MapViewFrame& frame);
 
     /**
      * \brief Draw all received commonroad obstacles from get_obstacle_data
      * \param ctx The drawing context, to draw on the map view
+     * \param frame Snapshot of the data to draw
      */
-    void draw_commonroad_obstacles(const DrawingContext& ctx);
+    void draw_commonroad_obstacles(const DrawingContext& ctx, const MapViewFrame& frame);
 
     /**
      * \brief draw function that uses the viz callback to get all received viz commands and draws them on the screen
      * \param ctx The drawing context, to draw on the map view
+     * \param frame Snapshot of the data to draw
      */
-    void draw_received_visualization_commands(const DrawingContext& ctx);
+    void draw_received_visualization_commands(const DrawingContext& ctx, const MapViewFrame& frame);
 
     /**
      * \brief Helper function to draw text surrounded by a small filled rectangle with white background and transparency
@@ -250,7 +446,15 @@ class MapViewUi
     bool is_valid_point_for_path(double x, double y);
 
     /**
-     * \brief Determine vehicle ID in focus, by taking a look at the current mouse position and vehicle time series.
+     * \brief Transform canvas coordinates (e.g. of a mouse event) into world coordinates by reversing all steps done while drawing
+     * \param canvas_x x coordinate on the drawing area
+     * \param canvas_y y coordinate on the drawing area
+     * \return (x, y) in world coordinates
+     */
+    std::pair<double, double> canvas_to_world(double canvas_x, double canvas_y);
+
+    /**
+     * \brief Determine vehicle ID in focus, by looking up the current mouse position in pick_index.
      * Is in focus if the mouse hovers over one of the vehicles shown on the map.
      */
     int find_vehicle_id_in_focus();
@@ -265,6 +469,7 @@ public:
      * \param _get_vehicle_path_tracking_command_callback Callback to get vehicle path tracking for drawing
      * \param _get_obstacle_data For visualization of / drawing commonroad data, get obstacle information from data storage object via callback
      * \param _get_visualization_msgs_callback Callback to get received visualization messages, which are drawn on the map view as well (lines, circles, text etc.)
+     * \param _presence_tracker Tells which vehicles are online, optional (else the age of the vehicle data is checked)
      */
     MapViewUi(
         shared_ptr<TrajectoryCommand> _trajectoryCommand,
@@ -273,13 +478,23 @@ public:
         std::function<VehicleTrajectories()> _get_vehicle_trajectory_command_callback,
         std::function<VehiclePathTracking()> _get_vehicle_path_tracking_command_callback,
         std::function<std::vector<CommonroadObstacle>()> _get_obstacle_data,
-        std::function<std::vector<Visualization>()> _get_visualization_msgs_callback
+        std::function<std::vector<Visualization>()> _get_visualization_msgs_callback,
+        shared_ptr<VehiclePresenceTracker> _presence_tracker = nullptr
     );
 
     ~MapViewUi() {
+        if (presence_tracker)
+            presence_tracker->unsubscribe(presence_subscription_id);
+
         run_draw_thread.store(false);
         if (draw_loop_thread.joinable())
             draw_loop_thread.join();
+
+        //The layers are drawn using this object, so they must be finished before any member is destroyed
+        layer_renderer->stop();
+
+        if (write_profile_on_exit)
+            write_profile_report();
     }
 
     /**
@@ -287,6 +502,20 @@ public:
      */
     Gtk::DrawingArea* get_parent();
 
+    /**
+     * \brief Configure the profiler of the map view, which measures the phases of fetching and drawing the data
+     * \param show_overlay Show the statistics on top of the map (can be toggled with F2)
+     * \param report_file File that the statistics are written to with F3
+     * \param write_on_exit Also write the statistics to report_file when the map view is closed, e.g. to compare different builds
+     */
+    void set_profiler(bool show_overlay, std::string report_file, bool write_on_exit);
+
+    /**
+     * \brief Write the current statistics of the profiler to the configured report file (see set_profiler)
+     * \return False if the file could not be written
+     */
+    bool write_profile_report();
+
     /**
      * \brief rotates the map view by rotation [deg] counterclockwise
      * \param rotation amount to rotate the map view by
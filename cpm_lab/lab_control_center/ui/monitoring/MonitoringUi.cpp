@@ -1,6 +1,7 @@
 #include "MonitoringUi.hpp"
 #include <numeric>
 #include <cassert>
+#include <iomanip>
 
 /**
  * \file MonitoringUi.cpp
@@ -39,6 +40,8 @@ MonitoringUi::MonitoringUi(
     builder->get_widget("label_rtt_vehicle_short", label_rtt_vehicle_short);
     builder->get_widget("label_rtt_vehicle_long", label_rtt_vehicle_long);
     builder->get_widget("label_experiment_time", label_experiment_time);
+    builder->get_widget("label_memory_short", label_memory_short);
+    builder->get_widget("label_memory_long", label_memory_long);
 
     assert(parent);
     assert(viewport_monitoring);
@@ -54,6 +57,8 @@ MonitoringUi::MonitoringUi(
     assert(label_rtt_vehicle_short);
     assert(label_rtt_vehicle_long);
     assert(label_experiment_time);
+    assert(label_memory_short);
+    assert(label_memory_long);
 
     //Warning: Most style options are set in Glade (style classes etc) and style.css
 
@@ -344,7 +349,7 @@ void MonitoringUi::init_ui_dispatcher()
                                 {
                                     label->set_text("Offline");
                                     label->get_style_context()->add_class("alert");
-                                    cpm::Logging::Instance().write(
+                                    CPM_LOG(
                                         1,
                                         "Warning: NUC %d disconnected. Stopping vehicles ...", 
                                         static_cast<int>(hlc_id)
@@ -361,7 +366,7 @@ void MonitoringUi::init_ui_dispatcher()
                                     
                                     if(!error_triggered[0][0])
                                     {
-                                        cpm::Logging::Instance().write(
+                                        CPM_LOG(
                                             1,
                                             "Warning: NUCs %d disconnected. Stopping experiment ...", 
                                             static_cast<int>(hlc_id)
@@ -375,7 +380,7 @@ void MonitoringUi::init_ui_dispatcher()
                                 {
                                     label->set_text("Prog. crash");
                                     label->get_style_context()->add_class("alert");
-                                    cpm::Logging::Instance().write(
+                                    CPM_LOG(
                                         1,
                                         "Warning: NUC %d had a program crash. Stopping vehicles ...", 
                                         static_cast<int>(hlc_id)
@@ -440,7 +445,7 @@ void MonitoringUi::init_ui_dispatcher()
                             
                             if(!error_triggered[i][vehicle_id])
                             {
-                                cpm::Logging::Instance().write(
+                                CPM_LOG(
                                     1,
                                     "Warning: Clock delta of vehicle %d too high. Stopping experiment ...",
                                     static_cast<int>(vehicle_id)
@@ -481,7 +486,7 @@ void MonitoringUi::init_ui_dispatcher()
                             
                             if(!error_triggered[i][vehicle_id])
                             {
-                                cpm::Logging::Instance().write(
+                                CPM_LOG(
                                     1,
                                     "Warning: Battery level of vehicle %d too low. Stopping experiment ...", 
                                     static_cast<int>(vehicle_id)
@@ -518,7 +523,7 @@ void MonitoringUi::init_ui_dispatcher()
 
                             if(!error_triggered[i][vehicle_id])
                             {
-                                cpm::Logging::Instance().write(
+                                CPM_LOG(
                                     1,
                                     "Warning: speed of vehicle %d too high. Stopping experiment ...", 
                                     static_cast<int>(vehicle_id)
@@ -555,7 +560,7 @@ void MonitoringUi::init_ui_dispatcher()
 
                             if(!error_triggered[i][vehicle_id])
                             {
-                                cpm::Logging::Instance().write(
+                                CPM_LOG(
                                     1,
                                     "Warning: no IPS signal of vehicle %d. Age: %f ms. Stopping experiment ...", 
                                     static_cast<int>(vehicle_id), value
@@ -604,12 +609,7 @@ void MonitoringUi::init_ui_dispatcher()
                             continue;
                         }
 
-                        const auto& trajectory_points = trajectory->second;
-                        std::vector<TrajectoryPoint> trajectory_segment;
-                        for (const auto& trajectory_point : trajectory_points.trajectory_points())
-                        {
-                            trajectory_segment.push_back(trajectory_point);
-                        }        
+                        const rti::core::vector<TrajectoryPoint>& trajectory_segment = trajectory->second->trajectory_points();
                         
                         if(trajectory_segment.size() > 2)
                         {
@@ -662,7 +662,7 @@ void MonitoringUi::init_ui_dispatcher()
 
                                 if(!error_triggered[i][vehicle_id])
                                 {
-                                    cpm::Logging::Instance().write(
+                                    CPM_LOG(
                                         1,
                                         "Warning: vehicle %d not on reference. Error: %f m and %f ms. Stopping experiment ...", 
                                         static_cast<int>(vehicle_id), error, dt/1e6
@@ -776,6 +776,29 @@ void MonitoringUi::init_ui_dispatcher()
             label_rtt_vehicle_short->set_text(rtt_short.str().c_str());
         }
 
+        //Memory update - usage of all components that are limited by MemoryBudget
+        auto memory_usage = MemoryBudget::Instance().get_usage();
+        size_t total_footprint = 0;
+        size_t total_budget = 0;
+        std::stringstream memory_long;
+        memory_long << std::fixed << std::setprecision(1);
+        for (size_t i = 0; i < memory_usage.size(); ++i)
+        {
+            total_footprint += memory_usage[i].footprint_bytes;
+            total_budget += memory_usage[i].budget_bytes;
+
+            if (i > 0) memory_long << "\n";
+            memory_long 
+            << "\t" << memory_usage[i].name << ": " 
+            << memory_usage[i].footprint_bytes / 1e6 << " / " << memory_usage[i].budget_bytes / 1e6
+            << " (reduced " << memory_usage[i].shrink_count << "x)";
+        }
+        label_memory_long->set_text(memory_long.str().c_str());
+
+        std::stringstream memory_short;
+        memory_short << std::fixed << std::setprecision(1) << "Memory (MB): " << total_footprint / 1e6 << " / " << total_budget / 1e6;
+        label_memory_short->set_text(memory_short.str().c_str());
+
         //Update running time of simulation, if it is currently running
         auto sim_start = sim_start_time.load();
         if (sim_start > 0)
@@ -17,6 +17,7 @@
 #include <math.h>
 
 #include "TimeSeries.hpp"
+#include "MemoryBudget.hpp"
 #include "defaults.hpp"
 #include "cpm/Logging.hpp"
 #include "cpm/get_time_ns.hpp"
@@ -27,7 +28,7 @@
 #include "ui/setup/CrashChecker.hpp"
 
 using VehicleData = map<uint8_t, map<string, shared_ptr<TimeSeries> > >;
-using VehicleTrajectories = map<uint8_t, VehicleCommandTrajectory >;
+using VehicleTrajectories = map<uint8_t, shared_ptr<const VehicleCommandTrajectory> >;
 
 /**
  * \class MonitoringUi
@@ -68,6 +69,10 @@ public:
     Gtk::Label* label_rtt_vehicle_long;
     //! Shows the current runtime of the simulation (Time since deploy)
     Gtk::Label* label_experiment_time;
+    //! Shows the total memory used by the data accumulated in the LCC and the total budget
+    Gtk::Label* label_memory_short;
+    //! Shows the memory usage and budget of each component registered in MemoryBudget
+    Gtk::Label* label_memory_long;
     //! Provides a reference to deploy functions, for rebooting the vehicles
     std::shared_ptr<Deploy> deploy_functions;
     //! To check if a NUC crashed
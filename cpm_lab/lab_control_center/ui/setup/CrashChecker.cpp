@@ -130,7 +130,7 @@ std::vector<std::string> CrashChecker::check_for_remote_crashes()
 
         if (!script_running)
         {
-            cpm::Logging::Instance().write("Script crashed on NUC %s (remote)", id_string.c_str());
+            CPM_LOG(1, "Script crashed on NUC %s (remote)", id_string.c_str());
 
             std::stringstream report_stream;
             report_stream << "Script at HLC " << id_string;
@@ -139,7 +139,7 @@ std::vector<std::string> CrashChecker::check_for_remote_crashes()
 
         if (!middleware_running)
         {
-            cpm::Logging::Instance().write("Middleware crashed on NUC %s (remote)", id_string.c_str());
+            CPM_LOG(1, "Middleware crashed on NUC %s (remote)", id_string.c_str());
 
             std::stringstream report_stream;
             report_stream << "Middleware at HLC " << id_string;
@@ -277,7 +277,7 @@ void CrashChecker::update_crashed_participants(std::vector<std::string> crashed_
                 }
             }
             
-            cpm::Logging::Instance().write("The following programs crashed during simulation: %s", program_stream.str().c_str());
+            CPM_LOG(1, "The following programs crashed during simulation: %s", program_stream.str().c_str());
 
             ui_dispatcher.emit();
         }
@@ -120,7 +120,7 @@ void Deploy::deploy_local_hlc(bool use_simulated_time, std::vector<unsigned int>
             }
             else 
             {
-                cpm::Logging::Instance().write(
+                CPM_LOG(
                         1, 
                         "%s",
                         "Warning: Could not run unknown script: Neither matlab nor C++ executable"
@@ -199,7 +199,7 @@ void Deploy::deploy_separate_local_hlcs(bool use_simulated_time, std::vector<uns
         }
         else
         {
-            cpm::Logging::Instance().write(
+            CPM_LOG(
                 1, 
                 "%s",
                 "Warning: Could not run unknown script: Neither matlab nor C++ executable"
@@ -414,7 +414,7 @@ void Deploy::reboot_real_vehicle(unsigned int vehicle_id, unsigned int timeout_s
 
                 if(!msg_success)
                 {
-                    cpm::Logging::Instance().write(
+                    CPM_LOG(
                         2, 
                         "Could not reboot vehicle %u (timeout or connection lost)", 
                         vehicle_id
@@ -468,7 +468,7 @@ void Deploy::reboot_hlcs(std::vector<uint8_t> hlc_ids, unsigned int timeout_seco
 
                     if(!msg_success)
                     {
-                        cpm::Logging::Instance().write(
+                        CPM_LOG(
                             2, 
                             "Could not reboot HLC %u (timeout or connection lost)", 
                             hlc_id
@@ -762,7 +762,7 @@ bool Deploy::session_exists(std::string session_id)
 
     if (running_sessions.find("ERROR") != std::string::npos)
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1, 
             "%s",
             "Could not determine running sessions, assuming no crash..."
@@ -15,7 +15,7 @@ SetupViewUI::SetupViewUI
     std::shared_ptr<VehicleAutomatedControl> _vehicle_control, 
     std::shared_ptr<HLCReadyAggregator> _hlc_ready_aggregator, 
     std::shared_ptr<GoToPlanner> go_to_planner, 
-    std::function<VehicleData()> _get_vehicle_data,
+    std::shared_ptr<VehiclePresenceTracker> _presence_tracker,
     std::function<void(bool, bool)> _reset_timer,
     std::function<void()> _reset_vehicle_view,
     std::function<void()> _on_simulation_start,
@@ -31,7 +31,7 @@ SetupViewUI::SetupViewUI
     vehicle_control(_vehicle_control),
     hlc_ready_aggregator(_hlc_ready_aggregator),
     go_to_planner(go_to_planner),
-    get_vehicle_data(_get_vehicle_data),
+    presence_tracker(_presence_tracker),
     reset_timer(_reset_timer),
     reset_vehicle_view(_reset_vehicle_view),
     on_simulation_start(_on_simulation_start),
@@ -177,57 +177,59 @@ SetupViewUI::SetupViewUI
 
     simulation_running.store(false);
     
-    //Regularly check / update which real vehicles are currently turned on, to use them when the experiment is deployed
+    //Update which real vehicles are currently turned on whenever this changes, to use them when the experiment is deployed
     is_deployed.store(false);
     vehicle_data_thread_running.store(true);
+    presence_subscription_id = presence_tracker->subscribe([&](const VehiclePresenceTracker::VehiclePresence&, VehiclePresenceTracker::PresenceChange change){
+        if (change == VehiclePresenceTracker::PresenceChange::ONLINE) return;
+
+        //Do not kill vehicles etc. in the thread that receives the vehicle data
+        std::lock_guard<std::mutex> lock(vehicle_data_thread_mutex);
+        real_vehicles_changed = true;
+        vehicle_data_thread_cv.notify_all();
+    });
     check_real_vehicle_data_thread = std::thread([&]{
         // So we can later check if anything changed
         std::vector<unsigned int> old_active_vehicles;
         std::vector<unsigned int> active_vehicles;
+        //Changes of the real vehicles during an experiment are applied afterwards
+        bool real_vehicles_outdated = false;
+        std::unique_lock<std::mutex> thread_lock(vehicle_data_thread_mutex);
         while(vehicle_data_thread_running.load())
         {
+            real_vehicles_outdated = real_vehicles_outdated || real_vehicles_changed;
+            real_vehicles_changed = false;
+            thread_lock.unlock();
+
             active_vehicles = get_vehicle_ids_active();
 
             //Don't update data during experiment
             if (! is_deployed.load())
             {
-            
-                //Check if vehicle data has changed, flag all vehicles that are active and not simulated as real vehicles
-                auto currently_simulated_vehicles = get_vehicle_ids_simulated();
-
-                //Get currently active vehicles
-                active_real_vehicles.clear();
-                for (auto vehicle_entry : get_vehicle_data())
+                if (real_vehicles_outdated)
                 {
-                    auto id = vehicle_entry.first;
-                    auto entry_real = vehicle_entry.second.at("is_real");
-                    auto entry_pose_x = vehicle_entry.second.at("pose_x");
+                    real_vehicles_outdated = false;
 
-                    //Continue if the entry is no longer valid (can happen e.g. during destruction)
-                    if (!entry_real || !entry_pose_x) continue;
+                    //Check if vehicle data has changed, flag all vehicles that are active and not simulated as real vehicles
+                    auto currently_simulated_vehicles = get_vehicle_ids_simulated();
+                    auto real_vehicle_ids = presence_tracker->get_real_vehicle_ids();
 
-                    //Only consider data of non-simulated vehicles that is not older than 500ms (else: probably turned off)
-                    //See if a signal of a real vehicle is among the past 25 signals (due to 50Hz -> 500ms); real is more important than simulated
-                    bool is_real_vehicle = false;
-                    for (bool const is_real : entry_real->get_last_n_values(25))
                     {
-                        if (is_real) {
-                            is_real_vehicle = true;
-                            break;
-                        }
+                        std::lock_guard<std::mutex> lock(active_real_vehicles_mutex);
+                        active_real_vehicles.assign(real_vehicle_ids.begin(), real_vehicle_ids.end());
                     }
 
-                    if (entry_pose_x->has_new_data(0.5) && is_real_vehicle)
+                    for (auto id : real_vehicle_ids)
                     {
-                        active_real_vehicles.push_back(id);
-
                         //Kill simulated vehicle if real vehicle was detected
                         if (std::find(currently_simulated_vehicles.begin(), currently_simulated_vehicles.end(), id) != currently_simulated_vehicles.end())
                         {
-                            cpm::Logging::Instance().write(3, "Killing simulated vehicle %i, replaced by real vehicle", static_cast<int>(id));
+                            CPM_LOG(3, "Killing simulated vehicle %i, replaced by real vehicle", static_cast<int>(id));
                             deploy_functions->kill_sim_vehicle(id);
                         }
                     }
+
+                    active_vehicles = get_vehicle_ids_active();
                 }
 
                 // If the active vehicle ids changed, update the parameter server
@@ -251,8 +253,11 @@ SetupViewUI::SetupViewUI
 
             old_active_vehicles = active_vehicles;
             
-            //Sleep for a while, then update again
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            //Wait for a change of the real vehicles, but check the active (simulated) vehicles regularly
+            thread_lock.lock();
+            vehicle_data_thread_cv.wait_for(thread_lock, std::chrono::milliseconds(500), [&] {
+                return !vehicle_data_thread_running.load() || real_vehicles_changed;
+            });
         }
     });
 
@@ -261,11 +266,7 @@ SetupViewUI::SetupViewUI
 
 SetupViewUI::~SetupViewUI() {
     //Kill real vehicle data thread
-    vehicle_data_thread_running.store(false);
-    if(check_real_vehicle_data_thread.joinable())
-    {
-        check_real_vehicle_data_thread.join();
-    }
+    stop_vehicle_data_thread();
 
     //Kill grey out thread for kill button, if it exists
     kill_grey_out_running.store(false);
@@ -294,6 +295,21 @@ void SetupViewUI::vehicle_toggle_callback(unsigned int vehicle_id, VehicleToggle
 }
 
 
+void SetupViewUI::stop_vehicle_data_thread() {
+    presence_tracker->unsubscribe(presence_subscription_id);
+
+    {
+        std::lock_guard<std::mutex> lock(vehicle_data_thread_mutex);
+        vehicle_data_thread_running.store(false);
+    }
+    vehicle_data_thread_cv.notify_all();
+
+    if(check_real_vehicle_data_thread.joinable())
+    {
+        check_real_vehicle_data_thread.join();
+    }
+}
+
 //Do the same as in the destructor, because there we do not get the desired results sadly
 void SetupViewUI::on_lcc_close() {
     lcc_closed.store(true);
@@ -301,11 +317,7 @@ void SetupViewUI::on_lcc_close() {
     deploy_functions->kill_ips();
 
     //Kill real vehicle data thread
-    vehicle_data_thread_running.store(false);
-    if(check_real_vehicle_data_thread.joinable())
-    {
-        check_real_vehicle_data_thread.join();
-    }
+    stop_vehicle_data_thread();
 
     //Kill grey out thread for kill button, if it exists
     kill_grey_out_running.store(false);
@@ -444,7 +456,7 @@ void SetupViewUI::deploy_applications() {
 
     if (!simulation_possible)
     {
-        cpm::Logging::Instance().write(1, "%s", "LCC Deploy: No vehicles are online, deploy was aborted");
+        CPM_LOG(1, "%s", "LCC Deploy: No vehicles are online, deploy was aborted");
         return;
     }
 
@@ -465,7 +477,7 @@ void SetupViewUI::deploy_applications() {
     }
     else
     {
-        cpm::Logging::Instance().write(1, "%s", "Error in SetupViewUI: on_simulation_start callback missing!");
+        CPM_LOG(1, "%s", "Error in SetupViewUI: on_simulation_start callback missing!");
     }
     
 
@@ -520,7 +532,7 @@ void SetupViewUI::deploy_applications() {
             {
                 std::stringstream error_stream;
                 error_stream << "Could not convert given script path to absolute path, error is: " << e.what();
-                cpm::Logging::Instance().write(1, "%s", error_stream.str().c_str());
+                CPM_LOG(1, "%s", error_stream.str().c_str());
             }
         }
     }
@@ -545,7 +557,7 @@ void SetupViewUI::deploy_applications() {
         }
         else 
         {
-            cpm::Logging::Instance().write(1, "%s", "No lookup function to get HLC IDs given, cannot deploy on HLCs");
+            CPM_LOG(1, "%s", "No lookup function to get HLC IDs given, cannot deploy on HLCs");
             return;
         }
 
@@ -590,7 +602,7 @@ void SetupViewUI::deploy_applications() {
     }
     else
     {
-        cpm::Logging::Instance().write(1, "%s", "Script path is empty / invalid / a directory, thus neither script nor middleware could be started");
+        CPM_LOG(1, "%s", "Script path is empty / invalid / a directory, thus neither script nor middleware could be started");
     }
     
 
@@ -705,7 +717,7 @@ void SetupViewUI::perform_post_kill_cleanup()
     }
     else if (!on_simulation_stop)
     {
-        cpm::Logging::Instance().write(1, "%s", "Error in SetupViewUI: on_simulation_stop callback missing!");
+        CPM_LOG(1, "%s", "Error in SetupViewUI: on_simulation_stop callback missing!");
     }
 
     //Undo grey out
@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <atomic>
 #include <array>
+#include <condition_variable>
 #include <cstdio> //For popen
 #include <experimental/filesystem> //Used instead of std::filesystem, because some compilers still seem to be outdated
 #include <functional>
@@ -148,17 +149,19 @@ private:
     //! Planner to control vehicle to desired poses
     std::shared_ptr<GoToPlanner> go_to_planner;
 
-    //! Function to get IDs of real vehicles (and simulated ones) which are currently active
-    std::function<VehicleData()> get_vehicle_data;
+    //! Tells which real vehicles are currently online, changes are sent to check_real_vehicle_data_thread
+    std::shared_ptr<VehiclePresenceTracker> presence_tracker;
+    //! ID of the subscription to presence_tracker
+    uint64_t presence_subscription_id = 0;
     //! List of currently online real (not simulated) vehicles
     std::vector<unsigned int> active_real_vehicles;
     //! Mutex to access active_real_vehicles
     std::mutex active_real_vehicles_mutex;
     /**
-     * \brief Check, using get_vehicle_data, if data from a real vehicle was received within the last 500ms for each ID. 
-     * If so, this vehicle ID is considered to be part of a "real" vehicle.
-     * If a simulated vehicle with the same ID is currently running, it is killed.
-     * Updates active_real_vehicles with the currently active real vehicles.
+     * \brief Updates active_real_vehicles whenever presence_tracker reports that a vehicle became real / simulated or went offline
+     * (a vehicle is real if data from the real vehicle was received within the last 500ms).
+     * If a simulated vehicle with the same ID as a real vehicle is currently running, it is killed.
+     * Also updates the vehicle IDs on the parameter server if the active vehicles changed, which is checked every 500ms.
      * The thread does not operate during simulation, because then the vehicle configuration is assumed to be fixed.
      */
     std::thread check_real_vehicle_data_thread;
@@ -166,6 +169,17 @@ private:
     std::atomic_bool is_deployed;
     //! Used as a stop condition for check_real_vehicle_data_thread
     std::atomic_bool vehicle_data_thread_running;
+    //! Set by the presence_tracker subscription if the real vehicles changed, reset by check_real_vehicle_data_thread
+    bool real_vehicles_changed = true;
+    //! Mutex for real_vehicles_changed and vehicle_data_thread_cv
+    std::mutex vehicle_data_thread_mutex;
+    //! Wakes up check_real_vehicle_data_thread if the real vehicles changed or if it is stopped
+    std::condition_variable vehicle_data_thread_cv;
+
+    /**
+     * \brief Stop check_real_vehicle_data_thread and the subscription to presence_tracker
+     */
+    void stop_vehicle_data_thread();
 
     //Functions to reset all UI elements after a simulation was performed / before a new one is started
     /**
@@ -292,7 +306,7 @@ public:
      * \param _deploy_functions Manages all deploy technicalities, like creating tmux sessions, calling bash scripts etc
      * \param _vehicle_control Allows to send automated commands to the vehicles, like stopping them at their current position after simulation
      * \param _hlc_ready_aggregator Get all IDs of currently active HLCs for correct remote deployment, get currently running scripts etc
-     * \param _get_vehicle_data Used to get currently active vehicle IDs
+     * \param _presence_tracker Used to get the currently online real vehicles
      * \param _reset_timer Reset timer & set up a new one for the next simulation
      * \param _reset_vehicle_view Reset shown data for vehicles in monitoring ui, called when a simulated vehicle is turned off
      * \param _on_simulation_start Callback that can be registered in e.g. main to perform changes on other modules when the simulation starts
@@ -307,7 +321,7 @@ public:
         std::shared_ptr<VehicleAutomatedControl> _vehicle_control, 
         std::shared_ptr<HLCReadyAggregator> _hlc_ready_aggregator, 
         std::shared_ptr<GoToPlanner> go_to_planner, 
-        std::function<VehicleData()> _get_vehicle_data,
+        std::shared_ptr<VehiclePresenceTracker> _presence_tracker,
         std::function<void(bool, bool)> _reset_timer,
         std::function<void()> _reset_vehicle_view,
         std::function<void()> _on_simulation_start,
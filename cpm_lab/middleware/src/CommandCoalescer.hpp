@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \class CommandCoalescer
+ * \brief Decides which vehicle commands of one command type are forwarded to the vehicles (optional, real time only).
+ * Per vehicle, at most one command is forwarded per slot (slots start at the beginning of each period) and two forwarded commands
+ * are at least min_interval_ns apart. A command that may be forwarded is forwarded immediately. Other commands are held back;
+ * only the newest held command of a vehicle is forwarded as soon as it is allowed, older ones are dropped (coalesced).
+ * Thus, the latest command of a vehicle always reaches it, but chatty HLCs do not flood the vehicle network.
+ * Not thread-safe, the user must synchronize the access.
+ * \ingroup middleware
+ */
+template<class MessageType> class CommandCoalescer {
+    private:
+        /**
+         * \struct VehicleEntry
+         * \brief Forwarding state of a single vehicle
+         */
+        struct VehicleEntry {
+            //! If a command was forwarded to the vehicle yet
+            bool has_forwarded = false;
+            //! Time of the last forwarded command in ns
+            uint64_t last_forward_ns = 0;
+            //! Newest command that was held back, if any
+            std::optional<MessageType> pending;
+        };
+
+        //! Length of a slot in ns, 0 to disable slots
+        uint64_t slot_ns;
+        //! Minimum time between two forwarded commands of a vehicle in ns, 0 to disable
+        uint64_t min_interval_ns;
+        //! Forwarding state per vehicle ID
+        std::unordered_map<uint8_t, VehicleEntry> vehicles;
+        //! Number of commands that were forwarded
+        uint64_t forwarded_count = 0;
+        //! Number of commands that were dropped because a newer command replaced them
+        uint64_t coalesced_count = 0;
+
+        /**
+         * \brief Earliest time at which the next command of a vehicle may be forwarded
+         * \param entry State of the vehicle
+         * \param period_start Start of the current period in ns, slots are aligned to it
+         */
+        uint64_t earliest_forward(const VehicleEntry& entry, uint64_t period_start) const
+        {
+            if (!entry.has_forwarded) return 0;
+
+            uint64_t earliest = entry.last_forward_ns + min_interval_ns;
+            if (slot_ns > 0)
+            {
+                //End of the slot of the last forwarded command; any time in the current period after that is a new slot
+                uint64_t slot_end = period_start;
+                if (entry.last_forward_ns >= period_start)
+                {
+                    slot_end = period_start + ((entry.last_forward_ns - period_start) / slot_ns + 1) * slot_ns;
+                }
+                earliest = std::max(earliest, slot_end);
+            }
+            return earliest;
+        }
+
+    public:
+        /**
+         * \brief Constructor
+         * \param _slot_ns Length of a slot in ns (at most one command per vehicle and slot), 0 to disable slots
+         * \param _min_interval_ns Minimum time between two forwarded commands of a vehicle in ns, 0 to disable
+         */
+        CommandCoalescer(uint64_t _slot_ns, uint64_t _min_interval_ns)
+        :slot_ns(_slot_ns)
+        ,min_interval_ns(_min_interval_ns)
+        {
+        }
+
+        /**
+         * \brief Offer a command that was received from an HLC
+         * \param message The command
+         * \param now Current time in ns
+         * \param period_start Start of the current period in ns
+         * \return The command if it should be forwarded right away, else nothing (it is held back, see take_due)
+         */
+        std::optional<MessageType> offer(const MessageType& message, uint64_t now, uint64_t period_start)
+        {
+            auto& entry = vehicles[message.vehicle_id()];
+
+            if (entry.pending.has_value())
+            {
+                //Only the newest command is kept
+                ++coalesced_count;
+                entry.pending.reset();
+            }
+
+            if (now >= earliest_forward(entry, period_start))
+            {
+                entry.has_forwarded = true;
+                entry.last_forward_ns = now;
+                ++forwarded_count;
+                return message;
+            }
+
+            entry.pending = message;
+            return std::nullopt;
+        }
+
+        /**
+         * \brief Take all held back commands that may be forwarded now
+         * \param now Current time in ns
+         * \param period_start Start of the current period in ns
+         * \return The commands to forward
+         */
+        std::vector<MessageType> take_due(uint64_t now, uint64_t period_start)
+        {
+            std::vector<MessageType> due;
+            for (auto& vehicle : vehicles)
+            {
+                auto& entry = vehicle.second;
+                if (entry.pending.has_value() && now >= earliest_forward(entry, period_start))
+                {
+                    due.push_back(std::move(entry.pending.value()));
+                    entry.pending.reset();
+                    entry.last_forward_ns = now;
+                    ++forwarded_count;
+                }
+            }
+            return due;
+        }
+
+        /**
+         * \brief Earliest time at which a held back command may be forwarded (see take_due), or nothing if no command is held back
+         * \param period_start Start of the current period in ns
+         */
+        std::optional<uint64_t> next_due(uint64_t period_start) const
+        {
+            std::optional<uint64_t> next;
+            for (auto& vehicle : vehicles)
+            {
+                if (vehicle.second.pending.has_value())
+                {
+                    uint64_t earliest = earliest_forward(vehicle.second, period_start);
+                    next = std::min(next.value_or(earliest), earliest);
+                }
+            }
+            return next;
+        }
+
+        /**
+         * \brief Number of commands that were forwarded
+         */
+        uint64_t get_forwarded_count() const
+        {
+            return forwarded_count;
+        }
+
+        /**
+         * \brief Number of commands that were dropped because a newer command of the same vehicle replaced them
+         */
+        uint64_t get_coalesced_count() const
+        {
+            return coalesced_count;
+        }
+};
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+
+/**
+ * \class CommandValidator
+ * \brief Structural validation of vehicle commands received from the HLC, before they are forwarded to the vehicle.
+ * Each check is a single pass over the command without allocations (unless a trajectory needs to be repaired),
+ * s.t. it only adds a few microseconds per command. The checks return a bit mask of issues (see Issue):
+ * Commands with issues in RejectMask must not be forwarded, other issues were fixed in place (clipped / repaired).
+ * The validator also counts the checked, clipped and rejected commands (thread-safe).
+ * The checks are templates, s.t. they work with the IDL types (see TypedCommunication.cpp) but do not depend on DDS.
+ * \ingroup middleware
+ */
+class CommandValidator {
+    public:
+        /**
+         * \struct Limits
+         * \brief Bounds for the values in vehicle commands
+         */
+        struct Limits {
+            //! If false, commands are neither checked nor changed
+            bool enabled = true;
+            //! Maximum absolute speed in m/s (trajectory point velocities, speed of speed curvature and path tracking commands), larger speeds are clipped
+            double max_speed = 4.0;
+            //! Maximum absolute curvature in 1/m, larger curvatures are clipped
+            double max_curvature = 5.0;
+            //! Maximum absolute x / y position in m, commands with positions outside are rejected
+            double max_position = 100.0;
+            //! Two consecutive trajectory points must not be further apart than this speed times their time difference (jumps), in m/s
+            double max_jump_speed = 8.0;
+            //! Maximum number of trajectory / path points, longer commands are rejected
+            size_t max_points = 1000;
+        };
+
+        /**
+         * \enum Issue
+         * \brief Issues that were found in a command, as bit flags
+         */
+        enum Issue : uint32_t {
+            IssueNone = 0,
+            IssueNotFinite = 1,         //!< NaN or infinite value (rejected)
+            IssueOutOfBounds = 2,       //!< Position outside of Limits::max_position (rejected)
+            IssueJump = 4,              //!< Consecutive trajectory points too far apart, or path s not increasing (rejected)
+            IssueTooFewPoints = 8,      //!< Empty trajectory or too short path (rejected)
+            IssueTooManyPoints = 16,    //!< More points than Limits::max_points (rejected)
+            IssueClipped = 32,          //!< Speed, curvature or direct input was clipped to its limits (fixed)
+            IssueUnsorted = 64          //!< Trajectory points were not sorted by time or had duplicate times; sorted, newest duplicate kept (fixed)
+        };
+
+        //! Commands with any of these issues must not be forwarded
+        static constexpr uint32_t RejectMask = IssueNotFinite | IssueOutOfBounds | IssueJump | IssueTooFewPoints | IssueTooManyPoints;
+
+    private:
+        //! Bounds for the commands
+        Limits limits;
+
+        //! Number of checked commands
+        std::atomic<uint64_t> checked_count{0};
+        //! Number of commands that were forwarded after clipping / repairing them
+        std::atomic<uint64_t> fixed_count{0};
+        //! Number of commands that were not forwarded
+        std::atomic<uint64_t> rejected_count{0};
+
+        /**
+         * \brief Clip a value to [-limit, limit]
+         * \param value The value, changed in place
+         * \param limit The (positive) limit
+         * \return IssueClipped if the value was changed, else IssueNone
+         */
+        static uint32_t clip(double& value, double limit)
+        {
+            if (std::abs(value) <= limit) return IssueNone;
+
+            value = std::max(-limit, std::min(value, limit));
+            return IssueClipped;
+        }
+
+        /**
+         * \brief Sort trajectory points by time and remove duplicate times (the later point in the original order wins,
+         * like on the vehicle, where a repeated time stamp overwrites the existing point)
+         * \param points The trajectory points, changed in place
+         */
+        template<class PointVector> static void sort_trajectory_points(PointVector& points)
+        {
+            using Point = typename std::decay<decltype(points[0])>::type;
+            std::stable_sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+                return a.t().nanoseconds() < b.t().nanoseconds();
+            });
+
+            size_t kept = 0;
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                if (i + 1 < points.size() && points[i + 1].t().nanoseconds() == points[i].t().nanoseconds()) continue;
+                if (kept != i) points[kept] = points[i];
+                ++kept;
+            }
+            points.resize(kept);
+        }
+
+        /**
+         * \brief Single pass over time-sorted trajectory points that detects jumps and returns whether the points are sorted
+         * \param points The trajectory points
+         * \param jumps Set to true if two consecutive points are too far apart (only meaningful if the points are sorted)
+         * \return True if the points have strictly increasing times
+         */
+        template<class PointVector> bool check_trajectory_order(const PointVector& points, bool& jumps) const
+        {
+            bool sorted = true;
+            jumps = false;
+            for (size_t i = 1; i < points.size(); ++i)
+            {
+                const auto& previous = points[i - 1];
+                const auto& current = points[i];
+                uint64_t t_previous = previous.t().nanoseconds();
+                uint64_t t_current = current.t().nanoseconds();
+                sorted &= (t_current > t_previous);
+
+                double dt = (t_current > t_previous) ? static_cast<double>(t_current - t_previous) * 1e-9 : 0.0;
+                double dx = current.px() - previous.px();
+                double dy = current.py() - previous.py();
+                double max_distance = limits.max_jump_speed * dt;
+                jumps |= (dx * dx + dy * dy > max_distance * max_distance);
+            }
+            return sorted;
+        }
+
+    public:
+        /**
+         * \brief Constructor
+         * \param _limits Bounds for the commands
+         */
+        CommandValidator(Limits _limits)
+        :limits(_limits)
+        {
+        }
+
+        /**
+         * \brief Whether the checks are enabled
+         */
+        bool is_enabled() const
+        {
+            return limits.enabled;
+        }
+
+        /**
+         * \brief Check trajectory points (VehicleCommandTrajectory): Values must be finite and positions within bounds,
+         * consecutive points must not jump; velocities are clipped and the points sorted by time if necessary
+         * \param points The trajectory points (with t().nanoseconds(), px(), py(), vx(), vy() and the corresponding setters), changed in place
+         * \return Found issues, see Issue
+         */
+        template<class PointVector> uint32_t check_trajectory_points(PointVector& points) const
+        {
+            if (points.size() == 0) return IssueTooFewPoints;
+            if (points.size() > limits.max_points) return IssueTooManyPoints;
+
+            //Branch-free accumulation over all points
+            bool finite = true;
+            bool in_bounds = true;
+            double max_speed_squared = 0.0;
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                const auto& point = points[i];
+                double px = point.px();
+                double py = point.py();
+                double vx = point.vx();
+                double vy = point.vy();
+                finite &= std::isfinite(px) & std::isfinite(py) & std::isfinite(vx) & std::isfinite(vy);
+                in_bounds &= (std::abs(px) <= limits.max_position) & (std::abs(py) <= limits.max_position);
+                max_speed_squared = std::max(max_speed_squared, vx * vx + vy * vy);
+            }
+
+            if (!finite) return IssueNotFinite;
+            if (!in_bounds) return IssueOutOfBounds;
+
+            uint32_t issues = IssueNone;
+
+            bool jumps = false;
+            if (!check_trajectory_order(points, jumps))
+            {
+                sort_trajectory_points(points);
+                check_trajectory_order(points, jumps);
+                issues |= IssueUnsorted;
+            }
+            if (jumps) return issues | IssueJump;
+
+            //Scale down velocities that are too high, keeping their direction
+            if (max_speed_squared > limits.max_speed * limits.max_speed)
+            {
+                for (size_t i = 0; i < points.size(); ++i)
+                {
+                    auto& point = points[i];
+                    double speed = std::hypot(point.vx(), point.vy());
+                    if (speed > limits.max_speed)
+                    {
+                        double factor = limits.max_speed / speed;
+                        point.vx(point.vx() * factor);
+                        point.vy(point.vy() * factor);
+                    }
+                }
+                issues |= IssueClipped;
+            }
+
+            return issues;
+        }
+
+        /**
+         * \brief Check path points (VehicleCommandPathTracking): At least two points, values must be finite,
+         * positions within bounds and s strictly increasing
+         * \param points The path points (with pose().x(), pose().y(), pose().yaw() and s())
+         * \return Found issues, see Issue
+         */
+        template<class PointVector> uint32_t check_path_points(const PointVector& points) const
+        {
+            if (points.size() < 2) return IssueTooFewPoints;
+            if (points.size() > limits.max_points) return IssueTooManyPoints;
+
+            bool finite = true;
+            bool in_bounds = true;
+            bool increasing = true;
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                const auto& point = points[i];
+                double x = point.pose().x();
+                double y = point.pose().y();
+                finite &= std::isfinite(x) & std::isfinite(y) & std::isfinite(point.pose().yaw()) & std::isfinite(point.s());
+                in_bounds &= (std::abs(x) <= limits.max_position) & (std::abs(y) <= limits.max_position);
+                increasing &= (i == 0) || (point.s() > points[i - 1].s());
+            }
+
+            if (!finite) return IssueNotFinite;
+            if (!in_bounds) return IssueOutOfBounds;
+            if (!increasing || points[0].s() != 0) return IssueJump;
+            return IssueNone;
+        }
+
+        /**
+         * \brief Check a speed: Must be finite, is clipped to the maximum speed
+         * \param speed The speed in m/s, changed in place
+         * \return Found issues, see Issue
+         */
+        uint32_t check_speed(double& speed) const
+        {
+            if (!std::isfinite(speed)) return IssueNotFinite;
+            return clip(speed, limits.max_speed);
+        }
+
+        /**
+         * \brief Check a curvature: Must be finite, is clipped to the maximum curvature
+         * \param curvature The curvature in 1/m, changed in place
+         * \return Found issues, see Issue
+         */
+        uint32_t check_curvature(double& curvature) const
+        {
+            if (!std::isfinite(curvature)) return IssueNotFinite;
+            return clip(curvature, limits.max_curvature);
+        }
+
+        /**
+         * \brief Check a dimensionless direct input (throttle / steering): Must be finite, is clipped to [-1, 1]
+         * \param value The input, changed in place
+         * \return Found issues, see Issue
+         */
+        uint32_t check_direct_input(double& value) const
+        {
+            if (!std::isfinite(value)) return IssueNotFinite;
+            return clip(value, 1.0);
+        }
+
+        /**
+         * \brief Count the result of a check
+         * \param issues Found issues, see Issue
+         * \return True if the command may be forwarded
+         */
+        bool record(uint32_t issues)
+        {
+            ++checked_count;
+            if (issues & RejectMask)
+            {
+                ++rejected_count;
+                return false;
+            }
+            if (issues != IssueNone)
+            {
+                ++fixed_count;
+            }
+            return true;
+        }
+
+        /**
+         * \brief Human-readable description of issues, for logging
+         * \param issues Found issues, see Issue
+         */
+        static std::string describe(uint32_t issues)
+        {
+            std::string description;
+            auto append = [&] (uint32_t issue, const char* text) {
+                if (!(issues & issue)) return;
+                if (!description.empty()) description += ", ";
+                description += text;
+            };
+            append(IssueNotFinite, "NaN or infinite value");
+            append(IssueOutOfBounds, "position out of bounds");
+            append(IssueJump, "jump between consecutive points");
+            append(IssueTooFewPoints, "too few points");
+            append(IssueTooManyPoints, "too many points");
+            append(IssueClipped, "values clipped");
+            append(IssueUnsorted, "points sorted by time");
+            return description;
+        }
+
+        //! Number of checked commands
+        uint64_t get_checked_count() const { return checked_count.load(); }
+        //! Number of commands that were forwarded after clipping / repairing them
+        uint64_t get_fixed_count() const { return fixed_count.load(); }
+        //! Number of commands that were not forwarded
+        uint64_t get_rejected_count() const { return rejected_count.load(); }
+};
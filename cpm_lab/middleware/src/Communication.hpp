@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <atomic>
 #include <mutex>
+#include <thread>
 
 #include "VehicleState.hpp"
 #include "VehicleStateList.hpp"
@@ -18,11 +19,11 @@
 #include "cpm/AsyncReader.hpp"
 #include "cpm/MultiVehicleReader.hpp"
 #include "cpm/Timer.hpp"
-#include "cpm/get_topic.hpp"
 #include "cpm/VehicleIDFilteredTopic.hpp"
 #include "cpm/Writer.hpp"
 #include "cpm/ReaderAbstract.hpp"
 #include "cpm/Participant.hpp"
+#include "cpm/HLCMailbox.hpp"
 
 #include "CommonroadDDSGoalState.hpp"
 #include "VehicleCommandTrajectory.hpp"
@@ -86,6 +87,75 @@ class Communication {
         TypedCommunication<VehicleCommandSpeedCurvature> speedCurvatureCommunication;
         //! To send direct commands to a vehicle (given by the HLC)
         TypedCommunication<VehicleCommandDirect> directCommunication;
+
+        //Local fast path to the HLC
+        //! Shared memory mailbox for a (C++) HLC on the same machine, nullptr if disabled; only used if an HLC attached to it, else DDS is used
+        std::shared_ptr<cpm::HLCMailbox> hlc_mailbox;
+        //! Thread that receives commands from the HLC via hlc_mailbox
+        std::thread hlc_mailbox_thread;
+        //! Stop condition for hlc_mailbox_thread
+        std::atomic_bool hlc_mailbox_running{false};
+
+        /**
+         * \brief Receive commands from the HLC via hlc_mailbox and pass them on like commands received via DDS, until hlc_mailbox_running is false
+         */
+        void receive_from_hlc_mailbox()
+        {
+            std::vector<char> buffer;
+            cpm::HLCMailbox::MessageTag tag;
+            uint64_t reported_lost_messages = 0;
+
+            while (hlc_mailbox_running.load())
+            {
+                if (!hlc_mailbox->read(tag, buffer, 100000000ull)) continue;
+
+                switch (tag)
+                {
+                    case cpm::HLCMailbox::TagVehicleCommandTrajectory:
+                        receive_from_hlc_mailbox_helper(buffer, trajectoryCommunication);
+                        break;
+                    case cpm::HLCMailbox::TagVehicleCommandPathTracking:
+                        receive_from_hlc_mailbox_helper(buffer, pathTrackingCommunication);
+                        break;
+                    case cpm::HLCMailbox::TagVehicleCommandSpeedCurvature:
+                        receive_from_hlc_mailbox_helper(buffer, speedCurvatureCommunication);
+                        break;
+                    case cpm::HLCMailbox::TagVehicleCommandDirect:
+                        receive_from_hlc_mailbox_helper(buffer, directCommunication);
+                        break;
+                    default:
+                        CPM_LOG(1, "Middleware received unexpected message type %u via the local mailbox", static_cast<unsigned int>(tag));
+                        break;
+                }
+
+                if (hlc_mailbox->get_lost_messages() > reported_lost_messages)
+                {
+                    reported_lost_messages = hlc_mailbox->get_lost_messages();
+                    CPM_LOG(1, "Middleware could not process all commands of the HLC in time, lost so far: %llu", static_cast<unsigned long long>(reported_lost_messages));
+                }
+            }
+        }
+
+        /**
+         * \brief Deserialize a command received via hlc_mailbox and pass it on to the typed communication
+         * \param buffer The serialized command
+         * \param communication Typed communication for the command type
+         */
+        template<class MessageType> void receive_from_hlc_mailbox_helper(const std::vector<char>& buffer, TypedCommunication<MessageType>& communication)
+        {
+            std::vector<MessageType> samples(1);
+            cpm::HLCMailbox::deserialize(buffer, samples.at(0));
+            communication.receive_from_local_mailbox(samples);
+        }
+
+        /**
+         * \brief Whether messages to the HLC should be sent via hlc_mailbox instead of DDS
+         */
+        bool use_hlc_mailbox()
+        {
+            return hlc_mailbox && hlc_mailbox->is_hlc_attached();
+        }
+
     public:
         /**
          * \brief Constructor
@@ -98,6 +168,11 @@ class Communication {
          * \param _timer Required for current real or simulated timing information to check if answers of the HLC / script are received in time
          * \param assigned_vehicle_ids List of vehicle IDs for setup of the readers (ignore other data)
          * \param active_vehicle_ids List of vehicle IDs for setup of the VehicleState/VehicleObservation readers (ignore other data). Necessary, because we want to receive VehicleState of all active vehicles, not just the ones the middleware was assigned.
+         * \param use_local_mailbox If a shared memory mailbox should be offered to a (C++) HLC on the same machine, see cpm::HLCMailbox; DDS is used as a fallback
+         * \param coalescing_slot_ns Real time only: Forward at most one command per vehicle and command type per slot of this length in ns,
+         * only the newest of the other commands is forwarded in the next slot (see CommandCoalescer). 0 to disable
+         * \param min_send_interval_ns Real time only: Minimum time between two forwarded commands of a vehicle and command type in ns, 0 to disable
+         * \param validation_limits Bounds for the structural checks of commands before they are forwarded, see CommandValidator
          */
         Communication(
             int hlcDomainNumber,
@@ -108,7 +183,11 @@ class Communication {
             std::string vehicleDirectTopicName,
             std::shared_ptr<cpm::Timer> _timer,
             std::vector<uint8_t> assigned_vehicle_ids,
-            std::vector<uint8_t> active_vehicle_ids
+            std::vector<uint8_t> active_vehicle_ids,
+            bool use_local_mailbox = true,
+            uint64_t coalescing_slot_ns = 0,
+            uint64_t min_send_interval_ns = 0,
+            CommandValidator::Limits validation_limits = CommandValidator::Limits()
         ) 
         :hlcParticipant(hlcDomainNumber, "QOS_LOCAL_COMMUNICATION.xml", "MatlabLibrary::LocalCommunicationProfile")
         ,hlcStateWriter(hlcParticipant.get_participant(), vehicleStateListTopicName)
@@ -126,15 +205,96 @@ class Communication {
             "commonroad_dds_goal_states",
             true, true)
 
-        ,vehicleReader(cpm::get_topic<VehicleState>("vehicleState"), active_vehicle_ids)
+        ,vehicleReader("vehicleState", active_vehicle_ids)
+
+        ,vehicleObservationReader("vehicleObservation", active_vehicle_ids)
+
+        ,trajectoryCommunication(hlcParticipant, vehicleTrajectoryTopicName, _timer, assigned_vehicle_ids, coalescing_slot_ns, min_send_interval_ns, validation_limits)
+        ,pathTrackingCommunication(hlcParticipant, vehiclePathTrackingTopicName, _timer, assigned_vehicle_ids, coalescing_slot_ns, min_send_interval_ns, validation_limits)
+        ,speedCurvatureCommunication(hlcParticipant, vehicleSpeedCurvatureTopicName, _timer, assigned_vehicle_ids, coalescing_slot_ns, min_send_interval_ns, validation_limits)
+        ,directCommunication(hlcParticipant, vehicleDirectTopicName, _timer, assigned_vehicle_ids, coalescing_slot_ns, min_send_interval_ns, validation_limits)
+        {
+            if (use_local_mailbox)
+            {
+                hlc_mailbox = cpm::HLCMailbox::create(hlcDomainNumber, assigned_vehicle_ids);
+                if (hlc_mailbox)
+                {
+                    hlc_mailbox_running.store(true);
+                    hlc_mailbox_thread = std::thread(&Communication::receive_from_hlc_mailbox, this);
+                }
+                else
+                {
+                    CPM_LOG(2, "%s", "Middleware could not create the local mailbox for the HLC, using DDS only");
+                }
+            }
+        }
+
+        /**
+         * \brief Destructor, stops the thread that receives commands via the local mailbox
+         */
+        ~Communication()
+        {
+            hlc_mailbox_running.store(false);
+            if (hlc_mailbox_thread.joinable())
+            {
+                hlc_mailbox_thread.join();
+            }
+        }
 
-        ,vehicleObservationReader(cpm::get_topic<VehicleObservation>("vehicleObservation"), active_vehicle_ids)
+        /**
+         * \brief Number of vehicle commands that were not forwarded because they were malformed (all command types)
+         */
+        uint64_t getRejectedCommandCount()
+        {
+            return trajectoryCommunication.getRejectedCount()
+                + pathTrackingCommunication.getRejectedCount()
+                + speedCurvatureCommunication.getRejectedCount()
+                + directCommunication.getRejectedCount();
+        }
 
-        ,trajectoryCommunication(hlcParticipant, vehicleTrajectoryTopicName, _timer, assigned_vehicle_ids)
-        ,pathTrackingCommunication(hlcParticipant, vehiclePathTrackingTopicName, _timer, assigned_vehicle_ids)
-        ,speedCurvatureCommunication(hlcParticipant, vehicleSpeedCurvatureTopicName, _timer, assigned_vehicle_ids)
-        ,directCommunication(hlcParticipant, vehicleDirectTopicName, _timer, assigned_vehicle_ids)
+        /**
+         * \brief Number of vehicle commands that were forwarded after their values were clipped / repaired (all command types)
+         */
+        uint64_t getCorrectedCommandCount()
         {
+            return trajectoryCommunication.getCorrectedCount()
+                + pathTrackingCommunication.getCorrectedCount()
+                + speedCurvatureCommunication.getCorrectedCount()
+                + directCommunication.getCorrectedCount();
+        }
+
+        /**
+         * \brief Number of vehicle commands that were not forwarded because a newer command of the HLC replaced them (all command types)
+         */
+        uint64_t getCoalescedCommandCount()
+        {
+            return trajectoryCommunication.getCoalescedCount()
+                + pathTrackingCommunication.getCoalescedCount()
+                + speedCurvatureCommunication.getCoalescedCount()
+                + directCommunication.getCoalescedCount();
+        }
+
+        /**
+         * \brief Returns the time at which the last vehicle command of an HLC was received (highest of all command types),
+         * or an empty optional if no command of the HLC was received yet
+         * \param id ID of the HLC
+         */
+        std::optional<uint64_t> getLatestHLCResponseTime(uint8_t id)
+        {
+            std::optional<uint64_t> latest_response;
+            for (auto response : {
+                trajectoryCommunication.getLatestHLCResponseTime(id),
+                speedCurvatureCommunication.getLatestHLCResponseTime(id),
+                directCommunication.getLatestHLCResponseTime(id),
+                pathTrackingCommunication.getLatestHLCResponseTime(id)
+            })
+            {
+                if (response.has_value())
+                {
+                    latest_response = std::max(latest_response.value_or(0), response.value());
+                }
+            }
+            return latest_response;
         }
 
         /**
@@ -146,35 +306,27 @@ class Communication {
          */
         bool checkHLCResponseTime(uint8_t id, uint64_t t_now, uint64_t period_nanoseconds)
         {
-            //Get latest response time of all message types
-            auto latest_response_trajectory = trajectoryCommunication.getLatestHLCResponseTime(id);
-            auto latest_response_curvature = speedCurvatureCommunication.getLatestHLCResponseTime(id);
-            auto latest_response_direct = directCommunication.getLatestHLCResponseTime(id);
-            auto latest_response_path_tracking = pathTrackingCommunication.getLatestHLCResponseTime(id);
+            auto latest_response = getLatestHLCResponseTime(id);
 
             //Check for irregularities
             // - No msg received
-            if (! (latest_response_trajectory.has_value() || latest_response_curvature.has_value() || latest_response_direct.has_value() || latest_response_path_tracking.has_value()))
+            if (! latest_response.has_value())
             {
                 //Simulated time - we have not yet received any msg
                 if (period_nanoseconds == 0)
                     return false;
 
                 //Real time - just log the error, then return
-                cpm::Logging::Instance().write(1, "HLC number %i has not yet sent any data", static_cast<int>(id));
+                CPM_LOG(1, "HLC number %i has not yet sent any data", static_cast<int>(id));
                 return true;
             }
 
-            //  (Get highest of all values)
-            auto max_latest_response = latest_response_trajectory.value_or(0);
-            max_latest_response = std::max(max_latest_response, latest_response_path_tracking.value_or(0));
-            max_latest_response = std::max(max_latest_response, latest_response_curvature.value_or(0));
-            max_latest_response = std::max(max_latest_response, latest_response_direct.value_or(0));
+            auto max_latest_response = latest_response.value();
 
             // - Undesired behaviour - log this, but do not treat it as an error
             if (t_now < max_latest_response)
             {
-                cpm::Logging::Instance().write(1, "Error: HLC %i answered with higher time than it was told to use", static_cast<int>(id));
+                CPM_LOG(1, "Error: HLC %i answered with higher time than it was told to use", static_cast<int>(id));
             }
 
             // - Period missed (real time) / no current msg received (simulated time)
@@ -189,7 +341,7 @@ class Communication {
                 stream << "Timestep missed by HLC number " << static_cast<uint32_t>(id) << ", last response: " << max_latest_response 
                     << ", current time: " << t_now 
                     << ", periods missed: " << passed_time / period_nanoseconds;
-                cpm::Logging::Instance().write(1, stream.str().c_str());
+                CPM_LOG(1, stream.str().c_str());
             }
 
             //Nothing else needs to be handled outside this function, so return true here
@@ -253,6 +405,12 @@ class Communication {
          * \param message Current vehicle states, time, periodicity of calling this function
          */
         void sendToHLC(VehicleStateList message) {
+            //Use DDS if the HLC does not use the local mailbox or if the message is too large for it
+            if (use_hlc_mailbox() && hlc_mailbox->write(cpm::HLCMailbox::TagVehicleStateList, message))
+            {
+                return;
+            }
+
             hlcStateWriter.write(message);
         }
 
@@ -302,6 +460,11 @@ class Communication {
          */
         void pass_through_system_trigger(std::vector<SystemTrigger>& samples) {
             for (auto& sample : samples) {
+                //Rare messages, so they are always sent via DDS as well (in case the HLC does not use the local mailbox yet)
+                if (use_hlc_mailbox())
+                {
+                    hlc_mailbox->write(cpm::HLCMailbox::TagSystemTrigger, sample);
+                }
                 hlc_system_trigger_writer.write(sample);
             }
         }
@@ -360,13 +523,24 @@ class Communication {
                         remaining_ids << id << " | ";
                     }
 
-                    cpm::Logging::Instance().write(2, "Still waiting for ready messages from the HLC in the Middleware for IDs: %s", remaining_ids.str().c_str());
+                    CPM_LOG(2, "Still waiting for ready messages from the HLC in the Middleware for IDs: %s", remaining_ids.str().c_str());
                 }
                 
                 usleep(200000);
                 ++wait_cycles;
             }
 
+            //The HLC attaches to the local mailbox before it sends its ready message
+            if (use_hlc_mailbox())
+            {
+                CPM_LOG(3, "%s", "Middleware: HLC uses the local mailbox (shared memory)");
+                std::cout << "\t... HLC uses the local mailbox (shared memory)" << std::endl;
+            }
+            else
+            {
+                std::cout << "\t... HLC uses DDS" << std::endl;
+            }
+
             //Tell other parts of the program that they can now regard the HLCs as being online / able to receive
             all_hlc_online.store(true);
             //Flush data that was received before the HLCs were online that is not periodical and could have been sent before
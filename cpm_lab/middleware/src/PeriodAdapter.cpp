@@ -0,0 +1,103 @@
+#include "PeriodAdapter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * \file PeriodAdapter.cpp
+ * \ingroup middleware
+ */
+
+PeriodAdapter::PeriodAdapter(
+    uint64_t _initial_period_ms,
+    uint64_t _min_period_ms,
+    uint64_t _max_period_ms,
+    uint64_t _step_ms,
+    double _percentile,
+    double _headroom,
+    size_t _window_size
+)
+:min_period_ms(std::max<uint64_t>(_min_period_ms, 1))
+,max_period_ms(std::max(_max_period_ms, std::max<uint64_t>(_min_period_ms, 1)))
+,step_ms(std::max<uint64_t>(_step_ms, 1))
+,percentile(std::min(std::max(_percentile, 0.0), 1.0))
+,headroom(std::max(_headroom, 1.0))
+,window_size(std::max<size_t>(_window_size, 1))
+,min_samples(std::max<size_t>(window_size / 5, 1))
+,period_ms(std::min(std::max(_initial_period_ms, min_period_ms), max_period_ms))
+{
+    percentile_buffer.reserve(window_size);
+}
+
+void PeriodAdapter::add_sample(uint8_t id, uint64_t response_time_ns)
+{
+    auto& window = windows[id];
+    if (window.response_times.size() != window_size)
+    {
+        window.response_times.resize(window_size);
+    }
+
+    window.response_times.at(window.next) = response_time_ns;
+    window.next = (window.next + 1) % window_size;
+    window.count = std::min(window.count + 1, window_size);
+}
+
+void PeriodAdapter::add_response_time(uint8_t id, uint64_t response_time_ns)
+{
+    add_sample(id, response_time_ns);
+}
+
+void PeriodAdapter::add_missed_period(uint8_t id)
+{
+    //The actual response time is unknown, but at least one period
+    add_sample(id, period_ms * 1000000ull);
+}
+
+std::optional<uint64_t> PeriodAdapter::get_required_period_ms()
+{
+    //The slowest HLC determines the period
+    std::optional<uint64_t> slowest_ns;
+    for (auto& entry : windows)
+    {
+        auto& window = entry.second;
+        if (window.count < min_samples) continue;
+
+        percentile_buffer.assign(window.response_times.begin(), window.response_times.begin() + window.count);
+        //Rank of the percentile in [1, count], s.t. percentile 0 selects the fastest response time
+        size_t rank = std::max<size_t>(static_cast<size_t>(std::ceil(percentile * window.count)), 1);
+        size_t index = std::min(rank, window.count) - 1;
+        std::nth_element(percentile_buffer.begin(), percentile_buffer.begin() + index, percentile_buffer.end());
+
+        slowest_ns = std::max(slowest_ns.value_or(0), percentile_buffer.at(index));
+    }
+
+    if (!slowest_ns.has_value()) return std::nullopt;
+
+    //Round up to the next step, then limit to the bounds
+    double required_ms = static_cast<double>(slowest_ns.value()) * headroom / 1e6;
+    uint64_t steps = static_cast<uint64_t>(std::ceil(required_ms / static_cast<double>(step_ms)));
+    uint64_t required_period_ms = std::max<uint64_t>(steps, 1) * step_ms;
+    return std::min(std::max(required_period_ms, min_period_ms), max_period_ms);
+}
+
+std::optional<uint64_t> PeriodAdapter::update()
+{
+    ++periods_since_change;
+
+    auto required_period_ms = get_required_period_ms();
+    if (!required_period_ms.has_value()) return std::nullopt;
+
+    //Increase immediately, decrease only after a whole window with the current period (hysteresis)
+    bool increase = required_period_ms.value() > period_ms;
+    bool decrease = required_period_ms.value() < period_ms && periods_since_change >= window_size;
+    if (!increase && !decrease) return std::nullopt;
+
+    period_ms = required_period_ms.value();
+    periods_since_change = 0;
+    return period_ms;
+}
+
+uint64_t PeriodAdapter::get_period_ms()
+{
+    return period_ms;
+}
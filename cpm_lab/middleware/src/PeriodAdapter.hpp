@@ -0,0 +1,115 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \class PeriodAdapter
+ * \brief Adapts the period of the middleware to the measured response times of the HLCs (optional, real time only).
+ * For each HLC, the response times of the last periods are stored (time from the start of a period until the last command
+ * of the HLC in that period was received; a period without a response counts as a response time of one period).
+ * The required period is a percentile of the response times of the slowest HLC plus some headroom, rounded up to a multiple of the step size
+ * and limited by the configured bounds.
+ * The period is increased as soon as the required period is higher than the current one, but only decreased if the required period
+ * has been lower for a whole window of periods since the last change (hysteresis), s.t. the period does not oscillate.
+ * \ingroup middleware
+ */
+class PeriodAdapter {
+    private:
+        /**
+         * \struct ResponseWindow
+         * \brief Ring buffer of the last response times of an HLC
+         */
+        struct ResponseWindow {
+            //! Response times in ns, allocated once with the window size
+            std::vector<uint64_t> response_times;
+            //! Position of the next write in response_times
+            size_t next = 0;
+            //! Number of valid entries in response_times
+            size_t count = 0;
+        };
+
+        //! Lower bound of the period in ms
+        uint64_t min_period_ms;
+        //! Upper bound of the period in ms
+        uint64_t max_period_ms;
+        //! Periods are multiples of this step in ms
+        uint64_t step_ms;
+        //! Percentile of the response times that must fit into the period, in [0, 1]
+        double percentile;
+        //! Factor that is applied to the percentile to get the required period
+        double headroom;
+        //! Number of response times per HLC that are considered
+        size_t window_size;
+        //! Minimum number of response times of an HLC before the period is adapted
+        size_t min_samples;
+
+        //! Current period in ms
+        uint64_t period_ms;
+        //! Number of periods since the last change of the period
+        size_t periods_since_change = 0;
+        //! Response times per HLC ID
+        std::map<uint8_t, ResponseWindow> windows;
+        //! Buffer to compute percentiles without allocations
+        std::vector<uint64_t> percentile_buffer;
+
+        /**
+         * \brief Store a response time of an HLC
+         * \param id ID of the HLC
+         * \param response_time_ns The response time in ns
+         */
+        void add_sample(uint8_t id, uint64_t response_time_ns);
+
+    public:
+        /**
+         * \brief Constructor
+         * \param _initial_period_ms Period at the start in ms, is limited by the bounds
+         * \param _min_period_ms Lower bound of the period in ms
+         * \param _max_period_ms Upper bound of the period in ms
+         * \param _step_ms Periods are multiples of this step in ms
+         * \param _percentile Percentile of the response times that must fit into the period, in [0, 1] (0: fastest, 1: slowest response time)
+         * \param _headroom Factor that is applied to the percentile to get the required period, e.g. 1.2 for 20% headroom
+         * \param _window_size Number of response times per HLC that are considered, also the number of periods before the period may be decreased again
+         */
+        PeriodAdapter(
+            uint64_t _initial_period_ms,
+            uint64_t _min_period_ms,
+            uint64_t _max_period_ms,
+            uint64_t _step_ms = 10,
+            double _percentile = 0.99,
+            double _headroom = 1.2,
+            size_t _window_size = 100
+        );
+
+        /**
+         * \brief Add the response time of an HLC in the last period
+         * \param id ID of the HLC
+         * \param response_time_ns Time from the start of the period until the last response of the HLC in it, in ns
+         */
+        void add_response_time(uint8_t id, uint64_t response_time_ns);
+
+        /**
+         * \brief Register that an HLC did not respond in the last period
+         * \param id ID of the HLC
+         */
+        void add_missed_period(uint8_t id);
+
+        /**
+         * \brief Decide on the period of the next periods, should be called once per period after the response times were added
+         * \return The new period in ms if it changed, else nothing
+         */
+        std::optional<uint64_t> update();
+
+        /**
+         * \brief Current period in ms
+         */
+        uint64_t get_period_ms();
+
+        /**
+         * \brief Required period in ms according to the current response times (not limited by the hysteresis),
+         * or nothing if not enough response times are known yet
+         */
+        std::optional<uint64_t> get_required_period_ms();
+};
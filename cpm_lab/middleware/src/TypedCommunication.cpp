@@ -5,14 +5,20 @@
  * \ingroup middleware
  */
 
-template<> void TypedCommunication<VehicleCommandTrajectory>::type_specific_msg_check(VehicleCommandTrajectory msg)
+template<> uint32_t TypedCommunication<VehicleCommandTrajectory>::type_specific_msg_check(VehicleCommandTrajectory& msg)
 {
     auto set_id = msg.vehicle_id();
 
+    //Structural checks, the command is not forwarded if they fail
+    uint32_t issues = validator.check_trajectory_points(msg.trajectory_points());
+    if (issues & CommandValidator::RejectMask) return issues;
+
+    //Further checks only create warnings
+
     //1. Make sure that enough points have been set (2 points or less are not sufficient)
     if (msg.trajectory_points().size() < 3)
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1,
             "Middleware (ID %i): HLC script sent too few trajectory points, cannot be used for interpolation",
             static_cast<int>(set_id)
@@ -22,7 +28,7 @@ template<> void TypedCommunication<VehicleCommandTrajectory>::type_specific_msg_
     //2. Check how many of the set trajectory points lie in the past / future
     size_t num_past_trajectories = 0;
     uint64_t current_time = msg.header().valid_after_stamp().nanoseconds();
-    for (auto point : msg.trajectory_points())
+    for (const auto& point : msg.trajectory_points())
     {
         if (point.t().nanoseconds() < current_time)
         {
@@ -37,7 +43,7 @@ template<> void TypedCommunication<VehicleCommandTrajectory>::type_specific_msg_
     //  a) At least one trajectory point must be in the past, or interpolation is not possible
     if (num_past_trajectories == 0)
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1,
             "Middleware (ID %i): HLC script sent no past trajectory points, cannot be used for interpolation",
             static_cast<int>(set_id)
@@ -46,57 +52,36 @@ template<> void TypedCommunication<VehicleCommandTrajectory>::type_specific_msg_
     //  b) At least one trajectory point must be in the future, or interpolation is not possible
     if (num_past_trajectories == msg.trajectory_points().size())
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1,
             "Middleware (ID %i): HLC script sent no future trajectory points, cannot be used for interpolation",
             static_cast<int>(set_id)
         );
     }
+
+    return issues;
 }
 
-template<> void TypedCommunication<VehicleCommandPathTracking>::type_specific_msg_check(VehicleCommandPathTracking msg)
+template<> uint32_t TypedCommunication<VehicleCommandPathTracking>::type_specific_msg_check(VehicleCommandPathTracking& msg)
 {
     auto set_id = msg.vehicle_id();
     auto path_length = msg.path().size();
 
-    //1. Make sure that enough points have been set (less than 2 points are not sufficient)
-    if (path_length < 2) {
-        cpm::Logging::Instance().write(
-            1,
-            "Middleware (ID %i): HLC script sent sent too few path tracking points, cannot be used for interpolation",
-            static_cast<int>(set_id)
-        );
-    }
-
-    //2. Make sure the first path tracking point is valid (s must be zero)
-    if (msg.path().at(0).s() != 0) {
-        cpm::Logging::Instance().write(
-            1,
-            "Middleware (ID %i): HLC script sent invalid first path point, s must be 0",
-            static_cast<int>(set_id)
-        );
-    }
-
-    //3. Make sure consecutive path points have increasing s
-    for (std::size_t i = 0; i < path_length - 1; ++i)
-    {
-        std::size_t j = i + 1;
-        if (msg.path().at(j).s() <= msg.path().at(i).s()) {
-            cpm::Logging::Instance().write(
-                1,
-                "Middleware (ID %i): HLC script sent invalid path points, s must be increasing",
-                static_cast<int>(set_id)
-            );
-        }
-    }
+    //Structural checks (at least two points, finite values within bounds, first s is 0 and s is increasing),
+    //the command is not forwarded if they fail
+    uint32_t issues = validator.check_path_points(msg.path());
+    double speed = msg.speed();
+    issues |= validator.check_speed(speed);
+    msg.speed(speed);
+    if (issues & CommandValidator::RejectMask) return issues;
 
-    //4. Make sure first and last pose are identical
+    //Make sure first and last pose are identical (only creates a warning)
     Pose2D first = msg.path().at(0).pose();
     Pose2D last = msg.path().at(path_length - 1).pose();
 
     if (first.x() != last.x())
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1,
             "Middleware (ID %i): HLC script sent invalid path points, first and last x value differ",
             static_cast<int>(set_id)
@@ -105,7 +90,7 @@ template<> void TypedCommunication<VehicleCommandPathTracking>::type_specific_ms
 
     if (first.y() != last.y())
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1,
             "Middleware (ID %i): HLC script sent invalid path points, first and last y value differ",
             static_cast<int>(set_id)
@@ -114,10 +99,32 @@ template<> void TypedCommunication<VehicleCommandPathTracking>::type_specific_ms
 
     if (first.yaw() != last.yaw())
     {
-        cpm::Logging::Instance().write(
+        CPM_LOG(
             1,
             "Middleware (ID %i): HLC script sent invalid path points, first and last yaw value differ",
             static_cast<int>(set_id)
         );
     }
-}
\ No newline at end of file
+
+    return issues;
+}
+
+template<> uint32_t TypedCommunication<VehicleCommandSpeedCurvature>::type_specific_msg_check(VehicleCommandSpeedCurvature& msg)
+{
+    double speed = msg.speed();
+    double curvature = msg.curvature();
+    uint32_t issues = validator.check_speed(speed) | validator.check_curvature(curvature);
+    msg.speed(speed);
+    msg.curvature(curvature);
+    return issues;
+}
+
+template<> uint32_t TypedCommunication<VehicleCommandDirect>::type_specific_msg_check(VehicleCommandDirect& msg)
+{
+    double motor_throttle = msg.motor_throttle();
+    double steering_servo = msg.steering_servo();
+    uint32_t issues = validator.check_direct_input(motor_throttle) | validator.check_direct_input(steering_servo);
+    msg.motor_throttle(motor_throttle);
+    msg.steering_servo(steering_servo);
+    return issues;
+}
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <optional>
 #include <string>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <cassert>
 #include <type_traits>
@@ -23,6 +27,10 @@
 #include "cpm/VehicleIDFilteredTopic.hpp"
 #include "cpm/Writer.hpp"
 #include "cpm/Participant.hpp"
+#include "cpm/get_time_ns.hpp"
+
+#include "CommandCoalescer.hpp"
+#include "CommandValidator.hpp"
 
 using namespace std::placeholders;
 
@@ -62,6 +70,70 @@ template<class MessageType> class TypedCommunication {
         //! To check messages received from the HLC regarding their consistency with the timing managed by the middleware. In nanoseconds. 
         std::atomic<uint64_t> current_period_start{0};
 
+        //! Structural checks of the commands before they are forwarded, see type_specific_msg_check
+        CommandValidator validator;
+
+        //Optional coalescing of commands (real time only)
+        //! Decides which commands are forwarded to the vehicles, nullptr if every command is forwarded right away
+        std::unique_ptr<CommandCoalescer<MessageType>> coalescer;
+        //! Mutex for access to coalescer, also held while forwarding to keep the order of the commands
+        std::mutex coalescing_mutex;
+        //! Wakes up coalescing_thread when a command was held back
+        std::condition_variable coalescing_cv;
+        //! Forwards held back commands once they are due
+        std::thread coalescing_thread;
+        //! Stop condition for coalescing_thread
+        std::atomic_bool coalescing_running{false};
+
+        /**
+         * \brief Forward a command received by the HLC to the vehicle, or hold it back if coalescing is enabled
+         * \param message The command
+         */
+        void forwardToVehicle(const MessageType& message)
+        {
+            if (!coalescer)
+            {
+                sendToVehicle(message);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(coalescing_mutex);
+            auto forward = coalescer->offer(message, cpm::get_time_ns(), current_period_start.load());
+            if (forward.has_value())
+            {
+                sendToVehicle(forward.value());
+            }
+            else
+            {
+                coalescing_cv.notify_one();
+            }
+        }
+
+        /**
+         * \brief Forward held back commands once they are due, until coalescing_running is false
+         */
+        void forward_coalesced_commands()
+        {
+            std::unique_lock<std::mutex> lock(coalescing_mutex);
+            while (coalescing_running.load())
+            {
+                for (auto& message : coalescer->take_due(cpm::get_time_ns(), current_period_start.load()))
+                {
+                    sendToVehicle(message);
+                }
+
+                //Sleep until the next command is due, but check the stop condition regularly
+                std::chrono::nanoseconds timeout(100000000ull);
+                auto next_due = coalescer->next_due(current_period_start.load());
+                if (next_due.has_value())
+                {
+                    uint64_t now = cpm::get_time_ns();
+                    timeout = std::chrono::nanoseconds((next_due.value() > now) ? std::min<uint64_t>(next_due.value() - now, 100000000ull) : 0);
+                }
+                coalescing_cv.wait_for(lock, timeout);
+            }
+        }
+
         /**
          * \brief Handler for vehicle commands received by the HLC.
          * Passes the commands on to the vehicle.
@@ -75,8 +147,30 @@ template<class MessageType> class TypedCommunication {
             for (auto& data : samples) {
                 uint64_t receive_timestamp = timer->get_time();
 
-                //First send the data to the vehicle
-                sendToVehicle(data);
+                //Structural and type specific checks (like finite values and plausible trajectory points) before forwarding:
+                //Malformed commands are not forwarded, clipped / repaired commands are
+                bool forward = true;
+                if (validator.is_enabled())
+                {
+                    uint32_t issues = type_specific_msg_check(data);
+                    forward = validator.record(issues);
+                    if (issues != CommandValidator::IssueNone)
+                    {
+                        CPM_LOG(
+                            forward ? 2 : 1,
+                            "Middleware (ID %i): %s command of HLC script (%s)",
+                            static_cast<int>(data.vehicle_id()),
+                            forward ? "Corrected" : "Rejected",
+                            CommandValidator::describe(issues).c_str()
+                        );
+                    }
+                }
+
+                //Then send the data to the vehicle (or hold it back for coalescing)
+                if (forward)
+                {
+                    forwardToVehicle(data);
+                }
 
                 //Then update the last response time of the HLC that sent the data
                 std::lock_guard<std::mutex> lock(map_mutex);
@@ -94,7 +188,7 @@ template<class MessageType> class TypedCommunication {
                 if(std::find(vehicle_ids.begin(), vehicle_ids.end(), set_id) == vehicle_ids.end())
                 {
                     //ID should not have been sent, print warning
-                    cpm::Logging::Instance().write(
+                    CPM_LOG(
                         1,
                         "Middleware received vehicle ID %i from HLC script - ID was not set to be used!",
                         static_cast<int>(set_id)
@@ -108,7 +202,7 @@ template<class MessageType> class TypedCommunication {
                 //     must be wrong - after all, it runs on the same machine, so the same clock is being used
                 if (header_create_stamp > current_time)
                 {
-                    cpm::Logging::Instance().write(
+                    CPM_LOG(
                         1,
                         "Middleware (ID %i) received creation stamp from HLC script that lies in the future - this must be a mistake",
                         static_cast<int>(set_id)
@@ -118,31 +212,31 @@ template<class MessageType> class TypedCommunication {
                 //     Missed periods are also checked in Communication, but only in terms of an absolute time diff
                 if (header_create_stamp < current_period_start.load())
                 {
-                    cpm::Logging::Instance().write(
+                    CPM_LOG(
                         1,
                         "Middleware (ID %i): Received HLC message missed the current period",
                         static_cast<int>(set_id)
                     );
                 }
-
-                //Perform type specific checks (like amount of trajectory points for trajectory data)
-                type_specific_msg_check(data);
             }
         }
 
-        //Ignore warning that t_start is unused
+        //Ignore warning that msg is unused
         #pragma GCC diagnostic push
         #pragma GCC diagnostic ignored "-Wunused-parameter"
 
         /**
          * \brief Type specific / unspecific handler, 
-         * the actual check depends on the message type and can be found in the .cpp file for this class
+         * the actual check depends on the message type and can be found in the .cpp file for this class.
+         * Uses validator for the structural checks; values may be clipped / repaired in place.
          * \param msg Message to check
+         * \return Found issues, see CommandValidator::Issue
          */
-        void type_specific_msg_check(MessageType msg)
+        uint32_t type_specific_msg_check(MessageType& msg)
         {
             //Unspecific version, thus empty
             //Specializations can be found in the .cpp file
+            return CommandValidator::IssueNone;
         }
 
         #pragma GCC diagnostic pop
@@ -155,12 +249,19 @@ template<class MessageType> class TypedCommunication {
          * \param vehicleCommandTopicName Topic name for the selected message type
          * \param _timer To get the current time for real and simulated timing
          * \param _vehicle_ids List of IDs the Middleware and HLC are responsible for
+         * \param coalescing_slot_ns Coalescing (real time only): At most one command per vehicle is forwarded per slot of this length in ns 
+         * (slots start with each period), only the newest of the remaining commands is forwarded in the next slot. 0 to disable
+         * \param min_send_interval_ns Coalescing (real time only): Minimum time between two forwarded commands of a vehicle in ns, 0 to disable
+         * \param validation_limits Bounds for the structural checks of the commands before forwarding, see CommandValidator
          */
         TypedCommunication(
             cpm::Participant& hlcParticipant,
             std::string vehicleCommandTopicName,
             std::shared_ptr<cpm::Timer> _timer,
-            std::vector<uint8_t> _vehicle_ids
+            std::vector<uint8_t> _vehicle_ids,
+            uint64_t coalescing_slot_ns = 0,
+            uint64_t min_send_interval_ns = 0,
+            CommandValidator::Limits validation_limits = CommandValidator::Limits()
         )
         :
         hlcCommandReader(std::bind(&TypedCommunication::handler, this, _1), hlcParticipant, vehicleCommandTopicName)
@@ -168,9 +269,58 @@ template<class MessageType> class TypedCommunication {
         ,timer(_timer)
         ,lastHLCResponseTimes()
         ,vehicle_ids(_vehicle_ids)
+        ,validator(validation_limits)
         {
             static_assert(std::is_same<decltype(std::declval<MessageType>().vehicle_id()), uint8_t>::value, "IDL type must have a vehicle_id.");
             static_assert(std::is_same<decltype(std::declval<MessageType>().header().create_stamp().nanoseconds()), unsigned long long>::value, "IDL type must use the Header IDL as header.");
+
+            if (coalescing_slot_ns > 0 || min_send_interval_ns > 0)
+            {
+                coalescer = std::unique_ptr<CommandCoalescer<MessageType>>(new CommandCoalescer<MessageType>(coalescing_slot_ns, min_send_interval_ns));
+                coalescing_running.store(true);
+                coalescing_thread = std::thread(&TypedCommunication::forward_coalesced_commands, this);
+            }
+        }
+
+        /**
+         * \brief Destructor, stops the thread that forwards coalesced commands
+         */
+        ~TypedCommunication()
+        {
+            coalescing_running.store(false);
+            coalescing_cv.notify_all();
+            if (coalescing_thread.joinable())
+            {
+                coalescing_thread.join();
+            }
+        }
+
+        /**
+         * \brief Number of commands that were not forwarded because they were malformed, see CommandValidator
+         */
+        uint64_t getRejectedCount()
+        {
+            return validator.get_rejected_count();
+        }
+
+        /**
+         * \brief Number of commands that were forwarded after their values were clipped / repaired, see CommandValidator
+         */
+        uint64_t getCorrectedCount()
+        {
+            return validator.get_fixed_count();
+        }
+
+        /**
+         * \brief Number of commands that were dropped because a newer command for the same vehicle replaced them before 
+         * they were forwarded (0 if coalescing is disabled)
+         */
+        uint64_t getCoalescedCount()
+        {
+            if (!coalescer) return 0;
+
+            std::lock_guard<std::mutex> lock(coalescing_mutex);
+            return coalescer->get_coalesced_count();
         }
 
         /**
@@ -202,6 +352,15 @@ template<class MessageType> class TypedCommunication {
             vehicleWriter.write(message);
         }
 
+        /**
+         * \brief Handle commands that were received from the HLC via the local mailbox instead of DDS (see cpm::HLCMailbox), 
+         * in the same way as commands received via DDS
+         * \param samples Received vehicle commands by the HLC
+         */
+        void receive_from_local_mailbox(std::vector<MessageType>& samples) {
+            handler(samples);
+        }
+
         /**
          * \brief Update the current period start time stored in typed communication for internal checks
          * \param t_now Current period time, obtained by the cpm timer
@@ -5,7 +5,9 @@
  * \ingroup middleware
  */
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <functional>
@@ -19,6 +21,7 @@
 #include "VehicleStateList.hpp"
 
 #include "Communication.hpp"
+#include "PeriodAdapter.hpp"
 
 /**
  * \brief The Middleware's main function
@@ -36,6 +39,9 @@ int main (int argc, char *argv[]) {
     std::string node_id = cpm::cmd_parameter_string("node_id", "middleware", argc, argv);
     cpm::Logging::Instance().set_id(node_id); 
     uint64_t offset_nanoseconds = cpm::cmd_parameter_uint64_t("offset_nanoseconds", 1, argc, argv);
+    //Alternatively: Let the offset be allocated automatically (after the vehicles, before HLC timers), s.t. not all nodes on this machine wake up at once
+    bool stagger_offset = cpm::cmd_parameter_bool("stagger_offset", false, argc, argv);
+    uint64_t expected_compute_nanoseconds = cpm::cmd_parameter_uint64_t("expected_compute_nanoseconds", 2000000, argc, argv);
     //uint64_t period_nanoseconds = cpm::cmd_parameter_uint64_t("period_nanoseconds", 250000000, argc, argv);
     bool simulated_time_allowed = true;
     bool simulated_time = cpm::cmd_parameter_bool("simulated_time", false, argc, argv);
@@ -46,6 +52,12 @@ int main (int argc, char *argv[]) {
     uint64_t period_ms = cpm::parameter_uint64_t("middleware_period_ms");
     uint64_t period_nanoseconds = period_ms * 1e6;
 
+    //Adaptive period (real time only): Adjust the period within the bounds to the measured response times of the HLCs
+    bool adaptive_period = cpm::cmd_parameter_bool("adaptive_period", false, argc, argv);
+    uint64_t min_period_ms = cpm::cmd_parameter_uint64_t("min_period_ms", std::max<uint64_t>(10, period_ms / 4), argc, argv);
+    uint64_t max_period_ms = cpm::cmd_parameter_uint64_t("max_period_ms", 2 * period_ms, argc, argv);
+    double adaptive_period_percentile = cpm::cmd_parameter_double("adaptive_period_percentile", 0.99, argc, argv);
+
     std::cout << "Waiting for parameter 'active_vehicle_ids' set by LCC ..." << std::endl;
     std::vector<int32_t> active_vehicle_ids = cpm::parameter_ints("active_vehicle_ids");
     std::vector<uint8_t> unsigned_active_vehicle_ids( active_vehicle_ids.begin(), active_vehicle_ids.end() );
@@ -53,6 +65,18 @@ int main (int argc, char *argv[]) {
     std::cout << std::endl;
     //Communication parameters
     int hlcDomainNumber = cpm::cmd_parameter_int("domain_number", 1, argc, argv); 
+    //Offer a shared memory mailbox to a C++ HLC on the same machine (DDS is still used for other HLCs)
+    bool use_local_mailbox = cpm::cmd_parameter_bool("local_mailbox", true, argc, argv);
+    //Coalescing of commands (real time only): Forward only the newest command per vehicle and command type within a slot (0: one period)
+    //and keep a minimum interval between forwarded commands of a vehicle, to reduce the load of chatty HLCs on the vehicle network
+    bool coalesce_commands = cpm::cmd_parameter_bool("coalesce_commands", false, argc, argv);
+    uint64_t coalescing_slot_ms = cpm::cmd_parameter_uint64_t("coalescing_slot_ms", 0, argc, argv);
+    uint64_t min_send_interval_ms = cpm::cmd_parameter_uint64_t("min_send_interval_ms", 0, argc, argv);
+    //Structural checks of commands before forwarding: Malformed commands (NaN, jumps, ...) are rejected, too high speeds etc. are clipped
+    CommandValidator::Limits validation_limits;
+    validation_limits.enabled = cpm::cmd_parameter_bool("validate_commands", true, argc, argv);
+    validation_limits.max_speed = cpm::cmd_parameter_double("command_max_speed", validation_limits.max_speed, argc, argv);
+    validation_limits.max_curvature = cpm::cmd_parameter_double("command_max_curvature", validation_limits.max_curvature, argc, argv);
     
     //Vehicle ID(s) set in command line, correspond to HLC IDs
     //Vehicle amount: Tell system amount of vehicles, IDs range from 1 to vehicle_amount
@@ -76,7 +100,12 @@ int main (int argc, char *argv[]) {
         << "Domain ID HLC:  " << hlcDomainNumber << std::endl
         << "Simulated time: " << simulated_time << std::endl
         << "Wait for start: " << wait_for_start << std::endl
-        << "Period (ns):    " << period_nanoseconds << std::endl;
+        << "Stagger offset: " << stagger_offset << std::endl
+        << "Local mailbox:  " << use_local_mailbox << std::endl
+        << "Validation:     " << validation_limits.enabled << " (max. speed " << validation_limits.max_speed << " m/s, max. curvature " << validation_limits.max_curvature << " 1/m)" << std::endl
+        << "Coalescing:     " << coalesce_commands << " (slot " << coalescing_slot_ms << " ms, min. interval " << min_send_interval_ms << " ms)" << std::endl
+        << "Period (ns):    " << period_nanoseconds << std::endl
+        << "Adapt. period:  " << adaptive_period << " (" << min_period_ms << " - " << max_period_ms << " ms, percentile " << adaptive_period_percentile << ")" << std::endl;
 
 
     //Get unsigned vehicle ids only if vehicle_amount was not correctly set
@@ -89,7 +118,7 @@ int main (int argc, char *argv[]) {
         }
         else {
             std::cerr << "Incompatible vehicle id" << std::endl;
-            cpm::Logging::Instance().write(
+            CPM_LOG(
                 1, 
                 "%s",
                 "Middleware: Incompatible vehicle ids set - not within 0 and 255"
@@ -111,7 +140,7 @@ int main (int argc, char *argv[]) {
             }
             else {
                 std::cerr << "Incompatible vehicle id" << std::endl;
-                cpm::Logging::Instance().write(
+                CPM_LOG(
                     1, 
                     "%s",
                     "Middleware: Incompatible vehicle ids set - not within 0 and 255"
@@ -120,16 +149,56 @@ int main (int argc, char *argv[]) {
         }
         if (unsigned_vehicle_ids.size() == 0) {
             std::cerr << "No vehicle ids set!" << std::endl;
-            cpm::Logging::Instance().write(1, "Error in middleware - %s", "No vehicle IDs set");
+            CPM_LOG(1, "Error in middleware - %s", "No vehicle IDs set");
             exit(EXIT_FAILURE);
         }
     }
 
     //Initialize the timer
     std::cout << "Initializing Timer..." << std::endl;
-    std::shared_ptr<cpm::Timer> timer = cpm::Timer::create(node_id, period_nanoseconds, offset_nanoseconds, wait_for_start, simulated_time_allowed, simulated_time);
+    std::shared_ptr<cpm::Timer> timer;
+    if (stagger_offset)
+    {
+        timer = cpm::Timer::create_staggered(node_id, period_nanoseconds, expected_compute_nanoseconds, cpm::PhaseAllocator::StageMiddleware, wait_for_start, simulated_time_allowed, simulated_time);
+    }
+    else
+    {
+        timer = cpm::Timer::create(node_id, period_nanoseconds, offset_nanoseconds, wait_for_start, simulated_time_allowed, simulated_time);
+    }
     std::cout << "...done." << std::endl;
 
+    std::optional<PeriodAdapter> period_adapter;
+    if (adaptive_period)
+    {
+        if (simulated_time)
+        {
+            CPM_LOG(2, "%s", "Middleware: The adaptive period is only supported in real time, using a fixed period");
+        }
+        else
+        {
+            period_adapter.emplace(period_ms, min_period_ms, max_period_ms, 10, adaptive_period_percentile);
+        }
+    }
+    //Start of the previous period, to measure the response times of the HLCs in it
+    uint64_t last_period_start = 0;
+    //Coalesced commands at the last log entry, s.t. the count is only logged when it changed
+    uint64_t last_logged_coalesced_count = 0;
+
+    uint64_t coalescing_slot_ns = 0;
+    uint64_t min_send_interval_ns = 0;
+    if (coalesce_commands)
+    {
+        if (simulated_time)
+        {
+            CPM_LOG(2, "%s", "Middleware: Coalescing of commands is only supported in real time, every command is forwarded");
+        }
+        else
+        {
+            coalescing_slot_ns = ((coalescing_slot_ms > 0) ? coalescing_slot_ms : period_ms) * 1000000ull;
+            min_send_interval_ns = min_send_interval_ms * 1000000ull;
+        }
+    }
+
     //Initialize the communication (TODO later: depending on message type for commands, can change dynamically)
     std::cout << "Initializing Communication..." << std::endl;
     std::shared_ptr<Communication> communication = std::make_shared<Communication>(
@@ -141,7 +210,11 @@ int main (int argc, char *argv[]) {
         vehicleDirectTopicName,
         timer,
         unsigned_vehicle_ids,
-        unsigned_active_vehicle_ids
+        unsigned_active_vehicle_ids,
+        use_local_mailbox,
+        coalescing_slot_ns,
+        min_send_interval_ns,
+        validation_limits
     );
     std::cout << "...done." << std::endl;
 
@@ -172,15 +245,13 @@ int main (int argc, char *argv[]) {
         communication->sendToHLC(state_list);
 
         //Log the received vehicle data size / sample size for verbose log level
-        std::stringstream stream;
-        stream << "Got latest messages, state array size: " << states.size();
+        //This is logged every period, so the binary log is used: Formatting is deferred to the LCC
         if (states.size() > 0) {
-            stream << " - sample data: " << states.at(0).battery_voltage();
+            CPM_LOG_BINARY(3, "Got latest messages, state array size: %zu - sample data: %f", states.size(), states.at(0).battery_voltage());
+        }
+        else {
+            CPM_LOG_BINARY(3, "Got latest messages, state array size: %zu", states.size());
         }
-        cpm::Logging::Instance().write(
-            3, 
-            stream.str().c_str()
-        );
 
         //Check the last response time of the HLC
         // Real time -> Print an error message if a period has been missed
@@ -212,7 +283,7 @@ int main (int argc, char *argv[]) {
                 if (count > 50)
                 {
                     count = 0;
-                    cpm::Logging::Instance().write(2, "Still waiting for a response from HLC with ID %i (and potentially others)", static_cast<int>(missing_id));
+                    CPM_LOG(2, "Still waiting for a response from HLC with ID %i (and potentially others)", static_cast<int>(missing_id));
                 }
             }
         }
@@ -227,6 +298,46 @@ int main (int argc, char *argv[]) {
             for (uint8_t id : unsigned_vehicle_ids) {
                 communication->checkHLCResponseTime(id, timer->get_time(), period_nanoseconds);
             }
+
+            //Adaptive period: Response time of each HLC in the previous period, then possibly change the period
+            //The new period is announced to the HLCs with the next VehicleStateList (period_ms)
+            if (period_adapter.has_value())
+            {
+                if (last_period_start != 0)
+                {
+                    for (uint8_t id : unsigned_vehicle_ids) {
+                        auto latest_response = communication->getLatestHLCResponseTime(id);
+                        if (latest_response.has_value() && latest_response.value() >= last_period_start)
+                        {
+                            period_adapter->add_response_time(id, latest_response.value() - last_period_start);
+                        }
+                        else
+                        {
+                            period_adapter->add_missed_period(id);
+                        }
+                    }
+                }
+
+                auto new_period_ms = period_adapter->update();
+                if (new_period_ms.has_value() && timer->set_period(new_period_ms.value() * 1000000ull))
+                {
+                    CPM_LOG(2, "Middleware: Changed period from %llu ms to %llu ms", 
+                        static_cast<unsigned long long>(period_ms), static_cast<unsigned long long>(new_period_ms.value()));
+                    period_ms = new_period_ms.value();
+                    period_nanoseconds = period_ms * 1000000ull;
+                }
+            }
+            last_period_start = t_now;
+
+            if (coalescing_slot_ns > 0)
+            {
+                uint64_t coalesced_count = communication->getCoalescedCommandCount();
+                if (coalesced_count > last_logged_coalesced_count)
+                {
+                    CPM_LOG_BINARY(3, "Coalesced commands so far: %llu", static_cast<unsigned long long>(coalesced_count));
+                    last_logged_coalesced_count = coalesced_count;
+                }
+            }
         }
     });
 
@@ -236,4 +347,14 @@ int main (int argc, char *argv[]) {
     std::cin.get();
     std::cout << "Exiting program" << std::endl;
     timer->stop();
+
+    if (validation_limits.enabled)
+    {
+        std::cout << "Rejected commands: " << communication->getRejectedCommandCount() 
+            << ", corrected commands: " << communication->getCorrectedCommandCount() << std::endl;
+    }
+    if (coalescing_slot_ns > 0)
+    {
+        std::cout << "Coalesced commands: " << communication->getCoalescedCommandCount() << std::endl;
+    }
 }
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VehicleState.hpp"
+#include "VehicleStateList.hpp"
+#include "VehicleCommandTrajectory.hpp"
+
+#include "cpm/AsyncReader.hpp"
+#include "cpm/CommandLineReader.hpp"
+#include "cpm/HLCMailbox.hpp"
+#include "cpm/Logging.hpp"
+#include "cpm/Participant.hpp"
+#include "cpm/Writer.hpp"
+#include "cpm/get_time_ns.hpp"
+
+/**
+ * \file hlc_mailbox_benchmark.cpp
+ * \brief Compares the round-trip latency between Middleware and a local HLC via DDS (QOS_LOCAL_COMMUNICATION.xml)
+ * and via the shared memory mailbox (cpm::HLCMailbox): A VehicleStateList is sent to a fake HLC, which answers
+ * with one VehicleCommandTrajectory per vehicle.
+ * Usage: ./hlc_mailbox_benchmark --iterations=1000 --vehicles=4
+ * \ingroup middleware
+ */
+
+/**
+ * \brief Create the VehicleStateList that is sent in each iteration
+ * \param vehicle_ids IDs of the vehicles in the list
+ * \ingroup middleware
+ */
+static VehicleStateList create_state_list(const std::vector<uint8_t>& vehicle_ids)
+{
+    std::vector<VehicleState> states;
+    for (auto id : vehicle_ids)
+    {
+        VehicleState state;
+        state.vehicle_id(id);
+        states.push_back(state);
+    }
+
+    VehicleStateList state_list;
+    state_list.state_list(rti::core::vector<VehicleState>(states));
+    return state_list;
+}
+
+/**
+ * \brief Create the answer of the fake HLC for one vehicle
+ * \param vehicle_id ID of the vehicle
+ * \param t_now Time given by the VehicleStateList
+ * \ingroup middleware
+ */
+static VehicleCommandTrajectory create_command(uint8_t vehicle_id, uint64_t t_now)
+{
+    std::vector<TrajectoryPoint> points(10);
+    VehicleCommandTrajectory command;
+    command.vehicle_id(vehicle_id);
+    command.trajectory_points(rti::core::vector<TrajectoryPoint>(points));
+    command.header().create_stamp().nanoseconds(t_now);
+    return command;
+}
+
+/**
+ * \brief Print mean, median, 99th percentile and max. of the measured round-trip times
+ * \param name Name of the communication path
+ * \param round_trip_times Measured round-trip times in ns
+ * \ingroup middleware
+ */
+static void print_statistics(std::string name, std::vector<uint64_t> round_trip_times)
+{
+    if (round_trip_times.empty())
+    {
+        std::cout << name << ": No answers received" << std::endl;
+        return;
+    }
+
+    std::sort(round_trip_times.begin(), round_trip_times.end());
+    uint64_t sum = 0;
+    for (auto time : round_trip_times) sum += time;
+
+    std::cout << name << " round-trip times (us, " << round_trip_times.size() << " samples):"
+        << " mean " << (sum / round_trip_times.size()) / 1000.0
+        << ", median " << round_trip_times.at(round_trip_times.size() / 2) / 1000.0
+        << ", p99 " << round_trip_times.at(round_trip_times.size() * 99 / 100) / 1000.0
+        << ", max " << round_trip_times.back() / 1000.0
+        << std::endl;
+}
+
+/**
+ * \brief Measure the round-trip times via DDS, using a Middleware and an HLC participant with the local communication QoS
+ * \param domain DDS domain to use
+ * \param vehicle_ids IDs of the vehicles
+ * \param iterations Number of round-trips
+ * \ingroup middleware
+ */
+static std::vector<uint64_t> benchmark_dds(int domain, const std::vector<uint8_t>& vehicle_ids, int iterations)
+{
+    cpm::Participant middleware_participant(domain, "QOS_LOCAL_COMMUNICATION.xml", "MatlabLibrary::LocalCommunicationProfile");
+    cpm::Participant hlc_participant(domain, "QOS_LOCAL_COMMUNICATION.xml", "MatlabLibrary::LocalCommunicationProfile");
+
+    cpm::Writer<VehicleStateList> state_writer(middleware_participant.get_participant(), "benchmarkVehicleStateList");
+    cpm::Writer<VehicleCommandTrajectory> command_writer(hlc_participant.get_participant(), "benchmarkVehicleCommandTrajectory");
+
+    std::mutex answer_mutex;
+    std::condition_variable answer_condition;
+    size_t received_answers = 0;
+
+    //Fake HLC: Answer each VehicleStateList
+    cpm::AsyncReader<VehicleStateList> hlc_reader([&](std::vector<VehicleStateList>& samples) {
+        for (auto& state_list : samples)
+        {
+            for (auto id : vehicle_ids)
+            {
+                command_writer.write(create_command(id, state_list.t_now()));
+            }
+        }
+    }, hlc_participant, "benchmarkVehicleStateList");
+
+    //Fake Middleware: Count the answers
+    cpm::AsyncReader<VehicleCommandTrajectory> middleware_reader([&](std::vector<VehicleCommandTrajectory>& samples) {
+        std::lock_guard<std::mutex> lock(answer_mutex);
+        received_answers += samples.size();
+        answer_condition.notify_all();
+    }, middleware_participant, "benchmarkVehicleCommandTrajectory");
+
+    //Wait for the discovery of the participants
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+
+    VehicleStateList state_list = create_state_list(vehicle_ids);
+    std::vector<uint64_t> round_trip_times;
+    for (int i = 0; i < iterations; ++i)
+    {
+        std::unique_lock<std::mutex> lock(answer_mutex);
+        received_answers = 0;
+        uint64_t start = cpm::get_time_ns();
+        state_list.t_now(start);
+        state_writer.write(state_list);
+
+        bool answered = answer_condition.wait_for(lock, std::chrono::seconds(1), [&]() {
+            return received_answers >= vehicle_ids.size();
+        });
+        if (answered)
+        {
+            round_trip_times.push_back(cpm::get_time_ns() - start);
+        }
+    }
+
+    return round_trip_times;
+}
+
+/**
+ * \brief Measure the round-trip times via the shared memory mailbox
+ * \param domain Domain used for the name of the mailbox
+ * \param vehicle_ids IDs of the vehicles
+ * \param iterations Number of round-trips
+ * \ingroup middleware
+ */
+static std::vector<uint64_t> benchmark_mailbox(int domain, const std::vector<uint8_t>& vehicle_ids, int iterations)
+{
+    auto middleware_mailbox = cpm::HLCMailbox::create(domain, vehicle_ids);
+    auto hlc_mailbox = cpm::HLCMailbox::open(domain, vehicle_ids);
+    if (!middleware_mailbox || !hlc_mailbox)
+    {
+        std::cerr << "Could not create the shared memory mailbox" << std::endl;
+        return {};
+    }
+
+    //Fake HLC: Answer each VehicleStateList (deserialized and serialized as in the HLCCommunicator)
+    std::atomic_bool hlc_running{true};
+    std::thread hlc_thread([&]() {
+        std::vector<char> buffer;
+        cpm::HLCMailbox::MessageTag tag;
+        VehicleStateList state_list;
+        while (hlc_running.load())
+        {
+            if (!hlc_mailbox->read(tag, buffer, 100000000ull)) continue;
+
+            cpm::HLCMailbox::deserialize(buffer, state_list);
+            for (auto id : vehicle_ids)
+            {
+                hlc_mailbox->write(cpm::HLCMailbox::TagVehicleCommandTrajectory, create_command(id, state_list.t_now()));
+            }
+        }
+    });
+
+    //Fake Middleware
+    VehicleStateList state_list = create_state_list(vehicle_ids);
+    std::vector<char> buffer;
+    cpm::HLCMailbox::MessageTag tag;
+    VehicleCommandTrajectory command;
+    std::vector<uint64_t> round_trip_times;
+    for (int i = 0; i < iterations; ++i)
+    {
+        uint64_t start = cpm::get_time_ns();
+        state_list.t_now(start);
+        middleware_mailbox->write(cpm::HLCMailbox::TagVehicleStateList, state_list);
+
+        size_t received_answers = 0;
+        while (received_answers < vehicle_ids.size() && middleware_mailbox->read(tag, buffer, 1000000000ull))
+        {
+            cpm::HLCMailbox::deserialize(buffer, command);
+            ++received_answers;
+        }
+        if (received_answers == vehicle_ids.size())
+        {
+            round_trip_times.push_back(cpm::get_time_ns() - start);
+        }
+    }
+
+    hlc_running.store(false);
+    hlc_thread.join();
+
+    return round_trip_times;
+}
+
+int main(int argc, char *argv[])
+{
+    cpm::Logging::Instance().set_id("hlc_mailbox_benchmark");
+
+    int iterations = cpm::cmd_parameter_int("iterations", 1000, argc, argv);
+    int vehicle_amount = cpm::cmd_parameter_int("vehicles", 4, argc, argv);
+    int domain = cpm::cmd_parameter_int("domain_number", 21, argc, argv);
+
+    std::vector<uint8_t> vehicle_ids;
+    for (int id = 1; id <= vehicle_amount; ++id)
+    {
+        vehicle_ids.push_back(static_cast<uint8_t>(id));
+    }
+
+    std::cout << "Round-trip VehicleStateList -> " << vehicle_amount << " x VehicleCommandTrajectory, " << iterations << " iterations" << std::endl;
+    print_statistics("DDS", benchmark_dds(domain, vehicle_ids, iterations));
+    print_statistics("Shared memory mailbox", benchmark_mailbox(domain, vehicle_ids, iterations));
+
+    return 0;
+}
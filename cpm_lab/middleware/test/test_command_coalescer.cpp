@@ -0,0 +1,74 @@
+#include "catch.hpp"
+
+#include "CommandCoalescer.hpp"
+
+/**
+ * \brief Minimal command type for the test, only the vehicle ID and a sequence number
+ * \ingroup middleware
+ */
+struct TestCommand {
+    //! Vehicle ID
+    uint8_t id;
+    //! To identify the command
+    int sequence;
+
+    //! Vehicle ID, like the IDL types
+    uint8_t vehicle_id() const { return id; }
+};
+
+/**
+ * \test Tests the coalescing of vehicle commands
+ *
+ * - The first command of a slot is forwarded immediately, later ones are held back
+ * - Only the newest held back command is forwarded in the next slot, the others are counted as coalesced
+ * - The minimum interval between forwarded commands is kept, vehicles are independent
+ * \ingroup middleware
+ */
+TEST_CASE( "CommandCoalescer" ) {
+    const uint64_t ms = 1000000ull;
+    const uint64_t period_start = 1000 * ms;
+
+    SECTION( "Slots" ) {
+        CommandCoalescer<TestCommand> coalescer(50 * ms, 0);
+
+        auto forwarded = coalescer.offer({1, 0}, period_start + 1 * ms, period_start);
+        REQUIRE( forwarded.has_value() );
+        CHECK( forwarded->sequence == 0 );
+
+        //Same slot: Held back, only the newest one survives
+        CHECK_FALSE( coalescer.offer({1, 1}, period_start + 10 * ms, period_start).has_value() );
+        CHECK_FALSE( coalescer.offer({1, 2}, period_start + 20 * ms, period_start).has_value() );
+        CHECK( coalescer.get_coalesced_count() == 1 );
+
+        //Other vehicles are not affected
+        CHECK( coalescer.offer({2, 0}, period_start + 20 * ms, period_start).has_value() );
+
+        REQUIRE( coalescer.next_due(period_start).has_value() );
+        CHECK( coalescer.next_due(period_start).value() == period_start + 50 * ms );
+        CHECK( coalescer.take_due(period_start + 49 * ms, period_start).empty() );
+
+        auto due = coalescer.take_due(period_start + 50 * ms, period_start);
+        REQUIRE( due.size() == 1 );
+        CHECK( due.at(0).sequence == 2 );
+        CHECK_FALSE( coalescer.next_due(period_start).has_value() );
+        CHECK( coalescer.get_forwarded_count() == 3 );
+
+        //A new period starts a new slot
+        CHECK( coalescer.offer({1, 3}, period_start + 60 * ms, period_start + 60 * ms).has_value() );
+    }
+
+    SECTION( "Minimum interval" ) {
+        CommandCoalescer<TestCommand> coalescer(0, 30 * ms);
+
+        CHECK( coalescer.offer({1, 0}, period_start, period_start).has_value() );
+        CHECK_FALSE( coalescer.offer({1, 1}, period_start + 10 * ms, period_start).has_value() );
+        CHECK( coalescer.next_due(period_start).value() == period_start + 30 * ms );
+
+        //A command that arrives once the interval passed is forwarded right away and replaces the held back one
+        auto forwarded = coalescer.offer({1, 2}, period_start + 40 * ms, period_start);
+        REQUIRE( forwarded.has_value() );
+        CHECK( forwarded->sequence == 2 );
+        CHECK( coalescer.get_coalesced_count() == 1 );
+        CHECK_FALSE( coalescer.next_due(period_start).has_value() );
+    }
+}
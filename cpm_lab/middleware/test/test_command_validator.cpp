@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "CommandValidator.hpp"
+
+/**
+ * \brief Minimal time stamp type for the test, like the IDL type
+ * \ingroup middleware
+ */
+struct TestTimeStamp {
+    //! Time in ns
+    uint64_t ns;
+    //! Time in ns, like the IDL type
+    uint64_t nanoseconds() const { return ns; }
+};
+
+/**
+ * \brief Minimal trajectory point type for the test, with the getters and setters of the IDL type
+ * \ingroup middleware
+ */
+struct TestTrajectoryPoint {
+    //! Time
+    TestTimeStamp time;
+    //! Position and velocity
+    double x, y, v_x, v_y;
+
+    //! Getters and setters like the IDL type
+    TestTimeStamp t() const { return time; }
+    double px() const { return x; }
+    double py() const { return y; }
+    double vx() const { return v_x; }
+    double vy() const { return v_y; }
+    void vx(double v) { v_x = v; }
+    void vy(double v) { v_y = v; }
+};
+
+/**
+ * \test Tests the structural checks of vehicle commands
+ *
+ * - Valid trajectories are not changed
+ * - NaN values, out of bounds positions and jumps are rejected
+ * - Unsorted trajectories are sorted (newest duplicate kept), too high speeds are clipped
+ * - Speeds, curvatures and direct inputs are clipped, NaN is rejected
+ * - The statistics count the results
+ * \ingroup middleware
+ */
+TEST_CASE( "CommandValidator" ) {
+    const uint64_t ms = 1000000ull;
+    CommandValidator::Limits limits;
+    limits.max_speed = 2.0;
+    CommandValidator validator(limits);
+
+    //Straight line with 1 m/s
+    std::vector<TestTrajectoryPoint> points;
+    for (uint64_t i = 0; i < 5; ++i)
+    {
+        points.push_back({{1000 * ms + i * 100 * ms}, 0.1 * i, 1.0, 1.0, 0.0});
+    }
+
+    SECTION( "Trajectories" ) {
+        CHECK( validator.check_trajectory_points(points) == CommandValidator::IssueNone );
+
+        auto nan_points = points;
+        nan_points.at(2).y = std::numeric_limits<double>::quiet_NaN();
+        CHECK( validator.check_trajectory_points(nan_points) == CommandValidator::IssueNotFinite );
+
+        auto far_points = points;
+        far_points.at(4).x = 1000.0;
+        CHECK( validator.check_trajectory_points(far_points) == CommandValidator::IssueOutOfBounds );
+
+        auto jump_points = points;
+        jump_points.at(3).x = 5.0;
+        CHECK( (validator.check_trajectory_points(jump_points) & CommandValidator::RejectMask) == CommandValidator::IssueJump );
+
+        std::vector<TestTrajectoryPoint> empty_points;
+        CHECK( validator.check_trajectory_points(empty_points) == CommandValidator::IssueTooFewPoints );
+
+        //Unsorted with a duplicate time: Sorted, later point of the duplicates kept
+        auto unsorted_points = points;
+        std::swap(unsorted_points.at(0), unsorted_points.at(3));
+        unsorted_points.push_back(unsorted_points.at(1));
+        unsorted_points.back().v_x = 0.5;
+        CHECK( validator.check_trajectory_points(unsorted_points) == CommandValidator::IssueUnsorted );
+        REQUIRE( unsorted_points.size() == 5 );
+        for (size_t i = 1; i < unsorted_points.size(); ++i)
+        {
+            CHECK( unsorted_points.at(i).t().nanoseconds() > unsorted_points.at(i - 1).t().nanoseconds() );
+        }
+        CHECK( unsorted_points.at(1).vx() == 0.5 );
+
+        //Too fast: Scaled down, direction kept
+        auto fast_points = points;
+        fast_points.at(1).v_x = 3.0;
+        fast_points.at(1).v_y = 4.0;
+        CHECK( validator.check_trajectory_points(fast_points) == CommandValidator::IssueClipped );
+        CHECK( fast_points.at(1).vx() == Approx(1.2) );
+        CHECK( fast_points.at(1).vy() == Approx(1.6) );
+        CHECK( fast_points.at(0).vx() == 1.0 );
+    }
+
+    SECTION( "Scalar values and statistics" ) {
+        double speed = -3.0;
+        CHECK( validator.check_speed(speed) == CommandValidator::IssueClipped );
+        CHECK( speed == -2.0 );
+
+        double curvature = 0.5;
+        CHECK( validator.check_curvature(curvature) == CommandValidator::IssueNone );
+        CHECK( curvature == 0.5 );
+
+        double throttle = std::numeric_limits<double>::infinity();
+        CHECK( validator.check_direct_input(throttle) == CommandValidator::IssueNotFinite );
+
+        CHECK( validator.record(CommandValidator::IssueNone) );
+        CHECK( validator.record(CommandValidator::IssueClipped) );
+        CHECK_FALSE( validator.record(CommandValidator::IssueNotFinite) );
+        CHECK( validator.get_checked_count() == 3 );
+        CHECK( validator.get_fixed_count() == 1 );
+        CHECK( validator.get_rejected_count() == 1 );
+    }
+}
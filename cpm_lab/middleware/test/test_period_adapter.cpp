@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include "PeriodAdapter.hpp"
+
+/**
+ * \test Tests the adaptive middleware period
+ *
+ * - The slowest HLC determines the period (percentile of its response times plus headroom, rounded to steps, within the bounds)
+ * - The period is increased immediately, but only decreased after a whole window (hysteresis)
+ * - Missed periods increase the period
+ * \ingroup middleware
+ */
+TEST_CASE( "PeriodAdapter" ) {
+    const uint64_t ms = 1000000ull;
+
+    //Bounds 20 - 400ms, steps of 10ms, 90th percentile, 20% headroom, window of 20 periods
+    PeriodAdapter adapter(200, 20, 400, 10, 0.9, 1.2, 20);
+    CHECK( adapter.get_period_ms() == 200 );
+    CHECK_FALSE( adapter.get_required_period_ms().has_value() );
+
+    SECTION( "Decrease with hysteresis" ) {
+        //HLC 1 needs 40ms (with outliers of 90ms in 5% of the periods), HLC 2 50ms
+        for (int i = 0; i < 19; ++i)
+        {
+            adapter.add_response_time(1, (i == 7) ? 90 * ms : 40 * ms);
+            adapter.add_response_time(2, 50 * ms);
+            CHECK_FALSE( adapter.update().has_value() );
+        }
+        REQUIRE( adapter.get_required_period_ms().has_value() );
+        CHECK( adapter.get_required_period_ms().value() == 60 );
+
+        adapter.add_response_time(1, 40 * ms);
+        adapter.add_response_time(2, 50 * ms);
+        auto new_period = adapter.update();
+        REQUIRE( new_period.has_value() );
+        CHECK( new_period.value() == 60 );
+        CHECK( adapter.get_period_ms() == 60 );
+
+        //Slower HLC: Increased immediately
+        adapter.add_response_time(2, 80 * ms);
+        adapter.add_response_time(2, 80 * ms);
+        adapter.add_response_time(2, 80 * ms);
+        new_period = adapter.update();
+        REQUIRE( new_period.has_value() );
+        CHECK( new_period.value() == 100 );
+    }
+
+    SECTION( "Missed periods and bounds" ) {
+        for (int i = 0; i < 20; ++i)
+        {
+            adapter.add_response_time(1, 1 * ms);
+            adapter.update();
+        }
+        CHECK( adapter.get_period_ms() == 20 );
+
+        //Missed periods count as one period
+        for (int i = 0; i < 3; ++i)
+        {
+            adapter.add_missed_period(1);
+        }
+        REQUIRE( adapter.update().has_value() );
+        CHECK( adapter.get_period_ms() == 30 );
+
+        for (int i = 0; i < 20; ++i)
+        {
+            adapter.add_response_time(1, 1000 * ms);
+        }
+        adapter.update();
+        CHECK( adapter.get_period_ms() == 400 );
+    }
+}
+
+/**
+ * \test Tests the bounds of the percentile: 0 uses the fastest, 1 the slowest response time of the window
+ * \ingroup middleware
+ */
+TEST_CASE( "PeriodAdapter_percentile_bounds" ) {
+    const uint64_t ms = 1000000ull;
+
+    //No headroom, steps of 10ms, window of 10 periods; response times 10, 20, ..., 100ms
+    PeriodAdapter fastest(200, 10, 400, 10, 0.0, 1.0, 10);
+    PeriodAdapter slowest(200, 10, 400, 10, 1.0, 1.0, 10);
+    for (uint64_t i = 1; i <= 10; ++i)
+    {
+        fastest.add_response_time(1, i * 10 * ms);
+        slowest.add_response_time(1, i * 10 * ms);
+    }
+
+    REQUIRE( fastest.get_required_period_ms().has_value() );
+    CHECK( fastest.get_required_period_ms().value() == 10 );
+    REQUIRE( slowest.get_required_period_ms().has_value() );
+    CHECK( slowest.get_required_period_ms().value() == 100 );
+
+    //Out of range values are limited to [0, 1]
+    PeriodAdapter negative(200, 10, 400, 10, -0.5, 1.0, 10);
+    for (uint64_t i = 1; i <= 10; ++i)
+    {
+        negative.add_response_time(1, i * 10 * ms);
+    }
+    REQUIRE( negative.get_required_period_ms().has_value() );
+    CHECK( negative.get_required_period_ms().value() == 10 );
+}
@@ -11,6 +11,7 @@
 #include "cpm/Parameter.hpp"
 #include "cpm/ParticipantSingleton.hpp"
 #include "cpm/Logging.hpp"
+#include "cpm/LoopbackTransport.hpp"
 #include "VehicleCommandTrajectory.hpp"
 #include "VehicleState.hpp"
 #include "VehicleStateList.hpp"
@@ -23,10 +24,13 @@
  * 
  * This tests getLatestVehicleMessage (to make sure that most/all messages sent by two vehicle are actually received) 
  * [with sensor period = (timer period / 2) two messages from each vehicle are received on average by the reader, and only the latest one is returned]
+ * The vehicle states are sent via the loopback transport, s.t. the result does not depend on DDS discovery.
+ * The HLC participant of the middleware and the timer still create DDS entities, but no samples are sent via DDS.
  * \ingroup middleware
  */
 TEST_CASE( "VehicleCommunication_Read" ) {
     cpm::Logging::Instance().set_id("middleware_test");
+    cpm::LoopbackTransport::enable();
     
     //Communication parameters
     int hlcDomainNumber = 1; 
@@ -112,6 +116,7 @@ TEST_CASE( "VehicleCommunication_Read" ) {
     }
 
     timer->stop();
+    cpm::LoopbackTransport::disable();
 
     //Perform tests - check that no more than one stamp was missed
     for (size_t i = 1; i < received_timestamps_vehicle_0.size(); ++i) {
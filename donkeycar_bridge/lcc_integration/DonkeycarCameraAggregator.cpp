@@ -11,6 +11,7 @@
 #include <QJsonArray>
 #include <QByteArray>
 #include <QBuffer>
+#include <cpm/get_time_ns.hpp>
 
 DonkeycarCameraAggregator::DonkeycarCameraAggregator(QObject* parent)
     : QObject(parent)
@@ -20,21 +21,39 @@ DonkeycarCameraAggregator::DonkeycarCameraAggregator(QObject* parent)
     connect(update_timer_, &QTimer::timeout, this, &DonkeycarCameraAggregator::updateVehicleList);
     update_timer_->start(5000); // Check for new cameras every 5 seconds
     
-    cpm::Logging::Instance().write(cpm::LogLevel::Debug, "DonkeycarCameraAggregator created");
+    CPM_LOG(cpm::LogLevel::Debug, "DonkeycarCameraAggregator created");
 }
 
 DonkeycarCameraAggregator::~DonkeycarCameraAggregator()
 {
     update_timer_->stop();
-    cpm::Logging::Instance().write(cpm::LogLevel::Debug, "DonkeycarCameraAggregator destroyed");
+    CPM_LOG(cpm::LogLevel::Debug, "DonkeycarCameraAggregator destroyed");
 }
 
 void DonkeycarCameraAggregator::initialize()
 {
+    // Vehicle states are only needed to tag recorded frames
+    vehicle_state_reader_ = std::make_unique<cpm::AsyncReader<VehicleState>>(
+        [this](std::vector<VehicleState>& samples)
+        {
+            for (auto& sample : samples)
+            {
+                DonkeycarCameraRecorder::StateSample state;
+                state.timestamp_ns = sample.header().create_stamp().nanoseconds();
+                state.x = sample.pose().x();
+                state.y = sample.pose().y();
+                state.yaw = sample.pose().yaw();
+                state.speed = sample.speed();
+                recorder_.addVehicleState(sample.vehicle_id(), state);
+            }
+        },
+        "vehicleState"
+    );
+
     // Perform initial update of vehicle list
     updateVehicleList();
     
-    cpm::Logging::Instance().write(cpm::LogLevel::Info, "DonkeycarCameraAggregator initialized");
+    CPM_LOG(cpm::LogLevel::Info, "DonkeycarCameraAggregator initialized");
 }
 
 QImage DonkeycarCameraAggregator::getCameraFeed(const int vehicle_id) const
@@ -71,6 +90,37 @@ bool DonkeycarCameraAggregator::hasCamera(const int vehicle_id) const
     return camera_images_.find(vehicle_id) != camera_images_.end();
 }
 
+bool DonkeycarCameraAggregator::startRecording(const QString& directory)
+{
+    bool started = recorder_.start(directory.toStdString());
+    if (started)
+    {
+        CPM_LOG(cpm::LogLevel::Info, 
+            "Started camera recording in " + directory.toStdString());
+    }
+    return started;
+}
+
+void DonkeycarCameraAggregator::stopRecording()
+{
+    recorder_.stop();
+
+    auto statistics = recorder_.getStatistics();
+    CPM_LOG(cpm::LogLevel::Info, 
+        "Stopped camera recording: " + std::to_string(statistics.frames_written) + " frames written, "
+        + std::to_string(statistics.frames_dropped) + " dropped");
+}
+
+bool DonkeycarCameraAggregator::isRecording() const
+{
+    return recorder_.isRecording();
+}
+
+DonkeycarCameraRecorder& DonkeycarCameraAggregator::recorder()
+{
+    return recorder_;
+}
+
 void DonkeycarCameraAggregator::processCameraMessage(const int vehicle_id, const std::string& message)
 {
     try
@@ -79,7 +129,7 @@ void DonkeycarCameraAggregator::processCameraMessage(const int vehicle_id, const
         QJsonDocument doc = QJsonDocument::fromJson(QString::fromStdString(message).toUtf8());
         if (doc.isNull() || !doc.isObject())
         {
-            cpm::Logging::Instance().write(cpm::LogLevel::Warning, 
+            CPM_LOG(cpm::LogLevel::Warning, 
                 "Invalid camera message format for vehicle " + std::to_string(vehicle_id));
             return;
         }
@@ -89,11 +139,23 @@ void DonkeycarCameraAggregator::processCameraMessage(const int vehicle_id, const
         // Extract image data
         if (!obj.contains("image_data") || !obj["image_data"].isString())
         {
-            cpm::Logging::Instance().write(cpm::LogLevel::Warning, 
+            CPM_LOG(cpm::LogLevel::Warning, 
                 "Missing image data in camera message for vehicle " + std::to_string(vehicle_id));
             return;
         }
         
+        // Record the original data before anything is decoded
+        // The source timestamp is set by the sender, the receive time is only used if it is missing
+        if (recorder_.isRecording())
+        {
+            uint64_t source_timestamp = cpm::get_time_ns();
+            if (obj.contains("timestamp") && obj["timestamp"].isDouble())
+            {
+                source_timestamp = static_cast<uint64_t>(obj["timestamp"].toDouble());
+            }
+            recorder_.addFrame(vehicle_id, source_timestamp, obj["image_data"].toString().toStdString());
+        }
+
         // Get base64 encoded image data
         QString base64Data = obj["image_data"].toString();
         QByteArray imageData = QByteArray::fromBase64(base64Data.toUtf8());
@@ -102,7 +164,7 @@ void DonkeycarCameraAggregator::processCameraMessage(const int vehicle_id, const
         QImage image;
         if (!image.loadFromData(imageData, "JPEG"))
         {
-            cpm::Logging::Instance().write(cpm::LogLevel::Warning, 
+            CPM_LOG(cpm::LogLevel::Warning, 
                 "Failed to load image data for vehicle " + std::to_string(vehicle_id));
             return;
         }
@@ -119,7 +181,7 @@ void DonkeycarCameraAggregator::processCameraMessage(const int vehicle_id, const
     }
     catch (const std::exception& e)
     {
-        cpm::Logging::Instance().write(cpm::LogLevel::Error, 
+        CPM_LOG(cpm::LogLevel::Error, 
             "Error processing camera message: " + std::string(e.what()));
     }
 }
@@ -154,7 +216,7 @@ void DonkeycarCameraAggregator::updateVehicleList()
             // Check if we got any data
             if (reader->matched())
             {
-                cpm::Logging::Instance().write(cpm::LogLevel::Info, 
+                CPM_LOG(cpm::LogLevel::Info, 
                     "Found camera feed for vehicle " + std::to_string(i));
                 
                 // Add to our map of readers
@@ -176,7 +238,7 @@ void DonkeycarCameraAggregator::updateVehicleList()
     }
     catch (const std::exception& e)
     {
-        cpm::Logging::Instance().write(cpm::LogLevel::Error, 
+        CPM_LOG(cpm::LogLevel::Error, 
             "Error updating vehicle list: " + std::string(e.what()));
     }
 }
\ No newline at end of file
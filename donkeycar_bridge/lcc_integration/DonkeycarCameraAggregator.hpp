@@ -19,6 +19,9 @@
 #include <cpm/Logging.hpp>
 #include <cpm/dds/Participant.hpp>
 
+#include "VehicleState.hpp"
+#include "DonkeycarCameraRecorder.hpp"
+
 class DonkeycarCameraAggregator : public QObject
 {
     Q_OBJECT
@@ -52,6 +55,30 @@ public:
      */
     Q_INVOKABLE bool hasCamera(const int vehicle_id) const;
 
+    /**
+     * Start recording the camera streams of all vehicles (original JPEG data, see DonkeycarCameraRecorder)
+     * @param directory Existing directory for the recording
+     * @return True if the recording was started
+     */
+    Q_INVOKABLE bool startRecording(const QString& directory);
+
+    /**
+     * Stop the current recording, writes all remaining frames
+     */
+    Q_INVOKABLE void stopRecording();
+
+    /**
+     * Check if the camera streams are being recorded
+     * @return True if a recording is running
+     */
+    Q_INVOKABLE bool isRecording() const;
+
+    /**
+     * Get the recorder, e.g. to query its statistics
+     * @return The recorder
+     */
+    DonkeycarCameraRecorder& recorder();
+
 signals:
     /**
      * Signal emitted when a new camera image is received
@@ -81,6 +108,12 @@ private:
     
     // Readers for camera feeds
     std::map<int, std::unique_ptr<cpm::AsyncReader<std::string>>> readers_;
+
+    // Records the original camera data of all vehicles
+    DonkeycarCameraRecorder recorder_;
+
+    // Reader for vehicle states, used to tag recorded frames
+    std::unique_ptr<cpm::AsyncReader<VehicleState>> vehicle_state_reader_;
     
     // List of vehicle IDs with camera feeds
     std::vector<int> vehicle_ids_;
@@ -0,0 +1,277 @@
+/*
+ * DonkeycarCameraRecorder.cpp
+ *
+ * Implementation of the Donkeycar camera recorder
+ */
+
+#include "DonkeycarCameraRecorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <QByteArray>
+#include <cpm/get_time_ns.hpp>
+
+constexpr uint64_t DonkeycarCameraRecorder::state_retention_ns_;
+constexpr size_t DonkeycarCameraRecorder::max_states_per_vehicle_;
+
+DonkeycarCameraRecorder::DonkeycarCameraRecorder(
+    size_t max_queued_bytes,
+    uint64_t max_chunk_bytes,
+    uint64_t state_match_delay_ns)
+    : max_queued_bytes_(max_queued_bytes)
+    , max_chunk_bytes_(max_chunk_bytes)
+    , state_match_delay_ns_(state_match_delay_ns)
+{
+}
+
+DonkeycarCameraRecorder::~DonkeycarCameraRecorder()
+{
+    stop();
+}
+
+bool DonkeycarCameraRecorder::start(const std::string& directory)
+{
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+
+    if (recording_.load() || writer_thread_.joinable())
+    {
+        return false;
+    }
+
+    directory_ = directory;
+    stop_writer_ = false;
+    recording_.store(true);
+    writer_thread_ = std::thread(&DonkeycarCameraRecorder::writerLoop, this);
+
+    return true;
+}
+
+void DonkeycarCameraRecorder::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        recording_.store(false);
+        stop_writer_ = true;
+    }
+    queue_cv_.notify_all();
+
+    if (writer_thread_.joinable())
+    {
+        writer_thread_.join();
+    }
+}
+
+bool DonkeycarCameraRecorder::isRecording() const
+{
+    return recording_.load();
+}
+
+bool DonkeycarCameraRecorder::addFrame(const int vehicle_id, const uint64_t source_timestamp_ns, std::string base64_jpeg)
+{
+    if (!recording_.load())
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+
+        // Bounded memory: Rather lose new frames than block the receiving thread
+        if (queued_bytes_ + base64_jpeg.size() > max_queued_bytes_)
+        {
+            frames_dropped_.fetch_add(1);
+            return false;
+        }
+
+        queued_bytes_ += base64_jpeg.size();
+        queue_.push_back(QueuedFrame{vehicle_id, source_timestamp_ns, cpm::get_time_ns(), std::move(base64_jpeg)});
+    }
+    queue_cv_.notify_one();
+
+    return true;
+}
+
+void DonkeycarCameraRecorder::addVehicleState(const int vehicle_id, const StateSample& state)
+{
+    std::lock_guard<std::mutex> lock(states_mutex_);
+
+    auto& states = states_[vehicle_id];
+
+    // States usually arrive in order, otherwise insert at the right position
+    auto position = states.end();
+    while (position != states.begin() && std::prev(position)->timestamp_ns > state.timestamp_ns)
+    {
+        --position;
+    }
+    states.insert(position, state);
+
+    // Frames may wait in the queue for a while, so states are kept by age instead of by count
+    while (states.size() > max_states_per_vehicle_
+        || states.back().timestamp_ns - states.front().timestamp_ns > state_retention_ns_)
+    {
+        states.pop_front();
+    }
+}
+
+bool DonkeycarCameraRecorder::findClosestState(const int vehicle_id, const uint64_t timestamp_ns, StateSample& state_out)
+{
+    std::lock_guard<std::mutex> lock(states_mutex_);
+
+    auto entry = states_.find(vehicle_id);
+    if (entry == states_.end() || entry->second.empty())
+    {
+        return false;
+    }
+
+    auto& states = entry->second;
+    auto after = std::lower_bound(states.begin(), states.end(), timestamp_ns,
+        [](const StateSample& state, uint64_t t) { return state.timestamp_ns < t; });
+
+    if (after == states.end())
+    {
+        state_out = states.back();
+    }
+    else if (after == states.begin())
+    {
+        state_out = *after;
+    }
+    else
+    {
+        auto before = std::prev(after);
+        state_out = (timestamp_ns - before->timestamp_ns <= after->timestamp_ns - timestamp_ns) ? *before : *after;
+    }
+
+    return true;
+}
+
+DonkeycarCameraRecorder::Statistics DonkeycarCameraRecorder::getStatistics() const
+{
+    Statistics statistics;
+    statistics.frames_written = frames_written_.load();
+    statistics.frames_dropped = frames_dropped_.load();
+    statistics.frames_invalid = frames_invalid_.load();
+    statistics.bytes_written = bytes_written_.load();
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    statistics.queued_bytes = queued_bytes_;
+
+    return statistics;
+}
+
+void DonkeycarCameraRecorder::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+
+    while (true)
+    {
+        if (queue_.empty())
+        {
+            if (stop_writer_)
+            {
+                break;
+            }
+
+            queue_cv_.wait(lock);
+            continue;
+        }
+
+        // Give late vehicle states a chance to arrive, unless the recording is being stopped
+        uint64_t now = cpm::get_time_ns();
+        uint64_t due = queue_.front().receive_timestamp_ns + state_match_delay_ns_;
+        if (!stop_writer_ && now < due)
+        {
+            queue_cv_.wait_for(lock, std::chrono::nanoseconds(due - now));
+            continue;
+        }
+
+        QueuedFrame frame = std::move(queue_.front());
+        queue_.pop_front();
+
+        // Write without holding the lock, s.t. the receiving thread is never blocked by file I/O
+        lock.unlock();
+        writeFrame(frame);
+        lock.lock();
+
+        queued_bytes_ -= frame.base64_jpeg.size();
+    }
+
+    lock.unlock();
+    closeFiles();
+}
+
+void DonkeycarCameraRecorder::writeFrame(const QueuedFrame& frame)
+{
+    // Only the transport encoding is removed, the JPEG data itself is stored as it is
+    QByteArray jpeg = QByteArray::fromBase64(QByteArray::fromRawData(frame.base64_jpeg.data(), static_cast<int>(frame.base64_jpeg.size())));
+    if (jpeg.isEmpty())
+    {
+        frames_invalid_.fetch_add(1);
+        return;
+    }
+
+    VehicleFiles& files = files_[frame.vehicle_id];
+    if (files.data == nullptr || files.chunk_bytes >= max_chunk_bytes_)
+    {
+        openChunk(frame.vehicle_id, files);
+    }
+    if (files.data == nullptr || files.index == nullptr)
+    {
+        frames_dropped_.fetch_add(1);
+        return;
+    }
+
+    StateSample state;
+    if (!findClosestState(frame.vehicle_id, frame.source_timestamp_ns, state))
+    {
+        state = StateSample();
+    }
+
+    fwrite(jpeg.constData(), 1, static_cast<size_t>(jpeg.size()), files.data);
+
+    fprintf(files.index, "%010" PRIu64 ",%020" PRIu64 ",%012" PRIu64 ",%010d,%020" PRIu64 ",%+014.6f,%+014.6f,%+014.6f,%+014.6f\n",
+        files.frame,
+        frame.source_timestamp_ns,
+        files.chunk_bytes,
+        jpeg.size(),
+        state.timestamp_ns,
+        state.x,
+        state.y,
+        state.yaw,
+        state.speed);
+
+    files.chunk_bytes += static_cast<uint64_t>(jpeg.size());
+    ++files.frame;
+
+    frames_written_.fetch_add(1);
+    bytes_written_.fetch_add(static_cast<uint64_t>(jpeg.size()));
+}
+
+void DonkeycarCameraRecorder::openChunk(const int vehicle_id, VehicleFiles& files)
+{
+    if (files.data != nullptr || files.index != nullptr)
+    {
+        if (files.data != nullptr) fclose(files.data);
+        if (files.index != nullptr) fclose(files.index);
+        ++files.chunk;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "/vehicle_%02d_%05u", vehicle_id, files.chunk);
+    std::string base = directory_ + name;
+
+    files.data = fopen((base + ".jpgs").c_str(), "wb");
+    files.index = fopen((base + ".idx").c_str(), "w");
+    files.chunk_bytes = 0;
+    files.frame = 0;
+}
+
+void DonkeycarCameraRecorder::closeFiles()
+{
+    for (auto& entry : files_)
+    {
+        if (entry.second.data != nullptr) fclose(entry.second.data);
+        if (entry.second.index != nullptr) fclose(entry.second.index);
+    }
+    files_.clear();
+}
@@ -0,0 +1,200 @@
+/*
+ * DonkeycarCameraRecorder.hpp
+ *
+ * Records the camera streams of all Donkeycars without re-encoding
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Writes the original JPEG payloads of all camera streams to per-vehicle chunk files.
+ *
+ * Frames are queued by the receiving thread (only the base64 payload is stored, nothing is decoded there)
+ * and written by a separate writer thread. The queue is bounded in bytes; frames that do not fit are dropped
+ * and counted. Each frame is matched to the vehicle state of the same vehicle that is closest in time.
+ *
+ * Files per vehicle, in the recording directory:
+ * - vehicle_<id>_<chunk>.jpgs: Concatenated JPEG images
+ * - vehicle_<id>_<chunk>.idx: One fixed-width line per frame:
+ *   frame,source_timestamp_ns,byte_offset,size,state_timestamp_ns,x,y,yaw,speed
+ *   (state_timestamp_ns is 0 if no vehicle state was known for the vehicle)
+ * A new chunk is started when the current one exceeds the maximum chunk size.
+ */
+class DonkeycarCameraRecorder
+{
+public:
+    /**
+     * Vehicle state sample used to tag the frames
+     */
+    struct StateSample
+    {
+        uint64_t timestamp_ns = 0;
+        double x = 0.0;
+        double y = 0.0;
+        double yaw = 0.0;
+        double speed = 0.0;
+    };
+
+    /**
+     * Counters of the recorder
+     */
+    struct Statistics
+    {
+        uint64_t frames_written = 0;
+        uint64_t frames_dropped = 0;
+        uint64_t frames_invalid = 0;
+        uint64_t bytes_written = 0;
+        size_t queued_bytes = 0;
+    };
+
+    /**
+     * @param max_queued_bytes Upper bound of the memory used by frames that were not written yet
+     * @param max_chunk_bytes Size after which a new chunk file is started for a vehicle
+     * @param state_match_delay_ns Frames are written after this delay, s.t. vehicle states that arrive slightly later can be matched
+     */
+    explicit DonkeycarCameraRecorder(
+        size_t max_queued_bytes = 64 * 1024 * 1024,
+        uint64_t max_chunk_bytes = 256 * 1024 * 1024,
+        uint64_t state_match_delay_ns = 50000000ull
+    );
+    ~DonkeycarCameraRecorder();
+
+    /**
+     * Start recording into the given directory (must exist)
+     * @param directory The recording directory
+     * @return False if a recording is already running
+     */
+    bool start(const std::string& directory);
+
+    /**
+     * Stop recording, writes all queued frames before returning
+     */
+    void stop();
+
+    /**
+     * @return True if a recording is running
+     */
+    bool isRecording() const;
+
+    /**
+     * Queue a frame for recording, ignored if no recording is running
+     * @param vehicle_id The ID of the vehicle
+     * @param source_timestamp_ns Time at which the frame was sent by the vehicle
+     * @param base64_jpeg The base64 encoded JPEG image, as received
+     * @return False if the frame was dropped
+     */
+    bool addFrame(const int vehicle_id, const uint64_t source_timestamp_ns, std::string base64_jpeg);
+
+    /**
+     * Remember a vehicle state to tag frames of the same vehicle with it
+     * @param vehicle_id The ID of the vehicle
+     * @param state The vehicle state
+     */
+    void addVehicleState(const int vehicle_id, const StateSample& state);
+
+    /**
+     * @return The counters of the recorder
+     */
+    Statistics getStatistics() const;
+
+private:
+    /**
+     * A frame that was not written yet
+     */
+    struct QueuedFrame
+    {
+        int vehicle_id;
+        uint64_t source_timestamp_ns;
+        uint64_t receive_timestamp_ns;
+        std::string base64_jpeg;
+    };
+
+    /**
+     * Output files of a vehicle
+     */
+    struct VehicleFiles
+    {
+        FILE* data = nullptr;
+        FILE* index = nullptr;
+        uint32_t chunk = 0;
+        uint64_t chunk_bytes = 0;
+        uint64_t frame = 0;
+    };
+
+    /**
+     * Writer thread: Writes queued frames after state_match_delay_ns
+     */
+    void writerLoop();
+
+    /**
+     * Write a single frame to the files of its vehicle
+     * @param frame The frame
+     */
+    void writeFrame(const QueuedFrame& frame);
+
+    /**
+     * Open the next chunk of a vehicle, closes the previous one
+     * @param vehicle_id The ID of the vehicle
+     * @param files The files of the vehicle
+     */
+    void openChunk(const int vehicle_id, VehicleFiles& files);
+
+    /**
+     * Close all files
+     */
+    void closeFiles();
+
+    /**
+     * Find the vehicle state closest in time
+     * @param vehicle_id The ID of the vehicle
+     * @param timestamp_ns Time of the frame
+     * @param state_out The closest state
+     * @return False if no state is known for the vehicle
+     */
+    bool findClosestState(const int vehicle_id, const uint64_t timestamp_ns, StateSample& state_out);
+
+private:
+    // Limits, see constructor
+    const size_t max_queued_bytes_;
+    const uint64_t max_chunk_bytes_;
+    const uint64_t state_match_delay_ns_;
+
+    // Vehicle states are kept for this long (relative to the newest state of the vehicle), but at most max_states_per_vehicle_
+    static constexpr uint64_t state_retention_ns_ = 5000000000ull;
+    static constexpr size_t max_states_per_vehicle_ = 4096;
+
+    // Recording directory
+    std::string directory_;
+
+    // Frames that were not written yet, in order of arrival
+    std::deque<QueuedFrame> queue_;
+    size_t queued_bytes_ = 0;
+    std::atomic_bool recording_{false};
+    bool stop_writer_ = false;
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::thread writer_thread_;
+
+    // Recent vehicle states per vehicle, sorted by time
+    std::map<int, std::deque<StateSample>> states_;
+    std::mutex states_mutex_;
+
+    // Output files per vehicle, only used by the writer thread
+    std::map<int, VehicleFiles> files_;
+
+    // Counters
+    std::atomic<uint64_t> frames_written_{0};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<uint64_t> frames_invalid_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+};
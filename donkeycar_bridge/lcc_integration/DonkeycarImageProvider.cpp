@@ -15,7 +15,7 @@ DonkeycarImageProvider::DonkeycarImageProvider(DonkeycarCameraAggregator* aggreg
     : QQuickImageProvider(QQuickImageProvider::Image)
     , aggregator_(aggregator)
 {
-    cpm::Logging::Instance().write(cpm::LogLevel::Debug, "DonkeycarImageProvider created");
+    CPM_LOG(cpm::LogLevel::Debug, "DonkeycarImageProvider created");
 }
 
 QImage DonkeycarImageProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize)
@@ -28,7 +28,7 @@ QImage DonkeycarImageProvider::requestImage(const QString& id, QSize* size, cons
     
     if (!ok)
     {
-        cpm::Logging::Instance().write(cpm::LogLevel::Warning, 
+        CPM_LOG(cpm::LogLevel::Warning, 
             "Invalid vehicle ID in image request: " + id.toStdString());
         return QImage();
     }
@@ -38,7 +38,7 @@ QImage DonkeycarImageProvider::requestImage(const QString& id, QSize* size, cons
     
     if (image.isNull())
     {
-        cpm::Logging::Instance().write(cpm::LogLevel::Debug, 
+        CPM_LOG(cpm::LogLevel::Debug, 
             "No camera feed available for vehicle " + std::to_string(vehicleId));
         
         // Return a placeholder image
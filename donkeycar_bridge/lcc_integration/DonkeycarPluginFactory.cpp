@@ -17,7 +17,7 @@ DonkeycarPluginFactory::DonkeycarPluginFactory(QObject* parent)
     : QObject(parent)
     , camera_aggregator_(std::make_unique<DonkeycarCameraAggregator>())
 {
-    cpm::Logging::Instance().write(cpm::LogLevel::Info, "DonkeycarPluginFactory initialized");
+    CPM_LOG(cpm::LogLevel::Info, "DonkeycarPluginFactory initialized");
     
     // Initialize the camera aggregator
     camera_aggregator_->initialize();
@@ -25,14 +25,14 @@ DonkeycarPluginFactory::DonkeycarPluginFactory(QObject* parent)
 
 DonkeycarPluginFactory::~DonkeycarPluginFactory()
 {
-    cpm::Logging::Instance().write(cpm::LogLevel::Debug, "DonkeycarPluginFactory destroyed");
+    CPM_LOG(cpm::LogLevel::Debug, "DonkeycarPluginFactory destroyed");
 }
 
 void DonkeycarPluginFactory::registerComponents(QQmlEngine* engine)
 {
     if (!engine)
     {
-        cpm::Logging::Instance().write(cpm::LogLevel::Error, "Invalid QML engine");
+        CPM_LOG(cpm::LogLevel::Error, "Invalid QML engine");
         return;
     }
     
@@ -45,7 +45,7 @@ void DonkeycarPluginFactory::registerComponents(QQmlEngine* engine)
     // Register the QML files location
     engine->addImportPath("/home/icarus/school/RIDE-project/donkeycar_bridge/lcc_integration");
     
-    cpm::Logging::Instance().write(cpm::LogLevel::Info, "Donkeycar components registered with QML engine");
+    CPM_LOG(cpm::LogLevel::Info, "Donkeycar components registered with QML engine");
 }
 
 DonkeycarCameraAggregator* DonkeycarPluginFactory::getCameraAggregator() const
@@ -0,0 +1,204 @@
+/*
+ * test_camera_recorder.cpp
+ *
+ * Test for the Donkeycar camera recorder with a synthetic frame publisher:
+ * Several vehicles publish JPEG-like frames at full frame rate (plus vehicle states),
+ * afterwards the recorded chunk files are checked against their indices.
+ *
+ * Usage: donkeycar_camera_recorder_test [vehicles] [fps] [seconds] [frame_kb] [directory]
+ */
+
+#include <QByteArray>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cpm/get_time_ns.hpp>
+
+#include "../DonkeycarCameraRecorder.hpp"
+
+/**
+ * Publishes synthetic frames and vehicle states of a single vehicle
+ */
+class SyntheticFramePublisher
+{
+public:
+    SyntheticFramePublisher(DonkeycarCameraRecorder& recorder, int vehicle_id, int fps, size_t frame_bytes)
+        : recorder_(recorder)
+        , vehicle_id_(vehicle_id)
+        , fps_(fps)
+        , frame_bytes_(frame_bytes)
+    {
+    }
+
+    void run(double seconds)
+    {
+        std::mt19937 random_engine(vehicle_id_);
+        std::uniform_int_distribution<int> byte_distribution(0, 255);
+
+        // Frames are generated up front, s.t. generating them does not limit the frame rate
+        std::vector<std::string> frames;
+        for (int i = 0; i < 8; ++i)
+        {
+            QByteArray jpeg(static_cast<int>(frame_bytes_), '\0');
+            for (int j = 0; j < jpeg.size(); ++j) jpeg[j] = static_cast<char>(byte_distribution(random_engine));
+            jpeg[0] = static_cast<char>(0xFF);
+            jpeg[1] = static_cast<char>(0xD8);
+            jpeg[jpeg.size() - 2] = static_cast<char>(0xFF);
+            jpeg[jpeg.size() - 1] = static_cast<char>(0xD9);
+            frames.push_back(jpeg.toBase64().toStdString());
+        }
+
+        auto period = std::chrono::nanoseconds(1000000000ll / fps_);
+        auto next = std::chrono::steady_clock::now();
+        auto end = next + std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(seconds));
+        uint64_t count = 0;
+
+        while (next < end)
+        {
+            uint64_t now = cpm::get_time_ns();
+
+            // Two vehicle states per frame, slightly before and after it
+            DonkeycarCameraRecorder::StateSample state;
+            state.timestamp_ns = now - 1000000ull;
+            state.x = static_cast<double>(count);
+            state.speed = 1.0;
+            recorder_.addVehicleState(vehicle_id_, state);
+
+            if (recorder_.addFrame(vehicle_id_, now, frames.at(count % frames.size())))
+            {
+                ++published_;
+            }
+
+            state.timestamp_ns = now + 10000000ull;
+            state.x = static_cast<double>(count) + 0.5;
+            recorder_.addVehicleState(vehicle_id_, state);
+
+            ++count;
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    uint64_t published() const { return published_; }
+
+private:
+    DonkeycarCameraRecorder& recorder_;
+    int vehicle_id_;
+    int fps_;
+    size_t frame_bytes_;
+    uint64_t published_ = 0;
+};
+
+/**
+ * Check the chunk files of a vehicle against their index
+ * @return Number of valid frames, or -1 on an error
+ */
+static long long check_vehicle(const std::string& directory, int vehicle_id)
+{
+    long long frames = 0;
+
+    for (unsigned chunk = 0; ; ++chunk)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "/vehicle_%02d_%05u", vehicle_id, chunk);
+        std::string base = directory + name;
+
+        FILE* data = fopen((base + ".jpgs").c_str(), "rb");
+        FILE* index = fopen((base + ".idx").c_str(), "r");
+        if (data == nullptr || index == nullptr)
+        {
+            if (data != nullptr) fclose(data);
+            if (index != nullptr) fclose(index);
+            break;
+        }
+
+        uint64_t frame, source_timestamp, offset, state_timestamp;
+        int size;
+        double x, y, yaw, speed;
+        uint64_t expected_offset = 0;
+        while (fscanf(index, "%" SCNu64 ",%" SCNu64 ",%" SCNu64 ",%d,%" SCNu64 ",%lf,%lf,%lf,%lf\n",
+            &frame, &source_timestamp, &offset, &size, &state_timestamp, &x, &y, &yaw, &speed) == 9)
+        {
+            unsigned char start[2] = {0, 0};
+            unsigned char end[2] = {0, 0};
+            fseek(data, static_cast<long>(offset), SEEK_SET);
+            bool ok = fread(start, 1, 2, data) == 2;
+            fseek(data, static_cast<long>(offset + size - 2), SEEK_SET);
+            ok = ok && fread(end, 1, 2, data) == 2;
+
+            // A state was published 1ms before each frame, so the closest state must be at most 1ms away
+            bool state_ok = state_timestamp + 1000000ull >= source_timestamp && state_timestamp <= source_timestamp + 1000000ull;
+
+            if (!ok || offset != expected_offset || start[0] != 0xFF || start[1] != 0xD8 || end[0] != 0xFF || end[1] != 0xD9 || !state_ok)
+            {
+                std::cerr << "Invalid frame " << frame << " of vehicle " << vehicle_id << " in chunk " << chunk << std::endl;
+                fclose(data);
+                fclose(index);
+                return -1;
+            }
+
+            expected_offset += static_cast<uint64_t>(size);
+            ++frames;
+        }
+
+        fclose(data);
+        fclose(index);
+    }
+
+    return frames;
+}
+
+int main(int argc, char** argv)
+{
+    int vehicles = (argc > 1) ? std::atoi(argv[1]) : 8;
+    int fps = (argc > 2) ? std::atoi(argv[2]) : 30;
+    double seconds = (argc > 3) ? std::atof(argv[3]) : 5.0;
+    size_t frame_bytes = ((argc > 4) ? std::atoi(argv[4]) : 40) * 1024;
+    std::string directory = (argc > 5) ? argv[5] : ".";
+
+    // Small chunks to test the rotation as well
+    DonkeycarCameraRecorder recorder(64 * 1024 * 1024, 16 * 1024 * 1024);
+    recorder.start(directory);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<SyntheticFramePublisher>> publishers;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < vehicles; ++i)
+    {
+        publishers.emplace_back(new SyntheticFramePublisher(recorder, i, fps, frame_bytes));
+        threads.emplace_back(&SyntheticFramePublisher::run, publishers.back().get(), seconds);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    recorder.stop();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto statistics = recorder.getStatistics();
+    std::cout << "Frames written: " << statistics.frames_written
+        << ", dropped: " << statistics.frames_dropped
+        << ", invalid: " << statistics.frames_invalid
+        << ", MB/s: " << static_cast<double>(statistics.bytes_written) / elapsed / 1e6 << std::endl;
+
+    bool success = statistics.frames_dropped == 0 && statistics.frames_invalid == 0;
+    for (int i = 0; i < vehicles; ++i)
+    {
+        long long frames = check_vehicle(directory, i);
+        if (frames < 0 || static_cast<uint64_t>(frames) != publishers.at(i)->published())
+        {
+            std::cerr << "Vehicle " << i << ": " << frames << " frames recorded, " << publishers.at(i)->published() << " published" << std::endl;
+            success = false;
+        }
+    }
+
+    std::cout << (success ? "Test passed" : "Test failed") << std::endl;
+    return success ? 0 : 1;
+}